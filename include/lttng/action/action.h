@@ -22,6 +22,7 @@ enum lttng_action_type {
 	LTTNG_ACTION_TYPE_ROTATE_SESSION = 3,
 	LTTNG_ACTION_TYPE_SNAPSHOT_SESSION = 4,
 	LTTNG_ACTION_TYPE_GROUP = 5,
+	LTTNG_ACTION_TYPE_INCREMENT_COUNTER = 6,
 };
 
 enum lttng_action_status {
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_ACTION_INCREMENT_COUNTER_INTERNAL_H
+#define LTTNG_ACTION_INCREMENT_COUNTER_INTERNAL_H
+
+#include <common/macros.h>
+#include <stdbool.h>
+
+struct lttng_action;
+struct lttng_condition;
+struct lttng_payload_view;
+
+/*
+ * Create an "increment counter" action from a payload view.
+ *
+ * On success, return the number of bytes consumed from `view`, and the created
+ * action in `*action`. On failure, return -1.
+ */
+LTTNG_HIDDEN
+extern ssize_t lttng_action_increment_counter_create_from_payload(
+		struct lttng_payload_view *view,
+		struct lttng_action **action);
+
+/*
+ * Return true if `action` is an increment-counter action or a group of
+ * increment-counter actions only, in which case the firings of its trigger
+ * need no evaluation by the action executor.
+ */
+LTTNG_HIDDEN
+bool lttng_action_is_counter_only(const struct lttng_action *action);
+
+/*
+ * Return true if the key of an increment-counter action of `action`, or of
+ * one of its children, is completed by a captured event field value.
+ */
+LTTNG_HIDDEN
+bool lttng_action_counter_uses_captures(const struct lttng_action *action);
+
+/*
+ * Return true unless the key capture index of an increment-counter action of
+ * `action`, or of one of its children, designates no capture descriptor of
+ * `condition`.
+ */
+LTTNG_HIDDEN
+bool lttng_action_counter_key_captures_are_valid(
+		const struct lttng_action *action,
+		const struct lttng_condition *condition);
+
+#endif /* LTTNG_ACTION_INCREMENT_COUNTER_INTERNAL_H */
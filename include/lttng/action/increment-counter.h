@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_ACTION_INCREMENT_COUNTER_H
+#define LTTNG_ACTION_INCREMENT_COUNTER_H
+
+#include <lttng/action/action.h>
+
+struct lttng_action;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Create a newly allocated increment-counter action object.
+ *
+ * Each time the trigger fires, this action increments by one the value of
+ * its key in the counter map of the trigger's owner. The value of a key is
+ * the count of the firings, seen by the session daemon, of every trigger
+ * incrementing that key of that map.
+ *
+ * By default, the key is the same for every firing. When a key capture index
+ * is set, the key incremented by a firing of an on-event trigger is the
+ * action's key followed by `=` and the value of the event field captured at
+ * that index by the trigger's condition (for instance, `comm=bash`). An
+ * unavailable or array value is written as `?`, and keys are truncated to
+ * 255 bytes.
+ *
+ * Firings can be lost, for instance when a tracer can't write its
+ * notification to the session daemon in time. Such losses are not reflected
+ * in the values but counted apart (see
+ * lttng_counter_map_values_get_dropped_count()).
+ *
+ * Unlike the notify action, the firings of a trigger holding only
+ * increment-counter actions are aggregated without notifying any client.
+ * The maps can be read and cleared using the lttng_counter_map API (see
+ * lttng/counter-map.h).
+ *
+ * An increment-counter action object must have a map name and a key set to
+ * be considered valid when used with a trigger object (lttng_trigger).
+ *
+ * Returns a new action on success, NULL on failure. This action must be
+ * destroyed using lttng_action_destroy().
+ */
+extern struct lttng_action *lttng_action_increment_counter_create(void);
+
+/*
+ * Set the name of the counter map of an lttng_action object of type
+ * LTTNG_ACTION_TYPE_INCREMENT_COUNTER.
+ */
+extern enum lttng_action_status lttng_action_increment_counter_set_map_name(
+		struct lttng_action *action, const char *map_name);
+
+/*
+ * Get the name of the counter map of an lttng_action object of type
+ * LTTNG_ACTION_TYPE_INCREMENT_COUNTER.
+ */
+extern enum lttng_action_status lttng_action_increment_counter_get_map_name(
+		const struct lttng_action *action, const char **map_name);
+
+/*
+ * Set the key incremented by an lttng_action object of type
+ * LTTNG_ACTION_TYPE_INCREMENT_COUNTER.
+ */
+extern enum lttng_action_status lttng_action_increment_counter_set_key(
+		struct lttng_action *action, const char *key);
+
+/*
+ * Get the key incremented by an lttng_action object of type
+ * LTTNG_ACTION_TYPE_INCREMENT_COUNTER.
+ */
+extern enum lttng_action_status lttng_action_increment_counter_get_key(
+		const struct lttng_action *action, const char **key);
+
+/*
+ * Set the index, within the capture descriptors of the trigger's on-event
+ * condition, of the event field whose value completes the key incremented by
+ * an lttng_action object of type LTTNG_ACTION_TYPE_INCREMENT_COUNTER.
+ *
+ * A trigger holding such an action is rejected if its condition is not an
+ * on-event condition having a capture descriptor at that index.
+ */
+extern enum lttng_action_status
+lttng_action_increment_counter_set_key_capture_index(
+		struct lttng_action *action, unsigned int capture_index);
+
+/*
+ * Get the key capture index of an lttng_action object of type
+ * LTTNG_ACTION_TYPE_INCREMENT_COUNTER.
+ *
+ * Returns LTTNG_ACTION_STATUS_UNSET if the key of the action is the same for
+ * every firing.
+ */
+extern enum lttng_action_status
+lttng_action_increment_counter_get_key_capture_index(
+		const struct lttng_action *action, unsigned int *capture_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LTTNG_ACTION_INCREMENT_COUNTER_H */
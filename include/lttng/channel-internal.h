@@ -15,6 +15,10 @@ struct lttng_channel_extended {
 	uint64_t lost_packets;
 	uint64_t monitor_timer_interval;
 	int64_t blocking_timeout;
+	uint64_t writeback_window_size;
+	uint8_t direct_io;
+	/* Mask of enum lttng_channel_advisable_attr. */
+	uint8_t advisable_attrs;
 } LTTNG_PACKED;
 
 #endif /* LTTNG_CHANNEL_INTERNAL_H */
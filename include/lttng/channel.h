@@ -77,6 +77,26 @@ extern void lttng_channel_destroy(struct lttng_channel *channel);
 extern int lttng_list_channels(struct lttng_handle *handle,
 		struct lttng_channel **channels);
 
+/*
+ * List the channel(s) of a session whose name matches `name_pattern`, a
+ * star-only globbing pattern. All channels are listed if `name_pattern` is
+ * NULL.
+ *
+ * The listing starts at the `*cursor`-th matching channel (the first one if
+ * cursor is NULL) and holds at most `max_count` channels (no limit if 0). On
+ * success, `*cursor` is advanced past the listed channels so that the next
+ * ones can be listed by calling this function again. Listings are consistent
+ * as long as the session's channels are not modified between calls.
+ *
+ * The handle CAN NOT be NULL.
+ *
+ * Return the size (number of entries) of the "lttng_channel" array. Caller
+ * must free channels. On error, a negative LTTng error code is returned.
+ */
+extern int lttng_list_channels_filtered(struct lttng_handle *handle,
+		const char *name_pattern, unsigned int *cursor,
+		unsigned int max_count, struct lttng_channel **channels);
+
 /*
  * Create or enable a channel.
  *
@@ -134,6 +154,115 @@ extern int lttng_channel_get_blocking_timeout(struct lttng_channel *chan,
 extern int lttng_channel_set_blocking_timeout(struct lttng_channel *chan,
 		int64_t blocking_timeout);
 
+/*
+ * Get the writeback window size of a channel, in bytes.
+ *
+ * The consumer daemon leaves the most recently written 'window size' bytes
+ * of each stream file in flight and hands the older data to a dedicated
+ * writeback thread which waits for it to reach the disk and evicts it from
+ * the page cache. A window size of 0 means one sub-buffer.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+extern int lttng_channel_get_writeback_window_size(struct lttng_channel *chan,
+		uint64_t *window_size);
+
+/*
+ * Set the writeback window size of a channel, in bytes.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+extern int lttng_channel_set_writeback_window_size(struct lttng_channel *chan,
+		uint64_t window_size);
+
+/*
+ * Get whether or not the stream files of a channel are written with direct
+ * I/O (O_DIRECT), bypassing the page cache.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+extern int lttng_channel_get_direct_io(struct lttng_channel *chan,
+		int *direct_io);
+
+/*
+ * Set whether or not the stream files of a channel are written with direct
+ * I/O (O_DIRECT), bypassing the page cache.
+ *
+ * Direct I/O is only used by channels having the "mmap" output type and is
+ * ignored when the trace is streamed to a relay daemon.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+extern int lttng_channel_set_direct_io(struct lttng_channel *chan,
+		int direct_io);
+
+/*
+ * Attributes of a channel which were not chosen by the user and which the
+ * session daemon may replace with the geometry it advised for the user's
+ * previous channel of the same name and domain (see the
+ * --apply-channel-advice option of lttng-sessiond(8)).
+ */
+enum lttng_channel_advisable_attr {
+	LTTNG_CHANNEL_ADVISABLE_ATTR_SUBBUF_SIZE = (1 << 0),
+	LTTNG_CHANNEL_ADVISABLE_ATTR_NUM_SUBBUF = (1 << 1),
+	LTTNG_CHANNEL_ADVISABLE_ATTR_SWITCH_TIMER = (1 << 2),
+};
+
+/*
+ * Get the attributes of a channel, a mask of enum
+ * lttng_channel_advisable_attr, left to the advice of the session daemon.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+extern int lttng_channel_get_advisable_attributes(struct lttng_channel *chan,
+		unsigned int *attrs);
+
+/*
+ * Set the attributes of a channel, a mask of enum
+ * lttng_channel_advisable_attr, left to the advice of the session daemon.
+ * By default, every attribute is considered chosen by the user.
+ *
+ * Returns 0 on success, or a negative LTTng error code on error.
+ */
+extern int lttng_channel_set_advisable_attributes(struct lttng_channel *chan,
+		unsigned int attrs);
+
+/*
+ * Geometry recommended for a channel from the throughput observed in its
+ * buffers, the discarded events and the lost packets.
+ *
+ * The recommended geometry is the current one until the channel was sampled
+ * by its monitor timer at least twice.
+ */
+#define LTTNG_CHANNEL_ADVICE_PADDING		64
+struct lttng_channel_advice {
+	/* Observation period (usec); 0 if the channel was not sampled yet. */
+	uint64_t observed_period;
+	/* Average and peak rates (bytes/s) of the channel, all streams. */
+	uint64_t rate;
+	uint64_t peak_rate;
+	/* Highest usage (bytes) observed in a stream. */
+	uint64_t peak_usage;
+	uint64_t discarded_events;
+	uint64_t lost_packets;
+
+	/* Recommended attributes. */
+	uint64_t subbuf_size;			/* bytes, power of 2 */
+	uint64_t num_subbuf;			/* power of 2 */
+	unsigned int switch_timer_interval;	/* usec */
+
+	char padding[LTTNG_CHANNEL_ADVICE_PADDING];
+};
+
+/*
+ * Get the geometry recommended for the channel named `channel_name` of the
+ * handle's session and domain (kernel or user space).
+ *
+ * Return 0 on success else a negative LTTng error code.
+ */
+extern int lttng_channel_get_advice(struct lttng_handle *handle,
+		const char *channel_name, struct lttng_channel_advice *advice);
+
 #ifdef __cplusplus
 }
 #endif
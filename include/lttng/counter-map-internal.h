@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_COUNTER_MAP_INTERNAL_H
+#define LTTNG_COUNTER_MAP_INTERNAL_H
+
+#include <common/dynamic-array.h>
+#include <common/macros.h>
+#include <lttng/counter-map.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+struct lttng_payload;
+struct lttng_payload_view;
+
+struct lttng_counter_map_values {
+	/* Array of `struct lttng_counter_map_value *`. */
+	struct lttng_dynamic_pointer_array array;
+	uint64_t dropped_count;
+};
+
+struct lttng_counter_map_value {
+	/* Owned by this. */
+	char *key;
+	uint64_t value;
+};
+
+struct lttng_counter_map_values_comm {
+	uint64_t dropped_count;
+	uint32_t count;
+	/*
+	 * Variable data: `count` values, each as a
+	 * struct lttng_counter_map_value_comm.
+	 */
+	char data[];
+} LTTNG_PACKED;
+
+struct lttng_counter_map_value_comm {
+	uint64_t value;
+	/* Includes the trailing \0. */
+	uint32_t key_len;
+	/* Key (null terminated). */
+	char key[];
+} LTTNG_PACKED;
+
+LTTNG_HIDDEN
+struct lttng_counter_map_values *lttng_counter_map_values_create(void);
+
+/* Append a copy of `key` and its value to the set. */
+LTTNG_HIDDEN
+int lttng_counter_map_values_add(struct lttng_counter_map_values *values,
+		const char *key, uint64_t value);
+
+LTTNG_HIDDEN
+void lttng_counter_map_values_set_dropped_count(
+		struct lttng_counter_map_values *values,
+		uint64_t dropped_count);
+
+LTTNG_HIDDEN
+int lttng_counter_map_values_serialize(
+		const struct lttng_counter_map_values *values,
+		struct lttng_payload *payload);
+
+LTTNG_HIDDEN
+ssize_t lttng_counter_map_values_create_from_payload(
+		struct lttng_payload_view *view,
+		struct lttng_counter_map_values **values);
+
+#endif /* LTTNG_COUNTER_MAP_INTERNAL_H */
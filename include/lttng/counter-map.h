@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#ifndef LTTNG_COUNTER_MAP_H
+#define LTTNG_COUNTER_MAP_H
+
+#include <stdint.h>
+#include <lttng/lttng-error.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A counter map is a named set of keyed counters incremented by the
+ * increment-counter actions of triggers (see lttng/action/increment-counter.h).
+ *
+ * Counter maps are owned by the user who registered the triggers
+ * incrementing them. A map comes into existence when one of its keys is
+ * first incremented. A map holds at most 4096 keys: the increments of any
+ * other key are dropped.
+ */
+struct lttng_counter_map_values;
+
+enum lttng_counter_map_status {
+	LTTNG_COUNTER_MAP_STATUS_OK = 0,
+	LTTNG_COUNTER_MAP_STATUS_ERROR = -1,
+	LTTNG_COUNTER_MAP_STATUS_INVALID = -2,
+};
+
+/*
+ * Get the values of every key of a counter map of the current user.
+ *
+ * An empty set is returned if no key of the map was incremented.
+ *
+ * On success, the caller owns `*values` and must release it using
+ * lttng_counter_map_values_destroy().
+ *
+ * Returns LTTNG_OK on success, else a suitable lttng_error_code.
+ */
+extern enum lttng_error_code lttng_counter_map_list_values(
+		const char *map_name, struct lttng_counter_map_values **values);
+
+/*
+ * Reset a counter map of the current user, removing all its keys.
+ *
+ * Returns LTTNG_OK on success, else a suitable lttng_error_code.
+ */
+extern enum lttng_error_code lttng_counter_map_clear(const char *map_name);
+
+/*
+ * Get the number of keys of a counter map value set.
+ */
+extern enum lttng_counter_map_status lttng_counter_map_values_get_count(
+		const struct lttng_counter_map_values *values,
+		unsigned int *count);
+
+/*
+ * Get the key and value at index `index` of a counter map value set.
+ *
+ * `*key` remains valid until `values` is destroyed.
+ */
+extern enum lttng_counter_map_status lttng_counter_map_values_get_at_index(
+		const struct lttng_counter_map_values *values,
+		unsigned int index, const char **key, uint64_t *value);
+
+/*
+ * Get the number of increments of the map which were lost since it was last
+ * cleared, and are thus missing from its values.
+ *
+ * Increments are lost when the session daemon runs out of memory or of keys,
+ * when its action executor is saturated, or when the kernel tracer can't
+ * write the notification of a firing to the session daemon. Such discards of
+ * the user space tracers are not accounted for.
+ */
+extern enum lttng_counter_map_status lttng_counter_map_values_get_dropped_count(
+		const struct lttng_counter_map_values *values,
+		uint64_t *dropped_count);
+
+/*
+ * Destroy a counter map value set.
+ */
+extern void lttng_counter_map_values_destroy(
+		struct lttng_counter_map_values *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LTTNG_COUNTER_MAP_H */
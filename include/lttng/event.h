@@ -313,6 +313,27 @@ struct lttng_event_field {
 extern int lttng_list_events(struct lttng_handle *handle,
 		const char *channel_name, struct lttng_event **events);
 
+/*
+ * List the event(s) of a session channel whose name matches `name_pattern`,
+ * a star-only globbing pattern. All events are listed if `name_pattern` is
+ * NULL.
+ *
+ * The listing starts at the `*cursor`-th matching event (the first one if
+ * cursor is NULL) and holds at most `max_count` events (no limit if 0). On
+ * success, `*cursor` is advanced past the listed events so that the next ones
+ * can be listed by calling this function again. Listings are consistent as
+ * long as the channel's events are not modified between calls.
+ *
+ * Both handle and channel_name CAN NOT be NULL.
+ *
+ * Return the size (number of entries) of the "lttng_event" array. Caller must
+ * free events. On error a negative LTTng error code is returned.
+ */
+extern int lttng_list_events_filtered(struct lttng_handle *handle,
+		const char *channel_name, const char *name_pattern,
+		unsigned int *cursor, unsigned int max_count,
+		struct lttng_event **events);
+
 /*
  * Create an lttng_event.
  *
@@ -492,6 +513,28 @@ extern int lttng_enable_event_with_exclusions(struct lttng_handle *handle,
 		const char *filter_expression,
 		int exclusion_count, char **exclusion_names);
 
+/*
+ * Create or enable a set of events, without filter nor exclusions, for a
+ * channel in a single session daemon command.
+ *
+ * The events are enabled as if each of them was passed to
+ * lttng_enable_event(), but the kernel tracer and the registered applications
+ * are updated once for the whole set. Userspace probes are not supported.
+ * Agent (JUL, log4j and Python) events are enabled one at a time, each with
+ * its logger name and log level filter.
+ * If channel_name is NULL, the default channel is used (channel0) and created
+ * if not found.
+ *
+ * If ret_codes is not NULL, it must hold event_count elements and receives
+ * the outcome of each event: 0 on success else a negative LTTng error code.
+ *
+ * Return 0 if the events were processed, even if some of them failed, else
+ * a negative LTTng error code.
+ */
+extern int lttng_enable_events(struct lttng_handle *handle,
+		struct lttng_event *events, unsigned int event_count,
+		const char *channel_name, int *ret_codes);
+
 /*
  * Disable event(s) of a channel and domain.
  *
@@ -179,6 +179,8 @@ enum lttng_error_code {
 	LTTNG_ERR_EVENT_NOTIFIER_REGISTRATION = 166, /* Error registering event notifier to the tracer. */
 	LTTNG_ERR_EVENT_NOTIFIER_ERROR_ACCOUNTING = 167, /* Error initializing event notifier error accounting. */
 	LTTNG_ERR_EVENT_NOTIFIER_ERROR_ACCOUNTING_FULL = 168, /* Error event notifier error accounting full. */
+	LTTNG_ERR_LOCAL_COPY_SPLICE      = 169, /* The local copy of a streamed session requires the mmap output. */
+	LTTNG_ERR_LIVE_LOCAL_NO_URL      = 170, /* Live session with a local output but no consumer daemon live URL. */
 
 	/* MUST be last element of the manually-assigned section of the enum */
 	LTTNG_ERR_NR,
@@ -25,9 +25,12 @@
  *   - New condition type "LTTNG_CONDITION_TYPE_SESSION_CONSUMED_SIZE" added,
  *   - New condition type "LTTNG_CONDITION_TYPE_SESSION_ROTATION_ONGOING" added,
  *   - New condition type "LTTNG_CONDITION_TYPE_SESSION_ROTATION_COMPLETED" added,
+ * - v1.2
+ *   - New message types to subscribe and unsubscribe to a set of conditions
+ *     with a single command.
  */
 #define LTTNG_NOTIFICATION_CHANNEL_VERSION_MAJOR 1
-#define LTTNG_NOTIFICATION_CHANNEL_VERSION_MINOR 1
+#define LTTNG_NOTIFICATION_CHANNEL_VERSION_MINOR 2
 
 enum lttng_notification_channel_message_type {
 	LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNKNOWN = -1,
@@ -37,6 +40,8 @@ enum lttng_notification_channel_message_type {
 	LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_COMMAND_REPLY = 3,
 	LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_NOTIFICATION = 4,
 	LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_NOTIFICATION_DROPPED = 5,
+	LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_MULTIPLE = 6,
+	LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE_MULTIPLE = 7,
 };
 
 struct lttng_notification_channel_message {
@@ -59,6 +64,17 @@ struct lttng_notification_channel_command_reply {
 	int8_t status;
 } LTTNG_PACKED;
 
+/*
+ * Payload of the SUBSCRIBE_MULTIPLE and UNSUBSCRIBE_MULTIPLE messages. The
+ * reply to those commands is followed by the status (int8_t) of each
+ * condition.
+ */
+struct lttng_notification_channel_command_conditions {
+	uint32_t condition_count;
+	/* condition_count serialized conditions. */
+	char conditions[];
+} LTTNG_PACKED;
+
 struct pending_notification {
 	/* NULL means "notification dropped". */
 	struct lttng_notification *notification;
@@ -91,6 +107,14 @@ struct lttng_notification_channel {
 		struct cds_list_head list;
 	} pending_notifications;
 	struct lttng_payload reception_payload;
+	/*
+	 * Complete messages, without file descriptors, received at once from
+	 * the socket and not yet decoded. The messages start at 'offset'.
+	 */
+	struct {
+		struct lttng_dynamic_buffer buffer;
+		size_t offset;
+	} reception_buffer;
 	/* Sessiond notification protocol version. */
 	struct {
 		bool set;
@@ -107,6 +107,39 @@ lttng_notification_channel_has_pending_notification(
 		struct lttng_notification_channel *channel,
 		bool *notification_pending);
 
+/*
+ * Get all the notifications pending on a notification channel.
+ *
+ * This call does not block waiting for new notifications: it returns the
+ * notifications that were already received along with those that are
+ * available on the channel at the time of the call. A single call receives
+ * many notifications, making it well suited to clients that handle a high
+ * rate of notifications.
+ *
+ * On success, the ownership of the returned array and of the notifications
+ * it contains is transferred to the caller. The notifications must be
+ * destroyed using lttng_notification_destroy() and the array must be
+ * released using free(). The array is set to NULL when count is 0.
+ *
+ * Returns
+ *   - LTTNG_NOTIFICATION_CHANNEL_STATUS_OK on success,
+ *   - LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID if an invalid parameter was
+ *     provided,
+ *   - LTTNG_NOTIFICATION_CHANNEL_STATUS_NOTIFICATIONS_DROPPED if notifications
+ *     were dropped; the notifications that were not dropped are still
+ *     returned,
+ *   - LTTNG_NOTIFICATION_CHANNEL_STATUS_INTERRUPTED if a signal was received
+ *     while checking the channel; no notification is returned and those
+ *     already received are kept for the next call,
+ *   - LTTNG_NOTIFICATION_CHANNEL_STATUS_CLOSED if the channel was closed and
+ *     no notification is left.
+ */
+extern enum lttng_notification_channel_status
+lttng_notification_channel_get_pending_notifications(
+		struct lttng_notification_channel *channel,
+		struct lttng_notification ***notifications,
+		unsigned int *count);
+
 /*
  * Subscribe to notifications of a condition through a notification channel.
  *
@@ -153,6 +186,58 @@ lttng_notification_channel_unsubscribe(
 extern void lttng_notification_channel_destroy(
 		struct lttng_notification_channel *channel);
 
+/*
+ * Subscribe to notifications of a set of conditions through a notification
+ * channel.
+ *
+ * This call is equivalent to calling lttng_notification_channel_subscribe()
+ * on each condition, but the conditions are sent to the session daemon in as
+ * few commands as possible.
+ *
+ * The caller retains the ownership of the conditions passed through this
+ * call. The status of the subscription to each condition is returned in the
+ * `statuses` array which must be able to hold `count` elements.
+ *
+ * Returns
+ *   - LTTNG_NOTIFICATION_CHANNEL_STATUS_OK if all subscriptions succeeded,
+ *   - LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID if an invalid parameter or
+ *     condition was provided, in which case no subscription is made,
+ *   - the first status other than LTTNG_NOTIFICATION_CHANNEL_STATUS_OK
+ *     found in `statuses` otherwise.
+ */
+extern enum lttng_notification_channel_status
+lttng_notification_channel_subscribe_multiple(
+		struct lttng_notification_channel *channel,
+		const struct lttng_condition *const *conditions,
+		unsigned int count,
+		enum lttng_notification_channel_status *statuses);
+
+/*
+ * Unsubscribe from notifications of a set of conditions through a
+ * notification channel.
+ *
+ * This call is equivalent to calling lttng_notification_channel_unsubscribe()
+ * on each condition, but the conditions are sent to the session daemon in as
+ * few commands as possible.
+ *
+ * The caller retains the ownership of the conditions passed through this
+ * call. The status of the unsubscription from each condition is returned in
+ * the `statuses` array which must be able to hold `count` elements.
+ *
+ * Returns
+ *   - LTTNG_NOTIFICATION_CHANNEL_STATUS_OK if all unsubscriptions succeeded,
+ *   - LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID if an invalid parameter or
+ *     condition was provided, in which case nothing is unsubscribed,
+ *   - the first status other than LTTNG_NOTIFICATION_CHANNEL_STATUS_OK
+ *     found in `statuses` otherwise.
+ */
+extern enum lttng_notification_channel_status
+lttng_notification_channel_unsubscribe_multiple(
+		struct lttng_notification_channel *channel,
+		const struct lttng_condition *const *conditions,
+		unsigned int count,
+		enum lttng_notification_channel_status *statuses);
+
 #ifdef __cplusplus
 }
 #endif
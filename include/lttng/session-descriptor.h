@@ -46,6 +46,7 @@ struct lttng_session_descriptor;
  *
  * Live session creation functions and output modes:
  *   * "no output": lttng_session_descriptor_live_create()
+ *   * local:       lttng_session_descriptor_live_local_create()
  *   * network:     lttng_session_descriptor_live_network_create()
  *
  * Local output functions accept a 'path' parameter that must be an absolute
@@ -189,6 +190,31 @@ extern struct lttng_session_descriptor *
 lttng_session_descriptor_live_create(
 		const char *name, unsigned long long live_timer_interval_us);
 
+/*
+ * Create a live session descriptor with a local output destination.
+ *
+ * The trace is written to the local output destination while the consumer
+ * daemons started with a live URL serve it to live viewers directly, without
+ * a relay daemon.
+ *
+ * The 'name' parameter can be left NULL to auto-generate a session name.
+ *
+ * The 'path' must either be an absolute path or it can be left NULL to
+ * use the default local output destination.
+ *
+ * The 'live_timer_interval_us' parameter is the live timer's period, specified
+ * in microseconds.
+ *
+ * This parameter can't be 0. There is no default value defined for a live
+ * timer's period.
+ *
+ * Returns an lttng_session_descriptor instance on success, NULL on error.
+ */
+extern struct lttng_session_descriptor *
+lttng_session_descriptor_live_local_create(
+		const char *name, const char *path,
+		unsigned long long live_timer_interval_us);
+
 /*
  * Create a live session descriptor with a remote output destination.
  *
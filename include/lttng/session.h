@@ -207,6 +207,20 @@ extern enum lttng_error_code lttng_session_get_creation_time(
 extern int lttng_set_session_shm_path(const char *session_name,
 		const char *shm_path);
 
+/*
+ * Set the local copy path of a session.
+ *
+ * A session streamed to a relay daemon also writes a local copy of its
+ * trace under this absolute path, from the same sub-buffers. The local copy
+ * requires channels using the mmap output: kernel channels using the splice
+ * output are rejected. An empty path disables the local copy. The path can
+ * only be set before the session is started.
+ *
+ * Return 0 on success else a negative LTTng error code.
+ */
+extern int lttng_set_session_local_copy_path(const char *session_name,
+		const char *path);
+
 #ifdef __cplusplus
 }
 #endif
@@ -164,6 +164,26 @@ void lttng_snapshot_output_list_destroy(struct lttng_snapshot_output_list *list)
 int lttng_snapshot_record(const char *session_name,
 		struct lttng_snapshot_output *output, int wait);
 
+/*
+ * Snapshot a subset of the trace of the given session.
+ *
+ * Same as lttng_snapshot_record(), except that only the channels named in the
+ * 'channel_names' array of 'channel_count' entries are recorded. The names
+ * are matched against the channels of every tracing domain of the session.
+ * Every channel is recorded when 'channel_count' is 0. The metadata of the
+ * traces is always recorded.
+ *
+ * When 'time_window_us' is not 0, only the packets which end within the last
+ * 'time_window_us' microseconds are recorded. The window is evaluated against
+ * the monotonic clock, which is the default clock of the tracers.
+ *
+ * Return 0 on success or else a negative LTTNG_ERR value.
+ */
+int lttng_snapshot_record_scoped(const char *session_name,
+		struct lttng_snapshot_output *output,
+		const char * const *channel_names, unsigned int channel_count,
+		uint64_t time_window_us, int wait);
+
 #ifdef __cplusplus
 }
 #endif
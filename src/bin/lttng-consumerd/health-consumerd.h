@@ -16,6 +16,10 @@ enum health_type_consumerd {
 	HEALTH_CONSUMERD_TYPE_DATA		= 2,
 	HEALTH_CONSUMERD_TYPE_SESSIOND		= 3,
 	HEALTH_CONSUMERD_TYPE_METADATA_TIMER	= 4,
+	HEALTH_CONSUMERD_TYPE_WRITEBACK		= 5,
+	HEALTH_CONSUMERD_TYPE_COMMAND_WORKER	= 6,
+	HEALTH_CONSUMERD_TYPE_LIVE		= 7,
+	HEALTH_CONSUMERD_TYPE_BUFFER_POOL	= 8,
 
 	NR_HEALTH_CONSUMERD_TYPES,
 };
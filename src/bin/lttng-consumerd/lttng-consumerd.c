@@ -33,19 +33,27 @@
 #include <common/defaults.h>
 #include <common/common.h>
 #include <common/consumer/consumer.h>
+#include <common/consumer/consumer-live.h>
 #include <common/consumer/consumer-timer.h>
+#include <common/consumer/consumer-writeback.h>
+#include <common/ust-consumer/ust-consumer-pool.h>
 #include <common/compat/poll.h>
 #include <common/compat/getenv.h>
 #include <common/sessiond-comm/sessiond-comm.h>
+#include <common/uri.h>
 #include <common/utils.h>
 
 #include "lttng-consumerd.h"
 #include "health-consumerd.h"
 
-/* threads (channel handling, poll, metadata, sessiond) */
+/*
+ * threads (channel handling, poll, metadata, sessiond, writeback, live,
+ * buffer pool)
+ */
 
 static pthread_t channel_thread, data_thread, metadata_thread,
-		sessiond_thread, metadata_timer_thread, health_thread;
+		sessiond_thread, metadata_timer_thread, health_thread,
+		writeback_thread, live_thread, pool_thread;
 static bool metadata_timer_thread_online;
 
 /* to count the number of times the user pressed ctrl+c */
@@ -61,6 +69,8 @@ static const char *progname;
 static char command_sock_path[PATH_MAX]; /* Global command socket path */
 static char error_sock_path[PATH_MAX]; /* Global error path */
 static enum lttng_consumer_type opt_type = LTTNG_CONSUMER_KERNEL;
+/* Local live endpoint, NULL when disabled. */
+static struct lttng_uri *live_uri;
 
 /* the liblttngconsumerd context */
 static struct lttng_consumer_local_data *ctx;
@@ -165,6 +175,8 @@ static void usage(FILE *fp)
 			" (support not compiled in)"
 #endif
 			);
+	fprintf(fp, "      --live-url URL                 "
+			"Serve the local live sessions to live viewers on URL.\n");
 }
 
 /*
@@ -187,6 +199,7 @@ static int parse_args(int argc, char **argv)
 #ifdef HAVE_LIBLTTNG_UST_CTL
 		{ "ust", 0, 0, 'u' },
 #endif
+		{ "live-url", 1, 0, 'l' },
 		{ NULL, 0, 0, 0 }
 	};
 
@@ -261,6 +274,24 @@ static int parse_args(int argc, char **argv)
 # endif
 			break;
 #endif
+		case 'l':
+			if (lttng_is_setuid_setgid()) {
+				WARN("Getting '%s' argument from setuid/setgid binary refused for security reasons.",
+					"--live-url");
+				break;
+			}
+			uri_free(live_uri);
+			if (uri_parse(optarg, &live_uri) != 1) {
+				ERR("Invalid live URL specified");
+				ret = -1;
+				goto end;
+			}
+			if (live_uri->port == 0) {
+				ERR("A port must be specified in the live URL");
+				ret = -1;
+				goto end;
+			}
+			break;
 		default:
 			usage(stderr);
 			ret = -1;
@@ -511,6 +542,50 @@ int main(int argc, char **argv)
 	}
 	metadata_timer_thread_online = true;
 
+	/*
+	 * Create the thread waiting on the writeback of the output files so
+	 * that the data and metadata threads never block on the disk.
+	 */
+	ret = pthread_create(&writeback_thread, default_pthread_attr(),
+			consumer_writeback_thread, (void *) ctx);
+	if (ret) {
+		errno = ret;
+		PERROR("pthread_create writeback");
+		retval = -1;
+		goto exit_writeback_thread;
+	}
+
+	if (live_uri) {
+		/* Bind now so that a misconfiguration is reported at launch. */
+		ret = consumer_live_init(live_uri);
+		if (ret) {
+			retval = -1;
+			goto exit_live_thread;
+		}
+
+		ret = pthread_create(&live_thread, default_pthread_attr(),
+				consumer_live_thread, (void *) ctx);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create live");
+			retval = -1;
+			goto exit_live_thread;
+		}
+	}
+
+	if (opt_type != LTTNG_CONSUMER_KERNEL) {
+		/* Create the buffers reserved by the session daemon. */
+		lttng_ustconsumer_pool_init();
+		ret = pthread_create(&pool_thread, default_pthread_attr(),
+				lttng_ustconsumer_pool_thread, (void *) ctx);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_create buffer pool");
+			retval = -1;
+			goto exit_pool_thread;
+		}
+	}
+
 	/* Create thread to manage channels */
 	ret = pthread_create(&channel_thread, default_pthread_attr(),
 			consumer_thread_channel_poll,
@@ -592,6 +667,40 @@ exit_metadata_thread:
 	}
 exit_channel_thread:
 
+	if (opt_type != LTTNG_CONSUMER_KERNEL) {
+		/* No buffer set may be reserved or taken from this point. */
+		lttng_ustconsumer_pool_thread_quit();
+		ret = pthread_join(pool_thread, &status);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join pool_thread");
+			retval = -1;
+		}
+	}
+exit_pool_thread:
+
+	if (live_uri) {
+		/* All streams served to the viewers are gone at this point. */
+		consumer_live_thread_quit();
+		ret = pthread_join(live_thread, &status);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join live_thread");
+			retval = -1;
+		}
+	}
+exit_live_thread:
+
+	/* All producers of writeback ranges are gone at this point. */
+	consumer_writeback_thread_quit();
+	ret = pthread_join(writeback_thread, &status);
+	if (ret) {
+		errno = ret;
+		PERROR("pthread_join writeback_thread");
+		retval = -1;
+	}
+exit_writeback_thread:
+
 exit_metadata_timer_thread:
 
 	ret = pthread_join(health_thread, &status);
@@ -656,6 +765,7 @@ exit_init_data:
 
 exit_health_consumerd_cleanup:
 exit_options:
+	uri_free(live_uri);
 exit_set_signal_handler:
 
 	rcu_unregister_thread();
@@ -0,0 +1,1869 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <urcu/list.h>
+#include <urcu/ref.h>
+#include <urcu/uatomic.h>
+
+#include <common/common.h>
+#include <common/compat/endian.h>
+#include <common/compat/time.h>
+#include <common/defaults.h>
+#include <common/dynamic-array.h>
+#include <common/dynamic-buffer.h>
+#include <common/fs-handle.h>
+#include <common/index/ctf-index.h>
+#include <common/optional.h>
+#include <common/relayd/relayd.h>
+#include <common/sessiond-comm/relayd.h>
+#include <common/sessiond-comm/sessiond-comm.h>
+#include <common/time.h>
+#include <common/utils.h>
+
+#include "ctf-trace.h"
+#include "forward.h"
+#include "health-relayd.h"
+#include "lttng-relayd.h"
+#include "session.h"
+#include "stream.h"
+
+enum forward_session_state {
+	/* The upstream connections of the session are being established. */
+	FORWARD_SESSION_STATE_CONNECTING,
+	/* The commands of the session are replayed upstream. */
+	FORWARD_SESSION_STATE_ACTIVE,
+	/* The session is only kept locally. */
+	FORWARD_SESSION_STATE_ABANDONED,
+};
+
+/*
+ * Upstream counterpart of a forwarded session. The commands and packets of
+ * the session are replayed upstream, in order, by the session's thread.
+ */
+struct relay_forward_session {
+	struct urcu_ref ref;
+	/* Id of the session on this relay daemon, for logging purposes. */
+	uint64_t session_id;
+	pthread_t thread;
+	/* Node of the forwarded session list, protected by its lock. */
+	struct cds_list_head node;
+	/* The following fields are only used by the session's thread. */
+	struct lttcomm_relayd_sock *control_sock;
+	struct lttcomm_relayd_sock *data_sock;
+	/* Id of the session on the upstream relay daemon. */
+	uint64_t upstream_session_id;
+	/*
+	 * Attributes of the session, copied as the session may be created
+	 * upstream long after it was created locally.
+	 */
+	struct {
+		char session_name[LTTNG_NAME_MAX];
+		char hostname[LTTNG_HOST_NAME_MAX];
+		char base_path[LTTNG_PATH_MAX];
+		uint32_t live_timer;
+		bool snapshot;
+		uint64_t id_sessiond;
+		lttng_uuid sessiond_uuid;
+		LTTNG_OPTIONAL(uint64_t) current_chunk_id;
+		time_t creation_time;
+		bool session_name_contains_creation_time;
+	} attributes;
+	/*
+	 * Streams (struct relay_forward_stream) with packets sent upstream
+	 * which the upstream relay daemon has not reported as written yet.
+	 */
+	struct lttng_dynamic_pointer_array unflushed_streams;
+	pthread_mutex_t lock;
+	/*
+	 * Signaled when a command is queued, when the session is destroyed
+	 * locally and when the thread must exit.
+	 */
+	pthread_cond_t cond;
+	/*
+	 * The following fields are protected by the session lock. The state
+	 * is also read atomically by the hooks.
+	 */
+	enum forward_session_state state;
+	struct cds_list_head commands;
+	/* Memory used by the queued commands and packets (bytes). */
+	uint64_t queued_size;
+	/* The session was destroyed locally. */
+	bool closed;
+	/* The relay daemon is exiting. */
+	bool quit;
+	/* The session's thread has exited and can be joined. */
+	bool exited;
+};
+
+/*
+ * Local stream file from which the packets which don't fit in memory are
+ * read back when they are sent upstream.
+ */
+struct forward_local_file {
+	struct urcu_ref ref;
+	struct fs_handle *handle;
+	/* Reference on the trace chunk the file belongs to. */
+	struct lttng_trace_chunk *chunk;
+	uint64_t tracefile_index;
+};
+
+/* Upstream counterpart of a forwarded stream. */
+struct relay_forward_stream {
+	struct urcu_ref ref;
+	/* Reference on the session the stream belongs to. */
+	struct relay_forward_session *fsession;
+	/* The following fields are only used by the session's thread. */
+	/* Handle of the stream upstream, -1ULL until it is added upstream. */
+	uint64_t upstream_id;
+	/* Sequence number of the last packet sent upstream, -1ULL if none. */
+	uint64_t sent_net_seq_num;
+	/* The stream is in the session's unflushed streams. */
+	bool unflushed;
+	/* The stream was closed upstream. */
+	bool closed;
+	/* The following fields are protected by the session lock. */
+	/* Sequence number of the last packet queued, -1ULL if none. */
+	uint64_t queued_net_seq_num;
+	/*
+	 * Sequence number up to which the upstream relay daemon reported
+	 * having written the stream's packets, -1ULL if unknown.
+	 */
+	uint64_t flushed_net_seq_num;
+	/*
+	 * The following fields describe the packet being received and are
+	 * protected by the lock of the relay stream.
+	 */
+	bool packet_started;
+	/* The packet is read back from the local trace, at `packet_offset`. */
+	bool packet_local;
+	uint64_t packet_offset;
+	uint64_t packet_size;
+	/* Local file of the packet being received, if any. */
+	struct forward_local_file *local_file;
+};
+
+enum forward_command_type {
+	FORWARD_COMMAND_CREATE_SESSION,
+	FORWARD_COMMAND_CREATE_TRACE_CHUNK,
+	FORWARD_COMMAND_CLOSE_TRACE_CHUNK,
+	FORWARD_COMMAND_ADD_STREAM,
+	FORWARD_COMMAND_STREAMS_SENT,
+	FORWARD_COMMAND_CLOSE_STREAM,
+	FORWARD_COMMAND_METADATA,
+	FORWARD_COMMAND_RESET_METADATA,
+	FORWARD_COMMAND_INDEX,
+	FORWARD_COMMAND_BEACONS,
+	FORWARD_COMMAND_ROTATE_STREAMS,
+	FORWARD_COMMAND_DATA,
+};
+
+/* Position of a stream, as carried by beacons and rotations. */
+struct forward_stream_position {
+	/* Reference on the stream. */
+	struct relay_forward_stream *fstream;
+	uint64_t net_seq_num;
+	uint64_t timestamp_end;
+};
+
+/*
+ * Command, or data packet, replayed upstream by the thread of its session.
+ * Commands hold copies of (or references on) everything they need, as the
+ * thread runs them after the worker thread has moved on.
+ */
+struct forward_command {
+	enum forward_command_type type;
+	/* Reference on the session the command belongs to. */
+	struct relay_forward_session *fsession;
+	/* Reference on the stream targeted by the command, if any. */
+	struct relay_forward_stream *fstream;
+	/* Reference on the trace chunk of the command, if any. */
+	struct lttng_trace_chunk *chunk;
+	union {
+		struct {
+			char *channel_name;
+			char *path_name;
+			uint64_t tracefile_size;
+			uint64_t tracefile_count;
+		} add_stream;
+		struct {
+			uint64_t last_net_seq_num;
+		} close_stream;
+		struct {
+			uint32_t padding_size;
+		} metadata;
+		struct {
+			uint64_t version;
+		} reset_metadata;
+		struct {
+			struct ctf_packet_index index;
+			uint64_t net_seq_num;
+		} index;
+		struct {
+			LTTNG_OPTIONAL(uint64_t) new_chunk_id;
+		} rotate_streams;
+		struct {
+			uint64_t net_seq_num;
+			uint64_t size;
+			uint32_t padding_size;
+			/*
+			 * Local file from which the packet is read back, NULL
+			 * if its contents are in the payload.
+			 */
+			struct forward_local_file *local_file;
+			uint64_t offset;
+		} data;
+	} u;
+	/* Contents of a metadata or data packet. */
+	struct lttng_dynamic_buffer payload;
+	/* Array of struct forward_stream_position. */
+	struct lttng_dynamic_array positions;
+	/* Size accounted for in the session's queued size (bytes). */
+	uint64_t size;
+	struct cds_list_head node;
+};
+
+static struct {
+	/* Control and data URIs of the upstream relay daemon. */
+	struct lttng_uri control_uri;
+	struct lttng_uri data_uri;
+	bool enabled;
+	pthread_mutex_t lock;
+	/*
+	 * Forwarded sessions whose thread has not been joined yet, each one
+	 * holding a reference. Protected by the lock.
+	 */
+	struct cds_list_head sessions;
+} forward = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.sessions = CDS_LIST_HEAD_INIT(forward.sessions),
+};
+
+static const char *forward_command_str(enum forward_command_type type)
+{
+	switch (type) {
+	case FORWARD_COMMAND_CREATE_SESSION:
+		return "create session";
+	case FORWARD_COMMAND_CREATE_TRACE_CHUNK:
+		return "create trace chunk";
+	case FORWARD_COMMAND_CLOSE_TRACE_CHUNK:
+		return "close trace chunk";
+	case FORWARD_COMMAND_ADD_STREAM:
+		return "add stream";
+	case FORWARD_COMMAND_STREAMS_SENT:
+		return "streams sent";
+	case FORWARD_COMMAND_CLOSE_STREAM:
+		return "close stream";
+	case FORWARD_COMMAND_METADATA:
+		return "metadata";
+	case FORWARD_COMMAND_RESET_METADATA:
+		return "reset metadata";
+	case FORWARD_COMMAND_INDEX:
+		return "index";
+	case FORWARD_COMMAND_BEACONS:
+		return "beacons";
+	case FORWARD_COMMAND_ROTATE_STREAMS:
+		return "rotate streams";
+	case FORWARD_COMMAND_DATA:
+		return "data packet";
+	default:
+		abort();
+	}
+}
+
+static void forward_session_release(struct urcu_ref *ref)
+{
+	struct relay_forward_session *fsession = caa_container_of(ref,
+			struct relay_forward_session, ref);
+
+	lttng_dynamic_pointer_array_reset(&fsession->unflushed_streams);
+	pthread_cond_destroy(&fsession->cond);
+	pthread_mutex_destroy(&fsession->lock);
+	free(fsession);
+}
+
+static void forward_session_get(struct relay_forward_session *fsession)
+{
+	urcu_ref_get(&fsession->ref);
+}
+
+static void forward_session_put(struct relay_forward_session *fsession)
+{
+	if (!fsession) {
+		return;
+	}
+	urcu_ref_put(&fsession->ref, forward_session_release);
+}
+
+static void forward_local_file_release(struct urcu_ref *ref)
+{
+	struct forward_local_file *local_file = caa_container_of(ref,
+			struct forward_local_file, ref);
+
+	(void) fs_handle_close(local_file->handle);
+	lttng_trace_chunk_put(local_file->chunk);
+	free(local_file);
+}
+
+static void forward_local_file_get(struct forward_local_file *local_file)
+{
+	urcu_ref_get(&local_file->ref);
+}
+
+static void forward_local_file_put(struct forward_local_file *local_file)
+{
+	if (!local_file) {
+		return;
+	}
+	urcu_ref_put(&local_file->ref, forward_local_file_release);
+}
+
+static void forward_stream_release(struct urcu_ref *ref)
+{
+	struct relay_forward_stream *fstream = caa_container_of(ref,
+			struct relay_forward_stream, ref);
+
+	forward_local_file_put(fstream->local_file);
+	forward_session_put(fstream->fsession);
+	free(fstream);
+}
+
+static void forward_stream_get(struct relay_forward_stream *fstream)
+{
+	urcu_ref_get(&fstream->ref);
+}
+
+void relay_forward_stream_put(struct relay_forward_stream *fstream)
+{
+	if (!fstream) {
+		return;
+	}
+	urcu_ref_put(&fstream->ref, forward_stream_release);
+}
+
+static void forward_stream_put_pointer(void *ptr)
+{
+	relay_forward_stream_put(ptr);
+}
+
+static void forward_stream_position_destroy(void *element)
+{
+	struct forward_stream_position *position = element;
+
+	relay_forward_stream_put(position->fstream);
+}
+
+/*
+ * Stop forwarding a session. The error is only reported once per session.
+ * Must be called with the session lock held.
+ */
+static void forward_session_abandon_locked(
+		struct relay_forward_session *fsession, const char *command)
+{
+	if (fsession->state == FORWARD_SESSION_STATE_ABANDONED) {
+		return;
+	}
+	ERR("Failed to forward \"%s\" of session %" PRIu64 " to the upstream relay daemon, the session is now only kept locally",
+			command, fsession->session_id);
+	uatomic_set(&fsession->state, FORWARD_SESSION_STATE_ABANDONED);
+	pthread_cond_broadcast(&fsession->cond);
+}
+
+static void forward_session_abandon(struct relay_forward_session *fsession,
+		const char *command)
+{
+	pthread_mutex_lock(&fsession->lock);
+	forward_session_abandon_locked(fsession, command);
+	pthread_mutex_unlock(&fsession->lock);
+}
+
+static bool forward_session_is_abandoned(
+		struct relay_forward_session *fsession)
+{
+	return uatomic_read(&fsession->state) ==
+			FORWARD_SESSION_STATE_ABANDONED;
+}
+
+/*
+ * Return the forwarding state of a session, or NULL if the session is not
+ * (or no longer) forwarded.
+ */
+static struct relay_forward_session *session_forward(
+		struct relay_session *session)
+{
+	struct relay_forward_session *fsession = session->forward;
+
+	if (!fsession || forward_session_is_abandoned(fsession)) {
+		return NULL;
+	}
+	return fsession;
+}
+
+static struct relay_forward_stream *stream_forward(
+		struct relay_stream *stream)
+{
+	struct relay_forward_stream *fstream = stream->forward;
+
+	if (!fstream || forward_session_is_abandoned(fstream->fsession)) {
+		return NULL;
+	}
+	return fstream;
+}
+
+/*
+ * Return a reference on the upstream counterpart of a stream of this relay
+ * daemon, or NULL if the stream is unknown or not forwarded.
+ */
+static struct relay_forward_stream *stream_id_to_forward(uint64_t stream_id)
+{
+	struct relay_forward_stream *fstream = NULL;
+	struct relay_stream *stream;
+
+	stream = stream_get_by_id(stream_id);
+	if (!stream) {
+		goto end;
+	}
+	pthread_mutex_lock(&stream->lock);
+	fstream = stream->forward;
+	if (fstream) {
+		forward_stream_get(fstream);
+	}
+	pthread_mutex_unlock(&stream->lock);
+	stream_put(stream);
+end:
+	return fstream;
+}
+
+static struct forward_command *forward_command_create(
+		enum forward_command_type type,
+		struct relay_forward_session *fsession,
+		struct relay_forward_stream *fstream)
+{
+	struct forward_command *command;
+
+	command = zmalloc(sizeof(*command));
+	if (!command) {
+		PERROR("zmalloc upstream command");
+		forward_session_abandon(fsession, forward_command_str(type));
+		goto end;
+	}
+
+	command->type = type;
+	forward_session_get(fsession);
+	command->fsession = fsession;
+	if (fstream) {
+		forward_stream_get(fstream);
+		command->fstream = fstream;
+	}
+	lttng_dynamic_buffer_init(&command->payload);
+	lttng_dynamic_array_init(&command->positions,
+			sizeof(struct forward_stream_position),
+			forward_stream_position_destroy);
+	CDS_INIT_LIST_HEAD(&command->node);
+end:
+	return command;
+}
+
+static void forward_command_destroy(struct forward_command *command)
+{
+	if (!command) {
+		return;
+	}
+
+	switch (command->type) {
+	case FORWARD_COMMAND_ADD_STREAM:
+		free(command->u.add_stream.channel_name);
+		free(command->u.add_stream.path_name);
+		break;
+	case FORWARD_COMMAND_DATA:
+		forward_local_file_put(command->u.data.local_file);
+		break;
+	default:
+		break;
+	}
+
+	if (command->chunk) {
+		lttng_trace_chunk_put(command->chunk);
+	}
+	lttng_dynamic_buffer_reset(&command->payload);
+	lttng_dynamic_array_reset(&command->positions);
+	relay_forward_stream_put(command->fstream);
+	forward_session_put(command->fsession);
+	free(command);
+}
+
+/*
+ * Queue a command on the thread of its session; ownership of the command
+ * is transferred. Never blocks: a session whose backlog exceeds
+ * DEFAULT_RELAYD_UPSTREAM_QUEUE_MAX_SIZE is abandoned.
+ */
+static void forward_command_enqueue(struct forward_command *command)
+{
+	struct relay_forward_session *fsession;
+
+	if (!command) {
+		return;
+	}
+	fsession = command->fsession;
+	command->size = sizeof(*command) + command->payload.size +
+			lttng_dynamic_array_get_count(&command->positions) *
+					sizeof(struct forward_stream_position);
+
+	pthread_mutex_lock(&fsession->lock);
+	if (fsession->state == FORWARD_SESSION_STATE_ABANDONED) {
+		goto error_unlock;
+	}
+	if (fsession->queued_size + command->size >
+			DEFAULT_RELAYD_UPSTREAM_QUEUE_MAX_SIZE) {
+		ERR("Upstream queue of session %" PRIu64 " is full",
+				fsession->session_id);
+		forward_session_abandon_locked(fsession,
+				forward_command_str(command->type));
+		goto error_unlock;
+	}
+	fsession->queued_size += command->size;
+	if (command->type == FORWARD_COMMAND_DATA) {
+		command->fstream->queued_net_seq_num =
+				command->u.data.net_seq_num;
+	}
+	cds_list_add_tail(&command->node, &fsession->commands);
+	pthread_cond_broadcast(&fsession->cond);
+	pthread_mutex_unlock(&fsession->lock);
+	return;
+
+error_unlock:
+	pthread_mutex_unlock(&fsession->lock);
+	forward_command_destroy(command);
+}
+
+/*
+ * Allocate and connect a socket to the upstream relay daemon. The version
+ * check is only performed on control connections; `incompatible` is set if
+ * the upstream relay daemon can't forward sessions. The connection and
+ * every later exchange on the socket are bounded by the network timeout,
+ * or by DEFAULT_RELAYD_UPSTREAM_TIMEOUT if none is set.
+ */
+static struct lttcomm_relayd_sock *forward_connect(struct lttng_uri *uri,
+		bool *incompatible)
+{
+	int ret;
+	struct lttcomm_relayd_sock *rsock;
+
+	rsock = lttcomm_alloc_relayd_sock(uri, RELAYD_VERSION_COMM_MAJOR,
+			RELAYD_VERSION_COMM_MINOR);
+	if (!rsock) {
+		goto error;
+	}
+
+	if (!lttcomm_get_network_timeout()) {
+		/* The send timeout also bounds connect(). */
+		ret = lttcomm_setsockopt_snd_timeout(rsock->sock.fd,
+				DEFAULT_RELAYD_UPSTREAM_TIMEOUT);
+		if (ret) {
+			goto error_destroy;
+		}
+		ret = lttcomm_setsockopt_rcv_timeout(rsock->sock.fd,
+				DEFAULT_RELAYD_UPSTREAM_TIMEOUT);
+		if (ret) {
+			goto error_destroy;
+		}
+	}
+
+	ret = relayd_connect(rsock);
+	if (ret < 0) {
+		/* The socket is closed on connection errors. */
+		goto error_free;
+	}
+
+	if (uri->stype == LTTNG_STREAM_CONTROL) {
+		ret = relayd_version_check(rsock);
+		if (ret < 0) {
+			ERR("Failed to check the version of the upstream relay daemon");
+			goto error_destroy;
+		}
+		if (rsock->major == 2 && rsock->minor < 11) {
+			ERR("The upstream relay daemon uses protocol %" PRIu32 ".%" PRIu32 ", forwarding requires 2.11 or later",
+					rsock->major, rsock->minor);
+			*incompatible = true;
+			goto error_destroy;
+		}
+	}
+
+	return rsock;
+
+error_destroy:
+	(void) relayd_close(rsock);
+error_free:
+	free(rsock);
+error:
+	return NULL;
+}
+
+static int forward_create_session(struct forward_command *command)
+{
+	int ret;
+	char output_path[LTTNG_PATH_MAX];
+	struct relay_forward_session *fsession = command->fsession;
+
+	ret = relayd_create_session(fsession->control_sock,
+			&fsession->upstream_session_id,
+			fsession->attributes.session_name,
+			fsession->attributes.hostname,
+			fsession->attributes.base_path,
+			fsession->attributes.live_timer,
+			fsession->attributes.snapshot,
+			fsession->attributes.id_sessiond,
+			fsession->attributes.sessiond_uuid,
+			fsession->attributes.current_chunk_id.is_set ?
+					&fsession->attributes.current_chunk_id.value :
+					NULL,
+			fsession->attributes.creation_time,
+			fsession->attributes.session_name_contains_creation_time,
+			output_path);
+	if (ret < 0) {
+		goto end;
+	}
+
+	DBG("Session %" PRIu64 " forwarded as upstream session %" PRIu64 " (upstream output path: %s)",
+			fsession->session_id, fsession->upstream_session_id,
+			output_path);
+end:
+	return ret;
+}
+
+static int forward_add_stream(struct forward_command *command)
+{
+	/* The stream's path already includes its domain. */
+	return relayd_add_stream(command->fsession->control_sock,
+			command->u.add_stream.channel_name, "",
+			command->u.add_stream.path_name,
+			&command->fstream->upstream_id,
+			command->u.add_stream.tracefile_size,
+			command->u.add_stream.tracefile_count,
+			command->chunk);
+}
+
+static int forward_close_stream(struct forward_command *command)
+{
+	int ret;
+
+	ret = relayd_send_close_stream(command->fsession->control_sock,
+			command->fstream->upstream_id,
+			command->u.close_stream.last_net_seq_num);
+	if (ret < 0) {
+		goto end;
+	}
+
+	/*
+	 * The upstream relay daemon closes the stream once it has written
+	 * all of its packets; the peer no longer checks it.
+	 */
+	command->fstream->closed = true;
+end:
+	return ret;
+}
+
+static int forward_metadata(struct forward_command *command)
+{
+	int ret;
+	ssize_t send_ret;
+	struct lttcomm_relayd_sock *sock = command->fsession->control_sock;
+	struct lttcomm_relayd_metadata_payload header = {
+		.stream_id = htobe64(command->fstream->upstream_id),
+		.padding_size = htobe32(command->u.metadata.padding_size),
+	};
+
+	ret = relayd_send_metadata(sock,
+			sizeof(header) + command->payload.size);
+	if (ret < 0) {
+		goto end;
+	}
+
+	send_ret = sock->sock.ops->sendmsg(&sock->sock, &header,
+			sizeof(header), 0);
+	if (send_ret < (ssize_t) sizeof(header)) {
+		ret = -1;
+		goto end;
+	}
+
+	send_ret = sock->sock.ops->sendmsg(&sock->sock, command->payload.data,
+			command->payload.size, 0);
+	if (send_ret < (ssize_t) command->payload.size) {
+		ret = -1;
+		goto end;
+	}
+end:
+	return ret;
+}
+
+static int forward_beacons(struct forward_command *command)
+{
+	int ret = 0;
+	size_t i, count = lttng_dynamic_array_get_count(&command->positions);
+	struct lttcomm_relayd_beacon *beacons = NULL;
+
+	if (!relayd_supports_send_beacons(command->fsession->control_sock)) {
+		goto end;
+	}
+
+	beacons = zmalloc(count * sizeof(*beacons));
+	if (!beacons) {
+		PERROR("zmalloc upstream beacons");
+		ret = -1;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		const struct forward_stream_position *position =
+				lttng_dynamic_array_get_element(
+						&command->positions, i);
+
+		beacons[i] = (struct lttcomm_relayd_beacon) {
+			.relay_stream_id = position->fstream->upstream_id,
+			.net_seq_num = position->net_seq_num,
+			.timestamp_end = position->timestamp_end,
+		};
+	}
+
+	ret = relayd_send_beacons(command->fsession->control_sock, beacons,
+			count);
+end:
+	free(beacons);
+	return ret;
+}
+
+static int forward_rotate_streams(struct forward_command *command)
+{
+	int ret;
+	size_t i, count = lttng_dynamic_array_get_count(&command->positions);
+	struct relayd_stream_rotation_position *positions;
+
+	positions = zmalloc(count * sizeof(*positions));
+	if (!positions) {
+		PERROR("zmalloc upstream stream rotation positions");
+		ret = -1;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		const struct forward_stream_position *position =
+				lttng_dynamic_array_get_element(
+						&command->positions, i);
+
+		positions[i] = (struct relayd_stream_rotation_position) {
+			.stream_id = position->fstream->upstream_id,
+			.rotate_at_seq_num = position->net_seq_num,
+		};
+	}
+
+	ret = relayd_rotate_streams(command->fsession->control_sock, count,
+			command->u.rotate_streams.new_chunk_id.is_set ?
+					&command->u.rotate_streams.new_chunk_id.value :
+					NULL,
+			positions);
+end:
+	free(positions);
+	return ret;
+}
+
+/* Read a packet back from the local trace into the command's payload. */
+static int forward_data_read(struct forward_command *command)
+{
+	int fd, ret = 0;
+	size_t read_size = 0;
+	struct forward_local_file *local_file = command->u.data.local_file;
+
+	if (lttng_dynamic_buffer_set_size(&command->payload,
+			command->u.data.size)) {
+		ret = -1;
+		goto end;
+	}
+
+	fd = fs_handle_get_fd(local_file->handle);
+	if (fd < 0) {
+		ret = -1;
+		goto end;
+	}
+
+	while (read_size < command->u.data.size) {
+		const ssize_t read_ret = pread(fd,
+				command->payload.data + read_size,
+				command->u.data.size - read_size,
+				command->u.data.offset + read_size);
+
+		if (read_ret < 0 && errno == EINTR) {
+			continue;
+		} else if (read_ret <= 0) {
+			/* The file was truncated since. */
+			ERR("Packet %" PRIu64 " of session %" PRIu64 " is no longer available in the local trace",
+					command->u.data.net_seq_num,
+					command->fsession->session_id);
+			ret = -1;
+			break;
+		}
+		read_size += read_ret;
+	}
+	fs_handle_put_fd(local_file->handle);
+end:
+	return ret;
+}
+
+static int forward_data(struct forward_command *command)
+{
+	int ret;
+	ssize_t send_ret;
+	struct relay_forward_session *fsession = command->fsession;
+	struct relay_forward_stream *fstream = command->fstream;
+	struct lttcomm_relayd_data_hdr header = {
+		.stream_id = htobe64(fstream->upstream_id),
+		.net_seq_num = htobe64(command->u.data.net_seq_num),
+		.data_size = htobe32((uint32_t) command->u.data.size),
+		.padding_size = htobe32(command->u.data.padding_size),
+	};
+
+	if (command->u.data.local_file) {
+		ret = forward_data_read(command);
+		if (ret) {
+			goto end;
+		}
+	}
+
+	ret = relayd_send_data_hdr(fsession->data_sock, &header,
+			sizeof(header));
+	if (ret < 0) {
+		goto end;
+	}
+
+	send_ret = fsession->data_sock->sock.ops->sendmsg(
+			&fsession->data_sock->sock, command->payload.data,
+			command->payload.size, 0);
+	if (send_ret < (ssize_t) command->payload.size) {
+		ret = -1;
+		goto end;
+	}
+
+	fstream->sent_net_seq_num = command->u.data.net_seq_num;
+	if (!fstream->unflushed) {
+		ret = lttng_dynamic_pointer_array_add_pointer(
+				&fsession->unflushed_streams, fstream);
+		if (ret) {
+			goto end;
+		}
+		forward_stream_get(fstream);
+		fstream->unflushed = true;
+	}
+end:
+	return ret;
+}
+
+static int forward_command_execute(struct forward_command *command)
+{
+	char path[LTTNG_PATH_MAX];
+	struct lttcomm_relayd_sock *sock = command->fsession->control_sock;
+
+	switch (command->type) {
+	case FORWARD_COMMAND_CREATE_SESSION:
+		return forward_create_session(command);
+	case FORWARD_COMMAND_CREATE_TRACE_CHUNK:
+		return relayd_create_trace_chunk(sock, command->chunk);
+	case FORWARD_COMMAND_CLOSE_TRACE_CHUNK:
+		return relayd_close_trace_chunk(sock, command->chunk, path);
+	case FORWARD_COMMAND_ADD_STREAM:
+		return forward_add_stream(command);
+	case FORWARD_COMMAND_STREAMS_SENT:
+		return relayd_streams_sent(sock);
+	case FORWARD_COMMAND_CLOSE_STREAM:
+		return forward_close_stream(command);
+	case FORWARD_COMMAND_METADATA:
+		return forward_metadata(command);
+	case FORWARD_COMMAND_RESET_METADATA:
+		return relayd_reset_metadata(sock,
+				command->fstream->upstream_id,
+				command->u.reset_metadata.version);
+	case FORWARD_COMMAND_INDEX:
+		return relayd_send_index(sock, &command->u.index.index,
+				command->fstream->upstream_id,
+				command->u.index.net_seq_num);
+	case FORWARD_COMMAND_BEACONS:
+		return forward_beacons(command);
+	case FORWARD_COMMAND_ROTATE_STREAMS:
+		return forward_rotate_streams(command);
+	case FORWARD_COMMAND_DATA:
+		return forward_data(command);
+	default:
+		abort();
+	}
+}
+
+/*
+ * Ask the upstream relay daemon whether it has written the packets sent
+ * since the last check. Returns the number of streams with packets still
+ * not written upstream, or a negative value on error.
+ */
+static int forward_session_check_flushed(
+		struct relay_forward_session *fsession)
+{
+	size_t i = 0;
+
+	while (i < lttng_dynamic_pointer_array_get_count(
+			&fsession->unflushed_streams)) {
+		int ret = 0;
+		struct relay_forward_stream *fstream =
+				lttng_dynamic_pointer_array_get_pointer(
+						&fsession->unflushed_streams, i);
+
+		health_code_update();
+		if (!fstream->closed) {
+			ret = relayd_data_pending(fsession->control_sock,
+					fstream->upstream_id,
+					fstream->sent_net_seq_num);
+			if (ret < 0) {
+				return ret;
+			}
+		}
+		if (ret) {
+			i++;
+			continue;
+		}
+
+		pthread_mutex_lock(&fsession->lock);
+		fstream->flushed_net_seq_num = fstream->sent_net_seq_num;
+		pthread_mutex_unlock(&fsession->lock);
+		fstream->unflushed = false;
+		(void) lttng_dynamic_pointer_array_remove_pointer(
+				&fsession->unflushed_streams, i);
+	}
+
+	return (int) lttng_dynamic_pointer_array_get_count(
+			&fsession->unflushed_streams);
+}
+
+/*
+ * Wait, with the session lock held, for a delay or until the thread must
+ * exit. The wait also ends when a command is queued if `wake_on_command`
+ * is set. Returns true if the thread must exit.
+ */
+static bool forward_session_wait(struct relay_forward_session *fsession,
+		unsigned int delay_ms, bool wake_on_command)
+{
+	int ret;
+	struct timespec deadline;
+
+	/* pthread_cond_timedwait() measures time on the realtime clock. */
+	ret = lttng_clock_gettime(CLOCK_REALTIME, &deadline);
+	if (ret) {
+		PERROR("clock_gettime");
+		abort();
+	}
+	deadline.tv_sec += delay_ms / MSEC_PER_SEC;
+	deadline.tv_nsec += (delay_ms % MSEC_PER_SEC) * NSEC_PER_MSEC;
+	if (deadline.tv_nsec >= NSEC_PER_SEC) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= NSEC_PER_SEC;
+	}
+
+	health_poll_entry();
+	while (!fsession->quit) {
+		if (wake_on_command && (!cds_list_empty(&fsession->commands) ||
+				fsession->closed)) {
+			break;
+		}
+		ret = pthread_cond_timedwait(&fsession->cond, &fsession->lock,
+				&deadline);
+		if (ret == ETIMEDOUT) {
+			break;
+		}
+	}
+	health_poll_exit();
+	return fsession->quit;
+}
+
+/*
+ * Establish the upstream control and data connections of a session,
+ * retrying with an exponential backoff. Must be called with the session
+ * lock held. Returns -1 if the thread must exit or if the upstream relay
+ * daemon can't forward the session.
+ */
+static int forward_session_connect(struct relay_forward_session *fsession)
+{
+	bool incompatible = false, warned = false;
+	unsigned int delay_ms = DEFAULT_RELAYD_UPSTREAM_RECONNECT_DELAY_MIN;
+
+	for (;;) {
+		health_code_update();
+		pthread_mutex_unlock(&fsession->lock);
+		fsession->control_sock = forward_connect(&forward.control_uri,
+				&incompatible);
+		if (fsession->control_sock) {
+			fsession->data_sock = forward_connect(
+					&forward.data_uri, &incompatible);
+			if (!fsession->data_sock) {
+				(void) relayd_close(fsession->control_sock);
+				free(fsession->control_sock);
+				fsession->control_sock = NULL;
+			}
+		}
+		pthread_mutex_lock(&fsession->lock);
+
+		if (fsession->data_sock) {
+			DBG("Upstream connections of session %" PRIu64 " established",
+					fsession->session_id);
+			return 0;
+		}
+		if (incompatible) {
+			forward_session_abandon_locked(fsession,
+					"create session");
+			return -1;
+		}
+
+		if (!warned) {
+			WARN("Unable to reach the upstream relay daemon, session %" PRIu64 " will be forwarded once it is reachable",
+					fsession->session_id);
+			warned = true;
+		}
+		DBG("Retrying to connect session %" PRIu64 " to the upstream relay daemon in %u ms",
+				fsession->session_id, delay_ms);
+		if (forward_session_wait(fsession, delay_ms, false)) {
+			return -1;
+		}
+		delay_ms = min(delay_ms * 2,
+				DEFAULT_RELAYD_UPSTREAM_RECONNECT_DELAY_MAX);
+	}
+}
+
+/*
+ * Replay the commands and packets of a session upstream, in the order in
+ * which they were received. Once the queue is drained, the packets sent are
+ * checked until the upstream relay daemon has written them. The thread
+ * exits once the session is destroyed locally and its queue is drained,
+ * when forwarding is abandoned or when the relay daemon exits.
+ */
+static void *forward_session_thread(void *data)
+{
+	struct relay_forward_session *fsession = data;
+	struct forward_command *command, *tmp;
+	unsigned int dropped_count = 0;
+	CDS_LIST_HEAD(dropped);
+
+	health_register(health_relayd, HEALTH_RELAYD_TYPE_FORWARD);
+
+	DBG("Upstream thread of session %" PRIu64 " started",
+			fsession->session_id);
+
+	pthread_mutex_lock(&fsession->lock);
+	for (;;) {
+		int ret;
+
+		health_code_update();
+
+		if (fsession->quit || fsession->state ==
+				FORWARD_SESSION_STATE_ABANDONED) {
+			break;
+		}
+
+		if (cds_list_empty(&fsession->commands)) {
+			if (fsession->closed) {
+				break;
+			}
+			if (!lttng_dynamic_pointer_array_get_count(
+					&fsession->unflushed_streams)) {
+				health_poll_entry();
+				pthread_cond_wait(&fsession->cond,
+						&fsession->lock);
+				health_poll_exit();
+				continue;
+			}
+
+			pthread_mutex_unlock(&fsession->lock);
+			ret = forward_session_check_flushed(fsession);
+			pthread_mutex_lock(&fsession->lock);
+			if (ret < 0) {
+				forward_session_abandon_locked(fsession,
+						"data pending");
+			} else if (ret > 0) {
+				(void) forward_session_wait(fsession,
+						DEFAULT_RELAYD_UPSTREAM_FLUSH_CHECK_DELAY,
+						true);
+			}
+			continue;
+		}
+
+		if (fsession->state == FORWARD_SESSION_STATE_CONNECTING) {
+			if (forward_session_connect(fsession)) {
+				break;
+			}
+			uatomic_set(&fsession->state,
+					FORWARD_SESSION_STATE_ACTIVE);
+			continue;
+		}
+
+		command = cds_list_first_entry(&fsession->commands,
+				struct forward_command, node);
+		cds_list_del(&command->node);
+		pthread_mutex_unlock(&fsession->lock);
+
+		ret = forward_command_execute(command);
+		health_code_update();
+
+		pthread_mutex_lock(&fsession->lock);
+		fsession->queued_size -= command->size;
+		if (ret < 0) {
+			forward_session_abandon_locked(fsession,
+					forward_command_str(command->type));
+		}
+		pthread_mutex_unlock(&fsession->lock);
+
+		forward_command_destroy(command);
+		pthread_mutex_lock(&fsession->lock);
+	}
+
+	/* The remaining commands are never forwarded. */
+	cds_list_for_each_entry_safe(command, tmp, &fsession->commands, node) {
+		cds_list_move(&command->node, &dropped);
+		dropped_count++;
+	}
+	fsession->queued_size = 0;
+	if (fsession->state != FORWARD_SESSION_STATE_ABANDONED &&
+			dropped_count) {
+		WARN("%u commands of session %" PRIu64 " were not forwarded to the upstream relay daemon",
+				dropped_count, fsession->session_id);
+	}
+	uatomic_set(&fsession->state, FORWARD_SESSION_STATE_ABANDONED);
+	fsession->exited = true;
+	pthread_mutex_unlock(&fsession->lock);
+
+	cds_list_for_each_entry_safe(command, tmp, &dropped, node) {
+		cds_list_del(&command->node);
+		forward_command_destroy(command);
+	}
+	lttng_dynamic_pointer_array_clear(&fsession->unflushed_streams);
+
+	if (fsession->control_sock) {
+		DBG("Closing upstream connections of session %" PRIu64,
+				fsession->session_id);
+		(void) relayd_close(fsession->control_sock);
+		free(fsession->control_sock);
+		fsession->control_sock = NULL;
+	}
+	if (fsession->data_sock) {
+		(void) relayd_close(fsession->data_sock);
+		free(fsession->data_sock);
+		fsession->data_sock = NULL;
+	}
+
+	DBG("Upstream thread of session %" PRIu64 " exiting",
+			fsession->session_id);
+	health_unregister(health_relayd);
+	return NULL;
+}
+
+/*
+ * Join the threads of the forwarded sessions which have exited, or of all
+ * the forwarded sessions if `all` is set, and release their references.
+ */
+static void forward_reap_sessions(bool all)
+{
+	struct relay_forward_session *fsession, *tmp;
+	CDS_LIST_HEAD(reaped);
+
+	pthread_mutex_lock(&forward.lock);
+	cds_list_for_each_entry_safe(fsession, tmp, &forward.sessions, node) {
+		bool exited;
+
+		pthread_mutex_lock(&fsession->lock);
+		exited = fsession->exited;
+		pthread_mutex_unlock(&fsession->lock);
+		if (exited || all) {
+			cds_list_move(&fsession->node, &reaped);
+		}
+	}
+	pthread_mutex_unlock(&forward.lock);
+
+	cds_list_for_each_entry_safe(fsession, tmp, &reaped, node) {
+		int ret;
+
+		ret = pthread_join(fsession->thread, NULL);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join upstream session");
+		}
+		cds_list_del(&fsession->node);
+		forward_session_put(fsession);
+	}
+}
+
+int relay_forward_create(struct lttng_uri *uris)
+{
+	if (!uris) {
+		goto end;
+	}
+
+	forward.control_uri = uris[0];
+	forward.data_uri = uris[1];
+	forward.enabled = true;
+	DBG("Forwarding sessions upstream");
+end:
+	return 0;
+}
+
+void relay_forward_destroy(void)
+{
+	struct relay_forward_session *fsession;
+
+	if (!forward.enabled) {
+		return;
+	}
+
+	pthread_mutex_lock(&forward.lock);
+	forward.enabled = false;
+	cds_list_for_each_entry(fsession, &forward.sessions, node) {
+		pthread_mutex_lock(&fsession->lock);
+		fsession->quit = true;
+		pthread_cond_broadcast(&fsession->cond);
+		pthread_mutex_unlock(&fsession->lock);
+	}
+	pthread_mutex_unlock(&forward.lock);
+
+	forward_reap_sessions(true);
+}
+
+void relay_forward_session_close(struct relay_forward_session *fsession)
+{
+	if (!fsession) {
+		return;
+	}
+
+	/* The thread forwards the commands still queued, then exits. */
+	pthread_mutex_lock(&fsession->lock);
+	fsession->closed = true;
+	pthread_cond_broadcast(&fsession->cond);
+	pthread_mutex_unlock(&fsession->lock);
+	forward_session_put(fsession);
+}
+
+/* Copy the attributes of a session, to create it upstream. */
+static int forward_session_set_attributes(
+		struct relay_forward_session *fsession,
+		const struct relay_session *session)
+{
+	int ret = -1;
+
+	if (lttng_strncpy(fsession->attributes.session_name,
+			session->session_name,
+			sizeof(fsession->attributes.session_name)) ||
+			lttng_strncpy(fsession->attributes.hostname,
+					session->hostname,
+					sizeof(fsession->attributes.hostname)) ||
+			lttng_strncpy(fsession->attributes.base_path,
+					session->base_path,
+					sizeof(fsession->attributes.base_path))) {
+		goto end;
+	}
+	fsession->attributes.live_timer = session->live_timer;
+	fsession->attributes.snapshot = session->snapshot;
+	fsession->attributes.id_sessiond = session->id_sessiond.value;
+	lttng_uuid_copy(fsession->attributes.sessiond_uuid,
+			session->sessiond_uuid);
+	fsession->attributes.creation_time = session->creation_time.value;
+	fsession->attributes.session_name_contains_creation_time =
+			session->session_name_contains_creation_time;
+
+	if (session->current_trace_chunk) {
+		uint64_t current_chunk_id;
+		enum lttng_trace_chunk_status chunk_status;
+
+		chunk_status = lttng_trace_chunk_get_id(
+				session->current_trace_chunk,
+				&current_chunk_id);
+		if (chunk_status == LTTNG_TRACE_CHUNK_STATUS_OK) {
+			LTTNG_OPTIONAL_SET(
+					&fsession->attributes.current_chunk_id,
+					current_chunk_id);
+		}
+	}
+	ret = 0;
+end:
+	return ret;
+}
+
+void relay_forward_session_create(struct relay_session *session)
+{
+	int ret;
+	struct relay_forward_session *fsession;
+	struct forward_command *command;
+
+	if (!forward.enabled) {
+		return;
+	}
+
+	/* Release the sessions whose forwarding has completed. */
+	forward_reap_sessions(false);
+
+	if (!session->id_sessiond.is_set) {
+		WARN("Session %" PRIu64 " is not forwarded upstream as its peer uses protocol %" PRIu32 ".%" PRIu32 " (2.11 or later required)",
+				session->id, session->major, session->minor);
+		return;
+	}
+
+	fsession = zmalloc(sizeof(*fsession));
+	if (!fsession) {
+		PERROR("zmalloc upstream session");
+		goto error;
+	}
+	urcu_ref_init(&fsession->ref);
+	fsession->session_id = session->id;
+	lttng_dynamic_pointer_array_init(&fsession->unflushed_streams,
+			forward_stream_put_pointer);
+	pthread_mutex_init(&fsession->lock, NULL);
+	pthread_cond_init(&fsession->cond, NULL);
+	CDS_INIT_LIST_HEAD(&fsession->commands);
+	CDS_INIT_LIST_HEAD(&fsession->node);
+	fsession->state = FORWARD_SESSION_STATE_CONNECTING;
+
+	if (forward_session_set_attributes(fsession, session)) {
+		goto error_put;
+	}
+	command = forward_command_create(FORWARD_COMMAND_CREATE_SESSION,
+			fsession, NULL);
+	if (!command) {
+		goto error_put;
+	}
+
+	/* The thread uses the reference of the forwarded session list. */
+	forward_session_get(fsession);
+	ret = pthread_create(&fsession->thread, default_pthread_attr(),
+			forward_session_thread, fsession);
+	if (ret) {
+		errno = ret;
+		PERROR("pthread_create upstream session");
+		forward_command_destroy(command);
+		forward_session_put(fsession);
+		goto error_put;
+	}
+	pthread_mutex_lock(&forward.lock);
+	cds_list_add_tail(&fsession->node, &forward.sessions);
+	pthread_mutex_unlock(&forward.lock);
+
+	/* The session is created upstream before anything else. */
+	forward_command_enqueue(command);
+
+	/* The session's reference is released with the session. */
+	session->forward = fsession;
+	return;
+
+error_put:
+	forward_session_put(fsession);
+error:
+	ERR("Session %" PRIu64 " is only kept locally", session->id);
+}
+
+static void forward_trace_chunk_command(enum forward_command_type type,
+		struct relay_session *session, struct lttng_trace_chunk *chunk)
+{
+	struct forward_command *command;
+	struct relay_forward_session *fsession = session_forward(session);
+
+	if (!fsession) {
+		return;
+	}
+
+	command = forward_command_create(type, fsession, NULL);
+	if (!command) {
+		return;
+	}
+
+	if (!lttng_trace_chunk_get(chunk)) {
+		forward_session_abandon(fsession, forward_command_str(type));
+		forward_command_destroy(command);
+		return;
+	}
+	command->chunk = chunk;
+	forward_command_enqueue(command);
+}
+
+void relay_forward_trace_chunk_create(struct relay_session *session,
+		struct lttng_trace_chunk *chunk)
+{
+	forward_trace_chunk_command(FORWARD_COMMAND_CREATE_TRACE_CHUNK,
+			session, chunk);
+}
+
+void relay_forward_trace_chunk_close(struct relay_session *session,
+		struct lttng_trace_chunk *chunk)
+{
+	forward_trace_chunk_command(FORWARD_COMMAND_CLOSE_TRACE_CHUNK,
+			session, chunk);
+}
+
+void relay_forward_stream_add(struct relay_stream *stream)
+{
+	struct relay_forward_stream *fstream;
+	struct forward_command *command;
+	struct relay_forward_session *fsession =
+			session_forward(stream->trace->session);
+
+	if (!fsession) {
+		return;
+	}
+
+	if (!stream->trace_chunk) {
+		forward_session_abandon(fsession, "add stream");
+		return;
+	}
+
+	fstream = zmalloc(sizeof(*fstream));
+	if (!fstream) {
+		PERROR("zmalloc upstream stream");
+		forward_session_abandon(fsession, "add stream");
+		return;
+	}
+	urcu_ref_init(&fstream->ref);
+	forward_session_get(fsession);
+	fstream->fsession = fsession;
+	fstream->upstream_id = -1ULL;
+	fstream->sent_net_seq_num = -1ULL;
+	fstream->queued_net_seq_num = -1ULL;
+	fstream->flushed_net_seq_num = -1ULL;
+
+	/* The stream's reference is released with the stream. */
+	pthread_mutex_lock(&stream->lock);
+	stream->forward = fstream;
+	pthread_mutex_unlock(&stream->lock);
+
+	command = forward_command_create(FORWARD_COMMAND_ADD_STREAM, fsession,
+			fstream);
+	if (!command) {
+		return;
+	}
+
+	command->u.add_stream.channel_name = strdup(stream->channel_name);
+	command->u.add_stream.path_name = strdup(stream->path_name);
+	if (!command->u.add_stream.channel_name ||
+			!command->u.add_stream.path_name ||
+			!lttng_trace_chunk_get(stream->trace_chunk)) {
+		forward_session_abandon(fsession, "add stream");
+		forward_command_destroy(command);
+		return;
+	}
+	command->chunk = stream->trace_chunk;
+	command->u.add_stream.tracefile_size = stream->tracefile_size;
+	command->u.add_stream.tracefile_count = stream->tracefile_count;
+	forward_command_enqueue(command);
+}
+
+void relay_forward_streams_sent(struct relay_session *session)
+{
+	struct relay_forward_session *fsession = session_forward(session);
+
+	if (!fsession) {
+		return;
+	}
+
+	forward_command_enqueue(forward_command_create(
+			FORWARD_COMMAND_STREAMS_SENT, fsession, NULL));
+}
+
+void relay_forward_stream_close(struct relay_stream *stream,
+		uint64_t last_net_seq_num)
+{
+	struct forward_command *command;
+	struct relay_forward_stream *fstream = stream_forward(stream);
+
+	if (!fstream) {
+		return;
+	}
+
+	command = forward_command_create(FORWARD_COMMAND_CLOSE_STREAM,
+			fstream->fsession, fstream);
+	if (!command) {
+		return;
+	}
+	command->u.close_stream.last_net_seq_num = last_net_seq_num;
+	forward_command_enqueue(command);
+}
+
+void relay_forward_metadata(struct relay_stream *stream,
+		const struct lttng_buffer_view *packet, uint32_t padding_size)
+{
+	struct forward_command *command;
+	struct relay_forward_stream *fstream = stream_forward(stream);
+
+	if (!fstream) {
+		return;
+	}
+
+	command = forward_command_create(FORWARD_COMMAND_METADATA,
+			fstream->fsession, fstream);
+	if (!command) {
+		return;
+	}
+
+	if (lttng_dynamic_buffer_append(&command->payload, packet->data,
+			packet->size)) {
+		forward_session_abandon(fstream->fsession, "metadata");
+		forward_command_destroy(command);
+		return;
+	}
+	command->u.metadata.padding_size = padding_size;
+	forward_command_enqueue(command);
+}
+
+void relay_forward_metadata_reset(struct relay_stream *stream,
+		uint64_t version)
+{
+	struct forward_command *command;
+	struct relay_forward_stream *fstream = stream_forward(stream);
+
+	if (!fstream) {
+		return;
+	}
+
+	command = forward_command_create(FORWARD_COMMAND_RESET_METADATA,
+			fstream->fsession, fstream);
+	if (!command) {
+		return;
+	}
+	command->u.reset_metadata.version = version;
+	forward_command_enqueue(command);
+}
+
+void relay_forward_index(struct relay_stream *stream,
+		const struct lttcomm_relayd_index *index)
+{
+	struct forward_command *command;
+	struct relay_forward_stream *fstream = stream_forward(stream);
+
+	if (!fstream) {
+		return;
+	}
+
+	command = forward_command_create(FORWARD_COMMAND_INDEX,
+			fstream->fsession, fstream);
+	if (!command) {
+		return;
+	}
+	command->u.index.index = (struct ctf_packet_index) {
+		.packet_size = htobe64(index->packet_size),
+		.content_size = htobe64(index->content_size),
+		.timestamp_begin = htobe64(index->timestamp_begin),
+		.timestamp_end = htobe64(index->timestamp_end),
+		.events_discarded = htobe64(index->events_discarded),
+		.stream_id = htobe64(index->stream_id),
+		.stream_instance_id = htobe64(index->stream_instance_id),
+		.packet_seq_num = htobe64(index->packet_seq_num),
+	};
+	command->u.index.net_seq_num = index->net_seq_num;
+	forward_command_enqueue(command);
+}
+
+/*
+ * Append the position of a stream, referenced by its id on this relay
+ * daemon, to an array of struct forward_stream_position. Returns 1 if the
+ * stream is not forwarded.
+ */
+static int forward_stream_position_add(struct lttng_dynamic_array *positions,
+		uint64_t stream_id, uint64_t net_seq_num,
+		uint64_t timestamp_end)
+{
+	int ret;
+	struct forward_stream_position position = {
+		.fstream = stream_id_to_forward(stream_id),
+		.net_seq_num = net_seq_num,
+		.timestamp_end = timestamp_end,
+	};
+
+	if (!position.fstream) {
+		return 1;
+	}
+
+	ret = lttng_dynamic_array_add_element(positions, &position);
+	if (ret) {
+		relay_forward_stream_put(position.fstream);
+	}
+	return ret;
+}
+
+void relay_forward_beacons(struct relay_session *session,
+		const struct lttng_buffer_view *beacons, uint32_t beacon_count)
+{
+	uint32_t i;
+	struct forward_command *command;
+	struct relay_forward_session *fsession = session_forward(session);
+
+	if (!fsession) {
+		return;
+	}
+
+	command = forward_command_create(FORWARD_COMMAND_BEACONS, fsession,
+			NULL);
+	if (!command) {
+		return;
+	}
+
+	for (i = 0; i < beacon_count; i++) {
+		int ret;
+		struct lttcomm_relayd_beacon beacon;
+
+		memcpy(&beacon, beacons->data + i * sizeof(beacon),
+				sizeof(beacon));
+		ret = forward_stream_position_add(&command->positions,
+				be64toh(beacon.relay_stream_id),
+				be64toh(beacon.net_seq_num),
+				be64toh(beacon.timestamp_end));
+		if (ret < 0) {
+			forward_session_abandon(fsession, "beacons");
+			forward_command_destroy(command);
+			return;
+		}
+	}
+
+	forward_command_enqueue(command);
+}
+
+void relay_forward_rotate_streams(struct relay_session *session,
+		const uint64_t *new_chunk_id,
+		const struct lttng_buffer_view *positions,
+		uint32_t stream_count)
+{
+	uint32_t i;
+	struct forward_command *command;
+	struct relay_forward_session *fsession = session_forward(session);
+
+	if (!fsession) {
+		return;
+	}
+
+	command = forward_command_create(FORWARD_COMMAND_ROTATE_STREAMS,
+			fsession, NULL);
+	if (!command) {
+		return;
+	}
+
+	for (i = 0; i < stream_count; i++) {
+		struct lttcomm_relayd_stream_rotation_position position;
+
+		memcpy(&position, positions->data + i * sizeof(position),
+				sizeof(position));
+		/* Every rotated stream must be known upstream. */
+		if (forward_stream_position_add(&command->positions,
+				be64toh(position.stream_id),
+				be64toh(position.rotate_at_seq_num), 0)) {
+			forward_session_abandon(fsession, "rotate streams");
+			forward_command_destroy(command);
+			return;
+		}
+	}
+
+	if (new_chunk_id) {
+		LTTNG_OPTIONAL_SET(&command->u.rotate_streams.new_chunk_id,
+				*new_chunk_id);
+	}
+	forward_command_enqueue(command);
+}
+
+bool relay_forward_stream_data_pending(struct relay_stream *stream,
+		uint64_t last_net_seq_num)
+{
+	bool pending = false;
+	uint64_t target_net_seq_num = last_net_seq_num;
+	struct relay_forward_stream *fstream = stream_forward(stream);
+	struct relay_forward_session *fsession;
+
+	if (!fstream) {
+		goto end;
+	}
+	fsession = fstream->fsession;
+
+	pthread_mutex_lock(&fsession->lock);
+	/* An unreachable upstream relay daemon doesn't hold back the peer. */
+	if (fsession->state != FORWARD_SESSION_STATE_ACTIVE ||
+			fstream->queued_net_seq_num == -1ULL) {
+		goto end_unlock;
+	}
+	if (((int64_t) (fstream->queued_net_seq_num -
+			target_net_seq_num)) < 0) {
+		target_net_seq_num = fstream->queued_net_seq_num;
+	}
+	pending = fstream->flushed_net_seq_num == -1ULL ||
+			((int64_t) (fstream->flushed_net_seq_num -
+					target_net_seq_num)) < 0;
+end_unlock:
+	pthread_mutex_unlock(&fsession->lock);
+end:
+	return pending;
+}
+
+bool relay_forward_end_data_pending(struct relay_session *session)
+{
+	bool pending;
+	struct relay_forward_session *fsession = session_forward(session);
+
+	if (!fsession) {
+		return false;
+	}
+
+	pthread_mutex_lock(&fsession->lock);
+	pending = fsession->state == FORWARD_SESSION_STATE_ACTIVE &&
+			fsession->queued_size;
+	pthread_mutex_unlock(&fsession->lock);
+	return pending;
+}
+
+/*
+ * Get the local file of the packet being received on a stream, opening it
+ * when the stream moved to a new file.
+ */
+static int forward_stream_get_local_file(struct relay_stream *stream,
+		struct relay_forward_stream *fstream)
+{
+	int ret;
+	char path[LTTNG_PATH_MAX];
+	enum lttng_trace_chunk_status status;
+	struct forward_local_file *local_file = fstream->local_file;
+
+	if (local_file && local_file->chunk == stream->trace_chunk &&
+			local_file->tracefile_index ==
+					stream->tracefile_current_index) {
+		return 0;
+	}
+
+	ret = utils_stream_file_path(stream->path_name, stream->channel_name,
+			stream->tracefile_size, stream->tracefile_current_index,
+			NULL, path, sizeof(path));
+	if (ret < 0) {
+		goto end;
+	}
+
+	local_file = zmalloc(sizeof(*local_file));
+	if (!local_file) {
+		PERROR("zmalloc upstream local file");
+		ret = -1;
+		goto end;
+	}
+	urcu_ref_init(&local_file->ref);
+	local_file->tracefile_index = stream->tracefile_current_index;
+
+	status = lttng_trace_chunk_open_fs_handle(stream->trace_chunk, path,
+			O_RDONLY, 0, &local_file->handle, false);
+	if (status != LTTNG_TRACE_CHUNK_STATUS_OK ||
+			!lttng_trace_chunk_get(stream->trace_chunk)) {
+		if (status == LTTNG_TRACE_CHUNK_STATUS_OK) {
+			(void) fs_handle_close(local_file->handle);
+		}
+		free(local_file);
+		ret = -1;
+		goto end;
+	}
+	local_file->chunk = stream->trace_chunk;
+
+	forward_local_file_put(fstream->local_file);
+	fstream->local_file = local_file;
+	ret = 0;
+end:
+	return ret;
+}
+
+/*
+ * Start accumulating a packet. Once the session's queue holds more than
+ * DEFAULT_RELAYD_UPSTREAM_QUEUE_SIZE bytes, the packet is read back from
+ * the local trace, where it is being written, when it is sent upstream.
+ */
+static void forward_packet_start(struct relay_stream *stream,
+		struct relay_forward_stream *fstream)
+{
+	bool local;
+
+	fstream->packet_started = true;
+	fstream->packet_local = false;
+	fstream->packet_size = 0;
+
+	pthread_mutex_lock(&fstream->fsession->lock);
+	local = fstream->fsession->queued_size >=
+			DEFAULT_RELAYD_UPSTREAM_QUEUE_SIZE;
+	pthread_mutex_unlock(&fstream->fsession->lock);
+
+	/*
+	 * The files of a tracefile ring are overwritten: their packets are
+	 * always kept in memory.
+	 */
+	if (!local || stream->tracefile_count ||
+			forward_stream_get_local_file(stream, fstream)) {
+		return;
+	}
+
+	fstream->packet_local = true;
+	fstream->packet_offset = stream->tracefile_size_current;
+}
+
+void relay_forward_packet_append(struct relay_stream *stream,
+		const struct lttng_buffer_view *data)
+{
+	struct relay_forward_stream *fstream = stream_forward(stream);
+
+	if (!fstream) {
+		return;
+	}
+
+	if (!fstream->packet_started) {
+		forward_packet_start(stream, fstream);
+	}
+	fstream->packet_size += data->size;
+	if (fstream->packet_local) {
+		return;
+	}
+
+	if (lttng_dynamic_buffer_append(&stream->forward_packet, data->data,
+			data->size)) {
+		forward_session_abandon(fstream->fsession, "data packet");
+	}
+}
+
+struct forward_command *relay_forward_packet_complete(
+		struct relay_stream *stream, uint64_t net_seq_num,
+		uint32_t padding_size)
+{
+	struct forward_command *packet = NULL;
+	struct relay_forward_stream *fstream = stream_forward(stream);
+
+	if (!fstream) {
+		goto end;
+	}
+
+	packet = forward_command_create(FORWARD_COMMAND_DATA,
+			fstream->fsession, fstream);
+	if (!packet) {
+		goto end;
+	}
+
+	packet->u.data.net_seq_num = net_seq_num;
+	packet->u.data.size = fstream->packet_size;
+	packet->u.data.padding_size = padding_size;
+	if (fstream->packet_local) {
+		forward_local_file_get(fstream->local_file);
+		packet->u.data.local_file = fstream->local_file;
+		packet->u.data.offset = fstream->packet_offset;
+	} else {
+		/* The accumulated data is handed over to the packet. */
+		packet->payload = stream->forward_packet;
+		lttng_dynamic_buffer_init(&stream->forward_packet);
+	}
+end:
+	if (fstream) {
+		fstream->packet_started = false;
+	}
+	lttng_dynamic_buffer_set_size(&stream->forward_packet, 0);
+	return packet;
+}
+
+void relay_forward_packet_enqueue(struct forward_command *packet)
+{
+	forward_command_enqueue(packet);
+}
@@ -0,0 +1,115 @@
+#ifndef LTTNG_RELAYD_FORWARD_H
+#define LTTNG_RELAYD_FORWARD_H
+
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include <common/buffer-view.h>
+#include <common/trace-chunk.h>
+#include <common/uri.h>
+
+struct relay_session;
+struct relay_stream;
+struct relay_forward_session;
+struct relay_forward_stream;
+struct forward_command;
+struct lttcomm_relayd_index;
+
+/*
+ * Forwarding of the sessions received by the relay daemon to an upstream
+ * relay daemon (see --upstream-url).
+ *
+ * The relay daemon keeps producing its local copy of every session; the
+ * commands and packets it receives from peers >= 2.11 are also replayed,
+ * as a consumer daemon would, on the upstream relay daemon.
+ *
+ * Sessions are forwarded independently of each other: each one has its own
+ * queue, its own thread and its own upstream control and data connections,
+ * so that a slow upstream session never holds back the others. The hooks
+ * below never perform upstream I/O; they only queue the commands and
+ * packets of the session, in the order in which they were received.
+ *
+ * The upstream connections of a session are established, with an
+ * exponential backoff, while the upstream relay daemon is unreachable: the
+ * session is forwarded once it is reached, even if the session was
+ * destroyed in the meantime. Past a per-session amount of queued data, the
+ * packets are no longer kept in memory but read back from the local trace
+ * when they are sent upstream.
+ *
+ * A session is only abandoned (kept locally from that point on) when its
+ * upstream counterpart can't be kept consistent: an upstream error once the
+ * session exists upstream, a packet no longer available locally, or a
+ * backlog exceeding DEFAULT_RELAYD_UPSTREAM_QUEUE_MAX_SIZE.
+ */
+
+/*
+ * Enable forwarding to the upstream relay daemon whose control and data
+ * URIs are held by `uris`; forwarding is disabled when it is NULL.
+ */
+int relay_forward_create(struct lttng_uri *uris);
+/*
+ * Stop the threads of the forwarded sessions. The commands and packets
+ * still queued are not forwarded.
+ */
+void relay_forward_destroy(void);
+
+/* Release the forwarding state of a session destroyed locally. */
+void relay_forward_session_close(struct relay_forward_session *fsession);
+void relay_forward_stream_put(struct relay_forward_stream *fstream);
+
+/* Hooks called once a command has been handled locally. */
+void relay_forward_session_create(struct relay_session *session);
+void relay_forward_trace_chunk_create(struct relay_session *session,
+		struct lttng_trace_chunk *chunk);
+void relay_forward_trace_chunk_close(struct relay_session *session,
+		struct lttng_trace_chunk *chunk);
+void relay_forward_stream_add(struct relay_stream *stream);
+void relay_forward_streams_sent(struct relay_session *session);
+void relay_forward_stream_close(struct relay_stream *stream,
+		uint64_t last_net_seq_num);
+void relay_forward_metadata(struct relay_stream *stream,
+		const struct lttng_buffer_view *packet, uint32_t padding_size);
+void relay_forward_metadata_reset(struct relay_stream *stream,
+		uint64_t version);
+void relay_forward_index(struct relay_stream *stream,
+		const struct lttcomm_relayd_index *index);
+void relay_forward_beacons(struct relay_session *session,
+		const struct lttng_buffer_view *beacons, uint32_t beacon_count);
+void relay_forward_rotate_streams(struct relay_session *session,
+		const uint64_t *new_chunk_id,
+		const struct lttng_buffer_view *positions,
+		uint32_t stream_count);
+
+/*
+ * Data pending checks. While a session is forwarded, a stream is only
+ * reported as flushed once the upstream relay daemon has written its
+ * packets, which the session's thread checks as soon as its queue is
+ * drained, and a session while it still has queued commands. A session
+ * whose upstream relay daemon is unreachable is reported as flushed: its
+ * data is kept locally until it can be forwarded.
+ */
+bool relay_forward_stream_data_pending(struct relay_stream *stream,
+		uint64_t last_net_seq_num);
+bool relay_forward_end_data_pending(struct relay_session *session);
+
+/*
+ * Data path. The contents of a packet are accumulated, under the stream
+ * lock, as they are received, unless the packet is to be read back from the
+ * local trace. The completed packet is then queued without holding any
+ * lock.
+ */
+void relay_forward_packet_append(struct relay_stream *stream,
+		const struct lttng_buffer_view *data);
+struct forward_command *relay_forward_packet_complete(
+		struct relay_stream *stream, uint64_t net_seq_num,
+		uint32_t padding_size);
+void relay_forward_packet_enqueue(struct forward_command *packet);
+
+#endif /* LTTNG_RELAYD_FORWARD_H */
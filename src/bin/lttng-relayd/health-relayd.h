@@ -21,6 +21,7 @@ enum health_type_relayd {
 	HEALTH_RELAYD_TYPE_LIVE_DISPATCHER	= 3,
 	HEALTH_RELAYD_TYPE_LIVE_WORKER		= 4,
 	HEALTH_RELAYD_TYPE_LIVE_LISTENER	= 5,
+	HEALTH_RELAYD_TYPE_FORWARD		= 6,
 
 	NR_HEALTH_RELAYD_TYPES,
 };
@@ -351,6 +351,12 @@ static int make_viewer_streams(struct relay_session *relay_session,
 			if (!relay_stream->published) {
 				goto next;
 			}
+			if (!live_stream_filter_match(
+					relay_session->viewer_stream_filter,
+					relay_stream->channel_name,
+					relay_stream->is_metadata)) {
+				goto next;
+			}
 			viewer_stream = viewer_stream_get_by_id(
 					relay_stream->stream_handle);
 			if (!viewer_stream) {
@@ -1210,34 +1216,22 @@ error_unlock_session:
 }
 
 /*
- * Send the viewer the list of current sessions.
+ * Attach the viewer to a session and send it the list of streams made
+ * available by the stream filter, if any. The ownership of the filter is
+ * taken by this function.
  */
 static
-int viewer_attach_session(struct relay_connection *conn)
+int attach_session(struct relay_connection *conn, uint64_t session_id,
+		uint32_t seek, struct live_stream_filter *filter)
 {
 	int send_streams = 0;
 	ssize_t ret;
 	uint32_t nb_streams = 0;
 	enum lttng_viewer_seek seek_type;
-	struct lttng_viewer_attach_session_request request;
 	struct lttng_viewer_attach_session_response response;
 	struct relay_session *session = NULL;
 	enum lttng_viewer_attach_return_code viewer_attach_status;
 	bool closed = false;
-	uint64_t session_id;
-
-	assert(conn);
-
-	health_code_update();
-
-	/* Receive the request from the connected client. */
-	ret = recv_request(conn->sock, &request, sizeof(request));
-	if (ret < 0) {
-		goto error;
-	}
-
-	session_id = be64toh(request.session_id);
-	health_code_update();
 
 	memset(&response, 0, sizeof(response));
 
@@ -1264,17 +1258,19 @@ int viewer_attach_session(struct relay_connection *conn)
 
 	send_streams = 1;
 	viewer_attach_status = viewer_session_attach(conn->viewer_session,
-			session);
+			session, filter);
 	if (viewer_attach_status != LTTNG_VIEWER_ATTACH_OK) {
 		response.status = htobe32(viewer_attach_status);
 		goto send_reply;
 	}
+	/* Ownership transferred to the session. */
+	filter = NULL;
 
-	switch (be32toh(request.seek)) {
+	switch (seek) {
 	case LTTNG_VIEWER_SEEK_BEGINNING:
 	case LTTNG_VIEWER_SEEK_LAST:
 		response.status = htobe32(LTTNG_VIEWER_ATTACH_OK);
-		seek_type = be32toh(request.seek);
+		seek_type = seek;
 		break;
 	default:
 		ERR("Wrong seek parameter");
@@ -1335,7 +1331,106 @@ end_put_session:
 		pthread_mutex_unlock(&session->lock);
 		session_put(session);
 	}
-error:
+	free(filter);
+	return ret;
+}
+
+/*
+ * Send the viewer the list of streams of a session it attached to.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static
+int viewer_attach_session(struct relay_connection *conn)
+{
+	ssize_t ret;
+	struct lttng_viewer_attach_session_request request;
+
+	assert(conn);
+
+	health_code_update();
+
+	/* Receive the request from the connected client. */
+	ret = recv_request(conn->sock, &request, sizeof(request));
+	if (ret < 0) {
+		goto end;
+	}
+	health_code_update();
+
+	ret = attach_session(conn, be64toh(request.session_id),
+			be32toh(request.seek), NULL);
+end:
+	return ret;
+}
+
+/*
+ * Send the viewer the list of streams of a session it attached to, limited
+ * to the streams of the selected channel and CPUs. The selection also
+ * applies to the streams created later on during the session.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static
+int viewer_attach_session_filtered(struct relay_connection *conn)
+{
+	ssize_t ret;
+	uint32_t i, cpu_count;
+	struct lttng_viewer_attach_session_filtered_request request;
+	struct live_stream_filter *filter = NULL;
+
+	assert(conn);
+
+	health_code_update();
+
+	/* Receive the request from the connected client. */
+	ret = recv_request(conn->sock, &request, sizeof(request));
+	if (ret < 0) {
+		goto end;
+	}
+	health_code_update();
+
+	cpu_count = be32toh(request.cpu_count);
+	if (cpu_count > LTTNG_VIEWER_FILTER_CPUS_MAX) {
+		ERR("Viewer stream filter CPU count exceeds the maximum: count = %" PRIu32 ", max = %d",
+				cpu_count, LTTNG_VIEWER_FILTER_CPUS_MAX);
+		ret = -1;
+		goto end;
+	}
+
+	filter = zmalloc(sizeof(*filter) + cpu_count * sizeof(filter->cpus[0]));
+	if (!filter) {
+		PERROR("zmalloc viewer stream filter");
+		ret = -1;
+		goto end;
+	}
+
+	if (cpu_count) {
+		ret = recv_request(conn->sock, filter->cpus,
+				cpu_count * sizeof(filter->cpus[0]));
+		if (ret < 0) {
+			goto end;
+		}
+		health_code_update();
+	}
+
+	filter->cpu_count = cpu_count;
+	for (i = 0; i < cpu_count; i++) {
+		filter->cpus[i] = be32toh(filter->cpus[i]);
+	}
+	request.channel_name[sizeof(request.channel_name) - 1] = '\0';
+	strcpy(filter->channel_name, request.channel_name);
+
+	DBG("Filtered attach of session ID %" PRIu64 ": channel = \"%s\", cpu count = %" PRIu32,
+			be64toh(request.session_id),
+			filter->channel_name[0] ? filter->channel_name : "*",
+			cpu_count);
+
+	ret = attach_session(conn, be64toh(request.session_id),
+			be32toh(request.seek), filter);
+	/* Ownership transferred to attach_session(). */
+	filter = NULL;
+end:
+	free(filter);
 	return ret;
 }
 
@@ -2349,6 +2444,9 @@ int process_control(struct lttng_viewer_cmd *recv_hdr,
 	case LTTNG_VIEWER_DETACH_SESSION:
 		ret = viewer_detach_session(conn);
 		break;
+	case LTTNG_VIEWER_ATTACH_SESSION_FILTERED:
+		ret = viewer_attach_session_filtered(conn);
+		break;
 	default:
 		ERR("Received unknown viewer command (%u)",
 				be32toh(recv_hdr->cmd));
@@ -48,6 +48,8 @@ extern char *opt_output_path;
 extern const char *tracing_group_name;
 extern const char * const config_section_name;
 extern enum relay_group_output_by opt_group_output_by;
+extern uint64_t opt_writeback_size;
+extern uint64_t opt_writeback_resident_size;
 
 extern int thread_quit_pipe[2];
 
@@ -60,6 +60,7 @@
 #include "cmd.h"
 #include "connection.h"
 #include "ctf-trace.h"
+#include "forward.h"
 #include "health-relayd.h"
 #include "index.h"
 #include "live.h"
@@ -94,6 +95,8 @@ enum relay_connection_status {
 char *opt_output_path, *opt_working_directory;
 static int opt_daemon, opt_background, opt_print_version, opt_allow_clear = 1;
 enum relay_group_output_by opt_group_output_by = RELAYD_GROUP_OUTPUT_BY_UNKNOWN;
+uint64_t opt_writeback_size = DEFAULT_RELAYD_WRITEBACK_SIZE;
+uint64_t opt_writeback_resident_size = DEFAULT_RELAYD_WRITEBACK_RESIDENT_SIZE;
 
 /*
  * We need to wait for listener and live listener threads, as well as
@@ -111,6 +114,8 @@ static pid_t child_ppid;	/* Internal parent PID use with daemonize. */
 static struct lttng_uri *control_uri;
 static struct lttng_uri *data_uri;
 static struct lttng_uri *live_uri;
+/* Control and data URIs of the upstream relay daemon, if any. */
+static struct lttng_uri *upstream_uris;
 
 const char *progname;
 
@@ -191,6 +196,9 @@ static struct option long_options[] = {
 	{ "group-output-by-session", 0, 0, 's', },
 	{ "group-output-by-host", 0, 0, 'p', },
 	{ "disallow-clear", 0, 0, 'x' },
+	{ "writeback-size", 1, 0, '\0', },
+	{ "writeback-resident-size", 1, 0, '\0', },
+	{ "upstream-url", 1, 0, '\0', },
 	{ NULL, 0, 0, 0, },
 };
 
@@ -241,6 +249,32 @@ static int set_option(int opt, const char *arg, const char *optname)
 				goto end;
 			}
 			lttng_opt_fd_pool_size = (unsigned int) v;
+		} else if (!strcmp(optname, "writeback-size")) {
+			if (utils_parse_size_suffix(arg, &opt_writeback_size)) {
+				ERR("Wrong value in --writeback-size parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "writeback-resident-size")) {
+			if (utils_parse_size_suffix(arg,
+					&opt_writeback_resident_size)) {
+				ERR("Wrong value in --writeback-resident-size parameter: %s", arg);
+				ret = -1;
+				goto end;
+			}
+		} else if (!strcmp(optname, "upstream-url")) {
+			ssize_t uri_count;
+
+			uri_free(upstream_uris);
+			upstream_uris = NULL;
+			uri_count = uri_parse_str_urls(arg, NULL, &upstream_uris);
+			if (uri_count != 2 ||
+					upstream_uris[0].dtype == LTTNG_DST_PATH) {
+				ERR("Invalid upstream relay daemon URL specified: %s",
+						arg);
+				ret = -1;
+				goto end;
+			}
 		} else {
 			fprintf(stderr, "unknown option %s", optname);
 			if (arg) {
@@ -730,6 +764,7 @@ static void relayd_cleanup(void)
 
 	uri_free(control_uri);
 	uri_free(data_uri);
+	uri_free(upstream_uris);
 	/* Live URI is freed in the live thread. */
 
 	if (tracing_group_name_override) {
@@ -1439,6 +1474,7 @@ static int relay_create_session(const struct lttcomm_relayd_hdr *recv_hdr,
 	assert(!conn->session);
 	conn->session = session;
 	DBG("Created session %" PRIu64, session->id);
+	relay_forward_session_create(session);
 
 	reply.generic.session_id = htobe64(session->id);
 
@@ -1670,6 +1706,10 @@ static int relay_add_stream(const struct lttcomm_relayd_hdr *recv_hdr,
 	 */
 	ctf_trace_put(trace);
 
+	if (stream) {
+		relay_forward_stream_add(stream);
+	}
+
 send_reply:
 	memset(&reply, 0, sizeof(reply));
 	reply.handle = htobe64(stream_handle);
@@ -1693,6 +1733,230 @@ end_no_session:
 	return ret;
 }
 
+/*
+ * relay_add_streams: allocate a batch of streams sharing the same path for a
+ * session.
+ */
+static int relay_add_streams(const struct lttcomm_relayd_hdr *recv_hdr,
+		struct relay_connection *conn,
+		const struct lttng_buffer_view *payload)
+{
+	int ret = 0;
+	uint32_t i;
+	ssize_t send_ret;
+	size_t offset, reply_len = 0;
+	struct relay_session *session = conn->session;
+	struct lttcomm_relayd_add_streams header;
+	struct lttcomm_relayd_status_streams *reply = NULL;
+	struct relay_stream **streams = NULL;
+	const size_t header_len = sizeof(struct lttcomm_relayd_add_streams);
+	struct lttng_buffer_view names_view, pathname_view;
+	struct ctf_trace *trace = NULL;
+	char *streams_path_name = NULL;
+	enum lttng_error_code reply_code = LTTNG_ERR_UNK;
+
+	if (!session || !conn->version_check_done) {
+		ERR("Trying to add streams before version check");
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	if (session->major == 2 && session->minor < 13) {
+		ERR("Unsupported feature before 2.13");
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	if (payload->size < header_len) {
+		ERR("Unexpected payload size in \"relay_add_streams\": expected >= %zu bytes, got %zu bytes",
+				header_len, payload->size);
+		ret = -1;
+		goto end_no_reply;
+	}
+	memcpy(&header, payload->data, header_len);
+
+	header.stream_count = be32toh(header.stream_count);
+	header.names_len = be32toh(header.names_len);
+	header.pathname_len = be32toh(header.pathname_len);
+	header.tracefile_size = be64toh(header.tracefile_size);
+	header.tracefile_count = be64toh(header.tracefile_count);
+	header.trace_chunk_id = be64toh(header.trace_chunk_id);
+
+	if (header.pathname_len == 0 || header.pathname_len > LTTNG_NAME_MAX) {
+		ERR("Invalid path name length received in \"relay_add_streams\": %" PRIu32 " bytes",
+				header.pathname_len);
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	/* Every stream name is at least one byte long (its terminator). */
+	if (header.stream_count == 0 ||
+			header.names_len < header.stream_count) {
+		ERR("Invalid stream names received in \"relay_add_streams\": stream_count = %" PRIu32 ", names_len = %" PRIu32,
+				header.stream_count, header.names_len);
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	names_view = lttng_buffer_view_from_view(payload, header_len,
+			header.names_len);
+	if (!lttng_buffer_view_is_valid(&names_view)) {
+		ERR("Invalid payload received in \"relay_add_streams\": buffer too short for stream names");
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	pathname_view = lttng_buffer_view_from_view(payload,
+			header_len + header.names_len, header.pathname_len);
+	if (!lttng_buffer_view_is_valid(&pathname_view)) {
+		ERR("Invalid payload received in \"relay_add_streams\": buffer too short for path name");
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	if (pathname_view.data[pathname_view.size - 1] != '\0') {
+		ERR("relay_add_streams pathname is invalid (not NULL terminated)");
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	/* Validate all stream names before creating any stream. */
+	offset = 0;
+	for (i = 0; i < header.stream_count; i++) {
+		const char *name;
+		size_t name_len;
+
+		if (offset >= names_view.size) {
+			ERR("Invalid payload received in \"relay_add_streams\": buffer too short for stream name %" PRIu32,
+					i);
+			ret = -1;
+			goto end_no_reply;
+		}
+
+		name = names_view.data + offset;
+		name_len = strnlen(name, names_view.size - offset);
+		if (name_len == names_view.size - offset) {
+			ERR("relay_add_streams stream name %" PRIu32 " is invalid (not NULL terminated)",
+					i);
+			ret = -1;
+			goto end_no_reply;
+		}
+		if (name_len + 1 > DEFAULT_STREAM_NAME_LEN) {
+			ERR("Stream name too long");
+			ret = -1;
+			goto end_no_reply;
+		}
+		offset += name_len + 1;
+	}
+
+	reply_len = sizeof(*reply) +
+			sizeof(reply->handles[0]) * header.stream_count;
+	reply = zmalloc(reply_len);
+	if (!reply) {
+		PERROR("zmalloc \"add streams\" command reply");
+		ret = -1;
+		goto end_no_reply;
+	}
+	reply->stream_count = htobe32(header.stream_count);
+	for (i = 0; i < header.stream_count; i++) {
+		reply->handles[i] = htobe64(-1ULL);
+	}
+
+	streams = zmalloc(sizeof(*streams) * header.stream_count);
+	if (!streams) {
+		PERROR("zmalloc \"add streams\" command streams");
+		goto send_reply;
+	}
+
+	streams_path_name = strdup(pathname_view.data);
+	if (!streams_path_name) {
+		PERROR("Path name allocation");
+		goto send_reply;
+	}
+
+	if (conform_channel_path(streams_path_name)) {
+		goto send_reply;
+	}
+
+	/*
+	 * All streams share the same path, and thus the same trace. Peers
+	 * using this command are >= 2.11 and the trace chunk is responsible
+	 * for the output path: no group-by-session transformation is needed.
+	 */
+	trace = ctf_trace_get_by_path_or_create(session, streams_path_name);
+	if (!trace) {
+		goto send_reply;
+	}
+
+	offset = 0;
+	for (i = 0; i < header.stream_count; i++) {
+		const char *name = names_view.data + offset;
+		struct relay_stream *stream;
+		uint64_t stream_handle;
+		char *path_name, *channel_name;
+
+		offset += strlen(name) + 1;
+
+		path_name = strdup(streams_path_name);
+		channel_name = strdup(name);
+		if (!path_name || !channel_name) {
+			PERROR("Stream name allocation");
+			free(path_name);
+			free(channel_name);
+			goto destroy_streams;
+		}
+
+		/* This stream here has one reference on the trace. */
+		pthread_mutex_lock(&last_relay_stream_id_lock);
+		stream_handle = ++last_relay_stream_id;
+		pthread_mutex_unlock(&last_relay_stream_id_lock);
+
+		/* We pass ownership of path_name and channel_name. */
+		stream = stream_create(trace, stream_handle, path_name,
+				channel_name, header.tracefile_size,
+				header.tracefile_count);
+		if (!stream) {
+			goto destroy_streams;
+		}
+		streams[i] = stream;
+	}
+
+	for (i = 0; i < header.stream_count; i++) {
+		reply->handles[i] = htobe64(streams[i]->stream_handle);
+		relay_forward_stream_add(streams[i]);
+	}
+	reply_code = LTTNG_OK;
+	goto put_trace;
+
+destroy_streams:
+	/*
+	 * The peer is told that the whole batch failed: close the streams
+	 * created so far, which releases their creation reference.
+	 */
+	for (i = 0; i < header.stream_count && streams[i]; i++) {
+		try_stream_close(streams[i]);
+	}
+put_trace:
+	/*
+	 * Streams are the owners of their trace. Reference to trace is
+	 * kept within stream_create().
+	 */
+	ctf_trace_put(trace);
+send_reply:
+	reply->ret_code = htobe32((uint32_t) reply_code);
+	send_ret = conn->sock->ops->sendmsg(conn->sock, reply, reply_len, 0);
+	if (send_ret < (ssize_t) reply_len) {
+		ERR("Failed to send \"add streams\" command reply (ret = %zd)",
+				send_ret);
+		ret = -1;
+	}
+end_no_reply:
+	free(streams_path_name);
+	free(streams);
+	free(reply);
+	return ret;
+}
+
 /*
  * relay_close_stream: close a specific stream
  */
@@ -1748,6 +2012,7 @@ static int relay_close_stream(const struct lttcomm_relayd_hdr *recv_hdr,
 	 *        request.
 	 */
 	try_stream_close(stream);
+	relay_forward_stream_close(stream, stream_info.last_net_seq_num);
 	if (stream->is_metadata) {
 		struct relay_viewer_stream *vstream;
 
@@ -1850,6 +2115,9 @@ int relay_reset_metadata(const struct lttcomm_relayd_hdr *recv_hdr,
 	}
 end_unlock:
 	pthread_mutex_unlock(&stream->lock);
+	if (!ret) {
+		relay_forward_metadata_reset(stream, stream_info.version);
+	}
 	stream_put(stream);
 
 end:
@@ -1975,6 +2243,8 @@ static int relay_recv_metadata(const struct lttcomm_relayd_hdr *recv_hdr,
 		ret = -1;
 		goto end_put;
 	}
+	relay_forward_metadata(metadata_stream, &packet_view,
+			metadata_payload_header.padding_size);
 end_put:
 	stream_put(metadata_stream);
 end:
@@ -2051,6 +2321,32 @@ end:
 	return ret;
 }
 
+/*
+ * Sequence number of the last packet of a stream whose data and, if the
+ * stream has any, index were both written. -1ULL while either the data or
+ * the index of the stream's first packet is awaited.
+ *
+ * Called with the stream's lock held.
+ */
+static uint64_t stream_get_written_seq(struct relay_session *session,
+		struct relay_stream *stream)
+{
+	if (!session_streams_have_index(session) || stream->is_metadata) {
+		return stream->prev_data_seq;
+	}
+
+	if (stream->prev_data_seq == -1ULL ||
+			stream->prev_index_seq == -1ULL) {
+		return -1ULL;
+	}
+
+	/*
+	 * Ensure that both the index and stream data have been flushed up to
+	 * the requested point.
+	 */
+	return min(stream->prev_data_seq, stream->prev_index_seq);
+}
+
 /*
  * Check for data pending for a given stream id from the session daemon.
  */
@@ -2092,15 +2388,7 @@ static int relay_data_pending(const struct lttcomm_relayd_hdr *recv_hdr,
 
 	pthread_mutex_lock(&stream->lock);
 
-	if (session_streams_have_index(session)) {
-		/*
-		 * Ensure that both the index and stream data have been
-		 * flushed up to the requested point.
-		 */
-		stream_seq = min(stream->prev_data_seq, stream->prev_index_seq);
-	} else {
-		stream_seq = stream->prev_data_seq;
-	}
+	stream_seq = stream_get_written_seq(session, stream);
 	DBG("Data pending for stream id %" PRIu64 ": prev_data_seq %" PRIu64
 			", prev_index_seq %" PRIu64
 			", and last_seq %" PRIu64, msg.stream_id,
@@ -2119,6 +2407,12 @@ static int relay_data_pending(const struct lttcomm_relayd_hdr *recv_hdr,
 	stream->data_pending_check_done = true;
 	pthread_mutex_unlock(&stream->lock);
 
+	if (!ret && relay_forward_stream_data_pending(stream,
+			msg.last_net_seq_num)) {
+		/* Data is still being forwarded upstream. */
+		ret = 1;
+	}
+
 	stream_put(stream);
 end:
 
@@ -2330,15 +2624,8 @@ static int relay_end_data_pending(const struct lttcomm_relayd_hdr *recv_hdr,
 		if (!stream->data_pending_check_done) {
 			uint64_t stream_seq;
 
-			if (session_streams_have_index(conn->session)) {
-				/*
-				 * Ensure that both the index and stream data have been
-				 * flushed up to the requested point.
-				 */
-				stream_seq = min(stream->prev_data_seq, stream->prev_index_seq);
-			} else {
-				stream_seq = stream->prev_data_seq;
-			}
+			stream_seq = stream_get_written_seq(conn->session,
+					stream);
 			if (!stream->closed || !(((int64_t) (stream_seq - stream->last_net_seq_num)) >= 0)) {
 				is_data_inflight = 1;
 				DBG("Data is still in flight for stream %" PRIu64,
@@ -2353,6 +2640,10 @@ static int relay_end_data_pending(const struct lttcomm_relayd_hdr *recv_hdr,
 	}
 	rcu_read_unlock();
 
+	if (relay_forward_end_data_pending(conn->session)) {
+		is_data_inflight = 1;
+	}
+
 	memset(&reply, 0, sizeof(reply));
 	/* All good, send back reply. */
 	reply.ret_code = htobe32(is_data_inflight);
@@ -2438,6 +2729,7 @@ static int relay_recv_index(const struct lttcomm_relayd_hdr *recv_hdr,
 	if (ret) {
 		goto end_stream_put;
 	}
+	relay_forward_index(stream, &index_info);
 
 end_stream_put:
 	stream_put(stream);
@@ -2458,6 +2750,97 @@ end_no_session:
 	return ret;
 }
 
+/*
+ * relay_recv_beacons: receive the live beacons of a batch of idle streams.
+ *
+ * Beacons of unknown streams are ignored since a stream can be closed while
+ * its beacon is in flight.
+ */
+static int relay_recv_beacons(const struct lttcomm_relayd_hdr *recv_hdr,
+		struct relay_connection *conn,
+		const struct lttng_buffer_view *payload)
+{
+	int ret = 0;
+	uint32_t i;
+	ssize_t send_ret;
+	struct relay_session *session = conn->session;
+	struct lttcomm_relayd_beacons header;
+	struct lttcomm_relayd_generic_reply reply;
+	const size_t header_len = sizeof(struct lttcomm_relayd_beacons);
+	struct lttng_buffer_view beacons_view;
+
+	if (!session || !conn->version_check_done) {
+		ERR("Trying to receive beacons before version check");
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	if (session->major == 2 && session->minor < 13) {
+		ERR("Unsupported feature before 2.13");
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	if (payload->size < header_len) {
+		ERR("Unexpected payload size in \"relay_recv_beacons\": expected >= %zu bytes, got %zu bytes",
+				header_len, payload->size);
+		ret = -1;
+		goto end_no_reply;
+	}
+	memcpy(&header, payload->data, header_len);
+	header.beacon_count = be32toh(header.beacon_count);
+
+	beacons_view = lttng_buffer_view_from_view(payload, header_len,
+			(size_t) header.beacon_count *
+					sizeof(struct lttcomm_relayd_beacon));
+	if (!lttng_buffer_view_is_valid(&beacons_view)) {
+		ERR("Invalid payload received in \"relay_recv_beacons\": buffer too short for %" PRIu32 " beacons",
+				header.beacon_count);
+		ret = -1;
+		goto end_no_reply;
+	}
+
+	DBG("Relay receiving %" PRIu32 " live beacons", header.beacon_count);
+
+	for (i = 0; i < header.beacon_count; i++) {
+		struct lttcomm_relayd_beacon beacon;
+		struct relay_stream *stream;
+
+		memcpy(&beacon, beacons_view.data + i * sizeof(beacon),
+				sizeof(beacon));
+		beacon.relay_stream_id = be64toh(beacon.relay_stream_id);
+		beacon.net_seq_num = be64toh(beacon.net_seq_num);
+		beacon.timestamp_end = be64toh(beacon.timestamp_end);
+
+		stream = stream_get_by_id(beacon.relay_stream_id);
+		if (!stream) {
+			DBG("Ignoring live beacon of unknown stream %" PRIu64,
+					beacon.relay_stream_id);
+			continue;
+		}
+
+		pthread_mutex_lock(&stream->lock);
+		stream_add_beacon(stream, beacon.net_seq_num,
+				beacon.timestamp_end);
+		pthread_mutex_unlock(&stream->lock);
+		stream_put(stream);
+	}
+
+	relay_forward_beacons(session, &beacons_view, header.beacon_count);
+
+	memset(&reply, 0, sizeof(reply));
+	reply.ret_code = htobe32(LTTNG_OK);
+	send_ret = conn->sock->ops->sendmsg(conn->sock, &reply, sizeof(reply), 0);
+	if (send_ret < (ssize_t) sizeof(reply)) {
+		ERR("Failed to send \"recv beacons\" command reply (ret = %zd)",
+				send_ret);
+		ret = -1;
+	}
+
+end_no_reply:
+	return ret;
+}
+
 /*
  * Receive the streams_sent message.
  *
@@ -2486,6 +2869,7 @@ static int relay_streams_sent(const struct lttcomm_relayd_hdr *recv_hdr,
 	 * now ready to be used by the viewer.
 	 */
 	publish_connection_local_streams(conn);
+	relay_forward_streams_sent(conn->session);
 
 	memset(&reply, 0, sizeof(reply));
 	reply.ret_code = htobe32(LTTNG_OK);
@@ -2632,6 +3016,12 @@ static int relay_rotate_session_streams(
 		stream = NULL;
 	}
 
+	relay_forward_rotate_streams(session,
+			rotate_streams.new_chunk_id.is_set ?
+					&rotate_streams.new_chunk_id.value :
+					NULL,
+			&stream_positions, rotate_streams.stream_count);
+
 	reply_code = LTTNG_OK;
 	ret = 0;
 end:
@@ -2822,6 +3212,10 @@ static int relay_create_trace_chunk(const struct lttcomm_relayd_hdr *recv_hdr,
 	}
 end_unlock_session:
 	pthread_mutex_unlock(&conn->session->lock);
+	if (!ret) {
+		relay_forward_trace_chunk_create(session,
+				session->current_trace_chunk);
+	}
 end:
 	reply.ret_code = htobe32((uint32_t) reply_code);
 	send_ret = conn->sock->ops->sendmsg(conn->sock,
@@ -3059,6 +3453,9 @@ static int relay_close_trace_chunk(const struct lttcomm_relayd_hdr *recv_hdr,
 	session->pending_closure_trace_chunk = NULL;
 end_unlock_session:
 	pthread_mutex_unlock(&session->lock);
+	if (ret >= 0 && reply_code == LTTNG_OK) {
+		relay_forward_trace_chunk_close(session, chunk);
+	}
 
 end:
 	reply.generic.ret_code = htobe32((uint32_t) reply_code);
@@ -3293,6 +3690,14 @@ static int relay_process_control_command(struct relay_connection *conn,
 		DBG_CMD("RELAYD_GET_CONFIGURATION", conn);
 		ret = relay_get_configuration(header, conn, payload);
 		break;
+	case RELAYD_ADD_STREAMS:
+		DBG_CMD("RELAYD_ADD_STREAMS", conn);
+		ret = relay_add_streams(header, conn, payload);
+		break;
+	case RELAYD_SEND_BEACONS:
+		DBG_CMD("RELAYD_SEND_BEACONS", conn);
+		ret = relay_recv_beacons(header, conn, payload);
+		break;
 	case RELAYD_UPDATE_SYNC_INFO:
 	default:
 		ERR("Received unknown command (%u)", header->cmd);
@@ -3599,6 +4004,7 @@ static enum relay_connection_status relay_process_data_receive_payload(
 	bool new_stream = false, close_requested = false, index_flushed = false;
 	uint64_t left_to_receive = state->left_to_receive;
 	struct relay_session *session;
+	struct forward_command *forward_packet = NULL;
 
 	DBG3("Receiving data for stream id %" PRIu64 " seqnum %" PRIu64 ", %" PRIu64" bytes received, %" PRIu64 " bytes left to receive",
 			state->header.stream_id, state->header.net_seq_num,
@@ -3666,6 +4072,7 @@ static enum relay_connection_status relay_process_data_receive_payload(
 			status = RELAY_CONNECTION_STATUS_ERROR;
 			goto end_stream_unlock;
 		}
+		relay_forward_packet_append(stream, &packet_chunk);
 
 		left_to_receive -= recv_size;
 		state->received += recv_size;
@@ -3714,6 +4121,9 @@ static enum relay_connection_status relay_process_data_receive_payload(
 		goto end_stream_unlock;
 	}
 
+	forward_packet = relay_forward_packet_complete(stream,
+			state->header.net_seq_num, state->header.padding_size);
+
 	/*
 	 * Resetting the protocol state (to RECEIVE_HEADER) will trash the
 	 * contents of *state which are aliased (union) to the same location as
@@ -3725,6 +4135,7 @@ static enum relay_connection_status relay_process_data_receive_payload(
 end_stream_unlock:
 	close_requested = stream->close_requested;
 	pthread_mutex_unlock(&stream->lock);
+	relay_forward_packet_enqueue(forward_packet);
 	if (close_requested && left_to_receive == 0) {
 		try_stream_close(stream);
 	}
@@ -4196,6 +4607,10 @@ int main(int argc, char **argv)
 	}
 
 	DBG("Clear command %s", opt_allow_clear ? "allowed" : "disallowed");
+	if (opt_writeback_size) {
+		DBG("Stream writeback every %" PRIu64 " bytes, keeping %" PRIu64 " bytes resident",
+				opt_writeback_size, opt_writeback_resident_size);
+	}
 
 	/* Try to create directory if -o, --output is specified. */
 	if (opt_output_path) {
@@ -4350,6 +4765,14 @@ int main(int argc, char **argv)
 		goto exit_dispatcher_thread;
 	}
 
+	/* Enable the forwarding of the sessions upstream, if requested. */
+	ret = relay_forward_create(upstream_uris);
+	if (ret) {
+		ERR("Failed to set up forwarding to the upstream relay daemon");
+		retval = -1;
+		goto exit_forward;
+	}
+
 	/* Setup the worker thread */
 	ret = pthread_create(&worker_thread, default_pthread_attr(),
 			relay_thread_worker, NULL);
@@ -4404,6 +4827,10 @@ exit_listener_thread:
 	}
 
 exit_worker_thread:
+exit_forward:
+	/* The worker thread no longer queues packets to forward. */
+	relay_forward_destroy();
+
 	ret = pthread_join(dispatcher_thread, &status);
 	if (ret) {
 		errno = ret;
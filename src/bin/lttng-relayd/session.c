@@ -19,6 +19,7 @@
 #include <sys/stat.h>
 
 #include "ctf-trace.h"
+#include "forward.h"
 #include "lttng-relayd.h"
 #include "session.h"
 #include "sessiond-trace-chunks.h"
@@ -519,6 +520,8 @@ static void destroy_session(struct relay_session *session)
 	assert(!ret);
 	lttng_directory_handle_put(session->output_directory);
 	session->output_directory = NULL;
+	relay_forward_session_close(session->forward);
+	session->forward = NULL;
 	call_rcu(&session->rcu_node, rcu_destroy_session);
 }
 
@@ -22,6 +22,9 @@
 #include <common/trace-chunk.h>
 #include <common/optional.h>
 
+struct live_stream_filter;
+struct relay_forward_session;
+
 /*
  * Represents a session for the relay point of view
  */
@@ -80,6 +83,17 @@ struct relay_session {
 	uint32_t minor;
 
 	bool viewer_attached;
+	/*
+	 * Streams made available to the attached viewer, NULL to make every
+	 * stream available. Protected by the session lock.
+	 */
+	struct live_stream_filter *viewer_stream_filter;
+	/*
+	 * Upstream counterpart of the session, NULL if the session is not
+	 * forwarded to an upstream relay daemon (see forward.h). Only used by
+	 * the worker thread.
+	 */
+	struct relay_forward_session *forward;
 	/* Tell if the session connection has been closed on the streaming side. */
 	bool connection_closed;
 
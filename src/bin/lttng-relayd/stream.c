@@ -11,12 +11,14 @@
 #define _LGPL_SOURCE
 #include <common/common.h>
 #include <common/defaults.h>
+#include <common/compat/fcntl.h>
 #include <common/fs-handle.h>
 #include <common/sessiond-comm/relayd.h>
 #include <common/utils.h>
 #include <sys/stat.h>
 #include <urcu/rculist.h>
 
+#include "forward.h"
 #include "lttng-relayd.h"
 #include "index.h"
 #include "stream.h"
@@ -126,6 +128,47 @@ static int stream_create_data_output_file_from_trace_chunk(
 		ret = -1;
 		goto end;
 	}
+	stream->writeback_submitted = 0;
+	stream->writeback_dropped = 0;
+end:
+	return ret;
+}
+
+/*
+ * The data file of a stream is only created when its first packet of the
+ * current trace chunk (or trace file) is received so that idle streams don't
+ * produce empty files.
+ */
+static int stream_open_data_file(struct relay_stream *stream)
+{
+	int ret = 0;
+	struct lttng_trace_chunk *chunk = stream->trace_chunk;
+
+	ASSERT_LOCKED(stream->lock);
+
+	if (stream->file) {
+		goto end;
+	}
+
+	/*
+	 * Once the data file was rotated, the data received belongs to the
+	 * next trace chunk even if the rotation is not completed.
+	 */
+	if (stream->ongoing_rotation.is_set &&
+			stream->ongoing_rotation.value.data_rotated) {
+		chunk = stream->ongoing_rotation.value.next_trace_chunk;
+	}
+
+	if (!chunk) {
+		ERR("Protocol error: received a packet for a stream that doesn't have a current trace chunk: stream_id = %" PRIu64 ", channel_name = %s",
+				stream->stream_handle, stream->channel_name);
+		ret = -1;
+		goto end;
+	}
+
+	DBG("Creating data file of stream %" PRIu64, stream->stream_handle);
+	ret = stream_create_data_output_file_from_trace_chunk(stream, chunk,
+			false, &stream->file);
 end:
 	return ret;
 }
@@ -148,6 +191,10 @@ static int stream_rotate_data_file(struct relay_stream *stream)
 	if (stream->ongoing_rotation.value.next_trace_chunk) {
 		enum lttng_trace_chunk_status chunk_status;
 
+		/*
+		 * The data file of the next trace chunk is created when its
+		 * first packet is received.
+		 */
 		chunk_status = lttng_trace_chunk_create_subdirectory(
 				stream->ongoing_rotation.value.next_trace_chunk,
 				stream->path_name);
@@ -155,15 +202,6 @@ static int stream_rotate_data_file(struct relay_stream *stream)
 			ret = -1;
 			goto end;
 		}
-
-		/* Rotate the data file. */
-		ret = stream_create_data_output_file_from_trace_chunk(stream,
-				stream->ongoing_rotation.value.next_trace_chunk,
-				false, &stream->file);
-		if (ret < 0) {
-			ERR("Failed to rotate stream data file");
-			goto end;
-		}
 	}
 	DBG("%s: reset tracefile_size_current for stream %" PRIu64 " was %" PRIu64,
 			__func__, stream->stream_handle, stream->tracefile_size_current);
@@ -242,7 +280,11 @@ static int rotate_truncate_stream(struct relay_stream *stream)
 		goto end;
 	}
 
-	assert(stream->file);
+	ret = stream_open_data_file(stream);
+	if (ret) {
+		ERR("Failed to rotate stream data file");
+		goto end;
+	}
 	/*
 	 * Seek the current tracefile to the position at which the rotation
 	 * should have occurred.
@@ -558,8 +600,12 @@ static int stream_set_trace_chunk(struct relay_stream *stream,
 		fs_handle_close(stream->file);
 		stream->file = NULL;
 	}
-	ret = stream_create_data_output_file_from_trace_chunk(stream, chunk,
-			false, &stream->file);
+
+	/* The data files of data streams are created on their first packet. */
+	if (stream->is_metadata) {
+		ret = stream_create_data_output_file_from_trace_chunk(stream,
+				chunk, false, &stream->file);
+	}
 end:
 	return ret;
 }
@@ -594,6 +640,7 @@ struct relay_stream *stream_create(struct ctf_trace *trace,
 	stream->path_name = path_name;
 	stream->channel_name = channel_name;
 	stream->beacon_ts_end = -1ULL;
+	lttng_dynamic_buffer_init(&stream->forward_packet);
 	lttng_ht_node_init_u64(&stream->node, stream->stream_handle);
 	pthread_mutex_init(&stream->lock, NULL);
 	urcu_ref_init(&stream->ref);
@@ -620,6 +667,9 @@ struct relay_stream *stream_create(struct ctf_trace *trace,
 		goto end;
 	}
 
+	stream->is_metadata = !strcmp(stream->channel_name,
+			DEFAULT_METADATA_NAME);
+
 	pthread_mutex_lock(&stream->lock);
 	ret = stream_set_trace_chunk(stream, current_trace_chunk);
 	pthread_mutex_unlock(&stream->lock);
@@ -636,8 +686,6 @@ struct relay_stream *stream_create(struct ctf_trace *trace,
 		goto end;
 	}
 
-	stream->is_metadata = !strcmp(stream->channel_name,
-			DEFAULT_METADATA_NAME);
 	stream->in_recv_list = true;
 
 	/*
@@ -750,6 +798,8 @@ static void stream_destroy(struct relay_stream *stream)
 	if (stream->tfa) {
 		tracefile_array_destroy(stream->tfa);
 	}
+	relay_forward_stream_put(stream->forward);
+	lttng_dynamic_buffer_reset(&stream->forward_packet);
 	free(stream->path_name);
 	free(stream->channel_name);
 	free(stream);
@@ -991,13 +1041,18 @@ int stream_init_packet(struct relay_stream *stream, size_t packet_size,
 
 	ASSERT_LOCKED(stream->lock);
 
-	if (!stream->file || !stream->trace_chunk) {
+	if (!stream->trace_chunk) {
 		ERR("Protocol error: received a packet for a stream that doesn't have a current trace chunk: stream_id = %" PRIu64 ", channel_name = %s",
 				stream->stream_handle, stream->channel_name);
 		ret = -1;
 		goto end;
 	}
 
+	ret = stream_open_data_file(stream);
+	if (ret) {
+		goto end;
+	}
+
 	if (caa_likely(stream->tracefile_size == 0)) {
 		/* No size limit set; nothing to check. */
 		goto end;
@@ -1052,6 +1107,78 @@ end:
 	return ret;
 }
 
+/*
+ * Incrementally write back the data written to the current tracefile of a
+ * stream and evict it from the page cache once it has reached the disk.
+ *
+ * Every --writeback-size bytes, writeback of the newly written range is
+ * started without waiting for it. The range submitted on the previous pass,
+ * which had a full period to complete, is then waited for and dropped from
+ * the page cache, except for the last --writeback-resident-size bytes of the
+ * file which live viewers are the most likely to read.
+ *
+ * Errors are not reported since this only limits the amount of page cache
+ * used by the relay daemon.
+ *
+ * Called with the stream lock held.
+ */
+static void stream_writeback(struct relay_stream *stream)
+{
+	int fd, ret;
+	off_t position;
+	uint64_t previous_submitted, drop_end;
+
+	ASSERT_LOCKED(stream->lock);
+
+	if (!opt_writeback_size || stream->is_metadata) {
+		return;
+	}
+
+	position = fs_handle_seek(stream->file, 0, SEEK_CUR);
+	if (position < 0 ||
+			(uint64_t) position < stream->writeback_submitted +
+					opt_writeback_size) {
+		return;
+	}
+
+	fd = fs_handle_get_fd(stream->file);
+	if (fd < 0) {
+		return;
+	}
+
+	previous_submitted = stream->writeback_submitted;
+	lttng_sync_file_range(fd, (off64_t) previous_submitted,
+			(off64_t) position - previous_submitted,
+			SYNC_FILE_RANGE_WRITE);
+	stream->writeback_submitted = position;
+
+	if ((uint64_t) position <= opt_writeback_resident_size) {
+		goto end;
+	}
+	drop_end = min_t(uint64_t, previous_submitted,
+			position - opt_writeback_resident_size);
+	if (drop_end <= stream->writeback_dropped) {
+		goto end;
+	}
+
+	lttng_sync_file_range(fd, (off64_t) stream->writeback_dropped,
+			(off64_t) drop_end - stream->writeback_dropped,
+			SYNC_FILE_RANGE_WAIT_BEFORE |
+			SYNC_FILE_RANGE_WRITE |
+			SYNC_FILE_RANGE_WAIT_AFTER);
+	ret = posix_fadvise(fd, (off_t) stream->writeback_dropped,
+			(off_t) (drop_end - stream->writeback_dropped),
+			POSIX_FADV_DONTNEED);
+	if (ret && ret != -ENOSYS) {
+		errno = ret;
+		PERROR("posix_fadvise on file of stream %" PRIu64,
+				stream->stream_handle);
+	}
+	stream->writeback_dropped = drop_end;
+end:
+	fs_handle_put_fd(stream->file);
+}
+
 /* Note that the packet is not necessarily complete. */
 int stream_write(struct relay_stream *stream,
 		const struct lttng_buffer_view *packet, size_t padding_len)
@@ -1065,12 +1192,18 @@ int stream_write(struct relay_stream *stream,
 	memset(padding_buffer, 0,
 			min(sizeof(padding_buffer), padding_to_write));
 
-	if (!stream->file || !stream->trace_chunk) {
+	if (!stream->trace_chunk) {
 		ERR("Protocol error: received a packet for a stream that doesn't have a current trace chunk: stream_id = %" PRIu64 ", channel_name = %s",
 				stream->stream_handle, stream->channel_name);
 		ret = -1;
 		goto end;
 	}
+
+	ret = stream_open_data_file(stream);
+	if (ret) {
+		goto end;
+	}
+
 	if (packet) {
 		write_ret = fs_handle_write(
 				stream->file, packet->data, packet->size);
@@ -1099,6 +1232,8 @@ int stream_write(struct relay_stream *stream,
 		padding_to_write -= padding_to_write_this_pass;
 	}
 
+	stream_writeback(stream);
+
 	if (stream->is_metadata) {
 		size_t recv_len;
 
@@ -1304,6 +1439,36 @@ end:
 	return ret;
 }
 
+void stream_add_beacon(struct relay_stream *stream,
+		uint64_t net_seq_num, uint64_t timestamp_end)
+{
+	ASSERT_LOCKED(stream->lock);
+
+	DBG("Received batched live beacon for stream %" PRIu64,
+			stream->stream_handle);
+
+	/*
+	 * The consumer samples its idle streams before sending their beacons
+	 * in a batch; discard the beacon if an index of a packet sent after
+	 * the stream was sampled was received since.
+	 */
+	if (stream_beacon_is_overtaken(stream->prev_index_seq, net_seq_num)) {
+		DBG("Discarding live beacon of stream %" PRIu64
+				" overtaken by index %" PRIu64,
+				stream->stream_handle, stream->prev_index_seq);
+		return;
+	}
+
+	/*
+	 * Only flag a stream inactive when it has already
+	 * received data and no indexes are in flight.
+	 */
+	if (stream->index_received_seqcount > 0
+			&& stream->indexes_in_flight == 0) {
+		stream->beacon_ts_end = timestamp_end;
+	}
+}
+
 static void print_stream_indexes(struct relay_stream *stream)
 {
 	struct lttng_ht_iter iter;
@@ -1345,7 +1510,8 @@ int stream_reset_file(struct relay_stream *stream)
 			__func__, stream->stream_handle, stream->tracefile_size_current);
 	stream->tracefile_size_current = 0;
 	stream->prev_data_seq = 0;
-	stream->prev_index_seq = 0;
+	/* No index received yet in the new tracefile. */
+	stream->prev_index_seq = -1ULL;
 	/* Note that this does not reset the tracefile array. */
 	stream->tracefile_current_index = 0;
 	stream->pos_after_last_complete_data_index = 0;
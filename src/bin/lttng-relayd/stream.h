@@ -19,11 +19,13 @@
 #include <common/trace-chunk.h>
 #include <common/optional.h>
 #include <common/buffer-view.h>
+#include <common/dynamic-buffer.h>
 
 #include "session.h"
 #include "tracefile-array.h"
 
 struct lttcomm_relayd_index;
+struct relay_forward_stream;
 
 struct relay_stream_rotation {
 	/*
@@ -91,6 +93,16 @@ struct relay_stream {
 	 */
 	bool tracefile_wrapped_around;
 
+	/*
+	 * Page-cache writeback progress within the current tracefile (see
+	 * --writeback-size). Data before `writeback_submitted` has been
+	 * handed to the kernel for writeback; data before
+	 * `writeback_dropped` has reached the disk and was evicted from the
+	 * page cache. Both are reset when a new tracefile is opened.
+	 */
+	uint64_t writeback_submitted;
+	uint64_t writeback_dropped;
+
 	/*
 	 * Position in the tracefile where we have the full index also on disk.
 	 */
@@ -178,6 +190,13 @@ struct relay_stream {
 	struct lttng_trace_chunk *trace_chunk;
 	LTTNG_OPTIONAL(struct relay_stream_rotation) ongoing_rotation;
 	uint64_t completed_rotation_count;
+	/*
+	 * Upstream counterpart of the stream, NULL if the stream is not
+	 * forwarded (see forward.h).
+	 */
+	struct relay_forward_stream *forward;
+	/* Data of the packet being received, to be forwarded upstream. */
+	struct lttng_dynamic_buffer forward_packet;
 };
 
 struct relay_stream *stream_create(struct ctf_trace *trace,
@@ -208,6 +227,31 @@ int stream_complete_packet(struct relay_stream *stream,
 /* Index info is in host endianness. */
 int stream_add_index(struct relay_stream *stream,
 		const struct lttcomm_relayd_index *index_info);
+/*
+ * Handle a live beacon received in a batch. `net_seq_num` is the sequence
+ * number of the last packet sent by the consumer when it sampled the stream.
+ */
+void stream_add_beacon(struct relay_stream *stream,
+		uint64_t net_seq_num, uint64_t timestamp_end);
+
+/*
+ * Return true if a live beacon sampled when `beacon_seq` was the last packet
+ * sent for a stream was overtaken by the index of a later packet.
+ * `prev_index_seq` is the sequence number of the last index received. Either
+ * can be -1ULL, meaning that no packet was sent or no index was received
+ * since the stream was created or its tracefile reset.
+ */
+static inline bool stream_beacon_is_overtaken(uint64_t prev_index_seq,
+		uint64_t beacon_seq)
+{
+	if (prev_index_seq == -1ULL) {
+		/* Nothing to be overtaken by before the first index. */
+		return false;
+	}
+
+	return beacon_seq == -1ULL ||
+			(int64_t) (prev_index_seq - beacon_seq) > 0;
+}
 int stream_reset_file(struct relay_stream *stream);
 
 void print_relay_streams(void);
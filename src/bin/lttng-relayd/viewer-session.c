@@ -57,10 +57,17 @@ end:
 	return ret;
 }
 
-/* The existence of session must be guaranteed by the caller. */
+/*
+ * Attach a relay session to a viewer session. On success, the ownership of
+ * the stream filter, if any, is transferred to the relay session until the
+ * viewer detaches from it.
+ *
+ * The existence of session must be guaranteed by the caller.
+ */
 enum lttng_viewer_attach_return_code viewer_session_attach(
 		struct relay_viewer_session *vsession,
-		struct relay_session *session)
+		struct relay_session *session,
+		struct live_stream_filter *filter)
 {
 	enum lttng_viewer_attach_return_code viewer_attach_status =
 			LTTNG_VIEWER_ATTACH_OK;
@@ -92,6 +99,8 @@ enum lttng_viewer_attach_return_code viewer_session_attach(
 			DBG("Failed to create a viewer trace chunk from the current trace chunk of session \"%s\", returning LTTNG_VIEWER_ATTACH_UNK",
 					session->session_name);
 			viewer_attach_status = LTTNG_VIEWER_ATTACH_UNK;
+		} else {
+			session->viewer_stream_filter = filter;
 		}
 	}
 
@@ -120,6 +129,8 @@ static int viewer_session_detach(struct relay_viewer_session *vsession,
 		ret = -1;
 	} else {
 		session->viewer_attached = false;
+		free(session->viewer_stream_filter);
+		session->viewer_stream_filter = NULL;
 	}
 
 	if (!ret) {
@@ -39,7 +39,8 @@ void viewer_session_close(struct relay_viewer_session *vsession);
 
 enum lttng_viewer_attach_return_code viewer_session_attach(
 		struct relay_viewer_session *vsession,
-		struct relay_session *session);
+		struct relay_session *session,
+		struct live_stream_filter *filter);
 int viewer_session_is_attached(struct relay_viewer_session *vsession,
 		struct relay_session *session);
 void viewer_session_close_one_session(struct relay_viewer_session *vsession,
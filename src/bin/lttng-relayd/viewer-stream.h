@@ -15,9 +15,10 @@
 #include <pthread.h>
 
 #include <common/hashtable/hashtable.h>
+#include <common/live/lttng-viewer-abi.h>
+#include <common/live/stream-filter.h>
 
 #include "ctf-trace.h"
-#include "lttng-viewer-abi.h"
 #include "stream.h"
 
 struct relay_stream;
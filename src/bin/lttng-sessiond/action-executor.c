@@ -7,6 +7,7 @@
 
 #include "action-executor.h"
 #include "cmd.h"
+#include "counter-map.h"
 #include "health-sessiond.h"
 #include "lttng-sessiond.h"
 #include "notification-thread-internal.h"
@@ -82,6 +83,10 @@ static int action_executor_snapshot_session_handler(struct action_executor *exec
 static int action_executor_group_handler(struct action_executor *executor,
 		const struct action_work_item *,
 		const struct lttng_action *);
+static int action_executor_increment_counter_handler(
+		struct action_executor *executor,
+		const struct action_work_item *,
+		const struct lttng_action *);
 static int action_executor_generic_handler(struct action_executor *executor,
 		const struct action_work_item *,
 		const struct lttng_action *);
@@ -93,6 +98,7 @@ static const action_executor_handler action_executors[] = {
 	[LTTNG_ACTION_TYPE_ROTATE_SESSION] = action_executor_rotate_session_handler,
 	[LTTNG_ACTION_TYPE_SNAPSHOT_SESSION] = action_executor_snapshot_session_handler,
 	[LTTNG_ACTION_TYPE_GROUP] = action_executor_group_handler,
+	[LTTNG_ACTION_TYPE_INCREMENT_COUNTER] = action_executor_increment_counter_handler,
 };
 
 static const char *action_type_names[] = {
@@ -102,6 +108,7 @@ static const char *action_type_names[] = {
 	[LTTNG_ACTION_TYPE_ROTATE_SESSION] = "Rotate session",
 	[LTTNG_ACTION_TYPE_SNAPSHOT_SESSION] = "Snapshot session",
 	[LTTNG_ACTION_TYPE_GROUP] = "Group",
+	[LTTNG_ACTION_TYPE_INCREMENT_COUNTER] = "Increment counter",
 };
 
 static const char *get_action_name(const struct lttng_action *action)
@@ -438,7 +445,7 @@ static int action_executor_snapshot_session_handler(struct action_executor *exec
 		goto error_dispose_session;
 	}
 
-	cmd_ret = cmd_snapshot_record(session, snapshot_output, 0);
+	cmd_ret = cmd_snapshot_record(session, snapshot_output, 0, NULL);
 	switch (cmd_ret) {
 	case LTTNG_OK:
 		DBG("Successfully recorded snapshot of session `%s` on behalf of trigger `%s`",
@@ -460,6 +467,23 @@ end:
 	return ret;
 }
 
+static int action_executor_increment_counter_handler(
+		struct action_executor *executor,
+		const struct action_work_item *work_item,
+		const struct lttng_action *action)
+{
+	const struct lttng_credentials *trigger_creds =
+			lttng_trigger_get_credentials(work_item->trigger);
+	const struct lttng_event_field_value *captured_values = NULL;
+
+	/* Only set if the captures complete the key of a counter action. */
+	(void) lttng_evaluation_on_event_get_captured_values(
+			work_item->evaluation, &captured_values);
+	counter_map_increment(lttng_credentials_get_uid(trigger_creds), action,
+			captured_values);
+	return 0;
+}
+
 static int action_executor_group_handler(struct action_executor *executor,
 		const struct action_work_item *work_item,
 		const struct lttng_action *action_group)
@@ -43,6 +43,8 @@ struct buffer_reg_channel {
 	size_t subbuf_size;
 	/* Number of subbuffers per stream. */
 	size_t num_subbuf;
+	/* Name of the channel, used to scope snapshots. */
+	char name[LTTNG_SYMBOL_NAME_LEN];
 	union {
 		/* Original object data that MUST be copied over. */
 		struct lttng_ust_abi_object_data *ust;
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <urcu/list.h>
+
+#include <common/common.h>
+#include <common/defaults.h>
+#include <common/time.h>
+#include <common/utils.h>
+
+#include <lttng/channel-internal.h>
+
+#include "channel-advisor.h"
+
+struct channel_advisor_record {
+	uid_t uid;
+	enum lttng_domain_type domain;
+	char channel_name[LTTNG_SYMBOL_NAME_LEN];
+	uint64_t subbuf_size;
+	uint64_t num_subbuf;
+	unsigned int switch_timer_interval;
+	struct cds_list_head node;
+};
+
+/* Most recently used first. */
+static pthread_mutex_t records_lock = PTHREAD_MUTEX_INITIALIZER;
+static CDS_LIST_HEAD(records);
+static unsigned int records_count;
+
+static uint64_t round_up_pow2(uint64_t x)
+{
+	int order;
+
+	if (x <= 1) {
+		return 1;
+	}
+
+	order = utils_get_count_order_u64(x);
+	if (order >= 63) {
+		return 1ULL << 63;
+	}
+	return 1ULL << order;
+}
+
+/* Largest buffer size of a stream, all streams taking a share of memory. */
+static uint64_t get_max_buffer_size(uint64_t stream_count, long page_size)
+{
+	long phys_pages;
+
+	phys_pages = sysconf(_SC_PHYS_PAGES);
+	if (phys_pages <= 0) {
+		return UINT64_MAX;
+	}
+
+	return (uint64_t) phys_pages * page_size /
+			DEFAULT_CHANNEL_ADVISOR_MEMORY_SHARE / stream_count;
+}
+
+void channel_advisor_compute(const struct channel_advisor_input *input,
+		struct lttng_channel_advice *advice)
+{
+	long nr_cpus, page_size;
+	uint64_t stream_count, stream_rate, stream_peak_rate;
+	uint64_t subbuf_size, buffer_size, num_subbuf, min_num_subbuf;
+	uint64_t capacity, fill_period, max_buffer_size;
+	const struct channel_throughput_summary *throughput =
+			&input->throughput;
+
+	memset(advice, 0, sizeof(*advice));
+	advice->rate = throughput->rate;
+	advice->peak_rate = throughput->peak_rate;
+	advice->peak_usage = throughput->peak_usage;
+	advice->discarded_events = input->discarded_events;
+	advice->lost_packets = input->lost_packets;
+	advice->subbuf_size = input->subbuf_size;
+	advice->num_subbuf = input->num_subbuf;
+	advice->switch_timer_interval = input->switch_timer_interval;
+
+	/* A rate needs two samples of a buffer. */
+	if (throughput->duration == 0 || throughput->buffer_count == 0) {
+		return;
+	}
+	advice->observed_period = throughput->duration;
+
+	/* Channels have one stream per CPU in every buffer. */
+	nr_cpus = sysconf(_SC_NPROCESSORS_CONF);
+	page_size = sysconf(_SC_PAGESIZE);
+	if (nr_cpus <= 0 || page_size <= 0) {
+		return;
+	}
+
+	stream_count = throughput->buffer_count * (uint64_t) nr_cpus;
+	stream_rate = throughput->rate / stream_count;
+	stream_peak_rate = max_t(uint64_t, throughput->peak_rate / stream_count,
+			stream_rate);
+
+	subbuf_size = round_up_pow2(max_t(uint64_t,
+			stream_rate * DEFAULT_CHANNEL_ADVISOR_SUBBUF_PERIOD /
+					USEC_PER_SEC,
+			page_size));
+	buffer_size = stream_peak_rate * DEFAULT_CHANNEL_ADVISOR_BURST_PERIOD /
+			USEC_PER_SEC;
+
+	capacity = input->subbuf_size * input->num_subbuf;
+	if (input->discarded_events || input->lost_packets ||
+			throughput->peak_usage >= capacity / 4 * 3) {
+		/* Events were lost, or nearly: grow the buffers. */
+		buffer_size = max_t(uint64_t, buffer_size, capacity * 2);
+	}
+	/* Never shrink below twice the highest usage observed. */
+	buffer_size = max_t(uint64_t, buffer_size, throughput->peak_usage * 2);
+
+	/* The reader holds one sub-buffer of an overwrite mode channel. */
+	min_num_subbuf = input->overwrite == 1 ? 4 : 2;
+	num_subbuf = round_up_pow2(
+			(buffer_size + subbuf_size - 1) / subbuf_size);
+	num_subbuf = max_t(uint64_t, num_subbuf, min_num_subbuf);
+
+	/*
+	 * Losses grow the buffers at every advice: bound them, keeping at
+	 * least the minimum count of one-page sub-buffers. Halving the
+	 * powers of two keeps them powers of two.
+	 */
+	max_buffer_size = input->max_buffer_size ? :
+			get_max_buffer_size(stream_count, page_size);
+	max_buffer_size = max_t(uint64_t, max_buffer_size,
+			(uint64_t) page_size * min_num_subbuf);
+	while (subbuf_size * num_subbuf > max_buffer_size) {
+		if (num_subbuf > min_num_subbuf) {
+			num_subbuf >>= 1;
+		} else {
+			subbuf_size >>= 1;
+		}
+	}
+
+	advice->subbuf_size = subbuf_size;
+	advice->num_subbuf = num_subbuf;
+
+	/*
+	 * A switch timer only wakes the consumer daemon up when sub-buffers
+	 * fill faster than it expires.
+	 */
+	if (!input->live && input->switch_timer_interval && stream_rate) {
+		fill_period = subbuf_size * USEC_PER_SEC / stream_rate;
+		if (fill_period <= input->switch_timer_interval) {
+			advice->switch_timer_interval = 0;
+		}
+	}
+
+	DBG("Channel geometry advice: rate = %" PRIu64 " B/s, peak rate = %" PRIu64 " B/s, subbuf size = %" PRIu64 ", num subbuf = %" PRIu64 ", switch timer = %u",
+			throughput->rate, throughput->peak_rate,
+			advice->subbuf_size, advice->num_subbuf,
+			advice->switch_timer_interval);
+}
+
+static struct channel_advisor_record *find_record(uid_t uid,
+		enum lttng_domain_type domain, const char *channel_name)
+{
+	struct channel_advisor_record *record;
+
+	cds_list_for_each_entry(record, &records, node) {
+		if (record->uid == uid && record->domain == domain &&
+				!strcmp(record->channel_name, channel_name)) {
+			cds_list_move(&record->node, &records);
+			return record;
+		}
+	}
+
+	return NULL;
+}
+
+void channel_advisor_record(uid_t uid, enum lttng_domain_type domain,
+		const char *channel_name,
+		const struct lttng_channel_advice *advice)
+{
+	struct channel_advisor_record *record;
+
+	/* Nothing was observed; keep the previous advice, if any. */
+	if (!advice->observed_period) {
+		return;
+	}
+
+	pthread_mutex_lock(&records_lock);
+	record = find_record(uid, domain, channel_name);
+	if (!record && records_count >= DEFAULT_CHANNEL_ADVISOR_MAX_RECORDS) {
+		/* Reuse the least recently used record. */
+		record = cds_list_entry(records.prev,
+				struct channel_advisor_record, node);
+		DBG("Forgetting the advice of channel %s", record->channel_name);
+		cds_list_del(&record->node);
+		records_count--;
+		memset(record, 0, sizeof(*record));
+	} else if (!record) {
+		record = zmalloc(sizeof(*record));
+		if (!record) {
+			PERROR("zmalloc channel advisor record");
+			goto end;
+		}
+	}
+
+	if (!record->channel_name[0]) {
+		record->uid = uid;
+		record->domain = domain;
+		if (lttng_strncpy(record->channel_name, channel_name,
+				sizeof(record->channel_name))) {
+			free(record);
+			goto end;
+		}
+		cds_list_add(&record->node, &records);
+		records_count++;
+	}
+
+	record->subbuf_size = advice->subbuf_size;
+	record->num_subbuf = advice->num_subbuf;
+	record->switch_timer_interval = advice->switch_timer_interval;
+end:
+	pthread_mutex_unlock(&records_lock);
+}
+
+void channel_advisor_apply(uid_t uid, enum lttng_domain_type domain,
+		struct lttng_channel *attr)
+{
+	unsigned int advisable_attrs;
+	const struct channel_advisor_record *record;
+	const char *channel_name = attr->name[0] ? attr->name :
+			DEFAULT_CHANNEL_NAME;
+
+	/* Clients predating the advice choose the whole geometry. */
+	if (!attr->attr.extended.ptr) {
+		return;
+	}
+
+	advisable_attrs = ((struct lttng_channel_extended *)
+			attr->attr.extended.ptr)->advisable_attrs;
+	if (!advisable_attrs) {
+		return;
+	}
+
+	pthread_mutex_lock(&records_lock);
+	record = find_record(uid, domain, channel_name);
+	if (!record) {
+		goto end;
+	}
+
+	DBG("Applying advised geometry to channel %s: subbuf size = %" PRIu64 ", num subbuf = %" PRIu64 ", switch timer = %u, advisable attributes = %#x",
+			channel_name, record->subbuf_size, record->num_subbuf,
+			record->switch_timer_interval, advisable_attrs);
+	if (advisable_attrs & LTTNG_CHANNEL_ADVISABLE_ATTR_SUBBUF_SIZE) {
+		attr->attr.subbuf_size = record->subbuf_size;
+	}
+	if (advisable_attrs & LTTNG_CHANNEL_ADVISABLE_ATTR_NUM_SUBBUF) {
+		attr->attr.num_subbuf = record->num_subbuf;
+	}
+	if (advisable_attrs & LTTNG_CHANNEL_ADVISABLE_ATTR_SWITCH_TIMER) {
+		attr->attr.switch_timer_interval =
+				record->switch_timer_interval;
+	}
+end:
+	pthread_mutex_unlock(&records_lock);
+}
+
+void channel_advisor_fini(void)
+{
+	struct channel_advisor_record *record, *tmp;
+
+	pthread_mutex_lock(&records_lock);
+	cds_list_for_each_entry_safe(record, tmp, &records, node) {
+		cds_list_del(&record->node);
+		free(record);
+	}
+	records_count = 0;
+	pthread_mutex_unlock(&records_lock);
+}
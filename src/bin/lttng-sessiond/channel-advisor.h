@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_SESSIOND_CHANNEL_ADVISOR_H
+#define LTTNG_SESSIOND_CHANNEL_ADVISOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <lttng/channel.h>
+#include <lttng/domain.h>
+
+#include "notification-thread-internal.h"
+
+/*
+ * The channel geometry advisor recommends sub-buffer sizes, counts and switch
+ * timer intervals from the throughput observed in a channel's buffers by the
+ * notification thread (see struct channel_throughput), and from its discarded
+ * events and lost packets.
+ *
+ * The sub-buffers are sized to fill in DEFAULT_CHANNEL_ADVISOR_SUBBUF_PERIOD
+ * at the average rate of a stream, which bounds the wake-ups of the consumer
+ * daemon, and enough of them are recommended to absorb the peak rate of a
+ * stream during DEFAULT_CHANNEL_ADVISOR_BURST_PERIOD. Channels which lost data
+ * or were nearly full are grown at least twofold, up to a maximum buffer size.
+ */
+struct channel_advisor_input {
+	enum lttng_domain_type domain;
+	int overwrite;
+	uint64_t subbuf_size;
+	uint64_t num_subbuf;
+	unsigned int switch_timer_interval;
+	/* The live timer of the session replaces the switch timer. */
+	bool live;
+	struct channel_throughput_summary throughput;
+	uint64_t discarded_events;
+	uint64_t lost_packets;
+	/*
+	 * Largest advised buffer size (bytes) of a stream. When 0, the buffers
+	 * of all the streams are limited to DEFAULT_CHANNEL_ADVISOR_MEMORY_SHARE
+	 * of the physical memory.
+	 */
+	uint64_t max_buffer_size;
+};
+
+void channel_advisor_compute(const struct channel_advisor_input *input,
+		struct lttng_channel_advice *advice);
+
+/*
+ * Remember the geometry recommended for a user's channel for the next
+ * channel of the same name and domain this user creates. Only the
+ * DEFAULT_CHANNEL_ADVISOR_MAX_RECORDS most recently used channels are
+ * remembered.
+ */
+void channel_advisor_record(uid_t uid, enum lttng_domain_type domain,
+		const char *channel_name,
+		const struct lttng_channel_advice *advice);
+
+/*
+ * Apply, to the attributes of a channel being created, the geometry last
+ * recorded for the user's channel of the same name and domain. Only the
+ * attributes the client left to the advice (see
+ * lttng_channel_set_advisable_attributes()) are replaced.
+ */
+void channel_advisor_apply(uid_t uid, enum lttng_domain_type domain,
+		struct lttng_channel *attr);
+
+void channel_advisor_fini(void);
+
+#endif /* LTTNG_SESSIOND_CHANNEL_ADVISOR_H */
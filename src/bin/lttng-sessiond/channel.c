@@ -261,6 +261,19 @@ int channel_kernel_create(struct ltt_kernel_session *ksession,
 		goto error;
 	}
 
+	/*
+	 * The local copy of a streamed session is written from the mapped
+	 * sub-buffers: spliced data can only be moved once.
+	 */
+	if (ksession->consumer->tee_path[0] &&
+			attr->attr.output != LTTNG_EVENT_MMAP) {
+		if (!defattr) {
+			ret = LTTNG_ERR_LOCAL_COPY_SPLICE;
+			goto error;
+		}
+		attr->attr.output = LTTNG_EVENT_MMAP;
+	}
+
 	/* Channel not found, creating it */
 	ret = kernel_create_channel(ksession, attr);
 	if (ret < 0) {
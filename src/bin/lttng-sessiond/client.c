@@ -23,6 +23,7 @@
 #include <common/tracker.h>
 #include <common/unix.h>
 #include <common/utils.h>
+#include <lttng/counter-map-internal.h>
 #include <lttng/event-internal.h>
 #include <lttng/session-descriptor-internal.h>
 #include <lttng/session-internal.h>
@@ -199,6 +200,8 @@ static pid_t spawn_consumerd(struct consumer_data *consumer_data)
 	pid_t pid;
 	const char *consumer_to_use;
 	const char *verbosity;
+	/* The argument list ends early when no live URL is set. */
+	const char *live_url_opt = NULL;
 	struct stat st;
 
 	DBG("Spawning consumerd");
@@ -243,11 +246,15 @@ static pid_t spawn_consumerd(struct consumer_data *consumer_data)
 				goto error;
 			}
 			DBG("Using kernel consumer at: %s",  consumer_to_use);
+			if (config.kconsumerd_live_url.value) {
+				live_url_opt = "--live-url";
+			}
 			(void) execl(consumer_to_use,
 				"lttng-consumerd", verbosity, "-k",
 				"--consumerd-cmd-sock", consumer_data->cmd_unix_sock_path,
 				"--consumerd-err-sock", consumer_data->err_unix_sock_path,
 				"--group", config.tracing_group_name.value,
+				live_url_opt, config.kconsumerd_live_url.value,
 				NULL);
 			break;
 		case LTTNG_CONSUMER64_UST:
@@ -280,10 +287,14 @@ static pid_t spawn_consumerd(struct consumer_data *consumer_data)
 				}
 			}
 			DBG("Using 64-bit UST consumer at: %s",  config.consumerd64_bin_path.value);
+			if (config.consumerd64_live_url.value) {
+				live_url_opt = "--live-url";
+			}
 			(void) execl(config.consumerd64_bin_path.value, "lttng-consumerd", verbosity, "-u",
 					"--consumerd-cmd-sock", consumer_data->cmd_unix_sock_path,
 					"--consumerd-err-sock", consumer_data->err_unix_sock_path,
 					"--group", config.tracing_group_name.value,
+					live_url_opt, config.consumerd64_live_url.value,
 					NULL);
 			break;
 		}
@@ -317,10 +328,14 @@ static pid_t spawn_consumerd(struct consumer_data *consumer_data)
 				}
 			}
 			DBG("Using 32-bit UST consumer at: %s",  config.consumerd32_bin_path.value);
+			if (config.consumerd32_live_url.value) {
+				live_url_opt = "--live-url";
+			}
 			(void) execl(config.consumerd32_bin_path.value, "lttng-consumerd", verbosity, "-u",
 					"--consumerd-cmd-sock", consumer_data->cmd_unix_sock_path,
 					"--consumerd-err-sock", consumer_data->err_unix_sock_path,
 					"--group", config.tracing_group_name.value,
+					live_url_opt, config.consumerd32_live_url.value,
 					NULL);
 			break;
 		}
@@ -417,6 +432,17 @@ static int copy_session_consumer(int domain, struct ltt_session *session)
 	assert(session);
 	assert(session->consumer);
 
+	/*
+	 * The consumer daemons of each domain serve the live sessions with a
+	 * local output on their own live URL.
+	 */
+	if (session->live_timer &&
+			session->consumer->type == CONSUMER_DST_LOCAL &&
+			!sessiond_config_has_live_url(&config, domain)) {
+		ret = LTTNG_ERR_LIVE_LOCAL_NO_URL;
+		goto error;
+	}
+
 	switch (domain) {
 	case LTTNG_DOMAIN_KERNEL:
 		DBG3("Copying tracing session consumer output in kernel session");
@@ -776,6 +802,23 @@ static int setup_lttng_msg_no_cmd_header(struct command_ctx *cmd_ctx,
 	return setup_lttng_msg(cmd_ctx, payload_buf, payload_len, NULL, 0);
 }
 
+/*
+ * Get the selection of objects requested by a listing command.
+ */
+static void get_list_selection(struct command_ctx *cmd_ctx,
+		struct cmd_list_selection *selection)
+{
+	char *name_pattern = cmd_ctx->lsm.u.list.name_pattern;
+
+	/* The pattern comes from the client; ensure it is terminated. */
+	name_pattern[sizeof(cmd_ctx->lsm.u.list.name_pattern) - 1] = '\0';
+
+	selection->name_pattern = name_pattern[0] != '\0' ?
+			name_pattern : NULL;
+	selection->cursor = cmd_ctx->lsm.u.list.cursor;
+	selection->max_count = cmd_ctx->lsm.u.list.max_count;
+}
+
 /*
  * Check if the current kernel tracer supports the session rotation feature.
  * Return 1 if it does, 0 otherwise.
@@ -868,6 +911,7 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 	case LTTNG_SNAPSHOT_RECORD:
 	case LTTNG_SAVE_SESSION:
 	case LTTNG_SET_SESSION_SHM_PATH:
+	case LTTNG_SET_SESSION_LOCAL_COPY_PATH:
 	case LTTNG_REGENERATE_METADATA:
 	case LTTNG_REGENERATE_STATEDUMP:
 	case LTTNG_ROTATE_SESSION:
@@ -876,6 +920,8 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 	case LTTNG_SESSION_LIST_ROTATION_SCHEDULES:
 	case LTTNG_CLEAR_SESSION:
 	case LTTNG_LIST_TRIGGERS:
+	case LTTNG_LIST_COUNTER_MAP:
+	case LTTNG_CLEAR_COUNTER_MAP:
 		need_domain = false;
 		break;
 	default:
@@ -935,6 +981,9 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 	case LTTNG_ROTATION_GET_INFO:
 	case LTTNG_REGISTER_TRIGGER:
 	case LTTNG_LIST_TRIGGERS:
+	case LTTNG_ENABLE_EVENTS:
+	case LTTNG_LIST_COUNTER_MAP:
+	case LTTNG_GET_CHANNEL_ADVICE:
 		break;
 	default:
 		/* Setup lttng message with no payload */
@@ -956,6 +1005,8 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 	case LTTNG_REGISTER_TRIGGER:
 	case LTTNG_UNREGISTER_TRIGGER:
 	case LTTNG_LIST_TRIGGERS:
+	case LTTNG_LIST_COUNTER_MAP:
+	case LTTNG_CLEAR_COUNTER_MAP:
 		need_tracing_session = false;
 		break;
 	default:
@@ -986,6 +1037,7 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 	switch (cmd_ctx->lsm.cmd_type) {
 	case LTTNG_DISABLE_CHANNEL:
 	case LTTNG_DISABLE_EVENT:
+	case LTTNG_GET_CHANNEL_ADVICE:
 		switch (cmd_ctx->lsm.domain.type) {
 		case LTTNG_DOMAIN_KERNEL:
 			if (!cmd_ctx->session->kernel_session) {
@@ -1070,7 +1122,8 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 			 * the consumer output of the session if exist.
 			 */
 			ret = consumer_create_socket(&kconsumer_data,
-					cmd_ctx->session->kernel_session->consumer);
+					cmd_ctx->session->kernel_session->consumer,
+					cmd_ctx->session->id);
 			if (ret < 0) {
 				goto error;
 			}
@@ -1134,7 +1187,8 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 			 * since it was set above and can ONLY be set in this thread.
 			 */
 			ret = consumer_create_socket(&ustconsumer64_data,
-					cmd_ctx->session->ust_session->consumer);
+					cmd_ctx->session->ust_session->consumer,
+					cmd_ctx->session->id);
 			if (ret < 0) {
 				goto error;
 			}
@@ -1163,7 +1217,8 @@ static int process_client_msg(struct command_ctx *cmd_ctx, int *sock,
 			 * since it was set above and can ONLY be set in this thread.
 			 */
 			ret = consumer_create_socket(&ustconsumer32_data,
-					cmd_ctx->session->ust_session->consumer);
+					cmd_ctx->session->ust_session->consumer,
+					cmd_ctx->session->id);
 			if (ret < 0) {
 				goto error;
 			}
@@ -1689,6 +1744,72 @@ error_add_context:
 		lttng_event_destroy(ev);
 		break;
 	}
+	case LTTNG_ENABLE_EVENTS:
+	{
+		const uint32_t event_count =
+				cmd_ctx->lsm.u.enable_events.event_count;
+		struct lttng_event *events = NULL;
+		enum lttng_error_code *ret_codes = NULL;
+		int32_t *reply_ret_codes = NULL;
+		uint32_t i;
+
+		if (event_count == 0 ||
+				event_count > LTTNG_ENABLE_EVENTS_MAX_COUNT) {
+			ret = LTTNG_ERR_INVALID;
+			goto error;
+		}
+
+		events = zmalloc(sizeof(*events) * event_count);
+		ret_codes = zmalloc(sizeof(*ret_codes) * event_count);
+		reply_ret_codes = zmalloc(sizeof(*reply_ret_codes) * event_count);
+		if (!events || !ret_codes || !reply_ret_codes) {
+			ret = LTTNG_ERR_NOMEM;
+			goto error_enable_events;
+		}
+
+		DBG("Receiving %" PRIu32 " events from client ...", event_count);
+		ret = lttcomm_recv_unix_sock(*sock, events,
+				sizeof(*events) * event_count);
+		if (ret <= 0) {
+			DBG("Nothing recv() from client var len data... continuing");
+			*sock_error = 1;
+			ret = LTTNG_ERR_INVALID;
+			goto error_enable_events;
+		}
+
+		/* The extended part of the events is not transmitted. */
+		for (i = 0; i < event_count; i++) {
+			events[i].extended.ptr = NULL;
+		}
+
+		ret = cmd_enable_events(cmd_ctx->session,
+				ALIGNED_CONST_PTR(cmd_ctx->lsm.domain),
+				cmd_ctx->lsm.u.enable_events.channel_name,
+				events, event_count, ret_codes,
+				kernel_poll_pipe[1]);
+		if (ret != LTTNG_OK) {
+			goto error_enable_events;
+		}
+
+		for (i = 0; i < event_count; i++) {
+			reply_ret_codes[i] = ret_codes[i] == LTTNG_OK ?
+					0 : -ret_codes[i];
+		}
+
+		ret = setup_lttng_msg_no_cmd_header(cmd_ctx, reply_ret_codes,
+				sizeof(*reply_ret_codes) * event_count);
+		if (ret < 0) {
+			ret = LTTNG_ERR_NOMEM;
+			goto error_enable_events;
+		}
+
+		ret = LTTNG_OK;
+	error_enable_events:
+		free(events);
+		free(ret_codes);
+		free(reply_ret_codes);
+		break;
+	}
 	case LTTNG_LIST_TRACEPOINTS:
 	{
 		struct lttng_event *events;
@@ -1872,9 +1993,11 @@ error_add_context:
 	{
 		ssize_t payload_size;
 		struct lttng_channel *channels = NULL;
+		struct cmd_list_selection selection;
 
+		get_list_selection(cmd_ctx, &selection);
 		payload_size = cmd_list_channels(cmd_ctx->lsm.domain.type,
-				cmd_ctx->session, &channels);
+				cmd_ctx->session, &selection, &channels);
 		if (payload_size < 0) {
 			/* Return value is a negative lttng_error_code. */
 			ret = -payload_size;
@@ -1898,6 +2021,7 @@ error_add_context:
 		struct lttcomm_event_command_header cmd_header = {};
 		size_t original_payload_size;
 		size_t payload_size;
+		struct cmd_list_selection selection;
 
 		ret = setup_empty_lttng_msg(cmd_ctx);
 		if (ret) {
@@ -1908,10 +2032,11 @@ error_add_context:
 		original_payload_size = cmd_ctx->reply_payload.buffer.size;
 
 		/* Extended infos are included at the end of the payload. */
+		get_list_selection(cmd_ctx, &selection);
 		list_ret = cmd_list_events(cmd_ctx->lsm.domain.type,
 				cmd_ctx->session,
 				cmd_ctx->lsm.u.list.channel_name,
-				&cmd_ctx->reply_payload);
+				&selection, &cmd_ctx->reply_payload);
 		if (list_ret < 0) {
 			/* Return value is a negative lttng_error_code. */
 			ret = -list_ret;
@@ -2075,9 +2200,53 @@ error_add_context:
 	}
 	case LTTNG_SNAPSHOT_RECORD:
 	{
+		const uint32_t channel_count =
+				cmd_ctx->lsm.u.snapshot_record.channel_count;
+		char (*channel_names)[LTTNG_SYMBOL_NAME_LEN] = NULL;
+		struct snapshot_scope scope;
+		uint32_t i;
+
+		if (channel_count > LTTNG_SNAPSHOT_RECORD_MAX_CHANNEL_COUNT) {
+			ret = LTTNG_ERR_INVALID;
+			goto error;
+		}
+
+		if (channel_count) {
+			channel_names = zmalloc(sizeof(*channel_names) *
+					channel_count);
+			if (!channel_names) {
+				ret = LTTNG_ERR_NOMEM;
+				goto error;
+			}
+
+			DBG("Receiving %" PRIu32 " snapshot channel names from client ...",
+					channel_count);
+			ret = lttcomm_recv_unix_sock(*sock, channel_names,
+					sizeof(*channel_names) * channel_count);
+			if (ret <= 0) {
+				DBG("Nothing recv() from client var len data... continuing");
+				*sock_error = 1;
+				ret = LTTNG_ERR_INVALID;
+				goto error_snapshot_record;
+			}
+			for (i = 0; i < channel_count; i++) {
+				channel_names[i][LTTNG_SYMBOL_NAME_LEN - 1] = '\0';
+			}
+		}
+
+		if (snapshot_scope_init(&scope,
+				(const char (*)[LTTNG_SYMBOL_NAME_LEN]) channel_names,
+				channel_count,
+				cmd_ctx->lsm.u.snapshot_record.time_window_us)) {
+			ret = LTTNG_ERR_UNK;
+			goto error_snapshot_record;
+		}
+
 		ret = cmd_snapshot_record(cmd_ctx->session,
 				ALIGNED_CONST_PTR(cmd_ctx->lsm.u.snapshot_record.output),
-				cmd_ctx->lsm.u.snapshot_record.wait);
+				cmd_ctx->lsm.u.snapshot_record.wait, &scope);
+	error_snapshot_record:
+		free(channel_names);
 		break;
 	}
 	case LTTNG_CREATE_SESSION_EXT:
@@ -2123,6 +2292,12 @@ error_add_context:
 				cmd_ctx->lsm.u.set_shm_path.shm_path);
 		break;
 	}
+	case LTTNG_SET_SESSION_LOCAL_COPY_PATH:
+	{
+		ret = cmd_set_session_local_copy_path(cmd_ctx->session,
+				cmd_ctx->lsm.u.set_local_copy_path.path);
+		break;
+	}
 	case LTTNG_REGENERATE_METADATA:
 	{
 		ret = cmd_regenerate_metadata(cmd_ctx->session);
@@ -2343,6 +2518,77 @@ error_add_context:
 		ret = LTTNG_OK;
 		break;
 	}
+	case LTTNG_LIST_COUNTER_MAP:
+	{
+		struct lttng_counter_map_values *values = NULL;
+		size_t original_payload_size;
+		size_t payload_size;
+
+		ret = setup_empty_lttng_msg(cmd_ctx);
+		if (ret) {
+			ret = LTTNG_ERR_NOMEM;
+			goto setup_error;
+		}
+
+		original_payload_size = cmd_ctx->reply_payload.buffer.size;
+
+		cmd_ctx->lsm.u.counter_map.map_name[
+				sizeof(cmd_ctx->lsm.u.counter_map.map_name) - 1] = '\0';
+		ret = cmd_list_counter_map(cmd_ctx, notification_thread_handle,
+				cmd_ctx->lsm.u.counter_map.map_name, &values);
+		if (ret != LTTNG_OK) {
+			goto error;
+		}
+
+		ret = lttng_counter_map_values_serialize(
+				values, &cmd_ctx->reply_payload);
+		lttng_counter_map_values_destroy(values);
+		if (ret) {
+			ERR("Failed to serialize counter map values in reply to `list counter map` command");
+			ret = LTTNG_ERR_NOMEM;
+			goto error;
+		}
+
+		payload_size = cmd_ctx->reply_payload.buffer.size -
+			original_payload_size;
+
+		update_lttng_msg(cmd_ctx, 0, payload_size);
+
+		ret = LTTNG_OK;
+		break;
+	}
+	case LTTNG_CLEAR_COUNTER_MAP:
+	{
+		cmd_ctx->lsm.u.counter_map.map_name[
+				sizeof(cmd_ctx->lsm.u.counter_map.map_name) - 1] = '\0';
+		ret = cmd_clear_counter_map(cmd_ctx, notification_thread_handle,
+				cmd_ctx->lsm.u.counter_map.map_name);
+		break;
+	}
+	case LTTNG_GET_CHANNEL_ADVICE:
+	{
+		struct lttng_channel_advice advice;
+
+		memset(&advice, 0, sizeof(advice));
+		cmd_ctx->lsm.u.channel_advice.channel_name[
+				sizeof(cmd_ctx->lsm.u.channel_advice.channel_name) - 1] = '\0';
+		ret = cmd_get_channel_advice(cmd_ctx->session,
+				cmd_ctx->lsm.domain.type,
+				cmd_ctx->lsm.u.channel_advice.channel_name,
+				&advice);
+		if (ret != LTTNG_OK) {
+			goto error;
+		}
+
+		ret = setup_lttng_msg_no_cmd_header(cmd_ctx, &advice,
+				sizeof(advice));
+		if (ret < 0) {
+			goto setup_error;
+		}
+
+		ret = LTTNG_OK;
+		break;
+	}
 	default:
 		ret = LTTNG_ERR_UND;
 		break;
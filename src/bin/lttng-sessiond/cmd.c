@@ -21,6 +21,7 @@
 #include <common/relayd/relayd.h>
 #include <common/utils.h>
 #include <common/compat/string.h>
+#include <common/compat/time.h>
 #include <common/kernel-ctl/kernel-ctl.h>
 #include <common/dynamic-buffer.h>
 #include <common/buffer-view.h>
@@ -48,7 +49,9 @@
 #include <common/string-utils/string-utils.h>
 
 #include "channel.h"
+#include "channel-advisor.h"
 #include "consumer.h"
+#include "counter-map.h"
 #include "event.h"
 #include "health-sessiond.h"
 #include "kernel.h"
@@ -65,6 +68,7 @@
 #include "timer.h"
 #include "agent-thread.h"
 #include "tracker.h"
+#include "reap-apps.h"
 
 #include "cmd.h"
 
@@ -290,13 +294,55 @@ end:
 }
 
 /*
- * Fill lttng_channel array of all channels.
+ * Returns true if the object named `name` is part of `selection`.
+ *
+ * `matched` counts the objects matching the name pattern seen so far during
+ * a listing; it must be zero-initialized before the first call.
+ */
+static bool list_selection_match(const struct cmd_list_selection *selection,
+		uint32_t *matched, const char *name)
+{
+	uint32_t position;
+
+	if (selection->name_pattern &&
+			!strutils_star_glob_match(selection->name_pattern, name)) {
+		return false;
+	}
+
+	position = (*matched)++;
+	if (position < selection->cursor) {
+		return false;
+	}
+
+	return !selection->max_count ||
+			position - selection->cursor < selection->max_count;
+}
+
+/*
+ * Returns true once all the objects of `selection` were seen during a
+ * listing, allowing it to stop early.
+ */
+static bool list_selection_complete(const struct cmd_list_selection *selection,
+		uint32_t matched)
+{
+	return selection->max_count &&
+			(uint64_t) matched >= (uint64_t) selection->cursor +
+					selection->max_count;
+}
+
+/*
+ * Fill lttng_channel array of the selected channels.
+ *
+ * Return the number of channels listed or else a negative lttng_error_code.
  */
 static ssize_t list_lttng_channels(enum lttng_domain_type domain,
-		struct ltt_session *session, struct lttng_channel *channels,
+		struct ltt_session *session,
+		const struct cmd_list_selection *selection,
+		struct lttng_channel *channels,
 		struct lttng_channel_extended *chan_exts)
 {
 	int i = 0, ret = 0;
+	uint32_t matched = 0;
 	struct ltt_kernel_channel *kchan;
 
 	DBG("Listing channels for session %s", session->name);
@@ -310,6 +356,14 @@ static ssize_t list_lttng_channels(enum lttng_domain_type domain,
 				uint64_t discarded_events, lost_packets;
 				struct lttng_channel_extended *extended;
 
+				if (list_selection_complete(selection, matched)) {
+					break;
+				}
+				if (!list_selection_match(selection, &matched,
+						kchan->channel->name)) {
+					continue;
+				}
+
 				extended = (struct lttng_channel_extended *)
 						kchan->channel->attr.extended.ptr;
 
@@ -327,6 +381,9 @@ static ssize_t list_lttng_channels(enum lttng_domain_type domain,
 				chan_exts[i].monitor_timer_interval =
 						extended->monitor_timer_interval;
 				chan_exts[i].blocking_timeout = 0;
+				chan_exts[i].writeback_window_size =
+						extended->writeback_window_size;
+				chan_exts[i].direct_io = extended->direct_io;
 				i++;
 			}
 		}
@@ -341,6 +398,14 @@ static ssize_t list_lttng_channels(enum lttng_domain_type domain,
 				&iter.iter, uchan, node.node) {
 			uint64_t discarded_events = 0, lost_packets = 0;
 
+			if (list_selection_complete(selection, matched)) {
+				break;
+			}
+			if (!list_selection_match(selection, &matched,
+					uchan->name)) {
+				continue;
+			}
+
 			if (lttng_strncpy(channels[i].name, uchan->name,
 					LTTNG_SYMBOL_NAME_LEN)) {
 				break;
@@ -376,6 +441,9 @@ static ssize_t list_lttng_channels(enum lttng_domain_type domain,
 					uchan->monitor_timer_interval;
 			chan_exts[i].blocking_timeout =
 				uchan->attr.u.s.blocking_timeout;
+			chan_exts[i].writeback_window_size =
+				uchan->writeback_window_size;
+			chan_exts[i].direct_io = uchan->direct_io;
 
 			ret = get_ust_runtime_stats(session, uchan,
 					&discarded_events, &lost_packets);
@@ -397,7 +465,7 @@ end:
 	if (ret < 0) {
 		return -LTTNG_ERR_FATAL;
 	} else {
-		return LTTNG_OK;
+		return i;
 	}
 }
 
@@ -475,9 +543,11 @@ end:
  * Return number of events in list on success or else a negative value.
  */
 static int list_lttng_agent_events(struct agent *agt,
+		const struct cmd_list_selection *selection,
 		struct lttng_payload *payload)
 {
 	int nb_events = 0, ret = 0;
+	uint32_t matched = 0;
 	const struct agent_event *agent_event;
 	struct lttng_ht_iter iter;
 
@@ -494,6 +564,14 @@ static int list_lttng_agent_events(struct agent *agt,
 			.loglevel_type = agent_event->loglevel_type,
 		};
 
+		if (list_selection_complete(selection, matched)) {
+			break;
+		}
+		if (!list_selection_match(selection, &matched,
+				agent_event->name)) {
+			continue;
+		}
+
 		ret = lttng_strncpy(event.name, agent_event->name, sizeof(event.name));
 		if (ret) {
 			/* Internal error, invalid name. */
@@ -514,8 +592,18 @@ static int list_lttng_agent_events(struct agent *agt,
 		nb_events++;
 	}
 
+	/* Extended infos follow the events, in the same order. */
+	matched = 0;
 	cds_lfht_for_each_entry (
 		agt->events->ht, &iter.iter, agent_event, node.node) {
+		if (list_selection_complete(selection, matched)) {
+			break;
+		}
+		if (!list_selection_match(selection, &matched,
+				agent_event->name)) {
+			continue;
+		}
+
 		/* Append extended info. */
 		ret = append_extended_info(agent_event->filter_expression, NULL,
 				NULL, payload);
@@ -537,10 +625,12 @@ end:
  */
 static int list_lttng_ust_global_events(char *channel_name,
 		struct ltt_ust_domain_global *ust_global,
+		const struct cmd_list_selection *selection,
 		struct lttng_payload *payload)
 {
 	int ret = 0;
 	unsigned int nb_events = 0;
+	uint32_t matched = 0;
 	struct lttng_ht_iter iter;
 	const struct lttng_ht_node_str *node;
 	const struct ltt_ust_channel *uchan;
@@ -567,6 +657,13 @@ static int list_lttng_ust_global_events(char *channel_name,
 		if (uevent->internal) {
 			continue;
 		}
+		if (list_selection_complete(selection, matched)) {
+			break;
+		}
+		if (!list_selection_match(selection, &matched,
+				uevent->attr.name)) {
+			continue;
+		}
 
 		ret = lttng_strncpy(event.name, uevent->attr.name, sizeof(event.name));
 		if (ret) {
@@ -622,7 +719,20 @@ static int list_lttng_ust_global_events(char *channel_name,
 		nb_events++;
 	}
 
+	/* Extended infos follow the events, in the same order. */
+	matched = 0;
 	cds_lfht_for_each_entry(uchan->events->ht, &iter.iter, uevent, node.node) {
+		if (uevent->internal) {
+			continue;
+		}
+		if (list_selection_complete(selection, matched)) {
+			break;
+		}
+		if (!list_selection_match(selection, &matched,
+				uevent->attr.name)) {
+			continue;
+		}
+
 		/* Append extended info. */
 		ret = append_extended_info(uevent->filter_expression,
 				uevent->exclusion, NULL, payload);
@@ -644,10 +754,12 @@ end:
  */
 static int list_lttng_kernel_events(char *channel_name,
 		struct ltt_kernel_session *kernel_session,
+		const struct cmd_list_selection *selection,
 		struct lttng_payload *payload)
 {
 	int ret;
-	unsigned int nb_event;
+	unsigned int nb_event = 0;
+	uint32_t matched = 0;
 	const struct ltt_kernel_event *kevent;
 	const struct ltt_kernel_channel *kchan;
 
@@ -657,14 +769,20 @@ static int list_lttng_kernel_events(char *channel_name,
 		goto error;
 	}
 
-	nb_event = kchan->event_count;
-
 	DBG("Listing events for channel %s", kchan->channel->name);
 
 	/* Kernel channels */
 	cds_list_for_each_entry(kevent, &kchan->events_list.head , list) {
 		struct lttng_event event = {};
 
+		if (list_selection_complete(selection, matched)) {
+			break;
+		}
+		if (!list_selection_match(selection, &matched,
+				kevent->event->name)) {
+			continue;
+		}
+
 		ret = lttng_strncpy(event.name, kevent->event->name, sizeof(event.name));
 		if (ret) {
 			/* Internal error, invalid name. */
@@ -720,9 +838,20 @@ static int list_lttng_kernel_events(char *channel_name,
 			ret = -LTTNG_ERR_NOMEM;
 			goto end;
 		}
+		nb_event++;
 	}
 
+	/* Extended infos follow the events, in the same order. */
+	matched = 0;
 	cds_list_for_each_entry(kevent, &kchan->events_list.head , list) {
+		if (list_selection_complete(selection, matched)) {
+			break;
+		}
+		if (!list_selection_match(selection, &matched,
+				kevent->event->name)) {
+			continue;
+		}
+
 		/* Append extended info. */
 		ret = append_extended_info(kevent->filter_expression, NULL,
 				kevent->userspace_probe_location, payload);
@@ -1088,10 +1217,36 @@ error:
 	return status;
 }
 
+/*
+ * Announce a live session with a local output to the consumers of a domain so
+ * that they serve it on their local live endpoint.
+ */
+static int setup_local_live(struct ltt_session *session,
+		struct consumer_output *consumer)
+{
+	int ret;
+	struct consumer_socket *socket;
+	struct lttng_ht_iter iter;
+
+	cds_lfht_for_each_entry(consumer->socks->ht, &iter.iter, socket,
+			node.node) {
+		ret = consumer_send_add_live_session(socket, session->id,
+				session->name, session->hostname,
+				session->live_timer);
+		if (ret < 0) {
+			return LTTNG_ERR_UNK;
+		}
+	}
+	return LTTNG_OK;
+}
+
 /*
  * Setup relayd connections for a tracing session. First creates the socket to
  * the relayd and send them to the right domain consumer. Consumer type MUST be
  * network.
+ *
+ * The consumers of live sessions with a local output are told about the
+ * session instead.
  */
 int cmd_setup_relayd(struct ltt_session *session)
 {
@@ -1180,6 +1335,24 @@ int cmd_setup_relayd(struct ltt_session *session)
 			ksess->consumer->relay_allows_clear;
 	}
 
+	if (session->live_timer && usess && usess->consumer &&
+			usess->consumer->type == CONSUMER_DST_LOCAL &&
+			usess->consumer->enabled) {
+		ret = setup_local_live(session, usess->consumer);
+		if (ret != LTTNG_OK) {
+			goto error;
+		}
+	}
+
+	if (session->live_timer && ksess && ksess->consumer &&
+			ksess->consumer->type == CONSUMER_DST_LOCAL &&
+			ksess->consumer->enabled) {
+		ret = setup_local_live(session, ksess->consumer);
+		if (ret != LTTNG_OK) {
+			goto error;
+		}
+	}
+
 error:
 	rcu_read_unlock();
 	return ret;
@@ -1394,6 +1567,12 @@ int cmd_enable_channel(struct ltt_session *session,
 		goto error;
 	}
 
+	if (config.apply_channel_advice &&
+			(domain->type == LTTNG_DOMAIN_KERNEL ||
+			 domain->type == LTTNG_DOMAIN_UST)) {
+		channel_advisor_apply(session->uid, domain->type, &attr);
+	}
+
 	/*
 	 * If the session is a live session, remove the switch timer, the
 	 * live timer does the same thing but sends also synchronisation
@@ -2074,6 +2253,137 @@ end:
 	return ret;
 }
 
+/*
+ * Look up the kernel channel an event is enabled on, creating it with the
+ * default attributes if it does not exist yet.
+ *
+ * Return LTTNG_OK on success, else an LTTng error code.
+ */
+static enum lttng_error_code get_or_create_kernel_channel(
+		struct ltt_session *session, const struct lttng_domain *domain,
+		const char *channel_name, int wpipe,
+		struct ltt_kernel_channel **_kchan, bool *created)
+{
+	int ret;
+	struct lttng_channel *attr = NULL;
+	struct ltt_kernel_channel *kchan;
+
+	*created = false;
+
+	/*
+	 * If a non-default channel has been created in the
+	 * session, explicitely require that -c chan_name needs
+	 * to be provided.
+	 */
+	if (session->kernel_session->has_non_default_channel
+			&& channel_name[0] == '\0') {
+		ret = LTTNG_ERR_NEED_CHANNEL_NAME;
+		goto end;
+	}
+
+	kchan = trace_kernel_get_channel_by_name(channel_name,
+			session->kernel_session);
+	if (kchan == NULL) {
+		attr = channel_new_default_attr(LTTNG_DOMAIN_KERNEL,
+				LTTNG_BUFFER_GLOBAL);
+		if (attr == NULL) {
+			ret = LTTNG_ERR_FATAL;
+			goto end;
+		}
+		if (lttng_strncpy(attr->name, channel_name,
+				sizeof(attr->name))) {
+			ret = LTTNG_ERR_INVALID;
+			goto end;
+		}
+		if (session->consumer->tee_path[0]) {
+			/* The local copy requires the mmap output. */
+			attr->attr.output = LTTNG_EVENT_MMAP;
+		}
+
+		ret = cmd_enable_channel(session, domain, attr, wpipe);
+		if (ret != LTTNG_OK) {
+			goto end;
+		}
+		*created = true;
+
+		/* Get the newly created kernel channel pointer */
+		kchan = trace_kernel_get_channel_by_name(channel_name,
+				session->kernel_session);
+		if (kchan == NULL) {
+			/* This sould not happen... */
+			ret = LTTNG_ERR_FATAL;
+			goto end;
+		}
+	}
+
+	*_kchan = kchan;
+	ret = LTTNG_OK;
+end:
+	channel_attr_destroy(attr);
+	return ret;
+}
+
+/*
+ * Look up the UST channel an event is enabled on, creating it with the
+ * default attributes if it does not exist yet.
+ *
+ * Return LTTNG_OK on success, else an LTTng error code.
+ */
+static enum lttng_error_code get_or_create_ust_channel(
+		struct ltt_session *session, const struct lttng_domain *domain,
+		const char *channel_name, int wpipe,
+		struct ltt_ust_channel **_uchan)
+{
+	int ret;
+	struct lttng_channel *attr = NULL;
+	struct ltt_ust_channel *uchan;
+	struct ltt_ust_session *usess = session->ust_session;
+
+	/*
+	 * If a non-default channel has been created in the
+	 * session, explicitely require that -c chan_name needs
+	 * to be provided.
+	 */
+	if (usess->has_non_default_channel && channel_name[0] == '\0') {
+		ret = LTTNG_ERR_NEED_CHANNEL_NAME;
+		goto end;
+	}
+
+	/* Get channel from global UST domain */
+	uchan = trace_ust_find_channel_by_name(usess->domain_global.channels,
+			channel_name);
+	if (uchan == NULL) {
+		/* Create default channel */
+		attr = channel_new_default_attr(LTTNG_DOMAIN_UST,
+				usess->buffer_type);
+		if (attr == NULL) {
+			ret = LTTNG_ERR_FATAL;
+			goto end;
+		}
+		if (lttng_strncpy(attr->name, channel_name,
+				sizeof(attr->name))) {
+			ret = LTTNG_ERR_INVALID;
+			goto end;
+		}
+
+		ret = cmd_enable_channel(session, domain, attr, wpipe);
+		if (ret != LTTNG_OK) {
+			goto end;
+		}
+
+		/* Get the newly created channel reference back */
+		uchan = trace_ust_find_channel_by_name(
+				usess->domain_global.channels, channel_name);
+		assert(uchan);
+	}
+
+	*_uchan = uchan;
+	ret = LTTNG_OK;
+end:
+	channel_attr_destroy(attr);
+	return ret;
+}
+
 /*
  * Internal version of cmd_enable_event() with a supplemental
  * "internal_event" flag which is used to enable internal events which should
@@ -2088,8 +2398,8 @@ static int _cmd_enable_event(struct ltt_session *session,
 		struct lttng_event_exclusion *exclusion,
 		int wpipe, bool internal_event)
 {
-	int ret = 0, channel_created = 0;
-	struct lttng_channel *attr = NULL;
+	int ret = 0;
+	bool channel_created = false;
 
 	assert(session);
 	assert(event);
@@ -2121,45 +2431,9 @@ static int _cmd_enable_event(struct ltt_session *session,
 	{
 		struct ltt_kernel_channel *kchan;
 
-		/*
-		 * If a non-default channel has been created in the
-		 * session, explicitely require that -c chan_name needs
-		 * to be provided.
-		 */
-		if (session->kernel_session->has_non_default_channel
-				&& channel_name[0] == '\0') {
-			ret = LTTNG_ERR_NEED_CHANNEL_NAME;
-			goto error;
-		}
-
-		kchan = trace_kernel_get_channel_by_name(channel_name,
-				session->kernel_session);
-		if (kchan == NULL) {
-			attr = channel_new_default_attr(LTTNG_DOMAIN_KERNEL,
-					LTTNG_BUFFER_GLOBAL);
-			if (attr == NULL) {
-				ret = LTTNG_ERR_FATAL;
-				goto error;
-			}
-			if (lttng_strncpy(attr->name, channel_name,
-					sizeof(attr->name))) {
-				ret = LTTNG_ERR_INVALID;
-				goto error;
-			}
-
-			ret = cmd_enable_channel(session, domain, attr, wpipe);
-			if (ret != LTTNG_OK) {
-				goto error;
-			}
-			channel_created = 1;
-		}
-
-		/* Get the newly created kernel channel pointer */
-		kchan = trace_kernel_get_channel_by_name(channel_name,
-				session->kernel_session);
-		if (kchan == NULL) {
-			/* This sould not happen... */
-			ret = LTTNG_ERR_FATAL;
+		ret = get_or_create_kernel_channel(session, domain,
+				channel_name, wpipe, &kchan, &channel_created);
+		if (ret != LTTNG_OK) {
 			goto error;
 		}
 
@@ -2259,44 +2533,12 @@ static int _cmd_enable_event(struct ltt_session *session,
 
 		assert(usess);
 
-		/*
-		 * If a non-default channel has been created in the
-		 * session, explicitely require that -c chan_name needs
-		 * to be provided.
-		 */
-		if (usess->has_non_default_channel && channel_name[0] == '\0') {
-			ret = LTTNG_ERR_NEED_CHANNEL_NAME;
+		ret = get_or_create_ust_channel(session, domain, channel_name,
+				wpipe, &uchan);
+		if (ret != LTTNG_OK) {
 			goto error;
 		}
 
-		/* Get channel from global UST domain */
-		uchan = trace_ust_find_channel_by_name(usess->domain_global.channels,
-				channel_name);
-		if (uchan == NULL) {
-			/* Create default channel */
-			attr = channel_new_default_attr(LTTNG_DOMAIN_UST,
-					usess->buffer_type);
-			if (attr == NULL) {
-				ret = LTTNG_ERR_FATAL;
-				goto error;
-			}
-			if (lttng_strncpy(attr->name, channel_name,
-					sizeof(attr->name))) {
-				ret = LTTNG_ERR_INVALID;
-				goto error;
-			}
-
-			ret = cmd_enable_channel(session, domain, attr, wpipe);
-			if (ret != LTTNG_OK) {
-				goto error;
-			}
-
-			/* Get the newly created channel reference back */
-			uchan = trace_ust_find_channel_by_name(
-					usess->domain_global.channels, channel_name);
-			assert(uchan);
-		}
-
 		if (uchan->domain != LTTNG_DOMAIN_UST && !internal_event) {
 			/*
 			 * Don't allow users to add UST events to channels which
@@ -2469,7 +2711,6 @@ error:
 	free(filter_expression);
 	free(filter);
 	free(exclusion);
-	channel_attr_destroy(attr);
 	rcu_read_unlock();
 	return ret;
 }
@@ -2491,41 +2732,203 @@ int cmd_enable_event(struct ltt_session *session,
 }
 
 /*
- * Enable an event which is internal to LTTng. An internal should
- * never be made visible to clients and are immune to checks such as
- * reserved names.
+ * Enable a set of kernel events, without filter, on a channel. The tracer is
+ * waited on once for the whole set.
  */
-static int cmd_enable_event_internal(struct ltt_session *session,
-		const struct lttng_domain *domain,
-		char *channel_name, struct lttng_event *event,
-		char *filter_expression,
-		struct lttng_bytecode *filter,
-		struct lttng_event_exclusion *exclusion,
-		int wpipe)
+static void enable_kernel_events(struct ltt_kernel_channel *kchan,
+		struct lttng_event *events, unsigned int event_count,
+		enum lttng_error_code *ret_codes)
 {
-	return _cmd_enable_event(session, domain, channel_name, event,
-			filter_expression, filter, exclusion, wpipe, true);
-}
+	unsigned int i;
 
-/*
- * Command LTTNG_LIST_TRACEPOINTS processed by the client thread.
- */
-ssize_t cmd_list_tracepoints(enum lttng_domain_type domain,
-		struct lttng_event **events)
-{
-	int ret;
-	ssize_t nb_events = 0;
+	for (i = 0; i < event_count; i++) {
+		struct lttng_event *event = &events[i];
 
-	switch (domain) {
-	case LTTNG_DOMAIN_KERNEL:
-		nb_events = kernel_list_events(events);
-		if (nb_events < 0) {
-			ret = LTTNG_ERR_KERN_LIST_FAIL;
-			goto error;
-		}
-		break;
-	case LTTNG_DOMAIN_UST:
-		nb_events = ust_app_list_events(events);
+		strutils_normalize_star_glob_pattern(event->name);
+
+		switch (event->type) {
+		case LTTNG_EVENT_ALL:
+			event->type = LTTNG_EVENT_TRACEPOINT;	/* Hack */
+			ret_codes[i] = event_kernel_enable_event(kchan, event,
+					NULL, NULL);
+			if (ret_codes[i] != LTTNG_OK) {
+				break;
+			}
+			event->type = LTTNG_EVENT_SYSCALL;	/* Hack */
+			ret_codes[i] = event_kernel_enable_event(kchan, event,
+					NULL, NULL);
+			break;
+		case LTTNG_EVENT_PROBE:
+		case LTTNG_EVENT_FUNCTION:
+		case LTTNG_EVENT_FUNCTION_ENTRY:
+		case LTTNG_EVENT_TRACEPOINT:
+		case LTTNG_EVENT_SYSCALL:
+			ret_codes[i] = event_kernel_enable_event(kchan, event,
+					NULL, NULL);
+			break;
+		case LTTNG_EVENT_USERSPACE_PROBE:
+			/* The probe location is not part of the event. */
+			ret_codes[i] = LTTNG_ERR_INVALID;
+			break;
+		default:
+			ret_codes[i] = LTTNG_ERR_UNK;
+			break;
+		}
+	}
+
+	kernel_wait_quiescent();
+}
+
+/*
+ * Command LTTNG_ENABLE_EVENTS processed by the client thread.
+ *
+ * Kernel and UST events are enabled on the session first and the tracers are
+ * then updated once for the whole set. The outcome of each event is stored in
+ * ret_codes. Agent events are not supported since they need the logger name
+ * and log level filter built by the client for each of them.
+ *
+ * Return LTTNG_OK if the set was processed, else an LTTng error code that
+ * applies to all the events.
+ */
+int cmd_enable_events(struct ltt_session *session,
+		const struct lttng_domain *domain,
+		char *channel_name, struct lttng_event *events,
+		unsigned int event_count, enum lttng_error_code *ret_codes,
+		int wpipe)
+{
+	int ret;
+	unsigned int i;
+
+	assert(session);
+	assert(events);
+	assert(ret_codes);
+	assert(channel_name);
+
+	DBG("Enable events command for %u events", event_count);
+
+	rcu_read_lock();
+
+	switch (domain->type) {
+	case LTTNG_DOMAIN_KERNEL:
+	{
+		bool channel_created;
+		struct ltt_kernel_channel *kchan;
+
+		ret = get_or_create_kernel_channel(session, domain,
+				channel_name, wpipe, &kchan, &channel_created);
+		if (ret != LTTNG_OK) {
+			goto error;
+		}
+
+		enable_kernel_events(kchan, events, event_count, ret_codes);
+
+		if (channel_created) {
+			for (i = 0; i < event_count; i++) {
+				if (ret_codes[i] == LTTNG_OK) {
+					break;
+				}
+			}
+			if (i == event_count) {
+				/* Let's not leak a useless channel. */
+				kernel_destroy_channel(kchan);
+			}
+		}
+		break;
+	}
+	case LTTNG_DOMAIN_UST:
+	{
+		struct ltt_ust_channel *uchan;
+
+		assert(session->ust_session);
+
+		ret = get_or_create_ust_channel(session, domain, channel_name,
+				wpipe, &uchan);
+		if (ret != LTTNG_OK) {
+			goto error;
+		}
+
+		if (uchan->domain != LTTNG_DOMAIN_UST) {
+			/*
+			 * Don't allow users to add UST events to channels which
+			 * are assigned to a userspace subdomain (JUL, Log4J,
+			 * Python, etc.).
+			 */
+			ret = LTTNG_ERR_INVALID_CHANNEL_DOMAIN;
+			goto error;
+		}
+
+		for (i = 0; i < event_count; i++) {
+			struct lttng_event *event = &events[i];
+
+			/* Normalize event name as a globbing pattern */
+			strutils_normalize_star_glob_pattern(event->name);
+			/*
+			 * Ensure the event name is not reserved for internal
+			 * use.
+			 */
+			if (validate_ust_event_name(event->name)) {
+				WARN("Userspace event name %s failed validation.",
+						event->name);
+				ret_codes[i] = LTTNG_ERR_INVALID_EVENT_NAME;
+			} else {
+				ret_codes[i] = LTTNG_OK;
+			}
+		}
+
+		ret = event_ust_enable_tracepoints(session->ust_session, uchan,
+				events, event_count, ret_codes);
+		if (ret != LTTNG_OK) {
+			goto error;
+		}
+		break;
+	}
+	default:
+		ret = LTTNG_ERR_UND;
+		goto error;
+	}
+
+	ret = LTTNG_OK;
+error:
+	rcu_read_unlock();
+	return ret;
+}
+
+/*
+ * Enable an event which is internal to LTTng. An internal should
+ * never be made visible to clients and are immune to checks such as
+ * reserved names.
+ */
+static int cmd_enable_event_internal(struct ltt_session *session,
+		const struct lttng_domain *domain,
+		char *channel_name, struct lttng_event *event,
+		char *filter_expression,
+		struct lttng_bytecode *filter,
+		struct lttng_event_exclusion *exclusion,
+		int wpipe)
+{
+	return _cmd_enable_event(session, domain, channel_name, event,
+			filter_expression, filter, exclusion, wpipe, true);
+}
+
+/*
+ * Command LTTNG_LIST_TRACEPOINTS processed by the client thread.
+ */
+ssize_t cmd_list_tracepoints(enum lttng_domain_type domain,
+		struct lttng_event **events)
+{
+	int ret;
+	ssize_t nb_events = 0;
+
+	switch (domain) {
+	case LTTNG_DOMAIN_KERNEL:
+		nb_events = kernel_list_events(events);
+		if (nb_events < 0) {
+			ret = LTTNG_ERR_KERN_LIST_FAIL;
+			goto error;
+		}
+		break;
+	case LTTNG_DOMAIN_UST:
+		nb_events = ust_app_list_events(events);
 		if (nb_events < 0) {
 			ret = LTTNG_ERR_UST_LIST_FAIL;
 			goto error;
@@ -2708,6 +3111,11 @@ int cmd_start_trace(struct ltt_session *session)
 			ret = LTTNG_ERR_UST_START_FAIL;
 			goto error;
 		}
+
+		/* Prepare the buffers of the applications to come. */
+		rcu_read_lock();
+		ust_buffer_pool_fill(usess);
+		rcu_read_unlock();
 	}
 
 	/*
@@ -3078,6 +3486,15 @@ enum lttng_error_code cmd_create_session_from_descriptor(
 	if (ret_code != LTTNG_OK) {
 		goto end;
 	}
+
+	/* Without a live URL, nothing serves the session to live viewers. */
+	if (new_session->live_timer &&
+			new_session->consumer->type == CONSUMER_DST_LOCAL &&
+			!sessiond_config_has_live_url(&config,
+					LTTNG_DOMAIN_NONE)) {
+		ret_code = LTTNG_ERR_LIVE_LOCAL_NO_URL;
+		goto end;
+	}
 	new_session->consumer->enabled = 1;
 	ret_code = LTTNG_OK;
 end:
@@ -3263,6 +3680,128 @@ error:
 	free(_reply_context);
 }
 
+static enum lttng_error_code get_channel_advice(struct ltt_session *session,
+		enum lttng_domain_type domain, const char *channel_name,
+		struct lttng_channel_advice *advice)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	struct channel_advisor_input input = {
+		.domain = domain,
+		.live = session->live_timer > 0,
+		.max_buffer_size = config.channel_advice_max_buffer_size,
+	};
+
+	rcu_read_lock();
+	switch (domain) {
+	case LTTNG_DOMAIN_KERNEL:
+	{
+		struct ltt_kernel_channel *kchan = NULL;
+
+		if (session->kernel_session) {
+			kchan = trace_kernel_get_channel_by_name(channel_name,
+					session->kernel_session);
+		}
+		if (!kchan) {
+			ret_code = LTTNG_ERR_KERN_CHAN_NOT_FOUND;
+			goto end_unlock;
+		}
+
+		input.overwrite = kchan->channel->attr.overwrite;
+		input.subbuf_size = kchan->channel->attr.subbuf_size;
+		input.num_subbuf = kchan->channel->attr.num_subbuf;
+		input.switch_timer_interval =
+				kchan->channel->attr.switch_timer_interval;
+		ret = get_kernel_runtime_stats(session, kchan,
+				&input.discarded_events, &input.lost_packets);
+		break;
+	}
+	case LTTNG_DOMAIN_UST:
+	{
+		struct ltt_ust_channel *uchan = NULL;
+
+		if (session->ust_session) {
+			uchan = trace_ust_find_channel_by_name(
+					session->ust_session->domain_global.channels,
+					channel_name);
+		}
+		if (!uchan) {
+			ret_code = LTTNG_ERR_UST_CHAN_NOT_FOUND;
+			goto end_unlock;
+		}
+
+		input.overwrite = uchan->attr.overwrite;
+		input.subbuf_size = uchan->attr.subbuf_size;
+		input.num_subbuf = uchan->attr.num_subbuf;
+		input.switch_timer_interval = uchan->attr.switch_timer_interval;
+		ret = get_ust_runtime_stats(session, uchan,
+				&input.discarded_events, &input.lost_packets);
+		break;
+	}
+	default:
+		ret_code = LTTNG_ERR_UNKNOWN_DOMAIN;
+		goto end_unlock;
+	}
+	rcu_read_unlock();
+	if (ret < 0) {
+		ret_code = LTTNG_ERR_FATAL;
+		goto end;
+	}
+
+	ret_code = notification_thread_command_get_channel_throughput(
+			notification_thread_handle, session->name, domain,
+			channel_name, &input.throughput);
+	if (ret_code == LTTNG_ERR_CHAN_NOT_FOUND) {
+		/* Not sampled: no monitor timer or per-PID buffers. */
+		memset(&input.throughput, 0, sizeof(input.throughput));
+	} else if (ret_code != LTTNG_OK) {
+		goto end;
+	}
+
+	channel_advisor_compute(&input, advice);
+	channel_advisor_record(session->uid, domain, channel_name, advice);
+	ret_code = LTTNG_OK;
+	goto end;
+end_unlock:
+	rcu_read_unlock();
+end:
+	return ret_code;
+}
+
+/*
+ * Remember the geometry advised for the channels of a session being
+ * destroyed, for the channels of the same name created afterwards.
+ */
+static void record_channel_advice(struct ltt_session *session)
+{
+	struct lttng_channel_advice advice;
+
+	if (session->kernel_session) {
+		struct ltt_kernel_channel *kchan;
+
+		cds_list_for_each_entry(kchan,
+				&session->kernel_session->channel_list.head,
+				list) {
+			(void) get_channel_advice(session, LTTNG_DOMAIN_KERNEL,
+					kchan->channel->name, &advice);
+		}
+	}
+
+	if (session->ust_session) {
+		struct lttng_ht_iter iter;
+		struct ltt_ust_channel *uchan;
+
+		rcu_read_lock();
+		cds_lfht_for_each_entry(
+				session->ust_session->domain_global.channels->ht,
+				&iter.iter, uchan, node.node) {
+			(void) get_channel_advice(session, LTTNG_DOMAIN_UST,
+					uchan->name, &advice);
+		}
+		rcu_read_unlock();
+	}
+}
+
 /*
  * Command LTTNG_DESTROY_SESSION processed by the client thread.
  *
@@ -3302,6 +3841,10 @@ int cmd_destroy_session(struct ltt_session *session,
 		}
 	}
 
+	if (config.apply_channel_advice) {
+		record_channel_advice(session);
+	}
+
 	if (session->rotation_schedule_timer_enabled) {
 		if (timer_session_rotation_schedule_timer_stop(
 				session)) {
@@ -3311,6 +3854,14 @@ int cmd_destroy_session(struct ltt_session *session,
 		}
 	}
 
+	if (session->snapshot_relayd_idle_timer_enabled) {
+		if (timer_session_snapshot_relayd_idle_timer_stop(session)) {
+			ERR("Failed to stop the \"snapshot relayd idle check\" timer of session %s",
+					session->name);
+			destruction_last_error = LTTNG_ERR_TIMER_STOP_ERROR;
+		}
+	}
+
 	if (session->rotate_size) {
 		unsubscribe_session_consumed_size_rotation(session, notification_thread_handle);
 		session->rotate_size = 0;
@@ -3592,7 +4143,9 @@ error:
  * Command LTTNG_LIST_CHANNELS processed by the client thread.
  */
 ssize_t cmd_list_channels(enum lttng_domain_type domain,
-		struct ltt_session *session, struct lttng_channel **channels)
+		struct ltt_session *session,
+		const struct cmd_list_selection *selection,
+		struct lttng_channel **channels)
 {
 	ssize_t nb_chan = 0, payload_size = 0, ret;
 
@@ -3629,9 +4182,10 @@ ssize_t cmd_list_channels(enum lttng_domain_type domain,
 		const size_t channel_size = sizeof(struct lttng_channel) +
 			sizeof(struct lttng_channel_extended);
 		struct lttng_channel_extended *channel_exts;
+		ssize_t nb_listed;
 
-		payload_size = nb_chan * channel_size;
-		*channels = zmalloc(payload_size);
+		/* Room for all channels; the selection may list fewer. */
+		*channels = zmalloc(nb_chan * channel_size);
 		if (*channels == NULL) {
 			ret = -LTTNG_ERR_FATAL;
 			goto end;
@@ -3639,12 +4193,21 @@ ssize_t cmd_list_channels(enum lttng_domain_type domain,
 
 		channel_exts = ((void *) *channels) +
 				(nb_chan * sizeof(struct lttng_channel));
-		ret = list_lttng_channels(domain, session, *channels, channel_exts);
-		if (ret != LTTNG_OK) {
+		nb_listed = list_lttng_channels(domain, session, selection,
+				*channels, channel_exts);
+		if (nb_listed < 0) {
 			free(*channels);
 			*channels = NULL;
+			ret = nb_listed;
 			goto end;
 		}
+
+		/* The extended infos must immediately follow the channels. */
+		memmove(((void *) *channels) +
+					(nb_listed * sizeof(struct lttng_channel)),
+				channel_exts,
+				nb_listed * sizeof(struct lttng_channel_extended));
+		payload_size = nb_listed * channel_size;
 	} else {
 		*channels = NULL;
 	}
@@ -3659,6 +4222,7 @@ end:
  */
 ssize_t cmd_list_events(enum lttng_domain_type domain,
 		struct ltt_session *session, char *channel_name,
+		const struct cmd_list_selection *selection,
 		struct lttng_payload *payload)
 {
 	int ret = 0;
@@ -3677,7 +4241,8 @@ ssize_t cmd_list_events(enum lttng_domain_type domain,
 	case LTTNG_DOMAIN_KERNEL:
 		if (session->kernel_session != NULL) {
 			nb_events = list_lttng_kernel_events(channel_name,
-					session->kernel_session, payload);
+					session->kernel_session, selection,
+					payload);
 		}
 		break;
 	case LTTNG_DOMAIN_UST:
@@ -3685,7 +4250,7 @@ ssize_t cmd_list_events(enum lttng_domain_type domain,
 		if (session->ust_session != NULL) {
 			nb_events = list_lttng_ust_global_events(channel_name,
 					&session->ust_session->domain_global,
-					payload);
+					selection, payload);
 		}
 		break;
 	}
@@ -3701,7 +4266,7 @@ ssize_t cmd_list_events(enum lttng_domain_type domain,
 					&iter.iter, agt, node.node) {
 				if (agt->domain == domain) {
 					nb_events = list_lttng_agent_events(
-							agt, payload);
+							agt, selection, payload);
 					break;
 				}
 			}
@@ -3831,6 +4396,17 @@ int cmd_data_pending(struct ltt_session *session)
 		goto error;
 	}
 
+	/*
+	 * The buffers of this session held by applications that have exited
+	 * may not be flushed yet, we have to wait.
+	 */
+	if (usess && reap_apps_pending(usess->id)) {
+		DBG("Application teardown still pending for session %s",
+				session->name);
+		ret = 1;
+		goto error;
+	}
+
 	if (ksess && ksess->consumer) {
 		ret = consumer_is_data_pending(ksess->id, ksess->consumer);
 		if (ret == 1) {
@@ -4622,6 +5198,64 @@ end:
 	lttng_triggers_destroy(triggers);
 	return ret;
 }
+
+/*
+ * Command LTTNG_GET_CHANNEL_ADVICE processed by the client thread.
+ */
+enum lttng_error_code cmd_get_channel_advice(struct ltt_session *session,
+		enum lttng_domain_type domain, const char *channel_name,
+		struct lttng_channel_advice *advice)
+{
+	return get_channel_advice(session, domain, channel_name, advice);
+}
+
+/*
+ * Command LTTNG_LIST_COUNTER_MAP processed by the client thread.
+ */
+enum lttng_error_code cmd_list_counter_map(struct command_ctx *cmd_ctx,
+		struct notification_thread_handle *notification_thread,
+		const char *map_name,
+		struct lttng_counter_map_values **return_values)
+{
+	enum lttng_error_code ret_code;
+	struct lttng_triggers *triggers = NULL;
+
+	/* The triggers report the notifications discarded by the tracers. */
+	ret_code = notification_thread_command_list_triggers(
+			notification_thread, cmd_ctx->creds.uid, &triggers);
+	if (ret_code != LTTNG_OK) {
+		goto end;
+	}
+
+	ret_code = counter_map_list_values(cmd_ctx->creds.uid, map_name,
+			triggers, return_values);
+end:
+	lttng_triggers_destroy(triggers);
+	return ret_code;
+}
+
+/*
+ * Command LTTNG_CLEAR_COUNTER_MAP processed by the client thread.
+ */
+enum lttng_error_code cmd_clear_counter_map(struct command_ctx *cmd_ctx,
+		struct notification_thread_handle *notification_thread,
+		const char *map_name)
+{
+	enum lttng_error_code ret_code;
+	struct lttng_triggers *triggers = NULL;
+
+	ret_code = notification_thread_command_list_triggers(
+			notification_thread, cmd_ctx->creds.uid, &triggers);
+	if (ret_code != LTTNG_OK) {
+		goto end;
+	}
+
+	ret_code = counter_map_clear(cmd_ctx->creds.uid, map_name, triggers);
+end:
+	lttng_triggers_destroy(triggers);
+	return ret_code;
+}
+
 /*
  * Send relayd sockets from snapshot output to consumer. Ignore request if the
  * snapshot output is *not* set with a remote destination.
@@ -4701,6 +5335,74 @@ error:
 	return status;
 }
 
+/*
+ * Get the consumer output of a tracer domain through which a snapshot is
+ * recorded and connect it to the relay daemon if the snapshot output is
+ * remote.
+ *
+ * When relayd_consumer is not NULL, the relay daemon connections of the
+ * snapshot output are kept open between snapshots: the consumer output
+ * holding them is saved in relayd_consumer and reused by the following
+ * snapshots, which then only ship data.
+ *
+ * Return LTTNG_OK on success or a LTTNG_ERR code.
+ */
+static enum lttng_error_code get_snapshot_consumer_output(
+		const struct ltt_session *session,
+		const struct snapshot_output *snapshot_output,
+		struct consumer_output *session_consumer_output,
+		const char *chunk_name,
+		struct consumer_output **relayd_consumer,
+		struct consumer_output **_output)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	struct consumer_output *output;
+
+	if (relayd_consumer && *relayd_consumer) {
+		DBG("Reusing relayd connections of snapshot output \"%s\"",
+				snapshot_output->name);
+		output = *relayd_consumer;
+		consumer_output_get(output);
+	} else {
+		output = consumer_copy_output(snapshot_output->consumer);
+		if (!output) {
+			ERR("Failed to copy consumer output of snapshot output configuration");
+			ret_code = LTTNG_ERR_NOMEM;
+			goto error;
+		}
+
+		ret = consumer_copy_sockets(output, session_consumer_output);
+		if (ret < 0) {
+			ERR("Failed to copy consumer sockets from snapshot output configuration");
+			ret_code = LTTNG_ERR_NOMEM;
+			goto error_put;
+		}
+	}
+
+	strcpy(output->chunk_path, chunk_name);
+
+	/* Only connects the consumer sockets that were not sent yet. */
+	ret_code = set_relayd_for_snapshot(output, session);
+	if (ret_code != LTTNG_OK) {
+		goto error_put;
+	}
+
+	if (relayd_consumer && !*relayd_consumer &&
+			output->type == CONSUMER_DST_NET) {
+		consumer_output_get(output);
+		*relayd_consumer = output;
+	}
+
+	*_output = output;
+	return LTTNG_OK;
+
+error_put:
+	consumer_output_put(output);
+error:
+	return ret_code;
+}
+
 /*
  * Record a kernel snapshot.
  *
@@ -4710,7 +5412,8 @@ static enum lttng_error_code record_kernel_snapshot(
 		struct ltt_kernel_session *ksess,
 		const struct consumer_output *output,
 		const struct ltt_session *session,
-		int wait, uint64_t nb_packets_per_stream)
+		int wait, uint64_t nb_packets_per_stream,
+		const struct snapshot_scope *scope)
 {
 	enum lttng_error_code status;
 
@@ -4719,7 +5422,7 @@ static enum lttng_error_code record_kernel_snapshot(
 	assert(session);
 
 	status = kernel_snapshot_record(
-			ksess, output, wait, nb_packets_per_stream);
+			ksess, output, wait, nb_packets_per_stream, scope);
 	return status;
 }
 
@@ -4731,7 +5434,8 @@ static enum lttng_error_code record_kernel_snapshot(
 static enum lttng_error_code record_ust_snapshot(struct ltt_ust_session *usess,
 		const struct consumer_output *output,
 		const struct ltt_session *session,
-		int wait, uint64_t nb_packets_per_stream)
+		int wait, uint64_t nb_packets_per_stream,
+		const struct snapshot_scope *scope)
 {
 	enum lttng_error_code status;
 
@@ -4740,13 +5444,14 @@ static enum lttng_error_code record_ust_snapshot(struct ltt_ust_session *usess,
 	assert(session);
 
 	status = ust_app_snapshot_record(
-			usess, output, wait, nb_packets_per_stream);
+			usess, output, wait, nb_packets_per_stream, scope);
 	return status;
 }
 
 static
 uint64_t get_session_size_one_more_packet_per_stream(
-		const struct ltt_session *session, uint64_t cur_nr_packets)
+		const struct ltt_session *session, uint64_t cur_nr_packets,
+		const struct snapshot_scope *scope)
 {
 	uint64_t tot_size = 0;
 
@@ -4756,6 +5461,10 @@ uint64_t get_session_size_one_more_packet_per_stream(
 				session->kernel_session;
 
 		cds_list_for_each_entry(chan, &ksess->channel_list.head, list) {
+			if (!snapshot_scope_has_channel(scope,
+					chan->channel->name)) {
+				continue;
+			}
 			if (cur_nr_packets >= chan->channel->attr.num_subbuf) {
 				/*
 				 * Don't take channel into account if we
@@ -4772,7 +5481,7 @@ uint64_t get_session_size_one_more_packet_per_stream(
 		const struct ltt_ust_session *usess = session->ust_session;
 
 		tot_size += ust_app_get_size_one_more_packet_per_stream(usess,
-				cur_nr_packets);
+				cur_nr_packets, scope);
 	}
 
 	return tot_size;
@@ -4800,7 +5509,7 @@ uint64_t get_session_size_one_more_packet_per_stream(
  */
 static
 int64_t get_session_nb_packets_per_stream(const struct ltt_session *session,
-		uint64_t max_size)
+		uint64_t max_size, const struct snapshot_scope *scope)
 {
 	int64_t size_left;
 	uint64_t cur_nb_packets = 0;
@@ -4814,7 +5523,7 @@ int64_t get_session_nb_packets_per_stream(const struct ltt_session *session,
 		uint64_t one_more_packet_tot_size;
 
 		one_more_packet_tot_size = get_session_size_one_more_packet_per_stream(
-				session, cur_nb_packets);
+				session, cur_nb_packets, scope);
 		if (!one_more_packet_tot_size) {
 			/* We are already grabbing all packets. */
 			break;
@@ -4832,9 +5541,20 @@ int64_t get_session_nb_packets_per_stream(const struct ltt_session *session,
 	return cur_nb_packets;
 }
 
+/*
+ * Attempt to record a snapshot of the session to a snapshot output.
+ *
+ * relayd holds the relay daemon connections kept open for the snapshot
+ * output, or is NULL if the connections must be closed once the snapshot
+ * is recorded (temporary output).
+ *
+ * Only the subset of the session described by scope is recorded, when set.
+ */
 static
-enum lttng_error_code snapshot_record(struct ltt_session *session,
-		const struct snapshot_output *snapshot_output, int wait)
+enum lttng_error_code _snapshot_record(struct ltt_session *session,
+		const struct snapshot_output *snapshot_output, int wait,
+		struct snapshot_output_relayd *relayd,
+		const struct snapshot_scope *scope)
 {
 	int64_t nb_packets_per_stream;
 	char snapshot_chunk_name[LTTNG_NAME_MAX];
@@ -4868,19 +5588,11 @@ enum lttng_error_code snapshot_record(struct ltt_session *session,
 	if (session->kernel_session) {
 		original_kernel_consumer_output =
 				session->kernel_session->consumer;
-		snapshot_kernel_consumer_output =
-				consumer_copy_output(snapshot_output->consumer);
-		strcpy(snapshot_kernel_consumer_output->chunk_path,
-			snapshot_chunk_name);
-		ret = consumer_copy_sockets(snapshot_kernel_consumer_output,
-				original_kernel_consumer_output);
-		if (ret < 0) {
-			ERR("Failed to copy consumer sockets from snapshot output configuration");
-			ret_code = LTTNG_ERR_NOMEM;
-			goto error;
-		}
-		ret_code = set_relayd_for_snapshot(
-				snapshot_kernel_consumer_output, session);
+		ret_code = get_snapshot_consumer_output(session,
+				snapshot_output, original_kernel_consumer_output,
+				snapshot_chunk_name,
+				relayd ? &relayd->kernel_consumer : NULL,
+				&snapshot_kernel_consumer_output);
 		if (ret_code != LTTNG_OK) {
 			ERR("Failed to setup relay daemon for kernel tracer snapshot");
 			goto error;
@@ -4890,19 +5602,11 @@ enum lttng_error_code snapshot_record(struct ltt_session *session,
 	}
 	if (session->ust_session) {
 		original_ust_consumer_output = session->ust_session->consumer;
-		snapshot_ust_consumer_output =
-				consumer_copy_output(snapshot_output->consumer);
-		strcpy(snapshot_ust_consumer_output->chunk_path,
-			snapshot_chunk_name);
-		ret = consumer_copy_sockets(snapshot_ust_consumer_output,
-				original_ust_consumer_output);
-		if (ret < 0) {
-			ERR("Failed to copy consumer sockets from snapshot output configuration");
-			ret_code = LTTNG_ERR_NOMEM;
-			goto error;
-		}
-		ret_code = set_relayd_for_snapshot(
-				snapshot_ust_consumer_output, session);
+		ret_code = get_snapshot_consumer_output(session,
+				snapshot_output, original_ust_consumer_output,
+				snapshot_chunk_name,
+				relayd ? &relayd->ust_consumer : NULL,
+				&snapshot_ust_consumer_output);
 		if (ret_code != LTTNG_OK) {
 			ERR("Failed to setup relay daemon for userspace tracer snapshot");
 			goto error;
@@ -4935,7 +5639,7 @@ enum lttng_error_code snapshot_record(struct ltt_session *session,
 	}
 
 	nb_packets_per_stream = get_session_nb_packets_per_stream(session,
-			snapshot_output->max_size);
+			snapshot_output->max_size, scope);
 	if (nb_packets_per_stream < 0) {
 		ret_code = LTTNG_ERR_MAX_SIZE_INVALID;
 		goto error_close_trace_chunk;
@@ -4944,7 +5648,7 @@ enum lttng_error_code snapshot_record(struct ltt_session *session,
 	if (session->kernel_session) {
 		ret_code = record_kernel_snapshot(session->kernel_session,
 				snapshot_kernel_consumer_output, session,
-				wait, nb_packets_per_stream);
+				wait, nb_packets_per_stream, scope);
 		if (ret_code != LTTNG_OK) {
 			goto error_close_trace_chunk;
 		}
@@ -4953,7 +5657,7 @@ enum lttng_error_code snapshot_record(struct ltt_session *session,
 	if (session->ust_session) {
 		ret_code = record_ust_snapshot(session->ust_session,
 				snapshot_ust_consumer_output, session,
-				wait, nb_packets_per_stream);
+				wait, nb_packets_per_stream, scope);
 		if (ret_code != LTTNG_OK) {
 			goto error_close_trace_chunk;
 		}
@@ -4984,21 +5688,129 @@ error:
 		session->kernel_session->consumer =
 				original_kernel_consumer_output;
 	}
+
+	if (!relayd) {
+		/* Close the connections of temporary outputs right away. */
+		if (snapshot_kernel_consumer_output) {
+			consumer_output_send_destroy_relayd(
+					snapshot_kernel_consumer_output);
+		}
+		if (snapshot_ust_consumer_output) {
+			consumer_output_send_destroy_relayd(
+					snapshot_ust_consumer_output);
+		}
+	} else if (ret_code != LTTNG_OK) {
+		/*
+		 * The connections may have been broken; the next snapshot
+		 * connects to the relay daemon again.
+		 */
+		snapshot_output_relayd_close(relayd);
+	} else if (snapshot_output_relayd_is_open(relayd)) {
+		ret = lttng_clock_gettime(CLOCK_MONOTONIC, &relayd->last_use);
+		if (ret) {
+			PERROR("Failed to sample monotonic clock");
+			snapshot_output_relayd_close(relayd);
+		} else if (timer_session_snapshot_relayd_idle_timer_start(
+				session, DEFAULT_SNAPSHOT_RELAYD_IDLE_TIMEOUT)) {
+			/* Don't keep connections that would never be closed. */
+			ERR("Failed to start snapshot relayd idle check timer of session \"%s\"",
+					session->name);
+			snapshot_output_relayd_close(relayd);
+		}
+	}
+
 	consumer_output_put(snapshot_ust_consumer_output);
 	consumer_output_put(snapshot_kernel_consumer_output);
 	return ret_code;
 }
 
+/*
+ * Record a snapshot of the session to a snapshot output.
+ *
+ * The relay daemon connections kept open since a previous snapshot may have
+ * been broken in the meantime (relay daemon restarted, network failure). A
+ * failed attempt over such connections closes them; the snapshot is then
+ * recorded once more over new connections.
+ */
+static
+enum lttng_error_code snapshot_record(struct ltt_session *session,
+		const struct snapshot_output *snapshot_output, int wait,
+		struct snapshot_output_relayd *relayd,
+		const struct snapshot_scope *scope)
+{
+	enum lttng_error_code ret_code;
+	const bool reused_relayd = relayd &&
+			snapshot_output_relayd_is_open(relayd);
+
+	ret_code = _snapshot_record(session, snapshot_output, wait, relayd,
+			scope);
+	if (ret_code != LTTNG_OK && reused_relayd) {
+		assert(!snapshot_output_relayd_is_open(relayd));
+		WARN("Failed to record snapshot of session \"%s\" over the relay daemon connections of output \"%s\", reconnecting: %s",
+				session->name, snapshot_output->name,
+				lttng_strerror(-ret_code));
+		ret_code = _snapshot_record(session, snapshot_output, wait,
+				relayd, scope);
+	}
+
+	return ret_code;
+}
+
+/*
+ * Check that every channel named by a snapshot scope exists in the kernel or
+ * the user space domain of a session.
+ *
+ * Return LTTNG_OK if they all exist, else LTTNG_ERR_CHAN_NOT_FOUND.
+ */
+static enum lttng_error_code validate_snapshot_scope(
+		const struct ltt_session *session,
+		const struct snapshot_scope *scope)
+{
+	enum lttng_error_code ret_code = LTTNG_OK;
+	unsigned int i;
+
+	if (!scope) {
+		goto end;
+	}
+
+	rcu_read_lock();
+	for (i = 0; i < scope->channel_count; i++) {
+		const char *channel_name = scope->channel_names[i];
+
+		if (session->kernel_session &&
+				trace_kernel_get_channel_by_name(channel_name,
+						session->kernel_session)) {
+			continue;
+		}
+		if (session->ust_session &&
+				trace_ust_find_channel_by_name(
+						session->ust_session->domain_global.channels,
+						channel_name)) {
+			continue;
+		}
+
+		DBG("Snapshot channel \"%s\" not found in session \"%s\"",
+				channel_name, session->name);
+		ret_code = LTTNG_ERR_CHAN_NOT_FOUND;
+		break;
+	}
+	rcu_read_unlock();
+end:
+	return ret_code;
+}
+
 /*
  * Command LTTNG_SNAPSHOT_RECORD from lib lttng ctl.
  *
  * The wait parameter is ignored so this call always wait for the snapshot to
- * complete before returning.
+ * complete before returning. The scope, if any, restricts the snapshot to
+ * a subset of the session.
  *
  * Return LTTNG_OK on success or else a LTTNG_ERR code.
  */
 int cmd_snapshot_record(struct ltt_session *session,
-		const struct lttng_snapshot_output *output, int wait)
+		const struct lttng_snapshot_output *output, int wait,
+		const struct snapshot_scope *scope)
 {
 	enum lttng_error_code cmd_ret = LTTNG_OK;
 	int ret;
@@ -5034,6 +5846,11 @@ int cmd_snapshot_record(struct ltt_session *session,
 		goto error;
 	}
 
+	cmd_ret = validate_snapshot_scope(session, scope);
+	if (cmd_ret != LTTNG_OK) {
+		goto error;
+	}
+
 	/* Use temporary output for the session. */
 	if (*output->ctrl_url != '\0') {
 		tmp_output = snapshot_output_alloc();
@@ -5060,7 +5877,8 @@ int cmd_snapshot_record(struct ltt_session *session,
 
 		/* Use the global datetime */
 		memcpy(tmp_output->datetime, datetime, sizeof(datetime));
-		cmd_ret = snapshot_record(session, tmp_output, wait);
+		cmd_ret = snapshot_record(session, tmp_output, wait, NULL,
+				scope);
 		if (cmd_ret != LTTNG_OK) {
 			goto error;
 		}
@@ -5100,7 +5918,8 @@ int cmd_snapshot_record(struct ltt_session *session,
 				}
 			}
 
-			cmd_ret = snapshot_record(session, &output_copy, wait);
+			cmd_ret = snapshot_record(session, &output_copy, wait,
+					&sout->relayd, scope);
 			if (cmd_ret != LTTNG_OK) {
 				rcu_read_unlock();
 				goto error;
@@ -5146,6 +5965,81 @@ int cmd_set_session_shm_path(struct ltt_session *session,
 	return LTTNG_OK;
 }
 
+/*
+ * Command LTTNG_SET_SESSION_LOCAL_COPY_PATH from the lttng-ctl library.
+ *
+ * Set the root path of the local copy of a session streamed to a relay
+ * daemon; an empty path disables the local copy. The sub-buffers are written
+ * to both destinations from their mapping, which spliced channels lack.
+ */
+int cmd_set_session_local_copy_path(struct ltt_session *session,
+		const char *path)
+{
+	int ret;
+	unsigned int i;
+	struct ltt_kernel_channel *kchan;
+	struct consumer_output *outputs[3];
+
+	assert(session);
+
+	if (session->has_been_started) {
+		ret = LTTNG_ERR_SESSION_STARTED;
+		goto end;
+	}
+
+	if (!path[0]) {
+		goto set;
+	}
+
+	if (path[0] != '/' || strstr(path, "../")) {
+		ret = LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	if (session->consumer->type != CONSUMER_DST_NET ||
+			!session->consumer->dst.net.control_isset ||
+			!session->consumer->dst.net.data_isset) {
+		ret = LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	if (session->kernel_session) {
+		cds_list_for_each_entry(kchan,
+				&session->kernel_session->channel_list.head,
+				list) {
+			if (kchan->channel->attr.output != LTTNG_EVENT_MMAP) {
+				ret = LTTNG_ERR_LOCAL_COPY_SPLICE;
+				goto end;
+			}
+		}
+	}
+
+set:
+	/* The domains created later on copy the session's output. */
+	outputs[0] = session->consumer;
+	outputs[1] = session->ust_session ?
+			session->ust_session->consumer : NULL;
+	outputs[2] = session->kernel_session ?
+			session->kernel_session->consumer : NULL;
+	for (i = 0; i < ARRAY_SIZE(outputs); i++) {
+		if (!outputs[i]) {
+			continue;
+		}
+		ret = lttng_strncpy(outputs[i]->tee_path, path,
+				sizeof(outputs[i]->tee_path));
+		if (ret) {
+			ret = LTTNG_ERR_INVALID;
+			goto end;
+		}
+	}
+
+	DBG("Local copy path of session \"%s\" set to \"%s\"", session->name,
+			path);
+	ret = LTTNG_OK;
+end:
+	return ret;
+}
+
 /*
  * Command LTTNG_ROTATE_SESSION from the lttng-ctl library.
  *
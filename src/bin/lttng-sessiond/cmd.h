@@ -15,6 +15,8 @@
 #include <common/tracker.h>
 
 struct notification_thread_handle;
+struct lttng_counter_map_values;
+struct lttng_channel_advice;
 
 /*
  * A callback (and associated user data) that should be run after a command
@@ -30,6 +32,18 @@ struct cmd_completion_handler {
 	void *data;
 };
 
+/*
+ * Selection of the objects returned by a listing command.
+ */
+struct cmd_list_selection {
+	/* Star-only globbing pattern on the object names, NULL for all. */
+	const char *name_pattern;
+	/* Number of matching objects to skip. */
+	uint32_t cursor;
+	/* Maximal number of objects to list, 0 for no limit. */
+	uint32_t max_count;
+};
+
 /*
  * Init the command subsystem. Must be called before using any of the functions
  * above. This is called in the main() of the session daemon.
@@ -93,6 +107,11 @@ int cmd_enable_event(struct ltt_session *session, const struct lttng_domain *dom
 		struct lttng_bytecode *filter,
 		struct lttng_event_exclusion *exclusion,
 		int wpipe);
+int cmd_enable_events(struct ltt_session *session,
+		const struct lttng_domain *domain,
+		char *channel_name, struct lttng_event *events,
+		unsigned int event_count, enum lttng_error_code *ret_codes,
+		int wpipe);
 
 /* Trace session action commands */
 int cmd_start_trace(struct ltt_session *session);
@@ -111,9 +130,12 @@ ssize_t cmd_list_domains(struct ltt_session *session,
 		struct lttng_domain **domains);
 ssize_t cmd_list_events(enum lttng_domain_type domain,
 		struct ltt_session *session, char *channel_name,
+		const struct cmd_list_selection *selection,
 		struct lttng_payload *payload);
 ssize_t cmd_list_channels(enum lttng_domain_type domain,
-		struct ltt_session *session, struct lttng_channel **channels);
+		struct ltt_session *session,
+		const struct cmd_list_selection *selection,
+		struct lttng_channel **channels);
 ssize_t cmd_list_domains(struct ltt_session *session,
 		struct lttng_domain **domains);
 void cmd_list_lttng_sessions(struct lttng_session *sessions,
@@ -134,10 +156,13 @@ int cmd_snapshot_add_output(struct ltt_session *session,
 int cmd_snapshot_del_output(struct ltt_session *session,
 		const struct lttng_snapshot_output *output);
 int cmd_snapshot_record(struct ltt_session *session,
-		const struct lttng_snapshot_output *output, int wait);
+		const struct lttng_snapshot_output *output, int wait,
+		const struct snapshot_scope *scope);
 
 int cmd_set_session_shm_path(struct ltt_session *session,
 		const char *shm_path);
+int cmd_set_session_local_copy_path(struct ltt_session *session,
+		const char *path);
 int cmd_regenerate_metadata(struct ltt_session *session);
 int cmd_regenerate_statedump(struct ltt_session *session);
 
@@ -155,6 +180,18 @@ int cmd_list_triggers(struct command_ctx *cmd_ctx,
 		struct notification_thread_handle *notification_thread_handle,
 		struct lttng_triggers **return_triggers);
 
+enum lttng_error_code cmd_get_channel_advice(struct ltt_session *session,
+		enum lttng_domain_type domain, const char *channel_name,
+		struct lttng_channel_advice *advice);
+
+enum lttng_error_code cmd_list_counter_map(struct command_ctx *cmd_ctx,
+		struct notification_thread_handle *notification_thread_handle,
+		const char *map_name,
+		struct lttng_counter_map_values **return_values);
+enum lttng_error_code cmd_clear_counter_map(struct command_ctx *cmd_ctx,
+		struct notification_thread_handle *notification_thread_handle,
+		const char *map_name);
+
 int cmd_rotate_session(struct ltt_session *session,
 		struct lttng_rotate_session_return *rotate_return,
 		bool quiet_rotation,
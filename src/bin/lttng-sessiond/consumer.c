@@ -307,14 +307,122 @@ void consumer_output_send_destroy_relayd(struct consumer_output *consumer)
 	}
 }
 
+/*
+ * Announce a live session with a local output to the consumer so that it is
+ * listed to the viewers of the consumer's local live endpoint. This is only
+ * done once per consumer socket.
+ *
+ * On success return positive value. On error, negative value.
+ */
+int consumer_send_add_live_session(struct consumer_socket *sock,
+		uint64_t session_id, const char *session_name,
+		const char *hostname, unsigned int live_timer)
+{
+	int ret = 1;
+	struct lttcomm_consumer_msg msg;
+
+	assert(sock);
+	assert(session_name);
+	assert(hostname);
+
+	pthread_mutex_lock(sock->lock);
+	if (sock->live_session_sent) {
+		goto error;
+	}
+
+	DBG2("Sending add live session command to consumer sock %d",
+			*sock->fd_ptr);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd_type = LTTNG_CONSUMER_ADD_LIVE_SESSION;
+	msg.u.add_live_session.session_id = session_id;
+	msg.u.add_live_session.live_timer = live_timer;
+	ret = lttng_strncpy(msg.u.add_live_session.session_name, session_name,
+			sizeof(msg.u.add_live_session.session_name));
+	if (ret) {
+		ret = -1;
+		goto error;
+	}
+	ret = lttng_strncpy(msg.u.add_live_session.hostname, hostname,
+			sizeof(msg.u.add_live_session.hostname));
+	if (ret) {
+		ret = -1;
+		goto error;
+	}
+
+	ret = consumer_socket_send(sock, &msg, sizeof(msg));
+	if (ret < 0) {
+		goto error;
+	}
+
+	ret = consumer_recv_status_reply(sock);
+	if (ret < 0) {
+		goto error;
+	}
+	sock->live_session_sent = 1;
+
+error:
+	pthread_mutex_unlock(sock->lock);
+	return ret;
+}
+
+/*
+ * For each consumer socket of a local consumer output, tell the consumer that
+ * the live session is destroyed.
+ */
+void consumer_output_send_close_live_session(struct consumer_output *consumer,
+		uint64_t session_id)
+{
+	struct lttng_ht_iter iter;
+	struct consumer_socket *socket;
+	struct lttcomm_consumer_msg msg;
+
+	assert(consumer);
+
+	if (consumer->type != CONSUMER_DST_LOCAL) {
+		return;
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd_type = LTTNG_CONSUMER_CLOSE_LIVE_SESSION;
+	msg.u.close_live_session.session_id = session_id;
+
+	rcu_read_lock();
+	cds_lfht_for_each_entry(consumer->socks->ht, &iter.iter, socket,
+			node.node) {
+		int ret;
+
+		pthread_mutex_lock(socket->lock);
+		if (!socket->live_session_sent) {
+			pthread_mutex_unlock(socket->lock);
+			continue;
+		}
+
+		ret = consumer_socket_send(socket, &msg, sizeof(msg));
+		if (ret >= 0) {
+			ret = consumer_recv_status_reply(socket);
+		}
+		if (ret < 0) {
+			DBG("Unable to send close live session command to consumer");
+			/* Continue since we MUST delete everything at this point. */
+		}
+		socket->live_session_sent = 0;
+		pthread_mutex_unlock(socket->lock);
+	}
+	rcu_read_unlock();
+}
+
 /*
  * From a consumer_data structure, allocate and add a consumer socket to the
  * consumer output.
  *
+ * The socket is keyed by the consumer data's command socket but uses the
+ * command connection assigned to the session.
+ *
  * Return 0 on success, else negative value on error
  */
 int consumer_create_socket(struct consumer_data *data,
-		struct consumer_output *output)
+		struct consumer_output *output, uint64_t session_id)
 {
 	int ret = 0;
 	struct consumer_socket *socket;
@@ -341,6 +449,19 @@ int consumer_create_socket(struct consumer_data *data,
 
 		socket->registered = 0;
 		socket->lock = &data->lock;
+		if (data->cmd_connection_count > 0) {
+			const unsigned int connection = session_id %
+					(data->cmd_connection_count + 1);
+
+			/* Connection 0 is the consumer data's command socket. */
+			if (connection > 0) {
+				struct consumer_cmd_connection *cmd_connection =
+						&data->cmd_connections[connection - 1];
+
+				socket->fd_ptr = &cmd_connection->sock;
+				socket->lock = &cmd_connection->lock;
+			}
+		}
 		rcu_read_lock();
 		consumer_add_socket(socket, output);
 		rcu_read_unlock();
@@ -349,7 +470,7 @@ int consumer_create_socket(struct consumer_data *data,
 	socket->type = data->type;
 
 	DBG3("Consumer socket created (fd: %d) and added to output",
-			data->cmd_sock);
+			*socket->fd_ptr);
 
 error:
 	return ret;
@@ -594,6 +715,16 @@ void consumer_output_put(struct consumer_output *obj)
 	urcu_ref_put(&obj->ref, consumer_release_output);
 }
 
+/*
+ * Indicates whether or not the trace chunks of a consumer output have a local
+ * output directory: either the output is local or it is a network output with
+ * a local copy.
+ */
+bool consumer_output_has_local_output(const struct consumer_output *output)
+{
+	return output->type == CONSUMER_DST_LOCAL || output->tee_path[0];
+}
+
 /*
  * Copy consumer output and returned the newly allocated copy.
  *
@@ -619,6 +750,7 @@ struct consumer_output *consumer_copy_output(struct consumer_output *src)
 	output->relay_minor_version = src->relay_minor_version;
 	output->relay_allows_clear = src->relay_allows_clear;
 	memcpy(&output->dst, &src->dst, sizeof(output->dst));
+	memcpy(output->tee_path, src->tee_path, sizeof(output->tee_path));
 	ret = consumer_copy_sockets(output, src);
 	if (ret < 0) {
 		goto error_put;
@@ -649,18 +781,22 @@ int consumer_copy_sockets(struct consumer_output *dst,
 	rcu_read_lock();
 	cds_lfht_for_each_entry(src->socks->ht, &iter.iter, socket, node.node) {
 		/* Ignore socket that are already there. */
-		copy_sock = consumer_find_socket(*socket->fd_ptr, dst);
+		copy_sock = consumer_find_socket((int) socket->node.key, dst);
 		if (copy_sock) {
 			continue;
 		}
 
-		/* Create new socket object. */
+		/*
+		 * Create new socket object, sharing the key and command
+		 * connection of the source socket.
+		 */
 		copy_sock = consumer_allocate_socket(socket->fd_ptr);
 		if (copy_sock == NULL) {
 			rcu_read_unlock();
 			ret = -ENOMEM;
 			goto error;
 		}
+		lttng_ht_node_init_ulong(&copy_sock->node, socket->node.key);
 
 		copy_sock->registered = socket->registered;
 		/*
@@ -931,6 +1067,8 @@ void consumer_init_ask_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 		unsigned int monitor,
 		uint32_t ust_app_uid,
 		int64_t blocking_timeout,
+		uint64_t writeback_window_size,
+		bool direct_io,
 		const char *root_shm_path,
 		const char *shm_path,
 		struct lttng_trace_chunk *trace_chunk,
@@ -977,6 +1115,8 @@ void consumer_init_ask_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 	msg->u.ask_channel.monitor = monitor;
 	msg->u.ask_channel.ust_app_uid = ust_app_uid;
 	msg->u.ask_channel.blocking_timeout = blocking_timeout;
+	msg->u.ask_channel.writeback_window_size = writeback_window_size;
+	msg->u.ask_channel.direct_io = direct_io;
 
 	memcpy(msg->u.ask_channel.uuid, uuid, sizeof(msg->u.ask_channel.uuid));
 
@@ -1021,6 +1161,8 @@ void consumer_init_add_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 		unsigned int live_timer_interval,
 		bool is_in_live_session,
 		unsigned int monitor_timer_interval,
+		uint64_t writeback_window_size,
+		bool direct_io,
 		struct lttng_trace_chunk *trace_chunk)
 {
 	assert(msg);
@@ -1051,6 +1193,8 @@ void consumer_init_add_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 	msg->u.channel.live_timer_interval = live_timer_interval;
 	msg->u.channel.is_live = is_in_live_session;
 	msg->u.channel.monitor_timer_interval = monitor_timer_interval;
+	msg->u.channel.writeback_window_size = writeback_window_size;
+	msg->u.channel.direct_io = direct_io;
 
 	strncpy(msg->u.channel.pathname, pathname,
 			sizeof(msg->u.channel.pathname));
@@ -1078,6 +1222,23 @@ void consumer_init_add_stream_comm_msg(struct lttcomm_consumer_msg *msg,
 	msg->u.stream.cpu = cpu;
 }
 
+/*
+ * Init stream communication message structure used to hand several streams of
+ * a channel to the consumer in a single exchange.
+ */
+void consumer_init_add_streams_comm_msg(struct lttcomm_consumer_msg *msg,
+		uint64_t channel_key,
+		uint32_t stream_count)
+{
+	assert(msg);
+
+	memset(msg, 0, sizeof(struct lttcomm_consumer_msg));
+
+	msg->cmd_type = LTTNG_CONSUMER_ADD_STREAMS;
+	msg->u.streams.channel_key = channel_key;
+	msg->u.streams.stream_count = stream_count;
+}
+
 void consumer_init_streams_sent_comm_msg(struct lttcomm_consumer_msg *msg,
 		enum lttng_consumer_command cmd,
 		uint64_t channel_key, uint64_t net_seq_idx)
@@ -1119,6 +1280,62 @@ error:
 	return ret;
 }
 
+/*
+ * Send an ADD_STREAMS message followed by the attributes and file descriptors
+ * of its streams. The file descriptors are passed in chunks of at most
+ * LTTCOMM_MAX_SEND_FDS and the consumer replies with a single status once it
+ * has received all of them.
+ *
+ * The consumer socket lock must be held by the caller.
+ *
+ * Return 0 on success else a negative value.
+ */
+int consumer_send_streams(struct consumer_socket *sock,
+		const struct lttcomm_consumer_msg *msg,
+		const struct lttcomm_consumer_stream_info *infos,
+		const int *fds, size_t nb_fd)
+{
+	int ret;
+	size_t fds_sent = 0;
+
+	assert(msg);
+	assert(sock);
+	assert(infos);
+	assert(fds);
+	assert(nb_fd > 0);
+	assert(pthread_mutex_trylock(sock->lock) == EBUSY);
+
+	ret = consumer_socket_send(sock, msg, sizeof(*msg));
+	if (ret < 0) {
+		goto error;
+	}
+
+	ret = consumer_socket_send(sock, infos, sizeof(*infos) * nb_fd);
+	if (ret < 0) {
+		goto error;
+	}
+
+	while (fds_sent < nb_fd) {
+		const size_t chunk = min_t(size_t, nb_fd - fds_sent,
+				LTTCOMM_MAX_SEND_FDS);
+
+		ret = lttcomm_send_fds_unix_sock(*sock->fd_ptr,
+				fds + fds_sent, chunk);
+		if (ret < 0) {
+			/* The above call will print a PERROR on error. */
+			DBG("Error when sending consumer fds on sock %d",
+					*sock->fd_ptr);
+			goto error;
+		}
+		fds_sent += chunk;
+		health_code_update();
+	}
+
+	ret = consumer_recv_status_reply(sock);
+error:
+	return ret;
+}
+
 /*
  * Send relayd socket to consumer associated with a session name.
  *
@@ -1215,6 +1432,10 @@ int consumer_send_pipe(struct consumer_socket *consumer_sock,
 		pipe_name = "channel monitor";
 		command_name = "SET_CHANNEL_MONITOR_PIPE";
 		break;
+	case LTTNG_CONSUMER_ADD_COMMAND_SOCKET:
+		pipe_name = "command socket";
+		command_name = "ADD_COMMAND_SOCKET";
+		break;
 	default:
 		ERR("Unexpected command received in %s (cmd = %d)", __func__,
 				(int) cmd);
@@ -1254,6 +1475,77 @@ int consumer_send_channel_monitor_pipe(struct consumer_socket *consumer_sock,
 			LTTNG_CONSUMER_SET_CHANNEL_MONITOR_PIPE, pipe);
 }
 
+/*
+ * Open the additional command connections of a consumer daemon. One end of
+ * each socket pair is handed to the consumer daemon, which serves it with a
+ * dedicated command worker.
+ *
+ * Failing to open a connection is not fatal; the sessions are then spread
+ * over the connections that could be opened.
+ */
+void consumer_create_cmd_connections(struct consumer_data *data,
+		struct consumer_socket *cmd_socket)
+{
+	unsigned int i;
+
+	assert(data);
+	assert(cmd_socket);
+
+	for (i = 0; i < DEFAULT_CONSUMERD_CMD_CONNECTIONS - 1; i++) {
+		int ret, fds[2];
+		struct consumer_cmd_connection *cmd_connection =
+				&data->cmd_connections[i];
+
+		ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+		if (ret) {
+			PERROR("socketpair consumer command connection");
+			break;
+		}
+
+		ret = consumer_send_pipe(cmd_socket,
+				LTTNG_CONSUMER_ADD_COMMAND_SOCKET, fds[1]);
+		/* The consumer daemon holds its own copy of its end. */
+		if (close(fds[1])) {
+			PERROR("close consumer command connection");
+		}
+		if (ret) {
+			if (close(fds[0])) {
+				PERROR("close consumer command connection");
+			}
+			break;
+		}
+
+		cmd_connection->sock = fds[0];
+		pthread_mutex_init(&cmd_connection->lock, NULL);
+		data->cmd_connection_count++;
+	}
+
+	DBG("Consumer daemon reachable through %u command connections",
+			data->cmd_connection_count + 1);
+}
+
+/*
+ * Close the additional command connections of a consumer daemon.
+ */
+void consumer_close_cmd_connections(struct consumer_data *data)
+{
+	unsigned int i;
+
+	for (i = 0; i < data->cmd_connection_count; i++) {
+		struct consumer_cmd_connection *cmd_connection =
+				&data->cmd_connections[i];
+
+		pthread_mutex_lock(&cmd_connection->lock);
+		if (cmd_connection->sock >= 0) {
+			if (close(cmd_connection->sock)) {
+				PERROR("close consumer command connection");
+			}
+			cmd_connection->sock = -1;
+		}
+		pthread_mutex_unlock(&cmd_connection->lock);
+	}
+}
+
 /*
  * Ask the consumer if the data is pending for the specific session id.
  * Returns 1 if data is pending, 0 otherwise, or < 0 on error.
@@ -1345,6 +1637,141 @@ end:
 	return ret;
 }
 
+/*
+ * Send a single flush command to the consumer for a set of channel keys.
+ *
+ * The consumer flushes every channel it can find and replies once, which
+ * saves a round-trip per channel when many of them must be flushed at once.
+ *
+ * Return 0 on success else a negative value.
+ */
+int consumer_flush_channels(struct consumer_socket *socket,
+		const uint64_t *keys, uint32_t count)
+{
+	int ret;
+	struct lttcomm_consumer_msg msg;
+
+	assert(socket);
+	assert(keys || count == 0);
+
+	if (count == 0) {
+		ret = 0;
+		goto end_unlocked;
+	}
+
+	DBG2("Consumer flush %" PRIu32 " channels", count);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd_type = LTTNG_CONSUMER_FLUSH_CHANNELS;
+	msg.u.flush_channels.count = count;
+
+	pthread_mutex_lock(socket->lock);
+	health_code_update();
+
+	ret = consumer_socket_send(socket, &msg, sizeof(msg));
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = consumer_socket_send(socket, keys, count * sizeof(*keys));
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = consumer_recv_status_reply(socket);
+
+end:
+	health_code_update();
+	pthread_mutex_unlock(socket->lock);
+end_unlocked:
+	return ret;
+}
+
+/*
+ * Ask the consumer to create, in the background, the buffers of the given
+ * channels for the per-PID registry identified by `uuid`. The consumer
+ * replies as soon as the request is queued.
+ *
+ * Return 0 on success else a negative value.
+ */
+int consumer_prepare_buffer_set(struct consumer_socket *socket,
+		uint64_t session_id, const lttng_uuid uuid,
+		const struct lttcomm_consumer_buffer_set_channel *channels,
+		uint32_t channel_count)
+{
+	int ret;
+	struct lttcomm_consumer_msg msg;
+
+	assert(socket);
+	assert(channels);
+	assert(channel_count > 0);
+
+	DBG2("Consumer prepare buffer set of %" PRIu32 " channels for session %" PRIu64,
+			channel_count, session_id);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd_type = LTTNG_CONSUMER_PREPARE_BUFFER_SET;
+	msg.u.prepare_buffer_set.session_id = session_id;
+	lttng_uuid_copy(msg.u.prepare_buffer_set.uuid, uuid);
+	msg.u.prepare_buffer_set.channel_count = channel_count;
+
+	pthread_mutex_lock(socket->lock);
+	health_code_update();
+
+	ret = consumer_socket_send(socket, &msg, sizeof(msg));
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = consumer_socket_send(socket, channels,
+			channel_count * sizeof(*channels));
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = consumer_recv_status_reply(socket);
+
+end:
+	health_code_update();
+	pthread_mutex_unlock(socket->lock);
+	return ret;
+}
+
+/*
+ * Release every buffer set the consumer keeps for the given session.
+ *
+ * Return 0 on success else a negative value.
+ */
+int consumer_destroy_buffer_pool(struct consumer_socket *socket,
+		uint64_t session_id)
+{
+	int ret;
+	struct lttcomm_consumer_msg msg;
+
+	assert(socket);
+
+	DBG2("Consumer destroy buffer pool of session %" PRIu64, session_id);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd_type = LTTNG_CONSUMER_DESTROY_BUFFER_POOL;
+	msg.u.destroy_buffer_pool.session_id = session_id;
+
+	pthread_mutex_lock(socket->lock);
+	health_code_update();
+
+	ret = consumer_socket_send(socket, &msg, sizeof(msg));
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = consumer_recv_status_reply(socket);
+
+end:
+	health_code_update();
+	pthread_mutex_unlock(socket->lock);
+	return ret;
+}
+
 /*
  * Send a clear quiescent command to consumer using the given channel key.
  *
@@ -1497,14 +1924,15 @@ end:
 }
 
 /*
- * Ask the consumer to snapshot a specific channel using the key.
+ * Ask the consumer to snapshot a specific channel using the key. The packets
+ * which end before begin_timestamp, when not 0, are skipped.
  *
  * Returns LTTNG_OK on success or else an LTTng error code.
  */
 enum lttng_error_code consumer_snapshot_channel(struct consumer_socket *socket,
 		uint64_t key, const struct consumer_output *output, int metadata,
 		uid_t uid, gid_t gid, const char *channel_path, int wait,
-		uint64_t nb_packets_per_stream)
+		uint64_t nb_packets_per_stream, uint64_t begin_timestamp)
 {
 	int ret;
 	enum lttng_error_code status = LTTNG_OK;
@@ -1519,6 +1947,7 @@ enum lttng_error_code consumer_snapshot_channel(struct consumer_socket *socket,
 	msg.cmd_type = LTTNG_CONSUMER_SNAPSHOT_CHANNEL;
 	msg.u.snapshot_channel.key = key;
 	msg.u.snapshot_channel.nb_packets_per_stream = nb_packets_per_stream;
+	msg.u.snapshot_channel.begin_timestamp = begin_timestamp;
 	msg.u.snapshot_channel.metadata = metadata;
 
 	if (output->type == CONSUMER_DST_NET) {
@@ -1824,7 +2253,7 @@ int consumer_create_trace_chunk(struct consumer_socket *socket,
 	time_t creation_timestamp;
 	char creation_timestamp_buffer[ISO8601_STR_LEN];
 	const char *creation_timestamp_str = "(none)";
-	const bool chunk_has_local_output = relayd_id == -1ULL;
+	bool chunk_has_local_output;
 	enum lttng_trace_chunk_status tc_status;
 	struct lttcomm_consumer_msg msg = {
 		.cmd_type = LTTNG_CONSUMER_CREATE_TRACE_CHUNK,
@@ -1886,13 +2315,30 @@ int consumer_create_trace_chunk(struct consumer_socket *socket,
 	}
 	msg.u.create_trace_chunk.chunk_id = chunk_id;
 
-	if (chunk_has_local_output) {
-		chunk_status = lttng_trace_chunk_borrow_chunk_directory_handle(
-				chunk, &chunk_directory_handle);
-		if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK) {
+	/*
+	 * Chunks of local traces and of streamed traces with a local copy have
+	 * an output directory; it is provided to the consumer.
+	 */
+	chunk_status = lttng_trace_chunk_borrow_chunk_directory_handle(
+			chunk, &chunk_directory_handle);
+	switch (chunk_status) {
+	case LTTNG_TRACE_CHUNK_STATUS_OK:
+		chunk_has_local_output = true;
+		break;
+	case LTTNG_TRACE_CHUNK_STATUS_NONE:
+		if (relayd_id == -1ULL) {
+			/* A local trace chunk always has an output directory. */
 			ret = -LTTNG_ERR_FATAL;
 			goto error;
 		}
+		chunk_has_local_output = false;
+		break;
+	default:
+		ret = -LTTNG_ERR_FATAL;
+		goto error;
+	}
+
+	if (chunk_has_local_output) {
 		chunk_status = lttng_trace_chunk_get_credentials(
 				chunk, &chunk_credentials);
 		if (chunk_status != LTTNG_TRACE_CHUNK_STATUS_OK) {
@@ -54,12 +54,24 @@ struct consumer_socket {
 	/* Flag if network sockets were sent to the consumer. */
 	unsigned int control_sock_sent;
 	unsigned int data_sock_sent;
+	/* Flag if the live session of a local output was announced. */
+	unsigned int live_session_sent;
 
 	struct lttng_ht_node_ulong node;
 
 	enum lttng_consumer_type type;
 };
 
+/*
+ * Additional command connection to a consumer daemon. The consumer daemon
+ * serves each command connection with its own worker thread.
+ */
+struct consumer_cmd_connection {
+	int sock;
+	/* Same semantic as the consumer data lock, for this connection. */
+	pthread_mutex_t lock;
+};
+
 struct consumer_data {
 	enum lttng_consumer_type type;
 
@@ -94,6 +106,17 @@ struct consumer_data {
 	 * operations.
 	 */
 	pthread_mutex_t lock;
+
+	/*
+	 * Command connections opened in addition to cmd_sock. The commands of a
+	 * session are always sent on the same connection, chosen from the
+	 * session's id, so that the consumer daemon executes them in order
+	 * while executing those of other sessions concurrently.
+	 *
+	 * Only set while the consumer daemon is being launched.
+	 */
+	struct consumer_cmd_connection cmd_connections[DEFAULT_CONSUMERD_CMD_CONNECTIONS - 1];
+	unsigned int cmd_connection_count;
 };
 
 /*
@@ -172,6 +195,13 @@ struct consumer_output {
 	 * trace will be stored (\0 before the first session rotation).
 	 */
 	char chunk_path[LTTNG_PATH_MAX];
+
+	/*
+	 * Root path of the local copy of a network output, empty if the trace
+	 * is only streamed. The consumer writes each sub-buffer both to the
+	 * relay daemon and under this path.
+	 */
+	char tee_path[LTTNG_PATH_MAX];
 };
 
 struct consumer_socket *consumer_find_socket(int key,
@@ -194,6 +224,7 @@ int consumer_socket_recv(struct consumer_socket *socket, void *msg,
 
 struct consumer_output *consumer_create_output(enum consumer_dst_type type);
 struct consumer_output *consumer_copy_output(struct consumer_output *obj);
+bool consumer_output_has_local_output(const struct consumer_output *output);
 void consumer_output_get(struct consumer_output *obj);
 void consumer_output_put(struct consumer_output *obj);
 int consumer_set_network_uri(const struct ltt_session *session,
@@ -206,6 +237,10 @@ int consumer_send_msg(struct consumer_socket *sock,
 int consumer_send_stream(struct consumer_socket *sock,
 		struct consumer_output *dst, struct lttcomm_consumer_msg *msg,
 		const int *fds, size_t nb_fd);
+int consumer_send_streams(struct consumer_socket *sock,
+		const struct lttcomm_consumer_msg *msg,
+		const struct lttcomm_consumer_stream_info *infos,
+		const int *fds, size_t nb_fd);
 int consumer_send_channel(struct consumer_socket *sock,
 		struct lttcomm_consumer_msg *msg);
 int consumer_send_relayd_socket(struct consumer_socket *consumer_sock,
@@ -223,8 +258,16 @@ int consumer_recv_status_reply(struct consumer_socket *sock);
 int consumer_recv_status_channel(struct consumer_socket *sock,
 		uint64_t *key, unsigned int *stream_count);
 void consumer_output_send_destroy_relayd(struct consumer_output *consumer);
+int consumer_send_add_live_session(struct consumer_socket *sock,
+		uint64_t session_id, const char *session_name,
+		const char *hostname, unsigned int live_timer);
+void consumer_output_send_close_live_session(struct consumer_output *consumer,
+		uint64_t session_id);
 int consumer_create_socket(struct consumer_data *data,
-		struct consumer_output *output);
+		struct consumer_output *output, uint64_t session_id);
+void consumer_create_cmd_connections(struct consumer_data *data,
+		struct consumer_socket *cmd_socket);
+void consumer_close_cmd_connections(struct consumer_data *data);
 
 void consumer_init_ask_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 		uint64_t subbuf_size,
@@ -250,6 +293,8 @@ void consumer_init_ask_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 		unsigned int monitor,
 		uint32_t ust_app_uid,
 		int64_t blocking_timeout,
+		uint64_t writeback_window_size,
+		bool direct_io,
 		const char *root_shm_path,
 		const char *shm_path,
 		struct lttng_trace_chunk *trace_chunk,
@@ -258,6 +303,9 @@ void consumer_init_add_stream_comm_msg(struct lttcomm_consumer_msg *msg,
 		uint64_t channel_key,
 		uint64_t stream_key,
 		int32_t cpu);
+void consumer_init_add_streams_comm_msg(struct lttcomm_consumer_msg *msg,
+		uint64_t channel_key,
+		uint32_t stream_count);
 void consumer_init_streams_sent_comm_msg(struct lttcomm_consumer_msg *msg,
 		enum lttng_consumer_command cmd,
 		uint64_t channel_key, uint64_t net_seq_idx);
@@ -278,6 +326,8 @@ void consumer_init_add_channel_comm_msg(struct lttcomm_consumer_msg *msg,
 		unsigned int live_timer_interval,
 		bool is_in_live_session,
 		unsigned int monitor_timer_interval,
+		uint64_t writeback_window_size,
+		bool direct_io,
 		struct lttng_trace_chunk *trace_chunk);
 int consumer_is_data_pending(uint64_t session_id,
 		struct consumer_output *consumer);
@@ -289,6 +339,14 @@ int consumer_push_metadata(struct consumer_socket *socket,
 		uint64_t metadata_key, char *metadata_str, size_t len,
 		size_t target_offset, uint64_t version);
 int consumer_flush_channel(struct consumer_socket *socket, uint64_t key);
+int consumer_flush_channels(struct consumer_socket *socket,
+		const uint64_t *keys, uint32_t count);
+int consumer_prepare_buffer_set(struct consumer_socket *socket,
+		uint64_t session_id, const lttng_uuid uuid,
+		const struct lttcomm_consumer_buffer_set_channel *channels,
+		uint32_t channel_count);
+int consumer_destroy_buffer_pool(struct consumer_socket *socket,
+		uint64_t session_id);
 int consumer_clear_quiescent_channel(struct consumer_socket *socket, uint64_t key);
 int consumer_get_discarded_events(uint64_t session_id, uint64_t channel_key,
 		struct consumer_output *consumer, uint64_t *discarded);
@@ -299,7 +357,7 @@ int consumer_get_lost_packets(uint64_t session_id, uint64_t channel_key,
 enum lttng_error_code consumer_snapshot_channel(struct consumer_socket *socket,
 		uint64_t key, const struct consumer_output *output, int metadata,
 		uid_t uid, gid_t gid, const char *channel_path, int wait,
-		uint64_t nb_packets_per_stream);
+		uint64_t nb_packets_per_stream, uint64_t begin_timestamp);
 
 /* Rotation commands. */
 int consumer_rotate_channel(struct consumer_socket *socket, uint64_t key,
@@ -0,0 +1,714 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <urcu.h>
+#include <urcu/rculfhash.h>
+
+#include <common/defaults.h>
+#include <common/dynamic-array.h>
+#include <common/error.h>
+#include <common/hashtable/hashtable.h>
+#include <common/hashtable/utils.h>
+#include <common/macros.h>
+#include <lttng/action/action.h>
+#include <lttng/action/group.h>
+#include <lttng/action/increment-counter.h>
+#include <lttng/condition/condition.h>
+#include <lttng/condition/on-event-internal.h>
+#include <lttng/counter-map-internal.h>
+#include <lttng/event-field-value.h>
+#include <lttng/trigger/trigger-internal.h>
+
+#include "counter-map.h"
+
+/* A map of a uid. Kept, with its dropped increments, across clears. */
+struct counter_map {
+	uid_t uid;
+	/* Owned by this. */
+	char *name;
+	/* Number of keys in the map, bounded by DEFAULT_COUNTER_MAP_MAX_KEYS. */
+	unsigned long key_count;
+	/* Increments dropped by the session daemon since the last clear. */
+	uint64_t dropped_count;
+	/* Protects `discard_baselines`. */
+	pthread_mutex_t lock;
+	/*
+	 * Tracer discards of the triggers incrementing the map when it was
+	 * last cleared, as `struct discard_baseline`.
+	 */
+	struct lttng_dynamic_array discard_baselines;
+	struct cds_lfht_node node;
+	struct rcu_head rcu_head;
+};
+
+struct counter_map_key {
+	uid_t uid;
+	const char *name;
+};
+
+struct discard_baseline {
+	uint64_t tracer_token;
+	uint64_t count;
+};
+
+struct counter_map_entry {
+	/* Maps are only freed once every entry is gone. */
+	struct counter_map *map;
+	/* Owned by this. */
+	char *key;
+	uint64_t value;
+	struct cds_lfht_node node;
+	struct rcu_head rcu_head;
+};
+
+struct counter_map_entry_key {
+	const struct counter_map *map;
+	const char *key;
+};
+
+/* Maps of every uid, indexed by (uid, map name). */
+static struct cds_lfht *counter_map_maps_ht;
+/* Entries of every map, indexed by (map, key). */
+static struct cds_lfht *counter_map_ht;
+
+static unsigned long hash_map_key(const struct counter_map_key *key)
+{
+	unsigned long uid = (unsigned long) key->uid;
+
+	return hash_key_str(key->name, lttng_ht_seed) ^
+			hash_key_ulong((void *) uid, lttng_ht_seed);
+}
+
+static int match_map(struct cds_lfht_node *node, const void *_key)
+{
+	const struct counter_map_key *key = _key;
+	const struct counter_map *map = caa_container_of(
+			node, struct counter_map, node);
+
+	return map->uid == key->uid && !strcmp(map->name, key->name);
+}
+
+static unsigned long hash_entry_key(const struct counter_map_entry_key *key)
+{
+	return hash_key_str(key->key, lttng_ht_seed) ^
+			hash_key_ulong((void *) key->map, lttng_ht_seed);
+}
+
+static int match_entry(struct cds_lfht_node *node, const void *_key)
+{
+	const struct counter_map_entry_key *key = _key;
+	const struct counter_map_entry *entry = caa_container_of(
+			node, struct counter_map_entry, node);
+
+	return entry->map == key->map && !strcmp(entry->key, key->key);
+}
+
+static void free_map(struct counter_map *map)
+{
+	if (!map) {
+		return;
+	}
+
+	free(map->name);
+	lttng_dynamic_array_reset(&map->discard_baselines);
+	pthread_mutex_destroy(&map->lock);
+	free(map);
+}
+
+static void free_map_rcu(struct rcu_head *head)
+{
+	free_map(caa_container_of(head, struct counter_map, rcu_head));
+}
+
+static void free_entry(struct counter_map_entry *entry)
+{
+	if (!entry) {
+		return;
+	}
+
+	free(entry->key);
+	free(entry);
+}
+
+static void free_entry_rcu(struct rcu_head *head)
+{
+	free_entry(caa_container_of(head, struct counter_map_entry, rcu_head));
+}
+
+int counter_map_init(void)
+{
+	counter_map_maps_ht = cds_lfht_new(DEFAULT_HT_SIZE, 1, 0,
+			CDS_LFHT_AUTO_RESIZE | CDS_LFHT_ACCOUNTING, NULL);
+	if (!counter_map_maps_ht) {
+		goto error;
+	}
+
+	counter_map_ht = cds_lfht_new(DEFAULT_HT_SIZE, 1, 0,
+			CDS_LFHT_AUTO_RESIZE | CDS_LFHT_ACCOUNTING, NULL);
+	if (!counter_map_ht) {
+		goto error;
+	}
+
+	return 0;
+error:
+	if (counter_map_maps_ht) {
+		cds_lfht_destroy(counter_map_maps_ht, NULL);
+		counter_map_maps_ht = NULL;
+	}
+	return -1;
+}
+
+void counter_map_fini(void)
+{
+	struct cds_lfht_iter iter;
+	struct counter_map *map;
+	struct counter_map_entry *entry;
+
+	if (!counter_map_ht) {
+		return;
+	}
+
+	rcu_read_lock();
+	cds_lfht_for_each_entry(counter_map_ht, &iter, entry, node) {
+		cds_lfht_del(counter_map_ht, &entry->node);
+		call_rcu(&entry->rcu_head, free_entry_rcu);
+	}
+	cds_lfht_for_each_entry(counter_map_maps_ht, &iter, map, node) {
+		cds_lfht_del(counter_map_maps_ht, &map->node);
+		call_rcu(&map->rcu_head, free_map_rcu);
+	}
+	rcu_read_unlock();
+
+	cds_lfht_destroy(counter_map_ht, NULL);
+	counter_map_ht = NULL;
+	cds_lfht_destroy(counter_map_maps_ht, NULL);
+	counter_map_maps_ht = NULL;
+}
+
+/*
+ * Get a map, creating it if `create` is set. The RCU read lock must be held.
+ */
+static struct counter_map *get_map(uid_t uid, const char *name, bool create)
+{
+	const struct counter_map_key key = { .uid = uid, .name = name };
+	unsigned long hash = hash_map_key(&key);
+	struct cds_lfht_iter iter;
+	struct cds_lfht_node *node;
+	struct counter_map *map;
+
+	cds_lfht_lookup(counter_map_maps_ht, hash, match_map, &key, &iter);
+	node = cds_lfht_iter_get_node(&iter);
+	if (node) {
+		return caa_container_of(node, struct counter_map, node);
+	}
+
+	if (!create) {
+		return NULL;
+	}
+
+	map = zmalloc(sizeof(*map));
+	if (!map) {
+		goto error;
+	}
+
+	pthread_mutex_init(&map->lock, NULL);
+	lttng_dynamic_array_init(&map->discard_baselines,
+			sizeof(struct discard_baseline), NULL);
+	map->uid = uid;
+	map->name = strdup(name);
+	if (!map->name) {
+		goto error;
+	}
+
+	cds_lfht_node_init(&map->node);
+	node = cds_lfht_add_unique(counter_map_maps_ht, hash, match_map, &key,
+			&map->node);
+	if (node != &map->node) {
+		/* Lost a race against another incrementer. */
+		free_map(map);
+		map = caa_container_of(node, struct counter_map, node);
+	}
+
+	return map;
+error:
+	free_map(map);
+	return NULL;
+}
+
+/* The RCU read lock must be held. */
+static struct counter_map_entry *get_entry(struct counter_map *map,
+		const char *key)
+{
+	const struct counter_map_entry_key entry_key = {
+		.map = map,
+		.key = key,
+	};
+	unsigned long hash = hash_entry_key(&entry_key);
+	struct cds_lfht_iter iter;
+	struct cds_lfht_node *node;
+	struct counter_map_entry *entry = NULL;
+
+	cds_lfht_lookup(counter_map_ht, hash, match_entry, &entry_key, &iter);
+	node = cds_lfht_iter_get_node(&iter);
+	if (node) {
+		return caa_container_of(node, struct counter_map_entry, node);
+	}
+
+	/* First increment of this key. */
+	if (uatomic_add_return(&map->key_count, 1) >
+			DEFAULT_COUNTER_MAP_MAX_KEYS) {
+		goto error;
+	}
+
+	entry = zmalloc(sizeof(*entry));
+	if (!entry) {
+		goto error;
+	}
+
+	entry->map = map;
+	entry->key = strdup(key);
+	if (!entry->key) {
+		goto error;
+	}
+
+	cds_lfht_node_init(&entry->node);
+	node = cds_lfht_add_unique(counter_map_ht, hash, match_entry,
+			&entry_key, &entry->node);
+	if (node != &entry->node) {
+		/* Lost a race against another incrementer. */
+		uatomic_dec(&map->key_count);
+		free_entry(entry);
+		entry = caa_container_of(node, struct counter_map_entry, node);
+	}
+
+	return entry;
+error:
+	uatomic_dec(&map->key_count);
+	free_entry(entry);
+	return NULL;
+}
+
+/*
+ * Complete the key of an action with the captured event field value at
+ * `capture_index` in `buf`.
+ */
+static int format_captured_key(const char *key,
+		const struct lttng_event_field_value *captured_values,
+		unsigned int capture_index, char *buf, size_t buf_len)
+{
+	int ret;
+	const struct lttng_event_field_value *value = NULL;
+
+	if (!captured_values ||
+			lttng_event_field_value_array_get_element_at_index(
+					captured_values, capture_index,
+					&value) !=
+					LTTNG_EVENT_FIELD_VALUE_STATUS_OK) {
+		value = NULL;
+	}
+
+	switch (lttng_event_field_value_get_type(value)) {
+	case LTTNG_EVENT_FIELD_VALUE_TYPE_UNSIGNED_INT:
+	case LTTNG_EVENT_FIELD_VALUE_TYPE_UNSIGNED_ENUM:
+	{
+		uint64_t uint_value;
+
+		(void) lttng_event_field_value_unsigned_int_get_value(value,
+				&uint_value);
+		ret = snprintf(buf, buf_len, "%s=%" PRIu64, key, uint_value);
+		break;
+	}
+	case LTTNG_EVENT_FIELD_VALUE_TYPE_SIGNED_INT:
+	case LTTNG_EVENT_FIELD_VALUE_TYPE_SIGNED_ENUM:
+	{
+		int64_t int_value;
+
+		(void) lttng_event_field_value_signed_int_get_value(value,
+				&int_value);
+		ret = snprintf(buf, buf_len, "%s=%" PRId64, key, int_value);
+		break;
+	}
+	case LTTNG_EVENT_FIELD_VALUE_TYPE_REAL:
+	{
+		double real_value;
+
+		(void) lttng_event_field_value_real_get_value(value,
+				&real_value);
+		ret = snprintf(buf, buf_len, "%s=%g", key, real_value);
+		break;
+	}
+	case LTTNG_EVENT_FIELD_VALUE_TYPE_STRING:
+	{
+		const char *string_value;
+
+		(void) lttng_event_field_value_string_get_value(value,
+				&string_value);
+		ret = snprintf(buf, buf_len, "%s=%s", key, string_value);
+		break;
+	}
+	default:
+		/* Unavailable or array value. */
+		ret = snprintf(buf, buf_len, "%s=?", key);
+		break;
+	}
+
+	/* Long keys are truncated. */
+	return ret < 0 ? -1 : 0;
+}
+
+void counter_map_increment(uid_t uid, const struct lttng_action *action,
+		const struct lttng_event_field_value *captured_values)
+{
+	const char *map_name, *key;
+	unsigned int capture_index;
+	enum lttng_action_status status;
+	struct counter_map *map;
+	struct counter_map_entry *entry;
+	char captured_key[DEFAULT_COUNTER_MAP_KEY_MAX_LEN];
+
+	status = lttng_action_increment_counter_get_map_name(action, &map_name);
+	assert(status == LTTNG_ACTION_STATUS_OK);
+	status = lttng_action_increment_counter_get_key(action, &key);
+	assert(status == LTTNG_ACTION_STATUS_OK);
+
+	rcu_read_lock();
+	map = get_map(uid, map_name, true);
+	if (!map) {
+		ERR("Failed to allocate counter map: map-name = `%s`",
+				map_name);
+		goto end;
+	}
+
+	status = lttng_action_increment_counter_get_key_capture_index(
+			action, &capture_index);
+	if (status == LTTNG_ACTION_STATUS_OK) {
+		if (format_captured_key(key, captured_values, capture_index,
+				captured_key, sizeof(captured_key))) {
+			uatomic_inc(&map->dropped_count);
+			goto end;
+		}
+		key = captured_key;
+	}
+
+	entry = get_entry(map, key);
+	if (!entry) {
+		DBG("Dropping counter map increment: map-name = `%s`, key = `%s`",
+				map_name, key);
+		uatomic_inc(&map->dropped_count);
+		goto end;
+	}
+
+	uatomic_inc(&entry->value);
+end:
+	rcu_read_unlock();
+}
+
+/*
+ * Call `cb` on every increment-counter action of a trigger, directly or
+ * within a group.
+ */
+static void for_each_counter_action(const struct lttng_trigger *trigger,
+		void (*cb)(uid_t, const struct lttng_action *, const void *),
+		const void *data)
+{
+	uid_t uid;
+	unsigned int i, count;
+	enum lttng_trigger_status trigger_status;
+	const struct lttng_action *action =
+			lttng_trigger_get_const_action(trigger);
+
+	trigger_status = lttng_trigger_get_owner_uid(trigger, &uid);
+	assert(trigger_status == LTTNG_TRIGGER_STATUS_OK);
+
+	switch (lttng_action_get_type(action)) {
+	case LTTNG_ACTION_TYPE_INCREMENT_COUNTER:
+		cb(uid, action, data);
+		break;
+	case LTTNG_ACTION_TYPE_GROUP:
+		if (lttng_action_group_get_count(action, &count) !=
+				LTTNG_ACTION_STATUS_OK) {
+			break;
+		}
+
+		for (i = 0; i < count; i++) {
+			const struct lttng_action *child =
+					lttng_action_group_get_at_index(
+							action, i);
+
+			if (lttng_action_get_type(child) ==
+					LTTNG_ACTION_TYPE_INCREMENT_COUNTER) {
+				cb(uid, child, data);
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void increment_action(uid_t uid, const struct lttng_action *action,
+		const void *captured_values)
+{
+	counter_map_increment(uid, action, captured_values);
+}
+
+void counter_map_increment_trigger(const struct lttng_trigger *trigger,
+		const struct lttng_event_field_value *captured_values)
+{
+	for_each_counter_action(trigger, increment_action, captured_values);
+}
+
+static void drop_action(uid_t uid, const struct lttng_action *action,
+		const void *data)
+{
+	const char *map_name;
+	struct counter_map *map;
+	enum lttng_action_status status;
+
+	status = lttng_action_increment_counter_get_map_name(action, &map_name);
+	assert(status == LTTNG_ACTION_STATUS_OK);
+
+	rcu_read_lock();
+	map = get_map(uid, map_name, true);
+	if (map) {
+		uatomic_inc(&map->dropped_count);
+	}
+	rcu_read_unlock();
+}
+
+void counter_map_drop_trigger(const struct lttng_trigger *trigger)
+{
+	for_each_counter_action(trigger, drop_action, NULL);
+}
+
+struct map_action_count {
+	const char *map_name;
+	unsigned int count;
+};
+
+static void count_map_action(uid_t uid, const struct lttng_action *action,
+		const void *data)
+{
+	const char *map_name;
+	struct map_action_count *action_count = (void *) data;
+	enum lttng_action_status status;
+
+	status = lttng_action_increment_counter_get_map_name(action, &map_name);
+	assert(status == LTTNG_ACTION_STATUS_OK);
+	if (!strcmp(map_name, action_count->map_name)) {
+		action_count->count++;
+	}
+}
+
+/*
+ * Number of increment-counter actions of a trigger of `uid` targeting
+ * `map_name`, if the firings of the trigger are notified by a tracer.
+ */
+static unsigned int get_tracer_action_count(const struct lttng_trigger *trigger,
+		uid_t uid, const char *map_name)
+{
+	uid_t trigger_uid;
+	struct map_action_count action_count = { .map_name = map_name };
+
+	if (lttng_trigger_get_owner_uid(trigger, &trigger_uid) !=
+			LTTNG_TRIGGER_STATUS_OK || trigger_uid != uid) {
+		return 0;
+	}
+
+	if (lttng_condition_get_type(lttng_trigger_get_const_condition(
+			trigger)) != LTTNG_CONDITION_TYPE_ON_EVENT) {
+		return 0;
+	}
+
+	for_each_counter_action(trigger, count_map_action, &action_count);
+	return action_count.count;
+}
+
+/* The lock of the map must be held. */
+static uint64_t get_discard_baseline(const struct counter_map *map,
+		uint64_t tracer_token)
+{
+	size_t i;
+
+	for (i = 0; i < lttng_dynamic_array_get_count(&map->discard_baselines);
+			i++) {
+		const struct discard_baseline *baseline =
+				lttng_dynamic_array_get_element(
+						&map->discard_baselines, i);
+
+		if (baseline->tracer_token == tracer_token) {
+			return baseline->count;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Increments of a map lost by the tracers since the map was last cleared.
+ * The lock of the map, if any, must be held.
+ */
+static uint64_t get_tracer_dropped_count(const struct counter_map *map,
+		uid_t uid, const char *map_name,
+		const struct lttng_triggers *triggers)
+{
+	unsigned int i, count;
+	uint64_t dropped_count = 0;
+
+	if (lttng_triggers_get_count(triggers, &count) !=
+			LTTNG_TRIGGER_STATUS_OK) {
+		return 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		uint64_t discards, baseline;
+		const struct lttng_trigger *trigger =
+				lttng_triggers_get_at_index(triggers, i);
+		const unsigned int action_count = get_tracer_action_count(
+				trigger, uid, map_name);
+
+		if (!action_count) {
+			continue;
+		}
+
+		discards = lttng_condition_on_event_get_error_count(
+				lttng_trigger_get_const_condition(trigger));
+		baseline = map ? get_discard_baseline(map,
+					lttng_trigger_get_tracer_token(
+							trigger)) :
+				0;
+		if (discards > baseline) {
+			dropped_count += (discards - baseline) * action_count;
+		}
+	}
+
+	return dropped_count;
+}
+
+enum lttng_error_code counter_map_list_values(uid_t uid, const char *map_name,
+		const struct lttng_triggers *triggers,
+		struct lttng_counter_map_values **values)
+{
+	enum lttng_error_code ret_code;
+	uint64_t dropped_count = 0;
+	struct cds_lfht_iter iter;
+	struct counter_map *map;
+	struct counter_map_entry *entry;
+	struct lttng_counter_map_values *local_values;
+
+	local_values = lttng_counter_map_values_create();
+	if (!local_values) {
+		ret_code = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
+	rcu_read_lock();
+	map = get_map(uid, map_name, false);
+	if (!map) {
+		/* No key was incremented, but increments may have been lost. */
+		dropped_count = get_tracer_dropped_count(NULL, uid, map_name,
+				triggers);
+		goto unlock;
+	}
+
+	cds_lfht_for_each_entry(counter_map_ht, &iter, entry, node) {
+		if (entry->map != map) {
+			continue;
+		}
+
+		if (lttng_counter_map_values_add(local_values, entry->key,
+				uatomic_read(&entry->value))) {
+			rcu_read_unlock();
+			ret_code = LTTNG_ERR_NOMEM;
+			goto end;
+		}
+	}
+
+	pthread_mutex_lock(&map->lock);
+	dropped_count = uatomic_read(&map->dropped_count) +
+			get_tracer_dropped_count(map, uid, map_name, triggers);
+	pthread_mutex_unlock(&map->lock);
+unlock:
+	rcu_read_unlock();
+
+	lttng_counter_map_values_set_dropped_count(local_values, dropped_count);
+	*values = local_values;
+	local_values = NULL;
+	ret_code = LTTNG_OK;
+end:
+	lttng_counter_map_values_destroy(local_values);
+	return ret_code;
+}
+
+enum lttng_error_code counter_map_clear(uid_t uid, const char *map_name,
+		const struct lttng_triggers *triggers)
+{
+	enum lttng_error_code ret_code = LTTNG_OK;
+	unsigned int i, count;
+	struct cds_lfht_iter iter;
+	struct counter_map *map;
+	struct counter_map_entry *entry;
+
+	rcu_read_lock();
+	/* Keep the tracer discards of the map to count from them. */
+	map = get_map(uid, map_name, true);
+	if (!map) {
+		ret_code = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
+	/*
+	 * An increment racing with the removal of its entry is lost, as if
+	 * it happened before the clear.
+	 */
+	cds_lfht_for_each_entry(counter_map_ht, &iter, entry, node) {
+		if (entry->map != map) {
+			continue;
+		}
+
+		if (!cds_lfht_del(counter_map_ht, &entry->node)) {
+			uatomic_dec(&map->key_count);
+			call_rcu(&entry->rcu_head, free_entry_rcu);
+		}
+	}
+
+	pthread_mutex_lock(&map->lock);
+	uatomic_set(&map->dropped_count, 0);
+	lttng_dynamic_array_clear(&map->discard_baselines);
+	if (lttng_triggers_get_count(triggers, &count) !=
+			LTTNG_TRIGGER_STATUS_OK) {
+		count = 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		struct discard_baseline baseline;
+		const struct lttng_trigger *trigger =
+				lttng_triggers_get_at_index(triggers, i);
+
+		if (!get_tracer_action_count(trigger, uid, map_name)) {
+			continue;
+		}
+
+		baseline.tracer_token = lttng_trigger_get_tracer_token(trigger);
+		baseline.count = lttng_condition_on_event_get_error_count(
+				lttng_trigger_get_const_condition(trigger));
+		if (lttng_dynamic_array_add_element(&map->discard_baselines,
+				&baseline)) {
+			ret_code = LTTNG_ERR_NOMEM;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&map->lock);
+end:
+	rcu_read_unlock();
+	return ret_code;
+}
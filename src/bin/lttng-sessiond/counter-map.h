@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_SESSIOND_COUNTER_MAP_H
+#define LTTNG_SESSIOND_COUNTER_MAP_H
+
+#include <sys/types.h>
+#include <lttng/lttng-error.h>
+
+struct lttng_action;
+struct lttng_counter_map_values;
+struct lttng_event_field_value;
+struct lttng_trigger;
+struct lttng_triggers;
+
+/*
+ * Counter maps incremented by the increment-counter actions of triggers.
+ *
+ * The values are kept per (owner uid, map name, key). A key is added to its
+ * map on its first increment and removed when the map is cleared. The
+ * increments which can't be applied are counted as dropped by their map.
+ */
+int counter_map_init(void);
+void counter_map_fini(void);
+
+/*
+ * Apply an increment-counter action on behalf of `uid`. `captured_values`
+ * are the event field values captured by the firing, if any. Safe to call
+ * concurrently with the other functions of this module.
+ */
+void counter_map_increment(uid_t uid, const struct lttng_action *action,
+		const struct lttng_event_field_value *captured_values);
+
+/* Apply every increment-counter action of a firing trigger. */
+void counter_map_increment_trigger(const struct lttng_trigger *trigger,
+		const struct lttng_event_field_value *captured_values);
+
+/* Count the increments of a firing trigger as dropped. */
+void counter_map_drop_trigger(const struct lttng_trigger *trigger);
+
+/*
+ * List and clear a map of `uid`. `triggers` are the registered triggers,
+ * with up to date error counts, whose notifications discarded by the tracers
+ * are counted as dropped increments of the map.
+ */
+enum lttng_error_code counter_map_list_values(uid_t uid, const char *map_name,
+		const struct lttng_triggers *triggers,
+		struct lttng_counter_map_values **values);
+
+enum lttng_error_code counter_map_clear(uid_t uid, const char *map_name,
+		const struct lttng_triggers *triggers);
+
+#endif /* LTTNG_SESSIOND_COUNTER_MAP_H */
@@ -10,6 +10,7 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <urcu.h>
+#include <common/defaults.h>
 #include <common/futex.h>
 #include <common/macros.h>
 
@@ -20,6 +21,7 @@
 #include "health-sessiond.h"
 #include "lttng-sessiond.h"
 #include "thread.h"
+#include "utils.h"
 
 struct thread_notifiers {
 	struct ust_cmd_queue *ust_cmd_queue;
@@ -72,6 +74,7 @@ static void update_ust_app(int app_sock)
 		}
 
 		ust_app_global_update(sess->ust_session, app);
+		ust_buffer_pool_schedule_refill(sess);
 	unlock_session:
 		session_unlock(sess);
 		session_put(sess);
@@ -81,6 +84,59 @@ unlock_rcu:
 	rcu_read_unlock();
 }
 
+/*
+ * Add an application waiting for its notify socket to the wait queue.
+ */
+static void wait_queue_add(struct ust_reg_wait_queue *wait_queue,
+		struct ust_reg_wait_node *wait_node)
+{
+	lttng_ht_node_init_ulong(&wait_node->pid_n,
+			(unsigned long) wait_node->app->pid);
+	rcu_read_lock();
+	lttng_ht_add_ulong(wait_queue->pid_ht, &wait_node->pid_n);
+	rcu_read_unlock();
+	cds_list_add(&wait_node->head, &wait_queue->head);
+	wait_queue->count++;
+}
+
+static void wait_queue_remove(struct ust_reg_wait_queue *wait_queue,
+		struct ust_reg_wait_node *wait_node)
+{
+	int ret;
+	struct lttng_ht_iter iter;
+
+	iter.iter.node = &wait_node->pid_n.node;
+	rcu_read_lock();
+	ret = lttng_ht_del(wait_queue->pid_ht, &iter);
+	assert(!ret);
+	rcu_read_unlock();
+	cds_list_del(&wait_node->head);
+	wait_queue->count--;
+}
+
+/*
+ * Find an application, by pid, in the wait queue. Returns NULL if no
+ * application of that pid is waiting for its notify socket.
+ */
+static struct ust_reg_wait_node *wait_queue_find_by_pid(
+		struct ust_reg_wait_queue *wait_queue, pid_t pid)
+{
+	struct lttng_ht_iter iter;
+	struct lttng_ht_node_ulong *node;
+	struct ust_reg_wait_node *wait_node = NULL;
+
+	rcu_read_lock();
+	lttng_ht_lookup(wait_queue->pid_ht, (void *) ((unsigned long) pid),
+			&iter);
+	node = lttng_ht_iter_get_node_ulong(&iter);
+	if (node) {
+		wait_node = caa_container_of(node, struct ust_reg_wait_node,
+				pid_n);
+	}
+	rcu_read_unlock();
+	return wait_node;
+}
+
 /*
  * Sanitize the wait queue of the dispatch registration thread meaning removing
  * invalid nodes from it. This is to avoid memory leaks for the case the UST
@@ -138,12 +194,15 @@ static void sanitize_wait_queue(struct ust_reg_wait_queue *wait_queue)
 		uint32_t revents = LTTNG_POLL_GETEV(&events, i);
 		int pollfd = LTTNG_POLL_GETFD(&events, i);
 
+		if (!(revents & (LPOLLHUP | LPOLLERR))) {
+			ERR("Unexpected poll events %u for sock %d", revents, pollfd);
+			goto error;
+		}
+
 		cds_list_for_each_entry_safe(wait_node, tmp_wait_node,
 				&wait_queue->head, head) {
-			if (pollfd == wait_node->app->sock &&
-					(revents & (LPOLLHUP | LPOLLERR))) {
-				cds_list_del(&wait_node->head);
-				wait_queue->count--;
+			if (pollfd == wait_node->app->sock) {
+				wait_queue_remove(wait_queue, wait_node);
 				ust_app_destroy(wait_node->app);
 				free(wait_node);
 				/*
@@ -153,9 +212,6 @@ static void sanitize_wait_queue(struct ust_reg_wait_queue *wait_queue)
 				 */
 				wait_node = NULL;
 				break;
-			} else {
-				ERR("Unexpected poll events %u for sock %d", revents, pollfd);
-				goto error;
 			}
 		}
 	}
@@ -213,6 +269,95 @@ error:
 	return (int) ret;
 }
 
+/*
+ * Publish the applications which received both of their sockets, in
+ * registration order, and hand them over to the application management
+ * threads. The session list lock is acquired once for the whole batch.
+ *
+ * Dispatched applications are removed from the ready list. Returns 0 on
+ * success, or a negative value if an application management thread is gone.
+ */
+static int dispatch_ready_apps(struct cds_list_head *ready_apps,
+		unsigned int *ready_count, struct thread_notifiers *notifiers)
+{
+	int ret = 0;
+	struct ust_reg_wait_node *wait_node, *tmp_wait_node;
+
+	if (cds_list_empty(ready_apps)) {
+		goto end;
+	}
+
+	DBG("Dispatching a batch of %u registered UST applications",
+			*ready_count);
+
+	/*
+	 * @session_lock_list
+	 *
+	 * Lock the global session list so from the register up to the
+	 * registration done message, no thread can see the applications
+	 * and change their state.
+	 */
+	session_lock_list();
+	rcu_read_lock();
+	cds_list_for_each_entry_safe(wait_node, tmp_wait_node, ready_apps,
+			head) {
+		struct ust_app *app = wait_node->app;
+
+		health_code_update();
+
+		/*
+		 * Add application to the global hash table. This needs to be
+		 * done before the update to the UST registry can locate the
+		 * application.
+		 */
+		ust_app_add(app);
+
+		/* Set app version. This call will print an error if needed. */
+		(void) ust_app_version(app);
+
+		(void) ust_app_setup_event_notifier_group(app);
+
+		/* Send notify socket through the notify pipe. */
+		ret = send_socket_to_thread(
+				notifiers->apps_cmd_notify_pipe_write_fd,
+				app->notify_sock);
+		if (ret < 0) {
+			break;
+		}
+
+		/*
+		 * Update newly registered application with the tracing
+		 * registry info already enabled information.
+		 */
+		update_ust_app(app->sock);
+
+		/*
+		 * Don't care about return value. Let the manage apps threads
+		 * handle app unregistration upon socket close.
+		 */
+		(void) ust_app_register_done(app);
+
+		/*
+		 * Even if the application socket has been closed, send the app
+		 * to the thread and unregistration will take place at that
+		 * place.
+		 */
+		ret = send_socket_to_thread(notifiers->apps_cmd_pipe_write_fd,
+				app->sock);
+		if (ret < 0) {
+			break;
+		}
+
+		cds_list_del(&wait_node->head);
+		(*ready_count)--;
+		free(wait_node);
+	}
+	rcu_read_unlock();
+	session_unlock_list();
+end:
+	return ret;
+}
+
 static void cleanup_ust_dispatch_thread(void *data)
 {
 	free(data);
@@ -231,6 +376,9 @@ static void *thread_dispatch_ust_registration(void *data)
 	struct ust_reg_wait_queue wait_queue = {
 		.count = 0,
 	};
+	/* Applications which received both of their sockets. */
+	struct cds_list_head ready_apps;
+	unsigned int ready_count = 0;
 	struct thread_notifiers *notifiers = data;
 
 	rcu_register_thread();
@@ -244,6 +392,11 @@ static void *thread_dispatch_ust_registration(void *data)
 	health_code_update();
 
 	CDS_INIT_LIST_HEAD(&wait_queue.head);
+	CDS_INIT_LIST_HEAD(&ready_apps);
+	wait_queue.pid_ht = lttng_ht_new(0, LTTNG_HT_TYPE_ULONG);
+	if (!wait_queue.pid_ht) {
+		goto error_testpoint;
+	}
 
 	DBG("[thread] Dispatch UST command started");
 
@@ -257,17 +410,17 @@ static void *thread_dispatch_ust_registration(void *data)
 			break;
 		}
 
-		do {
-			struct ust_app *app = NULL;
-			ust_cmd = NULL;
-
-			/*
-			 * Make sure we don't have node(s) that have hung up before receiving
-			 * the notify socket. This is to clean the list in order to avoid
-			 * memory leaks from notify socket that are never seen.
-			 */
-			sanitize_wait_queue(&wait_queue);
+		/*
+		 * Make sure we don't have node(s) that have hung up before
+		 * receiving the notify socket. This is to clean the list in order
+		 * to avoid memory leaks from notify socket that are never seen.
+		 *
+		 * This is done once per wake-up rather than for every command
+		 * as it polls every socket of the wait queue.
+		 */
+		sanitize_wait_queue(&wait_queue);
 
+		do {
 			health_code_update();
 			/* Dequeue command for registration */
 			node = cds_wfcq_dequeue_blocking(
@@ -322,8 +475,7 @@ static void *thread_dispatch_ust_registration(void *data)
 				 * Add application to the wait queue so we can set the notify
 				 * socket before putting this object in the global ht.
 				 */
-				cds_list_add(&wait_node->head, &wait_queue.head);
-				wait_queue.count++;
+				wait_queue_add(&wait_queue, wait_node);
 
 				free(ust_cmd);
 				ust_cmd = NULL;
@@ -333,118 +485,62 @@ static void *thread_dispatch_ust_registration(void *data)
 				 * only at that moment.
 				 */
 				continue;
-			} else {
-				/*
-				 * Look for the application in the local wait queue and set the
-				 * notify socket if found.
-				 */
-				cds_list_for_each_entry_safe(wait_node, tmp_wait_node,
-						&wait_queue.head, head) {
-					health_code_update();
-					if (wait_node->app->pid == ust_cmd->reg_msg.pid) {
-						wait_node->app->notify_sock = ust_cmd->sock;
-						cds_list_del(&wait_node->head);
-						wait_queue.count--;
-						app = wait_node->app;
-						free(wait_node);
-						wait_node = NULL;
-						DBG3("UST app notify socket %d is set", ust_cmd->sock);
-						break;
-					}
-				}
-
-				/*
-				 * With no application at this stage the received socket is
-				 * basically useless so close it before we free the cmd data
-				 * structure for good.
-				 */
-				if (!app) {
-					ret = close(ust_cmd->sock);
-					if (ret < 0) {
-						PERROR("close ust sock dispatch %d", ust_cmd->sock);
-					}
-					lttng_fd_put(LTTNG_FD_APPS, 1);
-				}
-				free(ust_cmd);
-				ust_cmd = NULL;
 			}
 
-			if (app) {
-				/*
-				 * @session_lock_list
-				 *
-				 * Lock the global session list so from the register up to the
-				 * registration done message, no thread can see the application
-				 * and change its state.
-				 */
-				session_lock_list();
-				rcu_read_lock();
-
+			/*
+			 * Look for the application in the local wait queue and set the
+			 * notify socket if found.
+			 */
+			wait_node = wait_queue_find_by_pid(&wait_queue,
+					ust_cmd->reg_msg.pid);
+			if (wait_node) {
+				wait_queue_remove(&wait_queue, wait_node);
+				wait_node->app->notify_sock = ust_cmd->sock;
+				DBG3("UST app notify socket %d is set", ust_cmd->sock);
+
+				/* The application is published with its batch. */
+				cds_list_add_tail(&wait_node->head, &ready_apps);
+				ready_count++;
+				wait_node = NULL;
+			} else {
 				/*
-				 * Add application to the global hash table. This needs to be
-				 * done before the update to the UST registry can locate the
-				 * application.
+				 * With no application at this stage the received
+				 * socket is basically useless so close it before we
+				 * free the cmd data structure for good.
 				 */
-				ust_app_add(app);
-
-				/* Set app version. This call will print an error if needed. */
-				(void) ust_app_version(app);
-
-				(void) ust_app_setup_event_notifier_group(app);
-
-				/* Send notify socket through the notify pipe. */
-				ret = send_socket_to_thread(
-						notifiers->apps_cmd_notify_pipe_write_fd,
-						app->notify_sock);
+				ret = close(ust_cmd->sock);
 				if (ret < 0) {
-					rcu_read_unlock();
-					session_unlock_list();
-					/*
-					 * No notify thread, stop the UST tracing. However, this is
-					 * not an internal error of the this thread thus setting
-					 * the health error code to a normal exit.
-					 */
-					err = 0;
-					goto error;
+					PERROR("close ust sock dispatch %d", ust_cmd->sock);
 				}
+				lttng_fd_put(LTTNG_FD_APPS, 1);
+			}
+			free(ust_cmd);
+			ust_cmd = NULL;
 
-				/*
-				 * Update newly registered application with the tracing
-				 * registry info already enabled information.
-				 */
-				update_ust_app(app->sock);
-
-				/*
-				 * Don't care about return value. Let the manage apps threads
-				 * handle app unregistration upon socket close.
-				 */
-				(void) ust_app_register_done(app);
-
-				/*
-				 * Even if the application socket has been closed, send the app
-				 * to the thread and unregistration will take place at that
-				 * place.
-				 */
-				ret = send_socket_to_thread(
-						notifiers->apps_cmd_pipe_write_fd,
-						app->sock);
+			if (ready_count >= DEFAULT_APP_REG_DISPATCH_BATCH_SIZE) {
+				ret = dispatch_ready_apps(&ready_apps,
+						&ready_count, notifiers);
 				if (ret < 0) {
-					rcu_read_unlock();
-					session_unlock_list();
 					/*
-					 * No apps. thread, stop the UST tracing. However, this is
-					 * not an internal error of the this thread thus setting
-					 * the health error code to a normal exit.
+					 * No apps. or notify thread, stop the UST
+					 * tracing. However, this is not an internal
+					 * error of the this thread thus setting the
+					 * health error code to a normal exit.
 					 */
 					err = 0;
 					goto error;
 				}
-
-				rcu_read_unlock();
-				session_unlock_list();
 			}
 		} while (node != NULL);
 
+		/* Publish the last, partial, batch before going to sleep. */
+		ret = dispatch_ready_apps(&ready_apps, &ready_count, notifiers);
+		if (ret < 0) {
+			/* See above. */
+			err = 0;
+			goto error;
+		}
+
 		health_poll_entry();
 		/* Futex wait on queue. Blocking call on futex() */
 		futex_nto1_wait(&notifiers->ust_cmd_queue->futex);
@@ -457,10 +553,16 @@ error:
 	/* Clean up wait queue. */
 	cds_list_for_each_entry_safe(wait_node, tmp_wait_node,
 			&wait_queue.head, head) {
+		wait_queue_remove(&wait_queue, wait_node);
+		free(wait_node);
+	}
+	cds_list_for_each_entry_safe(wait_node, tmp_wait_node,
+			&ready_apps, head) {
 		cds_list_del(&wait_node->head);
-		wait_queue.count--;
+		ready_count--;
 		free(wait_node);
 	}
+	ht_cleanup_push(wait_queue.pid_ht);
 
 	/* Empty command queue. */
 	for (;;) {
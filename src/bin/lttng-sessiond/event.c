@@ -252,6 +252,95 @@ error:
 	return ret;
 }
 
+/*
+ * Enable a set of UST tracepoints, without filter nor exclusion, on a channel
+ * of a UST session. All the events are enabled on the session before the
+ * registered applications are updated in a single pass.
+ *
+ * The outcome of each event is stored in ret_codes. Events whose return code
+ * is not LTTNG_OK on entry are skipped.
+ *
+ * Return LTTNG_OK if the set was processed, else an LTTng error code.
+ */
+int event_ust_enable_tracepoints(struct ltt_ust_session *usess,
+		struct ltt_ust_channel *uchan, struct lttng_event *events,
+		unsigned int event_count, enum lttng_error_code *ret_codes)
+{
+	int ret;
+	unsigned int i, uevent_count = 0;
+	struct ltt_ust_event **uevents;
+
+	assert(usess);
+	assert(uchan);
+	assert(events);
+	assert(ret_codes);
+
+	uevents = zmalloc(sizeof(*uevents) * event_count);
+	if (!uevents) {
+		ret = LTTNG_ERR_NOMEM;
+		goto end;
+	}
+
+	rcu_read_lock();
+
+	for (i = 0; i < event_count; i++) {
+		struct lttng_event *event = &events[i];
+		struct ltt_ust_event *uevent;
+
+		if (ret_codes[i] != LTTNG_OK) {
+			continue;
+		}
+
+		uevent = trace_ust_find_event(uchan->events, event->name, NULL,
+				(enum lttng_ust_abi_loglevel_type) event->loglevel_type,
+				event->loglevel, NULL);
+		if (!uevent) {
+			ret = trace_ust_create_event(event, NULL, NULL, NULL,
+					false, &uevent);
+			if (ret != LTTNG_OK) {
+				ret_codes[i] = ret;
+				continue;
+			}
+
+			/* Add ltt ust event to channel */
+			add_unique_ust_event(uchan->events, uevent);
+		} else if (uevent->enabled) {
+			/* It's already enabled so everything is OK */
+			ret_codes[i] = LTTNG_ERR_UST_EVENT_ENABLED;
+			continue;
+		}
+
+		uevent->enabled = 1;
+		uevents[uevent_count++] = uevent;
+	}
+
+	if (!usess->active || uevent_count == 0) {
+		goto done;
+	}
+
+	/*
+	 * The events stay enabled on the session if an application could not
+	 * be updated; they are synchronized when the applications register.
+	 */
+	ret = ust_app_enable_events_glb(usess, uchan, uevents, uevent_count);
+	if (ret < 0) {
+		for (i = 0; i < event_count; i++) {
+			if (ret_codes[i] == LTTNG_OK) {
+				ret_codes[i] = LTTNG_ERR_UST_ENABLE_FAIL;
+			}
+		}
+	}
+
+	DBG("%u UST events enabled in channel %s", uevent_count, uchan->name);
+
+done:
+	rcu_read_unlock();
+	ret = LTTNG_OK;
+	free(uevents);
+end:
+	return ret;
+}
+
 /*
  * Disable UST tracepoint of a channel from a UST session.
  */
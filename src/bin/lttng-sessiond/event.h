@@ -25,6 +25,9 @@ int event_ust_enable_tracepoint(struct ltt_ust_session *usess,
 		struct lttng_bytecode *filter,
 		struct lttng_event_exclusion *exclusion,
 		bool internal_event);
+int event_ust_enable_tracepoints(struct ltt_ust_session *usess,
+		struct ltt_ust_channel *uchan, struct lttng_event *events,
+		unsigned int event_count, enum lttng_error_code *ret_codes);
 int event_ust_disable_tracepoint(struct ltt_ust_session *usess,
 		struct ltt_ust_channel *uchan, const char *event_name);
 
@@ -21,6 +21,8 @@ struct health_app *health_sessiond;
 
 struct notification_thread_handle *notification_thread_handle;
 
+struct rotation_thread_timer_queue *rotation_timer_queue;
+
 struct lttng_ht *agent_apps_ht_by_sock = NULL;
 struct lttng_ht *trigger_agents_ht_by_domain = NULL;
 
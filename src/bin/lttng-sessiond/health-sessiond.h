@@ -24,6 +24,7 @@ enum health_type_sessiond {
 	HEALTH_SESSIOND_TYPE_ROTATION		= 9,
 	HEALTH_SESSIOND_TYPE_TIMER		= 10,
 	HEALTH_SESSIOND_TYPE_ACTION_EXECUTOR	= 11,
+	HEALTH_SESSIOND_TYPE_APP_REAPER		= 12,
 
 	NR_HEALTH_SESSIOND_TYPES,
 };
@@ -93,7 +93,7 @@ int kernel_consumer_add_channel(struct consumer_socket *sock,
 	enum lttng_error_code status;
 	struct ltt_session *session = NULL;
 	struct lttng_channel_extended *channel_attr_extended;
-	bool is_local_trace;
+	bool has_local_output;
 	size_t consumer_path_offset = 0;
 
 	/* Safety net */
@@ -107,7 +107,7 @@ int kernel_consumer_add_channel(struct consumer_socket *sock,
 
 	DBG("Kernel consumer adding channel %s to kernel consumer",
 			channel->channel->name);
-	is_local_trace = consumer->net_seq_index == -1ULL;
+	has_local_output = consumer_output_has_local_output(consumer);
 
 	pathname = create_channel_path(consumer, &consumer_path_offset);
 	if (!pathname) {
@@ -115,7 +115,7 @@ int kernel_consumer_add_channel(struct consumer_socket *sock,
 		goto error;
 	}
 
-	if (is_local_trace && ksession->current_trace_chunk) {
+	if (has_local_output && ksession->current_trace_chunk) {
 		enum lttng_trace_chunk_status chunk_status;
 		char *pathname_index;
 
@@ -158,6 +158,8 @@ int kernel_consumer_add_channel(struct consumer_socket *sock,
 			channel->channel->attr.live_timer_interval,
 			ksession->is_live_session,
 			channel_attr_extended->monitor_timer_interval,
+			channel_attr_extended->writeback_window_size,
+			channel_attr_extended->direct_io,
 			ksession->current_trace_chunk);
 
 	health_code_update();
@@ -238,7 +240,7 @@ int kernel_consumer_add_metadata(struct consumer_socket *sock,
 			monitor,
 			ksession->metadata->conf->attr.live_timer_interval,
 			ksession->is_live_session,
-			0,
+			0, 0, false,
 			ksession->current_trace_chunk);
 
 	health_code_update();
@@ -273,47 +275,81 @@ error:
 }
 
 /*
- * Sending a single stream to the consumer with command ADD_STREAM.
+ * Send the streams of a channel that were not yet handed to the consumer with
+ * a single ADD_STREAMS command.
+ *
+ * Return 0 on success else a negative value.
  */
 static
-int kernel_consumer_add_stream(struct consumer_socket *sock,
+int kernel_consumer_add_streams(struct consumer_socket *sock,
 		struct ltt_kernel_channel *channel,
-		struct ltt_kernel_stream *stream,
-		struct ltt_kernel_session *session, unsigned int monitor)
+		struct ltt_kernel_session *session)
 {
-	int ret;
+	int ret = 0;
+	unsigned int stream_count = 0, i = 0;
 	struct lttcomm_consumer_msg lkm;
-	struct consumer_output *consumer;
+	struct lttcomm_consumer_stream_info *infos = NULL;
+	struct ltt_kernel_stream *stream;
+	int *fds = NULL;
 
 	assert(channel);
-	assert(stream);
 	assert(session);
 	assert(session->consumer);
 	assert(sock);
 
-	DBG("Sending stream %d of channel %s to kernel consumer",
-			stream->fd, channel->channel->name);
+	cds_list_for_each_entry(stream, &channel->stream_list.head, list) {
+		if (!stream->fd || stream->sent_to_consumer) {
+			continue;
+		}
+		stream_count++;
+	}
 
-	/* Get consumer output pointer */
-	consumer = session->consumer;
+	if (stream_count == 0) {
+		goto end;
+	}
 
-	/* Prep stream consumer message */
-	consumer_init_add_stream_comm_msg(&lkm,
-			channel->key,
-			stream->fd,
-			stream->cpu);
+	DBG("Sending %u streams of channel %s to kernel consumer",
+			stream_count, channel->channel->name);
+
+	infos = zmalloc(sizeof(*infos) * stream_count);
+	fds = zmalloc(sizeof(*fds) * stream_count);
+	if (!infos || !fds) {
+		PERROR("zmalloc stream descriptors");
+		ret = -1;
+		goto end;
+	}
+
+	cds_list_for_each_entry(stream, &channel->stream_list.head, list) {
+		if (!stream->fd || stream->sent_to_consumer) {
+			continue;
+		}
+		infos[i].cpu = stream->cpu;
+		fds[i] = stream->fd;
+		i++;
+	}
+
+	consumer_init_add_streams_comm_msg(&lkm, channel->key, stream_count);
 
 	health_code_update();
 
-	/* Send stream and file descriptor */
-	ret = consumer_send_stream(sock, consumer, &lkm, &stream->fd, 1);
+	/* Send the streams and their file descriptors in one exchange. */
+	ret = consumer_send_streams(sock, &lkm, infos, fds, stream_count);
 	if (ret < 0) {
-		goto error;
+		goto end;
+	}
+
+	cds_list_for_each_entry(stream, &channel->stream_list.head, list) {
+		if (!stream->fd) {
+			continue;
+		}
+		stream->sent_to_consumer = true;
 	}
 
 	health_code_update();
 
-error:
+end:
+	free(infos);
+	free(fds);
 	return ret;
 }
 
@@ -361,7 +397,6 @@ int kernel_consumer_send_channel_streams(struct consumer_socket *sock,
 		unsigned int monitor)
 {
 	int ret = LTTNG_OK;
-	struct ltt_kernel_stream *stream;
 
 	/* Safety net */
 	assert(channel);
@@ -388,19 +423,10 @@ int kernel_consumer_send_channel_streams(struct consumer_socket *sock,
 		channel->sent_to_consumer = true;
 	}
 
-	/* Send streams */
-	cds_list_for_each_entry(stream, &channel->stream_list.head, list) {
-		if (!stream->fd || stream->sent_to_consumer) {
-			continue;
-		}
-
-		/* Add stream on the kernel consumer side. */
-		ret = kernel_consumer_add_stream(sock, channel, stream,
-				ksession, monitor);
-		if (ret < 0) {
-			goto error;
-		}
-		stream->sent_to_consumer = true;
+	/* Add the streams on the kernel consumer side. */
+	ret = kernel_consumer_add_streams(sock, channel, ksession);
+	if (ret < 0) {
+		goto error;
 	}
 
 error:
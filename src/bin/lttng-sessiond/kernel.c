@@ -1625,6 +1625,7 @@ void kernel_destroy_session(struct ltt_kernel_session *ksess)
 
 	/* Close any relayd session */
 	consumer_output_send_destroy_relayd(ksess->consumer);
+	consumer_output_send_close_live_session(ksess->consumer, ksess->id);
 
 	trace_kernel_destroy_session(ksess);
 	lttng_trace_chunk_put(trace_chunk);
@@ -1670,14 +1671,16 @@ void kernel_destroy_channel(struct ltt_kernel_channel *kchan)
 }
 
 /*
- * Take a snapshot for a given kernel session.
+ * Take a snapshot for a given kernel session, restricted to the channels of
+ * the scope, if any.
  *
  * Return LTTNG_OK on success or else return a LTTNG_ERR code.
  */
 enum lttng_error_code kernel_snapshot_record(
 		struct ltt_kernel_session *ksess,
 		const struct consumer_output *output, int wait,
-		uint64_t nb_packets_per_stream)
+		uint64_t nb_packets_per_stream,
+		const struct snapshot_scope *scope)
 {
 	int err, ret, saved_metadata_fd;
 	enum lttng_error_code status = LTTNG_OK;
@@ -1733,10 +1736,15 @@ enum lttng_error_code kernel_snapshot_record(
 
 		/* For each channel, ask the consumer to snapshot it. */
 		cds_list_for_each_entry(chan, &ksess->channel_list.head, list) {
+			if (!snapshot_scope_has_channel(scope,
+					chan->channel->name)) {
+				continue;
+			}
 			status = consumer_snapshot_channel(socket, chan->key, output, 0,
 					ksess->uid, ksess->gid,
 					&trace_path[consumer_path_offset], wait,
-					nb_packets_per_stream);
+					nb_packets_per_stream,
+					snapshot_scope_get_begin_timestamp(scope));
 			if (status != LTTNG_OK) {
 				(void) kernel_consumer_destroy_metadata(socket,
 						ksess->metadata);
@@ -1747,7 +1755,7 @@ enum lttng_error_code kernel_snapshot_record(
 		/* Snapshot metadata, */
 		status = consumer_snapshot_channel(socket, ksess->metadata->key, output,
 				1, ksess->uid, ksess->gid, &trace_path[consumer_path_offset],
-				wait, 0);
+				wait, 0, 0);
 		if (status != LTTNG_OK) {
 			goto error_consumer;
 		}
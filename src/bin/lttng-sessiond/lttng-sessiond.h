@@ -72,6 +72,9 @@ extern struct lttng_kernel_tracer_abi_version kernel_tracer_abi_version;
 /* Notification thread handle. */
 extern struct notification_thread_handle *notification_thread_handle;
 
+/* Job queue of the rotation thread, shared with the timer thread. */
+extern struct rotation_thread_timer_queue *rotation_timer_queue;
+
 /*
  * This contains extra data needed for processing a command received by the
  * session daemon from the lttng client.
@@ -109,6 +112,8 @@ struct ust_cmd_queue {
 struct ust_reg_wait_queue {
 	unsigned long count;
 	struct cds_list_head head;
+	/* Wait nodes indexed by application pid. */
+	struct lttng_ht *pid_ht;
 };
 
 /*
@@ -118,6 +123,8 @@ struct ust_reg_wait_queue {
 struct ust_reg_wait_node {
 	struct ust_app *app;
 	struct cds_list_head head;
+	/* Node in the wait queue's pid_ht, keyed by the application's pid. */
+	struct lttng_ht_node_ulong pid_n;
 };
 
 /*
@@ -45,9 +45,11 @@
 #include "lttng-sessiond.h"
 #include "buffer-registry.h"
 #include "channel.h"
+#include "channel-advisor.h"
 #include "cmd.h"
 #include "consumer.h"
 #include "context.h"
+#include "counter-map.h"
 #include "event.h"
 #include "event-notifier-error-accounting.h"
 #include "kernel.h"
@@ -73,6 +75,7 @@
 #include "dispatch.h"
 #include "register.h"
 #include "manage-apps.h"
+#include "reap-apps.h"
 #include "manage-kernel.h"
 #include "modprobe.h"
 
@@ -85,6 +88,7 @@ NULL
 ;
 
 #define EVENT_NOTIFIER_ERROR_COUNTER_NUMBER_OF_BUCKET_MAX 65535
+#define UST_BUFFER_POOL_SIZE_MAX 1024
 
 const char *progname;
 static int lockfile_fd = -1;
@@ -107,6 +111,9 @@ static const struct option long_options[] = {
 	{ "consumerd32-libdir", required_argument, 0, '\0' },
 	{ "consumerd64-path", required_argument, 0, '\0' },
 	{ "consumerd64-libdir", required_argument, 0, '\0' },
+	{ "kconsumerd-live-url", required_argument, 0, '\0' },
+	{ "ustconsumerd32-live-url", required_argument, 0, '\0' },
+	{ "ustconsumerd64-live-url", required_argument, 0, '\0' },
 	{ "daemonize", no_argument, 0, 'd' },
 	{ "background", no_argument, 0, 'b' },
 	{ "sig-parent", no_argument, 0, 'S' },
@@ -124,6 +131,9 @@ static const struct option long_options[] = {
 	{ "kmod-probes", required_argument, 0, '\0' },
 	{ "extra-kmod-probes", required_argument, 0, '\0' },
 	{ "event-notifier-error-number-of-bucket", required_argument, 0, '\0' },
+	{ "ust-buffer-pool-size", required_argument, 0, '\0' },
+	{ "apply-channel-advice", no_argument, 0, '\0' },
+	{ "channel-advice-max-buffer-size", required_argument, 0, '\0' },
 	{ NULL, 0, 0, 0 }
 };
 
@@ -532,6 +542,8 @@ static int set_option(int opt, const char *arg, const char *optname)
 		}
 	} else if (string_match(optname, "no-kernel")) {
 		config.no_kernel = true;
+	} else if (string_match(optname, "apply-channel-advice")) {
+		config.apply_channel_advice = true;
 	} else if (string_match(optname, "quiet") || opt == 'q') {
 		config.quiet = true;
 	} else if (string_match(optname, "verbose") || opt == 'v') {
@@ -616,6 +628,51 @@ static int set_option(int opt, const char *arg, const char *optname)
 				ret = -ENOMEM;
 			}
 		}
+	} else if (string_match(optname, "kconsumerd-live-url")) {
+		if (!arg || *arg == '\0') {
+			ret = -EINVAL;
+			goto end;
+		}
+		if (lttng_is_setuid_setgid()) {
+			WARN("Getting '%s' argument from setuid/setgid binary refused for security reasons.",
+				"--kconsumerd-live-url");
+		} else {
+			config_string_set(&config.kconsumerd_live_url, strdup(arg));
+			if (!config.kconsumerd_live_url.value) {
+				PERROR("strdup");
+				ret = -ENOMEM;
+			}
+		}
+	} else if (string_match(optname, "ustconsumerd32-live-url")) {
+		if (!arg || *arg == '\0') {
+			ret = -EINVAL;
+			goto end;
+		}
+		if (lttng_is_setuid_setgid()) {
+			WARN("Getting '%s' argument from setuid/setgid binary refused for security reasons.",
+				"--ustconsumerd32-live-url");
+		} else {
+			config_string_set(&config.consumerd32_live_url, strdup(arg));
+			if (!config.consumerd32_live_url.value) {
+				PERROR("strdup");
+				ret = -ENOMEM;
+			}
+		}
+	} else if (string_match(optname, "ustconsumerd64-live-url")) {
+		if (!arg || *arg == '\0') {
+			ret = -EINVAL;
+			goto end;
+		}
+		if (lttng_is_setuid_setgid()) {
+			WARN("Getting '%s' argument from setuid/setgid binary refused for security reasons.",
+				"--ustconsumerd64-live-url");
+		} else {
+			config_string_set(&config.consumerd64_live_url, strdup(arg));
+			if (!config.consumerd64_live_url.value) {
+				PERROR("strdup");
+				ret = -ENOMEM;
+			}
+		}
 	} else if (string_match(optname, "pidfile") || opt == 'p') {
 		if (!arg || *arg == '\0') {
 			ret = -EINVAL;
@@ -718,6 +775,34 @@ static int set_option(int opt, const char *arg, const char *optname)
 		DBG3("Number of event notifier error counter set to non default: %i",
 				config.event_notifier_error_counter_bucket);
 		goto end;
+	} else if (string_match(optname, "ust-buffer-pool-size")) {
+		unsigned long v;
+
+		errno = 0;
+		v = strtoul(arg, NULL, 0);
+		if (errno != 0 || !isdigit(arg[0])) {
+			ERR("Wrong value in --ust-buffer-pool-size parameter: %s", arg);
+			return -1;
+		}
+		if (v > UST_BUFFER_POOL_SIZE_MAX) {
+			ERR("Value out of range for --ust-buffer-pool-size parameter: %s", arg);
+			return -1;
+		}
+		config.ust_buffer_pool_size = (int) v;
+		DBG3("UST buffer pool size set to non default: %i",
+				config.ust_buffer_pool_size);
+		goto end;
+	} else if (string_match(optname, "channel-advice-max-buffer-size")) {
+		uint64_t v;
+
+		if (utils_parse_size_suffix(arg, &v) < 0 || !v) {
+			ERR("Wrong value in --channel-advice-max-buffer-size parameter: %s", arg);
+			return -1;
+		}
+		config.channel_advice_max_buffer_size = v;
+		DBG3("Channel advice maximum buffer size set to non default: %" PRIu64,
+				config.channel_advice_max_buffer_size);
+		goto end;
 	} else if (string_match(optname, "config") || opt == 'f') {
 		/* This is handled in set_options() thus silent skip. */
 		goto end;
@@ -1378,7 +1463,6 @@ int main(int argc, char **argv)
 	/* Rotation thread handle. */
 	struct rotation_thread_handle *rotation_thread_handle = NULL;
 	/* Queue of rotation jobs populated by the sessiond-timer. */
-	struct rotation_thread_timer_queue *rotation_timer_queue = NULL;
 	struct lttng_thread *client_thread = NULL;
 	struct lttng_thread *notification_thread = NULL;
 	struct lttng_thread *register_apps_thread = NULL;
@@ -1612,6 +1696,12 @@ int main(int argc, char **argv)
 
 	event_notifier_error_accounting_init(config.event_notifier_error_counter_bucket);
 
+	if (counter_map_init()) {
+		ERR("Failed to allocate counter map hash table");
+		retval = -1;
+		goto stop_threads;
+	}
+
 	/*
 	 * Initialize agent app hash table. We allocate the hash table here
 	 * since cleanup() can get called after this point.
@@ -1775,6 +1865,16 @@ int main(int argc, char **argv)
 		goto stop_threads;
 	}
 
+	/*
+	 * Create thread to tear down unregistered applications. It is launched
+	 * before the application management thread so that it is shutdown
+	 * after it.
+	 */
+	if (!launch_application_reaper_thread()) {
+		retval = -1;
+		goto stop_threads;
+	}
+
 	if (!launch_ust_dispatch_thread(&ust_cmd_queue, apps_cmd_pipe[1],
 			apps_cmd_notify_pipe[1])) {
 		retval = -1;
@@ -1906,6 +2006,10 @@ stop_threads:
 	 */
 	event_notifier_error_accounting_fini();
 
+	/* The notification and client threads are stopped at this point. */
+	counter_map_fini();
+	channel_advisor_fini();
+
 	/*
 	 * Unloading the kernel modules needs to be done after all kernel
 	 * ressources have been released. In our case, this includes the
@@ -8,6 +8,7 @@
  */
 
 #include "manage-apps.h"
+#include "reap-apps.h"
 #include "testpoint.h"
 #include "health-sessiond.h"
 #include "utils.h"
@@ -31,9 +32,10 @@ static void cleanup_application_management_thread(void *data)
  * apps_cmd_pipe and waits (polls) on them until they are closed
  * or an error occurs.
  *
- * At that point, it flushes the data (tracing and metadata) associated
- * with this application and tears down ust app sessions and other
- * associated data structures through ust_app_unregister().
+ * At that point, it unregisters the application through
+ * ust_app_unregister() and hands it to the application reaper thread which
+ * flushes the data (tracing and metadata) associated with this application
+ * and tears down ust app sessions and other associated data structures.
  *
  * Note that this thread never sends commands to the applications
  * through the command sockets; it merely listens for hang-ups
@@ -46,6 +48,7 @@ static void *thread_application_management(void *data)
 	uint32_t revents, nb_fd;
 	struct lttng_poll_event events;
 	struct thread_notifiers *notifiers = data;
+	struct ust_app *app;
 	const int quit_pipe_read_fd = lttng_pipe_get_readfd(
 			notifiers->quit_pipe);
 
@@ -163,7 +166,10 @@ static void *thread_application_management(void *data)
 					}
 
 					/* Socket closed on remote end. */
-					ust_app_unregister(pollfd);
+					app = ust_app_unregister(pollfd);
+					if (app) {
+						reap_apps_enqueue(app);
+					}
 				} else {
 					ERR("Unexpected poll events %u for sock %d", revents, pollfd);
 					goto error;
@@ -259,6 +259,12 @@ static void *thread_consumer_management(void *data)
 		goto error;
 	}
 
+	/*
+	 * Open the additional command connections used to send the commands
+	 * of different sessions concurrently.
+	 */
+	consumer_create_cmd_connections(consumer_data, cmd_socket_wrapper);
+
 	/* Discard the socket wrapper as it is no longer needed. */
 	consumer_destroy_socket(cmd_socket_wrapper);
 	cmd_socket_wrapper = NULL;
@@ -373,6 +379,7 @@ error:
 		}
 		consumer_data->cmd_sock = -1;
 	}
+	consumer_close_cmd_connections(consumer_data);
 	if (consumer_data->metadata_sock.fd_ptr &&
 	    *consumer_data->metadata_sock.fd_ptr >= 0) {
 		ret = close(*consumer_data->metadata_sock.fd_ptr);
@@ -354,6 +354,40 @@ end:
 	return ret_code;
 }
 
+enum lttng_error_code notification_thread_command_get_channel_throughput(
+		struct notification_thread_handle *handle,
+		const char *session_name, enum lttng_domain_type domain,
+		const char *channel_name,
+		struct channel_throughput_summary *throughput)
+{
+	int ret;
+	enum lttng_error_code ret_code;
+	struct notification_thread_command cmd = {};
+
+	assert(handle);
+	assert(throughput);
+
+	init_notification_thread_command(&cmd);
+
+	cmd.type = NOTIFICATION_COMMAND_TYPE_GET_CHANNEL_THROUGHPUT;
+	cmd.parameters.get_channel_throughput.session_name = session_name;
+	cmd.parameters.get_channel_throughput.channel_name = channel_name;
+	cmd.parameters.get_channel_throughput.domain = domain;
+
+	ret = run_command_wait(handle, &cmd);
+	if (ret) {
+		ret_code = LTTNG_ERR_UNK;
+		goto end;
+	}
+
+	ret_code = cmd.reply_code;
+	if (ret_code == LTTNG_OK) {
+		*throughput = cmd.reply.channel_throughput;
+	}
+end:
+	return ret_code;
+}
+
 void notification_thread_command_quit(
 		struct notification_thread_handle *handle)
 {
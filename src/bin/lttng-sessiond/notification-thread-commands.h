@@ -30,6 +30,7 @@ enum notification_thread_command_type {
 	NOTIFICATION_COMMAND_TYPE_ADD_TRACER_EVENT_SOURCE,
 	NOTIFICATION_COMMAND_TYPE_REMOVE_TRACER_EVENT_SOURCE,
 	NOTIFICATION_COMMAND_TYPE_LIST_TRIGGERS,
+	NOTIFICATION_COMMAND_TYPE_GET_CHANNEL_THROUGHPUT,
 	NOTIFICATION_COMMAND_TYPE_QUIT,
 	NOTIFICATION_COMMAND_TYPE_CLIENT_COMMUNICATION_UPDATE,
 };
@@ -83,6 +84,12 @@ struct notification_thread_command {
 			/* Credentials of the requesting user. */
 			uid_t uid;
 		} list_triggers;
+		/* Get channel throughput. */
+		struct {
+			const char *session_name;
+			const char *channel_name;
+			enum lttng_domain_type domain;
+		} get_channel_throughput;
 		/* Client communication update. */
 		struct {
 			notification_client_id id;
@@ -95,6 +102,7 @@ struct notification_thread_command {
 		struct {
 			struct lttng_triggers *triggers;
 		} list_triggers;
+		struct channel_throughput_summary channel_throughput;
 	} reply;
 	/* lttng_waiter on which to wait for command reply (optional). */
 	struct lttng_waiter reply_waiter;
@@ -163,6 +171,17 @@ enum lttng_error_code notification_thread_command_remove_tracer_event_source(
 		struct notification_thread_handle *handle,
 		int tracer_event_source_fd);
 
+/*
+ * Get the throughput observed, since their creation, in the buffers of a
+ * session's channel. Return LTTNG_ERR_CHAN_NOT_FOUND if none of the buffers
+ * of the channel is monitored.
+ */
+enum lttng_error_code notification_thread_command_get_channel_throughput(
+		struct notification_thread_handle *handle,
+		const char *session_name, enum lttng_domain_type domain,
+		const char *channel_name,
+		struct channel_throughput_summary *throughput);
+
 void notification_thread_command_quit(
 		struct notification_thread_handle *handle);
 
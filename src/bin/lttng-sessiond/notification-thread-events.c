@@ -13,6 +13,7 @@
 
 #include <common/defaults.h>
 #include <common/error.h>
+#include <common/compat/time.h>
 #include <common/futex.h>
 #include <common/unix.h>
 #include <common/dynamic-buffer.h>
@@ -22,6 +23,7 @@
 #include <lttng/condition/condition.h>
 #include <lttng/action/action-internal.h>
 #include <lttng/action/group-internal.h>
+#include <lttng/action/increment-counter-internal.h>
 #include <lttng/domain-internal.h>
 #include <lttng/notification/notification-internal.h>
 #include <lttng/condition/condition-internal.h>
@@ -41,6 +43,7 @@
 #include <fcntl.h>
 
 #include "condition-internal.h"
+#include "counter-map.h"
 #include "event-notifier-error-accounting.h"
 #include "notification-thread.h"
 #include "notification-thread-events.h"
@@ -352,6 +355,8 @@ const char *notification_command_type_str(
 		return "REMOVE_TRACER_EVENT_SOURCE";
 	case NOTIFICATION_COMMAND_TYPE_LIST_TRIGGERS:
 		return "LIST_TRIGGERS";
+	case NOTIFICATION_COMMAND_TYPE_GET_CHANNEL_THROUGHPUT:
+		return "GET_CHANNEL_THROUGHPUT";
 	case NOTIFICATION_COMMAND_TYPE_QUIT:
 		return "QUIT";
 	case NOTIFICATION_COMMAND_TYPE_CLIENT_COMMUNICATION_UPDATE:
@@ -2180,6 +2185,7 @@ bool action_type_needs_tracer_notifier(enum lttng_action_type action_type)
 	case LTTNG_ACTION_TYPE_STOP_SESSION:
 	case LTTNG_ACTION_TYPE_SNAPSHOT_SESSION:
 	case LTTNG_ACTION_TYPE_ROTATE_SESSION:
+	case LTTNG_ACTION_TYPE_INCREMENT_COUNTER:
 		return true;
 	case LTTNG_ACTION_TYPE_GROUP:
 	case LTTNG_ACTION_TYPE_UNKNOWN:
@@ -2320,6 +2326,70 @@ end:
 	return ret;
 }
 
+static int handle_notification_thread_command_get_channel_throughput(
+		struct notification_thread_state *state,
+		const char *session_name,
+		enum lttng_domain_type domain,
+		const char *channel_name,
+		struct channel_throughput_summary *summary,
+		enum lttng_error_code *_cmd_result)
+{
+	struct cds_lfht_iter iter;
+	struct channel_info *channel_info;
+
+	memset(summary, 0, sizeof(*summary));
+
+	/*
+	 * A channel has one buffer (channel key) per user or per application
+	 * in the user space domain; sum their throughputs.
+	 */
+	rcu_read_lock();
+	cds_lfht_for_each_entry(state->channels_ht, &iter, channel_info,
+			channels_ht_node) {
+		const struct channel_throughput *throughput =
+				&channel_info->throughput;
+		uint64_t duration;
+
+		if (channel_info->key.domain != domain ||
+				strcmp(channel_info->name, channel_name) ||
+				strcmp(channel_info->session_info->name,
+						session_name)) {
+			continue;
+		}
+
+		summary->buffer_count++;
+		summary->capacity = max_t(uint64_t, summary->capacity,
+				channel_info->capacity);
+		if (throughput->sample_count == 0) {
+			continue;
+		}
+
+		summary->sample_count += throughput->sample_count;
+		summary->peak_rate += throughput->peak_rate;
+		summary->peak_usage = max_t(uint64_t, summary->peak_usage,
+				throughput->peak_usage);
+
+		duration = throughput->last_sample_ts -
+				throughput->first_sample_ts;
+		summary->duration = max_t(uint64_t, summary->duration,
+				duration);
+		if (duration > 0) {
+			const uint64_t consumed = throughput->last_consumed -
+					throughput->first_consumed;
+
+			/* Divided first, to not overflow on large volumes. */
+			summary->rate += consumed / duration * USEC_PER_SEC +
+					consumed % duration * USEC_PER_SEC /
+							duration;
+		}
+	}
+	rcu_read_unlock();
+
+	*_cmd_result = summary->buffer_count ? LTTNG_OK :
+			LTTNG_ERR_CHAN_NOT_FOUND;
+	return 0;
+}
+
 static
 bool condition_is_supported(struct lttng_condition *condition)
 {
@@ -2681,6 +2751,14 @@ int handle_notification_thread_command_register_trigger(
 		trigger_tokens_ht_element->token =
 				LTTNG_OPTIONAL_GET(trigger->tracer_token);
 		trigger_tokens_ht_element->trigger = trigger;
+		trigger_tokens_ht_element->counter_only =
+				lttng_action_is_counter_only(
+						lttng_trigger_get_const_action(
+								trigger));
+		trigger_tokens_ht_element->counter_uses_captures =
+				lttng_action_counter_uses_captures(
+						lttng_trigger_get_const_action(
+								trigger));
 
 		node = cds_lfht_add_unique(state->trigger_tokens_ht,
 				hash_key_u64(&trigger_tokens_ht_element->token,
@@ -3135,6 +3213,15 @@ int handle_notification_thread_command(
 		ret = 0;
 		break;
 	}
+	case NOTIFICATION_COMMAND_TYPE_GET_CHANNEL_THROUGHPUT:
+		ret = handle_notification_thread_command_get_channel_throughput(
+				state,
+				cmd->parameters.get_channel_throughput.session_name,
+				cmd->parameters.get_channel_throughput.domain,
+				cmd->parameters.get_channel_throughput.channel_name,
+				&cmd->reply.channel_throughput,
+				&cmd->reply_code);
+		break;
 	case NOTIFICATION_COMMAND_TYPE_QUIT:
 		cmd->reply_code = LTTNG_OK;
 		ret = 1;
@@ -3600,11 +3687,17 @@ bool client_has_outbound_data_left(
 	return has_data || has_fds;
 }
 
-/* Client lock must _not_ be held by the caller. */
+/*
+ * Send a command reply followed by `status_count` per-item statuses.
+ *
+ * Client lock must _not_ be held by the caller.
+ */
 static
-int client_send_command_reply(struct notification_client *client,
+int client_send_command_reply_with_statuses(
+		struct notification_client *client,
 		struct notification_thread_state *state,
-		enum lttng_notification_channel_status status)
+		enum lttng_notification_channel_status status,
+		const int8_t *statuses, size_t status_count)
 {
 	int ret;
 	struct lttng_notification_channel_command_reply reply = {
@@ -3612,7 +3705,7 @@ int client_send_command_reply(struct notification_client *client,
 	};
 	struct lttng_notification_channel_message msg = {
 		.type = (int8_t) LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_COMMAND_REPLY,
-		.size = sizeof(reply),
+		.size = sizeof(reply) + status_count,
 	};
 	char buffer[sizeof(msg) + sizeof(reply)];
 	enum client_transmission_status transmission_status;
@@ -3635,6 +3728,15 @@ int client_send_command_reply(struct notification_client *client,
 		goto error_unlock;
 	}
 
+	if (status_count) {
+		ret = lttng_dynamic_buffer_append(
+				&client->communication.outbound.payload.buffer,
+				statuses, status_count);
+		if (ret) {
+			goto error_unlock;
+		}
+	}
+
 	transmission_status = client_flush_outgoing_queue(client);
 
 	if (client_has_outbound_data_left(client)) {
@@ -3656,6 +3758,16 @@ error:
 	return -1;
 }
 
+/* Client lock must _not_ be held by the caller. */
+static
+int client_send_command_reply(struct notification_client *client,
+		struct notification_thread_state *state,
+		enum lttng_notification_channel_status status)
+{
+	return client_send_command_reply_with_statuses(
+			client, state, status, NULL, 0);
+}
+
 static
 int client_handle_message_unknown(struct notification_client *client,
 		struct notification_thread_state *state)
@@ -3683,6 +3795,8 @@ int client_handle_message_unknown(struct notification_client *client,
 	switch (msg->type) {
 	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE:
 	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE:
+	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_MULTIPLE:
+	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE_MULTIPLE:
 	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_HANDSHAKE:
 		break;
 	default:
@@ -3843,6 +3957,120 @@ end:
 	return ret;
 }
 
+/*
+ * Handle a SUBSCRIBE_MULTIPLE or UNSUBSCRIBE_MULTIPLE command: every
+ * condition of the message is (un)subscribed and the reply carries the
+ * status of each of them.
+ */
+static
+int client_handle_message_subscriptions(
+		struct notification_client *client,
+		enum lttng_notification_channel_message_type msg_type,
+		struct notification_thread_state *state)
+{
+	int ret;
+	uint32_t i;
+	size_t offset;
+	struct lttng_dynamic_buffer statuses;
+	const struct lttng_notification_channel_command_conditions *cmd;
+	const struct lttng_payload *payload =
+			&client->communication.inbound.payload;
+	/*
+	 * The conditions are created from views of this view so that they
+	 * consume the file descriptors of the message in order.
+	 */
+	struct lttng_payload_view payload_view =
+			lttng_payload_view_from_payload(payload, 0, -1);
+
+	lttng_dynamic_buffer_init(&statuses);
+
+	/*
+	 * No need to lock client to sample the inbound state as the only
+	 * other thread accessing clients (action executor) only uses the
+	 * outbound state.
+	 */
+	if (payload->buffer.size < sizeof(*cmd)) {
+		ERR("[notification-thread] Malformed conditions command received from client");
+		ret = -1;
+		goto end;
+	}
+
+	cmd = (const struct lttng_notification_channel_command_conditions *)
+			payload->buffer.data;
+	if (cmd->condition_count == 0 || cmd->condition_count >
+			payload->buffer.size - sizeof(*cmd)) {
+		ERR("[notification-thread] Invalid condition count received from client: count = %" PRIu32,
+				cmd->condition_count);
+		ret = -1;
+		goto end;
+	}
+
+	ret = lttng_dynamic_buffer_set_size(&statuses, cmd->condition_count);
+	if (ret) {
+		goto end;
+	}
+
+	offset = sizeof(*cmd);
+	for (i = 0; i < cmd->condition_count; i++) {
+		ssize_t condition_size;
+		struct lttng_condition *condition;
+		enum lttng_notification_channel_status status =
+				LTTNG_NOTIFICATION_CHANNEL_STATUS_OK;
+		struct lttng_payload_view condition_view =
+				lttng_payload_view_from_view(
+						&payload_view, offset, -1);
+
+		condition_size = lttng_condition_create_from_payload(
+				&condition_view, &condition);
+		if (condition_size <= 0) {
+			ERR("[notification-thread] Malformed condition received from client");
+			ret = -1;
+			goto end;
+		}
+
+		offset += condition_size;
+
+		if (msg_type == LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_MULTIPLE) {
+			ret = notification_thread_client_subscribe(
+					client, condition, state, &status);
+		} else {
+			ret = notification_thread_client_unsubscribe(
+					client, condition, state, &status);
+		}
+
+		if (ret) {
+			goto end;
+		}
+
+		statuses.data[i] = (int8_t) status;
+	}
+
+	if (offset != payload->buffer.size) {
+		ERR("[notification-thread] Unexpected trailing data in conditions command received from client");
+		ret = -1;
+		goto end;
+	}
+
+	/* Set reception state to receive the next message header. */
+	ret = client_reset_inbound_state(client);
+	if (ret) {
+		ERR("[notification-thread] Failed to reset client communication's inbound state");
+		goto end;
+	}
+
+	ret = client_send_command_reply_with_statuses(client, state,
+			LTTNG_NOTIFICATION_CHANNEL_STATUS_OK,
+			(const int8_t *) statuses.data, statuses.size);
+	if (ret) {
+		ERR("[notification-thread] Failed to send reply to notification channel client");
+		goto end;
+	}
+
+end:
+	lttng_dynamic_buffer_reset(&statuses);
+	return ret;
+}
+
 static
 int client_dispatch_message(struct notification_client *client,
 		struct notification_thread_state *state)
@@ -3877,6 +4105,13 @@ int client_dispatch_message(struct notification_client *client,
 				client->communication.inbound.msg_type, state);
 		break;
 	}
+	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_MULTIPLE:
+	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE_MULTIPLE:
+	{
+		ret = client_handle_message_subscriptions(client,
+				client->communication.inbound.msg_type, state);
+		break;
+	}
 	default:
 		abort();
 	}
@@ -4499,6 +4734,49 @@ end:
 	return notification;
 }
 
+/*
+ * Apply the increment-counter actions of a trigger, only decoding the
+ * captured event field values if they complete a key.
+ */
+static
+void increment_counter_maps(
+		const struct notification_trigger_tokens_ht_element *element,
+		const struct lttng_event_notifier_notification *notification)
+{
+	const char *trigger_name;
+	enum lttng_trigger_status trigger_status;
+	struct lttng_evaluation *evaluation = NULL;
+	const struct lttng_event_field_value *captured_values = NULL;
+
+	if (!element->counter_uses_captures || !notification->capture_buffer) {
+		goto increment;
+	}
+
+	trigger_status = lttng_trigger_get_name(element->trigger, &trigger_name);
+	assert(trigger_status == LTTNG_TRIGGER_STATUS_OK);
+
+	evaluation = lttng_evaluation_on_event_create(
+			container_of(lttng_trigger_get_const_condition(
+						     element->trigger),
+					struct lttng_condition_on_event,
+					parent),
+			trigger_name,
+			notification->capture_buffer,
+			notification->capture_buf_size, true);
+	if (!evaluation) {
+		ERR("[notification-thread] Failed to decode the captured event field values of a counter map increment");
+		counter_map_drop_trigger(element->trigger);
+		goto end;
+	}
+
+	(void) lttng_evaluation_on_event_get_captured_values(evaluation,
+			&captured_values);
+increment:
+	counter_map_increment_trigger(element->trigger, captured_values);
+end:
+	lttng_evaluation_destroy(evaluation);
+}
+
 static
 int dispatch_one_event_notifier_notification(struct notification_thread_state *state,
 		struct lttng_event_notifier_notification *notification)
@@ -4542,6 +4820,13 @@ int dispatch_one_event_notifier_notification(struct notification_thread_state *s
 
 	lttng_trigger_fire(element->trigger);
 
+	if (element->counter_only) {
+		/* Nothing to evaluate nor to notify. */
+		increment_counter_maps(element, notification);
+		ret = 0;
+		goto end_unlock;
+	}
+
 	trigger_status = lttng_trigger_get_name(element->trigger, &trigger_name);
 	assert(trigger_status == LTTNG_TRIGGER_STATUS_OK);
 
@@ -4566,7 +4851,8 @@ int dispatch_one_event_notifier_notification(struct notification_thread_state *s
 					parent),
 			trigger_name,
 			notification->capture_buffer,
-			notification->capture_buf_size, false);
+			notification->capture_buf_size,
+			element->counter_uses_captures);
 
 	if (evaluation == NULL) {
 		ERR("[notification-thread] Failed to create event rule hit evaluation while creating and enqueuing action executor job");
@@ -4592,6 +4878,8 @@ int dispatch_one_event_notifier_notification(struct notification_thread_state *s
 		 */
 		ret = 0;
 
+		counter_map_drop_trigger(element->trigger);
+
 		/* No clients subscribed to notifications for this trigger. */
 		if (!client_list) {
 			break;
@@ -4682,6 +4970,45 @@ int handle_notification_thread_event_notification(struct notification_thread_sta
 	return handle_one_event_notifier_notification(state, pipe, domain);
 }
 
+static
+void channel_throughput_update(struct channel_throughput *throughput,
+		const struct channel_state_sample *sample)
+{
+	int ret;
+	uint64_t now;
+	struct timespec ts;
+
+	ret = lttng_clock_gettime(CLOCK_MONOTONIC, &ts);
+	if (ret) {
+		PERROR("clock_gettime");
+		return;
+	}
+
+	now = (uint64_t) ts.tv_sec * USEC_PER_SEC +
+			(uint64_t) ts.tv_nsec / NSEC_PER_USEC;
+	throughput->peak_usage = max_t(uint64_t, throughput->peak_usage,
+			sample->highest_usage);
+
+	/* The consumed size is reset when the buffers are cleared. */
+	if (throughput->sample_count == 0 ||
+			sample->channel_total_consumed <
+					throughput->last_consumed) {
+		throughput->first_sample_ts = now;
+		throughput->first_consumed = sample->channel_total_consumed;
+	} else if (now > throughput->last_sample_ts) {
+		const uint64_t rate = (sample->channel_total_consumed -
+				throughput->last_consumed) * USEC_PER_SEC /
+				(now - throughput->last_sample_ts);
+
+		throughput->peak_rate = max_t(uint64_t, throughput->peak_rate,
+				rate);
+	}
+
+	throughput->last_sample_ts = now;
+	throughput->last_consumed = sample->channel_total_consumed;
+	throughput->sample_count++;
+}
+
 int handle_notification_thread_channel_sample(
 		struct notification_thread_state *state, int pipe,
 		enum lttng_domain_type domain)
@@ -4740,6 +5067,7 @@ int handle_notification_thread_channel_sample(
 	}
 	channel_info = caa_container_of(node, struct channel_info,
 			channels_ht_node);
+	channel_throughput_update(&channel_info->throughput, &latest_sample);
 	DBG("[notification-thread] Handling channel sample for channel %s (key = %" PRIu64 ") in session %s (highest usage = %" PRIu64 ", lowest usage = %" PRIu64", total consumed = %" PRIu64")",
 			channel_info->name,
 			latest_sample.key.key,
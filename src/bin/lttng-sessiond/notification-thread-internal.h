@@ -58,10 +58,42 @@ struct session_info {
 	struct rcu_head rcu_node;
 };
 
+/*
+ * Throughput of a channel's buffers, derived from the samples sent by the
+ * monitor timer of the consumer daemon.
+ */
+struct channel_throughput {
+	uint64_t sample_count;
+	/* Monotonic time (usec) at which the first and last samples arrived. */
+	uint64_t first_sample_ts, last_sample_ts;
+	/* Total consumed size of the channel at the first and last samples. */
+	uint64_t first_consumed, last_consumed;
+	/* Highest rate (bytes/s) observed between two consecutive samples. */
+	uint64_t peak_rate;
+	/* Highest usage (bytes) observed in any stream of the channel. */
+	uint64_t peak_usage;
+};
+
+/* Throughput of all the buffers of a channel, as reported to the advisor. */
+struct channel_throughput_summary {
+	/* Number of sampled buffers (e.g. per-UID/per-PID buffers). */
+	uint64_t buffer_count;
+	uint64_t sample_count;
+	/* Longest observation period of a buffer (usec). */
+	uint64_t duration;
+	/* Average and peak rates (bytes/s), summed over the buffers. */
+	uint64_t rate, peak_rate;
+	/* Highest usage (bytes) and capacity of a stream. */
+	uint64_t peak_usage;
+	uint64_t capacity;
+};
+
 struct channel_info {
 	struct channel_key key;
 	char *name;
 	uint64_t capacity;
+	/* Only accessed by the notification thread. */
+	struct channel_throughput throughput;
 	/*
 	 * A channel info holds a reference (lttng_ref) on session_info.
 	 * session_info, in return, holds a weak reference to the channel.
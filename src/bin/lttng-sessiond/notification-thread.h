@@ -51,6 +51,13 @@ struct notification_trigger_tokens_ht_element {
 	uint64_t token;
 	/* Weak reference to the trigger. */
 	struct lttng_trigger *trigger;
+	/*
+	 * The trigger only increments counter maps: its notifications are
+	 * aggregated without going through the action executor.
+	 */
+	bool counter_only;
+	/* A key of a counter action of the trigger is completed by a capture. */
+	bool counter_uses_captures;
 	struct cds_lfht_node node;
 	/* call_rcu delayed reclaim. */
 	struct rcu_head rcu_node;
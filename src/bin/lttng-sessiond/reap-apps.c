@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <urcu.h>
+#include <urcu/list.h>
+#include <urcu/wfcqueue.h>
+#include <common/futex.h>
+#include <common/macros.h>
+
+#include "reap-apps.h"
+#include "health-sessiond.h"
+#include "lttng-sessiond.h"
+#include "testpoint.h"
+#include "thread.h"
+
+struct reap_app_node {
+	struct ust_app *app;
+	/* Ids of the sessions of which the application holds buffers. */
+	uint64_t *session_ids;
+	size_t session_count;
+	struct cds_wfcq_node node;
+	/* Node of reap_queue.pending, protected by reap_queue.pending_lock. */
+	struct cds_list_head pending_node;
+};
+
+/*
+ * Queue of unregistered applications waiting to be torn down, synchronized
+ * by a futex with a scheme N wakers / 1 waiters. See futex.c/.h
+ */
+static struct reap_queue {
+	int32_t futex;
+	int thread_exit;
+	struct cds_wfcq_head head;
+	struct cds_wfcq_tail tail;
+	/* Applications enqueued and not yet torn down. */
+	pthread_mutex_t pending_lock;
+	struct cds_list_head pending;
+} reap_queue = {
+	.pending_lock = PTHREAD_MUTEX_INITIALIZER,
+	.pending = CDS_LIST_HEAD_INIT(reap_queue.pending),
+};
+
+static void reap_app_node_destroy(struct reap_app_node *reap_node)
+{
+	free(reap_node->session_ids);
+	free(reap_node);
+}
+
+/*
+ * Record the sessions of which an unregistered application holds buffers.
+ *
+ * The teardown list of the application is only modified by
+ * ust_app_unregister(), which returned before the application is enqueued.
+ */
+static int reap_app_node_set_sessions(struct reap_app_node *reap_node)
+{
+	size_t count = 0;
+	struct ust_app_session *ua_sess;
+
+	cds_list_for_each_entry(ua_sess, &reap_node->app->teardown_head,
+			teardown_node) {
+		count++;
+	}
+
+	if (count == 0) {
+		return 0;
+	}
+
+	reap_node->session_ids = calloc(count,
+			sizeof(*reap_node->session_ids));
+	if (!reap_node->session_ids) {
+		return -1;
+	}
+
+	cds_list_for_each_entry(ua_sess, &reap_node->app->teardown_head,
+			teardown_node) {
+		reap_node->session_ids[reap_node->session_count++] =
+				ua_sess->tracing_id;
+	}
+
+	return 0;
+}
+
+/*
+ * Hand an application returned by ust_app_unregister() to the reaper thread.
+ *
+ * If the queue node can't be allocated, the application is torn down
+ * immediately by the caller's thread.
+ */
+void reap_apps_enqueue(struct ust_app *app)
+{
+	struct reap_app_node *reap_node;
+
+	assert(app);
+
+	reap_node = zmalloc(sizeof(*reap_node));
+	if (!reap_node) {
+		PERROR("zmalloc reap app node");
+		ust_app_reap(&app, 1);
+		return;
+	}
+
+	reap_node->app = app;
+	if (reap_app_node_set_sessions(reap_node)) {
+		PERROR("calloc reap app node sessions");
+		free(reap_node);
+		ust_app_reap(&app, 1);
+		return;
+	}
+	cds_wfcq_node_init(&reap_node->node);
+
+	pthread_mutex_lock(&reap_queue.pending_lock);
+	cds_list_add_tail(&reap_node->pending_node, &reap_queue.pending);
+	pthread_mutex_unlock(&reap_queue.pending_lock);
+
+	cds_wfcq_enqueue(&reap_queue.head, &reap_queue.tail, &reap_node->node);
+
+	/*
+	 * Wake the reaper queue futex. Implicit memory barrier with the
+	 * exchange in cds_wfcq_enqueue.
+	 */
+	futex_nto1_wake(&reap_queue.futex);
+}
+
+/*
+ * Return true if unregistered applications holding buffers of a session are
+ * still waiting for (or undergoing) their teardown.
+ *
+ * Until the teardown is done, the buffers of those applications may not be
+ * flushed nor their metadata pushed to the consumer.
+ */
+bool reap_apps_pending(uint64_t session_id)
+{
+	bool pending = false;
+	struct reap_app_node *reap_node;
+
+	pthread_mutex_lock(&reap_queue.pending_lock);
+	cds_list_for_each_entry(reap_node, &reap_queue.pending, pending_node) {
+		size_t i;
+
+		for (i = 0; i < reap_node->session_count; i++) {
+			if (reap_node->session_ids[i] == session_id) {
+				pending = true;
+				goto end;
+			}
+		}
+	}
+end:
+	pthread_mutex_unlock(&reap_queue.pending_lock);
+	return pending;
+}
+
+/*
+ * Tear down every queued application, in batches of at most
+ * DEFAULT_APP_REAP_BATCH_SIZE applications.
+ */
+static void reap_queued_apps(void)
+{
+	struct ust_app *batch[DEFAULT_APP_REAP_BATCH_SIZE];
+	struct reap_app_node *batch_nodes[DEFAULT_APP_REAP_BATCH_SIZE];
+	size_t count, i;
+
+	do {
+		count = 0;
+
+		while (count < DEFAULT_APP_REAP_BATCH_SIZE) {
+			struct cds_wfcq_node *node;
+			struct reap_app_node *reap_node;
+
+			node = cds_wfcq_dequeue_blocking(&reap_queue.head,
+					&reap_queue.tail);
+			if (!node) {
+				break;
+			}
+
+			reap_node = caa_container_of(node,
+					struct reap_app_node, node);
+			batch_nodes[count] = reap_node;
+			batch[count++] = reap_node->app;
+		}
+
+		if (count == 0) {
+			break;
+		}
+
+		health_code_update();
+		ust_app_reap(batch, count);
+
+		pthread_mutex_lock(&reap_queue.pending_lock);
+		for (i = 0; i < count; i++) {
+			cds_list_del(&batch_nodes[i]->pending_node);
+		}
+		pthread_mutex_unlock(&reap_queue.pending_lock);
+
+		for (i = 0; i < count; i++) {
+			reap_app_node_destroy(batch_nodes[i]);
+		}
+	} while (count == DEFAULT_APP_REAP_BATCH_SIZE);
+}
+
+/*
+ * This thread tears down the applications unregistered by the application
+ * management thread: it flushes their per-PID buffers, pushes and closes their
+ * metadata and releases them. Doing so in batches keeps the application
+ * management path free of consumer round-trips when many applications exit
+ * at once.
+ */
+static void *thread_application_reaper(void *data)
+{
+	int err = -1;
+
+	DBG("[thread] Application reaper started");
+
+	rcu_register_thread();
+
+	health_register(health_sessiond, HEALTH_SESSIOND_TYPE_APP_REAPER);
+
+	if (testpoint(sessiond_thread_app_reaper)) {
+		goto error_testpoint;
+	}
+
+	for (;;) {
+		health_code_update();
+
+		/* Atomically prepare the queue futex */
+		futex_nto1_prepare(&reap_queue.futex);
+
+		if (CMM_LOAD_SHARED(reap_queue.thread_exit)) {
+			break;
+		}
+
+		reap_queued_apps();
+
+		health_poll_entry();
+		/* Futex wait on queue. Blocking call on futex() */
+		futex_nto1_wait(&reap_queue.futex);
+		health_poll_exit();
+	}
+
+	/* Don't leak the applications that were unregistered before exiting. */
+	reap_queued_apps();
+
+	/* Normal exit, no error */
+	err = 0;
+
+error_testpoint:
+	DBG("Application reaper thread dying");
+	if (err) {
+		health_error();
+		ERR("Health error occurred in %s", __func__);
+	}
+	health_unregister(health_sessiond);
+	rcu_unregister_thread();
+	return NULL;
+}
+
+static bool shutdown_application_reaper_thread(void *data)
+{
+	CMM_STORE_SHARED(reap_queue.thread_exit, 1);
+	futex_nto1_wake(&reap_queue.futex);
+	return true;
+}
+
+bool launch_application_reaper_thread(void)
+{
+	struct lttng_thread *thread;
+
+	cds_wfcq_init(&reap_queue.head, &reap_queue.tail);
+
+	thread = lttng_thread_create("UST application reaper",
+			thread_application_reaper,
+			shutdown_application_reaper_thread,
+			NULL,
+			NULL);
+	if (!thread) {
+		goto error;
+	}
+	lttng_thread_put(thread);
+	return true;
+error:
+	return false;
+}
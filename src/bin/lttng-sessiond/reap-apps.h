@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef SESSIOND_APPLICATION_REAPER_THREAD_H
+#define SESSIOND_APPLICATION_REAPER_THREAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ust-app.h"
+
+bool launch_application_reaper_thread(void);
+
+void reap_apps_enqueue(struct ust_app *app);
+bool reap_apps_pending(uint64_t session_id);
+
+#endif /* SESSIOND_APPLICATION_REAPER_THREAD_H */
@@ -35,6 +35,7 @@
 #include "notification-thread-commands.h"
 #include "utils.h"
 #include "thread.h"
+#include "ust-buffer-pool.h"
 
 #include <urcu.h>
 #include <urcu/list.h>
@@ -78,6 +79,10 @@ const char *get_job_type_str(enum rotation_thread_job_type job_type)
 		return "CHECK_PENDING_ROTATION";
 	case ROTATION_THREAD_JOB_TYPE_SCHEDULED_ROTATION:
 		return "SCHEDULED_ROTATION";
+	case ROTATION_THREAD_JOB_TYPE_SNAPSHOT_RELAYD_IDLE_CHECK:
+		return "SNAPSHOT_RELAYD_IDLE_CHECK";
+	case ROTATION_THREAD_JOB_TYPE_UST_BUFFER_POOL_REFILL:
+		return "UST_BUFFER_POOL_REFILL";
 	default:
 		abort();
 	}
@@ -539,6 +544,45 @@ int launch_session_rotation(struct ltt_session *session)
 	return 0;
 }
 
+/* Call with the session and session_list locks held. */
+static
+int close_idle_snapshot_relayd(struct ltt_session *session)
+{
+	DBG("[rotation-thread] Checking for idle snapshot relayd connections of session \"%s\"",
+			session->name);
+
+	if (snapshot_close_idle_relayd(&session->snapshot,
+			DEFAULT_SNAPSHOT_RELAYD_IDLE_TIMEOUT)) {
+		goto end;
+	}
+
+	/* No connection left to check; rearmed by the next snapshot. */
+	if (timer_session_snapshot_relayd_idle_timer_stop(session)) {
+		/* Don't consider errors as fatal. */
+		DBG("[rotation-thread] Failed to stop snapshot relayd idle check timer of session \"%s\"",
+				session->name);
+	}
+end:
+	return 0;
+}
+
+/* Call with the session and session_list locks held. */
+static
+int refill_ust_buffer_pool(struct ltt_session *session)
+{
+	if (session->destroyed || !session->ust_session) {
+		goto end;
+	}
+
+	DBG("[rotation-thread] Refilling the UST buffer pool of session \"%s\"",
+			session->name);
+	rcu_read_lock();
+	ust_buffer_pool_fill(session->ust_session);
+	rcu_read_unlock();
+end:
+	return 0;
+}
+
 static
 int run_job(struct rotation_thread_job *job, struct ltt_session *session,
 		struct notification_thread_handle *notification_thread_handle)
@@ -553,6 +597,12 @@ int run_job(struct rotation_thread_job *job, struct ltt_session *session,
 		ret = check_session_rotation_pending(session,
 				notification_thread_handle);
 		break;
+	case ROTATION_THREAD_JOB_TYPE_SNAPSHOT_RELAYD_IDLE_CHECK:
+		ret = close_idle_snapshot_relayd(session);
+		break;
+	case ROTATION_THREAD_JOB_TYPE_UST_BUFFER_POOL_REFILL:
+		ret = refill_ust_buffer_pool(session);
+		break;
 	default:
 		abort();
 	}
@@ -25,7 +25,9 @@ extern struct lttng_notification_channel *rotate_notification_channel;
 
 enum rotation_thread_job_type {
 	ROTATION_THREAD_JOB_TYPE_SCHEDULED_ROTATION,
-	ROTATION_THREAD_JOB_TYPE_CHECK_PENDING_ROTATION
+	ROTATION_THREAD_JOB_TYPE_CHECK_PENDING_ROTATION,
+	ROTATION_THREAD_JOB_TYPE_SNAPSHOT_RELAYD_IDLE_CHECK,
+	ROTATION_THREAD_JOB_TYPE_UST_BUFFER_POOL_REFILL,
 };
 
 struct rotation_thread_timer_queue;
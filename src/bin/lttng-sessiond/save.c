@@ -124,6 +124,21 @@ int save_kernel_channel_attributes(struct config_writer *writer,
 			ret = LTTNG_ERR_SAVE_IO_FAIL;
 			goto end;
 		}
+
+		ret = config_writer_write_element_unsigned_int(writer,
+				config_element_writeback_window_size,
+				ext->writeback_window_size);
+		if (ret) {
+			ret = LTTNG_ERR_SAVE_IO_FAIL;
+			goto end;
+		}
+
+		ret = config_writer_write_element_bool(writer,
+				config_element_direct_io, ext->direct_io);
+		if (ret) {
+			ret = LTTNG_ERR_SAVE_IO_FAIL;
+			goto end;
+		}
 	}
 
 	ret = LTTNG_OK;
@@ -209,6 +224,21 @@ int save_ust_channel_attributes(struct config_writer *writer,
 		goto end;
 	}
 
+	ret = config_writer_write_element_unsigned_int(writer,
+		config_element_writeback_window_size,
+		channel->writeback_window_size);
+	if (ret) {
+		ret = LTTNG_ERR_SAVE_IO_FAIL;
+		goto end;
+	}
+
+	ret = config_writer_write_element_bool(writer,
+		config_element_direct_io, channel->direct_io);
+	if (ret) {
+		ret = LTTNG_ERR_SAVE_IO_FAIL;
+		goto end;
+	}
+
 	ret = LTTNG_OK;
 end:
 	return ret;
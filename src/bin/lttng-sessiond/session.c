@@ -466,12 +466,11 @@ int _session_set_trace_chunk_no_lock_check(struct ltt_session *session,
 	if (session->ust_session) {
 		const uint64_t relayd_id =
 				session->ust_session->consumer->net_seq_index;
-		const bool is_local_trace =
-				session->ust_session->consumer->type ==
-				CONSUMER_DST_LOCAL;
+		const bool has_local_output = consumer_output_has_local_output(
+				session->ust_session->consumer);
 
 		session->ust_session->current_trace_chunk = new_trace_chunk;
-		if (is_local_trace) {
+		if (has_local_output) {
 			enum lttng_error_code ret_error_code;
 
 			ret_error_code = ust_app_create_channel_subdirectories(
@@ -497,12 +496,11 @@ int _session_set_trace_chunk_no_lock_check(struct ltt_session *session,
 	if (session->kernel_session) {
 		const uint64_t relayd_id =
 				session->kernel_session->consumer->net_seq_index;
-		const bool is_local_trace =
-				session->kernel_session->consumer->type ==
-				CONSUMER_DST_LOCAL;
+		const bool has_local_output = consumer_output_has_local_output(
+				session->kernel_session->consumer);
 
 		session->kernel_session->current_trace_chunk = new_trace_chunk;
-		if (is_local_trace) {
+		if (has_local_output) {
 			enum lttng_error_code ret_error_code;
 
 			ret_error_code = kernel_create_channel_subdirectories(
@@ -570,7 +568,7 @@ struct lttng_trace_chunk *session_create_new_trace_chunk(
 	struct lttng_trace_chunk *trace_chunk = NULL;
 	enum lttng_trace_chunk_status chunk_status;
 	const time_t chunk_creation_ts = time(NULL);
-	bool is_local_trace;
+	bool has_local_output;
 	const char *base_path;
 	struct lttng_directory_handle *session_output_directory = NULL;
 	const struct lttng_credentials session_credentials = {
@@ -590,9 +588,15 @@ struct lttng_trace_chunk *session_create_new_trace_chunk(
 					 session->kernel_session->consumer;
 	}
 
-	is_local_trace = output->type == CONSUMER_DST_LOCAL;
-	base_path = session_base_path_override ? :
-			consumer_output_get_base_path(output);
+	has_local_output = consumer_output_has_local_output(output);
+	if (session_base_path_override) {
+		base_path = session_base_path_override;
+	} else if (output->type == CONSUMER_DST_NET && has_local_output) {
+		/* Local copy of a streamed trace. */
+		base_path = output->tee_path;
+	} else {
+		base_path = consumer_output_get_base_path(output);
+	}
 
 	if (chunk_creation_ts == (time_t) -1) {
 		PERROR("Failed to sample time while creation session \"%s\" trace chunk",
@@ -635,7 +639,7 @@ struct lttng_trace_chunk *session_create_new_trace_chunk(
 		}
 	}
 
-	if (!is_local_trace) {
+	if (!has_local_output) {
 		/*
 		 * No need to set crendentials and output directory
 		 * for remote trace chunks.
@@ -939,6 +943,9 @@ void session_release(struct urcu_ref *ref)
 	if (usess) {
 		/* Close any relayd session */
 		consumer_output_send_destroy_relayd(usess->consumer);
+		consumer_output_send_close_live_session(usess->consumer,
+				usess->id);
+		ust_buffer_pool_release(usess);
 
 		/* Destroy every UST application related to this session. */
 		ret = ust_app_destroy_trace_all(usess);
@@ -154,6 +154,12 @@ struct ltt_session {
 	/* Timer to periodically rotate a session. */
 	bool rotation_schedule_timer_enabled;
 	timer_t rotation_schedule_timer;
+	/*
+	 * Timer to periodically close the idle relay daemon connections of
+	 * the session's snapshot outputs.
+	 */
+	bool snapshot_relayd_idle_timer_enabled;
+	timer_t snapshot_relayd_idle_timer;
 	/* Value for periodic rotations, 0 if disabled. */
 	uint64_t rotate_timer_period;
 	/* Value for size-based rotations, 0 if disabled. */
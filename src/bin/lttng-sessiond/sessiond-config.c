@@ -12,6 +12,7 @@
 #include <common/defaults.h>
 #include <limits.h>
 #include <ctype.h>
+#include <inttypes.h>
 #include <common/error.h>
 #include <common/utils.h>
 #include <common/compat/errno.h>
@@ -25,9 +26,12 @@ struct sessiond_config sessiond_config_build_defaults = {
 
 	.agent_tcp_port = 			{ .begin = DEFAULT_AGENT_TCP_PORT_RANGE_BEGIN, .end = DEFAULT_AGENT_TCP_PORT_RANGE_END },
 	.event_notifier_error_counter_bucket =	DEFAULT_EVENT_NOTIFIER_ERROR_COUNT_MAP_SIZE,
+	.ust_buffer_pool_size =			DEFAULT_UST_BUFFER_POOL_SIZE,
 	.app_socket_timeout = 			DEFAULT_APP_SOCKET_RW_TIMEOUT,
 
 	.no_kernel = 				false,
+	.apply_channel_advice =			false,
+	.channel_advice_max_buffer_size =	0,
 	.background = 				false,
 	.daemonize = 				false,
 	.sig_parent = 				false,
@@ -53,16 +57,19 @@ struct sessiond_config sessiond_config_build_defaults = {
 	.consumerd32_lib_dir.value =		NULL,
 	.consumerd32_err_unix_sock_path.value = NULL,
 	.consumerd32_cmd_unix_sock_path.value = NULL,
+	.consumerd32_live_url.value =		NULL,
 
 	.consumerd64_path.value =		NULL,
 	.consumerd64_bin_path.value =		NULL,
 	.consumerd64_lib_dir.value =		NULL,
 	.consumerd64_err_unix_sock_path.value = NULL,
 	.consumerd64_cmd_unix_sock_path.value = NULL,
+	.consumerd64_live_url.value =		NULL,
 
 	.kconsumerd_path.value =		NULL,
 	.kconsumerd_err_unix_sock_path.value = 	NULL,
 	.kconsumerd_cmd_unix_sock_path.value = 	NULL,
+	.kconsumerd_live_url.value =		NULL,
 };
 
 static
@@ -422,14 +429,35 @@ void sessiond_config_fini(struct sessiond_config *config)
 	config_string_fini(&config->consumerd32_lib_dir);
 	config_string_fini(&config->consumerd32_err_unix_sock_path);
 	config_string_fini(&config->consumerd32_cmd_unix_sock_path);
+	config_string_fini(&config->consumerd32_live_url);
 	config_string_fini(&config->consumerd64_path);
 	config_string_fini(&config->consumerd64_bin_path);
 	config_string_fini(&config->consumerd64_lib_dir);
 	config_string_fini(&config->consumerd64_err_unix_sock_path);
 	config_string_fini(&config->consumerd64_cmd_unix_sock_path);
+	config_string_fini(&config->consumerd64_live_url);
 	config_string_fini(&config->kconsumerd_path);
 	config_string_fini(&config->kconsumerd_err_unix_sock_path);
 	config_string_fini(&config->kconsumerd_cmd_unix_sock_path);
+	config_string_fini(&config->kconsumerd_live_url);
+}
+
+LTTNG_HIDDEN
+bool sessiond_config_has_live_url(const struct sessiond_config *config,
+		enum lttng_domain_type domain)
+{
+	const bool ust = config->consumerd32_live_url.value ||
+			config->consumerd64_live_url.value;
+
+	switch (domain) {
+	case LTTNG_DOMAIN_NONE:
+		return ust || config->kconsumerd_live_url.value;
+	case LTTNG_DOMAIN_KERNEL:
+		return config->kconsumerd_live_url.value;
+	default:
+		/* The agent domains are traced through the UST domain. */
+		return ust;
+	}
 }
 
 static
@@ -513,7 +541,10 @@ void sessiond_config_log(struct sessiond_config *config)
 				config->agent_tcp_port.end);
 	}
 	DBG_NO_LOC("\tapplication socket timeout:    %i", config->app_socket_timeout);
+	DBG_NO_LOC("\tUST buffer pool size:          %i", config->ust_buffer_pool_size);
 	DBG_NO_LOC("\tno-kernel:                     %s", config->no_kernel ? "True" : "False");
+	DBG_NO_LOC("\tapply channel advice:          %s", config->apply_channel_advice ? "True" : "False");
+	DBG_NO_LOC("\tadvice max buffer size:        %" PRIu64, config->channel_advice_max_buffer_size);
 	DBG_NO_LOC("\tbackground:                    %s", config->background ? "True" : "False");
 	DBG_NO_LOC("\tdaemonize:                     %s", config->daemonize ? "True" : "False");
 	DBG_NO_LOC("\tsignal parent on start:        %s", config->sig_parent ? "True" : "False");
@@ -535,12 +566,15 @@ void sessiond_config_log(struct sessiond_config *config)
 	DBG_NO_LOC("\tconsumerd32 lib dir:           %s", config->consumerd32_lib_dir.value ? : "Unknown");
 	DBG_NO_LOC("\tconsumerd32 err unix sock path:%s", config->consumerd32_err_unix_sock_path.value ? : "Unknown");
 	DBG_NO_LOC("\tconsumerd32 cmd unix sock path:%s", config->consumerd32_cmd_unix_sock_path.value ? : "Unknown");
+	DBG_NO_LOC("\tconsumerd32 live URL:          %s", config->consumerd32_live_url.value ? : "None");
 	DBG_NO_LOC("\tconsumerd64 path:              %s", config->consumerd64_path.value ? : "Unknown");
 	DBG_NO_LOC("\tconsumerd64 bin path:          %s", config->consumerd64_bin_path.value ? : "Unknown");
 	DBG_NO_LOC("\tconsumerd64 lib dir:           %s", config->consumerd64_lib_dir.value ? : "Unknown");
 	DBG_NO_LOC("\tconsumerd64 err unix sock path:%s", config->consumerd64_err_unix_sock_path.value ? : "Unknown");
 	DBG_NO_LOC("\tconsumerd64 cmd unix sock path:%s", config->consumerd64_cmd_unix_sock_path.value ? : "Unknown");
+	DBG_NO_LOC("\tconsumerd64 live URL:          %s", config->consumerd64_live_url.value ? : "None");
 	DBG_NO_LOC("\tkconsumerd path:               %s", config->kconsumerd_path.value ? : "Unknown");
 	DBG_NO_LOC("\tkconsumerd err unix sock path: %s", config->kconsumerd_err_unix_sock_path.value ? : "Unknown");
 	DBG_NO_LOC("\tkconsumerd cmd unix sock path: %s", config->kconsumerd_cmd_unix_sock_path.value ? : "Unknown");
+	DBG_NO_LOC("\tkconsumerd live URL:           %s", config->kconsumerd_live_url.value ? : "None");
 }
@@ -9,7 +9,9 @@
 #define LTTNG_SESSIOND_CONFIG_H
 
 #include <common/macros.h>
+#include <lttng/domain.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 struct config_string {
 	char *value;
@@ -31,11 +33,17 @@ struct sessiond_config {
 	struct config_int_range agent_tcp_port;
 
 	int event_notifier_error_counter_bucket;
+	/* Buffer sets pre-created for each started per-PID UST session. */
+	int ust_buffer_pool_size;
 	/* Socket timeout for receiving and sending (in seconds). */
 	int app_socket_timeout;
 
 	bool quiet;
 	bool no_kernel;
+	/* Apply the advised geometry to the channels created with defaults. */
+	bool apply_channel_advice;
+	/* Largest advised buffer size of a stream; 0 to derive from memory. */
+	uint64_t channel_advice_max_buffer_size;
 	bool background;
 	bool daemonize;
 	bool sig_parent;
@@ -70,16 +78,19 @@ struct sessiond_config {
 	struct config_string consumerd32_lib_dir;
 	struct config_string consumerd32_err_unix_sock_path;
 	struct config_string consumerd32_cmd_unix_sock_path;
+	struct config_string consumerd32_live_url;
 
 	struct config_string consumerd64_path;
 	struct config_string consumerd64_bin_path;
 	struct config_string consumerd64_lib_dir;
 	struct config_string consumerd64_err_unix_sock_path;
 	struct config_string consumerd64_cmd_unix_sock_path;
+	struct config_string consumerd64_live_url;
 
 	struct config_string kconsumerd_path;
 	struct config_string kconsumerd_err_unix_sock_path;
 	struct config_string kconsumerd_cmd_unix_sock_path;
+	struct config_string kconsumerd_live_url;
 };
 
 /* Initialize the sessiond_config values to build-defaults. */
@@ -99,4 +110,12 @@ int sessiond_config_resolve_paths(struct sessiond_config *config);
 LTTNG_HIDDEN
 void sessiond_config_log(struct sessiond_config *config);
 
+/*
+ * Whether the consumer daemons of a domain serve live viewers on a live URL.
+ * LTTNG_DOMAIN_NONE checks the consumer daemons of all domains.
+ */
+LTTNG_HIDDEN
+bool sessiond_config_has_live_url(const struct sessiond_config *config,
+		enum lttng_domain_type domain);
+
 #endif /* LTTNG_SESSIOND_CONFIG_H */
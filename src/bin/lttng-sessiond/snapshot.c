@@ -11,7 +11,9 @@
 #include <string.h>
 #include <urcu/uatomic.h>
 
+#include <common/compat/time.h>
 #include <common/defaults.h>
+#include <common/time.h>
 
 #include "snapshot.h"
 #include "utils.h"
@@ -221,6 +223,7 @@ void snapshot_output_destroy(struct snapshot_output *obj)
 {
 	assert(obj);
 
+	snapshot_output_relayd_close(&obj->relayd);
 	if (obj->consumer) {
 		consumer_output_send_destroy_relayd(obj->consumer);
 		consumer_output_put(obj->consumer);
@@ -228,6 +231,89 @@ void snapshot_output_destroy(struct snapshot_output *obj)
 	free(obj);
 }
 
+/*
+ * Return true if relay daemon connections are kept open for a snapshot output.
+ */
+bool snapshot_output_relayd_is_open(const struct snapshot_output_relayd *relayd)
+{
+	return relayd->kernel_consumer || relayd->ust_consumer;
+}
+
+/*
+ * Close the relay daemon connections kept open for a snapshot output, if any.
+ */
+void snapshot_output_relayd_close(struct snapshot_output_relayd *relayd)
+{
+	struct consumer_output **consumers[] = {
+		&relayd->kernel_consumer,
+		&relayd->ust_consumer,
+	};
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(consumers); i++) {
+		if (!*consumers[i]) {
+			continue;
+		}
+
+		DBG("Closing relayd connections of snapshot output (net index %" PRIu64 ")",
+				(*consumers[i])->net_seq_index);
+		consumer_output_send_destroy_relayd(*consumers[i]);
+		consumer_output_put(*consumers[i]);
+		*consumers[i] = NULL;
+	}
+}
+
+/*
+ * Close the relay daemon connections of the snapshot outputs that were not
+ * used for idle_timeout_us.
+ *
+ * The session owning the snapshot object must be locked.
+ *
+ * Return true if connections are still open for an output.
+ */
+bool snapshot_close_idle_relayd(struct snapshot *snapshot,
+		uint64_t idle_timeout_us)
+{
+	int ret;
+	bool open_left = false;
+	struct timespec now;
+	struct lttng_ht_iter iter;
+	struct snapshot_output *output;
+
+	assert(snapshot);
+
+	ret = lttng_clock_gettime(CLOCK_MONOTONIC, &now);
+	if (ret) {
+		PERROR("Failed to sample monotonic clock");
+		/* Keep the connections until the next check. */
+		return true;
+	}
+
+	rcu_read_lock();
+	cds_lfht_for_each_entry(snapshot->output_ht->ht, &iter.iter, output,
+			node.node) {
+		unsigned long idle_ms;
+
+		if (!snapshot_output_relayd_is_open(&output->relayd)) {
+			continue;
+		}
+
+		ret = timespec_to_ms(timespec_abs_diff(now,
+				output->relayd.last_use), &idle_ms);
+		if (ret || (uint64_t) idle_ms * USEC_PER_MSEC >= idle_timeout_us) {
+			DBG("Closing idle relayd connections of snapshot output \"%s\"",
+					output->name);
+			snapshot_output_relayd_close(&output->relayd);
+			continue;
+		}
+
+		open_left = true;
+	}
+	rcu_read_unlock();
+
+	return open_left;
+}
+
 /*
  * RCU read side lock MUST be acquired before calling this since the returned
  * pointer is in a RCU hash table.
@@ -328,3 +414,63 @@ void snapshot_destroy(struct snapshot *obj)
 	rcu_read_unlock();
 	ht_cleanup_push(obj->output_ht);
 }
+
+/*
+ * Initialize a snapshot scope; the time window ends at the current time.
+ *
+ * Return 0 on success or else a negative value.
+ */
+int snapshot_scope_init(struct snapshot_scope *scope,
+		const char (*channel_names)[LTTNG_SYMBOL_NAME_LEN],
+		unsigned int channel_count, uint64_t time_window_us)
+{
+	int ret = 0;
+	struct timespec now;
+	uint64_t now_ns;
+
+	assert(scope);
+
+	memset(scope, 0, sizeof(*scope));
+	scope->channel_names = channel_names;
+	scope->channel_count = channel_count;
+
+	if (!time_window_us) {
+		goto end;
+	}
+
+	/* The monotonic clock is the default clock of the tracers. */
+	ret = lttng_clock_gettime(CLOCK_MONOTONIC, &now);
+	if (ret) {
+		PERROR("Failed to sample monotonic clock");
+		goto end;
+	}
+	now_ns = (uint64_t) now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+	if (time_window_us < now_ns / NSEC_PER_USEC) {
+		scope->begin_timestamp = now_ns - time_window_us * NSEC_PER_USEC;
+	}
+end:
+	return ret;
+}
+
+bool snapshot_scope_has_channel(const struct snapshot_scope *scope,
+		const char *channel_name)
+{
+	unsigned int i;
+
+	if (!scope || !scope->channel_count) {
+		return true;
+	}
+
+	for (i = 0; i < scope->channel_count; i++) {
+		if (!strncmp(scope->channel_names[i], channel_name,
+				LTTNG_SYMBOL_NAME_LEN)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+uint64_t snapshot_scope_get_begin_timestamp(const struct snapshot_scope *scope)
+{
+	return scope ? scope->begin_timestamp : 0;
+}
@@ -9,7 +9,9 @@
 #define SNAPSHOT_H
 
 #include <limits.h>
+#include <stdbool.h>
 #include <stdint.h>
+#include <time.h>
 
 #include <common/common.h>
 #include <common/hashtable/hashtable.h>
@@ -20,6 +22,23 @@
 struct consumer_output;
 struct ltt_session;
 
+/*
+ * Relay daemon connections of a network snapshot output. They are kept open
+ * between the snapshots recorded to the output so that a snapshot only ships
+ * data, and closed once they have been idle for
+ * DEFAULT_SNAPSHOT_RELAYD_IDLE_TIMEOUT.
+ */
+struct snapshot_output_relayd {
+	/*
+	 * Consumer outputs, per tracer domain, holding the connections. NULL
+	 * when no connection is open.
+	 */
+	struct consumer_output *kernel_consumer;
+	struct consumer_output *ust_consumer;
+	/* Monotonic time of the last use of the connections. */
+	struct timespec last_use;
+};
+
 struct snapshot_output {
 	uint32_t id;
 	uint64_t max_size;
@@ -35,6 +54,8 @@ struct snapshot_output {
 	 * for the directory output.
 	 */
 	char datetime[16];
+	/* Relay daemon connections kept open for this output. */
+	struct snapshot_output_relayd relayd;
 
 	/* Indexed by ID. */
 	struct lttng_ht_node_ulong node;
@@ -78,4 +99,32 @@ struct snapshot_output *snapshot_find_output_by_id(uint32_t id,
 struct snapshot_output *snapshot_find_output_by_name(const char *name,
 		struct snapshot *snapshot);
 
+/* Snapshot output relay daemon connections. */
+bool snapshot_output_relayd_is_open(const struct snapshot_output_relayd *relayd);
+void snapshot_output_relayd_close(struct snapshot_output_relayd *relayd);
+bool snapshot_close_idle_relayd(struct snapshot *snapshot,
+		uint64_t idle_timeout_us);
+
+/*
+ * Subset of a session recorded by a snapshot. A NULL scope records the whole
+ * session.
+ */
+struct snapshot_scope {
+	/* Names of the channels to record, every channel if channel_count is 0. */
+	const char (*channel_names)[LTTNG_SYMBOL_NAME_LEN];
+	unsigned int channel_count;
+	/*
+	 * Monotonic clock timestamp, in nanoseconds, before which the packets
+	 * which end are not recorded. 0 to record every packet.
+	 */
+	uint64_t begin_timestamp;
+};
+
+int snapshot_scope_init(struct snapshot_scope *scope,
+		const char (*channel_names)[LTTNG_SYMBOL_NAME_LEN],
+		unsigned int channel_count, uint64_t time_window_us);
+bool snapshot_scope_has_channel(const struct snapshot_scope *scope,
+		const char *channel_name);
+uint64_t snapshot_scope_get_begin_timestamp(const struct snapshot_scope *scope);
+
 #endif /* SNAPSHOT_H */
@@ -20,6 +20,7 @@
 #define LTTNG_SESSIOND_SIG_EXIT				SIGRTMIN + 11
 #define LTTNG_SESSIOND_SIG_PENDING_ROTATION_CHECK	SIGRTMIN + 12
 #define LTTNG_SESSIOND_SIG_SCHEDULED_ROTATION		SIGRTMIN + 13
+#define LTTNG_SESSIOND_SIG_SNAPSHOT_RELAYD_IDLE_CHECK	SIGRTMIN + 14
 
 #define UINT_TO_PTR(value)				\
 	({						\
@@ -74,6 +75,10 @@ void setmask(sigset_t *mask)
 	if (ret) {
 		PERROR("sigaddset scheduled rotation");
 	}
+	ret = sigaddset(mask, LTTNG_SESSIOND_SIG_SNAPSHOT_RELAYD_IDLE_CHECK);
+	if (ret) {
+		PERROR("sigaddset snapshot relayd idle check");
+	}
 }
 
 /*
@@ -312,6 +317,68 @@ end:
 	return ret;
 }
 
+/*
+ * Call with session and session_list locks held.
+ */
+int timer_session_snapshot_relayd_idle_timer_start(struct ltt_session *session,
+		unsigned int interval_us)
+{
+	int ret;
+
+	if (session->snapshot_relayd_idle_timer_enabled) {
+		ret = 0;
+		goto end;
+	}
+
+	if (!session_get(session)) {
+		ret = -1;
+		goto end;
+	}
+	DBG("Enabling snapshot relayd idle check timer on session \"%s\" (%ui %s)",
+			session->name, interval_us, USEC_UNIT);
+	ret = timer_start(&session->snapshot_relayd_idle_timer, session,
+			interval_us, LTTNG_SESSIOND_SIG_SNAPSHOT_RELAYD_IDLE_CHECK,
+			/* one-shot */ false);
+	if (ret < 0) {
+		session_put(session);
+		goto end;
+	}
+	session->snapshot_relayd_idle_timer_enabled = true;
+end:
+	return ret;
+}
+
+/*
+ * Call with session and session_list locks held.
+ */
+int timer_session_snapshot_relayd_idle_timer_stop(struct ltt_session *session)
+{
+	int ret = 0;
+
+	assert(session);
+
+	if (!session->snapshot_relayd_idle_timer_enabled) {
+		goto end;
+	}
+
+	DBG("Disabling snapshot relayd idle check timer on session \"%s\"",
+			session->name);
+	ret = timer_stop(&session->snapshot_relayd_idle_timer,
+			LTTNG_SESSIOND_SIG_SNAPSHOT_RELAYD_IDLE_CHECK);
+	if (ret < 0) {
+		ERR("Failed to stop snapshot relayd idle check timer of session \"%s\"",
+				session->name);
+		goto end;
+	}
+
+	session->snapshot_relayd_idle_timer_enabled = false;
+	/* The timer's reference to the session can be released safely. */
+	session_put(session);
+	ret = 0;
+end:
+	return ret;
+}
+
 /*
  * Block the RT signals for the entire process. It must be called from the
  * sessiond main before creating the threads
@@ -393,6 +460,14 @@ void *thread_timer(void *data)
 			 * released since the timer is still enabled and can
 			 * still fire.
 			 */
+		} else if (signr == LTTNG_SESSIOND_SIG_SNAPSHOT_RELAYD_IDLE_CHECK) {
+			/*
+			 * Periodic timer; the reference to the session is
+			 * released when the timer is stopped.
+			 */
+			rotation_thread_enqueue_job(ctx->rotation_thread_job_queue,
+					ROTATION_THREAD_JOB_TYPE_SNAPSHOT_RELAYD_IDLE_CHECK,
+					(struct ltt_session *) info.si_value.sival_ptr);
 		} else {
 			ERR("Unexpected signal %d\n", info.si_signo);
 		}
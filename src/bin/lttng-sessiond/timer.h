@@ -32,6 +32,12 @@ int timer_session_rotation_schedule_timer_start(struct ltt_session *session,
 /* Stop a session's rotation schedule timer. */
 int timer_session_rotation_schedule_timer_stop(struct ltt_session *session);
 
+/* Start a session's snapshot relayd connections idle check timer. */
+int timer_session_snapshot_relayd_idle_timer_start(struct ltt_session *session,
+		unsigned int interval_us);
+/* Stop a session's snapshot relayd connections idle check timer. */
+int timer_session_snapshot_relayd_idle_timer_stop(struct ltt_session *session);
+
 bool launch_timer_thread(
 		struct timer_thread_parameters *timer_thread_parameters);
 
@@ -298,6 +298,7 @@ struct ltt_ust_session *trace_ust_create_session(uint64_t session_id)
 	lus->buffer_type_changed = 0;
 	/* Init it in case it get used after allocation. */
 	CDS_INIT_LIST_HEAD(&lus->buffer_reg_uid_list);
+	ust_buffer_pool_init(&lus->buffer_pool);
 
 	/* Alloc UST global domain channels' HT */
 	lus->domain_global.channels = lttng_ht_new(0, LTTNG_HT_TYPE_STRING);
@@ -367,6 +368,10 @@ struct ltt_ust_channel *trace_ust_create_channel(struct lttng_channel *chan,
 			chan->attr.extended.ptr)->monitor_timer_interval;
 	luc->attr.u.s.blocking_timeout = ((struct lttng_channel_extended *)
 			chan->attr.extended.ptr)->blocking_timeout;
+	luc->writeback_window_size = ((struct lttng_channel_extended *)
+			chan->attr.extended.ptr)->writeback_window_size;
+	luc->direct_io = ((struct lttng_channel_extended *)
+			chan->attr.extended.ptr)->direct_io;
 
 	/* Translate to UST output enum */
 	switch (luc->attr.output) {
@@ -1422,6 +1427,8 @@ void trace_ust_destroy_session(struct ltt_ust_session *session)
 		buffer_reg_uid_destroy(reg, session->consumer);
 	}
 
+	ust_buffer_pool_fini(&session->buffer_pool);
+
 	process_attr_tracker_destroy(session->tracker_vpid);
 	process_attr_tracker_destroy(session->tracker_vuid);
 	process_attr_tracker_destroy(session->tracker_vgid);
@@ -19,6 +19,7 @@
 
 #include "consumer.h"
 #include "lttng-ust-ctl.h"
+#include "ust-buffer-pool.h"
 
 struct agent;
 
@@ -74,6 +75,8 @@ struct ltt_ust_channel {
 	uint64_t per_pid_closed_app_discarded;
 	uint64_t per_pid_closed_app_lost;
 	uint64_t monitor_timer_interval;
+	uint64_t writeback_window_size;
+	bool direct_io;
 };
 
 /* UST domain global (LTTNG_DOMAIN_UST) */
@@ -110,6 +113,8 @@ struct ltt_ust_session {
 	int buffer_type_changed;
 	/* For per UID buffer, every buffer reg object is kept of this session */
 	struct cds_list_head buffer_reg_uid_list;
+	/* For per PID buffer, buffer sets reserved in the consumers. */
+	struct ust_buffer_pool buffer_pool;
 	/* Next channel ID available for a newly registered channel. */
 	uint64_t next_channel_id;
 	/* Once this value reaches UINT32_MAX, no more id can be allocated. */
@@ -21,6 +21,7 @@
 #include <common/bytecode/bytecode.h>
 #include <common/compat/errno.h>
 #include <common/common.h>
+#include <common/dynamic-array.h>
 #include <common/hashtable/utils.h>
 #include <lttng/event-rule/event-rule.h>
 #include <lttng/event-rule/event-rule-internal.h>
@@ -2266,6 +2267,8 @@ static void shadow_copy_channel(struct ust_app_channel *ua_chan,
 	ua_chan->attr.switch_timer_interval = uchan->attr.switch_timer_interval;
 	ua_chan->attr.read_timer_interval = uchan->attr.read_timer_interval;
 	ua_chan->monitor_timer_interval = uchan->monitor_timer_interval;
+	ua_chan->writeback_window_size = uchan->writeback_window_size;
+	ua_chan->direct_io = uchan->direct_io;
 	ua_chan->attr.output = uchan->attr.output;
 	ua_chan->attr.blocking_timeout = uchan->attr.u.s.blocking_timeout;
 
@@ -2411,14 +2414,22 @@ error:
  * is found, a new one is created, added to the global registry and
  * initialized. If regp is valid, it's set with the newly created object.
  *
+ * A new registry takes the uuid of a buffer set reserved in the session's
+ * buffer pool, if any, so that the consumer can hand over the buffers it
+ * already created for it.
+ *
  * Return 0 on success or else a negative value.
  */
-static int setup_buffer_reg_pid(struct ust_app_session *ua_sess,
+static int setup_buffer_reg_pid(struct ltt_ust_session *usess,
+		struct ust_app_session *ua_sess,
 		struct ust_app *app, struct buffer_reg_pid **regp)
 {
 	int ret = 0;
+	bool pooled;
+	lttng_uuid uuid;
 	struct buffer_reg_pid *reg_pid;
 
+	assert(usess);
 	assert(ua_sess);
 	assert(app);
 
@@ -2439,6 +2450,8 @@ static int setup_buffer_reg_pid(struct ust_app_session *ua_sess,
 		goto end;
 	}
 
+	pooled = ust_buffer_pool_claim(usess, app->bits_per_long, uuid);
+
 	/* Initialize registry. */
 	ret = ust_registry_session_init(&reg_pid->registry->reg.ust, app,
 			app->bits_per_long, app->uint8_t_alignment,
@@ -2449,7 +2462,8 @@ static int setup_buffer_reg_pid(struct ust_app_session *ua_sess,
 			lttng_credentials_get_uid(&ua_sess->effective_credentials),
 			lttng_credentials_get_gid(&ua_sess->effective_credentials),
 			ua_sess->tracing_id,
-			app->uid);
+			app->uid,
+			pooled ? uuid : NULL);
 	if (ret < 0) {
 		/*
 		 * reg_pid->registry->reg.ust is NULL upon error, so we need to
@@ -2517,7 +2531,7 @@ static int setup_buffer_reg_uid(struct ltt_ust_session *usess,
 			app->byte_order, app->version.major,
 			app->version.minor, reg_uid->root_shm_path,
 			reg_uid->shm_path, usess->uid, usess->gid,
-			ua_sess->tracing_id, app->uid);
+			ua_sess->tracing_id, app->uid, NULL);
 	if (ret < 0) {
 		/*
 		 * reg_uid->registry->reg.ust is NULL upon error, so we need to
@@ -2584,7 +2598,7 @@ static int find_or_create_ust_app_session(struct ltt_ust_session *usess,
 	switch (usess->buffer_type) {
 	case LTTNG_BUFFER_PER_PID:
 		/* Init local registry. */
-		ret = setup_buffer_reg_pid(ua_sess, app, NULL);
+		ret = setup_buffer_reg_pid(usess, ua_sess, app, NULL);
 		if (ret < 0) {
 			delete_ust_app_session(-1, ua_sess, app);
 			goto error;
@@ -2877,14 +2891,19 @@ error:
 /*
  * Ask the consumer to create a channel and get it if successful.
  *
+ * When `app` is not NULL, the consumer sends the channel and its streams
+ * directly to that application instead of handing them to the session daemon.
+ * The channel is then flagged as sent and has no stream object.
+ *
  * Called with UST app session lock held.
  *
- * Return 0 on success or else a negative value.
+ * Return 0 on success or else a negative value. Returns -ENOTCONN if the
+ * application exited during a direct handoff.
  */
 static int do_consumer_create_channel(struct ltt_ust_session *usess,
 		struct ust_app_session *ua_sess, struct ust_app_channel *ua_chan,
 		int bitness, struct ust_registry_session *registry,
-		uint64_t trace_archive_id)
+		uint64_t trace_archive_id, struct ust_app *app)
 {
 	int ret;
 	unsigned int nb_fd = 0;
@@ -2924,6 +2943,20 @@ static int do_consumer_create_channel(struct ltt_ust_session *usess,
 		goto error_ask;
 	}
 
+	if (app && usess->consumer->enabled) {
+		/*
+		 * The stream file descriptors never transit through the
+		 * session daemon; no need to reserve them.
+		 */
+		ret = ust_consumer_send_channel_to_app(socket, app, ua_sess,
+				ua_chan);
+		if (ret < 0) {
+			goto error_fd_get_stream;
+		}
+		ua_chan->is_sent = 1;
+		goto end;
+	}
+
 	/*
 	 * Compute the number of fd needed before receiving them. It must be 2 per
 	 * stream (2 being the default value here).
@@ -2950,6 +2983,7 @@ static int do_consumer_create_channel(struct ltt_ust_session *usess,
 		}
 	}
 
+end:
 	rcu_read_unlock();
 	return 0;
 
@@ -3117,6 +3151,9 @@ static int create_buffer_reg_channel(struct buffer_reg_session *reg_sess,
 	buf_reg_chan->consumer_key = ua_chan->key;
 	buf_reg_chan->subbuf_size = ua_chan->attr.subbuf_size;
 	buf_reg_chan->num_subbuf = ua_chan->attr.num_subbuf;
+	strncpy(buf_reg_chan->name, ua_chan->name,
+			sizeof(buf_reg_chan->name));
+	buf_reg_chan->name[sizeof(buf_reg_chan->name) - 1] = '\0';
 
 	/* Create and add a channel registry to session. */
 	ret = ust_registry_channel_add(reg_sess->reg.ust,
@@ -3302,7 +3339,7 @@ static int create_channel_per_uid(struct ust_app *app,
 	 */
 	ret = do_consumer_create_channel(usess, ua_sess, ua_chan,
 			app->bits_per_long, reg_uid->registry->reg.ust,
-			session->most_recent_chunk_id.value);
+			session->most_recent_chunk_id.value, NULL);
 	if (ret < 0) {
 		ERR("Error creating UST channel \"%s\" on the consumer daemon",
 				ua_chan->name);
@@ -3413,22 +3450,29 @@ static int create_channel_per_pid(struct ust_app *app,
 	assert(pthread_mutex_trylock(&session->lock));
 	assert(session_trylock_list());
 
-	/* Create and get channel on the consumer side. */
+	/*
+	 * Create the channel on the consumer side and have the consumer hand
+	 * its buffers directly to the application.
+	 */
 	ret = do_consumer_create_channel(usess, ua_sess, ua_chan,
 			app->bits_per_long, registry,
-			session->most_recent_chunk_id.value);
+			session->most_recent_chunk_id.value, app);
 	if (ret < 0) {
-		ERR("Error creating UST channel \"%s\" on the consumer daemon",
-			ua_chan->name);
+		if (ret != -ENOTCONN) {
+			ERR("Error creating UST channel \"%s\" on the consumer daemon",
+				ua_chan->name);
+		}
 		goto error_remove_from_registry;
 	}
 
-	ret = send_channel_pid_to_ust(app, ua_sess, ua_chan);
-	if (ret < 0) {
-		if (ret != -ENOTCONN) {
-			ERR("Error sending channel to application");
+	if (!ua_chan->is_sent) {
+		ret = send_channel_pid_to_ust(app, ua_sess, ua_chan);
+		if (ret < 0) {
+			if (ret != -ENOTCONN) {
+				ERR("Error sending channel to application");
+			}
+			goto error_remove_from_registry;
 		}
-		goto error_remove_from_registry;
 	}
 
 	chan_reg_key = ua_chan->key;
@@ -4051,12 +4095,19 @@ error:
 }
 
 /*
- * Unregister app by removing it from the global traceable app list and freeing
- * the data struct.
+ * Unregister app by removing it from the global traceable app list.
+ *
+ * The application's sessions are detached and moved to its teardown list, but
+ * no command is sent to the consumer here: flushing the buffers and pushing
+ * the metadata of a dead application is costly, so the application is
+ * returned to the caller which must hand it to ust_app_reap(). The
+ * application is freed by ust_app_reap() once its teardown is done.
  *
  * The socket is already closed at this point so no close to sock.
+ *
+ * Return the unregistered application.
  */
-void ust_app_unregister(int sock)
+struct ust_app *ust_app_unregister(int sock)
 {
 	struct ust_app *lta;
 	struct lttng_ht_node_ulong *node;
@@ -4076,25 +4127,18 @@ void ust_app_unregister(int sock)
 	DBG("PID %d unregistering with sock %d", lta->pid, sock);
 
 	/*
-	 * For per-PID buffers, perform "push metadata" and flush all
-	 * application streams before removing app from hash tables,
-	 * ensuring proper behavior of data_pending check.
-	 * Remove sessions so they are not visible during deletion.
+	 * Remove sessions so they are not visible during deletion. The flush
+	 * of the per-PID buffers and the metadata push are deferred to
+	 * ust_app_reap().
 	 */
 	cds_lfht_for_each_entry(lta->sessions->ht, &iter.iter, ua_sess,
 			node.node) {
-		struct ust_registry_session *registry;
-
 		ret = lttng_ht_del(lta->sessions, &iter);
 		if (ret) {
 			/* The session was already removed so scheduled for teardown. */
 			continue;
 		}
 
-		if (ua_sess->buffer_type == LTTNG_BUFFER_PER_PID) {
-			(void) ust_app_flush_app_session(lta, ua_sess);
-		}
-
 		/*
 		 * Add session to list for teardown. This is safe since at this point we
 		 * are the only one using this list.
@@ -4106,33 +4150,6 @@ void ust_app_unregister(int sock)
 			continue;
 		}
 
-		/*
-		 * Normally, this is done in the delete session process which is
-		 * executed in the call rcu below. However, upon registration we can't
-		 * afford to wait for the grace period before pushing data or else the
-		 * data pending feature can race between the unregistration and stop
-		 * command where the data pending command is sent *before* the grace
-		 * period ended.
-		 *
-		 * The close metadata below nullifies the metadata pointer in the
-		 * session so the delete session will NOT push/close a second time.
-		 */
-		registry = get_session_registry(ua_sess);
-		if (registry) {
-			/* Push metadata for application before freeing the application. */
-			(void) push_metadata(registry, ua_sess->consumer);
-
-			/*
-			 * Don't ask to close metadata for global per UID buffers. Close
-			 * metadata only on destroy trace session in this case. Also, the
-			 * previous push metadata could have flag the metadata registry to
-			 * close so don't send a close command if closed.
-			 */
-			if (ua_sess->buffer_type != LTTNG_BUFFER_PER_UID) {
-				/* And ask to close it for this session registry. */
-				(void) close_metadata(registry, ua_sess->consumer);
-			}
-		}
 		cds_list_add(&ua_sess->teardown_node, &lta->teardown_head);
 
 		pthread_mutex_unlock(&ua_sess->lock);
@@ -4163,11 +4180,218 @@ void ust_app_unregister(int sock)
 				lta->pid);
 	}
 
-	/* Free memory */
-	call_rcu(&lta->pid_n.head, delete_ust_app_rcu);
+	rcu_read_unlock();
+	return lta;
+}
+
+/*
+ * Set of per-PID channel keys to flush through the same consumer socket.
+ */
+struct reap_flush_set {
+	struct consumer_socket *socket;
+	/* Array of uint64_t channel keys. */
+	struct lttng_dynamic_array keys;
+};
+
+static
+void reap_flush_set_destroy(void *ptr)
+{
+	struct reap_flush_set *set = ptr;
+
+	if (!set) {
+		return;
+	}
+
+	lttng_dynamic_array_reset(&set->keys);
+	free(set);
+}
+
+/*
+ * Add the keys of the channels of a per-PID application session to the flush
+ * set of its consumer socket, creating that set if needed.
+ *
+ * Called with the RCU read side lock and the application session lock held.
+ */
+static
+int reap_add_app_session_channels(struct lttng_dynamic_pointer_array *sets,
+		struct ust_app *app, struct ust_app_session *ua_sess)
+{
+	int ret = 0;
+	size_t i;
+	struct lttng_ht_iter iter;
+	struct ust_app_channel *ua_chan;
+	struct consumer_socket *socket;
+	struct reap_flush_set *set = NULL;
+
+	socket = consumer_find_socket_by_bitness(app->bits_per_long,
+			ua_sess->consumer);
+	if (!socket) {
+		goto end;
+	}
+
+	for (i = 0; i < lttng_dynamic_pointer_array_get_count(sets); i++) {
+		struct reap_flush_set *candidate =
+				lttng_dynamic_pointer_array_get_pointer(sets, i);
+
+		if (candidate->socket == socket) {
+			set = candidate;
+			break;
+		}
+	}
+
+	if (!set) {
+		set = zmalloc(sizeof(*set));
+		if (!set) {
+			PERROR("zmalloc reap flush set");
+			ret = -ENOMEM;
+			goto end;
+		}
+		set->socket = socket;
+		lttng_dynamic_array_init(&set->keys, sizeof(uint64_t), NULL);
+		ret = lttng_dynamic_pointer_array_add_pointer(sets, set);
+		if (ret) {
+			reap_flush_set_destroy(set);
+			goto end;
+		}
+	}
+
+	cds_lfht_for_each_entry(ua_sess->channels->ht, &iter.iter, ua_chan,
+			node.node) {
+		ret = lttng_dynamic_array_add_element(&set->keys, &ua_chan->key);
+		if (ret) {
+			goto end;
+		}
+	}
+
+end:
+	return ret;
+}
+
+/*
+ * Tear down a batch of applications previously unregistered through
+ * ust_app_unregister().
+ *
+ * For per-PID buffers, the channels of all the applications of the batch that
+ * share a consumer socket are flushed with a single consumer command. Then,
+ * the metadata of each application session is pushed and closed, which
+ * ensures proper behavior of the data_pending check. Finally, the
+ * applications are freed after a grace period.
+ *
+ * The RCU read side lock must NOT be held by the caller.
+ */
+void ust_app_reap(struct ust_app **apps, size_t count)
+{
+	int ret;
+	size_t i;
+	struct lttng_dynamic_pointer_array flush_sets;
+
+	lttng_dynamic_pointer_array_init(&flush_sets, reap_flush_set_destroy);
+
+	DBG("Reaping %zu unregistered applications", count);
+
+	rcu_read_lock();
+
+	/* Gather the per-PID channels to flush, grouped by consumer socket. */
+	for (i = 0; i < count; i++) {
+		struct ust_app *app = apps[i];
+		struct ust_app_session *ua_sess;
+
+		if (!app->compatible) {
+			continue;
+		}
+
+		cds_list_for_each_entry(ua_sess, &app->teardown_head,
+				teardown_node) {
+			if (ua_sess->buffer_type != LTTNG_BUFFER_PER_PID) {
+				continue;
+			}
+
+			pthread_mutex_lock(&ua_sess->lock);
+			if (!ua_sess->deleted) {
+				ret = reap_add_app_session_channels(
+						&flush_sets, app, ua_sess);
+				if (ret) {
+					ERR("Failed to gather channels to flush of app pid %d",
+							app->pid);
+				}
+			}
+			pthread_mutex_unlock(&ua_sess->lock);
+		}
+	}
+
+	for (i = 0; i < lttng_dynamic_pointer_array_get_count(&flush_sets); i++) {
+		const struct reap_flush_set *set =
+				lttng_dynamic_pointer_array_get_pointer(
+						&flush_sets, i);
+		const size_t key_count =
+				lttng_dynamic_array_get_count(&set->keys);
+
+		health_code_update();
+		ret = consumer_flush_channels(set->socket,
+				key_count ? lttng_dynamic_array_get_element(
+						&set->keys, 0) : NULL,
+				(uint32_t) key_count);
+		if (ret) {
+			ERR("Error flushing %zu consumer channels of unregistered applications",
+					key_count);
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		struct ust_app *app = apps[i];
+		struct ust_app_session *ua_sess;
+
+		cds_list_for_each_entry(ua_sess, &app->teardown_head,
+				teardown_node) {
+			struct ust_registry_session *registry;
+
+			pthread_mutex_lock(&ua_sess->lock);
+
+			if (ua_sess->deleted) {
+				pthread_mutex_unlock(&ua_sess->lock);
+				continue;
+			}
+
+			/*
+			 * Normally, this is done in the delete session process
+			 * which is executed in the call rcu below. However, we
+			 * can't afford to wait for the grace period before pushing
+			 * data or else the data pending feature can race between
+			 * the unregistration and stop command where the data
+			 * pending command is sent *before* the grace period ended.
+			 *
+			 * The close metadata below nullifies the metadata pointer
+			 * in the session so the delete session will NOT push/close
+			 * a second time.
+			 */
+			registry = get_session_registry(ua_sess);
+			if (registry) {
+				/* Push metadata for application before freeing the application. */
+				(void) push_metadata(registry, ua_sess->consumer);
+
+				/*
+				 * Don't ask to close metadata for global per UID
+				 * buffers. Close metadata only on destroy trace
+				 * session in this case. Also, the previous push
+				 * metadata could have flag the metadata registry to
+				 * close so don't send a close command if closed.
+				 */
+				if (ua_sess->buffer_type != LTTNG_BUFFER_PER_UID) {
+					/* And ask to close it for this session registry. */
+					(void) close_metadata(registry, ua_sess->consumer);
+				}
+			}
+
+			pthread_mutex_unlock(&ua_sess->lock);
+		}
+
+		/* Free memory */
+		call_rcu(&app->pid_n.head, delete_ust_app_rcu);
+	}
 
 	rcu_read_unlock();
-	return;
+	lttng_dynamic_pointer_array_reset(&flush_sets);
+	health_code_update();
 }
 
 /*
@@ -4914,6 +5138,97 @@ int ust_app_create_event_glb(struct ltt_ust_session *usess,
 	return ret;
 }
 
+/*
+ * For a set of UST events of a channel, create the events missing from each
+ * registered application and enable the others. Each application session is
+ * locked once for the whole set.
+ */
+int ust_app_enable_events_glb(struct ltt_ust_session *usess,
+		struct ltt_ust_channel *uchan, struct ltt_ust_event **uevents,
+		unsigned int count)
+{
+	int ret = 0;
+	unsigned int i;
+	struct lttng_ht_iter iter, uiter;
+	struct lttng_ht_node_str *ua_chan_node;
+	struct ust_app *app;
+	struct ust_app_session *ua_sess;
+	struct ust_app_channel *ua_chan;
+	struct ust_app_event *ua_event;
+
+	assert(usess->active);
+	DBG("UST app enabling %u events for all apps for session id %" PRIu64,
+			count, usess->id);
+
+	rcu_read_lock();
+
+	/* For all registered applications */
+	cds_lfht_for_each_entry(ust_app_ht->ht, &iter.iter, app, pid_n.node) {
+		if (!app->compatible) {
+			continue;
+		}
+		ua_sess = lookup_session_by_app(usess, app);
+		if (!ua_sess) {
+			/* The application has problem or is probably dead. */
+			continue;
+		}
+
+		pthread_mutex_lock(&ua_sess->lock);
+
+		if (ua_sess->deleted) {
+			pthread_mutex_unlock(&ua_sess->lock);
+			continue;
+		}
+
+		/* Lookup channel in the ust app session */
+		lttng_ht_lookup(ua_sess->channels, (void *)uchan->name, &uiter);
+		ua_chan_node = lttng_ht_iter_get_node_str(&uiter);
+		/*
+		 * It is possible that the channel cannot be found is
+		 * the channel/event creation occurs concurrently with
+		 * an application exit.
+		 */
+		if (!ua_chan_node) {
+			pthread_mutex_unlock(&ua_sess->lock);
+			continue;
+		}
+
+		ua_chan = caa_container_of(ua_chan_node, struct ust_app_channel, node);
+
+		for (i = 0; i < count; i++) {
+			struct ltt_ust_event *uevent = uevents[i];
+
+			ua_event = find_ust_app_event(ua_chan->events,
+					uevent->attr.name, uevent->filter,
+					uevent->attr.loglevel, uevent->exclusion);
+			if (ua_event == NULL) {
+				ret = create_ust_app_event(ua_sess, ua_chan,
+						uevent, app);
+			} else if (!ua_event->enabled) {
+				ret = enable_ust_app_event(ua_sess, ua_event,
+						app);
+			} else {
+				continue;
+			}
+			if (ret == -LTTNG_UST_ERR_EXIST) {
+				DBG2("UST app event %s already exist on app PID %d",
+						uevent->attr.name, app->pid);
+				ret = 0;
+			} else if (ret < 0) {
+				/* Possible value at this point: -ENOMEM. If so, we stop! */
+				pthread_mutex_unlock(&ua_sess->lock);
+				goto error;
+			}
+		}
+
+		pthread_mutex_unlock(&ua_sess->lock);
+	}
+
+error:
+	rcu_read_unlock();
+	return ret;
+}
+
 /*
  * Start tracing for a specific UST session and app.
  *
@@ -6643,15 +6958,19 @@ void ust_app_destroy(struct ust_app *app)
 
 /*
  * Take a snapshot for a given UST session. The snapshot is sent to the given
- * output.
+ * output and restricted to the channels of the scope, if any.
  *
  * Returns LTTNG_OK on success or a LTTNG_ERR error code.
  */
 enum lttng_error_code ust_app_snapshot_record(
 		const struct ltt_ust_session *usess,
 		const struct consumer_output *output, int wait,
-		uint64_t nb_packets_per_stream)
+		uint64_t nb_packets_per_stream,
+		const struct snapshot_scope *scope)
 {
+	const uint64_t begin_timestamp =
+			snapshot_scope_get_begin_timestamp(scope);
+
 	int ret = 0;
 	enum lttng_error_code status = LTTNG_OK;
 	struct lttng_ht_iter iter;
@@ -6707,11 +7026,15 @@ enum lttng_error_code ust_app_snapshot_record(
 			/* Add the UST default trace dir to path. */
 			cds_lfht_for_each_entry(reg->registry->channels->ht, &iter.iter,
 					buf_reg_chan, node.node) {
+				if (!snapshot_scope_has_channel(scope,
+						buf_reg_chan->name)) {
+					continue;
+				}
 				status = consumer_snapshot_channel(socket,
 						buf_reg_chan->consumer_key,
 						output, 0, usess->uid,
 						usess->gid, &trace_path[consumer_path_offset], wait,
-						nb_packets_per_stream);
+						nb_packets_per_stream, begin_timestamp);
 				if (status != LTTNG_OK) {
 					goto error;
 				}
@@ -6719,7 +7042,7 @@ enum lttng_error_code ust_app_snapshot_record(
 			status = consumer_snapshot_channel(socket,
 					reg->registry->reg.ust->metadata_key, output, 1,
 					usess->uid, usess->gid, &trace_path[consumer_path_offset],
-					wait, 0);
+					wait, 0, 0);
 			if (status != LTTNG_OK) {
 				goto error;
 			}
@@ -6770,12 +7093,16 @@ enum lttng_error_code ust_app_snapshot_record(
 			}
 			cds_lfht_for_each_entry(ua_sess->channels->ht, &chan_iter.iter,
 					ua_chan, node.node) {
+				if (!snapshot_scope_has_channel(scope,
+						ua_chan->name)) {
+					continue;
+				}
 				status = consumer_snapshot_channel(socket,
 						ua_chan->key, output, 0,
 						lttng_credentials_get_uid(&ua_sess->effective_credentials),
 						lttng_credentials_get_gid(&ua_sess->effective_credentials),
 						&trace_path[consumer_path_offset], wait,
-						nb_packets_per_stream);
+						nb_packets_per_stream, begin_timestamp);
 				switch (status) {
 				case LTTNG_OK:
 					break;
@@ -6795,7 +7122,7 @@ enum lttng_error_code ust_app_snapshot_record(
 					registry->metadata_key, output, 1,
 					lttng_credentials_get_uid(&ua_sess->effective_credentials),
 					lttng_credentials_get_gid(&ua_sess->effective_credentials),
-					&trace_path[consumer_path_offset], wait, 0);
+					&trace_path[consumer_path_offset], wait, 0, 0);
 			switch (status) {
 			case LTTNG_OK:
 				break;
@@ -6822,7 +7149,8 @@ error:
  * Return the size taken by one more packet per stream.
  */
 uint64_t ust_app_get_size_one_more_packet_per_stream(
-		const struct ltt_ust_session *usess, uint64_t cur_nr_packets)
+		const struct ltt_ust_session *usess, uint64_t cur_nr_packets,
+		const struct snapshot_scope *scope)
 {
 	uint64_t tot_size = 0;
 	struct ust_app *app;
@@ -6841,6 +7169,10 @@ uint64_t ust_app_get_size_one_more_packet_per_stream(
 			rcu_read_lock();
 			cds_lfht_for_each_entry(reg->registry->channels->ht, &iter.iter,
 					buf_reg_chan, node.node) {
+				if (!snapshot_scope_has_channel(scope,
+						buf_reg_chan->name)) {
+					continue;
+				}
 				if (cur_nr_packets >= buf_reg_chan->num_subbuf) {
 					/*
 					 * Don't take channel into account if we
@@ -6870,6 +7202,10 @@ uint64_t ust_app_get_size_one_more_packet_per_stream(
 
 			cds_lfht_for_each_entry(ua_sess->channels->ht, &chan_iter.iter,
 					ua_chan, node.node) {
+				if (!snapshot_scope_has_channel(scope,
+						ua_chan->name)) {
+					continue;
+				}
 				if (cur_nr_packets >= ua_chan->attr.num_subbuf) {
 					/*
 					 * Don't take channel into account if we
@@ -172,6 +172,8 @@ struct ust_app_channel {
 	uint64_t tracefile_size;
 	uint64_t tracefile_count;
 	uint64_t monitor_timer_interval;
+	uint64_t writeback_window_size;
+	bool direct_io;
 	/*
 	 * Node indexed by channel name in the channels' hash table of a session.
 	 */
@@ -332,7 +334,8 @@ struct ust_app {
 int ust_app_register(struct ust_register_msg *msg, int sock);
 int ust_app_register_done(struct ust_app *app);
 int ust_app_version(struct ust_app *app);
-void ust_app_unregister(int sock);
+struct ust_app *ust_app_unregister(int sock);
+void ust_app_reap(struct ust_app **apps, size_t count);
 int ust_app_start_trace_all(struct ltt_ust_session *usess);
 int ust_app_stop_trace_all(struct ltt_ust_session *usess);
 int ust_app_destroy_trace_all(struct ltt_ust_session *usess);
@@ -346,6 +349,9 @@ int ust_app_enable_channel_glb(struct ltt_ust_session *usess,
 		struct ltt_ust_channel *uchan);
 int ust_app_enable_event_glb(struct ltt_ust_session *usess,
 		struct ltt_ust_channel *uchan, struct ltt_ust_event *uevent);
+int ust_app_enable_events_glb(struct ltt_ust_session *usess,
+		struct ltt_ust_channel *uchan, struct ltt_ust_event **uevents,
+		unsigned int count);
 int ust_app_disable_event_glb(struct ltt_ust_session *usess,
 		struct ltt_ust_channel *uchan, struct ltt_ust_event *uevent);
 int ust_app_add_ctx_channel_glb(struct ltt_ust_session *usess,
@@ -370,9 +376,11 @@ void ust_app_destroy(struct ust_app *app);
 enum lttng_error_code ust_app_snapshot_record(
 		const struct ltt_ust_session *usess,
 		const struct consumer_output *output, int wait,
-		uint64_t nb_packets_per_stream);
+		uint64_t nb_packets_per_stream,
+		const struct snapshot_scope *scope);
 uint64_t ust_app_get_size_one_more_packet_per_stream(
-		const struct ltt_ust_session *usess, uint64_t cur_nr_packets);
+		const struct ltt_ust_session *usess, uint64_t cur_nr_packets,
+		const struct snapshot_scope *scope);
 struct ust_app *ust_app_find_by_sock(int sock);
 int ust_app_uid_get_channel_runtime_stats(uint64_t ust_session_id,
 		struct cds_list_head *buffer_reg_uid_list,
@@ -447,7 +455,12 @@ int ust_app_version(struct ust_app *app)
 	return -ENOSYS;
 }
 static inline
-void ust_app_unregister(int sock)
+struct ust_app *ust_app_unregister(int sock)
+{
+	return NULL;
+}
+static inline
+void ust_app_reap(struct ust_app **apps, size_t count)
 {
 }
 static inline
@@ -522,6 +535,13 @@ int ust_app_enable_event_glb(struct ltt_ust_session *usess,
 	return 0;
 }
 static inline
+int ust_app_enable_events_glb(struct ltt_ust_session *usess,
+		struct ltt_ust_channel *uchan, struct ltt_ust_event **uevents,
+		unsigned int count)
+{
+	return 0;
+}
+static inline
 int ust_app_add_ctx_channel_glb(struct ltt_ust_session *usess,
 		struct ltt_ust_channel *uchan, struct ltt_ust_context *uctx)
 {
@@ -570,7 +590,8 @@ void ust_app_destroy(struct ust_app *app)
 }
 static inline
 enum lttng_error_code ust_app_snapshot_record(struct ltt_ust_session *usess,
-		const struct consumer_output *output, int wait, uint64_t max_stream_size)
+		const struct consumer_output *output, int wait, uint64_t max_stream_size,
+		const struct snapshot_scope *scope)
 {
 	return 0;
 }
@@ -597,7 +618,8 @@ struct ust_app *ust_app_find_by_pid(pid_t pid)
 }
 static inline
 uint64_t ust_app_get_size_one_more_packet_per_stream(
-		const struct ltt_ust_session *usess, uint64_t cur_nr_packets) {
+		const struct ltt_ust_session *usess, uint64_t cur_nr_packets,
+		const struct snapshot_scope *scope) {
 	return 0;
 }
 static inline
@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <inttypes.h>
+
+#include <common/common.h>
+#include <common/defaults.h>
+
+#include "consumer.h"
+#include "lttng-sessiond.h"
+#include "rotation-thread.h"
+#include "session.h"
+#include "trace-ust.h"
+#include "ust-buffer-pool.h"
+
+struct ust_buffer_pool_reservation {
+	lttng_uuid uuid;
+	uint32_t bits_per_long;
+	struct cds_list_head node;
+};
+
+void ust_buffer_pool_init(struct ust_buffer_pool *pool)
+{
+	pthread_mutex_init(&pool->lock, NULL);
+	CDS_INIT_LIST_HEAD(&pool->reservations);
+}
+
+void ust_buffer_pool_fini(struct ust_buffer_pool *pool)
+{
+	struct ust_buffer_pool_reservation *reservation, *tmp;
+
+	cds_list_for_each_entry_safe(reservation, tmp, &pool->reservations,
+			node) {
+		cds_list_del(&reservation->node);
+		free(reservation);
+	}
+	pthread_mutex_destroy(&pool->lock);
+}
+
+static bool pool_enabled(const struct ltt_ust_session *usess)
+{
+	/*
+	 * The buffers of the sessions using an explicit shm path are created
+	 * as files named after their channel and application.
+	 */
+	return config.ust_buffer_pool_size > 0 &&
+			usess->buffer_type == LTTNG_BUFFER_PER_PID &&
+			!usess->shm_path[0] && usess->consumer;
+}
+
+/*
+ * Describe the data channels of the session as they will be created for a
+ * new application. The tracer side channel IDs are assigned, per registry, in
+ * the order in which the channels are created, which follows the iteration
+ * order of the session's channels. A channel which is not created as
+ * expected only causes its buffers to be allocated on demand.
+ *
+ * Return the number of channels, or a negative value on error.
+ */
+static int pool_get_channels(struct ltt_ust_session *usess,
+		struct lttcomm_consumer_buffer_set_channel **_channels)
+{
+	int count = 0;
+	unsigned long channel_count;
+	struct lttng_ht_iter iter;
+	struct ltt_ust_channel *uchan;
+	struct lttcomm_consumer_buffer_set_channel *channels;
+
+	channel_count = lttng_ht_get_count(usess->domain_global.channels);
+	if (channel_count == 0) {
+		return 0;
+	}
+
+	channels = zmalloc(channel_count * sizeof(*channels));
+	if (!channels) {
+		PERROR("zmalloc buffer set channels");
+		return -1;
+	}
+
+	cds_lfht_for_each_entry(usess->domain_global.channels->ht, &iter.iter,
+			uchan, node.node) {
+		struct lttcomm_consumer_buffer_set_channel *channel;
+
+		if (!strncmp(uchan->name, DEFAULT_METADATA_NAME,
+				sizeof(uchan->name))) {
+			continue;
+		}
+
+		channel = &channels[count];
+		channel->chan_id = count;
+		count++;
+		channel->subbuf_size = uchan->attr.subbuf_size;
+		channel->num_subbuf = uchan->attr.num_subbuf;
+		channel->overwrite = uchan->attr.overwrite;
+		channel->switch_timer_interval =
+				uchan->attr.switch_timer_interval;
+		channel->read_timer_interval = uchan->attr.read_timer_interval;
+		channel->blocking_timeout = uchan->attr.u.s.blocking_timeout;
+	}
+
+	*_channels = channels;
+	return count;
+}
+
+/*
+ * Reserve one buffer set in the consumer of the given bitness.
+ *
+ * Return 0 on success else a negative value.
+ */
+static int pool_reserve(struct ltt_ust_session *usess, uint32_t bits_per_long,
+		const struct lttcomm_consumer_buffer_set_channel *channels,
+		int channel_count)
+{
+	int ret;
+	struct consumer_socket *socket;
+	struct ust_buffer_pool_reservation *reservation;
+
+	socket = consumer_find_socket_by_bitness(bits_per_long,
+			usess->consumer);
+	if (!socket) {
+		ret = -1;
+		goto error;
+	}
+
+	reservation = zmalloc(sizeof(*reservation));
+	if (!reservation) {
+		PERROR("zmalloc buffer pool reservation");
+		ret = -1;
+		goto error;
+	}
+	reservation->bits_per_long = bits_per_long;
+	ret = lttng_uuid_generate(reservation->uuid);
+	if (ret) {
+		ERR("Failed to generate buffer pool reservation uuid");
+		ret = -1;
+		goto error_free;
+	}
+
+	ret = consumer_prepare_buffer_set(socket, usess->id, reservation->uuid,
+			channels, channel_count);
+	if (ret < 0) {
+		goto error_free;
+	}
+
+	pthread_mutex_lock(&usess->buffer_pool.lock);
+	cds_list_add_tail(&reservation->node, &usess->buffer_pool.reservations);
+	pthread_mutex_unlock(&usess->buffer_pool.lock);
+	return 0;
+
+error_free:
+	free(reservation);
+error:
+	return ret;
+}
+
+static unsigned int pool_count(struct ust_buffer_pool *pool,
+		uint32_t bits_per_long)
+{
+	unsigned int count = 0;
+	struct ust_buffer_pool_reservation *reservation;
+
+	pthread_mutex_lock(&pool->lock);
+	cds_list_for_each_entry(reservation, &pool->reservations, node) {
+		if (reservation->bits_per_long == bits_per_long) {
+			count++;
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return count;
+}
+
+void ust_buffer_pool_fill(struct ltt_ust_session *usess)
+{
+	int channel_count;
+	unsigned int i;
+	struct lttcomm_consumer_buffer_set_channel *channels = NULL;
+	static const uint32_t bitnesses[] = { 32, 64 };
+
+	if (!pool_enabled(usess)) {
+		return;
+	}
+
+	pthread_mutex_lock(&usess->buffer_pool.lock);
+	usess->buffer_pool.refill_pending = false;
+	pthread_mutex_unlock(&usess->buffer_pool.lock);
+
+	channel_count = pool_get_channels(usess, &channels);
+	if (channel_count <= 0) {
+		goto end;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(bitnesses); i++) {
+		unsigned int count;
+
+		if (!consumer_find_socket_by_bitness(bitnesses[i],
+				usess->consumer)) {
+			continue;
+		}
+
+		count = pool_count(&usess->buffer_pool, bitnesses[i]);
+		for (; count < (unsigned int) config.ust_buffer_pool_size;
+				count++) {
+			if (pool_reserve(usess, bitnesses[i], channels,
+					channel_count)) {
+				WARN("Failed to reserve a %" PRIu32 "-bit buffer set for session %" PRIu64,
+						bitnesses[i], usess->id);
+				break;
+			}
+		}
+		DBG("UST buffer pool of session %" PRIu64 " holds %u %" PRIu32 "-bit buffer sets",
+				usess->id, count, bitnesses[i]);
+	}
+end:
+	free(channels);
+}
+
+bool ust_buffer_pool_claim(struct ltt_ust_session *usess,
+		uint32_t bits_per_long, lttng_uuid uuid)
+{
+	bool claimed = false;
+	struct ust_buffer_pool_reservation *reservation, *tmp;
+
+	if (!pool_enabled(usess)) {
+		goto end;
+	}
+
+	pthread_mutex_lock(&usess->buffer_pool.lock);
+	cds_list_for_each_entry_safe(reservation, tmp,
+			&usess->buffer_pool.reservations, node) {
+		if (reservation->bits_per_long != bits_per_long) {
+			continue;
+		}
+		cds_list_del(&reservation->node);
+		lttng_uuid_copy(uuid, reservation->uuid);
+		free(reservation);
+		/*
+		 * Replacing the reservation takes a round trip to the consumer
+		 * daemon, which the registering application must not wait for.
+		 */
+		usess->buffer_pool.refill_pending = true;
+		claimed = true;
+		break;
+	}
+	pthread_mutex_unlock(&usess->buffer_pool.lock);
+end:
+	return claimed;
+}
+
+void ust_buffer_pool_schedule_refill(struct ltt_session *session)
+{
+	bool refill_pending;
+	struct ltt_ust_session *usess = session->ust_session;
+
+	if (!usess || !pool_enabled(usess)) {
+		return;
+	}
+
+	pthread_mutex_lock(&usess->buffer_pool.lock);
+	refill_pending = usess->buffer_pool.refill_pending;
+	pthread_mutex_unlock(&usess->buffer_pool.lock);
+
+	if (refill_pending) {
+		rotation_thread_enqueue_job(rotation_timer_queue,
+				ROTATION_THREAD_JOB_TYPE_UST_BUFFER_POOL_REFILL,
+				session);
+	}
+}
+
+void ust_buffer_pool_release(struct ltt_ust_session *usess)
+{
+	struct lttng_ht_iter iter;
+	struct consumer_socket *socket;
+	struct ust_buffer_pool_reservation *reservation, *tmp;
+
+	if (!pool_enabled(usess)) {
+		return;
+	}
+
+	pthread_mutex_lock(&usess->buffer_pool.lock);
+	cds_list_for_each_entry_safe(reservation, tmp,
+			&usess->buffer_pool.reservations, node) {
+		cds_list_del(&reservation->node);
+		free(reservation);
+	}
+	pthread_mutex_unlock(&usess->buffer_pool.lock);
+
+	rcu_read_lock();
+	cds_lfht_for_each_entry(usess->consumer->socks->ht, &iter.iter, socket,
+			node.node) {
+		if (consumer_destroy_buffer_pool(socket, usess->id) < 0) {
+			DBG("Unable to send destroy buffer pool command to consumer");
+			/* Continue since we MUST delete everything at this point. */
+		}
+	}
+	rcu_read_unlock();
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_SESSIOND_UST_BUFFER_POOL_H
+#define LTTNG_SESSIOND_UST_BUFFER_POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <urcu/list.h>
+
+#include <common/uuid.h>
+
+struct ltt_session;
+struct ltt_ust_session;
+
+/*
+ * Buffer sets reserved in the consumer daemons for the applications which
+ * register to a started per-PID UST session (see --ust-buffer-pool-size).
+ *
+ * A reservation is the uuid of a future per-PID registry. The consumer daemon
+ * of the reservation's bitness creates, in the background, the buffers of
+ * every channel of the session for this uuid. The next application of that
+ * bitness takes the uuid for its registry and the consumer daemon hands it
+ * those buffers when its channels are created. The reservations taken are
+ * replaced later on by the rotation thread, off the registration path.
+ */
+struct ust_buffer_pool {
+	pthread_mutex_t lock;
+	/* struct ust_buffer_pool_reservation */
+	struct cds_list_head reservations;
+	/* Set when a reservation is taken, until the pool is filled again. */
+	bool refill_pending;
+};
+
+void ust_buffer_pool_init(struct ust_buffer_pool *pool);
+void ust_buffer_pool_fini(struct ust_buffer_pool *pool);
+
+#ifdef HAVE_LIBLTTNG_UST_CTL
+
+/*
+ * Reserve buffer sets up to the configured pool size for each consumer
+ * daemon of the session. The RCU read lock and the session lock must be held.
+ */
+void ust_buffer_pool_fill(struct ltt_ust_session *usess);
+
+/*
+ * Take a reservation of the given bitness, setting `uuid`. Return false if
+ * none is available. The RCU read lock and the session lock must be held.
+ */
+bool ust_buffer_pool_claim(struct ltt_ust_session *usess,
+		uint32_t bits_per_long, lttng_uuid uuid);
+
+/*
+ * Queue the replacement of the reservations taken from the pool of a session
+ * to the rotation thread. The session lock must be held.
+ */
+void ust_buffer_pool_schedule_refill(struct ltt_session *session);
+
+/*
+ * Drop every reservation of the session and release the buffer sets of the
+ * consumer daemons.
+ */
+void ust_buffer_pool_release(struct ltt_ust_session *usess);
+
+#else /* HAVE_LIBLTTNG_UST_CTL */
+
+static inline
+void ust_buffer_pool_fill(struct ltt_ust_session *usess)
+{
+}
+
+static inline
+bool ust_buffer_pool_claim(struct ltt_ust_session *usess,
+		uint32_t bits_per_long, lttng_uuid uuid)
+{
+	return false;
+}
+
+static inline
+void ust_buffer_pool_schedule_refill(struct ltt_session *session)
+{
+}
+
+static inline
+void ust_buffer_pool_release(struct ltt_ust_session *usess)
+{
+}
+
+#endif /* HAVE_LIBLTTNG_UST_CTL */
+
+#endif /* LTTNG_SESSIOND_UST_BUFFER_POOL_H */
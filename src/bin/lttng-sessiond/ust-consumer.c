@@ -45,7 +45,7 @@ static int ask_channel_creation(struct ust_app_session *ua_sess,
 	struct ust_registry_channel *ust_reg_chan;
 	char shm_path[PATH_MAX] = "";
 	char root_shm_path[PATH_MAX] = "";
-	bool is_local_trace;
+	bool has_local_output;
 	size_t consumer_path_offset = 0;
 
 	assert(ua_sess);
@@ -56,7 +56,7 @@ static int ask_channel_creation(struct ust_app_session *ua_sess,
 
 	DBG2("Asking UST consumer for channel");
 
-	is_local_trace = consumer->net_seq_index == -1ULL;
+	has_local_output = consumer_output_has_local_output(consumer);
 	/* Format the channel's path (relative to the current trace chunk). */
 	pathname = setup_channel_trace_path(consumer, ua_sess->path,
 			&consumer_path_offset);
@@ -65,7 +65,7 @@ static int ask_channel_creation(struct ust_app_session *ua_sess,
 		goto error;
 	}
 
-	if (is_local_trace && trace_chunk) {
+	if (has_local_output && trace_chunk) {
 		enum lttng_trace_chunk_status chunk_status;
 		char *pathname_index;
 
@@ -153,6 +153,8 @@ static int ask_channel_creation(struct ust_app_session *ua_sess,
 			ua_sess->output_traces,
 			lttng_credentials_get_uid(&ua_sess->real_credentials),
 			ua_chan->attr.blocking_timeout,
+			ua_chan->writeback_window_size,
+			ua_chan->direct_io,
 			root_shm_path, shm_path,
 			trace_chunk,
 			&ua_sess->effective_credentials);
@@ -316,6 +318,92 @@ error:
 	return ret;
 }
 
+/*
+ * Ask the consumer to send a channel and its streams directly to the
+ * application, bypassing the session daemon. The application's command
+ * socket is passed to the consumer for the duration of the exchange.
+ *
+ * On success, the channel object is populated with the handle of the channel
+ * in the application. It holds no file descriptor.
+ *
+ * Return 0 on success else a negative value. -ENOTCONN is returned if the
+ * application exited during the handoff.
+ */
+int ust_consumer_send_channel_to_app(struct consumer_socket *socket,
+		struct ust_app *app, struct ust_app_session *ua_sess,
+		struct ust_app_channel *ua_chan)
+{
+	int ret;
+	int32_t channel_handle;
+	struct lttcomm_consumer_msg msg;
+	struct lttng_ust_abi_object_data *obj = NULL;
+
+	assert(socket);
+	assert(app);
+	assert(ua_sess);
+	assert(ua_chan);
+
+	DBG2("UST consumer sending channel %s directly to app pid %d",
+			ua_chan->name, app->pid);
+
+	obj = zmalloc(sizeof(*obj));
+	if (!obj) {
+		PERROR("zmalloc ust app channel object");
+		ret = -ENOMEM;
+		goto end;
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd_type = LTTNG_CONSUMER_SEND_CHANNEL_TO_APP;
+	msg.u.send_channel_to_app.key = ua_chan->key;
+	msg.u.send_channel_to_app.session_handle = ua_sess->handle;
+
+	pthread_mutex_lock(socket->lock);
+	health_code_update();
+
+	ret = consumer_send_msg(socket, &msg);
+	if (ret < 0) {
+		goto error;
+	}
+
+	/*
+	 * The application socket is used by the consumer until it replies; no
+	 * other command may be sent to the application in the meantime.
+	 */
+	pthread_mutex_lock(&app->sock_lock);
+	ret = consumer_send_fds(socket, &app->sock, 1);
+	pthread_mutex_unlock(&app->sock_lock);
+	if (ret == -LTTCOMM_CONSUMERD_APP_EXITING) {
+		DBG3("UST app send channel to ust failed. Application is dead.");
+		ret = -ENOTCONN;
+		goto error;
+	} else if (ret < 0) {
+		goto error;
+	}
+
+	ret = consumer_socket_recv(socket, &channel_handle,
+			sizeof(channel_handle));
+	if (ret < 0) {
+		goto error;
+	}
+
+	obj->type = LTTNG_UST_ABI_OBJECT_TYPE_CHANNEL;
+	obj->handle = channel_handle;
+	obj->u.channel.type = ua_chan->attr.type;
+	obj->u.channel.wakeup_fd = -1;
+	ua_chan->obj = obj;
+	ua_chan->handle = channel_handle;
+	ua_chan->streams.count = ua_chan->expected_stream_count;
+	obj = NULL;
+
+error:
+	health_code_update();
+	pthread_mutex_unlock(socket->lock);
+end:
+	free(obj);
+	return ret;
+}
+
 /*
  * Send a destroy channel command to consumer using the given channel key.
  *
@@ -23,6 +23,10 @@ int ust_consumer_ask_channel(struct ust_app_session *ua_sess,
 int ust_consumer_get_channel(struct consumer_socket *socket,
 		struct ust_app_channel *ua_chan);
 
+int ust_consumer_send_channel_to_app(struct consumer_socket *socket,
+		struct ust_app *app, struct ust_app_session *ua_sess,
+		struct ust_app_channel *ua_chan);
+
 int ust_consumer_destroy_channel(struct consumer_socket *socket,
 		struct ust_app_channel *ua_chan);
 
@@ -865,7 +865,8 @@ end:
 
 /*
  * Initialize registry with default values and set the newly allocated session
- * pointer to sessionp.
+ * pointer to sessionp. The registry takes the given uuid, if any, or else a
+ * new one is generated.
  *
  * Return 0 on success and sessionp is set or else return -1 and sessionp is
  * kept untouched.
@@ -886,7 +887,8 @@ int ust_registry_session_init(struct ust_registry_session **sessionp,
 		uid_t euid,
 		gid_t egid,
 		uint64_t tracing_id,
-		uid_t tracing_uid)
+		uid_t tracing_uid,
+		const lttng_uuid uuid)
 {
 	int ret;
 	struct ust_registry_session *session;
@@ -962,10 +964,14 @@ int ust_registry_session_init(struct ust_registry_session **sessionp,
 		goto error;
 	}
 
-	ret = lttng_uuid_generate(session->uuid);
-	if (ret) {
-		ERR("Failed to generate UST uuid (errno = %d)", ret);
-		goto error;
+	if (uuid) {
+		lttng_uuid_copy(session->uuid, uuid);
+	} else {
+		ret = lttng_uuid_generate(session->uuid);
+		if (ret) {
+			ERR("Failed to generate UST uuid (errno = %d)", ret);
+			goto error;
+		}
 	}
 
 	session->tracing_id = tracing_id;
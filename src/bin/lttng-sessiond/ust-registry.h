@@ -287,7 +287,8 @@ int ust_registry_session_init(struct ust_registry_session **sessionp,
 		uid_t euid,
 		gid_t egid,
 		uint64_t tracing_id,
-		uid_t tracing_uid);
+		uid_t tracing_uid,
+		const lttng_uuid uuid);
 void ust_registry_session_destroy(struct ust_registry_session *session);
 
 int ust_registry_create_event(struct ust_registry_session *session,
@@ -355,7 +356,8 @@ int ust_registry_session_init(struct ust_registry_session **sessionp,
 		uid_t euid,
 		gid_t egid,
 		uint64_t tracing_id,
-		uid_t tracing_uid)
+		uid_t tracing_uid,
+		const lttng_uuid uuid)
 {
 	return 0;
 }
@@ -70,6 +70,8 @@ enum {
 	OPT_PATH,
 
 	OPT_CAPTURE,
+
+	OPT_KEY_CAPTURE,
 };
 
 static const struct argpar_opt_descr event_rule_opt_descrs[] = {
@@ -1466,6 +1468,152 @@ struct lttng_action *handle_action_rotate_session(int *argc,
 		"rotate");
 }
 
+static const struct argpar_opt_descr increment_counter_action_opt_descrs[] = {
+	{ OPT_KEY_CAPTURE, '\0', "key-capture", true },
+	ARGPAR_OPT_DESCR_SENTINEL
+};
+
+static
+struct lttng_action *handle_action_increment_counter(int *argc,
+		const char ***argv)
+{
+	struct lttng_action *action = NULL;
+	struct argpar_state *state = NULL;
+	struct argpar_item *item = NULL;
+	const char *map_name_arg = NULL, *key_arg = NULL;
+	char *key_capture_arg = NULL;
+	char *error = NULL;
+	enum lttng_action_status action_status;
+
+	state = argpar_state_create(*argc, *argv,
+			increment_counter_action_opt_descrs);
+	if (!state) {
+		ERR("Failed to allocate an argpar state.");
+		goto error;
+	}
+
+	while (true) {
+		enum argpar_state_parse_next_status status;
+		const struct argpar_item_non_opt *item_non_opt;
+
+		ARGPAR_ITEM_DESTROY_AND_RESET(item);
+		status = argpar_state_parse_next(state, &item, &error);
+		if (status == ARGPAR_STATE_PARSE_NEXT_STATUS_ERROR) {
+			ERR("%s", error);
+			goto error;
+		} else if (status == ARGPAR_STATE_PARSE_NEXT_STATUS_ERROR_UNKNOWN_OPT) {
+			/* Just stop parsing here. */
+			break;
+		} else if (status == ARGPAR_STATE_PARSE_NEXT_STATUS_END) {
+			break;
+		}
+
+		assert(status == ARGPAR_STATE_PARSE_NEXT_STATUS_OK);
+
+		if (item->type == ARGPAR_ITEM_TYPE_OPT) {
+			const struct argpar_item_opt *item_opt =
+					(const struct argpar_item_opt *) item;
+
+			switch (item_opt->descr->id) {
+			case OPT_KEY_CAPTURE:
+				if (!assign_string(&key_capture_arg,
+						item_opt->arg,
+						"--key-capture")) {
+					goto error;
+				}
+
+				break;
+			default:
+				abort();
+			}
+
+			continue;
+		}
+
+		assert(item->type == ARGPAR_ITEM_TYPE_NON_OPT);
+
+		item_non_opt = (const struct argpar_item_non_opt *) item;
+
+		switch (item_non_opt->non_opt_index) {
+		case 0:
+			map_name_arg = item_non_opt->arg;
+			break;
+		case 1:
+			key_arg = item_non_opt->arg;
+			break;
+		default:
+			ERR("Unexpected argument `%s`.", item_non_opt->arg);
+			goto error;
+		}
+	}
+
+	*argc -= argpar_state_get_ingested_orig_args(state);
+	*argv += argpar_state_get_ingested_orig_args(state);
+
+	if (!map_name_arg) {
+		ERR("Missing counter map name.");
+		goto error;
+	}
+
+	if (!key_arg) {
+		ERR("Missing counter map key.");
+		goto error;
+	}
+
+	action = lttng_action_increment_counter_create();
+	if (!action) {
+		ERR("Failed to allocate increment counter action.");
+		goto error;
+	}
+
+	action_status = lttng_action_increment_counter_set_map_name(
+			action, map_name_arg);
+	if (action_status != LTTNG_ACTION_STATUS_OK) {
+		ERR("Failed to set action increment counter's map name to '%s'.",
+				map_name_arg);
+		goto error;
+	}
+
+	action_status = lttng_action_increment_counter_set_key(action, key_arg);
+	if (action_status != LTTNG_ACTION_STATUS_OK) {
+		ERR("Failed to set action increment counter's key to '%s'.",
+				key_arg);
+		goto error;
+	}
+
+	if (key_capture_arg) {
+		unsigned long long capture_index;
+
+		if (utils_parse_unsigned_long_long(key_capture_arg,
+				&capture_index) != 0 ||
+				capture_index > UINT_MAX) {
+			ERR("Failed to parse `%s` as a capture index.",
+					key_capture_arg);
+			goto error;
+		}
+
+		action_status = lttng_action_increment_counter_set_key_capture_index(
+				action, (unsigned int) capture_index);
+		if (action_status != LTTNG_ACTION_STATUS_OK) {
+			ERR("Failed to set action increment counter's key capture index to %llu.",
+					capture_index);
+			goto error;
+		}
+	}
+
+	goto end;
+
+error:
+	lttng_action_destroy(action);
+	action = NULL;
+end:
+	argpar_item_destroy(item);
+	free(key_capture_arg);
+	free(error);
+	argpar_state_destroy(state);
+	return action;
+}
+
 static const struct argpar_opt_descr snapshot_action_opt_descrs[] = {
 	{ OPT_NAME, 'n', "name", true },
 	{ OPT_MAX_SIZE, 'm', "max-size", true },
@@ -1775,6 +1923,7 @@ struct action_descr action_descrs[] = {
 	{ "stop-session", handle_action_stop_session },
 	{ "rotate-session", handle_action_rotate_session },
 	{ "snapshot-session", handle_action_snapshot_session },
+	{ "increment-counter", handle_action_increment_counter },
 };
 
 static
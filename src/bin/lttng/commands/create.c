@@ -37,6 +37,7 @@ static char *opt_url;
 static char *opt_ctrl_url;
 static char *opt_data_url;
 static char *opt_shm_path;
+static char *opt_local_copy_path;
 static int opt_no_consumer;
 static int opt_no_output;
 static int opt_snapshot;
@@ -75,6 +76,7 @@ static struct poptOption long_options[] = {
 	{"snapshot",        0, POPT_ARG_VAL, &opt_snapshot, 1, 0, 0},
 	{"live",            0, POPT_ARG_INT | POPT_ARGFLAG_OPTIONAL, 0, OPT_LIVE_TIMER, 0, 0},
 	{"shm-path",        0, POPT_ARG_STRING, &opt_shm_path, 0, 0, 0},
+	{"local-copy",      0, POPT_ARG_STRING, &opt_local_copy_path, 0, 0, 0},
 	{0, 0, 0, 0, 0, 0, 0}
 };
 
@@ -217,14 +219,23 @@ struct lttng_session_descriptor *create_session_descriptor(void)
 		}
 	} else if (opt_live_timer) {
 		/* Live session. */
-		if (output_type != OUTPUT_UNSPECIFIED &&
-				output_type != OUTPUT_NETWORK) {
+		switch (output_type) {
+		case OUTPUT_UNSPECIFIED:
+		case OUTPUT_NETWORK:
+			descriptor = lttng_session_descriptor_live_network_create(
+					opt_session_name, uri_str1, uri_str2,
+					opt_live_timer);
+			break;
+		case OUTPUT_LOCAL:
+			/* Served by the consumer daemons' live endpoints. */
+			descriptor = lttng_session_descriptor_live_local_create(
+					opt_session_name, local_output_path,
+					opt_live_timer);
+			break;
+		default:
 			ERR("Unsupported output type specified for live session.");
 			goto end;
 		}
-		descriptor = lttng_session_descriptor_live_network_create(
-				opt_session_name, uri_str1, uri_str2,
-				opt_live_timer);
 	} else {
 		/* Regular session. */
 		switch (output_type) {
@@ -255,7 +266,8 @@ struct lttng_session_descriptor *create_session_descriptor(void)
 		 * is created using default URLs.
 		 */
 		if (!opt_url && !opt_ctrl_url && !opt_data_url &&
-				opt_live_timer && !check_relayd()) {
+				!opt_output_path && opt_live_timer &&
+				!check_relayd()) {
 			int ret;
 			const char *pathname = opt_relayd_path ? :
 					INSTALL_BIN_PATH "/lttng-relayd";
@@ -282,6 +294,7 @@ static int create_session(void)
 {
 	int ret, i;
 	char shm_path[LTTNG_PATH_MAX] = {};
+	char *local_copy_path = NULL;
 	struct lttng_session_descriptor *session_descriptor = NULL;
 	enum lttng_session_descriptor_status descriptor_status;
 	enum lttng_error_code ret_code;
@@ -420,6 +433,25 @@ static int create_session(void)
 		}
 	}
 
+	if (opt_local_copy_path) {
+		local_copy_path = utils_expand_path(opt_local_copy_path);
+		if (!local_copy_path) {
+			ERR("Failed to expand local copy path.");
+			lttng_destroy_session(created_session_name);
+			ret = CMD_ERROR;
+			goto error;
+		}
+		ret = lttng_set_session_local_copy_path(created_session_name,
+				local_copy_path);
+		if (ret < 0) {
+			ERR("Failed to set the local copy path: %s",
+					lttng_strerror(ret));
+			lttng_destroy_session(created_session_name);
+			ret = CMD_ERROR;
+			goto error;
+		}
+	}
+
 	if (opt_snapshot) {
 		MSG("Snapshot session %s created.", created_session_name);
 	} else if (opt_live_timer) {
@@ -471,6 +503,10 @@ static int create_session(void)
 	if (opt_shm_path) {
 		MSG("Shared memory path set to %s", shm_path);
 	}
+	if (local_copy_path) {
+		MSG("A local copy of the traces will be output to %s",
+				local_copy_path);
+	}
 
 	/* Mi output */
 	if (lttng_opt_mi) {
@@ -492,6 +528,7 @@ static int create_session(void)
 error:
 	lttng_session_descriptor_destroy(session_descriptor);
 	free(sessions);
+	free(local_copy_path);
 	return ret;
 }
 
@@ -640,6 +677,11 @@ int validate_url_option_combination(void)
 		ret = -1;
 	}
 
+	if (opt_local_copy_path && !opt_url && !opt_ctrl_url) {
+		ERR("The --local-copy option requires a network output.");
+		ret = -1;
+	}
+
 	return ret;
 }
 
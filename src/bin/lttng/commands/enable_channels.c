@@ -42,6 +42,13 @@ static struct {
 	bool set;
 	int64_t value;
 } opt_blocking_timeout;
+static struct {
+	bool set;
+	uint64_t size;
+} opt_writeback_window;
+static int opt_direct_io;
+/* Geometry attributes not given on the command line. */
+static unsigned int advisable_attrs;
 
 static struct mi_writer *writer;
 
@@ -65,6 +72,7 @@ enum {
 	OPT_TRACEFILE_SIZE,
 	OPT_TRACEFILE_COUNT,
 	OPT_BLOCKING_TIMEOUT,
+	OPT_WRITEBACK_WINDOW,
 };
 
 static struct lttng_handle *handle;
@@ -93,6 +101,8 @@ static struct poptOption long_options[] = {
 	{"tracefile-size", 'C',   POPT_ARG_INT, 0, OPT_TRACEFILE_SIZE, 0, 0},
 	{"tracefile-count", 'W',   POPT_ARG_INT, 0, OPT_TRACEFILE_COUNT, 0, 0},
 	{"blocking-timeout",     0,   POPT_ARG_INT, 0, OPT_BLOCKING_TIMEOUT, 0, 0},
+	{"writeback-window", 0,   POPT_ARG_STRING, 0, OPT_WRITEBACK_WINDOW, 0, 0},
+	{"direct-io",      0,   POPT_ARG_VAL, &opt_direct_io, 1, 0, 0},
 	{0, 0, 0, 0, 0, 0, 0}
 };
 
@@ -114,12 +124,15 @@ static void set_default_attr(struct lttng_domain *dom)
 	}
 	if (chan_opts.attr.subbuf_size == -1) {
 		chan_opts.attr.subbuf_size = default_attr.subbuf_size;
+		advisable_attrs |= LTTNG_CHANNEL_ADVISABLE_ATTR_SUBBUF_SIZE;
 	}
 	if (chan_opts.attr.num_subbuf == -1) {
 		chan_opts.attr.num_subbuf = default_attr.num_subbuf;
+		advisable_attrs |= LTTNG_CHANNEL_ADVISABLE_ATTR_NUM_SUBBUF;
 	}
 	if (chan_opts.attr.switch_timer_interval == -1) {
 		chan_opts.attr.switch_timer_interval = default_attr.switch_timer_interval;
+		advisable_attrs |= LTTNG_CHANNEL_ADVISABLE_ATTR_SWITCH_TIMER;
 	}
 	if (chan_opts.attr.read_timer_interval == -1) {
 		chan_opts.attr.read_timer_interval = default_attr.read_timer_interval;
@@ -276,6 +289,30 @@ static int enable_channel(char *session_name)
 				goto error;
 			}
 		}
+		if (opt_writeback_window.set) {
+			ret = lttng_channel_set_writeback_window_size(channel,
+					opt_writeback_window.size);
+			if (ret) {
+				ERR("Failed to set the channel's writeback window size");
+				error = 1;
+				goto error;
+			}
+		}
+		if (opt_direct_io) {
+			ret = lttng_channel_set_direct_io(channel, 1);
+			if (ret) {
+				ERR("Failed to enable direct I/O for the channel");
+				error = 1;
+				goto error;
+			}
+		}
+		ret = lttng_channel_set_advisable_attributes(channel,
+				advisable_attrs);
+		if (ret) {
+			ERR("Failed to set the channel's advisable attributes");
+			error = 1;
+			goto error;
+		}
 
 		DBG("Enabling channel %s", channel_name);
 
@@ -600,6 +637,17 @@ int cmd_enable_channels(int argc, const char **argv)
 						" (non-blocking)" : "");
 			break;
 		}
+		case OPT_WRITEBACK_WINDOW:
+			opt_arg = poptGetOptArg(pc);
+			if (utils_parse_size_suffix(opt_arg, &opt_writeback_window.size) < 0) {
+				ERR("Wrong value in --writeback-window parameter: %s", opt_arg);
+				ret = CMD_ERROR;
+				goto end;
+			}
+			opt_writeback_window.set = true;
+			DBG("Channel writeback window size set to %" PRIu64,
+					opt_writeback_window.size);
+			break;
 		case OPT_USERSPACE:
 			opt_userspace = 1;
 			break;
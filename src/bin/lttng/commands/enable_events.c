@@ -19,6 +19,7 @@
 #include <common/sessiond-comm/sessiond-comm.h>
 #include <common/compat/string.h>
 #include <common/compat/getenv.h>
+#include <common/dynamic-array.h>
 #include <common/string-utils/string-utils.h>
 #include <common/utils.h>
 
@@ -406,13 +407,18 @@ static int enable_events(char *session_name)
 {
 	int ret = CMD_SUCCESS, command_ret = CMD_SUCCESS;
 	int error_holder = CMD_SUCCESS, warn = 0, error = 0, success = 1;
-	char *event_name, *channel_name = NULL;
+	char *event_name, *channel_name = NULL, *event_list = NULL;
 	struct lttng_event *ev;
 	struct lttng_domain dom;
 	char **exclusion_list = NULL;
 	struct lttng_userspace_probe_location *uprobe_loc = NULL;
+	struct lttng_dynamic_array bulk_events;
+	int *bulk_ret_codes = NULL;
+	size_t event_index = 0;
+	bool bulk_enable;
 
 	memset(&dom, 0, sizeof(dom));
+	lttng_dynamic_array_init(&bulk_events, sizeof(struct lttng_event), NULL);
 
 	ev = lttng_event_create();
 	if (!ev) {
@@ -783,8 +789,28 @@ static int enable_events(char *session_name)
 		goto end;
 	}
 
+	/*
+	 * Without filter nor exclusions, the events are enabled with a single
+	 * call: the event list is walked a first time to gather the events and
+	 * a second time to report the outcome of each of them.
+	 */
+	bulk_enable = !opt_filter &&
+			!opt_exclude &&
+			opt_event_type != LTTNG_EVENT_USERSPACE_PROBE;
+
+walk_event_list:
+	/* strtok() modifies the list it splits. */
+	free(event_list);
+	event_list = strdup(opt_event_list);
+	if (!event_list) {
+		PERROR("Failed to copy event list");
+		ret = CMD_ERROR;
+		goto error;
+	}
+	event_index = 0;
+
 	/* Strip event list */
-	event_name = strtok(opt_event_list, ",");
+	event_name = strtok(event_list, ",");
 	while (event_name != NULL) {
 		/* Copy name and type of the event */
 		strncpy(ev->name, event_name, LTTNG_SYMBOL_NAME_LEN);
@@ -978,11 +1004,24 @@ static int enable_events(char *session_name)
 		if (!opt_filter) {
 			char *exclusion_string;
 
-			command_ret = lttng_enable_event_with_exclusions(handle,
-					ev, channel_name,
-					NULL,
-					exclusion_list ? strutils_array_of_strings_len(exclusion_list) : 0,
-					exclusion_list);
+			if (bulk_ret_codes) {
+				command_ret = bulk_ret_codes[event_index];
+			} else if (bulk_enable) {
+				/* Enabled along with the rest of the list. */
+				ret = lttng_dynamic_array_add_element(
+						&bulk_events, ev);
+				if (ret) {
+					ret = CMD_ERROR;
+					goto error;
+				}
+				goto next_event;
+			} else {
+				command_ret = lttng_enable_event_with_exclusions(handle,
+						ev, channel_name,
+						NULL,
+						exclusion_list ? strutils_array_of_strings_len(exclusion_list) : 0,
+						exclusion_list);
+			}
 			exclusion_string = print_exclusions(exclusion_list);
 			if (!exclusion_string) {
 				PERROR("Cannot allocate exclusion_string");
@@ -1152,12 +1191,40 @@ static int enable_events(char *session_name)
 			}
 		}
 
+next_event:
 		/* Next event */
+		event_index++;
 		event_name = strtok(NULL, ",");
 		/* Reset warn, error and success */
 		success = 1;
 	}
 
+	if (bulk_enable && !bulk_ret_codes) {
+		const size_t event_count =
+				lttng_dynamic_array_get_count(&bulk_events);
+		size_t i;
+
+		bulk_ret_codes = zmalloc(sizeof(*bulk_ret_codes) * event_count);
+		if (!bulk_ret_codes) {
+			PERROR("Failed to allocate event return codes");
+			ret = CMD_ERROR;
+			goto error;
+		}
+
+		command_ret = lttng_enable_events(handle,
+				(struct lttng_event *) bulk_events.buffer.data,
+				event_count, channel_name, bulk_ret_codes);
+		if (command_ret < 0) {
+			/* The error applies to every event of the list. */
+			for (i = 0; i < event_count; i++) {
+				bulk_ret_codes[i] = command_ret;
+			}
+		}
+
+		/* Report the outcome of each event. */
+		goto walk_event_list;
+	}
+
 end:
 	/* Close Mi */
 	if (lttng_opt_mi) {
@@ -1178,6 +1245,9 @@ error:
 	lttng_destroy_handle(handle);
 	strutils_free_null_terminated_array_of_strings(exclusion_list);
 	lttng_userspace_probe_location_destroy(uprobe_loc);
+	lttng_dynamic_array_reset(&bulk_events);
+	free(bulk_ret_codes);
+	free(event_list);
 
 	/* Overwrite ret with error_holder if there was an actual error with
 	 * enabling an event.
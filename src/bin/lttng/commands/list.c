@@ -31,6 +31,7 @@ static char *opt_channel;
 static int opt_domain;
 static int opt_fields;
 static int opt_syscall;
+static int opt_advice;
 
 const char *indent4 = "    ";
 const char *indent6 = "      ";
@@ -66,6 +67,7 @@ static struct poptOption long_options[] = {
 	{"domain",	'd', POPT_ARG_VAL, &opt_domain, 1, 0, 0},
 	{"fields",	'f', POPT_ARG_VAL, &opt_fields, 1, 0, 0},
 	{"syscall",	'S', POPT_ARG_VAL, &opt_syscall, 1, 0, 0},
+	{"advice",	0, POPT_ARG_VAL, &opt_advice, 1, 0, 0},
 	{"list-options", 0, POPT_ARG_NONE, NULL, OPT_LIST_OPTIONS, NULL, NULL},
 	{0, 0, 0, 0, 0, 0, 0}
 };
@@ -1367,6 +1369,66 @@ skip_stats_printing:
 	return;
 }
 
+/*
+ * Get the geometry advised for a channel when --advice is given.
+ *
+ * Return 1 if the advice is set, 0 if none applies to the channel, else a
+ * negative LTTng error code.
+ */
+static int get_channel_advice(const char *channel_name,
+		struct lttng_channel_advice *advice)
+{
+	int ret;
+
+	if (!opt_advice || (handle->domain.type != LTTNG_DOMAIN_KERNEL &&
+			handle->domain.type != LTTNG_DOMAIN_UST)) {
+		ret = 0;
+		goto end;
+	}
+
+	ret = lttng_channel_get_advice(handle, channel_name, advice);
+	if (ret < 0) {
+		ERR("Failed to get the advice of channel %s: %s",
+				channel_name, lttng_strerror(ret));
+		goto end;
+	}
+	ret = 1;
+end:
+	return ret;
+}
+
+/*
+ * Pretty print the geometry advised for a channel
+ */
+static int print_channel_advice(const char *channel_name)
+{
+	int ret;
+	struct lttng_channel_advice advice;
+
+	ret = get_channel_advice(channel_name, &advice);
+	if (ret <= 0) {
+		goto end;
+	}
+
+	MSG("\n%sAdvice:", indent4);
+	if (advice.observed_period == 0) {
+		MSG("%sThroughput:       not sampled", indent6);
+	} else {
+		MSG("%sThroughput:       %" PRIu64 " bytes/s (peak: %" PRIu64 " bytes/s, over %" PRIu64 " %s)",
+				indent6, advice.rate, advice.peak_rate,
+				advice.observed_period, USEC_UNIT);
+		MSG("%sPeak usage:       %" PRIu64 " bytes", indent6,
+				advice.peak_usage);
+	}
+	MSG("%sSub-buffer size:  %" PRIu64 " bytes", indent6,
+			advice.subbuf_size);
+	MSG("%sSub-buffer count: %" PRIu64, indent6, advice.num_subbuf);
+	print_timer("Switch timer", 5, advice.switch_timer_interval);
+	ret = 0;
+end:
+	return ret;
+}
+
 /*
  * Machine interface
  * Print a list of channel
@@ -1399,6 +1461,20 @@ static int mi_list_channels(struct lttng_channel *channels, int count,
 			goto error;
 		}
 
+		if (opt_advice) {
+			struct lttng_channel_advice advice;
+
+			ret = get_channel_advice(channels[i].name, &advice);
+			if (ret < 0) {
+				goto error;
+			} else if (ret > 0) {
+				ret = mi_lttng_channel_advice(writer, &advice);
+				if (ret) {
+					goto error;
+				}
+			}
+		}
+
 		/* Listing events per channel */
 		ret = list_events(channels[i].name);
 		if (ret) {
@@ -1484,6 +1560,12 @@ static int list_channels(const char *channel_name)
 			}
 			print_channel(&channels[i]);
 
+			ret = print_channel_advice(channels[i].name);
+			if (ret) {
+				ret = CMD_ERROR;
+				goto error;
+			}
+
 			/* Listing events per channel */
 			ret = list_events(channels[i].name);
 			if (ret) {
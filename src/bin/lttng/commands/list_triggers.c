@@ -537,6 +537,28 @@ void print_one_action(const struct lttng_action *action)
 		MSG("");
 		break;
 	}
+	case LTTNG_ACTION_TYPE_INCREMENT_COUNTER:
+	{
+		const char *key;
+		unsigned int capture_index;
+
+		action_status = lttng_action_increment_counter_get_map_name(
+				action, &value);
+		assert(action_status == LTTNG_ACTION_STATUS_OK);
+		action_status = lttng_action_increment_counter_get_key(
+				action, &key);
+		assert(action_status == LTTNG_ACTION_STATUS_OK);
+		_MSG("increment counter map `%s`, key `%s`", value, key);
+
+		action_status = lttng_action_increment_counter_get_key_capture_index(
+				action, &capture_index);
+		if (action_status == LTTNG_ACTION_STATUS_OK) {
+			_MSG(", key capture index %u", capture_index);
+		}
+
+		MSG("");
+		break;
+	}
 
 	default:
 		abort();
@@ -19,6 +19,7 @@
 
 #include <common/utils.h>
 #include <common/mi-lttng.h>
+#include <common/string-utils/string-utils.h>
 #include <lttng/lttng.h>
 
 #include "../command.h"
@@ -27,8 +28,10 @@ static const char *opt_session_name;
 static const char *opt_output_name;
 static const char *opt_data_url;
 static const char *opt_ctrl_url;
+static const char *opt_channels;
 static const char *current_session_name;
 static uint64_t opt_max_size;
+static uint64_t opt_window;
 
 /* Stub for the cmd struct actions. */
 static int cmd_add_output(int argc, const char **argv);
@@ -49,6 +52,7 @@ enum {
 	OPT_LIST_OPTIONS,
 	OPT_MAX_SIZE,
 	OPT_LIST_COMMANDS,
+	OPT_WINDOW,
 };
 
 static struct mi_writer *writer;
@@ -61,6 +65,8 @@ static struct poptOption snapshot_opts[] = {
 	{"data-url",     'D', POPT_ARG_STRING, &opt_data_url, 0, 0, 0},
 	{"name",         'n', POPT_ARG_STRING, &opt_output_name, 0, 0, 0},
 	{"max-size",     'm', POPT_ARG_STRING, 0, OPT_MAX_SIZE, 0, 0},
+	{"channel",      'c', POPT_ARG_STRING, &opt_channels, 0, 0, 0},
+	{"window",         0, POPT_ARG_STRING, 0, OPT_WINDOW, 0, 0},
 	{"list-options",   0, POPT_ARG_NONE, NULL, OPT_LIST_OPTIONS, NULL, NULL},
 	{"list-commands",  0, POPT_ARG_NONE, NULL, OPT_LIST_COMMANDS},
 	{0, 0, 0, 0, 0, 0, 0}
@@ -402,6 +408,8 @@ static int record(const char *url)
 {
 	int ret;
 	struct lttng_snapshot_output *output = NULL;
+	char **channel_names = NULL;
+	size_t channel_count = 0;
 
 	output = create_output_from_args(url);
 	if (!output) {
@@ -409,7 +417,19 @@ static int record(const char *url)
 		goto error;
 	}
 
-	ret = lttng_snapshot_record(current_session_name, output, 0);
+	if (opt_channels) {
+		channel_names = strutils_split(opt_channels, ',', false);
+		if (!channel_names) {
+			ERR("Failed to parse channel names \"%s\"", opt_channels);
+			ret = CMD_FATAL;
+			goto error;
+		}
+		channel_count = strutils_array_of_strings_len(channel_names);
+	}
+
+	ret = lttng_snapshot_record_scoped(current_session_name, output,
+			(const char * const *) channel_names, channel_count,
+			opt_window, 0);
 	if (ret < 0) {
 		if (ret == -LTTNG_ERR_MAX_SIZE_INVALID) {
 			ERR("Invalid snapshot size. Cannot fit at least one packet per stream.");
@@ -435,6 +455,7 @@ static int record(const char *url)
 	}
 
 error:
+	strutils_free_null_terminated_array_of_strings(channel_names);
 	lttng_snapshot_output_destroy(output);
 	return ret;
 }
@@ -636,6 +657,21 @@ int cmd_snapshot(int argc, const char **argv)
 
 			break;
 		}
+		case OPT_WINDOW:
+		{
+			uint64_t val;
+			const char *opt = poptGetOptArg(pc);
+
+			if (utils_parse_time_suffix(opt, &val) < 0) {
+				ERR("Unable to handle window value %s", opt);
+				cmd_ret = CMD_ERROR;
+				goto end;
+			}
+
+			opt_window = val;
+
+			break;
+		}
 		default:
 			cmd_ret = CMD_UNDEFINED;
 			goto end;
@@ -9,6 +9,7 @@
 #include <common/error.h>
 #include <lttng/action/action-internal.h>
 #include <lttng/action/group-internal.h>
+#include <lttng/action/increment-counter-internal.h>
 #include <lttng/action/notify-internal.h>
 #include <lttng/action/rotate-session-internal.h>
 #include <lttng/action/snapshot-session-internal.h>
@@ -33,6 +34,8 @@ const char *lttng_action_type_string(enum lttng_action_type action_type)
 		return "START_SESSION";
 	case LTTNG_ACTION_TYPE_STOP_SESSION:
 		return "STOP_SESSION";
+	case LTTNG_ACTION_TYPE_INCREMENT_COUNTER:
+		return "INCREMENT_COUNTER";
 	default:
 		return "???";
 	}
@@ -185,6 +188,10 @@ ssize_t lttng_action_create_from_payload(struct lttng_payload_view *view,
 	case LTTNG_ACTION_TYPE_GROUP:
 		create_from_payload_cb = lttng_action_group_create_from_payload;
 		break;
+	case LTTNG_ACTION_TYPE_INCREMENT_COUNTER:
+		create_from_payload_cb =
+				lttng_action_increment_counter_create_from_payload;
+		break;
 	default:
 		ERR("Failed to create action from payload, unhandled action type: action-type=%u (%s)",
 				action_comm->action_type,
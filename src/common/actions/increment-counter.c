@@ -0,0 +1,539 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include <assert.h>
+#include <common/error.h>
+#include <common/macros.h>
+#include <common/optional.h>
+#include <lttng/action/action-internal.h>
+#include <lttng/action/group.h>
+#include <lttng/action/increment-counter-internal.h>
+#include <lttng/action/increment-counter.h>
+#include <lttng/condition/condition.h>
+#include <lttng/condition/on-event.h>
+#include <lttng/constant.h>
+
+#define IS_INCREMENT_COUNTER_ACTION(action) \
+	(lttng_action_get_type(action) == LTTNG_ACTION_TYPE_INCREMENT_COUNTER)
+
+struct lttng_action_increment_counter {
+	struct lttng_action parent;
+
+	/* Owned by this. */
+	char *map_name;
+	/* Owned by this. */
+	char *key;
+	/* Capture descriptor completing the key of each firing. */
+	LTTNG_OPTIONAL(uint32_t) key_capture_index;
+};
+
+struct lttng_action_increment_counter_comm {
+	/* Includes the trailing \0. */
+	uint32_t map_name_len;
+	/* Includes the trailing \0. */
+	uint32_t key_len;
+	uint8_t key_capture_index_is_set;
+	uint32_t key_capture_index;
+
+	/*
+	 * Variable data:
+	 *
+	 *  - map name (null terminated)
+	 *  - key (null terminated)
+	 */
+	char data[];
+} LTTNG_PACKED;
+
+static struct lttng_action_increment_counter *
+action_increment_counter_from_action(struct lttng_action *action)
+{
+	assert(action);
+
+	return container_of(action, struct lttng_action_increment_counter,
+			parent);
+}
+
+static const struct lttng_action_increment_counter *
+action_increment_counter_from_action_const(const struct lttng_action *action)
+{
+	assert(action);
+
+	return container_of(action, struct lttng_action_increment_counter,
+			parent);
+}
+
+static bool lttng_action_increment_counter_validate(struct lttng_action *action)
+{
+	bool valid;
+	struct lttng_action_increment_counter *action_increment_counter;
+
+	if (!action) {
+		valid = false;
+		goto end;
+	}
+
+	action_increment_counter = action_increment_counter_from_action(action);
+
+	/* A non-empty map name and key are mandatory. */
+	if (!action_increment_counter->map_name ||
+			strlen(action_increment_counter->map_name) == 0) {
+		valid = false;
+		goto end;
+	}
+
+	if (!action_increment_counter->key ||
+			strlen(action_increment_counter->key) == 0) {
+		valid = false;
+		goto end;
+	}
+
+	valid = true;
+end:
+	return valid;
+}
+
+static bool lttng_action_increment_counter_is_equal(
+		const struct lttng_action *_a, const struct lttng_action *_b)
+{
+	bool is_equal = false;
+	const struct lttng_action_increment_counter *a, *b;
+
+	a = action_increment_counter_from_action_const(_a);
+	b = action_increment_counter_from_action_const(_b);
+
+	/* Action is not valid if this is not true. */
+	assert(a->map_name);
+	assert(b->map_name);
+	assert(a->key);
+	assert(b->key);
+	if (strcmp(a->map_name, b->map_name)) {
+		goto end;
+	}
+
+	if (strcmp(a->key, b->key)) {
+		goto end;
+	}
+
+	if (a->key_capture_index.is_set != b->key_capture_index.is_set) {
+		goto end;
+	}
+
+	if (a->key_capture_index.is_set &&
+			a->key_capture_index.value !=
+					b->key_capture_index.value) {
+		goto end;
+	}
+
+	is_equal = true;
+end:
+	return is_equal;
+}
+
+static int lttng_action_increment_counter_serialize(
+		struct lttng_action *action, struct lttng_payload *payload)
+{
+	struct lttng_action_increment_counter *action_increment_counter;
+	struct lttng_action_increment_counter_comm comm;
+	size_t map_name_len, key_len;
+	int ret;
+
+	assert(action);
+	assert(payload);
+
+	action_increment_counter = action_increment_counter_from_action(action);
+
+	assert(action_increment_counter->map_name);
+	assert(action_increment_counter->key);
+
+	DBG("Serializing increment counter action: map-name: %s, key: %s",
+			action_increment_counter->map_name,
+			action_increment_counter->key);
+
+	map_name_len = strlen(action_increment_counter->map_name) + 1;
+	key_len = strlen(action_increment_counter->key) + 1;
+	comm.map_name_len = map_name_len;
+	comm.key_len = key_len;
+	comm.key_capture_index_is_set =
+			action_increment_counter->key_capture_index.is_set;
+	comm.key_capture_index =
+			action_increment_counter->key_capture_index.value;
+
+	ret = lttng_dynamic_buffer_append(&payload->buffer, &comm, sizeof(comm));
+	if (ret) {
+		ret = -1;
+		goto end;
+	}
+
+	ret = lttng_dynamic_buffer_append(&payload->buffer,
+			action_increment_counter->map_name, map_name_len);
+	if (ret) {
+		ret = -1;
+		goto end;
+	}
+
+	ret = lttng_dynamic_buffer_append(&payload->buffer,
+			action_increment_counter->key, key_len);
+	if (ret) {
+		ret = -1;
+		goto end;
+	}
+
+	ret = 0;
+end:
+	return ret;
+}
+
+static void lttng_action_increment_counter_destroy(struct lttng_action *action)
+{
+	struct lttng_action_increment_counter *action_increment_counter;
+
+	if (!action) {
+		goto end;
+	}
+
+	action_increment_counter = action_increment_counter_from_action(action);
+
+	free(action_increment_counter->map_name);
+	free(action_increment_counter->key);
+	free(action_increment_counter);
+
+end:
+	return;
+}
+
+ssize_t lttng_action_increment_counter_create_from_payload(
+		struct lttng_payload_view *view,
+		struct lttng_action **p_action)
+{
+	ssize_t consumed_len;
+	const struct lttng_action_increment_counter_comm *comm;
+	const char *map_name, *key;
+	struct lttng_action *action;
+	enum lttng_action_status status;
+
+	action = lttng_action_increment_counter_create();
+	if (!action) {
+		consumed_len = -1;
+		goto end;
+	}
+
+	if (view->buffer.size < sizeof(*comm)) {
+		consumed_len = -1;
+		goto end;
+	}
+
+	comm = (typeof(comm)) view->buffer.data;
+	map_name = (const char *) &comm->data;
+
+	if (!lttng_buffer_view_contains_string(&view->buffer, map_name,
+			    comm->map_name_len)) {
+		consumed_len = -1;
+		goto end;
+	}
+
+	key = map_name + comm->map_name_len;
+	if (!lttng_buffer_view_contains_string(&view->buffer, key,
+			    comm->key_len)) {
+		consumed_len = -1;
+		goto end;
+	}
+
+	status = lttng_action_increment_counter_set_map_name(action, map_name);
+	if (status != LTTNG_ACTION_STATUS_OK) {
+		consumed_len = -1;
+		goto end;
+	}
+
+	status = lttng_action_increment_counter_set_key(action, key);
+	if (status != LTTNG_ACTION_STATUS_OK) {
+		consumed_len = -1;
+		goto end;
+	}
+
+	if (comm->key_capture_index_is_set) {
+		status = lttng_action_increment_counter_set_key_capture_index(
+				action, comm->key_capture_index);
+		if (status != LTTNG_ACTION_STATUS_OK) {
+			consumed_len = -1;
+			goto end;
+		}
+	}
+
+	consumed_len = sizeof(*comm) + comm->map_name_len + comm->key_len;
+	*p_action = action;
+	action = NULL;
+
+end:
+	lttng_action_increment_counter_destroy(action);
+
+	return consumed_len;
+}
+
+struct lttng_action *lttng_action_increment_counter_create(void)
+{
+	struct lttng_action *action;
+
+	action = zmalloc(sizeof(struct lttng_action_increment_counter));
+	if (!action) {
+		goto end;
+	}
+
+	lttng_action_init(action, LTTNG_ACTION_TYPE_INCREMENT_COUNTER,
+			lttng_action_increment_counter_validate,
+			lttng_action_increment_counter_serialize,
+			lttng_action_increment_counter_is_equal,
+			lttng_action_increment_counter_destroy);
+
+end:
+	return action;
+}
+
+static enum lttng_action_status set_string(char **dst, const char *value)
+{
+	char *copy;
+
+	copy = strdup(value);
+	if (!copy) {
+		return LTTNG_ACTION_STATUS_ERROR;
+	}
+
+	free(*dst);
+	*dst = copy;
+	return LTTNG_ACTION_STATUS_OK;
+}
+
+enum lttng_action_status lttng_action_increment_counter_set_map_name(
+		struct lttng_action *action, const char *map_name)
+{
+	enum lttng_action_status status;
+
+	/* Map names are sent to the session daemon in a fixed-size field. */
+	if (!action || !IS_INCREMENT_COUNTER_ACTION(action) || !map_name ||
+			strlen(map_name) == 0 ||
+			strlen(map_name) >= LTTNG_SYMBOL_NAME_LEN) {
+		status = LTTNG_ACTION_STATUS_INVALID;
+		goto end;
+	}
+
+	status = set_string(
+			&action_increment_counter_from_action(action)->map_name,
+			map_name);
+end:
+	return status;
+}
+
+enum lttng_action_status lttng_action_increment_counter_get_map_name(
+		const struct lttng_action *action, const char **map_name)
+{
+	enum lttng_action_status status;
+
+	if (!action || !IS_INCREMENT_COUNTER_ACTION(action) || !map_name) {
+		status = LTTNG_ACTION_STATUS_INVALID;
+		goto end;
+	}
+
+	*map_name = action_increment_counter_from_action_const(action)->map_name;
+	status = *map_name ? LTTNG_ACTION_STATUS_OK : LTTNG_ACTION_STATUS_UNSET;
+end:
+	return status;
+}
+
+enum lttng_action_status lttng_action_increment_counter_set_key(
+		struct lttng_action *action, const char *key)
+{
+	enum lttng_action_status status;
+
+	if (!action || !IS_INCREMENT_COUNTER_ACTION(action) || !key ||
+			strlen(key) == 0) {
+		status = LTTNG_ACTION_STATUS_INVALID;
+		goto end;
+	}
+
+	status = set_string(&action_increment_counter_from_action(action)->key,
+			key);
+end:
+	return status;
+}
+
+enum lttng_action_status lttng_action_increment_counter_get_key(
+		const struct lttng_action *action, const char **key)
+{
+	enum lttng_action_status status;
+
+	if (!action || !IS_INCREMENT_COUNTER_ACTION(action) || !key) {
+		status = LTTNG_ACTION_STATUS_INVALID;
+		goto end;
+	}
+
+	*key = action_increment_counter_from_action_const(action)->key;
+	status = *key ? LTTNG_ACTION_STATUS_OK : LTTNG_ACTION_STATUS_UNSET;
+end:
+	return status;
+}
+
+enum lttng_action_status lttng_action_increment_counter_set_key_capture_index(
+		struct lttng_action *action, unsigned int capture_index)
+{
+	enum lttng_action_status status;
+
+	if (!action || !IS_INCREMENT_COUNTER_ACTION(action)) {
+		status = LTTNG_ACTION_STATUS_INVALID;
+		goto end;
+	}
+
+	LTTNG_OPTIONAL_SET(&action_increment_counter_from_action(action)->key_capture_index,
+			(uint32_t) capture_index);
+	status = LTTNG_ACTION_STATUS_OK;
+end:
+	return status;
+}
+
+enum lttng_action_status lttng_action_increment_counter_get_key_capture_index(
+		const struct lttng_action *action, unsigned int *capture_index)
+{
+	enum lttng_action_status status;
+	const struct lttng_action_increment_counter *action_increment_counter;
+
+	if (!action || !IS_INCREMENT_COUNTER_ACTION(action) || !capture_index) {
+		status = LTTNG_ACTION_STATUS_INVALID;
+		goto end;
+	}
+
+	action_increment_counter =
+			action_increment_counter_from_action_const(action);
+	if (!action_increment_counter->key_capture_index.is_set) {
+		status = LTTNG_ACTION_STATUS_UNSET;
+		goto end;
+	}
+
+	*capture_index = action_increment_counter->key_capture_index.value;
+	status = LTTNG_ACTION_STATUS_OK;
+end:
+	return status;
+}
+
+/*
+ * Call `cb` on `action` if it is an increment-counter action, or on each
+ * increment-counter action of `action` if it is a group. Stop at the first
+ * callback returning false, and return false in that case.
+ */
+static bool for_each_counter_action(const struct lttng_action *action,
+		bool (*cb)(const struct lttng_action *, const void *),
+		const void *data)
+{
+	unsigned int i, count;
+
+	switch (lttng_action_get_type(action)) {
+	case LTTNG_ACTION_TYPE_INCREMENT_COUNTER:
+		return cb(action, data);
+	case LTTNG_ACTION_TYPE_GROUP:
+		break;
+	default:
+		return true;
+	}
+
+	if (lttng_action_group_get_count(action, &count) !=
+			LTTNG_ACTION_STATUS_OK) {
+		return true;
+	}
+
+	for (i = 0; i < count; i++) {
+		const struct lttng_action *child =
+				lttng_action_group_get_at_index(action, i);
+
+		if (lttng_action_get_type(child) ==
+				LTTNG_ACTION_TYPE_INCREMENT_COUNTER &&
+				!cb(child, data)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool key_capture_index_is_unset(const struct lttng_action *action,
+		const void *data)
+{
+	return !action_increment_counter_from_action_const(action)
+			->key_capture_index.is_set;
+}
+
+LTTNG_HIDDEN
+bool lttng_action_counter_uses_captures(const struct lttng_action *action)
+{
+	return !for_each_counter_action(action, key_capture_index_is_unset,
+			NULL);
+}
+
+static bool key_capture_index_is_valid(const struct lttng_action *action,
+		const void *data)
+{
+	unsigned int capture_count;
+	const struct lttng_condition *condition = data;
+	const struct lttng_action_increment_counter *action_increment_counter =
+			action_increment_counter_from_action_const(action);
+
+	if (!action_increment_counter->key_capture_index.is_set) {
+		return true;
+	}
+
+	if (lttng_condition_get_type(condition) !=
+			LTTNG_CONDITION_TYPE_ON_EVENT) {
+		return false;
+	}
+
+	if (lttng_condition_on_event_get_capture_descriptor_count(
+			condition, &capture_count) !=
+			LTTNG_CONDITION_STATUS_OK) {
+		return false;
+	}
+
+	return action_increment_counter->key_capture_index.value <
+			capture_count;
+}
+
+LTTNG_HIDDEN
+bool lttng_action_counter_key_captures_are_valid(
+		const struct lttng_action *action,
+		const struct lttng_condition *condition)
+{
+	return for_each_counter_action(action, key_capture_index_is_valid,
+			condition);
+}
+
+LTTNG_HIDDEN
+bool lttng_action_is_counter_only(const struct lttng_action *action)
+{
+	unsigned int i, count;
+	enum lttng_action_status status;
+
+	switch (lttng_action_get_type(action)) {
+	case LTTNG_ACTION_TYPE_INCREMENT_COUNTER:
+		return true;
+	case LTTNG_ACTION_TYPE_GROUP:
+		break;
+	default:
+		return false;
+	}
+
+	status = lttng_action_group_get_count(action, &count);
+	if (status != LTTNG_ACTION_STATUS_OK || count == 0) {
+		return false;
+	}
+
+	for (i = 0; i < count; i++) {
+		const struct lttng_action *child =
+				lttng_action_group_get_at_index(action, i);
+
+		if (lttng_action_get_type(child) !=
+				LTTNG_ACTION_TYPE_INCREMENT_COUNTER) {
+			return false;
+		}
+	}
+
+	return true;
+}
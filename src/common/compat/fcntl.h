@@ -29,6 +29,11 @@ extern int compat_sync_file_range(int fd, off64_t offset, off64_t nbytes,
 
 #endif /* __linux__ */
 
+#ifndef O_DIRECT
+/* Direct I/O is not available; use buffered I/O instead. */
+#define O_DIRECT 0
+#endif
+
 #if (defined(__FreeBSD__) || defined(__CYGWIN__) || defined(__sun__))
 /*
  * Possible flags under Linux. Simply nullify them and avoid wrapper.
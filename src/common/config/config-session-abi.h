@@ -44,6 +44,8 @@ extern const char * const config_element_switch_timer_interval;
 extern const char * const config_element_read_timer_interval;
 extern const char * const config_element_monitor_timer_interval;
 extern const char * const config_element_blocking_timeout;
+extern const char * const config_element_writeback_window_size;
+extern const char * const config_element_direct_io;
 extern const char * const config_element_output;
 extern const char * const config_element_output_type;
 extern const char * const config_element_tracefile_size;
@@ -102,6 +102,8 @@ const char * const config_element_switch_timer_interval = "switch_timer_interval
 const char * const config_element_read_timer_interval = "read_timer_interval";
 LTTNG_HIDDEN const char * const config_element_monitor_timer_interval = "monitor_timer_interval";
 LTTNG_HIDDEN const char * const config_element_blocking_timeout = "blocking_timeout";
+LTTNG_HIDDEN const char * const config_element_writeback_window_size = "writeback_window_size";
+LTTNG_HIDDEN const char * const config_element_direct_io = "direct_io";
 const char * const config_element_output = "output";
 const char * const config_element_output_type = "output_type";
 const char * const config_element_tracefile_size = "tracefile_size";
@@ -2489,6 +2491,55 @@ int process_channel_attr_node(xmlNodePtr attr_node,
 			ret = -LTTNG_ERR_LOAD_INVALID_CONFIG;
 			goto end;
 		}
+	} else if (!strcmp((const char *) attr_node->name,
+			config_element_writeback_window_size)) {
+		xmlChar *content;
+		uint64_t writeback_window_size = 0;
+
+		/* writeback_window_size */
+		content = xmlNodeGetContent(attr_node);
+		if (!content) {
+			ret = -LTTNG_ERR_NOMEM;
+			goto end;
+		}
+
+		ret = parse_uint(content, &writeback_window_size);
+		free(content);
+		if (ret) {
+			ret = -LTTNG_ERR_LOAD_INVALID_CONFIG;
+			goto end;
+		}
+
+		ret = lttng_channel_set_writeback_window_size(channel,
+			writeback_window_size);
+		if (ret) {
+			ret = -LTTNG_ERR_LOAD_INVALID_CONFIG;
+			goto end;
+		}
+	} else if (!strcmp((const char *) attr_node->name,
+			config_element_direct_io)) {
+		xmlChar *content;
+		int direct_io = 0;
+
+		/* direct_io */
+		content = xmlNodeGetContent(attr_node);
+		if (!content) {
+			ret = -LTTNG_ERR_NOMEM;
+			goto end;
+		}
+
+		ret = parse_bool(content, &direct_io);
+		free(content);
+		if (ret) {
+			ret = -LTTNG_ERR_LOAD_INVALID_CONFIG;
+			goto end;
+		}
+
+		ret = lttng_channel_set_direct_io(channel, direct_io);
+		if (ret) {
+			ret = -LTTNG_ERR_LOAD_INVALID_CONFIG;
+			goto end;
+		}
 	} else if (!strcmp((const char *) attr_node->name,
 			config_element_events)) {
 		/* events */
@@ -0,0 +1,1401 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <bin/lttng-consumerd/health-consumerd.h>
+#include <common/common.h>
+#include <common/compat/endian.h>
+#include <common/compat/poll.h>
+#include <common/dynamic-buffer.h>
+#include <common/live/lttng-viewer-abi.h>
+#include <common/live/packet-list.h>
+#include <common/live/stream-filter.h>
+#include <common/sessiond-comm/relayd.h>
+#include <common/sessiond-comm/sessiond-comm.h>
+#include <common/utils.h>
+
+#include "consumer-live.h"
+
+struct live_session;
+
+struct consumer_live_stream {
+	/* Key of the consumer stream. */
+	uint64_t id;
+	uint64_t ctf_trace_id;
+	bool is_metadata;
+	char path_name[LTTNG_VIEWER_PATH_MAX];
+	char channel_name[LTTNG_VIEWER_NAME_MAX];
+	/* Set once the consumer stream is gone. */
+	bool closed;
+	struct live_session *session;
+	struct cds_list_head node;
+
+	/* Data streams. */
+	struct live_packet_list packets;
+	/*
+	 * Packet being consumed. Only accessed by the thread consuming the
+	 * stream, under the stream lock.
+	 */
+	struct live_packet *pending;
+	/* Timestamp of the last beacon, -1ULL if a packet followed it. */
+	uint64_t beacon_timestamp;
+	uint64_t beacon_ctf_stream_id;
+
+	/* Metadata streams. */
+	struct lttng_dynamic_buffer metadata;
+	uint64_t metadata_version;
+	/*
+	 * Set once the metadata outgrew its retention limit; it is no longer
+	 * served until it is regenerated.
+	 */
+	bool metadata_truncated;
+
+	/* State of the attached viewer. */
+	bool sent;
+	uint64_t viewer_offset;
+	uint64_t metadata_sent;
+	/* Packet of the last index sent, until the next one is sent. */
+	struct live_packet *viewer_packet;
+};
+
+struct live_viewer;
+
+struct live_session {
+	uint64_t id;
+	char session_name[LTTNG_VIEWER_NAME_MAX];
+	char hostname[LTTNG_VIEWER_HOST_NAME_MAX];
+	unsigned int live_timer;
+	/* Set once the session daemon announced the session. */
+	bool named;
+	/* Set once the session was destroyed. */
+	bool closed;
+	uint64_t next_ctf_trace_id;
+	struct cds_list_head streams;
+	struct live_viewer *viewer;
+	/* Streams selected by the viewer, NULL for all. */
+	struct live_stream_filter *filter;
+	struct cds_list_head node;
+};
+
+struct live_viewer {
+	struct lttcomm_sock *sock;
+	bool version_check_done;
+	bool session_created;
+	struct live_session *session;
+	struct cds_list_head node;
+};
+
+/*
+ * Protects the sessions, their streams and packets.
+ *
+ * This is nested INSIDE the stream lock.
+ */
+static pthread_mutex_t live_lock = PTHREAD_MUTEX_INITIALIZER;
+static CDS_LIST_HEAD(live_sessions);
+static struct lttcomm_sock *live_sock;
+static int live_quit_pipe[2] = { -1, -1 };
+static uint64_t last_viewer_session_id;
+
+static void live_stream_unpin(struct consumer_live_stream *stream)
+{
+	live_packet_put(stream->viewer_packet);
+	stream->viewer_packet = NULL;
+}
+
+static void live_stream_destroy(struct consumer_live_stream *stream)
+{
+	cds_list_del(&stream->node);
+	live_stream_unpin(stream);
+	live_packet_list_reset(&stream->packets);
+	lttng_dynamic_buffer_reset(&stream->metadata);
+	free(stream);
+}
+
+static void live_session_reset_filter(struct live_session *session)
+{
+	free(session->filter);
+	session->filter = NULL;
+}
+
+/*
+ * Destroy a session once it was destroyed by the session daemon, all of its
+ * consumer streams are gone and no viewer is attached to it.
+ */
+static void live_session_try_destroy(struct live_session *session)
+{
+	struct consumer_live_stream *stream, *tmp;
+
+	if (!session->closed || session->viewer) {
+		return;
+	}
+	cds_list_for_each_entry(stream, &session->streams, node) {
+		if (!stream->closed) {
+			return;
+		}
+	}
+
+	DBG("Destroying local live session %" PRIu64, session->id);
+	cds_list_for_each_entry_safe(stream, tmp, &session->streams, node) {
+		live_stream_destroy(stream);
+	}
+	live_session_reset_filter(session);
+	cds_list_del(&session->node);
+	free(session);
+}
+
+static struct live_session *live_session_find(uint64_t session_id)
+{
+	struct live_session *session;
+
+	cds_list_for_each_entry(session, &live_sessions, node) {
+		if (session->id == session_id) {
+			return session;
+		}
+	}
+	return NULL;
+}
+
+static struct live_session *live_session_find_or_create(uint64_t session_id)
+{
+	struct live_session *session;
+
+	session = live_session_find(session_id);
+	if (session) {
+		goto end;
+	}
+
+	session = zmalloc(sizeof(*session));
+	if (!session) {
+		PERROR("zmalloc local live session");
+		goto end;
+	}
+	session->id = session_id;
+	CDS_INIT_LIST_HEAD(&session->streams);
+	cds_list_add_tail(&session->node, &live_sessions);
+end:
+	return session;
+}
+
+static struct consumer_live_stream *live_session_find_stream(
+		struct live_session *session, uint64_t stream_id)
+{
+	struct consumer_live_stream *stream;
+
+	cds_list_for_each_entry(stream, &session->streams, node) {
+		if (stream->id == stream_id) {
+			return stream;
+		}
+	}
+	return NULL;
+}
+
+static struct consumer_live_stream *live_session_find_metadata(
+		struct live_session *session, uint64_t ctf_trace_id)
+{
+	struct consumer_live_stream *stream;
+
+	cds_list_for_each_entry(stream, &session->streams, node) {
+		if (stream->is_metadata && stream->ctf_trace_id == ctf_trace_id) {
+			return stream;
+		}
+	}
+	return NULL;
+}
+
+bool consumer_live_enabled(void)
+{
+	return live_sock != NULL;
+}
+
+void consumer_live_session_add(uint64_t session_id, const char *session_name,
+		const char *hostname, unsigned int live_timer)
+{
+	struct live_session *session;
+
+	if (!consumer_live_enabled()) {
+		return;
+	}
+
+	pthread_mutex_lock(&live_lock);
+	session = live_session_find_or_create(session_id);
+	if (!session) {
+		goto end;
+	}
+	if (lttng_strncpy(session->session_name, session_name,
+			sizeof(session->session_name))) {
+		WARN("Truncating name of local live session %" PRIu64,
+				session_id);
+	}
+	if (lttng_strncpy(session->hostname, hostname,
+			sizeof(session->hostname))) {
+		WARN("Truncating hostname of local live session %" PRIu64,
+				session_id);
+	}
+	session->live_timer = live_timer;
+	session->named = true;
+	DBG("Local live session %" PRIu64 " added: name = \"%s\"",
+			session_id, session->session_name);
+end:
+	pthread_mutex_unlock(&live_lock);
+}
+
+void consumer_live_session_close(uint64_t session_id)
+{
+	struct live_session *session;
+
+	pthread_mutex_lock(&live_lock);
+	session = live_session_find(session_id);
+	if (session) {
+		DBG("Local live session %" PRIu64 " closed", session_id);
+		session->closed = true;
+		live_session_try_destroy(session);
+	}
+	pthread_mutex_unlock(&live_lock);
+}
+
+void consumer_live_stream_add(struct lttng_consumer_stream *stream)
+{
+	struct live_session *session;
+	struct consumer_live_stream *lstream, *other;
+
+	if (!consumer_live_enabled() || !stream->chan->is_live ||
+			stream->net_seq_idx != (uint64_t) -1ULL ||
+			stream->chan->output != CONSUMER_CHANNEL_MMAP) {
+		return;
+	}
+
+	lstream = zmalloc(sizeof(*lstream));
+	if (!lstream) {
+		PERROR("zmalloc local live stream");
+		return;
+	}
+	lstream->id = stream->key;
+	lstream->is_metadata = stream->metadata_flag;
+	if (lttng_strncpy(lstream->path_name, stream->chan->pathname,
+			sizeof(lstream->path_name)) ||
+			lttng_strncpy(lstream->channel_name, stream->name,
+					sizeof(lstream->channel_name))) {
+		ERR("Failed to copy the names of local live stream %" PRIu64,
+				stream->key);
+		free(lstream);
+		return;
+	}
+	live_packet_list_init(&lstream->packets);
+	lttng_dynamic_buffer_init(&lstream->metadata);
+	lstream->metadata_version = stream->metadata_version;
+	lstream->beacon_timestamp = -1ULL;
+
+	pthread_mutex_lock(&live_lock);
+	session = live_session_find_or_create(stream->session_id);
+	if (!session) {
+		pthread_mutex_unlock(&live_lock);
+		free(lstream);
+		return;
+	}
+
+	/* The streams of a trace share the output path of their channels. */
+	lstream->ctf_trace_id = session->next_ctf_trace_id;
+	cds_list_for_each_entry(other, &session->streams, node) {
+		if (!strcmp(other->path_name, lstream->path_name)) {
+			lstream->ctf_trace_id = other->ctf_trace_id;
+			break;
+		}
+	}
+	if (lstream->ctf_trace_id == session->next_ctf_trace_id) {
+		session->next_ctf_trace_id++;
+	}
+
+	lstream->session = session;
+	cds_list_add_tail(&lstream->node, &session->streams);
+	stream->live_stream = lstream;
+	pthread_mutex_unlock(&live_lock);
+
+	DBG("Stream %" PRIu64 " of session %" PRIu64 " served to local live viewers",
+			stream->key, stream->session_id);
+}
+
+void consumer_live_stream_close(struct lttng_consumer_stream *stream)
+{
+	struct consumer_live_stream *lstream = stream->live_stream;
+
+	if (!lstream) {
+		return;
+	}
+
+	live_packet_put(lstream->pending);
+	lstream->pending = NULL;
+
+	pthread_mutex_lock(&live_lock);
+	lstream->closed = true;
+	live_session_try_destroy(lstream->session);
+	pthread_mutex_unlock(&live_lock);
+	stream->live_stream = NULL;
+}
+
+/*
+ * Retain the metadata of a stream, which a viewer attaching to the session
+ * needs in full, up to DEFAULT_CONSUMERD_LIVE_METADATA_RETENTION_SIZE.
+ *
+ * Called with the live lock held.
+ */
+static void live_stream_retain_metadata(struct consumer_live_stream *lstream,
+		struct lttng_consumer_stream *stream,
+		const struct lttng_buffer_view *buffer)
+{
+	if (lstream->metadata_version != stream->metadata_version) {
+		/* Regenerated metadata; start over. */
+		lttng_dynamic_buffer_set_size(&lstream->metadata, 0);
+		lstream->metadata_sent = 0;
+		lstream->metadata_version = stream->metadata_version;
+		lstream->metadata_truncated = false;
+	}
+	if (lstream->metadata_truncated) {
+		return;
+	}
+
+	if (lstream->metadata.size + buffer->size >
+			DEFAULT_CONSUMERD_LIVE_METADATA_RETENTION_SIZE) {
+		WARN("Metadata of local live stream %" PRIu64 " exceeds %d bytes, no longer serving it to live viewers",
+				stream->key,
+				DEFAULT_CONSUMERD_LIVE_METADATA_RETENTION_SIZE);
+		goto truncate;
+	}
+	if (lttng_dynamic_buffer_append_view(&lstream->metadata, buffer)) {
+		ERR("Failed to retain metadata of local live stream %" PRIu64,
+				stream->key);
+		goto truncate;
+	}
+	return;
+
+truncate:
+	/* A partial metadata can't be parsed; drop it altogether. */
+	lttng_dynamic_buffer_reset(&lstream->metadata);
+	lstream->metadata_truncated = true;
+}
+
+void consumer_live_stream_append(struct lttng_consumer_stream *stream,
+		const struct lttng_buffer_view *buffer)
+{
+	bool attached;
+	struct consumer_live_stream *lstream = stream->live_stream;
+
+	if (!lstream) {
+		return;
+	}
+
+	pthread_mutex_lock(&live_lock);
+	if (lstream->is_metadata) {
+		live_stream_retain_metadata(lstream, stream, buffer);
+		pthread_mutex_unlock(&live_lock);
+		return;
+	}
+	attached = lstream->session->viewer;
+	pthread_mutex_unlock(&live_lock);
+
+	live_packet_put(lstream->pending);
+	lstream->pending = NULL;
+
+	/*
+	 * Without a viewer attached, the packet is only written to the local
+	 * output. Otherwise, the sub-buffer is copied without holding the live
+	 * lock; it is only published, along with its index, once consumed.
+	 */
+	if (attached) {
+		lstream->pending = live_packet_create(buffer);
+	}
+}
+
+int consumer_live_stream_publish(struct lttng_consumer_stream *stream,
+		const struct stream_subbuffer *subbuffer,
+		struct lttng_consumer_local_data *ctx)
+{
+	struct consumer_live_stream *lstream = stream->live_stream;
+	struct live_packet *packet;
+
+	if (!lstream || !lstream->pending) {
+		return 0;
+	}
+
+	packet = lstream->pending;
+	lstream->pending = NULL;
+	packet->packet_size = subbuffer->info.data.packet_size;
+	packet->content_size = subbuffer->info.data.content_size;
+	packet->timestamp_begin = subbuffer->info.data.timestamp_begin;
+	packet->timestamp_end = subbuffer->info.data.timestamp_end;
+	packet->events_discarded = subbuffer->info.data.events_discarded;
+	packet->stream_id = subbuffer->info.data.stream_id;
+
+	pthread_mutex_lock(&live_lock);
+	lstream->beacon_timestamp = -1ULL;
+	if (lstream->session->viewer) {
+		live_packet_list_append(&lstream->packets, packet,
+				DEFAULT_CONSUMERD_LIVE_STREAM_RETENTION_SIZE);
+	} else {
+		/* The viewer detached while the packet was consumed. */
+		live_packet_put(packet);
+	}
+	pthread_mutex_unlock(&live_lock);
+	return 0;
+}
+
+void consumer_live_stream_beacon(struct lttng_consumer_stream *stream,
+		uint64_t timestamp_end, uint64_t ctf_stream_id)
+{
+	struct consumer_live_stream *lstream = stream->live_stream;
+
+	if (!lstream) {
+		return;
+	}
+
+	pthread_mutex_lock(&live_lock);
+	lstream->beacon_timestamp = timestamp_end;
+	lstream->beacon_ctf_stream_id = ctf_stream_id;
+	pthread_mutex_unlock(&live_lock);
+}
+
+/*
+ * Receive a request of the viewer.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int recv_request(struct live_viewer *viewer, void *buf, size_t size)
+{
+	ssize_t ret;
+
+	ret = viewer->sock->ops->recvmsg(viewer->sock, buf, size, 0);
+	if (ret < 0 || ret != size) {
+		if (ret == 0) {
+			/* Orderly shutdown. Not necessary to print an error. */
+			DBG("Socket %d did an orderly shutdown", viewer->sock->fd);
+		} else {
+			ERR("Failed to receive local live viewer request");
+		}
+		return -1;
+	}
+	return 0;
+}
+
+static int send_response(struct live_viewer *viewer, const void *buf,
+		size_t size)
+{
+	ssize_t ret;
+
+	if (!size) {
+		return 0;
+	}
+
+	ret = viewer->sock->ops->sendmsg(viewer->sock, buf, size, 0);
+	if (ret < 0) {
+		ERR("Failed to send local live viewer response");
+		return -1;
+	}
+	return 0;
+}
+
+static void live_viewer_detach(struct live_viewer *viewer)
+{
+	struct live_session *session = viewer->session;
+	struct consumer_live_stream *stream;
+
+	if (!session) {
+		return;
+	}
+
+	/* Packets are only retained while a viewer is attached. */
+	cds_list_for_each_entry(stream, &session->streams, node) {
+		live_stream_unpin(stream);
+		live_packet_list_reset(&stream->packets);
+	}
+	live_session_reset_filter(session);
+	session->viewer = NULL;
+	viewer->session = NULL;
+	live_session_try_destroy(session);
+}
+
+/*
+ * Append the description of the streams of the viewer's session not yet sent
+ * to the viewer and mark them as sent.
+ *
+ * Called with the live lock held.
+ */
+static int append_new_streams(struct live_viewer *viewer,
+		struct lttng_dynamic_buffer *buffer, uint32_t *count)
+{
+	struct consumer_live_stream *stream;
+	int ret = 0;
+
+	cds_list_for_each_entry(stream, &viewer->session->streams, node) {
+		struct lttng_viewer_stream send_stream = {};
+
+		if (stream->sent ||
+				!live_stream_filter_match(viewer->session->filter,
+						stream->channel_name,
+						stream->is_metadata)) {
+			continue;
+		}
+
+		send_stream.id = htobe64(stream->id);
+		send_stream.ctf_trace_id = htobe64(stream->ctf_trace_id);
+		send_stream.metadata_flag = htobe32(stream->is_metadata);
+		strcpy(send_stream.path_name, stream->path_name);
+		strcpy(send_stream.channel_name, stream->channel_name);
+		ret = lttng_dynamic_buffer_append(buffer, &send_stream,
+				sizeof(send_stream));
+		if (ret) {
+			break;
+		}
+		stream->sent = true;
+		(*count)++;
+	}
+	return ret;
+}
+
+static bool live_viewer_has_new_streams(struct live_viewer *viewer)
+{
+	struct consumer_live_stream *stream;
+
+	cds_list_for_each_entry(stream, &viewer->session->streams, node) {
+		if (!stream->sent &&
+				live_stream_filter_match(viewer->session->filter,
+						stream->channel_name,
+						stream->is_metadata)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static int viewer_connect(struct live_viewer *viewer)
+{
+	int ret;
+	struct lttng_viewer_connect reply, msg;
+
+	ret = recv_request(viewer, &msg, sizeof(msg));
+	if (ret < 0) {
+		goto end;
+	}
+
+	memset(&reply, 0, sizeof(reply));
+	reply.major = RELAYD_VERSION_COMM_MAJOR;
+	reply.minor = RELAYD_VERSION_COMM_MINOR;
+
+	/* Major versions must be the same */
+	if (reply.major != be32toh(msg.major)) {
+		DBG("Incompatible major versions ([consumerd] %u vs [client] %u)",
+				reply.major, be32toh(msg.major));
+		ret = -1;
+		goto end;
+	}
+
+	/* We adapt to the lowest compatible version */
+	if (reply.minor > be32toh(msg.minor)) {
+		reply.minor = be32toh(msg.minor);
+	}
+
+	if (be32toh(msg.type) != LTTNG_VIEWER_CLIENT_COMMAND &&
+			be32toh(msg.type) != LTTNG_VIEWER_CLIENT_NOTIFICATION) {
+		ERR("Unknown connection type : %u", be32toh(msg.type));
+		ret = -1;
+		goto end;
+	}
+
+	viewer->version_check_done = true;
+	reply.major = htobe32(reply.major);
+	reply.minor = htobe32(reply.minor);
+	if (be32toh(msg.type) == LTTNG_VIEWER_CLIENT_COMMAND) {
+		last_viewer_session_id++;
+		reply.viewer_session_id = htobe64(last_viewer_session_id);
+	}
+
+	ret = send_response(viewer, &reply, sizeof(reply));
+end:
+	return ret;
+}
+
+static int viewer_list_sessions(struct live_viewer *viewer)
+{
+	int ret = 0;
+	struct lttng_viewer_list_sessions session_list;
+	struct lttng_dynamic_buffer payload;
+	struct live_session *session;
+	uint32_t count = 0;
+
+	lttng_dynamic_buffer_init(&payload);
+
+	pthread_mutex_lock(&live_lock);
+	cds_list_for_each_entry(session, &live_sessions, node) {
+		struct lttng_viewer_session send_session = {};
+		struct consumer_live_stream *stream;
+		uint32_t stream_count = 0;
+
+		if (!session->named || session->closed) {
+			continue;
+		}
+
+		cds_list_for_each_entry(stream, &session->streams, node) {
+			stream_count++;
+		}
+
+		strcpy(send_session.session_name, session->session_name);
+		strcpy(send_session.hostname, session->hostname);
+		send_session.id = htobe64(session->id);
+		send_session.live_timer = htobe32(session->live_timer);
+		send_session.clients = htobe32(session->viewer ? 1 : 0);
+		send_session.streams = htobe32(stream_count);
+		ret = lttng_dynamic_buffer_append(&payload, &send_session,
+				sizeof(send_session));
+		if (ret) {
+			break;
+		}
+		count++;
+	}
+	pthread_mutex_unlock(&live_lock);
+	if (ret) {
+		goto end;
+	}
+
+	session_list.sessions_count = htobe32(count);
+	ret = send_response(viewer, &session_list, sizeof(session_list));
+	if (ret < 0) {
+		goto end;
+	}
+	ret = send_response(viewer, payload.data, payload.size);
+end:
+	lttng_dynamic_buffer_reset(&payload);
+	return ret;
+}
+
+/*
+ * Attach the viewer to a session. Takes ownership of the filter.
+ */
+static int attach_session(struct live_viewer *viewer, uint64_t session_id,
+		uint32_t seek, struct live_stream_filter *filter)
+{
+	int ret;
+	struct lttng_viewer_attach_session_response response = {};
+	struct lttng_dynamic_buffer payload;
+	struct live_session *session;
+	struct consumer_live_stream *stream;
+	uint32_t count = 0;
+
+	lttng_dynamic_buffer_init(&payload);
+
+	pthread_mutex_lock(&live_lock);
+	if (!viewer->session_created) {
+		response.status = htobe32(LTTNG_VIEWER_ATTACH_NO_SESSION);
+		goto send_reply;
+	}
+
+	session = live_session_find(session_id);
+	if (!session || !session->named || session->closed) {
+		DBG("Local live session %" PRIu64 " not found", session_id);
+		response.status = htobe32(LTTNG_VIEWER_ATTACH_UNK);
+		goto send_reply;
+	}
+
+	if (session->viewer && session->viewer != viewer) {
+		DBG("Already a viewer attached to local live session %" PRIu64,
+				session_id);
+		response.status = htobe32(LTTNG_VIEWER_ATTACH_ALREADY);
+		goto send_reply;
+	}
+
+	if (seek != LTTNG_VIEWER_SEEK_BEGINNING &&
+			seek != LTTNG_VIEWER_SEEK_LAST) {
+		ERR("Wrong seek parameter");
+		response.status = htobe32(LTTNG_VIEWER_ATTACH_SEEK_ERR);
+		goto send_reply;
+	}
+
+	if (viewer->session != session) {
+		live_viewer_detach(viewer);
+	}
+	live_session_reset_filter(session);
+	session->filter = filter;
+	filter = NULL;
+	session->viewer = viewer;
+	viewer->session = session;
+
+	cds_list_for_each_entry(stream, &session->streams, node) {
+		live_stream_unpin(stream);
+		stream->sent = false;
+		stream->metadata_sent = 0;
+		stream->viewer_offset = seek == LTTNG_VIEWER_SEEK_LAST ?
+				live_packet_list_last_offset(&stream->packets) :
+				0;
+	}
+
+	ret = append_new_streams(viewer, &payload, &count);
+	if (ret) {
+		pthread_mutex_unlock(&live_lock);
+		goto end;
+	}
+	response.status = htobe32(LTTNG_VIEWER_ATTACH_OK);
+	response.streams_count = htobe32(count);
+
+send_reply:
+	pthread_mutex_unlock(&live_lock);
+	ret = send_response(viewer, &response, sizeof(response));
+	if (ret < 0) {
+		goto end;
+	}
+	ret = send_response(viewer, payload.data, payload.size);
+end:
+	free(filter);
+	lttng_dynamic_buffer_reset(&payload);
+	return ret;
+}
+
+static int viewer_attach_session(struct live_viewer *viewer)
+{
+	int ret;
+	struct lttng_viewer_attach_session_request request;
+
+	ret = recv_request(viewer, &request, sizeof(request));
+	if (ret < 0) {
+		return ret;
+	}
+
+	return attach_session(viewer, be64toh(request.session_id),
+			be32toh(request.seek), NULL);
+}
+
+static int viewer_attach_session_filtered(struct live_viewer *viewer)
+{
+	int ret;
+	uint32_t i, cpu_count;
+	struct lttng_viewer_attach_session_filtered_request request;
+	struct live_stream_filter *filter = NULL;
+
+	ret = recv_request(viewer, &request, sizeof(request));
+	if (ret < 0) {
+		goto end;
+	}
+
+	cpu_count = be32toh(request.cpu_count);
+	if (cpu_count > LTTNG_VIEWER_FILTER_CPUS_MAX) {
+		ERR("Viewer stream filter CPU count exceeds the maximum: count = %" PRIu32 ", max = %d",
+				cpu_count, LTTNG_VIEWER_FILTER_CPUS_MAX);
+		ret = -1;
+		goto end;
+	}
+
+	filter = zmalloc(sizeof(*filter) + cpu_count * sizeof(filter->cpus[0]));
+	if (!filter) {
+		PERROR("zmalloc viewer stream filter");
+		ret = -1;
+		goto end;
+	}
+
+	if (cpu_count) {
+		ret = recv_request(viewer, filter->cpus,
+				cpu_count * sizeof(filter->cpus[0]));
+		if (ret < 0) {
+			goto end;
+		}
+	}
+	filter->cpu_count = cpu_count;
+	for (i = 0; i < cpu_count; i++) {
+		filter->cpus[i] = be32toh(filter->cpus[i]);
+	}
+
+	request.channel_name[sizeof(request.channel_name) - 1] = '\0';
+	strcpy(filter->channel_name, request.channel_name);
+	ret = attach_session(viewer, be64toh(request.session_id),
+			be32toh(request.seek), filter);
+	/* Ownership transferred to attach_session(). */
+	filter = NULL;
+end:
+	free(filter);
+	return ret;
+}
+
+static int viewer_get_next_index(struct live_viewer *viewer)
+{
+	int ret;
+	struct lttng_viewer_get_next_index request;
+	struct lttng_viewer_index viewer_index = {};
+	struct consumer_live_stream *stream = NULL, *metadata;
+	struct live_packet *packet;
+	uint32_t flags = 0;
+
+	ret = recv_request(viewer, &request, sizeof(request));
+	if (ret < 0) {
+		return ret;
+	}
+
+	pthread_mutex_lock(&live_lock);
+	if (viewer->session) {
+		stream = live_session_find_stream(viewer->session,
+				be64toh(request.stream_id));
+	}
+	if (!stream) {
+		DBG("Client requested index of unknown stream id %" PRIu64,
+				(uint64_t) be64toh(request.stream_id));
+		viewer_index.status = htobe32(LTTNG_VIEWER_INDEX_ERR);
+		goto send_reply;
+	}
+
+	/* The viewer should not ask for index on metadata stream. */
+	if (stream->is_metadata) {
+		viewer_index.status = htobe32(LTTNG_VIEWER_INDEX_HUP);
+		goto send_reply;
+	}
+
+	if (live_viewer_has_new_streams(viewer)) {
+		flags |= LTTNG_VIEWER_FLAG_NEW_STREAM;
+	}
+	metadata = live_session_find_metadata(viewer->session,
+			stream->ctf_trace_id);
+	if (metadata && !metadata->metadata_truncated &&
+			(!metadata->metadata.size ||
+			metadata->metadata.size > metadata->metadata_sent)) {
+		flags |= LTTNG_VIEWER_FLAG_NEW_METADATA;
+	}
+
+	/* Packets trimmed before the viewer got to them are skipped. */
+	packet = live_packet_list_next(&stream->packets,
+			stream->viewer_offset);
+	if (packet) {
+		viewer_index.status = htobe32(LTTNG_VIEWER_INDEX_OK);
+		viewer_index.offset = htobe64(packet->offset);
+		viewer_index.packet_size = htobe64(packet->packet_size);
+		viewer_index.content_size = htobe64(packet->content_size);
+		viewer_index.timestamp_begin = htobe64(packet->timestamp_begin);
+		viewer_index.timestamp_end = htobe64(packet->timestamp_end);
+		viewer_index.events_discarded =
+				htobe64(packet->events_discarded);
+		viewer_index.stream_id = htobe64(packet->stream_id);
+		stream->viewer_offset = packet->offset + packet->size;
+
+		/* Keep the packet around until the viewer fetched it. */
+		live_stream_unpin(stream);
+		live_packet_get(packet);
+		stream->viewer_packet = packet;
+		goto send_reply;
+	}
+
+	if (stream->closed) {
+		viewer_index.status = htobe32(LTTNG_VIEWER_INDEX_HUP);
+		live_stream_destroy(stream);
+	} else if (stream->beacon_timestamp != -1ULL) {
+		viewer_index.status = htobe32(LTTNG_VIEWER_INDEX_INACTIVE);
+		viewer_index.timestamp_end = htobe64(stream->beacon_timestamp);
+		viewer_index.stream_id = htobe64(stream->beacon_ctf_stream_id);
+	} else {
+		viewer_index.status = htobe32(LTTNG_VIEWER_INDEX_RETRY);
+	}
+
+send_reply:
+	pthread_mutex_unlock(&live_lock);
+	viewer_index.flags = htobe32(flags);
+	return send_response(viewer, &viewer_index, sizeof(viewer_index));
+}
+
+static int viewer_get_packet(struct live_viewer *viewer)
+{
+	int ret;
+	struct lttng_viewer_get_packet request;
+	struct lttng_viewer_trace_packet reply_header = {};
+	struct consumer_live_stream *stream = NULL;
+	struct live_packet *packet = NULL;
+	uint64_t offset;
+	uint32_t len;
+
+	ret = recv_request(viewer, &request, sizeof(request));
+	if (ret < 0) {
+		return ret;
+	}
+	offset = be64toh(request.offset);
+	len = be32toh(request.len);
+
+	pthread_mutex_lock(&live_lock);
+	if (viewer->session) {
+		stream = live_session_find_stream(viewer->session,
+				be64toh(request.stream_id));
+	}
+	if (!stream) {
+		DBG("Client requested packet of unknown stream id %" PRIu64,
+				(uint64_t) be64toh(request.stream_id));
+		goto unlock;
+	}
+
+	if (stream->viewer_packet && stream->viewer_packet->offset == offset) {
+		packet = stream->viewer_packet;
+	} else {
+		packet = live_packet_list_find(&stream->packets, offset);
+	}
+	if (packet && len <= packet->size) {
+		live_packet_get(packet);
+	} else {
+		packet = NULL;
+	}
+unlock:
+	pthread_mutex_unlock(&live_lock);
+
+	if (!packet) {
+		reply_header.status = htobe32(LTTNG_VIEWER_GET_PACKET_ERR);
+		return send_response(viewer, &reply_header,
+				sizeof(reply_header));
+	}
+
+	/* Retained packets are immutable; send them without the live lock. */
+	reply_header.status = htobe32(LTTNG_VIEWER_GET_PACKET_OK);
+	reply_header.len = htobe32(len);
+	ret = send_response(viewer, &reply_header, sizeof(reply_header));
+	if (!ret) {
+		ret = send_response(viewer, packet->data, len);
+	}
+
+	pthread_mutex_lock(&live_lock);
+	live_packet_put(packet);
+	pthread_mutex_unlock(&live_lock);
+	return ret;
+}
+
+static int viewer_get_metadata(struct live_viewer *viewer)
+{
+	int ret;
+	struct lttng_viewer_get_metadata request;
+	struct lttng_viewer_metadata_packet reply = {};
+	struct consumer_live_stream *stream = NULL;
+	char *data = NULL;
+	uint64_t len = 0;
+
+	ret = recv_request(viewer, &request, sizeof(request));
+	if (ret < 0) {
+		return ret;
+	}
+
+	pthread_mutex_lock(&live_lock);
+	if (viewer->session) {
+		stream = live_session_find_stream(viewer->session,
+				be64toh(request.stream_id));
+	}
+	if (!stream || !stream->is_metadata) {
+		ERR("Invalid metadata stream");
+		reply.status = htobe32(LTTNG_VIEWER_METADATA_ERR);
+		goto unlock;
+	}
+
+	if (stream->metadata_truncated) {
+		DBG("Metadata of local live stream %" PRIu64 " exceeds its retention limit",
+				stream->id);
+		reply.status = htobe32(LTTNG_VIEWER_METADATA_ERR);
+		goto unlock;
+	}
+
+	if (stream->metadata_sent >= stream->metadata.size) {
+		reply.status = htobe32(LTTNG_VIEWER_NO_NEW_METADATA);
+		goto unlock;
+	}
+
+	len = stream->metadata.size - stream->metadata_sent;
+	data = zmalloc(len);
+	if (!data) {
+		PERROR("zmalloc local live metadata");
+		len = 0;
+		reply.status = htobe32(LTTNG_VIEWER_METADATA_ERR);
+		goto unlock;
+	}
+	memcpy(data, stream->metadata.data + stream->metadata_sent, len);
+	stream->metadata_sent += len;
+	reply.status = htobe32(LTTNG_VIEWER_METADATA_OK);
+unlock:
+	pthread_mutex_unlock(&live_lock);
+
+	reply.len = htobe64(len);
+	ret = send_response(viewer, &reply, sizeof(reply));
+	if (!ret) {
+		ret = send_response(viewer, data, len);
+	}
+	free(data);
+	return ret;
+}
+
+static int viewer_get_new_streams(struct live_viewer *viewer)
+{
+	int ret;
+	struct lttng_viewer_new_streams_request request;
+	struct lttng_viewer_new_streams_response response = {};
+	struct lttng_dynamic_buffer payload;
+	uint32_t count = 0;
+
+	ret = recv_request(viewer, &request, sizeof(request));
+	if (ret < 0) {
+		return ret;
+	}
+
+	lttng_dynamic_buffer_init(&payload);
+	pthread_mutex_lock(&live_lock);
+	if (!viewer->session ||
+			viewer->session->id != be64toh(request.session_id)) {
+		DBG("Local live session %" PRIu64 " not attached",
+				(uint64_t) be64toh(request.session_id));
+		response.status = htobe32(LTTNG_VIEWER_NEW_STREAMS_ERR);
+		goto send_reply;
+	}
+
+	ret = append_new_streams(viewer, &payload, &count);
+	if (ret) {
+		pthread_mutex_unlock(&live_lock);
+		goto end;
+	}
+
+	if (count) {
+		response.status = htobe32(LTTNG_VIEWER_NEW_STREAMS_OK);
+	} else if (viewer->session->closed &&
+			cds_list_empty(&viewer->session->streams)) {
+		response.status = htobe32(LTTNG_VIEWER_NEW_STREAMS_HUP);
+	} else {
+		response.status = htobe32(LTTNG_VIEWER_NEW_STREAMS_NO_NEW);
+	}
+	response.streams_count = htobe32(count);
+
+send_reply:
+	pthread_mutex_unlock(&live_lock);
+	ret = send_response(viewer, &response, sizeof(response));
+	if (!ret) {
+		ret = send_response(viewer, payload.data, payload.size);
+	}
+end:
+	lttng_dynamic_buffer_reset(&payload);
+	return ret;
+}
+
+static int viewer_create_session(struct live_viewer *viewer)
+{
+	struct lttng_viewer_create_session_response resp = {};
+
+	viewer->session_created = true;
+	resp.status = htobe32(LTTNG_VIEWER_CREATE_SESSION_OK);
+	return send_response(viewer, &resp, sizeof(resp));
+}
+
+static int viewer_detach_session(struct live_viewer *viewer)
+{
+	int ret;
+	struct lttng_viewer_detach_session_request request;
+	struct lttng_viewer_detach_session_response response = {};
+
+	ret = recv_request(viewer, &request, sizeof(request));
+	if (ret < 0) {
+		return ret;
+	}
+
+	pthread_mutex_lock(&live_lock);
+	if (viewer->session &&
+			viewer->session->id == be64toh(request.session_id)) {
+		live_viewer_detach(viewer);
+		response.status = htobe32(LTTNG_VIEWER_DETACH_SESSION_OK);
+	} else {
+		response.status = htobe32(LTTNG_VIEWER_DETACH_SESSION_UNK);
+	}
+	pthread_mutex_unlock(&live_lock);
+
+	return send_response(viewer, &response, sizeof(response));
+}
+
+static int process_control(struct live_viewer *viewer,
+		const struct lttng_viewer_cmd *recv_hdr)
+{
+	int ret;
+	const uint32_t msg_value = be32toh(recv_hdr->cmd);
+
+	/*
+	 * Make sure we've done the version check before any command other then a
+	 * new client connection.
+	 */
+	if (msg_value != LTTNG_VIEWER_CONNECT && !viewer->version_check_done) {
+		ERR("Viewer conn value %" PRIu32 " before version check", msg_value);
+		return -1;
+	}
+
+	health_code_update();
+
+	switch (msg_value) {
+	case LTTNG_VIEWER_CONNECT:
+		ret = viewer_connect(viewer);
+		break;
+	case LTTNG_VIEWER_LIST_SESSIONS:
+		ret = viewer_list_sessions(viewer);
+		break;
+	case LTTNG_VIEWER_ATTACH_SESSION:
+		ret = viewer_attach_session(viewer);
+		break;
+	case LTTNG_VIEWER_GET_NEXT_INDEX:
+		ret = viewer_get_next_index(viewer);
+		break;
+	case LTTNG_VIEWER_GET_PACKET:
+		ret = viewer_get_packet(viewer);
+		break;
+	case LTTNG_VIEWER_GET_METADATA:
+		ret = viewer_get_metadata(viewer);
+		break;
+	case LTTNG_VIEWER_GET_NEW_STREAMS:
+		ret = viewer_get_new_streams(viewer);
+		break;
+	case LTTNG_VIEWER_CREATE_SESSION:
+		ret = viewer_create_session(viewer);
+		break;
+	case LTTNG_VIEWER_DETACH_SESSION:
+		ret = viewer_detach_session(viewer);
+		break;
+	case LTTNG_VIEWER_ATTACH_SESSION_FILTERED:
+		ret = viewer_attach_session_filtered(viewer);
+		break;
+	default:
+	{
+		struct lttcomm_relayd_generic_reply reply = {};
+
+		ERR("Received unknown viewer command (%u)", msg_value);
+		reply.ret_code = htobe32(LTTNG_ERR_UNK);
+		(void) send_response(viewer, &reply, sizeof(reply));
+		ret = -1;
+		break;
+	}
+	}
+
+	health_code_update();
+	return ret;
+}
+
+static void live_viewer_destroy(struct lttng_poll_event *events,
+		struct live_viewer *viewer)
+{
+	DBG("Local live viewer connection closed with %d", viewer->sock->fd);
+
+	pthread_mutex_lock(&live_lock);
+	live_viewer_detach(viewer);
+	pthread_mutex_unlock(&live_lock);
+
+	(void) lttng_poll_del(events, viewer->sock->fd);
+	cds_list_del(&viewer->node);
+	(void) viewer->sock->ops->close(viewer->sock);
+	lttcomm_destroy_sock(viewer->sock);
+	free(viewer);
+}
+
+static int accept_viewer(struct lttng_poll_event *events,
+		struct cds_list_head *viewers)
+{
+	int ret;
+	struct lttcomm_sock *sock;
+	struct live_viewer *viewer;
+
+	sock = live_sock->ops->accept(live_sock);
+	if (!sock) {
+		ERR("Failed to accept local live viewer connection");
+		return -1;
+	}
+
+	viewer = zmalloc(sizeof(*viewer));
+	if (!viewer) {
+		PERROR("zmalloc local live viewer");
+		goto error;
+	}
+
+	ret = lttng_poll_add(events, sock->fd, LPOLLIN | LPOLLRDHUP);
+	if (ret < 0) {
+		ERR("Failed to add local live viewer socket to the poll set");
+		goto error;
+	}
+
+	viewer->sock = sock;
+	cds_list_add(&viewer->node, viewers);
+	DBG("Local live viewer connection socket %d added to poll", sock->fd);
+	return 0;
+
+error:
+	free(viewer);
+	(void) sock->ops->close(sock);
+	lttcomm_destroy_sock(sock);
+	/* A failed connection is not fatal to the endpoint. */
+	return 0;
+}
+
+int consumer_live_init(struct lttng_uri *uri)
+{
+	int ret;
+	struct lttcomm_sock *sock;
+
+	sock = lttcomm_alloc_sock_from_uri(uri);
+	if (!sock) {
+		ERR("Failed to allocate local live socket");
+		goto error;
+	}
+
+	ret = lttcomm_create_sock(sock);
+	if (ret < 0) {
+		goto error_destroy;
+	}
+
+	ret = sock->ops->bind(sock);
+	if (ret < 0) {
+		PERROR("Failed to bind local live socket");
+		goto error_close;
+	}
+
+	ret = sock->ops->listen(sock, -1);
+	if (ret < 0) {
+		goto error_close;
+	}
+
+	ret = utils_create_pipe_cloexec(live_quit_pipe);
+	if (ret < 0) {
+		goto error_close;
+	}
+
+	live_sock = sock;
+	DBG("Local live endpoint listening on socket %d", sock->fd);
+	return 0;
+
+error_close:
+	(void) sock->ops->close(sock);
+error_destroy:
+	lttcomm_destroy_sock(sock);
+error:
+	return -1;
+}
+
+void *consumer_live_thread(void *data)
+{
+	int ret, err = -1;
+	uint32_t nb_fd;
+	struct lttng_poll_event events;
+	struct live_viewer *viewer, *tmp;
+	CDS_LIST_HEAD(viewers);
+
+	rcu_register_thread();
+
+	health_register(health_consumerd, HEALTH_CONSUMERD_TYPE_LIVE);
+
+	DBG("Consumer local live thread started");
+
+	health_code_update();
+
+	ret = lttng_poll_create(&events, 2, LTTNG_CLOEXEC);
+	if (ret < 0) {
+		goto error_poll;
+	}
+
+	ret = lttng_poll_add(&events, live_quit_pipe[0], LPOLLIN | LPOLLERR);
+	if (ret < 0) {
+		goto error;
+	}
+
+	ret = lttng_poll_add(&events, live_sock->fd, LPOLLIN | LPOLLRDHUP);
+	if (ret < 0) {
+		goto error;
+	}
+
+	for (;;) {
+		int i;
+
+		health_code_update();
+
+		/* Infinite blocking call, waiting for transmission */
+		health_poll_entry();
+		ret = lttng_poll_wait(&events, -1);
+		health_poll_exit();
+		if (ret < 0) {
+			/*
+			 * Restart interrupted system call.
+			 */
+			if (errno == EINTR) {
+				continue;
+			}
+			goto error;
+		}
+
+		nb_fd = ret;
+
+		for (i = 0; i < nb_fd; i++) {
+			/* Fetch once the poll data */
+			const uint32_t revents = LTTNG_POLL_GETEV(&events, i);
+			const int pollfd = LTTNG_POLL_GETFD(&events, i);
+			struct live_viewer *found = NULL;
+
+			health_code_update();
+
+			if (pollfd == live_quit_pipe[0]) {
+				err = 0;
+				goto exit;
+			}
+
+			if (pollfd == live_sock->fd) {
+				if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
+					ERR("Local live socket poll error");
+					goto error;
+				}
+				ret = accept_viewer(&events, &viewers);
+				if (ret) {
+					goto error;
+				}
+				continue;
+			}
+
+			cds_list_for_each_entry(viewer, &viewers, node) {
+				if (viewer->sock->fd == pollfd) {
+					found = viewer;
+					break;
+				}
+			}
+			if (!found) {
+				continue;
+			}
+
+			if (revents & LPOLLIN) {
+				struct lttng_viewer_cmd recv_hdr;
+
+				ret = found->sock->ops->recvmsg(found->sock,
+						&recv_hdr, sizeof(recv_hdr), 0);
+				if (ret <= 0 || process_control(found, &recv_hdr)) {
+					/* Connection closed or protocol error. */
+					live_viewer_destroy(&events, found);
+				}
+			} else if (revents & (LPOLLERR | LPOLLHUP | LPOLLRDHUP)) {
+				live_viewer_destroy(&events, found);
+			}
+		}
+	}
+
+exit:
+error:
+	cds_list_for_each_entry_safe(viewer, tmp, &viewers, node) {
+		live_viewer_destroy(&events, viewer);
+	}
+	lttng_poll_clean(&events);
+error_poll:
+	(void) live_sock->ops->close(live_sock);
+	lttcomm_destroy_sock(live_sock);
+	utils_close_pipe(live_quit_pipe);
+	if (err) {
+		health_error();
+		ERR("Health error occurred in %s", __func__);
+	}
+	DBG("Consumer local live thread exiting");
+	health_unregister(health_consumerd);
+	rcu_unregister_thread();
+	return NULL;
+}
+
+void consumer_live_thread_quit(void)
+{
+	ssize_t ret;
+	const char c = 'q';
+
+	ret = lttng_write(live_quit_pipe[1], &c, sizeof(c));
+	if (ret != sizeof(c)) {
+		PERROR("Failed to wake up the local live thread");
+	}
+}
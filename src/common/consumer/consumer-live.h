@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef CONSUMER_LIVE_H
+#define CONSUMER_LIVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <common/buffer-view.h>
+#include <common/uri.h>
+
+#include "consumer.h"
+
+/*
+ * Local live endpoint of the consumer daemon (see --live-url).
+ *
+ * The live viewer protocol is served directly by the consumer daemon for
+ * the live sessions which have a local output, without involving a relay
+ * daemon. The packets of the streams of those sessions are retained in
+ * memory, as they are consumed, up to a per-stream bound and handed to the
+ * viewers from there, along with the complete metadata of their traces.
+ *
+ * Only the channels using the mmap output are served.
+ */
+
+/*
+ * Create the endpoint's listening socket. Must be called before launching
+ * consumer_live_thread().
+ */
+int consumer_live_init(struct lttng_uri *uri);
+bool consumer_live_enabled(void);
+void *consumer_live_thread(void *data);
+void consumer_live_thread_quit(void);
+
+/* Commands of the session daemon. */
+void consumer_live_session_add(uint64_t session_id, const char *session_name,
+		const char *hostname, unsigned int live_timer);
+void consumer_live_session_close(uint64_t session_id);
+
+/*
+ * Stream hooks. The stream lock is held by the caller.
+ */
+void consumer_live_stream_add(struct lttng_consumer_stream *stream);
+void consumer_live_stream_close(struct lttng_consumer_stream *stream);
+/* Copy the contents of a sub-buffer while it is still owned. */
+void consumer_live_stream_append(struct lttng_consumer_stream *stream,
+		const struct lttng_buffer_view *buffer);
+/* Post-consumption callback publishing the packet with its index. */
+int consumer_live_stream_publish(struct lttng_consumer_stream *stream,
+		const struct stream_subbuffer *subbuffer,
+		struct lttng_consumer_local_data *ctx);
+void consumer_live_stream_beacon(struct lttng_consumer_stream *stream,
+		uint64_t timestamp_end, uint64_t ctf_stream_id);
+
+#endif /* CONSUMER_LIVE_H */
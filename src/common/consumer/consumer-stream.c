@@ -14,13 +14,16 @@
 #include <unistd.h>
 
 #include <common/common.h>
+#include <common/compat/fcntl.h>
 #include <common/index/index.h>
 #include <common/kernel-consumer/kernel-consumer.h>
 #include <common/relayd/relayd.h>
 #include <common/ust-consumer/ust-consumer.h>
 #include <common/utils.h>
 #include <common/consumer/consumer.h>
+#include <common/consumer/consumer-live.h>
 #include <common/consumer/consumer-timer.h>
+#include <common/consumer/consumer-writeback.h>
 #include <common/consumer/metadata-bucket.h>
 #include <common/kernel-ctl/kernel-ctl.h>
 
@@ -155,7 +158,7 @@ static ssize_t consumer_stream_consume_mmap(
 	const ssize_t written_bytes = lttng_consumer_on_read_subbuffer_mmap(
 			stream, &subbuffer->buffer.buffer, padding_size);
 
-	if (stream->net_seq_idx == -1ULL) {
+	if (!consumer_stream_is_streamed(stream)) {
 		/*
 		 * When writing on disk, check that only the subbuffer (no
 		 * padding) was written to disk.
@@ -221,16 +224,31 @@ static int consumer_stream_send_index(
 	off_t packet_offset = 0;
 	struct ctf_packet_index index = {};
 
+	const bool is_local = !consumer_stream_is_streamed(stream);
+	int ret;
+
 	/*
-	 * This is called after consuming the sub-buffer; substract the
-	 * effect this sub-buffer from the offset.
+	 * Each destination has its own index: the local one refers to the
+	 * packet's offset in the local output file while the relayd computes
+	 * the offset in its own copy.
 	 */
-	if (stream->net_seq_idx == (uint64_t) -1ULL) {
+	if (is_local || stream->out_fd >= 0) {
+		/*
+		 * This is called after consuming the sub-buffer; substract the
+		 * effect this sub-buffer from the offset.
+		 */
 		packet_offset = stream->out_fd_offset -
 				subbuffer->info.data.padded_subbuf_size;
+		ctf_packet_index_populate(&index, packet_offset, subbuffer);
+		/* Written by consumer_stream_commit_output(). */
+		ret = lttng_dynamic_array_add_element(&stream->pending_indexes,
+				&index);
+		if (ret || is_local) {
+			return ret;
+		}
 	}
 
-	ctf_packet_index_populate(&index, packet_offset, subbuffer);
+	ctf_packet_index_populate(&index, 0, subbuffer);
 	return consumer_stream_write_index(stream, &index);
 }
 
@@ -565,6 +583,7 @@ int post_consume_open_new_packet(struct lttng_consumer_stream *stream,
 	int ret = 0;
 
 	if (!stream->opened_packet_in_current_trace_chunk &&
+			!stream->skip_post_rotation_packet_open &&
 			stream->trace_chunk &&
 			!stream_is_rotating_to_null_chunk(stream)) {
 		const enum consumer_stream_open_packet_status status =
@@ -641,6 +660,8 @@ struct lttng_consumer_stream *consumer_stream_create(
 	stream->trace_chunk = trace_chunk;
 	stream->out_fd = -1;
 	stream->out_fd_offset = 0;
+	stream->writeout_offset = 0;
+	stream->writeback_offset = 0;
 	stream->output_written = 0;
 	stream->net_seq_idx = relayd_id;
 	stream->session_id = session_id;
@@ -705,6 +726,8 @@ struct lttng_consumer_stream *consumer_stream_create(
 
 	lttng_dynamic_array_init(&stream->read_subbuffer_ops.post_consume_cbs,
 			sizeof(post_consume_cb), NULL);
+	lttng_dynamic_array_init(&stream->pending_indexes,
+			sizeof(struct ctf_packet_index), NULL);
 
 	if (type == CONSUMER_CHANNEL_TYPE_METADATA) {
 		stream->read_subbuffer_ops.lock =
@@ -734,6 +757,18 @@ struct lttng_consumer_stream *consumer_stream_create(
 			goto error;
 		}
 
+		if (channel->is_live && consumer_live_enabled() &&
+				channel->output == CONSUMER_CHANNEL_MMAP) {
+			/* After the index op: the metadata is synced. */
+			ret = lttng_dynamic_array_add_element(
+					&stream->read_subbuffer_ops.post_consume_cbs,
+					&(post_consume_cb) { consumer_live_stream_publish });
+			if (ret) {
+				PERROR("Failed to add `local live publish` callback to stream's post consumption callbacks");
+				goto error;
+			}
+		}
+
 		stream->read_subbuffer_ops.lock = consumer_stream_data_lock_all;
 		stream->read_subbuffer_ops.unlock =
 				consumer_stream_data_unlock_all;
@@ -755,6 +790,7 @@ error:
 	rcu_read_unlock();
 	lttng_trace_chunk_put(stream->trace_chunk);
 	lttng_dynamic_array_reset(&stream->read_subbuffer_ops.post_consume_cbs);
+	lttng_dynamic_array_reset(&stream->pending_indexes);
 	free(stream);
 end:
 	if (alloc_ret) {
@@ -867,6 +903,9 @@ void consumer_stream_close(struct lttng_consumer_stream *stream)
 		assert(0);
 	}
 
+	(void) consumer_stream_commit_output(stream);
+	consumer_live_stream_close(stream);
+
 	/* Close output fd. Could be a socket or local file at this point. */
 	if (stream->out_fd >= 0) {
 		ret = close(stream->out_fd);
@@ -875,6 +914,7 @@ void consumer_stream_close(struct lttng_consumer_stream *stream)
 		}
 		stream->out_fd = -1;
 	}
+	stream->output_files_deferred = false;
 
 	if (stream->index_file) {
 		lttng_index_file_put(stream->index_file);
@@ -1067,6 +1107,7 @@ void consumer_stream_destroy(struct lttng_consumer_stream *stream,
 	lttng_trace_chunk_put(stream->trace_chunk);
 	stream->trace_chunk = NULL;
 	lttng_dynamic_array_reset(&stream->read_subbuffer_ops.post_consume_cbs);
+	lttng_dynamic_array_reset(&stream->pending_indexes);
 	consumer_stream_free(stream);
 }
 
@@ -1084,7 +1125,7 @@ int consumer_stream_write_index(struct lttng_consumer_stream *stream,
 	assert(element);
 
 	rcu_read_lock();
-	if (stream->net_seq_idx != (uint64_t) -1ULL) {
+	if (consumer_stream_is_streamed(stream)) {
 		struct consumer_relayd_sock_pair *relayd;
 		relayd = consumer_find_relayd(stream->net_seq_idx);
 		if (relayd) {
@@ -1127,13 +1168,23 @@ int consumer_stream_create_output_files(struct lttng_consumer_stream *stream,
 {
 	int ret;
 	enum lttng_trace_chunk_status chunk_status;
-	const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+	int flags = O_WRONLY | O_CREAT | O_TRUNC;
 	const mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP;
 	char stream_path[LTTNG_PATH_MAX];
 
 	ASSERT_LOCKED(stream->lock);
 	assert(stream->trace_chunk);
 
+	/*
+	 * Direct I/O is only used for data streams written from mmap'ed
+	 * buffers: their sub-buffers are page-aligned and written in whole,
+	 * which satisfies the alignment constraints of O_DIRECT.
+	 */
+	if (stream->chan->direct_io && !stream->metadata_flag &&
+			stream->chan->output == CONSUMER_CHANNEL_MMAP) {
+		flags |= O_DIRECT;
+	}
+
 	ret = utils_stream_file_path(stream->chan->pathname, stream->name,
 			stream->chan->tracefile_size,
 			stream->tracefile_count_current, NULL,
@@ -1142,6 +1193,12 @@ int consumer_stream_create_output_files(struct lttng_consumer_stream *stream,
 		goto end;
 	}
 
+	/* Flush what was consumed to the files being replaced. */
+	ret = consumer_stream_commit_output(stream);
+	if (ret) {
+		goto end;
+	}
+
 	if (stream->out_fd >= 0) {
 		ret = close(stream->out_fd);
 		if (ret < 0) {
@@ -1160,6 +1217,10 @@ int consumer_stream_create_output_files(struct lttng_consumer_stream *stream,
 		ret = -1;
 		goto end;
 	}
+	stream->out_fd_direct_io = !!(flags & O_DIRECT);
+	if (stream->net_seq_idx != (uint64_t) -1ULL) {
+		CMM_STORE_SHARED(stream->has_local_copy, true);
+	}
 
 	if (!stream->metadata_flag && (create_index || stream->index_file)) {
 		if (stream->index_file) {
@@ -1182,6 +1243,85 @@ int consumer_stream_create_output_files(struct lttng_consumer_stream *stream,
 	/* Reset current size because we just perform a rotation. */
 	stream->tracefile_size_current = 0;
 	stream->out_fd_offset = 0;
+	stream->writeout_offset = 0;
+	stream->writeback_offset = 0;
+	stream->output_files_deferred = false;
+end:
+	return ret;
+}
+
+int consumer_stream_defer_output_files(struct lttng_consumer_stream *stream)
+{
+	int ret = 0;
+
+	ASSERT_LOCKED(stream->lock);
+	assert(stream->trace_chunk);
+	assert(stream->out_fd < 0 && !stream->index_file);
+
+	if (stream->metadata_flag) {
+		ret = consumer_stream_create_output_files(stream, false);
+		goto end;
+	}
+
+	DBG("Deferring the creation of the output files of stream \"%s\"",
+			stream->name);
+	stream->tracefile_size_current = 0;
+	stream->output_files_deferred = true;
+	if (stream->net_seq_idx != (uint64_t) -1ULL) {
+		CMM_STORE_SHARED(stream->has_local_copy, true);
+	}
+end:
+	return ret;
+}
+
+int consumer_stream_open_deferred_output_files(
+		struct lttng_consumer_stream *stream)
+{
+	int ret = 0;
+
+	if (!stream->output_files_deferred) {
+		goto end;
+	}
+
+	assert(stream->trace_chunk);
+	DBG("Creating the deferred output files of stream \"%s\"",
+			stream->name);
+	ret = consumer_stream_create_output_files(stream, true);
+end:
+	return ret;
+}
+
+int consumer_stream_commit_output(struct lttng_consumer_stream *stream)
+{
+	int ret = 0;
+	const size_t index_count =
+			lttng_dynamic_array_get_count(&stream->pending_indexes);
+
+	if (stream->out_fd >= 0 &&
+			stream->out_fd_offset > stream->writeout_offset) {
+		/* This won't block, but will start writeout asynchronously */
+		lttng_sync_file_range(stream->out_fd, stream->writeout_offset,
+				stream->out_fd_offset - stream->writeout_offset,
+				SYNC_FILE_RANGE_WRITE);
+		stream->writeout_offset = stream->out_fd_offset;
+		consumer_writeback_submit(stream);
+	}
+
+	if (index_count == 0) {
+		goto end;
+	}
+
+	assert(stream->index_file);
+	ret = lttng_index_file_write_batch(stream->index_file,
+			lttng_dynamic_array_get_element(
+					&stream->pending_indexes, 0),
+			index_count);
+	lttng_dynamic_array_clear(&stream->pending_indexes);
+	if (ret) {
+		ERR("Failed to write %zu indexes of stream %" PRIu64,
+				index_count, stream->key);
+		ret = -1;
+	}
 end:
 	return ret;
 }
@@ -1206,6 +1346,34 @@ end:
 	return ret;
 }
 
+bool consumer_stream_is_streamed(const struct lttng_consumer_stream *stream)
+{
+	return stream->net_seq_idx != (uint64_t) -1ULL && !stream->relayd_lost;
+}
+
+bool consumer_stream_has_local_output(struct lttng_consumer_stream *stream)
+{
+	const struct lttng_directory_handle *chunk_directory;
+
+	if (!consumer_stream_is_streamed(stream)) {
+		return true;
+	}
+
+	/*
+	 * Only sub-buffers read from a mapping can be written to several
+	 * destinations; spliced data can only be moved once. The session
+	 * daemon refuses to configure a local copy for spliced channels.
+	 */
+	if (stream->chan->output != CONSUMER_CHANNEL_MMAP ||
+			!stream->trace_chunk) {
+		return false;
+	}
+
+	return lttng_trace_chunk_borrow_chunk_directory_handle(
+			stream->trace_chunk, &chunk_directory) ==
+			LTTNG_TRACE_CHUNK_STATUS_OK;
+}
+
 bool consumer_stream_is_deleted(struct lttng_consumer_stream *stream)
 {
 	/*
@@ -91,6 +91,32 @@ int consumer_stream_write_index(struct lttng_consumer_stream *stream,
 int consumer_stream_sync_metadata(struct lttng_consumer_local_data *ctx,
 		uint64_t session_id);
 
+/*
+ * Start the writeout of the data written to the output file of a local stream
+ * since the last call and write the indexes of the packets it contains.
+ *
+ * This must be called with the stream's lock held.
+ *
+ * Return 0 on success or else a negative value.
+ */
+int consumer_stream_commit_output(struct lttng_consumer_stream *stream);
+
+/*
+ * Indicates whether or not the data of a stream is sent to a relayd.
+ *
+ * This must be called with the stream's lock held.
+ */
+bool consumer_stream_is_streamed(const struct lttng_consumer_stream *stream);
+
+/*
+ * Indicates whether or not the data of a stream is written to local output
+ * files, either because it is a local stream or because it is streamed to a
+ * relayd and its trace chunk also has a local output directory.
+ *
+ * This must be called with the stream's lock held.
+ */
+bool consumer_stream_has_local_output(struct lttng_consumer_stream *stream);
+
 /*
  * Create the output files of a local stream.
  *
@@ -99,6 +125,25 @@ int consumer_stream_sync_metadata(struct lttng_consumer_local_data *ctx,
 int consumer_stream_create_output_files(struct lttng_consumer_stream *stream,
 		bool create_index);
 
+/*
+ * Defer the creation of the output files of a local data stream, and of its
+ * index, until its first packet of the current trace chunk is written so
+ * that idle streams don't produce empty files. The output files of metadata
+ * streams, which are rewritten in every trace chunk, are created immediately.
+ *
+ * This must be called with the channel's and the stream's lock held.
+ */
+int consumer_stream_defer_output_files(struct lttng_consumer_stream *stream);
+
+/*
+ * Create the output files of a stream if their creation was deferred. Called
+ * before writing a packet to the local output files.
+ *
+ * This must be called with the channel's and the stream's lock held.
+ */
+int consumer_stream_open_deferred_output_files(
+		struct lttng_consumer_stream *stream);
+
 /*
  * Rotate the output files of a local stream. This will change the
  * active output files of both the binary and index in accordance
@@ -16,9 +16,12 @@
 #include <common/compat/endian.h>
 #include <common/kernel-ctl/kernel-ctl.h>
 #include <common/kernel-consumer/kernel-consumer.h>
+#include <common/consumer/consumer-live.h>
 #include <common/consumer/consumer-stream.h>
 #include <common/consumer/consumer-timer.h>
 #include <common/consumer/consumer-testpoint.h>
+#include <common/dynamic-array.h>
+#include <common/relayd/relayd.h>
 #include <common/ust-consumer/ust-consumer.h>
 
 typedef int (*sample_positions_cb)(struct lttng_consumer_stream *stream);
@@ -26,7 +29,8 @@ typedef int (*get_consumed_cb)(struct lttng_consumer_stream *stream,
 		unsigned long *consumed);
 typedef int (*get_produced_cb)(struct lttng_consumer_stream *stream,
 		unsigned long *produced);
-typedef int (*flush_index_cb)(struct lttng_consumer_stream *stream);
+typedef int (*flush_index_cb)(struct lttng_consumer_stream *stream,
+		struct lttng_dynamic_array *beacons);
 
 static struct timer_signal_data timer_signal = {
 	.tid = 0,
@@ -120,12 +124,38 @@ static void metadata_switch_timer(struct lttng_consumer_local_data *ctx,
 	}
 }
 
+/*
+ * Send the live beacon of an idle stream or, if `beacons` is not NULL, queue
+ * it to be sent along with the beacons of the other idle streams of the
+ * channel.
+ */
 static int send_empty_index(struct lttng_consumer_stream *stream, uint64_t ts,
-		uint64_t stream_id)
+		uint64_t stream_id, struct lttng_dynamic_array *beacons)
 {
 	int ret;
 	struct ctf_packet_index index;
 
+	if (stream->live_stream) {
+		/* Local live streams have no index to write the beacon to. */
+		consumer_live_stream_beacon(stream, ts, stream_id);
+		ret = 0;
+		goto error;
+	}
+
+	if (beacons) {
+		const struct lttcomm_relayd_beacon beacon = {
+			.relay_stream_id = stream->relayd_stream_id,
+			.net_seq_num = stream->next_net_seq_num - 1,
+			.timestamp_end = ts,
+		};
+
+		ret = lttng_dynamic_array_add_element(beacons, &beacon);
+		if (ret) {
+			ret = -1;
+		}
+		goto error;
+	}
+
 	memset(&index, 0, sizeof(index));
 	index.stream_id = htobe64(stream_id);
 	index.timestamp_end = htobe64(ts);
@@ -138,7 +168,8 @@ error:
 	return ret;
 }
 
-int consumer_flush_kernel_index(struct lttng_consumer_stream *stream)
+static int flush_kernel_index(struct lttng_consumer_stream *stream,
+		struct lttng_dynamic_array *beacons)
 {
 	uint64_t ts, stream_id;
 	int ret;
@@ -166,7 +197,7 @@ int consumer_flush_kernel_index(struct lttng_consumer_stream *stream)
 			goto end;
 		}
 		DBG("Stream %" PRIu64 " empty, sending beacon", stream->key);
-		ret = send_empty_index(stream, ts, stream_id);
+		ret = send_empty_index(stream, ts, stream_id, beacons);
 		if (ret < 0) {
 			goto end;
 		}
@@ -177,7 +208,7 @@ end:
 }
 
 static int check_stream(struct lttng_consumer_stream *stream,
-		flush_index_cb flush_index)
+		flush_index_cb flush_index, struct lttng_dynamic_array *beacons)
 {
 	int ret;
 
@@ -216,13 +247,14 @@ static int check_stream(struct lttng_consumer_stream *stream,
 		}
 		break;
 	}
-	ret = flush_index(stream);
+	ret = flush_index(stream, beacons);
 	pthread_mutex_unlock(&stream->lock);
 end:
 	return ret;
 }
 
-int consumer_flush_ust_index(struct lttng_consumer_stream *stream)
+static int flush_ust_index(struct lttng_consumer_stream *stream,
+		struct lttng_dynamic_array *beacons)
 {
 	uint64_t ts, stream_id;
 	int ret;
@@ -251,7 +283,7 @@ int consumer_flush_ust_index(struct lttng_consumer_stream *stream)
 			goto end;
 		}
 		DBG("Stream %" PRIu64 " empty, sending beacon", stream->key);
-		ret = send_empty_index(stream, ts, stream_id);
+		ret = send_empty_index(stream, ts, stream_id, beacons);
 		if (ret < 0) {
 			goto end;
 		}
@@ -261,6 +293,75 @@ end:
 	return ret;
 }
 
+int consumer_flush_kernel_index(struct lttng_consumer_stream *stream)
+{
+	return flush_kernel_index(stream, NULL);
+}
+
+int consumer_flush_ust_index(struct lttng_consumer_stream *stream)
+{
+	return flush_ust_index(stream, NULL);
+}
+
+/*
+ * Send the queued live beacons of the idle streams of a channel in a single
+ * command.
+ *
+ * The RCU read-side lock must be held by the caller.
+ */
+static int send_beacons(uint64_t relayd_id,
+		const struct lttng_dynamic_array *beacons)
+{
+	int ret = 0;
+	struct consumer_relayd_sock_pair *relayd;
+	const size_t beacon_count = lttng_dynamic_array_get_count(beacons);
+
+	if (beacon_count == 0) {
+		goto end;
+	}
+
+	relayd = consumer_find_relayd(relayd_id);
+	if (!relayd) {
+		ERR("Relayd ID %" PRIu64 " unknown. Can't send live beacons.",
+				relayd_id);
+		ret = -1;
+		goto end;
+	}
+
+	pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+	ret = relayd_send_beacons(&relayd->control_sock,
+			lttng_dynamic_array_get_element(beacons, 0),
+			(unsigned int) beacon_count);
+	if (ret < 0) {
+		/*
+		 * Communication error with lttng-relayd,
+		 * perform cleanup now
+		 */
+		ERR("Relayd send beacons failed. Cleaning up relayd %" PRIu64 ".",
+				relayd->net_seq_idx);
+		lttng_consumer_cleanup_relayd(relayd);
+		ret = -1;
+	}
+	pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+end:
+	return ret;
+}
+
+/*
+ * Return true if the live beacons of the channel's idle streams can be sent
+ * in a single command.
+ *
+ * The RCU read-side lock must be held by the caller.
+ */
+static bool channel_batches_beacons(
+		const struct lttng_consumer_channel *channel)
+{
+	struct consumer_relayd_sock_pair *relayd;
+
+	relayd = consumer_find_relayd(channel->relayd_id);
+	return relayd && relayd_supports_send_beacons(&relayd->control_sock);
+}
+
 /*
  * Execute action on a live timer
  */
@@ -272,10 +373,14 @@ static void live_timer(struct lttng_consumer_local_data *ctx,
 	struct lttng_consumer_stream *stream;
 	struct lttng_ht_iter iter;
 	const struct lttng_ht *ht = consumer_data.stream_per_chan_id_ht;
+	struct lttng_dynamic_array beacons, *batch = NULL;
 	const flush_index_cb flush_index =
 			ctx->type == LTTNG_CONSUMER_KERNEL ?
-					consumer_flush_kernel_index :
-					consumer_flush_ust_index;
+					flush_kernel_index :
+					flush_ust_index;
+
+	lttng_dynamic_array_init(&beacons,
+			sizeof(struct lttcomm_relayd_beacon), NULL);
 
 	channel = si->si_value.sival_ptr;
 	assert(channel);
@@ -287,20 +392,32 @@ static void live_timer(struct lttng_consumer_local_data *ctx,
 	DBG("Live timer for channel %" PRIu64, channel->key);
 
 	rcu_read_lock();
+	/*
+	 * Send the beacons of all the idle streams of the channel at once so
+	 * that the cost of an idle stream does not depend on the number of
+	 * streams.
+	 */
+	if (channel_batches_beacons(channel)) {
+		batch = &beacons;
+	}
+
 	cds_lfht_for_each_entry_duplicate(ht->ht,
 			ht->hash_fct(&channel->key, lttng_ht_seed),
 			ht->match_fct, &channel->key, &iter.iter,
 			stream, node_channel_id.node) {
-		ret = check_stream(stream, flush_index);
+		ret = check_stream(stream, flush_index, batch);
 		if (ret < 0) {
 			goto error_unlock;
 		}
 	}
 
+	(void) send_beacons(channel->relayd_id, &beacons);
+
 error_unlock:
 	rcu_read_unlock();
 
 error:
+	lttng_dynamic_array_reset(&beacons);
 	return;
 }
 
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <fcntl.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <urcu/futex.h>
+#include <urcu/uatomic.h>
+#include <urcu/wfcqueue.h>
+
+#include <bin/lttng-consumerd/health-consumerd.h>
+#include <common/common.h>
+#include <common/compat/fcntl.h>
+#include <common/futex.h>
+
+#include "consumer-writeback.h"
+
+/*
+ * Output file range waited on and evicted from the page cache by the
+ * writeback thread. The file descriptor is a duplicate of the stream's
+ * output file descriptor so that the range outlives a tracefile rotation or
+ * the teardown of the stream.
+ */
+struct writeback_range {
+	int fd;
+	off_t offset;
+	off_t len;
+	struct cds_wfcq_node node;
+};
+
+static struct {
+	struct cds_wfcq_head head;
+	struct cds_wfcq_tail tail;
+	int32_t futex;
+	/* Number of ranges queued and not yet processed. */
+	unsigned long pending;
+	int quit;
+} writeback_queue = {
+	.futex = 0,
+	.pending = 0,
+	.quit = 0,
+};
+
+static void writeback_range_destroy(struct writeback_range *range)
+{
+	if (close(range->fd)) {
+		PERROR("Failed to close writeback range file descriptor");
+	}
+	free(range);
+}
+
+/*
+ * Wait for the range to reach the disk and drop it from the page cache.
+ *
+ * Don't care about error values, as these are just hints and ways to limit
+ * the amount of page cache used.
+ */
+static void writeback_range_process(struct writeback_range *range)
+{
+	int ret;
+
+	lttng_sync_file_range(range->fd, range->offset, range->len,
+			SYNC_FILE_RANGE_WAIT_BEFORE
+			| SYNC_FILE_RANGE_WRITE
+			| SYNC_FILE_RANGE_WAIT_AFTER);
+	/*
+	 * Give hints to the kernel about how we access the file:
+	 * POSIX_FADV_DONTNEED : we won't re-access data in a near future after
+	 * we write it.
+	 *
+	 * Call fadvise _after_ having waited for the page writeback to
+	 * complete because the dirty page writeback semantic is not well
+	 * defined.
+	 */
+	ret = posix_fadvise(range->fd, range->offset, range->len,
+			POSIX_FADV_DONTNEED);
+	if (ret && ret != -ENOSYS) {
+		errno = ret;
+		PERROR("posix_fadvise on fd %i", range->fd);
+	}
+}
+
+void consumer_writeback_init(void)
+{
+	cds_wfcq_init(&writeback_queue.head, &writeback_queue.tail);
+}
+
+void consumer_writeback_submit(struct lttng_consumer_stream *stream)
+{
+	off_t window, end;
+	struct writeback_range *range;
+
+	if (stream->out_fd < 0 || stream->out_fd_direct_io) {
+		return;
+	}
+
+	window = stream->chan->writeback_window_size ?
+			(off_t) stream->chan->writeback_window_size :
+			(off_t) stream->max_sb_size;
+
+	/*
+	 * Only submit once a full window fell out of the window of data left
+	 * in flight to amortize the cost of a submission.
+	 */
+	if (stream->out_fd_offset - stream->writeback_offset < 2 * window) {
+		return;
+	}
+
+	/*
+	 * Let ranges coalesce when the writeback thread is lagging behind
+	 * rather than accumulating file descriptors.
+	 */
+	if (uatomic_read(&writeback_queue.pending) >=
+			DEFAULT_CONSUMER_WRITEBACK_MAX_PENDING) {
+		return;
+	}
+
+	end = stream->out_fd_offset - window;
+	range = zmalloc(sizeof(*range));
+	if (!range) {
+		PERROR("zmalloc writeback range");
+		return;
+	}
+
+	range->fd = dup(stream->out_fd);
+	if (range->fd < 0) {
+		PERROR("Failed to duplicate output file descriptor of stream %" PRIu64,
+				stream->key);
+		free(range);
+		return;
+	}
+	range->offset = stream->writeback_offset;
+	range->len = end - stream->writeback_offset;
+	cds_wfcq_node_init(&range->node);
+	stream->writeback_offset = end;
+
+	uatomic_inc(&writeback_queue.pending);
+	cds_wfcq_enqueue(&writeback_queue.head, &writeback_queue.tail,
+			&range->node);
+	/*
+	 * Wake the writeback thread. Memory ordering is ensured by the
+	 * implicit memory barrier of the atomic exchange in cds_wfcq_enqueue.
+	 */
+	futex_nto1_wake(&writeback_queue.futex);
+}
+
+/*
+ * Process every range currently queued. Ranges are only closed, without
+ * waiting on the disk, when the thread is exiting.
+ */
+static void writeback_queue_drain(bool process)
+{
+	struct cds_wfcq_node *node;
+
+	while ((node = cds_wfcq_dequeue_blocking(&writeback_queue.head,
+			&writeback_queue.tail))) {
+		struct writeback_range *range = caa_container_of(node,
+				struct writeback_range, node);
+
+		health_code_update();
+		if (process) {
+			writeback_range_process(range);
+		}
+		writeback_range_destroy(range);
+		uatomic_dec(&writeback_queue.pending);
+	}
+}
+
+void *consumer_writeback_thread(void *data)
+{
+	rcu_register_thread();
+
+	health_register(health_consumerd, HEALTH_CONSUMERD_TYPE_WRITEBACK);
+
+	DBG("Consumer writeback thread started");
+
+	for (;;) {
+		health_code_update();
+
+		/* Atomically prepare the queue futex */
+		futex_nto1_prepare(&writeback_queue.futex);
+
+		if (CMM_LOAD_SHARED(writeback_queue.quit)) {
+			break;
+		}
+
+		writeback_queue_drain(true);
+
+		/* Futex wait on queue. Blocking call on futex() */
+		health_poll_entry();
+		futex_nto1_wait(&writeback_queue.futex);
+		health_poll_exit();
+	}
+
+	writeback_queue_drain(false);
+
+	DBG("Consumer writeback thread exiting");
+	health_unregister(health_consumerd);
+	rcu_unregister_thread();
+	return NULL;
+}
+
+void consumer_writeback_thread_quit(void)
+{
+	CMM_STORE_SHARED(writeback_queue.quit, 1);
+	futex_nto1_wake(&writeback_queue.futex);
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef CONSUMER_WRITEBACK_H
+#define CONSUMER_WRITEBACK_H
+
+#include "consumer.h"
+
+/* Initialize the writeback queue. Must be called before any submission. */
+void consumer_writeback_init(void);
+
+/*
+ * Hand the output file range of a stream that fell out of its channel's
+ * writeback window to the writeback thread.
+ *
+ * Called by the data and metadata threads after writing to a local output
+ * file. This never waits on the disk.
+ */
+void consumer_writeback_submit(struct lttng_consumer_stream *stream);
+
+/*
+ * Writeback thread: waits for the submitted ranges to reach the disk and
+ * evicts them from the page cache.
+ */
+void *consumer_writeback_thread(void *data);
+
+/*
+ * Ask the writeback thread to exit once it has processed the ranges already
+ * submitted. No range may be submitted after this call.
+ */
+void consumer_writeback_thread_quit(void);
+
+#endif /* CONSUMER_WRITEBACK_H */
@@ -34,7 +34,9 @@
 #include <common/kernel-consumer/kernel-consumer.h>
 #include <common/relayd/relayd.h>
 #include <common/ust-consumer/ust-consumer.h>
+#include <common/consumer/consumer-live.h>
 #include <common/consumer/consumer-timer.h>
+#include <common/consumer/consumer-writeback.h>
 #include <common/consumer/consumer.h>
 #include <common/consumer/consumer-stream.h>
 #include <common/consumer/consumer-testpoint.h>
@@ -74,6 +76,25 @@ int data_consumption_paused;
  */
 int consumer_quit;
 
+/*
+ * Command worker serving an additional command socket of the session daemon.
+ * The worker is the only reader and writer of its socket, so each command is
+ * read and replied to as a whole.
+ */
+struct consumer_command_worker {
+	pthread_t thread;
+	int sock;
+	struct lttng_consumer_local_data *ctx;
+	struct cds_list_head node;
+};
+
+/*
+ * Command workers, joined by the sessiond poll thread before it asks the
+ * other threads to quit.
+ */
+static CDS_LIST_HEAD(command_workers);
+static pthread_mutex_t command_workers_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Global hash table containing respectively metadata and data streams. The
  * stream element in this ht should only be updated by the metadata poll thread
@@ -463,7 +484,8 @@ static void update_endpoint_status_by_netidx(uint64_t net_seq_idx,
 
 	/* Let's begin with metadata */
 	cds_lfht_for_each_entry(metadata_ht->ht, &iter.iter, stream, node.node) {
-		if (stream->net_seq_idx == net_seq_idx) {
+		if (stream->net_seq_idx == net_seq_idx &&
+				!CMM_LOAD_SHARED(stream->has_local_copy)) {
 			uatomic_set(&stream->endpoint_status, status);
 			DBG("Delete flag set to metadata stream %d", stream->wait_fd);
 		}
@@ -471,7 +493,8 @@ static void update_endpoint_status_by_netidx(uint64_t net_seq_idx,
 
 	/* Follow up by the data streams */
 	cds_lfht_for_each_entry(data_ht->ht, &iter.iter, stream, node.node) {
-		if (stream->net_seq_idx == net_seq_idx) {
+		if (stream->net_seq_idx == net_seq_idx &&
+				!CMM_LOAD_SHARED(stream->has_local_copy)) {
 			uatomic_set(&stream->endpoint_status, status);
 			DBG("Delete flag set to data stream %d", stream->wait_fd);
 		}
@@ -504,7 +527,10 @@ void lttng_consumer_cleanup_relayd(struct consumer_relayd_sock_pair *relayd)
 	 */
 	consumer_destroy_relayd(relayd);
 
-	/* Set inactive endpoint to all streams */
+	/*
+	 * Set inactive endpoint to all streams, except those having a local
+	 * copy: they switch to their local output on their next read.
+	 */
 	update_endpoint_status_by_netidx(netidx, CONSUMER_ENDPOINT_INACTIVE);
 
 	/*
@@ -619,6 +645,8 @@ void consumer_add_data_stream(struct lttng_consumer_stream *stream)
 	consumer_data.stream_count++;
 	consumer_data.need_update = 1;
 
+	consumer_live_stream_add(stream);
+
 	rcu_read_unlock();
 	pthread_mutex_unlock(&stream->lock);
 	pthread_mutex_unlock(&stream->chan->timer_lock);
@@ -760,6 +788,95 @@ end:
 	return ret;
 }
 
+/*
+ * Send all the streams of a channel that are not yet sent to the sessiond,
+ * i.e. linked on the channel's "send" list, to the relayd in a single batch.
+ *
+ * Only the UST consumer uses this: it receives all the streams of a channel
+ * before handing them to the data threads. The kernel consumer hands each
+ * stream to the data threads as soon as it is received, and a stream must
+ * be known to the relayd before its first packet, so it keeps announcing
+ * its streams one at a time.
+ *
+ * Returns 0 on success, < 0 on error
+ */
+int consumer_send_relayd_channel_streams(struct lttng_consumer_channel *channel,
+		char *path)
+{
+	int ret = 0;
+	unsigned int i, stream_count = 0;
+	const char **stream_names = NULL;
+	uint64_t *stream_ids = NULL;
+	struct lttng_consumer_stream *stream, *first_stream;
+	struct consumer_relayd_sock_pair *relayd;
+
+	assert(channel);
+	assert(path);
+
+	cds_list_for_each_entry(stream, &channel->streams.head, send_node) {
+		stream_count++;
+	}
+	if (stream_count == 0) {
+		goto end_no_rcu;
+	}
+
+	stream_names = zmalloc(sizeof(*stream_names) * stream_count);
+	stream_ids = zmalloc(sizeof(*stream_ids) * stream_count);
+	if (!stream_names || !stream_ids) {
+		PERROR("zmalloc relayd streams batch");
+		ret = -1;
+		goto end_no_rcu;
+	}
+
+	i = 0;
+	cds_list_for_each_entry(stream, &channel->streams.head, send_node) {
+		stream_names[i++] = stream->name;
+	}
+	first_stream = cds_list_first_entry(&channel->streams.head,
+			struct lttng_consumer_stream, send_node);
+	assert(first_stream->net_seq_idx != -1ULL);
+
+	rcu_read_lock();
+	relayd = consumer_find_relayd(first_stream->net_seq_idx);
+	if (!relayd) {
+		ERR("Channel %" PRIu64 " relayd ID %" PRIu64 " unknown. Can't send its streams.",
+				channel->key, first_stream->net_seq_idx);
+		ret = -1;
+		goto end;
+	}
+
+	/* Add the streams on the relayd. */
+	pthread_mutex_lock(&relayd->ctrl_sock_mutex);
+	ret = relayd_add_streams(&relayd->control_sock, stream_names,
+			stream_count, get_consumer_domain(), path, stream_ids,
+			channel->tracefile_size, channel->tracefile_count,
+			first_stream->trace_chunk);
+	pthread_mutex_unlock(&relayd->ctrl_sock_mutex);
+	if (ret < 0) {
+		ERR("Relayd add streams failed. Cleaning up relayd %" PRIu64".", relayd->net_seq_idx);
+		lttng_consumer_cleanup_relayd(relayd);
+		goto end;
+	}
+
+	i = 0;
+	cds_list_for_each_entry(stream, &channel->streams.head, send_node) {
+		stream->relayd_stream_id = stream_ids[i++];
+		uatomic_inc(&relayd->refcount);
+		stream->sent_to_relayd = 1;
+	}
+
+	DBG("%u streams of channel %s with key %" PRIu64 " sent to relayd id %" PRIu64,
+			stream_count, channel->name, channel->key,
+			first_stream->net_seq_idx);
+
+end:
+	rcu_read_unlock();
+end_no_rcu:
+	free(stream_names);
+	free(stream_ids);
+	return ret;
+}
+
 /*
  * Find a relayd and send the streams sent message
  *
@@ -1350,52 +1467,6 @@ void lttng_consumer_should_exit(struct lttng_consumer_local_data *ctx)
 }
 
 
-/*
- * Flush pending writes to trace output disk file.
- */
-static
-void lttng_consumer_sync_trace_file(struct lttng_consumer_stream *stream,
-		off_t orig_offset)
-{
-	int ret;
-	int outfd = stream->out_fd;
-
-	/*
-	 * This does a blocking write-and-wait on any page that belongs to the
-	 * subbuffer prior to the one we just wrote.
-	 * Don't care about error values, as these are just hints and ways to
-	 * limit the amount of page cache used.
-	 */
-	if (orig_offset < stream->max_sb_size) {
-		return;
-	}
-	lttng_sync_file_range(outfd, orig_offset - stream->max_sb_size,
-			stream->max_sb_size,
-			SYNC_FILE_RANGE_WAIT_BEFORE
-			| SYNC_FILE_RANGE_WRITE
-			| SYNC_FILE_RANGE_WAIT_AFTER);
-	/*
-	 * Give hints to the kernel about how we access the file:
-	 * POSIX_FADV_DONTNEED : we won't re-access data in a near future after
-	 * we write it.
-	 *
-	 * We need to call fadvise again after the file grows because the
-	 * kernel does not seem to apply fadvise to non-existing parts of the
-	 * file.
-	 *
-	 * Call fadvise _after_ having waited for the page writeback to
-	 * complete because the dirty page writeback semantic is not well
-	 * defined. So it can be expected to lead to lower throughput in
-	 * streaming.
-	 */
-	ret = posix_fadvise(outfd, orig_offset - stream->max_sb_size,
-			stream->max_sb_size, POSIX_FADV_DONTNEED);
-	if (ret && ret != -ENOSYS) {
-		errno = ret;
-		PERROR("posix_fadvise on fd %i", outfd);
-	}
-}
-
 /*
  * Initialise the necessary environnement :
  * - create a new context
@@ -1608,6 +1679,46 @@ end:
 	return (int) ret;
 }
 
+/*
+ * Write a sub-buffer, padding included, to the local output file of a stream
+ * which is also streamed to a relayd.
+ *
+ * Return 0 on success or else a negative value.
+ */
+static int write_local_subbuffer_copy(struct lttng_consumer_stream *stream,
+		const struct lttng_buffer_view *buffer)
+{
+	ssize_t ret;
+
+	ret = consumer_stream_open_deferred_output_files(stream);
+	if (ret) {
+		goto end;
+	}
+
+	if (stream->chan->tracefile_size > 0 &&
+			(stream->tracefile_size_current + buffer->size) >
+			stream->chan->tracefile_size) {
+		ret = consumer_stream_rotate_output_files(stream);
+		if (ret) {
+			goto end;
+		}
+	}
+
+	ret = lttng_write(stream->out_fd, buffer->data, buffer->size);
+	if (ret < 0 || (size_t) ret != buffer->size) {
+		PERROR("Failed to write sub-buffer to the local output file of stream %" PRIu64,
+				stream->key);
+		ret = -1;
+		goto end;
+	}
+	stream->tracefile_size_current += buffer->size;
+	stream->out_fd_offset += buffer->size;
+	stream->local_packet_count++;
+	ret = 0;
+end:
+	return ret;
+}
+
 /*
  * Mmap the ring buffer, read it and write the data to the tracefile. This is a
  * core function for writing trace buffers to either the local filesystem or
@@ -1625,7 +1736,6 @@ ssize_t lttng_consumer_on_read_subbuffer_mmap(
 		unsigned long padding)
 {
 	ssize_t ret = 0;
-	off_t orig_offset = stream->out_fd_offset;
 	/* Default is on the disk */
 	int outfd = stream->out_fd;
 	struct consumer_relayd_sock_pair *relayd = NULL;
@@ -1635,13 +1745,18 @@ ssize_t lttng_consumer_on_read_subbuffer_mmap(
 
 	/* RCU lock for the relayd pointer */
 	rcu_read_lock();
-	assert(stream->net_seq_idx != (uint64_t) -1ULL ||
-			stream->trace_chunk);
+	assert(consumer_stream_is_streamed(stream) || stream->trace_chunk);
 
 	/* Flag that the current stream if set for network streaming. */
-	if (stream->net_seq_idx != (uint64_t) -1ULL) {
+	if (consumer_stream_is_streamed(stream)) {
 		relayd = consumer_find_relayd(stream->net_seq_idx);
-		if (relayd == NULL) {
+		if (relayd == NULL && stream->has_local_copy &&
+				stream->trace_chunk) {
+			/* The relayd is gone; only the local copy is left. */
+			DBG("Relayd %" PRIu64 " of stream %" PRIu64 " is gone, writing to its local copy only",
+					stream->net_seq_idx, stream->key);
+			stream->relayd_lost = true;
+		} else if (relayd == NULL) {
 			ret = -EPIPE;
 			goto end;
 		}
@@ -1666,6 +1781,14 @@ ssize_t lttng_consumer_on_read_subbuffer_mmap(
 					relayd_hang_up = 1;
 					goto write_error;
 				}
+				if (stream->out_fd >= 0) {
+					ret = utils_truncate_stream_file(
+							stream->out_fd, 0);
+					if (ret < 0) {
+						ERR("Reset local metadata file");
+						goto end;
+					}
+				}
 				stream->reset_metadata_flag = 0;
 			}
 			netlen += sizeof(struct lttcomm_relayd_metadata_payload);
@@ -1691,6 +1814,12 @@ ssize_t lttng_consumer_on_read_subbuffer_mmap(
 		write_len = subbuf_content_size;
 	} else {
 		/* No streaming; we have to write the full padding. */
+		ret = consumer_stream_open_deferred_output_files(stream);
+		if (ret) {
+			goto end;
+		}
+		outfd = stream->out_fd;
+
 		if (stream->metadata_flag && stream->reset_metadata_flag) {
 			ret = utils_truncate_stream_file(stream->out_fd, 0);
 			if (ret < 0) {
@@ -1711,7 +1840,6 @@ ssize_t lttng_consumer_on_read_subbuffer_mmap(
 				goto end;
 			}
 			outfd = stream->out_fd;
-			orig_offset = 0;
 		}
 		stream->tracefile_size_current += buffer->size;
 		write_len = buffer->size;
@@ -1751,13 +1879,27 @@ ssize_t lttng_consumer_on_read_subbuffer_mmap(
 	}
 	stream->output_written += ret;
 
-	/* This call is useless on a socket so better save a syscall. */
+	/* Copied while the sub-buffer is still owned by the consumer. */
+	consumer_live_stream_append(stream, buffer);
+
+	/*
+	 * The writeout of the data is started by
+	 * consumer_stream_commit_output() once the stream is drained.
+	 */
 	if (!relayd) {
-		/* This won't block, but will start writeout asynchronously */
-		lttng_sync_file_range(outfd, stream->out_fd_offset, write_len,
-				SYNC_FILE_RANGE_WRITE);
 		stream->out_fd_offset += write_len;
-		lttng_consumer_sync_trace_file(stream, orig_offset);
+		stream->local_packet_count++;
+	} else if (stream->out_fd >= 0 || stream->output_files_deferred) {
+		/*
+		 * The sub-buffer is written once more, from the same mapping,
+		 * to the local copy of the stream.
+		 */
+		const int local_ret = write_local_subbuffer_copy(stream, buffer);
+
+		if (local_ret) {
+			ret = local_ret;
+			goto end;
+		}
 	}
 
 write_error:
@@ -1768,6 +1910,32 @@ write_error:
 	if (relayd && relayd_hang_up) {
 		ERR("Relayd hangup. Cleaning up relayd %" PRIu64".", relayd->net_seq_idx);
 		lttng_consumer_cleanup_relayd(relayd);
+
+		/*
+		 * The streams having a local copy outlive their relayd: the
+		 * sub-buffer which could not be sent is still written locally
+		 * and the stream is only written locally from now on.
+		 */
+		if (stream->has_local_copy && (stream->out_fd >= 0 ||
+				stream->output_files_deferred)) {
+			int local_ret;
+
+			stream->relayd_lost = true;
+			if (stream->metadata_flag && stream->reset_metadata_flag &&
+					stream->out_fd >= 0) {
+				local_ret = utils_truncate_stream_file(
+						stream->out_fd, 0);
+				if (local_ret < 0) {
+					ERR("Reset local metadata file");
+					ret = local_ret;
+					goto end;
+				}
+				stream->reset_metadata_flag = 0;
+			}
+
+			local_ret = write_local_subbuffer_copy(stream, buffer);
+			ret = local_ret ? local_ret : buffer->size;
+		}
 	}
 
 end:
@@ -1794,7 +1962,6 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(
 {
 	ssize_t ret = 0, written = 0, ret_splice = 0;
 	loff_t offset = 0;
-	off_t orig_offset = stream->out_fd_offset;
 	int fd = stream->wait_fd;
 	/* Default is on the disk */
 	int outfd = stream->out_fd;
@@ -1818,7 +1985,7 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(
 	rcu_read_lock();
 
 	/* Flag that the current stream if set for network streaming. */
-	if (stream->net_seq_idx != (uint64_t) -1ULL) {
+	if (consumer_stream_is_streamed(stream)) {
 		relayd = consumer_find_relayd(stream->net_seq_idx);
 		if (relayd == NULL) {
 			written = -ret;
@@ -1871,6 +2038,14 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(
 		/* No streaming, we have to set the len with the full padding */
 		len += padding;
 
+		ret = consumer_stream_open_deferred_output_files(stream);
+		if (ret < 0) {
+			written = ret;
+			goto end;
+		}
+		outfd = stream->out_fd;
+		stream->local_packet_count++;
+
 		if (stream->metadata_flag && stream->reset_metadata_flag) {
 			ret = utils_truncate_stream_file(stream->out_fd, 0);
 			if (ret < 0) {
@@ -1891,7 +2066,6 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(
 				goto end;
 			}
 			outfd = stream->out_fd;
-			orig_offset = 0;
 		}
 		stream->tracefile_size_current += len;
 	}
@@ -1949,19 +2123,13 @@ ssize_t lttng_consumer_on_read_subbuffer_splice(
 			len -= ret_splice;
 		}
 
-		/* This call is useless on a socket so better save a syscall. */
+		/* The writeout is started once the stream is drained. */
 		if (!relayd) {
-			/* This won't block, but will start writeout asynchronously */
-			lttng_sync_file_range(outfd, stream->out_fd_offset, ret_splice,
-					SYNC_FILE_RANGE_WRITE);
 			stream->out_fd_offset += ret_splice;
 		}
 		stream->output_written += ret_splice;
 		written += ret_splice;
 	}
-	if (!relayd) {
-		lttng_consumer_sync_trace_file(stream, orig_offset);
-	}
 	goto end;
 
 write_error:
@@ -2254,6 +2422,8 @@ void consumer_add_metadata_stream(struct lttng_consumer_stream *stream)
 	 */
 	lttng_ht_add_u64(consumer_data.stream_list_ht, &stream->node_session_id);
 
+	consumer_live_stream_add(stream);
+
 	rcu_read_unlock();
 
 	pthread_mutex_unlock(&stream->lock);
@@ -3169,6 +3339,145 @@ error:
 	return ret;
 }
 
+/*
+ * Execute the commands received on an additional command socket of the
+ * session daemon until it is closed or the consumer daemon exits.
+ *
+ * The session daemon always sends the commands of a given session on the
+ * same socket so they are executed in order, while the commands of sessions
+ * assigned to other sockets are executed concurrently.
+ */
+static void *consumer_thread_command_worker(void *data)
+{
+	int ret;
+	struct pollfd sockpoll[2];
+	struct consumer_command_worker *worker = data;
+
+	rcu_register_thread();
+
+	health_register(health_consumerd, HEALTH_CONSUMERD_TYPE_COMMAND_WORKER);
+
+	DBG("Consumer command worker started on socket %d", worker->sock);
+
+	sockpoll[0].fd = worker->ctx->consumer_should_quit[0];
+	sockpoll[0].events = POLLIN | POLLPRI;
+	sockpoll[1].fd = worker->sock;
+	sockpoll[1].events = POLLIN | POLLPRI;
+
+	while (1) {
+		health_code_update();
+
+		health_poll_entry();
+		ret = lttng_consumer_poll_socket(sockpoll);
+		health_poll_exit();
+		if (ret) {
+			break;
+		}
+
+		ret = lttng_consumer_recv_cmd(worker->ctx, worker->sock,
+				sockpoll);
+		if (ret <= 0) {
+			DBG("Communication interrupted on command socket %d",
+					worker->sock);
+			break;
+		}
+		if (CMM_LOAD_SHARED(consumer_quit)) {
+			break;
+		}
+	}
+
+	DBG("Consumer command worker exiting");
+	health_unregister(health_consumerd);
+	rcu_unregister_thread();
+	return NULL;
+}
+
+int consumer_add_command_worker(struct lttng_consumer_local_data *ctx,
+		int sock)
+{
+	int ret;
+	struct consumer_command_worker *worker;
+
+	pthread_mutex_lock(&command_workers_lock);
+	cds_list_for_each_entry(worker, &command_workers, node) {
+		/*
+		 * Only the main command socket hands sockets; a worker's
+		 * socket is never shared with another worker.
+		 */
+		if (pthread_equal(worker->thread, pthread_self())) {
+			ERR("Command socket received on the socket of a command worker");
+			pthread_mutex_unlock(&command_workers_lock);
+			ret = -1;
+			goto error;
+		}
+	}
+	pthread_mutex_unlock(&command_workers_lock);
+
+	worker = zmalloc(sizeof(*worker));
+	if (!worker) {
+		PERROR("zmalloc consumer command worker");
+		ret = -1;
+		goto error;
+	}
+
+	worker->sock = sock;
+	worker->ctx = ctx;
+
+	pthread_mutex_lock(&command_workers_lock);
+	ret = pthread_create(&worker->thread, default_pthread_attr(),
+			consumer_thread_command_worker, worker);
+	if (ret) {
+		errno = ret;
+		PERROR("pthread_create command worker");
+		pthread_mutex_unlock(&command_workers_lock);
+		free(worker);
+		ret = -1;
+		goto error;
+	}
+	cds_list_add(&worker->node, &command_workers);
+	pthread_mutex_unlock(&command_workers_lock);
+	return 0;
+
+error:
+	if (close(sock)) {
+		PERROR("close command socket");
+	}
+	return ret;
+}
+
+/*
+ * Stop the command workers, wait for the command they are executing to
+ * complete and close their sockets.
+ */
+static void join_command_workers(void)
+{
+	struct consumer_command_worker *worker, *tmp;
+
+	pthread_mutex_lock(&command_workers_lock);
+	/* Interrupt the workers waiting for, or receiving, a command. */
+	cds_list_for_each_entry(worker, &command_workers, node) {
+		if (shutdown(worker->sock, SHUT_RDWR)) {
+			PERROR("shutdown command socket");
+		}
+	}
+
+	cds_list_for_each_entry_safe(worker, tmp, &command_workers, node) {
+		int ret;
+
+		ret = pthread_join(worker->thread, NULL);
+		if (ret) {
+			errno = ret;
+			PERROR("pthread_join command worker");
+		}
+		if (close(worker->sock)) {
+			PERROR("close command socket");
+		}
+		cds_list_del(&worker->node);
+		free(worker);
+	}
+	pthread_mutex_unlock(&command_workers_lock);
+}
+
 /*
  * This thread listens on the consumerd socket and receives the file
  * descriptors from the session daemon.
@@ -3298,6 +3607,12 @@ void *consumer_thread_sessiond_poll(void *data)
 end:
 	DBG("Consumer thread sessiond poll exiting");
 
+	/*
+	 * The command workers use the streams and channels; they must be done
+	 * before those are closed and the other threads are told to quit.
+	 */
+	join_command_workers();
+
 	/*
 	 * Close metadata streams since the producer is the session daemon which
 	 * just died.
@@ -3375,8 +3690,9 @@ ssize_t lttng_consumer_read_subbuffer(struct lttng_consumer_stream *stream,
 		bool locked_by_caller)
 {
 	ssize_t ret, written_bytes = 0;
-	int rotation_ret;
-	struct stream_subbuffer subbuffer = {};
+	unsigned int subbuf_count = 0;
+	int rotation_ret, commit_ret;
+	struct stream_subbuffer subbuffer;
 
 	if (!locked_by_caller) {
 		stream->read_subbuffer_ops.lock(stream);
@@ -3402,69 +3718,92 @@ ssize_t lttng_consumer_read_subbuffer(struct lttng_consumer_stream *stream,
 		}
 	}
 
-	ret = stream->read_subbuffer_ops.get_next_subbuffer(stream, &subbuffer);
-	if (ret) {
-		if (ret == -ENODATA) {
-			/* Not an error. */
-			ret = 0;
-			goto sleep_stream;
+	/*
+	 * Drain the sub-buffers that are ready so that the cost of the wake-up,
+	 * of starting the writeout of the output file and of writing the
+	 * indexes is shared by all the packets consumed. The number of
+	 * sub-buffers consumed in one pass is bounded to remain fair to the
+	 * other streams.
+	 */
+	while (subbuf_count < DEFAULT_CONSUMER_MAX_SUBBUF_PER_READ) {
+		ssize_t consumed_bytes;
+
+		memset(&subbuffer, 0, sizeof(subbuffer));
+		ret = stream->read_subbuffer_ops.get_next_subbuffer(stream,
+				&subbuffer);
+		if (ret) {
+			if (ret == -ENODATA) {
+				/* Not an error. */
+				break;
+			}
+			goto end;
 		}
-		goto end;
-	}
 
-	ret = stream->read_subbuffer_ops.pre_consume_subbuffer(
-			stream, &subbuffer);
-	if (ret) {
-		goto error_put_subbuf;
-	}
+		ret = stream->read_subbuffer_ops.pre_consume_subbuffer(
+				stream, &subbuffer);
+		if (ret) {
+			goto error_put_subbuf;
+		}
 
-	written_bytes = stream->read_subbuffer_ops.consume_subbuffer(
-			ctx, stream, &subbuffer);
-	if (written_bytes <= 0) {
-		ERR("Error consuming subbuffer: (%zd)", written_bytes);
-		ret = (int) written_bytes;
-		goto error_put_subbuf;
-	}
+		consumed_bytes = stream->read_subbuffer_ops.consume_subbuffer(
+				ctx, stream, &subbuffer);
+		if (consumed_bytes <= 0) {
+			ERR("Error consuming subbuffer: (%zd)", consumed_bytes);
+			ret = (int) consumed_bytes;
+			goto error_put_subbuf;
+		}
+		written_bytes += consumed_bytes;
+		subbuf_count++;
 
-	ret = stream->read_subbuffer_ops.put_next_subbuffer(stream, &subbuffer);
-	if (ret) {
-		goto end;
-	}
+		ret = stream->read_subbuffer_ops.put_next_subbuffer(stream,
+				&subbuffer);
+		if (ret) {
+			goto end;
+		}
 
-	ret = post_consume(stream, &subbuffer, ctx);
-	if (ret) {
-		goto end;
-	}
+		ret = post_consume(stream, &subbuffer, ctx);
+		if (ret) {
+			goto end;
+		}
 
-	/*
-	 * After extracting the packet, we check if the stream is now ready to
-	 * be rotated and perform the action immediately.
-	 *
-	 * Don't overwrite `ret` as callers expect the number of bytes
-	 * consumed to be returned on success.
-	 */
-	rotation_ret = lttng_consumer_stream_is_rotate_ready(stream);
-	if (rotation_ret == 1) {
-		rotation_ret = lttng_consumer_rotate_stream(ctx, stream);
-		if (rotation_ret < 0) {
+		/*
+		 * After extracting the packet, we check if the stream is now
+		 * ready to be rotated and perform the action immediately.
+		 *
+		 * Don't overwrite `ret` as callers expect the number of bytes
+		 * consumed to be returned on success.
+		 */
+		rotation_ret = lttng_consumer_stream_is_rotate_ready(stream);
+		if (rotation_ret == 1) {
+			rotation_ret = lttng_consumer_rotate_stream(ctx, stream);
+			if (rotation_ret < 0) {
+				ret = rotation_ret;
+				ERR("Stream rotation error after consuming data");
+				goto end;
+			}
+
+		} else if (rotation_ret < 0) {
 			ret = rotation_ret;
-			ERR("Stream rotation error after consuming data");
+			ERR("Failed to check if stream was ready to rotate after consuming data");
 			goto end;
 		}
-
-	} else if (rotation_ret < 0) {
-		ret = rotation_ret;
-		ERR("Failed to check if stream was ready to rotate after consuming data");
-		goto end;
 	}
 
-sleep_stream:
 	if (stream->read_subbuffer_ops.on_sleep) {
 		stream->read_subbuffer_ops.on_sleep(stream, ctx);
 	}
 
 	ret = written_bytes;
 end:
+	/*
+	 * Start the writeout of the data consumed and write its indexes, even
+	 * on error, since the packets were already released to the tracer.
+	 */
+	commit_ret = consumer_stream_commit_output(stream);
+	if (commit_ret && ret >= 0) {
+		ret = commit_ret;
+	}
+
 	if (!locked_by_caller) {
 		stream->read_subbuffer_ops.unlock(stream);
 	}
@@ -3495,6 +3834,8 @@ int lttng_consumer_on_recv_stream(struct lttng_consumer_stream *stream)
  */
 int lttng_consumer_init(void)
 {
+	consumer_writeback_init();
+
 	consumer_data.channel_ht = lttng_ht_new(0, LTTNG_HT_TYPE_U64);
 	if (!consumer_data.channel_ht) {
 		goto error;
@@ -4025,6 +4366,11 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 			ht->match_fct, &channel->key, &iter.iter,
 			stream, node_channel_id.node) {
 		unsigned long produced_pos = 0, consumed_pos = 0;
+		/*
+		 * Packets of the current trace chunk produced but not yet
+		 * consumed, including the packet being written.
+		 */
+		uint64_t unconsumed_packet_count = 0;
 
 		health_code_update();
 
@@ -4058,6 +4404,21 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 				 */
 				flush_active = true;
 			} else {
+				/*
+				 * Sample the positions before the current
+				 * packet is closed, for local and streamed
+				 * traces alike.
+				 */
+				ret = sample_stream_positions(stream,
+						&produced_pos, &consumed_pos);
+				if (ret) {
+					goto end_unlock_stream;
+				}
+				unconsumed_packet_count =
+						(produced_pos - consumed_pos +
+						stream->max_sb_size - 1) /
+						stream->max_sb_size;
+
 				/*
 				 * Only flush an empty packet if the "packet
 				 * open" could not be performed on transition
@@ -4066,6 +4427,14 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 				 */
 				if (stream->opened_packet_in_current_trace_chunk) {
 					flush_active = true;
+				} else if (is_local_trace) {
+					/*
+					 * The output files of local streams are
+					 * only created once a packet is written:
+					 * an inactive stream produces no file
+					 * rather than an empty one.
+					 */
+					flush_active = true;
 				} else {
 					/*
 					 * Stream could have been full at the
@@ -4081,13 +4450,7 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 					 * able to know that tracing was active
 					 * for this stream during this trace
 					 * chunk's lifetime.
-					 */
-					ret = sample_stream_positions(stream, &produced_pos, &consumed_pos);
-					if (ret) {
-						goto end_unlock_stream;
-					}
-
-					/*
+					 *
 					 * Don't flush an empty packet if data
 					 * was produced; it will be consumed
 					 * before the rotation completes.
@@ -4217,9 +4580,22 @@ int lttng_consumer_rotate_channel(struct lttng_consumer_channel *channel,
 			stream_count++;
 		}
 
+		/*
+		 * A local stream which produced nothing but the packet opened
+		 * at the beginning of the current trace chunk, whether it was
+		 * consumed or not, is considered inactive: no packet is opened
+		 * in the next trace chunk on its behalf so that its output
+		 * files are only created if it becomes active again.
+		 */
+		stream->skip_post_rotation_packet_open = is_local_trace &&
+				!stream->metadata_flag &&
+				stream->local_packet_count +
+				unconsumed_packet_count <= 1;
+
 		stream->opened_packet_in_current_trace_chunk = false;
 
-		if (rotating_to_new_chunk && !stream->metadata_flag) {
+		if (rotating_to_new_chunk && !stream->metadata_flag &&
+				!stream->skip_post_rotation_packet_open) {
 			/*
 			 * Attempt to flush an empty packet as close to the
 			 * rotation point as possible. In the event where a
@@ -4542,6 +4918,15 @@ int rotate_local_stream(struct lttng_consumer_local_data *ctx,
 			stream->chan->key);
 	stream->tracefile_size_current = 0;
 	stream->tracefile_count_current = 0;
+	stream->local_packet_count = 0;
+	stream->output_files_deferred = false;
+	stream->skip_post_rotation_packet_open = false;
+
+	/* Flush what was consumed to the files of the previous chunk. */
+	ret = consumer_stream_commit_output(stream);
+	if (ret) {
+		goto end;
+	}
 
 	if (stream->out_fd >= 0) {
 		ret = close(stream->out_fd);
@@ -4561,7 +4946,7 @@ int rotate_local_stream(struct lttng_consumer_local_data *ctx,
 		goto end;
 	}
 
-	ret = consumer_stream_create_output_files(stream, true);
+	ret = consumer_stream_defer_output_files(stream);
 end:
 	return ret;
 }
@@ -4607,7 +4992,12 @@ int lttng_consumer_rotate_stream(struct lttng_consumer_local_data *ctx,
 		stream->trace_chunk = stream->chan->trace_chunk;
 	}
 
-	if (stream->net_seq_idx == (uint64_t) -1ULL) {
+	/*
+	 * The local copy of a stream streamed to a relayd is rotated like a
+	 * local stream; its output files are closed even if the stream is
+	 * now part of no chunk.
+	 */
+	if (stream->out_fd >= 0 || consumer_stream_has_local_output(stream)) {
 		ret = rotate_local_stream(ctx, stream);
 		if (ret < 0) {
 			ERR("Failed to rotate stream, ret = %i", ret);
@@ -66,6 +66,14 @@ enum lttng_consumer_command {
 	LTTNG_CONSUMER_TRACE_CHUNK_EXISTS,
 	LTTNG_CONSUMER_CLEAR_CHANNEL,
 	LTTNG_CONSUMER_OPEN_CHANNEL_PACKETS,
+	LTTNG_CONSUMER_FLUSH_CHANNELS,
+	LTTNG_CONSUMER_SEND_CHANNEL_TO_APP,
+	LTTNG_CONSUMER_ADD_COMMAND_SOCKET,
+	LTTNG_CONSUMER_ADD_STREAMS,
+	LTTNG_CONSUMER_ADD_LIVE_SESSION,
+	LTTNG_CONSUMER_CLOSE_LIVE_SESSION,
+	LTTNG_CONSUMER_PREPARE_BUFFER_SET,
+	LTTNG_CONSUMER_DESTROY_BUFFER_POOL,
 };
 
 enum lttng_consumer_type {
@@ -203,6 +211,14 @@ struct lttng_consumer_channel {
 	/* On-disk circular buffer */
 	uint64_t tracefile_size;
 	uint64_t tracefile_count;
+	/*
+	 * Amount of data (bytes) of a stream file left in flight before the
+	 * writeback thread waits for it to reach the disk. 0 means one
+	 * sub-buffer.
+	 */
+	uint64_t writeback_window_size;
+	/* Open the streams' output files with O_DIRECT (mmap output only). */
+	bool direct_io;
 	/*
 	 * Monitor or not the streams of this channel meaning this indicates if the
 	 * streams should be sent to the data/metadata thread or added to the no
@@ -423,10 +439,38 @@ struct lttng_consumer_stream {
 	/*
 	 * File descriptor of the data output file. This can be either a file or a
 	 * socket fd for relayd streaming.
+	 *
+	 * A stream streamed to a relayd also has an output file when its trace
+	 * chunk has a local directory; its data is then written to both.
 	 */
 	int out_fd; /* output file to write the data */
+	/*
+	 * Set once a stream streamed to a relayd gets local output files. Such
+	 * a stream is not torn down when its relayd is lost: it keeps writing
+	 * its local copy. Read without the stream lock when the relayd is
+	 * cleaned up.
+	 */
+	bool has_local_copy;
+	/*
+	 * Set, under the stream lock, by the thread reading a stream with a
+	 * local copy once its relayd is lost; the stream is then only written
+	 * locally. net_seq_idx is left untouched as other threads read it
+	 * under other locks.
+	 */
+	bool relayd_lost;
 	/* Write position in the output file descriptor */
 	off_t out_fd_offset;
+	/* End of the output file range for which writeout was started. */
+	off_t writeout_offset;
+	/* End of the output file range handed to the writeback thread. */
+	off_t writeback_offset;
+	/*
+	 * Indexes of the packets written to the local output file since the
+	 * last call to consumer_stream_commit_output().
+	 */
+	struct lttng_dynamic_array pending_indexes;
+	/* The output file was opened with O_DIRECT. */
+	bool out_fd_direct_io;
 	/* Amount of bytes written to the output */
 	uint64_t output_written;
 	int shm_fd_is_copy;
@@ -600,6 +644,20 @@ struct lttng_consumer_stream {
 
 	/* Whether or not a packet was opened during the current trace chunk. */
 	bool opened_packet_in_current_trace_chunk;
+	/*
+	 * The local output files of the stream are created when its first
+	 * packet of the current trace chunk is written rather than when the
+	 * stream enters the trace chunk.
+	 */
+	bool output_files_deferred;
+	/* Packets written to the local output files in the current trace chunk. */
+	uint64_t local_packet_count;
+	/*
+	 * Set, until the stream is rotated, when a local stream was inactive
+	 * during the trace chunk being rotated: no packet is opened in the
+	 * next trace chunk on its behalf.
+	 */
+	bool skip_post_rotation_packet_open;
 
 	/*
 	 * Read-only copies of channel values. We cannot safely access the
@@ -643,6 +701,8 @@ struct lttng_consumer_stream {
 		unlock_cb unlock;
 	} read_subbuffer_ops;
 	struct metadata_bucket *metadata_bucket;
+	/* State served to the local live viewers, NULL if not served. */
+	struct consumer_live_stream *live_stream;
 };
 
 /*
@@ -957,6 +1017,8 @@ void consumer_del_channel(struct lttng_consumer_channel *channel);
 /* lttng-relayd consumer command */
 struct consumer_relayd_sock_pair *consumer_find_relayd(uint64_t key);
 int consumer_send_relayd_stream(struct lttng_consumer_stream *stream, char *path);
+int consumer_send_relayd_channel_streams(struct lttng_consumer_channel *channel,
+		char *path);
 int consumer_send_relayd_streams_sent(uint64_t net_seq_idx);
 void close_relayd_stream(struct lttng_consumer_stream *stream);
 struct lttng_consumer_channel *consumer_find_channel(uint64_t key);
@@ -995,6 +1057,12 @@ void *consumer_thread_sessiond_poll(void *data);
 void *consumer_thread_channel_poll(void *data);
 int lttng_consumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 		int sock, struct pollfd *consumer_sockpoll);
+/*
+ * Serve an additional command socket of the session daemon with a dedicated
+ * worker thread. The socket is owned by the worker, or closed on error.
+ */
+int consumer_add_command_worker(struct lttng_consumer_local_data *ctx,
+		int sock);
 
 ssize_t lttng_consumer_read_subbuffer(struct lttng_consumer_stream *stream,
 		struct lttng_consumer_local_data *ctx,
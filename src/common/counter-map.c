@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only
+ *
+ */
+
+#include <assert.h>
+#include <common/error.h>
+#include <common/macros.h>
+#include <common/payload-view.h>
+#include <common/payload.h>
+#include <lttng/counter-map-internal.h>
+
+static void destroy_value(void *ptr)
+{
+	struct lttng_counter_map_value *value = ptr;
+
+	if (!value) {
+		return;
+	}
+
+	free(value->key);
+	free(value);
+}
+
+LTTNG_HIDDEN
+struct lttng_counter_map_values *lttng_counter_map_values_create(void)
+{
+	struct lttng_counter_map_values *values;
+
+	values = zmalloc(sizeof(*values));
+	if (!values) {
+		goto end;
+	}
+
+	lttng_dynamic_pointer_array_init(&values->array, destroy_value);
+end:
+	return values;
+}
+
+LTTNG_HIDDEN
+int lttng_counter_map_values_add(struct lttng_counter_map_values *values,
+		const char *key, uint64_t value)
+{
+	int ret;
+	struct lttng_counter_map_value *entry;
+
+	assert(values);
+	assert(key);
+
+	entry = zmalloc(sizeof(*entry));
+	if (!entry) {
+		ret = -1;
+		goto end;
+	}
+
+	entry->key = strdup(key);
+	if (!entry->key) {
+		ret = -1;
+		goto end;
+	}
+	entry->value = value;
+
+	ret = lttng_dynamic_pointer_array_add_pointer(&values->array, entry);
+	if (ret) {
+		ret = -1;
+		goto end;
+	}
+	entry = NULL;
+end:
+	destroy_value(entry);
+	return ret;
+}
+
+LTTNG_HIDDEN
+void lttng_counter_map_values_set_dropped_count(
+		struct lttng_counter_map_values *values,
+		uint64_t dropped_count)
+{
+	assert(values);
+
+	values->dropped_count = dropped_count;
+}
+
+LTTNG_HIDDEN
+int lttng_counter_map_values_serialize(
+		const struct lttng_counter_map_values *values,
+		struct lttng_payload *payload)
+{
+	int ret;
+	unsigned int i, count;
+	struct lttng_counter_map_values_comm comm;
+
+	count = lttng_dynamic_pointer_array_get_count(&values->array);
+	comm.dropped_count = values->dropped_count;
+	comm.count = count;
+
+	ret = lttng_dynamic_buffer_append(&payload->buffer, &comm, sizeof(comm));
+	if (ret) {
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		const struct lttng_counter_map_value *entry =
+				lttng_dynamic_pointer_array_get_pointer(
+						&values->array, i);
+		struct lttng_counter_map_value_comm value_comm;
+
+		value_comm.value = entry->value;
+		value_comm.key_len = strlen(entry->key) + 1;
+
+		ret = lttng_dynamic_buffer_append(&payload->buffer, &value_comm,
+				sizeof(value_comm));
+		if (ret) {
+			goto end;
+		}
+
+		ret = lttng_dynamic_buffer_append(&payload->buffer, entry->key,
+				value_comm.key_len);
+		if (ret) {
+			goto end;
+		}
+	}
+end:
+	return ret;
+}
+
+LTTNG_HIDDEN
+ssize_t lttng_counter_map_values_create_from_payload(
+		struct lttng_payload_view *view,
+		struct lttng_counter_map_values **values)
+{
+	ssize_t ret, offset = 0;
+	unsigned int i;
+	const struct lttng_counter_map_values_comm *comm;
+	struct lttng_counter_map_values *local_values = NULL;
+
+	if (!view || !values || view->buffer.size < sizeof(*comm)) {
+		ret = -1;
+		goto end;
+	}
+
+	comm = (typeof(comm)) view->buffer.data;
+	offset += sizeof(*comm);
+
+	local_values = lttng_counter_map_values_create();
+	if (!local_values) {
+		ret = -1;
+		goto end;
+	}
+
+	for (i = 0; i < comm->count; i++) {
+		const struct lttng_counter_map_value_comm *value_comm;
+		const struct lttng_buffer_view value_view =
+				lttng_buffer_view_from_view(
+						&view->buffer, offset, -1);
+
+		if (!lttng_buffer_view_is_valid(&value_view) ||
+				value_view.size < sizeof(*value_comm)) {
+			ret = -1;
+			goto end;
+		}
+
+		value_comm = (typeof(value_comm)) value_view.data;
+		if (!lttng_buffer_view_contains_string(&value_view,
+				value_comm->key, value_comm->key_len)) {
+			ret = -1;
+			goto end;
+		}
+
+		if (lttng_counter_map_values_add(local_values, value_comm->key,
+				value_comm->value)) {
+			ret = -1;
+			goto end;
+		}
+
+		offset += sizeof(*value_comm) + value_comm->key_len;
+	}
+
+	lttng_counter_map_values_set_dropped_count(local_values,
+			comm->dropped_count);
+
+	*values = local_values;
+	local_values = NULL;
+	ret = offset;
+end:
+	lttng_counter_map_values_destroy(local_values);
+	return ret;
+}
+
+enum lttng_counter_map_status lttng_counter_map_values_get_count(
+		const struct lttng_counter_map_values *values,
+		unsigned int *count)
+{
+	if (!values || !count) {
+		return LTTNG_COUNTER_MAP_STATUS_INVALID;
+	}
+
+	*count = lttng_dynamic_pointer_array_get_count(&values->array);
+	return LTTNG_COUNTER_MAP_STATUS_OK;
+}
+
+enum lttng_counter_map_status lttng_counter_map_values_get_at_index(
+		const struct lttng_counter_map_values *values,
+		unsigned int index, const char **key, uint64_t *value)
+{
+	const struct lttng_counter_map_value *entry;
+
+	if (!values || !key || !value ||
+			index >= lttng_dynamic_pointer_array_get_count(
+					&values->array)) {
+		return LTTNG_COUNTER_MAP_STATUS_INVALID;
+	}
+
+	entry = lttng_dynamic_pointer_array_get_pointer(&values->array, index);
+	*key = entry->key;
+	*value = entry->value;
+	return LTTNG_COUNTER_MAP_STATUS_OK;
+}
+
+enum lttng_counter_map_status lttng_counter_map_values_get_dropped_count(
+		const struct lttng_counter_map_values *values,
+		uint64_t *dropped_count)
+{
+	if (!values || !dropped_count) {
+		return LTTNG_COUNTER_MAP_STATUS_INVALID;
+	}
+
+	*dropped_count = values->dropped_count;
+	return LTTNG_COUNTER_MAP_STATUS_OK;
+}
+
+void lttng_counter_map_values_destroy(struct lttng_counter_map_values *values)
+{
+	if (!values) {
+		return;
+	}
+
+	lttng_dynamic_pointer_array_reset(&values->array);
+	free(values);
+}
@@ -79,6 +79,13 @@
 #define DEFAULT_USTCONSUMERD32_CMD_SOCK_PATH    DEFAULT_USTCONSUMERD32_PATH "/command"
 #define DEFAULT_USTCONSUMERD32_ERR_SOCK_PATH    DEFAULT_USTCONSUMERD32_PATH "/error"
 
+/*
+ * Number of command connections opened by the session daemon to each consumer
+ * daemon. The consumer daemon executes the commands received on different
+ * connections concurrently.
+ */
+#define DEFAULT_CONSUMERD_CMD_CONNECTIONS       4
+
 /* Relayd path */
 #define DEFAULT_RELAYD_RUNDIR			"%s"
 #define DEFAULT_RELAYD_PATH			DEFAULT_RELAYD_RUNDIR "/relayd"
@@ -98,6 +105,67 @@
  */
 #define DEFAULT_RELAYD_FD_POOL_SIZE_RESERVE	10
 
+/*
+ * Amount of data (bytes) a relay daemon stream accumulates before its
+ * dirty pages are submitted for writeback. 0 leaves writeback to the kernel.
+ */
+#define DEFAULT_RELAYD_WRITEBACK_SIZE		0
+/*
+ * Amount of the most recently written data (bytes) of a stream left in
+ * the page cache when writeback is enabled, for the benefit of live viewers.
+ */
+#define DEFAULT_RELAYD_WRITEBACK_RESIDENT_SIZE	0
+
+/*
+ * Amount of memory (bytes) used by the queue of a session forwarded to an
+ * upstream relay daemon beyond which its packets are read back from the
+ * local trace rather than kept in memory.
+ */
+#define DEFAULT_RELAYD_UPSTREAM_QUEUE_SIZE	(64 * 1024 * 1024)
+/*
+ * Amount of memory (bytes) used by the queue of a forwarded session beyond
+ * which its forwarding is abandoned.
+ */
+#define DEFAULT_RELAYD_UPSTREAM_QUEUE_MAX_SIZE	(256 * 1024 * 1024)
+/*
+ * Timeout (ms) of the connections to the upstream relay daemon and of their
+ * exchanges, unless LTTNG_NETWORK_SOCKET_TIMEOUT is set.
+ */
+#define DEFAULT_RELAYD_UPSTREAM_TIMEOUT		5000
+/* Bounds of the delay (ms) between connection attempts to the upstream relay daemon. */
+#define DEFAULT_RELAYD_UPSTREAM_RECONNECT_DELAY_MIN	100
+#define DEFAULT_RELAYD_UPSTREAM_RECONNECT_DELAY_MAX	10000
+/*
+ * Delay (ms) between the checks of the packets sent to the upstream relay
+ * daemon which it has not written yet.
+ */
+#define DEFAULT_RELAYD_UPSTREAM_FLUSH_CHECK_DELAY	100
+
+/*
+ * Maximal number of output file ranges queued to the consumer daemon's
+ * writeback thread. Once reached, ranges are coalesced with the next ones.
+ */
+#define DEFAULT_CONSUMER_WRITEBACK_MAX_PENDING	128
+
+/*
+ * Amount of packet data (bytes) of a stream retained in memory by the
+ * consumer daemon while a local live viewer is attached to its session. The
+ * newest packet is always retained.
+ */
+#define DEFAULT_CONSUMERD_LIVE_STREAM_RETENTION_SIZE	(1024 * 1024)
+
+/*
+ * Maximal size (bytes) of the metadata of a trace retained in memory by the
+ * consumer daemon for its local live viewers. Larger metadata is not served.
+ */
+#define DEFAULT_CONSUMERD_LIVE_METADATA_RETENTION_SIZE	(16 * 1024 * 1024)
+
+/*
+ * Maximal number of sub-buffers of a stream consumed by the consumer daemon
+ * each time the stream is read.
+ */
+#define DEFAULT_CONSUMER_MAX_SUBBUF_PER_READ	64
+
 /* Default lttng run directory */
 #define DEFAULT_LTTNG_HOME_ENV_VAR              "LTTNG_HOME"
 #define DEFAULT_LTTNG_FALLBACK_HOME_ENV_VAR	"HOME"
@@ -282,6 +350,13 @@
 /* Number of buckets in the event notifier error count map. */
 #define DEFAULT_EVENT_NOTIFIER_ERROR_COUNT_MAP_SIZE CONFIG_DEFAULT_EVENT_NOTIFIER_ERROR_COUNT_MAP_SIZE
 
+/*
+ * Maximal number of keys of a counter map, and length of a key (including
+ * the trailing \0) completed by a captured event field value.
+ */
+#define DEFAULT_COUNTER_MAP_MAX_KEYS        4096
+#define DEFAULT_COUNTER_MAP_KEY_MAX_LEN     256
+
 /*
  * If a thread stalls for this amount of time, it will be considered bogus (bad
  * health).
@@ -320,8 +395,46 @@
 
 #define DEFAULT_UST_STREAM_FD_NUM			2 /* Number of fd per UST stream. */
 
+/*
+ * Maximal number of unregistered applications torn down together by the
+ * session daemon's application reaper thread.
+ */
+#define DEFAULT_APP_REAP_BATCH_SIZE			128
+/*
+ * Maximal number of registered applications published together, under a
+ * single acquisition of the session list lock, by the session daemon's
+ * registration dispatch thread.
+ */
+#define DEFAULT_APP_REG_DISPATCH_BATCH_SIZE		128
+/*
+ * Number of buffer sets kept ready by the consumer daemons, per bitness, for
+ * the applications registering to a started per-PID UST session. 0 disables
+ * the pool.
+ */
+#define DEFAULT_UST_BUFFER_POOL_SIZE			0
+
+/*
+ * Channel geometry advisor: time, in usec, a recommended sub-buffer takes to
+ * fill at the observed average rate, bounding the consumer daemon wake-ups,
+ * and burst, at the observed peak rate, the recommended buffers can absorb.
+ */
+#define DEFAULT_CHANNEL_ADVISOR_SUBBUF_PERIOD		100000	/* usec */
+#define DEFAULT_CHANNEL_ADVISOR_BURST_PERIOD		250000	/* usec */
+/*
+ * Fraction of the physical memory the advised buffers of a channel, all its
+ * streams included, may take unless a maximum buffer size is configured.
+ */
+#define DEFAULT_CHANNEL_ADVISOR_MEMORY_SHARE		4	/* 1/4 */
+/* Number of channels whose last advice is remembered. */
+#define DEFAULT_CHANNEL_ADVISOR_MAX_RECORDS		1024
+
 #define DEFAULT_SNAPSHOT_NAME				"snapshot"
 #define DEFAULT_SNAPSHOT_MAX_SIZE			0 /* Unlimited. */
+/*
+ * Time, in usec, after which the relay daemon connections of a snapshot
+ * output that were not used to record a snapshot are closed.
+ */
+#define DEFAULT_SNAPSHOT_RELAYD_IDLE_TIMEOUT		60000000	/* usec */
 
 /* Suffix of an index file. */
 #define DEFAULT_INDEX_FILE_SUFFIX			".idx"
@@ -348,6 +461,12 @@
 /* Default maximal size of message notification channel message payloads. */
 #define DEFAULT_CLIENT_MAX_QUEUED_NOTIFICATIONS_COUNT		100
 
+/*
+ * Default size of the buffer in which notification channel clients receive
+ * the messages available on their socket at once.
+ */
+#define DEFAULT_CLIENT_NOTIFICATION_RECEPTION_BUFFER_SIZE	65536
+
 
 #define DEFAULT_LTTNG_RELAYD_TCP_KEEP_ALIVE_ENV "LTTNG_RELAYD_TCP_KEEP_ALIVE"
 #define DEFAULT_LTTNG_RELAYD_TCP_KEEP_ALIVE_IDLE_TIME_ENV "LTTNG_RELAYD_TCP_KEEP_ALIVE_IDLE_TIME"
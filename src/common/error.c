@@ -244,6 +244,8 @@ static const char *error_string_array[] = {
 	[ ERROR_INDEX(LTTNG_ERR_EVENT_NOTIFIER_REGISTRATION) ] = "Failed to create event notifier",
 	[ ERROR_INDEX(LTTNG_ERR_EVENT_NOTIFIER_ERROR_ACCOUNTING) ] = "Failed to initialize event notifier error accounting",
 	[ ERROR_INDEX(LTTNG_ERR_EVENT_NOTIFIER_ERROR_ACCOUNTING_FULL) ] = "No index available in event notifier error accounting",
+	[ ERROR_INDEX(LTTNG_ERR_LOCAL_COPY_SPLICE) ] = "The local copy of a streamed session requires channels using the mmap output",
+	[ ERROR_INDEX(LTTNG_ERR_LIVE_LOCAL_NO_URL) ] = "Live sessions with a local output require the session daemon to be started with a consumer daemon live URL",
 
 	/* Last element */
 	[ ERROR_INDEX(LTTNG_ERR_NR) ] = "Unknown error code"
@@ -218,6 +218,46 @@ error:
 	return -1;
 }
 
+/*
+ * Write 'count' consecutive index values to the given index file.
+ *
+ * Return 0 on success, -1 on error.
+ */
+int lttng_index_file_write_batch(const struct lttng_index_file *index_file,
+		const struct ctf_packet_index *elements, size_t count)
+{
+	ssize_t ret;
+	size_t i;
+	const size_t len = index_file->element_len;
+
+	assert(index_file);
+	assert(elements);
+
+	if (!index_file->file) {
+		goto error;
+	}
+
+	if (len != sizeof(*elements)) {
+		/* The file's index entries are shorter than ours. */
+		for (i = 0; i < count; i++) {
+			if (lttng_index_file_write(index_file, &elements[i])) {
+				goto error;
+			}
+		}
+		return 0;
+	}
+
+	ret = fs_handle_write(index_file->file, elements, len * count);
+	if (ret < 0 || (size_t) ret < len * count) {
+		PERROR("writing index file");
+		goto error;
+	}
+	return 0;
+
+error:
+	return -1;
+}
+
 /*
  * Read index values from the given index file.
  *
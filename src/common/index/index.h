@@ -46,6 +46,8 @@ enum lttng_trace_chunk_status lttng_index_file_create_from_trace_chunk_read_only
 
 int lttng_index_file_write(const struct lttng_index_file *index_file,
 		const struct ctf_packet_index *element);
+int lttng_index_file_write_batch(const struct lttng_index_file *index_file,
+		const struct ctf_packet_index *elements, size_t count);
 int lttng_index_file_read(const struct lttng_index_file *index_file,
 		struct ctf_packet_index *element);
 
@@ -31,6 +31,7 @@
 #include <common/pipe.h>
 #include <common/relayd/relayd.h>
 #include <common/utils.h>
+#include <common/consumer/consumer-live.h>
 #include <common/consumer/consumer-stream.h>
 #include <common/index/index.h>
 #include <common/consumer/consumer-timer.h>
@@ -137,7 +138,8 @@ error:
 }
 
 /*
- * Take a snapshot of all the stream of a channel
+ * Take a snapshot of all the stream of a channel, skipping the packets which
+ * end before begin_timestamp.
  * RCU read-side lock must be held across this function to ensure existence of
  * channel. The channel lock must be held by the caller.
  *
@@ -146,7 +148,7 @@ error:
 static int lttng_kconsumer_snapshot_channel(
 		struct lttng_consumer_channel *channel,
 		uint64_t key, char *path, uint64_t relayd_id,
-		uint64_t nb_packets_per_stream,
+		uint64_t nb_packets_per_stream, uint64_t begin_timestamp,
 		struct lttng_consumer_local_data *ctx)
 {
 	int ret;
@@ -269,6 +271,27 @@ static int lttng_kconsumer_snapshot_channel(
 				continue;
 			}
 
+			if (begin_timestamp) {
+				uint64_t timestamp_end;
+
+				ret = kernctl_get_timestamp_end(stream->wait_fd,
+						&timestamp_end);
+				if (ret < 0) {
+					ERR("Snapshot kernctl_get_timestamp_end");
+					goto error_put_subbuf;
+				}
+				if (timestamp_end < begin_timestamp) {
+					/* Packet ends before the time window. */
+					ret = kernctl_put_subbuf(stream->wait_fd);
+					if (ret < 0) {
+						ERR("Snapshot kernctl_put_subbuf");
+						goto end_unlock;
+					}
+					consumed_pos += stream->max_sb_size;
+					continue;
+				}
+			}
+
 			ret = kernctl_get_subbuf_size(stream->wait_fd, &len);
 			if (ret < 0) {
 				ERR("Snapshot kernctl_get_subbuf_size");
@@ -318,6 +341,7 @@ static int lttng_kconsumer_snapshot_channel(
 
 		if (relayd_id == (uint64_t) -1ULL) {
 			if (stream->out_fd >= 0) {
+				(void) consumer_stream_commit_output(stream);
 				ret = close(stream->out_fd);
 				if (ret < 0) {
 					PERROR("Kernel consumer snapshot close out_fd");
@@ -443,6 +467,173 @@ error_snapshot:
 	return ret;
 }
 
+/*
+ * Create the consumer stream of a stream file descriptor received from the
+ * session daemon and hand it to the data or metadata thread.
+ *
+ * Errors are reported through the error socket since the session daemon
+ * already received the command's status.
+ *
+ * Return 0 on success or else -1.
+ */
+static int add_stream(struct lttng_consumer_local_data *ctx,
+		struct lttng_consumer_channel *channel, int fd, int32_t cpu)
+{
+	int ret;
+	int alloc_ret = 0;
+	struct lttng_pipe *stream_pipe;
+	struct lttng_consumer_stream *new_stream;
+
+	pthread_mutex_lock(&channel->lock);
+	new_stream = consumer_stream_create(
+			channel,
+			channel->key,
+			fd,
+			channel->name,
+			channel->relayd_id,
+			channel->session_id,
+			channel->trace_chunk,
+			cpu,
+			&alloc_ret,
+			channel->type,
+			channel->monitor);
+	if (new_stream == NULL) {
+		switch (alloc_ret) {
+		case -ENOMEM:
+		case -EINVAL:
+		default:
+			lttng_consumer_send_error(ctx, LTTCOMM_CONSUMERD_OUTFD_ERROR);
+			break;
+		}
+		pthread_mutex_unlock(&channel->lock);
+		goto error;
+	}
+
+	new_stream->wait_fd = fd;
+	ret = kernctl_get_max_subbuf_size(new_stream->wait_fd,
+			&new_stream->max_sb_size);
+	if (ret < 0) {
+		pthread_mutex_unlock(&channel->lock);
+		ERR("Failed to get kernel maximal subbuffer size");
+		goto error;
+	}
+
+	consumer_stream_update_channel_attributes(new_stream,
+			channel);
+
+	/*
+	 * We've just assigned the channel to the stream so increment the
+	 * refcount right now. We don't need to increment the refcount for
+	 * streams in no monitor because we handle manually the cleanup of
+	 * those. It is very important to make sure there is NO prior
+	 * consumer_del_stream() calls or else the refcount will be unbalanced.
+	 */
+	if (channel->monitor) {
+		uatomic_inc(&new_stream->chan->refcount);
+	}
+
+	/*
+	 * The buffer flush is done on the session daemon side for the kernel
+	 * so no need for the stream "hangup_flush_done" variable to be
+	 * tracked. This is important for a kernel stream since we don't rely
+	 * on the flush state of the stream to read data. It's not the case for
+	 * user space tracing.
+	 */
+	new_stream->hangup_flush_done = 0;
+
+	health_code_update();
+
+	pthread_mutex_lock(&new_stream->lock);
+	if (ctx->on_recv_stream) {
+		ret = ctx->on_recv_stream(new_stream);
+		if (ret < 0) {
+			pthread_mutex_unlock(&new_stream->lock);
+			pthread_mutex_unlock(&channel->lock);
+			consumer_stream_free(new_stream);
+			goto error;
+		}
+	}
+	health_code_update();
+
+	if (new_stream->metadata_flag) {
+		channel->metadata_stream = new_stream;
+	}
+
+	/* Do not monitor this stream. */
+	if (!channel->monitor) {
+		DBG("Kernel consumer add stream %s in no monitor mode with "
+				"relayd id %" PRIu64, new_stream->name,
+				new_stream->net_seq_idx);
+		cds_list_add(&new_stream->send_node, &channel->streams.head);
+		pthread_mutex_unlock(&new_stream->lock);
+		pthread_mutex_unlock(&channel->lock);
+		goto end;
+	}
+
+	/* Send stream to relayd if the stream has an ID. */
+	if (new_stream->net_seq_idx != (uint64_t) -1ULL) {
+		ret = consumer_send_relayd_stream(new_stream,
+				new_stream->chan->pathname);
+		if (ret < 0) {
+			pthread_mutex_unlock(&new_stream->lock);
+			pthread_mutex_unlock(&channel->lock);
+			consumer_stream_free(new_stream);
+			goto error;
+		}
+
+		/*
+		 * If adding an extra stream to an already
+		 * existing channel (e.g. cpu hotplug), we need
+		 * to send the "streams_sent" command to relayd.
+		 */
+		if (channel->streams_sent_to_relayd) {
+			ret = consumer_send_relayd_streams_sent(
+					new_stream->net_seq_idx);
+			if (ret < 0) {
+				pthread_mutex_unlock(&new_stream->lock);
+				pthread_mutex_unlock(&channel->lock);
+				goto error;
+			}
+		}
+	}
+	pthread_mutex_unlock(&new_stream->lock);
+	pthread_mutex_unlock(&channel->lock);
+
+	/* Get the right pipe where the stream will be sent. */
+	if (new_stream->metadata_flag) {
+		consumer_add_metadata_stream(new_stream);
+		stream_pipe = ctx->consumer_metadata_pipe;
+	} else {
+		consumer_add_data_stream(new_stream);
+		stream_pipe = ctx->consumer_data_pipe;
+	}
+
+	/* Visible to other threads */
+	new_stream->globally_visible = 1;
+
+	health_code_update();
+
+	ret = lttng_pipe_write(stream_pipe, &new_stream, sizeof(new_stream));
+	if (ret < 0) {
+		ERR("Consumer write %s stream to pipe %d",
+				new_stream->metadata_flag ? "metadata" : "data",
+				lttng_pipe_get_writefd(stream_pipe));
+		if (new_stream->metadata_flag) {
+			consumer_del_stream_for_metadata(new_stream);
+		} else {
+			consumer_del_stream_for_data(new_stream);
+		}
+		goto error;
+	}
+
+	DBG("Kernel consumer ADD_STREAM %s (fd: %d) %s with relayd id %" PRIu64,
+			new_stream->name, fd, new_stream->chan->pathname, new_stream->relayd_stream_id);
+end:
+	return 0;
+error:
+	return -1;
+}
+
 /*
  * Receive command from session daemon and process it.
  *
@@ -522,6 +713,9 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 			goto end_nosignal;
 		}
 		new_channel->nb_init_stream_left = msg.u.channel.nb_init_streams;
+		new_channel->writeback_window_size =
+				msg.u.channel.writeback_window_size;
+		new_channel->direct_io = msg.u.channel.direct_io;
 		switch (msg.u.channel.output) {
 		case LTTNG_EVENT_SPLICE:
 			new_channel->output = CONSUMER_CHANNEL_SPLICE;
@@ -589,10 +783,7 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 	case LTTNG_CONSUMER_ADD_STREAM:
 	{
 		int fd;
-		struct lttng_pipe *stream_pipe;
-		struct lttng_consumer_stream *new_stream;
 		struct lttng_consumer_channel *channel;
-		int alloc_ret = 0;
 
 		/*
 		 * Get stream's channel reference. Needed when adding the stream to the
@@ -656,155 +847,116 @@ int lttng_kconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 
 		health_code_update();
 
-		pthread_mutex_lock(&channel->lock);
-		new_stream = consumer_stream_create(
-				channel,
-				channel->key,
-				fd,
-				channel->name,
-				channel->relayd_id,
-				channel->session_id,
-				channel->trace_chunk,
-				msg.u.stream.cpu,
-				&alloc_ret,
-				channel->type,
-				channel->monitor);
-		if (new_stream == NULL) {
-			switch (alloc_ret) {
-			case -ENOMEM:
-			case -EINVAL:
-			default:
-				lttng_consumer_send_error(ctx, LTTCOMM_CONSUMERD_OUTFD_ERROR);
-				break;
-			}
-			pthread_mutex_unlock(&channel->lock);
-			goto error_add_stream_nosignal;
-		}
-
-		new_stream->wait_fd = fd;
-		ret = kernctl_get_max_subbuf_size(new_stream->wait_fd,
-				&new_stream->max_sb_size);
-		if (ret < 0) {
-			pthread_mutex_unlock(&channel->lock);
-			ERR("Failed to get kernel maximal subbuffer size");
+		ret = add_stream(ctx, channel, fd, msg.u.stream.cpu);
+		if (ret) {
 			goto error_add_stream_nosignal;
 		}
-
-		consumer_stream_update_channel_attributes(new_stream,
-				channel);
+		break;
+error_add_stream_nosignal:
+		goto end_nosignal;
+error_add_stream_fatal:
+		goto error_fatal;
+	}
+	case LTTNG_CONSUMER_ADD_STREAMS:
+	{
+		uint32_t i, fds_received = 0;
+		const uint32_t stream_count = msg.u.streams.stream_count;
+		struct lttng_consumer_channel *channel;
+		struct lttcomm_consumer_stream_info *infos;
+		int *fds;
 
 		/*
-		 * We've just assigned the channel to the stream so increment the
-		 * refcount right now. We don't need to increment the refcount for
-		 * streams in no monitor because we handle manually the cleanup of
-		 * those. It is very important to make sure there is NO prior
-		 * consumer_del_stream() calls or else the refcount will be unbalanced.
+		 * The stream attributes and file descriptors are received
+		 * before the status is sent, so they are drained even if the
+		 * channel was torn down meanwhile.
 		 */
-		if (channel->monitor) {
-			uatomic_inc(&new_stream->chan->refcount);
+		channel = consumer_find_channel(msg.u.streams.channel_key);
+		if (!channel) {
+			ERR("Unable to find channel key %" PRIu64,
+					msg.u.streams.channel_key);
+			ret_code = LTTCOMM_CONSUMERD_CHAN_NOT_FOUND;
 		}
 
-		/*
-		 * The buffer flush is done on the session daemon side for the kernel
-		 * so no need for the stream "hangup_flush_done" variable to be
-		 * tracked. This is important for a kernel stream since we don't rely
-		 * on the flush state of the stream to read data. It's not the case for
-		 * user space tracing.
-		 */
-		new_stream->hangup_flush_done = 0;
-
-		health_code_update();
-
-		pthread_mutex_lock(&new_stream->lock);
-		if (ctx->on_recv_stream) {
-			ret = ctx->on_recv_stream(new_stream);
-			if (ret < 0) {
-				pthread_mutex_unlock(&new_stream->lock);
-				pthread_mutex_unlock(&channel->lock);
-				consumer_stream_free(new_stream);
-				goto error_add_stream_nosignal;
-			}
+		infos = zmalloc(sizeof(*infos) * stream_count);
+		fds = zmalloc(sizeof(*fds) * stream_count);
+		if (stream_count == 0 || !infos || !fds) {
+			ERR("Failed to allocate the descriptors of %" PRIu32 " streams",
+					stream_count);
+			goto error_add_streams_fatal;
 		}
+
 		health_code_update();
 
-		if (new_stream->metadata_flag) {
-			channel->metadata_stream = new_stream;
+		ret = lttcomm_recv_unix_sock(sock, infos,
+				sizeof(*infos) * stream_count);
+		if (ret != sizeof(*infos) * stream_count) {
+			lttng_consumer_send_error(ctx,
+					LTTCOMM_CONSUMERD_ERROR_RECV_CMD);
+			goto error_add_streams_fatal;
 		}
 
-		/* Do not monitor this stream. */
-		if (!channel->monitor) {
-			DBG("Kernel consumer add stream %s in no monitor mode with "
-					"relayd id %" PRIu64, new_stream->name,
-					new_stream->net_seq_idx);
-			cds_list_add(&new_stream->send_node, &channel->streams.head);
-			pthread_mutex_unlock(&new_stream->lock);
-			pthread_mutex_unlock(&channel->lock);
-			goto end_add_stream;
-		}
+		/* The descriptors are passed in chunks of LTTCOMM_MAX_SEND_FDS. */
+		while (fds_received < stream_count) {
+			const uint32_t chunk = min_t(uint32_t,
+					stream_count - fds_received,
+					LTTCOMM_MAX_SEND_FDS);
 
-		/* Send stream to relayd if the stream has an ID. */
-		if (new_stream->net_seq_idx != (uint64_t) -1ULL) {
-			ret = consumer_send_relayd_stream(new_stream,
-					new_stream->chan->pathname);
-			if (ret < 0) {
-				pthread_mutex_unlock(&new_stream->lock);
-				pthread_mutex_unlock(&channel->lock);
-				consumer_stream_free(new_stream);
-				goto error_add_stream_nosignal;
+			health_poll_entry();
+			ret = lttng_consumer_poll_socket(consumer_sockpoll);
+			health_poll_exit();
+			if (ret) {
+				goto error_add_streams_fatal;
 			}
 
-			/*
-			 * If adding an extra stream to an already
-			 * existing channel (e.g. cpu hotplug), we need
-			 * to send the "streams_sent" command to relayd.
-			 */
-			if (channel->streams_sent_to_relayd) {
-				ret = consumer_send_relayd_streams_sent(
-						new_stream->net_seq_idx);
-				if (ret < 0) {
-					pthread_mutex_unlock(&new_stream->lock);
-					pthread_mutex_unlock(&channel->lock);
-					goto error_add_stream_nosignal;
-				}
+			ret = lttcomm_recv_fds_unix_sock(sock,
+					fds + fds_received, chunk);
+			if (ret != sizeof(*fds) * chunk) {
+				lttng_consumer_send_error(ctx,
+						LTTCOMM_CONSUMERD_ERROR_RECV_FD);
+				goto error_add_streams_fatal;
 			}
+			fds_received += chunk;
+			health_code_update();
 		}
-		pthread_mutex_unlock(&new_stream->lock);
-		pthread_mutex_unlock(&channel->lock);
 
-		/* Get the right pipe where the stream will be sent. */
-		if (new_stream->metadata_flag) {
-			consumer_add_metadata_stream(new_stream);
-			stream_pipe = ctx->consumer_metadata_pipe;
-		} else {
-			consumer_add_data_stream(new_stream);
-			stream_pipe = ctx->consumer_data_pipe;
+		/* Single status for the whole batch. */
+		ret = consumer_send_status_msg(sock, ret_code);
+		if (ret < 0 || ret_code != LTTCOMM_CONSUMERD_SUCCESS) {
+			goto error_add_streams_nosignal;
 		}
 
-		/* Visible to other threads */
-		new_stream->globally_visible = 1;
-
-		health_code_update();
-
-		ret = lttng_pipe_write(stream_pipe, &new_stream, sizeof(new_stream));
-		if (ret < 0) {
-			ERR("Consumer write %s stream to pipe %d",
-					new_stream->metadata_flag ? "metadata" : "data",
-					lttng_pipe_get_writefd(stream_pipe));
-			if (new_stream->metadata_flag) {
-				consumer_del_stream_for_metadata(new_stream);
-			} else {
-				consumer_del_stream_for_data(new_stream);
+		for (i = 0; i < stream_count; i++) {
+			ret = add_stream(ctx, channel, fds[i], infos[i].cpu);
+			/* The stream now owns its file descriptor. */
+			fds[i] = -1;
+			if (ret) {
+				goto error_add_streams_nosignal;
 			}
-			goto error_add_stream_nosignal;
+			health_code_update();
 		}
 
-		DBG("Kernel consumer ADD_STREAM %s (fd: %d) %s with relayd id %" PRIu64,
-				new_stream->name, fd, new_stream->chan->pathname, new_stream->relayd_stream_id);
-end_add_stream:
+		DBG("Kernel consumer ADD_STREAMS added %" PRIu32 " streams to channel %" PRIu64,
+				stream_count, channel->key);
+		free(infos);
+		free(fds);
 		break;
-error_add_stream_nosignal:
+error_add_streams_nosignal:
+		for (i = 0; i < fds_received; i++) {
+			if (fds[i] >= 0 && close(fds[i])) {
+				PERROR("close stream fd");
+			}
+		}
+		free(infos);
+		free(fds);
 		goto end_nosignal;
-error_add_stream_fatal:
+error_add_streams_fatal:
+		for (i = 0; i < fds_received; i++) {
+			if (close(fds[i])) {
+				PERROR("close stream fd");
+			}
+		}
+		free(infos);
+		free(fds);
 		goto error_fatal;
 	}
 	case LTTNG_CONSUMER_STREAMS_SENT:
@@ -953,6 +1105,7 @@ error_streams_sent_nosignal:
 						msg.u.snapshot_channel.pathname,
 						msg.u.snapshot_channel.relayd_id,
 						msg.u.snapshot_channel.nb_packets_per_stream,
+						msg.u.snapshot_channel.begin_timestamp,
 						ctx);
 				if (ret < 0) {
 					ERR("Snapshot channel failed");
@@ -1123,6 +1276,30 @@ end_destroy_channel:
 		}
 		break;
 	}
+	case LTTNG_CONSUMER_ADD_COMMAND_SOCKET:
+	{
+		int command_sock;
+
+		ret_code = LTTCOMM_CONSUMERD_SUCCESS;
+		/* Successfully received the command's type. */
+		ret = consumer_send_status_msg(sock, ret_code);
+		if (ret < 0) {
+			goto error_fatal;
+		}
+
+		ret = lttcomm_recv_fds_unix_sock(sock, &command_sock, 1);
+		if (ret != sizeof(command_sock)) {
+			ERR("Failed to receive command socket");
+			goto error_fatal;
+		}
+
+		DBG("Received additional command socket (%d)", command_sock);
+		ret = consumer_add_command_worker(ctx, command_sock);
+		if (ret) {
+			ret_code = LTTCOMM_CONSUMERD_FATAL;
+		}
+		goto end_msg_sessiond;
+	}
 	case LTTNG_CONSUMER_ROTATE_CHANNEL:
 	{
 		struct lttng_consumer_channel *channel;
@@ -1212,6 +1389,8 @@ error_rotate_channel:
 		};
 		const bool is_local_trace =
 				!msg.u.create_trace_chunk.relayd_id.is_set;
+		const bool has_local_output =
+				msg.u.create_trace_chunk.credentials.is_set;
 		const uint64_t relayd_id =
 				msg.u.create_trace_chunk.relayd_id.value;
 		const char *chunk_override_name =
@@ -1221,10 +1400,12 @@ error_rotate_channel:
 		struct lttng_directory_handle *chunk_directory_handle = NULL;
 
 		/*
-		 * The session daemon will only provide a chunk directory file
-		 * descriptor for local traces.
+		 * The session daemon only provides a chunk directory file
+		 * descriptor, along with its credentials, for chunks having a
+		 * local output: local traces and local copies of streamed
+		 * traces.
 		 */
-		if (is_local_trace) {
+		if (has_local_output) {
 			int chunk_dirfd;
 
 			/* Acnowledge the reception of the command. */
@@ -1329,6 +1510,22 @@ error_rotate_channel:
 		health_code_update();
 		goto end_msg_sessiond;
 	}
+	case LTTNG_CONSUMER_ADD_LIVE_SESSION:
+	{
+		msg.u.add_live_session.session_name[
+				sizeof(msg.u.add_live_session.session_name) - 1] = '\0';
+		msg.u.add_live_session.hostname[
+				sizeof(msg.u.add_live_session.hostname) - 1] = '\0';
+		consumer_live_session_add(msg.u.add_live_session.session_id,
+				msg.u.add_live_session.session_name,
+				msg.u.add_live_session.hostname,
+				msg.u.add_live_session.live_timer);
+		goto end_msg_sessiond;
+	}
+	case LTTNG_CONSUMER_CLOSE_LIVE_SESSION:
+		consumer_live_session_close(
+				msg.u.close_live_session.session_id);
+		goto end_msg_sessiond;
 	default:
 		goto end_nosignal;
 	}
@@ -1706,12 +1903,12 @@ int lttng_kconsumer_on_recv_stream(struct lttng_consumer_stream *stream)
 	assert(stream);
 
 	/*
-	 * Don't create anything if this is set for streaming or if there is
-	 * no current trace chunk on the parent channel.
+	 * Don't create anything if this is set for streaming without a local
+	 * copy or if there is no current trace chunk on the parent channel.
 	 */
-	if (stream->net_seq_idx == (uint64_t) -1ULL && stream->chan->monitor &&
-			stream->chan->trace_chunk) {
-		ret = consumer_stream_create_output_files(stream, true);
+	if (stream->chan->monitor && stream->chan->trace_chunk &&
+			consumer_stream_has_local_output(stream)) {
+		ret = consumer_stream_defer_output_files(stream);
 		if (ret) {
 			goto error;
 		}
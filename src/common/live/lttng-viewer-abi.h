@@ -16,6 +16,8 @@
 #define LTTNG_VIEWER_PATH_MAX		4096
 #define LTTNG_VIEWER_NAME_MAX		255
 #define LTTNG_VIEWER_HOST_NAME_MAX	64
+/* Maximal number of CPUs in an attach stream filter. */
+#define LTTNG_VIEWER_FILTER_CPUS_MAX	8192
 
 /* Flags in reply to get_next_index and get_packet. */
 enum {
@@ -35,6 +37,8 @@ enum lttng_viewer_command {
 	LTTNG_VIEWER_GET_NEW_STREAMS	= 7,
 	LTTNG_VIEWER_CREATE_SESSION	= 8,
 	LTTNG_VIEWER_DETACH_SESSION	= 9,
+	/* Since protocol 2.13. */
+	LTTNG_VIEWER_ATTACH_SESSION_FILTERED	= 10,
 };
 
 enum lttng_viewer_attach_return_code {
@@ -149,6 +153,24 @@ struct lttng_viewer_attach_session_request {
 	uint32_t seek;		/* enum lttng_viewer_seek */
 } LTTNG_PACKED;
 
+/*
+ * LTTNG_VIEWER_ATTACH_SESSION_FILTERED payload.
+ *
+ * Only the data streams of the selected channel and CPUs are made
+ * available to the viewer. Metadata streams are always made available.
+ *
+ * The request is followed by 'cpu_count' CPU ids (uint32_t).
+ */
+struct lttng_viewer_attach_session_filtered_request {
+	uint64_t session_id;
+	uint64_t offset;	/* unused for now */
+	uint32_t seek;		/* enum lttng_viewer_seek */
+	/* Null-terminated channel name, empty to select every channel. */
+	char channel_name[LTTNG_VIEWER_NAME_MAX];
+	/* Number of CPU ids following the request, 0 to select every CPU. */
+	uint32_t cpu_count;
+} LTTNG_PACKED;
+
 struct lttng_viewer_attach_session_response {
 	/* enum lttng_viewer_attach_return_code */
 	uint32_t status;
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/error.h>
+
+#include "packet-list.h"
+
+LTTNG_HIDDEN
+struct live_packet *live_packet_create(const struct lttng_buffer_view *buffer)
+{
+	struct live_packet *packet;
+
+	/* Every other field is set before the packet is appended. */
+	packet = malloc(sizeof(*packet) + buffer->size);
+	if (!packet) {
+		PERROR("malloc live packet");
+		goto end;
+	}
+	packet->refcount = 1;
+	packet->size = buffer->size;
+	memcpy(packet->data, buffer->data, buffer->size);
+end:
+	return packet;
+}
+
+LTTNG_HIDDEN
+void live_packet_get(struct live_packet *packet)
+{
+	packet->refcount++;
+}
+
+LTTNG_HIDDEN
+void live_packet_put(struct live_packet *packet)
+{
+	if (!packet) {
+		return;
+	}
+	assert(packet->refcount);
+	if (--packet->refcount == 0) {
+		free(packet);
+	}
+}
+
+LTTNG_HIDDEN
+void live_packet_list_init(struct live_packet_list *list)
+{
+	CDS_INIT_LIST_HEAD(&list->packets);
+	list->retained_size = 0;
+	list->next_offset = 0;
+}
+
+LTTNG_HIDDEN
+void live_packet_list_reset(struct live_packet_list *list)
+{
+	struct live_packet *packet, *tmp;
+
+	cds_list_for_each_entry_safe(packet, tmp, &list->packets, node) {
+		cds_list_del(&packet->node);
+		live_packet_put(packet);
+	}
+	list->retained_size = 0;
+}
+
+LTTNG_HIDDEN
+void live_packet_list_append(struct live_packet_list *list,
+		struct live_packet *packet, uint64_t retention_size)
+{
+	struct live_packet *oldest;
+
+	packet->offset = list->next_offset;
+	list->next_offset += packet->size;
+	list->retained_size += packet->size;
+	cds_list_add_tail(&packet->node, &list->packets);
+
+	while (list->retained_size > retention_size) {
+		oldest = cds_list_first_entry(&list->packets,
+				struct live_packet, node);
+		if (oldest == packet) {
+			break;
+		}
+		cds_list_del(&oldest->node);
+		list->retained_size -= oldest->size;
+		live_packet_put(oldest);
+	}
+}
+
+LTTNG_HIDDEN
+struct live_packet *live_packet_list_next(struct live_packet_list *list,
+		uint64_t offset)
+{
+	struct live_packet *packet;
+
+	cds_list_for_each_entry(packet, &list->packets, node) {
+		if (packet->offset >= offset) {
+			return packet;
+		}
+	}
+	return NULL;
+}
+
+LTTNG_HIDDEN
+struct live_packet *live_packet_list_find(struct live_packet_list *list,
+		uint64_t offset)
+{
+	struct live_packet *packet;
+
+	cds_list_for_each_entry(packet, &list->packets, node) {
+		if (packet->offset == offset) {
+			return packet;
+		}
+	}
+	return NULL;
+}
+
+LTTNG_HIDDEN
+uint64_t live_packet_list_last_offset(struct live_packet_list *list)
+{
+	if (cds_list_empty(&list->packets)) {
+		return list->next_offset;
+	}
+	return cds_list_entry(list->packets.prev, struct live_packet,
+			node)->offset;
+}
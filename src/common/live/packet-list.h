@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef _COMMON_LIVE_PACKET_LIST_H
+#define _COMMON_LIVE_PACKET_LIST_H
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <urcu/list.h>
+
+#include <common/buffer-view.h>
+#include <common/macros.h>
+
+/*
+ * Packet retained for the live viewers.
+ *
+ * The packets of a stream are laid out, in the order they were consumed, in
+ * a "virtual file" of which they hold the offset. The index fields are kept
+ * in host byte order.
+ */
+struct live_packet {
+	unsigned int refcount;
+	uint64_t offset;
+	uint64_t packet_size;
+	uint64_t content_size;
+	uint64_t timestamp_begin;
+	uint64_t timestamp_end;
+	uint64_t events_discarded;
+	uint64_t stream_id;
+	struct cds_list_head node;
+	size_t size;
+	char data[];
+};
+
+/*
+ * Packets retained for a stream, oldest first, bounded in size.
+ *
+ * The packets and the list are not protected: the users provide their own
+ * locking.
+ */
+struct live_packet_list {
+	struct cds_list_head packets;
+	uint64_t retained_size;
+	/* Offset of the next packet appended. */
+	uint64_t next_offset;
+};
+
+/*
+ * Create a packet holding a copy of `buffer`. The other fields are set by
+ * the caller before the packet is appended to a list.
+ */
+LTTNG_HIDDEN
+struct live_packet *live_packet_create(const struct lttng_buffer_view *buffer);
+LTTNG_HIDDEN
+void live_packet_get(struct live_packet *packet);
+LTTNG_HIDDEN
+void live_packet_put(struct live_packet *packet);
+
+LTTNG_HIDDEN
+void live_packet_list_init(struct live_packet_list *list);
+/* Release the packets of the list. */
+LTTNG_HIDDEN
+void live_packet_list_reset(struct live_packet_list *list);
+
+/*
+ * Append a packet to the list, which takes ownership of the caller's
+ * reference, and set its offset. The oldest packets are then evicted until
+ * the list fits in `retention_size`; the newest packet is always kept.
+ */
+LTTNG_HIDDEN
+void live_packet_list_append(struct live_packet_list *list,
+		struct live_packet *packet, uint64_t retention_size);
+
+/*
+ * Get the first packet located at or after `offset`, skipping the packets
+ * evicted before they were read. Returns NULL if there is none yet.
+ */
+LTTNG_HIDDEN
+struct live_packet *live_packet_list_next(struct live_packet_list *list,
+		uint64_t offset);
+
+/* Get the packet located at `offset`, NULL if it is not retained. */
+LTTNG_HIDDEN
+struct live_packet *live_packet_list_find(struct live_packet_list *list,
+		uint64_t offset);
+
+/*
+ * Get the offset of the newest packet of the list, or of the next one if
+ * the list is empty.
+ */
+LTTNG_HIDDEN
+uint64_t live_packet_list_last_offset(struct live_packet_list *list);
+
+#endif /* _COMMON_LIVE_PACKET_LIST_H */
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stream-filter.h"
+
+LTTNG_HIDDEN
+bool live_stream_filter_match(const struct live_stream_filter *filter,
+		const char *stream_name, bool is_metadata)
+{
+	const char *cpu_separator;
+	size_t channel_name_len = strlen(stream_name);
+	unsigned long cpu = 0;
+	bool has_cpu = false;
+	uint32_t i;
+
+	if (!filter || is_metadata) {
+		return true;
+	}
+
+	cpu_separator = strrchr(stream_name, '_');
+	if (cpu_separator && isdigit((unsigned char) cpu_separator[1])) {
+		char *end;
+
+		errno = 0;
+		cpu = strtoul(cpu_separator + 1, &end, 10);
+		if (!errno && *end == '\0') {
+			has_cpu = true;
+			channel_name_len = cpu_separator - stream_name;
+		}
+	}
+
+	if (filter->channel_name[0] != '\0' &&
+			(strlen(filter->channel_name) != channel_name_len ||
+			strncmp(filter->channel_name, stream_name,
+					channel_name_len))) {
+		return false;
+	}
+
+	if (!filter->cpu_count || !has_cpu) {
+		return true;
+	}
+
+	for (i = 0; i < filter->cpu_count; i++) {
+		if (filter->cpus[i] == cpu) {
+			return true;
+		}
+	}
+	return false;
+}
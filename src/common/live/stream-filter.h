@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef _COMMON_LIVE_STREAM_FILTER_H
+#define _COMMON_LIVE_STREAM_FILTER_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include <common/live/lttng-viewer-abi.h>
+#include <common/macros.h>
+
+/*
+ * Selection of the streams of a session made available to the live viewer
+ * attached to it.
+ */
+struct live_stream_filter {
+	/* Empty to select every channel. */
+	char channel_name[LTTNG_VIEWER_NAME_MAX];
+	/* Number of entries in 'cpus', 0 to select every CPU. */
+	uint32_t cpu_count;
+	uint32_t cpus[];
+};
+
+/*
+ * Check whether a stream is selected by a live stream filter; a NULL filter
+ * selects every stream.
+ *
+ * Per-CPU streams are named after their channel, suffixed by "_<cpu>". A
+ * stream name without such a suffix is matched as a whole against the
+ * channel name of the filter and is not subject to the CPU selection.
+ * Metadata streams are always selected since no data stream can be decoded
+ * without them.
+ */
+LTTNG_HIDDEN
+bool live_stream_filter_match(const struct live_stream_filter *filter,
+		const char *stream_name, bool is_metadata);
+
+#endif /* _COMMON_LIVE_STREAM_FILTER_H */
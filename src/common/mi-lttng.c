@@ -211,6 +211,13 @@ LTTNG_HIDDEN const char * const mi_lttng_rotation_location_relay_protocol_str_tc
 /* String related to add-context command */
 LTTNG_HIDDEN const char * const mi_lttng_element_context_symbol = "symbol";
 
+/* String related to the channel advice of the list command */
+LTTNG_HIDDEN const char * const mi_lttng_element_channel_advice = "advice";
+LTTNG_HIDDEN const char * const mi_lttng_element_channel_advice_observed_period = "observed_period";
+LTTNG_HIDDEN const char * const mi_lttng_element_channel_advice_rate = "rate";
+LTTNG_HIDDEN const char * const mi_lttng_element_channel_advice_peak_rate = "peak_rate";
+LTTNG_HIDDEN const char * const mi_lttng_element_channel_advice_peak_usage = "peak_usage";
+
 /* Deprecated symbols preserved for ABI compatibility. */
 const char * const mi_lttng_context_type_perf_counter;
 const char * const mi_lttng_context_type_perf_cpu_counter;
@@ -982,7 +989,9 @@ int mi_lttng_channel_attr(struct mi_writer *writer,
 	struct lttng_channel *chan = caa_container_of(attr,
 			struct lttng_channel, attr);
 	uint64_t discarded_events, lost_packets, monitor_timer_interval;
+	uint64_t writeback_window_size;
 	int64_t blocking_timeout;
+	int direct_io;
 
 	assert(attr);
 
@@ -1008,6 +1017,17 @@ int mi_lttng_channel_attr(struct mi_writer *writer,
 		goto end;
 	}
 
+	ret = lttng_channel_get_writeback_window_size(chan,
+			&writeback_window_size);
+	if (ret) {
+		goto end;
+	}
+
+	ret = lttng_channel_get_direct_io(chan, &direct_io);
+	if (ret) {
+		goto end;
+	}
+
 	/* Opening Attributes */
 	ret = mi_lttng_writer_open_element(writer, config_element_attributes);
 	if (ret) {
@@ -1070,6 +1090,21 @@ int mi_lttng_channel_attr(struct mi_writer *writer,
 		goto end;
 	}
 
+	/* Writeback window size in bytes */
+	ret = mi_lttng_writer_write_element_unsigned_int(writer,
+		config_element_writeback_window_size,
+		writeback_window_size);
+	if (ret) {
+		goto end;
+	}
+
+	/* Direct I/O */
+	ret = mi_lttng_writer_write_element_bool(writer,
+		config_element_direct_io, direct_io);
+	if (ret) {
+		goto end;
+	}
+
 	/* Event output */
 	ret = mi_lttng_writer_write_element_string(writer,
 		config_element_output_type,
@@ -1128,6 +1163,91 @@ end:
 
 }
 
+LTTNG_HIDDEN
+int mi_lttng_channel_advice(struct mi_writer *writer,
+		const struct lttng_channel_advice *advice)
+{
+	int ret;
+
+	assert(advice);
+
+	/* Opening advice */
+	ret = mi_lttng_writer_open_element(writer,
+			mi_lttng_element_channel_advice);
+	if (ret) {
+		goto end;
+	}
+
+	/* Observation period in usec */
+	ret = mi_lttng_writer_write_element_unsigned_int(writer,
+		mi_lttng_element_channel_advice_observed_period,
+		advice->observed_period);
+	if (ret) {
+		goto end;
+	}
+
+	/* Average and peak rates in bytes/s */
+	ret = mi_lttng_writer_write_element_unsigned_int(writer,
+		mi_lttng_element_channel_advice_rate, advice->rate);
+	if (ret) {
+		goto end;
+	}
+
+	ret = mi_lttng_writer_write_element_unsigned_int(writer,
+		mi_lttng_element_channel_advice_peak_rate,
+		advice->peak_rate);
+	if (ret) {
+		goto end;
+	}
+
+	/* Peak usage of a stream in bytes */
+	ret = mi_lttng_writer_write_element_unsigned_int(writer,
+		mi_lttng_element_channel_advice_peak_usage,
+		advice->peak_usage);
+	if (ret) {
+		goto end;
+	}
+
+	ret = mi_lttng_writer_write_element_unsigned_int(writer,
+		config_element_discarded_events,
+		advice->discarded_events);
+	if (ret) {
+		goto end;
+	}
+
+	ret = mi_lttng_writer_write_element_unsigned_int(writer,
+		config_element_lost_packets,
+		advice->lost_packets);
+	if (ret) {
+		goto end;
+	}
+
+	/* Recommended geometry */
+	ret = mi_lttng_writer_write_element_unsigned_int(writer,
+		config_element_subbuf_size, advice->subbuf_size);
+	if (ret) {
+		goto end;
+	}
+
+	ret = mi_lttng_writer_write_element_unsigned_int(writer,
+		config_element_num_subbuf, advice->num_subbuf);
+	if (ret) {
+		goto end;
+	}
+
+	ret = mi_lttng_writer_write_element_unsigned_int(writer,
+		config_element_switch_timer_interval,
+		advice->switch_timer_interval);
+	if (ret) {
+		goto end;
+	}
+
+	/* Closing advice */
+	ret = mi_lttng_writer_close_element(writer);
+end:
+	return ret;
+}
+
 LTTNG_HIDDEN
 int mi_lttng_event_common_attributes(struct mi_writer *writer,
 		struct lttng_event *event)
@@ -215,6 +215,13 @@ LTTNG_HIDDEN extern const char * const mi_lttng_rotation_location_relay_protocol
 /* String related to add-context command */
 LTTNG_HIDDEN extern const char * const mi_lttng_element_context_symbol;
 
+/* String related to the channel advice of the list command */
+LTTNG_HIDDEN extern const char * const mi_lttng_element_channel_advice;
+LTTNG_HIDDEN extern const char * const mi_lttng_element_channel_advice_observed_period;
+LTTNG_HIDDEN extern const char * const mi_lttng_element_channel_advice_rate;
+LTTNG_HIDDEN extern const char * const mi_lttng_element_channel_advice_peak_rate;
+LTTNG_HIDDEN extern const char * const mi_lttng_element_channel_advice_peak_usage;
+
 /* Utility string function  */
 const char *mi_lttng_loglevel_string(int value, enum lttng_domain_type domain);
 const char *mi_lttng_logleveltype_string(enum lttng_loglevel_type value);
@@ -462,6 +469,18 @@ int mi_lttng_channel(struct mi_writer *writer,
 int mi_lttng_channel_attr(struct mi_writer *writer,
 		struct lttng_channel_attr *attr);
 
+/*
+ * Machine interface of struct lttng_channel_advice.
+ *
+ * writer An instance of a machine interface writer.
+ * advice An instance of a lttng_channel_advice struct.
+ *
+ * Returns zero if the element's value could be written.
+ * Negative values indicate an error.
+ */
+int mi_lttng_channel_advice(struct mi_writer *writer,
+		const struct lttng_channel_advice *advice);
+
 /*
 * Machine interface for event common attributes.
 *
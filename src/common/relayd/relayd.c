@@ -46,6 +46,27 @@ bool relayd_supports_get_configuration(const struct lttcomm_relayd_sock *sock)
 	return false;
 }
 
+static
+bool relayd_supports_add_streams(const struct lttcomm_relayd_sock *sock)
+{
+	if (sock->major > 2) {
+		return true;
+	} else if (sock->major == 2 && sock->minor >= 13) {
+		return true;
+	}
+	return false;
+}
+
+bool relayd_supports_send_beacons(const struct lttcomm_relayd_sock *sock)
+{
+	if (sock->major > 2) {
+		return true;
+	} else if (sock->major == 2 && sock->minor >= 13) {
+		return true;
+	}
+	return false;
+}
+
 /*
  * Send command. Fill up the header and append the data.
  */
@@ -482,6 +503,32 @@ error:
 	return ret;
 }
 
+/*
+ * Format the path of a stream, relative to the session's output, in
+ * `pathname` which must be at least RELAYD_COMM_LTTNG_PATH_MAX bytes long.
+ *
+ * Return 0 on success or else -1.
+ */
+static int format_stream_path(char *pathname, const char *domain_name,
+		const char *_pathname)
+{
+	int ret;
+	const char *separator;
+
+	if (_pathname[0] == '\0') {
+		separator = "";
+	} else {
+		separator = "/";
+	}
+	ret = snprintf(pathname, RELAYD_COMM_LTTNG_PATH_MAX, "%s%s%s",
+			domain_name, separator, _pathname);
+	if (ret <= 0 || ret >= RELAYD_COMM_LTTNG_PATH_MAX) {
+		ERR("stream path too long.");
+		return -1;
+	}
+	return 0;
+}
+
 /*
  * Add stream on the relayd and assign stream handle to the stream_id argument.
  *
@@ -499,7 +546,6 @@ int relayd_add_stream(struct lttcomm_relayd_sock *rsock, const char *channel_nam
 	int ret;
 	struct lttcomm_relayd_status_stream reply;
 	char pathname[RELAYD_COMM_LTTNG_PATH_MAX];
-	const char *separator;
 
 	/* Code flow error. Safety net. */
 	assert(rsock);
@@ -510,16 +556,8 @@ int relayd_add_stream(struct lttcomm_relayd_sock *rsock, const char *channel_nam
 
 	DBG("Relayd adding stream for channel name %s", channel_name);
 
-	if (_pathname[0] == '\0') {
-		separator = "";
-	} else {
-		separator = "/";
-	}
-	ret = snprintf(pathname, RELAYD_COMM_LTTNG_PATH_MAX, "%s%s%s",
-			domain_name, separator, _pathname);
-	if (ret <= 0 || ret >= RELAYD_COMM_LTTNG_PATH_MAX) {
-		ERR("stream path too long.");
-		ret = -1;
+	ret = format_stream_path(pathname, domain_name, _pathname);
+	if (ret) {
 		goto error;
 	}
 
@@ -578,6 +616,153 @@ error:
 	return ret;
 }
 
+/*
+ * Add a batch of streams sharing the same path on the relayd and assign
+ * their handles, in order, to the `stream_ids` array.
+ *
+ * A single command and a single reply are exchanged with relay daemons that
+ * support it (2.13+). Older relay daemons get one "add stream" command per
+ * stream.
+ *
+ * On success return 0 else return ret_code negative value.
+ */
+int relayd_add_streams(struct lttcomm_relayd_sock *rsock,
+		const char * const *stream_names, unsigned int stream_count,
+		const char *domain_name, const char *_pathname,
+		uint64_t *stream_ids, uint64_t tracefile_size,
+		uint64_t tracefile_count, struct lttng_trace_chunk *trace_chunk)
+{
+	int ret;
+	unsigned int i;
+	size_t names_len = 0, pathname_len;
+	uint64_t chunk_id;
+	enum lttng_trace_chunk_status chunk_status;
+	struct lttng_dynamic_buffer payload;
+	struct lttcomm_relayd_add_streams msg;
+	struct lttcomm_relayd_status_streams reply;
+	char pathname[RELAYD_COMM_LTTNG_PATH_MAX];
+
+	/* Code flow error. Safety net. */
+	assert(rsock);
+	assert(stream_names);
+	assert(domain_name);
+	assert(_pathname);
+	assert(stream_ids);
+	assert(trace_chunk);
+
+	lttng_dynamic_buffer_init(&payload);
+
+	if (stream_count == 0) {
+		ret = 0;
+		goto end;
+	}
+
+	if (!relayd_supports_add_streams(rsock)) {
+		for (i = 0; i < stream_count; i++) {
+			ret = relayd_add_stream(rsock, stream_names[i],
+					domain_name, _pathname, &stream_ids[i],
+					tracefile_size, tracefile_count,
+					trace_chunk);
+			if (ret) {
+				goto end;
+			}
+		}
+		ret = 0;
+		goto end;
+	}
+
+	DBG("Relayd adding %u streams of path %s", stream_count, _pathname);
+
+	ret = format_stream_path(pathname, domain_name, _pathname);
+	if (ret) {
+		goto end;
+	}
+
+	for (i = 0; i < stream_count; i++) {
+		names_len += strlen(stream_names[i]) + 1;
+	}
+	pathname_len = strlen(pathname) + 1;
+	assert(names_len <= UINT32_MAX);
+
+	chunk_status = lttng_trace_chunk_get_id(trace_chunk, &chunk_id);
+	assert(chunk_status == LTTNG_TRACE_CHUNK_STATUS_OK);
+
+	msg = (typeof(msg)) {
+		.stream_count = htobe32((uint32_t) stream_count),
+		.names_len = htobe32((uint32_t) names_len),
+		.pathname_len = htobe32((uint32_t) pathname_len),
+		.tracefile_size = htobe64(tracefile_size),
+		.tracefile_count = htobe64(tracefile_count),
+		.trace_chunk_id = htobe64(chunk_id),
+	};
+
+	ret = lttng_dynamic_buffer_append(&payload, &msg, sizeof(msg));
+	if (ret) {
+		goto error_alloc;
+	}
+	for (i = 0; i < stream_count; i++) {
+		ret = lttng_dynamic_buffer_append(&payload, stream_names[i],
+				strlen(stream_names[i]) + 1);
+		if (ret) {
+			goto error_alloc;
+		}
+	}
+	ret = lttng_dynamic_buffer_append(&payload, pathname, pathname_len);
+	if (ret) {
+		goto error_alloc;
+	}
+
+	ret = send_command(rsock, RELAYD_ADD_STREAMS, payload.data,
+			payload.size, 0);
+	if (ret < 0) {
+		ERR("Failed to send \"add streams\" command");
+		goto end;
+	}
+
+	/* The stream handles follow the fixed-size part of the reply. */
+	ret = recv_reply(rsock, &reply, sizeof(reply));
+	if (ret < 0) {
+		ERR("Failed to receive \"add streams\" command reply");
+		goto end;
+	}
+
+	reply.ret_code = be32toh(reply.ret_code);
+	reply.stream_count = be32toh(reply.stream_count);
+	if (reply.stream_count != stream_count) {
+		ERR("Relayd add streams replied with %" PRIu32 " stream handles, expected %u",
+				reply.stream_count, stream_count);
+		ret = -1;
+		goto end;
+	}
+
+	ret = recv_reply(rsock, stream_ids, sizeof(*stream_ids) * stream_count);
+	if (ret < 0) {
+		ERR("Failed to receive \"add streams\" command stream handles");
+		goto end;
+	}
+
+	if (reply.ret_code != LTTNG_OK) {
+		ret = -1;
+		ERR("Relayd add streams replied error %d", reply.ret_code);
+		goto end;
+	}
+
+	for (i = 0; i < stream_count; i++) {
+		stream_ids[i] = be64toh(stream_ids[i]);
+	}
+
+	DBG("Relayd added %u streams successfully", stream_count);
+	ret = 0;
+	goto end;
+
+error_alloc:
+	ERR("Failed to allocate \"add streams\" command payload");
+	ret = -1;
+end:
+	lttng_dynamic_buffer_reset(&payload);
+	return ret;
+}
+
 /*
  * Inform the relay that all the streams for the current channel has been sent.
  *
@@ -1145,6 +1330,89 @@ error:
 	return ret;
 }
 
+/*
+ * Send the live beacons of a batch of idle streams to the relayd in a single
+ * command. The beacons are in host byte order.
+ *
+ * This must only be used with relay daemons that support it (2.13+), as
+ * reported by relayd_supports_send_beacons().
+ *
+ * On success return 0 else return ret_code negative value.
+ */
+int relayd_send_beacons(struct lttcomm_relayd_sock *rsock,
+		const struct lttcomm_relayd_beacon *beacons,
+		unsigned int beacon_count)
+{
+	int ret;
+	unsigned int i;
+	struct lttng_dynamic_buffer payload;
+	struct lttcomm_relayd_beacons msg;
+	struct lttcomm_relayd_generic_reply reply;
+
+	/* Code flow error. Safety net. */
+	assert(rsock);
+	assert(beacons || beacon_count == 0);
+	assert(relayd_supports_send_beacons(rsock));
+
+	lttng_dynamic_buffer_init(&payload);
+
+	if (beacon_count == 0) {
+		ret = 0;
+		goto end;
+	}
+
+	DBG("Relayd sending %u live beacons", beacon_count);
+
+	msg.beacon_count = htobe32((uint32_t) beacon_count);
+	ret = lttng_dynamic_buffer_append(&payload, &msg, sizeof(msg));
+	if (ret) {
+		goto error_alloc;
+	}
+	for (i = 0; i < beacon_count; i++) {
+		const struct lttcomm_relayd_beacon beacon = {
+			.relay_stream_id = htobe64(beacons[i].relay_stream_id),
+			.net_seq_num = htobe64(beacons[i].net_seq_num),
+			.timestamp_end = htobe64(beacons[i].timestamp_end),
+		};
+
+		ret = lttng_dynamic_buffer_append(&payload, &beacon,
+				sizeof(beacon));
+		if (ret) {
+			goto error_alloc;
+		}
+	}
+
+	ret = send_command(rsock, RELAYD_SEND_BEACONS, payload.data,
+			payload.size, 0);
+	if (ret < 0) {
+		ERR("Failed to send \"send beacons\" command");
+		goto end;
+	}
+
+	ret = recv_reply(rsock, &reply, sizeof(reply));
+	if (ret < 0) {
+		ERR("Failed to receive \"send beacons\" command reply");
+		goto end;
+	}
+
+	reply.ret_code = be32toh(reply.ret_code);
+	if (reply.ret_code != LTTNG_OK) {
+		ret = -1;
+		ERR("Relayd send beacons replied error %d", reply.ret_code);
+		goto end;
+	}
+
+	ret = 0;
+	goto end;
+
+error_alloc:
+	ERR("Failed to allocate \"send beacons\" command payload");
+	ret = -1;
+end:
+	lttng_dynamic_buffer_reset(&payload);
+	return ret;
+}
+
 /*
  * Ask the relay to reset the metadata trace file (regeneration).
  */
@@ -42,6 +42,12 @@ int relayd_add_stream(struct lttcomm_relayd_sock *sock, const char *channel_name
 		const char *domain_name, const char *pathname, uint64_t *stream_id,
 		uint64_t tracefile_size, uint64_t tracefile_count,
 		struct lttng_trace_chunk *trace_chunk);
+/* `stream_names` and `stream_ids` are arrays of `stream_count` elements. */
+int relayd_add_streams(struct lttcomm_relayd_sock *rsock,
+		const char * const *stream_names, unsigned int stream_count,
+		const char *domain_name, const char *pathname,
+		uint64_t *stream_ids, uint64_t tracefile_size,
+		uint64_t tracefile_count, struct lttng_trace_chunk *trace_chunk);
 int relayd_streams_sent(struct lttcomm_relayd_sock *rsock);
 int relayd_send_close_stream(struct lttcomm_relayd_sock *sock, uint64_t stream_id,
 		uint64_t last_net_seq_num);
@@ -60,6 +66,10 @@ int relayd_end_data_pending(struct lttcomm_relayd_sock *sock, uint64_t id,
 int relayd_send_index(struct lttcomm_relayd_sock *rsock,
 		struct ctf_packet_index *index, uint64_t relay_stream_id,
 		uint64_t net_seq_num);
+bool relayd_supports_send_beacons(const struct lttcomm_relayd_sock *sock);
+int relayd_send_beacons(struct lttcomm_relayd_sock *rsock,
+		const struct lttcomm_relayd_beacon *beacons,
+		unsigned int beacon_count);
 int relayd_reset_metadata(struct lttcomm_relayd_sock *rsock,
 		uint64_t stream_id, uint64_t version);
 /* `positions` is an array of `stream_count` relayd_stream_rotation_position. */
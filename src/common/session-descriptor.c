@@ -498,6 +498,36 @@ error:
 	return NULL;
 }
 
+/* Ownership of uri is transferred. */
+static
+struct lttng_session_descriptor_live *
+_lttng_session_descriptor_live_local_create(const char *name,
+		struct lttng_uri *uri,
+		unsigned long long live_timer_interval_us)
+{
+	struct lttng_session_descriptor_live *descriptor;
+
+	descriptor = _lttng_session_descriptor_live_create(name,
+			live_timer_interval_us);
+	if (!descriptor) {
+		goto error;
+	}
+	descriptor->base.output_type =
+			LTTNG_SESSION_DESCRIPTOR_OUTPUT_TYPE_LOCAL;
+	if (uri) {
+		if (uri->dtype != LTTNG_DST_PATH) {
+			goto error;
+		}
+		descriptor->base.output.local = uri;
+		uri = NULL;
+	}
+	return descriptor;
+error:
+	free(uri);
+	lttng_session_descriptor_destroy(descriptor ? &descriptor->base : NULL);
+	return NULL;
+}
+
 /* Ownership of control and data is transferred. */
 static
 struct lttng_session_descriptor_live *
@@ -547,6 +577,27 @@ lttng_session_descriptor_live_create(
 	return descriptor ? &descriptor->base : NULL;
 }
 
+struct lttng_session_descriptor *
+lttng_session_descriptor_live_local_create(
+		const char *name, const char *path,
+		unsigned long long live_timer_us)
+{
+	struct lttng_uri *path_uri = NULL;
+	struct lttng_session_descriptor_live *descriptor;
+
+	if (path) {
+		path_uri = uri_from_path(path);
+		if (!path_uri) {
+			goto error;
+		}
+	}
+	descriptor = _lttng_session_descriptor_live_local_create(name,
+			path_uri, live_timer_us);
+	return descriptor ? &descriptor->base : NULL;
+error:
+	return NULL;
+}
+
 struct lttng_session_descriptor *
 lttng_session_descriptor_live_network_create(
 		const char *name,
@@ -777,8 +828,9 @@ skip_name:
 					live_timer_us);
 			break;
 		case LTTNG_SESSION_DESCRIPTOR_OUTPUT_TYPE_LOCAL:
-			ret = -1;
-			goto end;
+			live = _lttng_session_descriptor_live_local_create(
+					name, uris[0], live_timer_us);
+			break;
 		default:
 			/* Already checked. */
 			abort();
@@ -86,6 +86,23 @@ struct lttcomm_relayd_add_stream_2_11 {
 	char names[];
 } LTTNG_PACKED;
 
+/*
+ * Add a batch of streams sharing the same path and tracefile geometry.
+ *
+ * `names` contains `stream_count` NULL-terminated stream names followed by
+ * the NULL-terminated pathname. `names_len` is the total length of the
+ * stream names, including their terminators.
+ */
+struct lttcomm_relayd_add_streams {
+	uint32_t stream_count;
+	uint32_t names_len;
+	uint32_t pathname_len;
+	uint64_t tracefile_size;
+	uint64_t tracefile_count;
+	uint64_t trace_chunk_id;
+	char names[];
+} LTTNG_PACKED;
+
 /*
  * Answer from an add stream command.
  */
@@ -94,6 +111,16 @@ struct lttcomm_relayd_status_stream {
 	uint32_t ret_code;
 } LTTNG_PACKED;
 
+/*
+ * Answer from an add streams command. `stream_count` stream handles, in the
+ * order in which the streams were announced, follow.
+ */
+struct lttcomm_relayd_status_streams {
+	uint32_t ret_code;
+	uint32_t stream_count;
+	uint64_t handles[];
+} LTTNG_PACKED;
+
 /*
  * Used to return command code for command not needing special data.
  */
@@ -164,6 +191,27 @@ struct lttcomm_relayd_index {
 	uint64_t packet_seq_num;
 } LTTNG_PACKED;
 
+/*
+ * Live beacon of an idle stream.
+ *
+ * `net_seq_num` is the sequence number of the last packet sent for the
+ * stream when it was found idle, or -1ULL if none was sent. It allows the
+ * relay daemon to discard beacons that were overtaken by an index.
+ */
+struct lttcomm_relayd_beacon {
+	uint64_t relay_stream_id;
+	uint64_t net_seq_num;
+	uint64_t timestamp_end;
+} LTTNG_PACKED;
+
+/*
+ * Batch of live beacons. `beacon_count` beacons follow.
+ */
+struct lttcomm_relayd_beacons {
+	uint32_t beacon_count;
+	struct lttcomm_relayd_beacon beacons[];
+} LTTNG_PACKED;
+
 static inline size_t lttcomm_relayd_index_len(uint32_t major, uint32_t minor)
 {
 	if (major == 1) {
@@ -107,6 +107,11 @@ enum lttcomm_sessiond_command {
 	LTTNG_CREATE_SESSION_EXT                        = 49,
 	LTTNG_CLEAR_SESSION                             = 50,
 	LTTNG_LIST_TRIGGERS                             = 51,
+	LTTNG_ENABLE_EVENTS                             = 52,
+	LTTNG_SET_SESSION_LOCAL_COPY_PATH               = 53,
+	LTTNG_LIST_COUNTER_MAP                          = 54,
+	LTTNG_CLEAR_COUNTER_MAP                         = 55,
+	LTTNG_GET_CHANNEL_ADVICE                        = 56,
 };
 
 static inline
@@ -197,6 +202,16 @@ const char *lttcomm_sessiond_command_str(enum lttcomm_sessiond_command cmd)
 		return "LTTNG_CLEAR_SESSION";
 	case LTTNG_LIST_TRIGGERS:
 		return "LTTNG_LIST_TRIGGERS";
+	case LTTNG_ENABLE_EVENTS:
+		return "LTTNG_ENABLE_EVENTS";
+	case LTTNG_SET_SESSION_LOCAL_COPY_PATH:
+		return "LTTNG_SET_SESSION_LOCAL_COPY_PATH";
+	case LTTNG_LIST_COUNTER_MAP:
+		return "LTTNG_LIST_COUNTER_MAP";
+	case LTTNG_CLEAR_COUNTER_MAP:
+		return "LTTNG_CLEAR_COUNTER_MAP";
+	case LTTNG_GET_CHANNEL_ADVICE:
+		return "LTTNG_GET_CHANNEL_ADVICE";
 	default:
 		abort();
 	}
@@ -233,6 +248,10 @@ enum lttcomm_relayd_command {
 	RELAYD_TRACE_CHUNK_EXISTS           = 21,
 	/* Get the current configuration of a relayd peer (2.12+) */
 	RELAYD_GET_CONFIGURATION            = 22,
+	/* Add all the streams of a channel at once (2.13+). */
+	RELAYD_ADD_STREAMS                  = 23,
+	/* Send the live beacons of a batch of idle streams (2.13+). */
+	RELAYD_SEND_BEACONS                 = 24,
 
 	/* Feature branch specific commands start at 10000. */
 };
@@ -279,6 +298,7 @@ enum lttcomm_return_code {
 	LTTCOMM_CONSUMERD_UNKNOWN_TRACE_CHUNK,      /* Unknown trace chunk. */
 	LTTCOMM_CONSUMERD_RELAYD_CLEAR_DISALLOWED,  /* Relayd does not accept clear command. */
 	LTTCOMM_CONSUMERD_UNKNOWN_ERROR,            /* Unknown error. */
+	LTTCOMM_CONSUMERD_APP_EXITING,              /* Application exited during a buffer handoff. */
 
 	/* MUST be last element */
 	LTTCOMM_NR,						/* Last element */
@@ -408,6 +428,16 @@ struct lttcomm_session_msg {
 			 * - unsigned char filter_bytecode[bytecode_len]
 			 */
 		} LTTNG_PACKED disable;
+		/* Enable a set of events */
+		struct {
+			char channel_name[LTTNG_SYMBOL_NAME_LEN];
+			uint32_t event_count;
+			/*
+			 * After this structure, event_count struct lttng_event
+			 * are transmitted. The reply holds the int32_t status
+			 * of each event.
+			 */
+		} LTTNG_PACKED enable_events;
 		/* Create channel */
 		struct {
 			struct lttng_channel chan;
@@ -427,6 +457,15 @@ struct lttcomm_session_msg {
 		/* List */
 		struct {
 			char channel_name[LTTNG_SYMBOL_NAME_LEN];
+			/*
+			 * Star-only globbing pattern that the names of the
+			 * listed objects must match. Empty to list all.
+			 */
+			char name_pattern[LTTNG_SYMBOL_NAME_LEN];
+			/* Number of matching objects to skip. */
+			uint32_t cursor;
+			/* Maximal number of objects to list, 0 for no limit. */
+			uint32_t max_count;
 		} LTTNG_PACKED list;
 		struct lttng_calibrate calibrate;
 		/* Used by the set_consumer_url and used by create_session also call */
@@ -440,6 +479,17 @@ struct lttcomm_session_msg {
 		struct {
 			uint32_t wait;
 			struct lttng_snapshot_output output;
+			/*
+			 * Only record the packets which end within this
+			 * window, 0 to record every packet.
+			 */
+			uint64_t time_window_us;
+			/*
+			 * Number of channel names to record, 0 to record every
+			 * channel. The names follow this structure as
+			 * char channel_names[LTTNG_SYMBOL_NAME_LEN][channel_count].
+			 */
+			uint32_t channel_count;
 		} LTTNG_PACKED snapshot_record;
 		struct {
 			uint32_t nb_uri;
@@ -451,6 +501,9 @@ struct lttcomm_session_msg {
 		struct {
 			char shm_path[PATH_MAX];
 		} LTTNG_PACKED set_shm_path;
+		struct {
+			char path[PATH_MAX];
+		} LTTNG_PACKED set_local_copy_path;
 		struct {
 			/* enum lttng_process_attr */
 			int32_t process_attr;
@@ -484,6 +537,12 @@ struct lttcomm_session_msg {
 		struct {
 			uint32_t length;
 		} LTTNG_PACKED trigger;
+		struct {
+			char map_name[LTTNG_SYMBOL_NAME_LEN];
+		} LTTNG_PACKED counter_map;
+		struct {
+			char channel_name[LTTNG_SYMBOL_NAME_LEN];
+		} LTTNG_PACKED channel_advice;
 		struct {
 			uint64_t rotation_id;
 		} LTTNG_PACKED get_rotation_info;
@@ -514,6 +573,8 @@ struct lttcomm_session_msg {
 } LTTNG_PACKED;
 
 #define LTTNG_FILTER_MAX_LEN	65536
+#define LTTNG_ENABLE_EVENTS_MAX_COUNT	4096
+#define LTTNG_SNAPSHOT_RECORD_MAX_CHANNEL_COUNT	4096
 #define LTTNG_SESSION_DESCRIPTOR_MAX_LEN	65536
 
 /*
@@ -609,6 +670,14 @@ struct lttcomm_lttng_output_id {
 	uint32_t id;
 } LTTNG_PACKED;
 
+/*
+ * Attributes of a stream handed to the consumer as part of an
+ * LTTNG_CONSUMER_ADD_STREAMS command.
+ */
+struct lttcomm_consumer_stream_info {
+	int32_t cpu;	/* On which CPU this stream is assigned. */
+} LTTNG_PACKED;
+
 /*
  * lttcomm_consumer_msg is the message sent from sessiond to consumerd
  * to either add a channel, add a stream, update a stream, or stop
@@ -640,6 +709,9 @@ struct lttcomm_consumer_msg {
 			uint8_t is_live;
 			/* timer to sample a channel's positions (usec). */
 			unsigned int monitor_timer_interval;
+			/* Data left in flight before waiting on writeback. */
+			uint64_t writeback_window_size;	/* bytes */
+			uint8_t direct_io;		/* Open files with O_DIRECT. */
 		} LTTNG_PACKED channel; /* Only used by Kernel. */
 		struct {
 			uint64_t stream_key;
@@ -648,6 +720,15 @@ struct lttcomm_consumer_msg {
 			/* Tells the consumer if the stream should be or not monitored. */
 			uint32_t no_monitor;
 		} LTTNG_PACKED stream;	/* Only used by Kernel. */
+		struct {
+			uint64_t channel_key;
+			/*
+			 * Number of streams added. Followed by as many
+			 * struct lttcomm_consumer_stream_info and stream file
+			 * descriptors.
+			 */
+			uint32_t stream_count;
+		} LTTNG_PACKED streams;	/* Only used by Kernel. */
 		struct {
 			uint64_t net_index;
 			enum lttng_stream_type type;
@@ -702,12 +783,23 @@ struct lttcomm_consumer_msg {
 			 */
 			uint32_t ust_app_uid;
 			int64_t blocking_timeout;
+			uint64_t writeback_window_size;	/* bytes */
+			uint8_t direct_io;		/* Open files with O_DIRECT. */
 			char root_shm_path[PATH_MAX];
 			char shm_path[PATH_MAX];
 		} LTTNG_PACKED ask_channel;
 		struct {
 			uint64_t key;
 		} LTTNG_PACKED get_channel;
+		struct {
+			uint64_t key;
+			/*
+			 * Handle of the session object of the application
+			 * whose command socket is sent right after this
+			 * message.
+			 */
+			int32_t session_handle;
+		} LTTNG_PACKED send_channel_to_app;
 		struct {
 			uint64_t key;
 		} LTTNG_PACKED destroy_channel;
@@ -729,6 +821,13 @@ struct lttcomm_consumer_msg {
 		struct {
 			uint64_t key;	/* Channel key. */
 		} LTTNG_PACKED clear_quiescent_channel;
+		struct {
+			/*
+			 * Number of channel keys (uint64_t) sent right after
+			 * this message.
+			 */
+			uint32_t count;
+		} LTTNG_PACKED flush_channels;
 		struct {
 			char pathname[PATH_MAX];
 			/* Indicate if the snapshot goes on the relayd or locally. */
@@ -737,6 +836,11 @@ struct lttcomm_consumer_msg {
 			uint64_t relayd_id;		/* Relayd id if apply. */
 			uint64_t key;
 			uint64_t nb_packets_per_stream;
+			/*
+			 * The packets which end before this timestamp are
+			 * skipped, 0 to record every packet.
+			 */
+			uint64_t begin_timestamp;
 		} LTTNG_PACKED snapshot_channel;
 		struct {
 			uint64_t channel_key;
@@ -810,9 +914,47 @@ struct lttcomm_consumer_msg {
 		struct {
 			uint64_t key;
 		} LTTNG_PACKED open_channel_packets;
+		struct {
+			uint64_t session_id;
+			uint32_t live_timer;			/* usec */
+			char session_name[LTTNG_NAME_MAX];
+			char hostname[LTTNG_HOST_NAME_MAX];
+		} LTTNG_PACKED add_live_session;
+		struct {
+			uint64_t session_id;
+		} LTTNG_PACKED close_live_session;
+		struct {
+			uint64_t session_id;
+			/* UUID of the registry the buffer set is reserved for. */
+			lttng_uuid uuid;
+			/*
+			 * Number of channels (struct
+			 * lttcomm_consumer_buffer_set_channel) sent right after
+			 * this message.
+			 */
+			uint32_t channel_count;
+		} LTTNG_PACKED prepare_buffer_set;
+		struct {
+			uint64_t session_id;
+		} LTTNG_PACKED destroy_buffer_pool;
 	} u;
 } LTTNG_PACKED;
 
+/*
+ * Per-CPU channel of a buffer set pre-created by an UST consumer for a
+ * per-PID session (LTTNG_CONSUMER_PREPARE_BUFFER_SET). The buffers use the
+ * mmap output.
+ */
+struct lttcomm_consumer_buffer_set_channel {
+	uint32_t chan_id;			/* Channel ID on the tracer side. */
+	uint64_t subbuf_size;			/* bytes */
+	uint64_t num_subbuf;			/* power of 2 */
+	int32_t overwrite;			/* 1: overwrite, 0: discard */
+	uint32_t switch_timer_interval;		/* usec */
+	uint32_t read_timer_interval;		/* usec */
+	int64_t blocking_timeout;
+} LTTNG_PACKED;
+
 /*
  * Channel monitoring message returned to the session daemon on every
  * monitor timer expiration.
@@ -125,6 +125,85 @@ bool strutils_is_star_at_the_end_only_glob_pattern(const char *pattern)
 		STAR_GLOB_PATTERN_TYPE_FLAG_END_ONLY;
 }
 
+/*
+ * Returns true if the string `candidate` matches the star-only globbing
+ * pattern `pattern`. In `pattern`, a non-escaped `*` matches any sequence
+ * of characters (including none) and `\x` matches the character `x`.
+ */
+LTTNG_HIDDEN
+bool strutils_star_glob_match(const char *pattern, const char *candidate)
+{
+	const char *retry_c = candidate, *retry_p = pattern, *c, *p;
+	bool got_a_star = false;
+
+	assert(pattern);
+	assert(candidate);
+
+retry:
+	c = retry_c;
+	p = retry_p;
+
+	/*
+	 * The concept here is to retry a match in the specific case
+	 * where we already got a star. The retry position for the
+	 * pattern is just after the most recent star, and the retry
+	 * position for the candidate is the character following the
+	 * last try's first character.
+	 */
+	while (*c != '\0') {
+		switch (*p) {
+		case '\0':
+			goto end_of_pattern;
+		case '*':
+			got_a_star = true;
+
+			/* Consecutive stars are equivalent to a single one. */
+			while (*p == '*') {
+				p++;
+			}
+
+			/* A trailing star matches the rest of the candidate. */
+			if (*p == '\0') {
+				return true;
+			}
+
+			retry_p = p;
+			retry_c = c;
+			continue;
+		case '\\':
+			p++;
+			if (*p == '\0') {
+				goto end_of_pattern;
+			}
+			/* Fall through. */
+		default:
+			if (*p != *c) {
+				goto end_of_pattern;
+			}
+			break;
+		}
+
+		c++;
+		p++;
+	}
+
+	/* The candidate is exhausted: only stars may remain in the pattern. */
+	while (*p == '*') {
+		p++;
+	}
+
+	return *p == '\0';
+
+end_of_pattern:
+	if (!got_a_star) {
+		return false;
+	}
+
+	/* Let the most recent star consume one more character and retry. */
+	retry_c++;
+	goto retry;
+}
+
 /*
  * Unescapes the input string `input`, that is, in a `\x` sequence,
  * removes `\`. If `only_char` is not 0, only this character is
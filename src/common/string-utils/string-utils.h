@@ -20,6 +20,9 @@ bool strutils_is_star_glob_pattern(const char *pattern);
 LTTNG_HIDDEN
 bool strutils_is_star_at_the_end_only_glob_pattern(const char *pattern);
 
+LTTNG_HIDDEN
+bool strutils_star_glob_match(const char *pattern, const char *candidate);
+
 LTTNG_HIDDEN
 char *strutils_unescape_string(const char *input, char only_char);
 
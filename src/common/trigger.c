@@ -14,6 +14,7 @@
 #include <lttng/event-rule/event-rule-internal.h>
 #include <lttng/event-expr-internal.h>
 #include <lttng/action/action-internal.h>
+#include <lttng/action/increment-counter-internal.h>
 #include <common/credentials.h>
 #include <common/payload.h>
 #include <common/payload-view.h>
@@ -40,7 +41,9 @@ bool lttng_trigger_validate(const struct lttng_trigger *trigger)
 	}
 
 	valid = lttng_condition_validate(trigger->condition) &&
-			lttng_action_validate(trigger->action);
+			lttng_action_validate(trigger->action) &&
+			lttng_action_counter_key_captures_are_valid(
+					trigger->action, trigger->condition);
 end:
 	return valid;
 }
@@ -259,6 +259,34 @@ end:
 	return ret;
 }
 
+/*
+ * Peek at up to len bytes of data available on the unix socket, without
+ * blocking and without consuming them.
+ *
+ * Return the size of the data peeked at, 0 if none is available or -1 on
+ * error.
+ */
+LTTNG_HIDDEN
+ssize_t lttcomm_peek_unix_sock_non_block(int sock, void *buf, size_t len)
+{
+	ssize_t ret;
+
+	do {
+		ret = recv(sock, buf, len, MSG_PEEK | MSG_DONTWAIT);
+	} while (ret < 0 && errno == EINTR);
+	if (ret < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			/* Nothing available. */
+			ret = 0;
+		} else {
+			PERROR("recv");
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
+
 /*
  * Send buf data of size len. Using sendmsg API.
  *
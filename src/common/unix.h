@@ -59,6 +59,8 @@ ssize_t lttcomm_recv_unix_sock(int sock, void *buf, size_t len);
 LTTNG_HIDDEN
 ssize_t lttcomm_recv_unix_sock_non_block(int sock, void *buf, size_t len);
 LTTNG_HIDDEN
+ssize_t lttcomm_peek_unix_sock_non_block(int sock, void *buf, size_t len);
+LTTNG_HIDDEN
 ssize_t lttcomm_send_unix_sock(int sock, const void *buf, size_t len);
 LTTNG_HIDDEN
 ssize_t lttcomm_send_unix_sock_non_block(int sock, const void *buf, size_t len);
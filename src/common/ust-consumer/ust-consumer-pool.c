@@ -0,0 +1,407 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#define _LGPL_SOURCE
+#include <inttypes.h>
+#include <lttng/ust-ctl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <urcu/futex.h>
+#include <urcu/list.h>
+#include <urcu/uatomic.h>
+#include <urcu/wfcqueue.h>
+
+#include <bin/lttng-consumerd/health-consumerd.h>
+#include <common/common.h>
+#include <common/futex.h>
+#include <common/shm.h>
+
+#include "ust-consumer-pool.h"
+
+enum pool_entry_state {
+	/* Queued to the pool thread. */
+	POOL_ENTRY_PENDING,
+	/* Being created by the pool thread, without the pool lock. */
+	POOL_ENTRY_CREATING,
+	POOL_ENTRY_READY,
+};
+
+/* Buffers of one channel of a reserved buffer set. */
+struct pool_entry {
+	uint64_t session_id;
+	/* Holds the registry uuid and the channel ID of the reservation. */
+	struct ustctl_consumer_channel_attr attr;
+	enum pool_entry_state state;
+	/*
+	 * Set when the entry is removed from the pool while it is owned by
+	 * the pool thread, which then destroys it.
+	 */
+	bool cancelled;
+	struct ustctl_consumer_channel *uchan;
+	int *stream_fds;
+	int nr_stream_fds;
+	/* Node of the pool's entries, unless cancelled. */
+	struct cds_list_head node;
+	/* Node of the pool thread's queue while pending. */
+	struct cds_wfcq_node queue_node;
+};
+
+static struct {
+	/* Protects the lists and the state of the entries. */
+	pthread_mutex_t lock;
+	struct cds_list_head entries;
+	struct cds_wfcq_head head;
+	struct cds_wfcq_tail tail;
+	int32_t futex;
+	int quit;
+} pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.entries = CDS_LIST_HEAD_INIT(pool.entries),
+	.futex = 0,
+	.quit = 0,
+};
+
+static void close_stream_fds(int *stream_fds, int nr_stream_fds)
+{
+	int i;
+
+	for (i = 0; i < nr_stream_fds; i++) {
+		if (stream_fds[i] >= 0 && close(stream_fds[i])) {
+			PERROR("close pooled stream shm");
+		}
+	}
+	free(stream_fds);
+}
+
+static void pool_entry_destroy(struct pool_entry *entry)
+{
+	if (entry->uchan) {
+		ustctl_destroy_channel(entry->uchan);
+	}
+	if (entry->stream_fds) {
+		close_stream_fds(entry->stream_fds, entry->nr_stream_fds);
+	}
+	free(entry);
+}
+
+/*
+ * The attributes are compared member-wise since the structure is filled
+ * field by field by its users.
+ */
+static bool attr_equal(const struct ustctl_consumer_channel_attr *a,
+		const struct ustctl_consumer_channel_attr *b)
+{
+	return a->type == b->type &&
+			a->subbuf_size == b->subbuf_size &&
+			a->num_subbuf == b->num_subbuf &&
+			a->overwrite == b->overwrite &&
+			a->switch_timer_interval == b->switch_timer_interval &&
+			a->read_timer_interval == b->read_timer_interval &&
+			a->output == b->output &&
+			a->chan_id == b->chan_id &&
+			a->blocking_timeout == b->blocking_timeout &&
+			!memcmp(a->uuid, b->uuid, sizeof(a->uuid));
+}
+
+/*
+ * Create the buffers of an entry in new anonymous shared memory. The shared
+ * memory of a released channel is never reused: its application, or a child
+ * it forked, may still hold a copy of its file descriptors.
+ */
+static int pool_entry_create(struct pool_entry *entry)
+{
+	int i, nr_stream_fds;
+	int *stream_fds = NULL;
+
+	nr_stream_fds = ustctl_get_nr_stream_per_channel();
+
+	stream_fds = zmalloc(nr_stream_fds * sizeof(*stream_fds));
+	if (!stream_fds) {
+		PERROR("zmalloc pooled stream fds");
+		goto error;
+	}
+	for (i = 0; i < nr_stream_fds; i++) {
+		stream_fds[i] = -1;
+	}
+	for (i = 0; i < nr_stream_fds; i++) {
+		stream_fds[i] = shm_create_anonymous("ust-consumer");
+		if (stream_fds[i] < 0) {
+			goto error;
+		}
+	}
+
+	entry->uchan = ustctl_create_channel(&entry->attr, stream_fds,
+			nr_stream_fds);
+	if (!entry->uchan) {
+		ERR("Failed to create pooled channel %" PRIu32 " of session %" PRIu64,
+				entry->attr.chan_id, entry->session_id);
+		goto error;
+	}
+	entry->stream_fds = stream_fds;
+	entry->nr_stream_fds = nr_stream_fds;
+	return 0;
+
+error:
+	if (stream_fds) {
+		close_stream_fds(stream_fds, nr_stream_fds);
+	}
+	return -1;
+}
+
+static void pool_entry_process(struct pool_entry *entry)
+{
+	int ret;
+
+	pthread_mutex_lock(&pool.lock);
+	if (entry->cancelled) {
+		pthread_mutex_unlock(&pool.lock);
+		goto destroy;
+	}
+	entry->state = POOL_ENTRY_CREATING;
+	pthread_mutex_unlock(&pool.lock);
+
+	ret = pool_entry_create(entry);
+
+	pthread_mutex_lock(&pool.lock);
+	if (entry->cancelled) {
+		pthread_mutex_unlock(&pool.lock);
+		goto destroy;
+	}
+	if (ret) {
+		cds_list_del(&entry->node);
+		pthread_mutex_unlock(&pool.lock);
+		goto destroy;
+	}
+	entry->state = POOL_ENTRY_READY;
+	pthread_mutex_unlock(&pool.lock);
+	return;
+
+destroy:
+	pool_entry_destroy(entry);
+}
+
+void lttng_ustconsumer_pool_init(void)
+{
+	cds_wfcq_init(&pool.head, &pool.tail);
+}
+
+int lttng_ustconsumer_pool_prepare(uint64_t session_id, const lttng_uuid uuid,
+		const struct lttcomm_consumer_buffer_set_channel *channels,
+		uint32_t channel_count)
+{
+	uint32_t i;
+	struct cds_list_head entries;
+	struct pool_entry *entry, *tmp;
+
+	CDS_INIT_LIST_HEAD(&entries);
+
+	for (i = 0; i < channel_count; i++) {
+		entry = zmalloc(sizeof(*entry));
+		if (!entry) {
+			PERROR("zmalloc pool entry");
+			goto error;
+		}
+
+		entry->session_id = session_id;
+		entry->state = POOL_ENTRY_PENDING;
+		entry->attr.type = LTTNG_UST_ABI_CHAN_PER_CPU;
+		entry->attr.output = LTTNG_UST_ABI_MMAP;
+		entry->attr.chan_id = channels[i].chan_id;
+		entry->attr.subbuf_size = channels[i].subbuf_size;
+		entry->attr.num_subbuf = channels[i].num_subbuf;
+		entry->attr.overwrite = channels[i].overwrite;
+		entry->attr.switch_timer_interval =
+				channels[i].switch_timer_interval;
+		entry->attr.read_timer_interval =
+				channels[i].read_timer_interval;
+		entry->attr.blocking_timeout = channels[i].blocking_timeout;
+		memcpy(entry->attr.uuid, uuid, sizeof(entry->attr.uuid));
+		cds_wfcq_node_init(&entry->queue_node);
+		cds_list_add_tail(&entry->node, &entries);
+	}
+
+	/* Publish the entries before the pool thread can see them. */
+	pthread_mutex_lock(&pool.lock);
+	cds_list_for_each_entry(entry, &entries, node) {
+		cds_wfcq_enqueue(&pool.head, &pool.tail, &entry->queue_node);
+	}
+	cds_list_splice(&entries, &pool.entries);
+	pthread_mutex_unlock(&pool.lock);
+
+	futex_nto1_wake(&pool.futex);
+	DBG("Queued buffer set of %" PRIu32 " channels for session %" PRIu64,
+			channel_count, session_id);
+	return 0;
+
+error:
+	cds_list_for_each_entry_safe(entry, tmp, &entries, node) {
+		cds_list_del(&entry->node);
+		free(entry);
+	}
+	return -1;
+}
+
+void lttng_ustconsumer_pool_destroy_session(uint64_t session_id)
+{
+	struct cds_list_head released;
+	struct pool_entry *entry, *tmp;
+
+	CDS_INIT_LIST_HEAD(&released);
+
+	pthread_mutex_lock(&pool.lock);
+	cds_list_for_each_entry_safe(entry, tmp, &pool.entries, node) {
+		if (entry->session_id != session_id) {
+			continue;
+		}
+		cds_list_del(&entry->node);
+		if (entry->state == POOL_ENTRY_READY) {
+			cds_list_add(&entry->node, &released);
+		} else {
+			entry->cancelled = true;
+		}
+	}
+	pthread_mutex_unlock(&pool.lock);
+
+	cds_list_for_each_entry_safe(entry, tmp, &released, node) {
+		cds_list_del(&entry->node);
+		pool_entry_destroy(entry);
+	}
+}
+
+bool lttng_ustconsumer_pool_take(struct lttng_consumer_channel *channel,
+		const struct ustctl_consumer_channel_attr *attr)
+{
+	bool taken = false;
+	struct pool_entry *entry, *found = NULL;
+
+	if (channel->type != CONSUMER_CHANNEL_TYPE_DATA ||
+			channel->shm_path[0]) {
+		goto end;
+	}
+
+	pthread_mutex_lock(&pool.lock);
+	cds_list_for_each_entry(entry, &pool.entries, node) {
+		if (entry->session_id == channel->session_id &&
+				entry->attr.chan_id == attr->chan_id &&
+				!memcmp(entry->attr.uuid, attr->uuid,
+					sizeof(attr->uuid))) {
+			found = entry;
+			break;
+		}
+	}
+	if (!found) {
+		pthread_mutex_unlock(&pool.lock);
+		goto end;
+	}
+
+	/* The reservation is used up whether its buffers are ready or not. */
+	cds_list_del(&found->node);
+	if (found->state != POOL_ENTRY_READY) {
+		found->cancelled = true;
+		pthread_mutex_unlock(&pool.lock);
+		DBG("Pooled channel %" PRIu32 " of session %" PRIu64 " not ready",
+				attr->chan_id, channel->session_id);
+		goto end;
+	}
+	pthread_mutex_unlock(&pool.lock);
+
+	if (!attr_equal(&found->attr, attr)) {
+		DBG("Pooled channel %" PRIu32 " of session %" PRIu64 " does not match",
+				attr->chan_id, channel->session_id);
+		pool_entry_destroy(found);
+		goto end;
+	}
+
+	channel->uchan = found->uchan;
+	channel->stream_fds = found->stream_fds;
+	channel->nr_stream_fds = found->nr_stream_fds;
+	free(found);
+	taken = true;
+	DBG("Channel %" PRIu64 " takes pooled buffers", channel->key);
+end:
+	return taken;
+}
+
+/*
+ * Create the buffers of every queued entry. Entries are only destroyed,
+ * without creating their buffers, when the thread is exiting.
+ */
+static void pool_queue_drain(bool process)
+{
+	struct cds_wfcq_node *node;
+
+	while ((node = cds_wfcq_dequeue_blocking(&pool.head, &pool.tail))) {
+		struct pool_entry *entry = caa_container_of(node,
+				struct pool_entry, queue_node);
+
+		health_code_update();
+		if (process) {
+			pool_entry_process(entry);
+			continue;
+		}
+
+		pthread_mutex_lock(&pool.lock);
+		if (!entry->cancelled) {
+			cds_list_del(&entry->node);
+		}
+		pthread_mutex_unlock(&pool.lock);
+		pool_entry_destroy(entry);
+	}
+}
+
+static void pool_release_all(void)
+{
+	struct pool_entry *entry, *tmp;
+
+	pthread_mutex_lock(&pool.lock);
+	cds_list_for_each_entry_safe(entry, tmp, &pool.entries, node) {
+		cds_list_del(&entry->node);
+		pool_entry_destroy(entry);
+	}
+	pthread_mutex_unlock(&pool.lock);
+}
+
+void *lttng_ustconsumer_pool_thread(void *data)
+{
+	rcu_register_thread();
+
+	health_register(health_consumerd, HEALTH_CONSUMERD_TYPE_BUFFER_POOL);
+
+	DBG("Consumer buffer pool thread started");
+
+	for (;;) {
+		health_code_update();
+
+		/* Atomically prepare the queue futex */
+		futex_nto1_prepare(&pool.futex);
+
+		if (CMM_LOAD_SHARED(pool.quit)) {
+			break;
+		}
+
+		pool_queue_drain(true);
+
+		/* Futex wait on queue. Blocking call on futex() */
+		health_poll_entry();
+		futex_nto1_wait(&pool.futex);
+		health_poll_exit();
+	}
+
+	pool_queue_drain(false);
+	pool_release_all();
+
+	DBG("Consumer buffer pool thread exiting");
+	health_unregister(health_consumerd);
+	rcu_unregister_thread();
+	return NULL;
+}
+
+void lttng_ustconsumer_pool_thread_quit(void)
+{
+	CMM_STORE_SHARED(pool.quit, 1);
+	futex_nto1_wake(&pool.futex);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#ifndef LTTNG_UST_CONSUMER_POOL_H
+#define LTTNG_UST_CONSUMER_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <common/consumer/consumer.h>
+#include <common/sessiond-comm/sessiond-comm.h>
+#include <common/uuid.h>
+
+struct ustctl_consumer_channel_attr;
+
+/*
+ * Pool of per-PID channel buffers created ahead of the registration of the
+ * applications (see the --ust-buffer-pool-size option of the session daemon).
+ *
+ * The session daemon reserves buffer sets, identified by the uuid of the
+ * registry of a future application, and the pool thread creates their
+ * channels in the background. When the session daemon asks for the creation
+ * of a channel matching a pooled one, the pooled buffers are handed over as
+ * is. Pooled buffers are always backed by new anonymous shared memory.
+ */
+
+#ifdef HAVE_LIBLTTNG_UST_CTL
+
+/* Initialize the pool. Must be called before launching the pool thread. */
+void lttng_ustconsumer_pool_init(void);
+void *lttng_ustconsumer_pool_thread(void *data);
+/* Ask the pool thread to exit and release every pooled buffer. */
+void lttng_ustconsumer_pool_thread_quit(void);
+
+/* Commands of the session daemon. */
+int lttng_ustconsumer_pool_prepare(uint64_t session_id, const lttng_uuid uuid,
+		const struct lttcomm_consumer_buffer_set_channel *channels,
+		uint32_t channel_count);
+void lttng_ustconsumer_pool_destroy_session(uint64_t session_id);
+
+/*
+ * Hand the pooled buffers matching the attributes of a new channel over to
+ * it, setting its ustctl channel and stream file descriptors. Return true on
+ * success, false if the buffers must be created.
+ */
+bool lttng_ustconsumer_pool_take(struct lttng_consumer_channel *channel,
+		const struct ustctl_consumer_channel_attr *attr);
+
+#else /* HAVE_LIBLTTNG_UST_CTL */
+
+static inline
+void lttng_ustconsumer_pool_init(void)
+{
+}
+
+static inline
+void *lttng_ustconsumer_pool_thread(void *data)
+{
+	return NULL;
+}
+
+static inline
+void lttng_ustconsumer_pool_thread_quit(void)
+{
+}
+
+#endif /* HAVE_LIBLTTNG_UST_CTL */
+
+#endif /* LTTNG_UST_CONSUMER_POOL_H */
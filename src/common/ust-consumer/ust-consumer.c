@@ -17,6 +17,7 @@
 #include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <inttypes.h>
 #include <unistd.h>
@@ -32,6 +33,7 @@
 #include <common/compat/fcntl.h>
 #include <common/compat/endian.h>
 #include <common/consumer/consumer-metadata-cache.h>
+#include <common/consumer/consumer-live.h>
 #include <common/consumer/consumer-stream.h>
 #include <common/consumer/consumer-timer.h>
 #include <common/utils.h>
@@ -41,6 +43,7 @@
 #include <common/optional.h>
 
 #include "ust-consumer.h"
+#include "ust-consumer-pool.h"
 
 #define INT_MAX_STR_LEN 12	/* includes \0 */
 
@@ -505,7 +508,6 @@ static int send_channel_to_sessiond_and_relayd(int sock,
 {
 	int ret, ret_code = LTTCOMM_CONSUMERD_SUCCESS;
 	struct lttng_consumer_stream *stream;
-	uint64_t net_seq_idx = -1ULL;
 
 	assert(channel);
 	assert(ctx);
@@ -514,27 +516,25 @@ static int send_channel_to_sessiond_and_relayd(int sock,
 	DBG("UST consumer sending channel %s to sessiond", channel->name);
 
 	if (channel->relayd_id != (uint64_t) -1ULL) {
-		cds_list_for_each_entry(stream, &channel->streams.head, send_node) {
-
-			health_code_update();
+		health_code_update();
 
-			/* Try to send the stream to the relayd if one is available. */
-			DBG("Sending stream %" PRIu64 " of channel \"%s\" to relayd",
-					stream->key, channel->name);
-			ret = consumer_send_relayd_stream(stream, stream->chan->pathname);
-			if (ret < 0) {
-				/*
-				 * Flag that the relayd was the problem here probably due to a
-				 * communicaton error on the socket.
-				 */
-				if (relayd_error) {
-					*relayd_error = 1;
-				}
-				ret_code = LTTCOMM_CONSUMERD_RELAYD_FAIL;
-			}
-			if (net_seq_idx == -1ULL) {
-				net_seq_idx = stream->net_seq_idx;
+		/*
+		 * Announce all the streams of the channel to the relayd at once
+		 * to avoid a round-trip per stream.
+		 */
+		DBG("Sending streams of channel \"%s\" to relayd",
+				channel->name);
+		ret = consumer_send_relayd_channel_streams(channel,
+				channel->pathname);
+		if (ret < 0) {
+			/*
+			 * Flag that the relayd was the problem here probably due to a
+			 * communicaton error on the socket.
+			 */
+			if (relayd_error) {
+				*relayd_error = 1;
 			}
+			ret_code = LTTCOMM_CONSUMERD_RELAYD_FAIL;
 		}
 	}
 
@@ -588,6 +588,211 @@ error:
 	return ret;
 }
 
+/*
+ * Bound the send and receive timeouts of an application's command socket to
+ * DEFAULT_APP_SOCKET_RW_TIMEOUT seconds, saving the previous ones in `saved`.
+ *
+ * The socket is shared with the session daemon, which holds the
+ * application's socket lock for the duration of the handoff, so the previous
+ * timeouts are restored by restore_app_sock_timeouts() once it is done.
+ */
+static int bound_app_sock_timeouts(int app_sock, struct timeval saved[2])
+{
+	int i;
+	const int optnames[2] = { SO_SNDTIMEO, SO_RCVTIMEO };
+	const struct timeval bound = { .tv_sec = DEFAULT_APP_SOCKET_RW_TIMEOUT };
+
+	for (i = 0; i < 2; i++) {
+		socklen_t len = sizeof(saved[i]);
+
+		if (getsockopt(app_sock, SOL_SOCKET, optnames[i], &saved[i],
+				&len)) {
+			PERROR("getsockopt application socket timeout");
+			return -1;
+		}
+
+		/* A null timeout never expires. */
+		if ((saved[i].tv_sec || saved[i].tv_usec) &&
+				saved[i].tv_sec < bound.tv_sec) {
+			continue;
+		}
+
+		if (setsockopt(app_sock, SOL_SOCKET, optnames[i], &bound,
+				sizeof(bound))) {
+			PERROR("setsockopt application socket timeout");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void restore_app_sock_timeouts(int app_sock,
+		const struct timeval saved[2])
+{
+	if (setsockopt(app_sock, SOL_SOCKET, SO_SNDTIMEO, &saved[0],
+			sizeof(saved[0])) ||
+			setsockopt(app_sock, SOL_SOCKET, SO_RCVTIMEO,
+					&saved[1], sizeof(saved[1]))) {
+		PERROR("setsockopt restore application socket timeouts");
+	}
+}
+
+/*
+ * Send a channel and its streams directly to an application on its command
+ * socket, bypassing the session daemon.
+ *
+ * The application expects the objects in the form in which the session daemon
+ * receives them from the consumer. They are serialized over a local socket
+ * pair to obtain that form; the buffer file descriptors thus never leave the
+ * consumer until they are passed to the application. Each object is received
+ * from the socket pair right after it is sent to it: the socket pair is
+ * non-blocking so that overflowing it fails rather than deadlocks.
+ *
+ * The exchanges with the application are bounded in time so an application
+ * which stops responding can't hold the command thread of the consumer.
+ *
+ * The handle of the channel object in the application is returned through
+ * `channel_handle`.
+ *
+ * Return 0 on success or else a negative value. -EPIPE and
+ * -LTTNG_UST_ERR_EXITING indicate that the application is exiting.
+ */
+static int send_channel_to_app(int app_sock, int session_handle,
+		struct lttng_consumer_channel *channel, int *channel_handle)
+{
+	int ret, i;
+	int loopback[2] = { -1, -1 };
+	struct timeval saved_timeouts[2];
+	bool timeouts_bounded = false;
+	struct lttng_consumer_stream *stream;
+	struct lttng_ust_abi_object_data *channel_obj = NULL;
+
+	assert(channel);
+	assert(channel_handle);
+	assert(app_sock >= 0);
+
+	DBG("UST consumer sending channel %s to application sock %d",
+			channel->name, app_sock);
+
+	ret = lttcomm_create_anon_unix_socketpair(loopback);
+	if (ret < 0) {
+		goto end;
+	}
+
+	for (i = 0; i < 2; i++) {
+		ret = fcntl(loopback[i], F_SETFL, O_NONBLOCK);
+		if (ret < 0) {
+			PERROR("fcntl set O_NONBLOCK flag of channel handoff socket");
+			goto end;
+		}
+	}
+
+	ret = bound_app_sock_timeouts(app_sock, saved_timeouts);
+	if (ret < 0) {
+		goto end;
+	}
+	timeouts_bounded = true;
+
+	ret = ustctl_send_channel_to_sessiond(loopback[0], channel->uchan);
+	if (ret < 0) {
+		goto end;
+	}
+	ret = ustctl_recv_channel_from_consumer(loopback[1], &channel_obj);
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = ustctl_channel_close_wakeup_fd(channel->uchan);
+	if (ret < 0) {
+		goto end;
+	}
+
+	ret = ustctl_send_channel_to_ust(app_sock, session_handle, channel_obj);
+	if (ret < 0) {
+		goto end;
+	}
+
+	cds_list_for_each_entry(stream, &channel->streams.head, send_node) {
+		struct lttng_ust_abi_object_data *stream_obj = NULL;
+
+		health_code_update();
+
+		ret = send_sessiond_stream(loopback[0], stream);
+		if (ret < 0) {
+			goto end;
+		}
+		ret = ustctl_recv_stream_from_consumer(loopback[1],
+				&stream_obj);
+		if (ret < 0) {
+			goto end;
+		}
+
+		ret = ustctl_send_stream_to_ust(app_sock, channel_obj,
+				stream_obj);
+		/* The application holds its own copy of the descriptors. */
+		(void) ustctl_release_object(-1, stream_obj);
+		free(stream_obj);
+		if (ret < 0) {
+			goto end;
+		}
+	}
+
+	*channel_handle = channel_obj->handle;
+	ret = 0;
+end:
+	if (timeouts_bounded) {
+		restore_app_sock_timeouts(app_sock, saved_timeouts);
+	}
+	if (channel_obj) {
+		(void) ustctl_release_object(-1, channel_obj);
+		free(channel_obj);
+	}
+	for (i = 0; i < 2; i++) {
+		if (loopback[i] >= 0 && close(loopback[i])) {
+			PERROR("close channel handoff socket");
+		}
+	}
+	return ret;
+}
+
+/*
+ * Send channel to relayd (if applicable) and directly to the application
+ * owning `app_sock`.
+ *
+ * Return an lttcomm consumerd status code.
+ */
+static int send_channel_to_app_and_relayd(int app_sock, int session_handle,
+		struct lttng_consumer_channel *channel, int *channel_handle)
+{
+	int ret;
+
+	assert(channel);
+
+	if (channel->relayd_id != (uint64_t) -1ULL) {
+		health_code_update();
+
+		ret = consumer_send_relayd_channel_streams(channel,
+				channel->pathname);
+		if (ret < 0) {
+			return LTTCOMM_CONSUMERD_RELAYD_FAIL;
+		}
+	}
+
+	ret = send_channel_to_app(app_sock, session_handle, channel,
+			channel_handle);
+	if (ret == -EPIPE || ret == -LTTNG_UST_ERR_EXITING) {
+		DBG3("UST consumer send channel to application failed. Application is dead.");
+		return LTTCOMM_CONSUMERD_APP_EXITING;
+	} else if (ret < 0) {
+		ERR("Failed to send channel %s to application with ret %d",
+				channel->name, ret);
+		return LTTCOMM_CONSUMERD_CHANNEL_FAIL;
+	}
+
+	return LTTCOMM_CONSUMERD_SUCCESS;
+}
+
 /*
  * Creates a channel and streams and add the channel it to the channel internal
  * state. The created stream must ONLY be sent once the GET_CHANNEL command is
@@ -621,10 +826,15 @@ static int ask_channel(struct lttng_consumer_local_data *ctx,
 	 */
 	channel->nb_init_stream_left = 0;
 
-	/* The reply msg status is handled in the following call. */
-	ret = create_ust_channel(channel, attr, &channel->uchan);
-	if (ret < 0) {
-		goto end;
+	/*
+	 * The reply msg status is handled in the following call. The buffers
+	 * reserved for a per-PID channel are used as is.
+	 */
+	if (!lttng_ustconsumer_pool_take(channel, attr)) {
+		ret = create_ust_channel(channel, attr, &channel->uchan);
+		if (ret < 0) {
+			goto end;
+		}
 	}
 
 	channel->wait_fd = ustctl_channel_get_wait_fd(channel->uchan);
@@ -1061,14 +1271,15 @@ error:
 }
 
 /*
- * Take a snapshot of all the stream of a channel.
+ * Take a snapshot of all the stream of a channel, skipping the packets which
+ * end before begin_timestamp.
  * RCU read-side lock and the channel lock must be held by the caller.
  *
  * Returns 0 on success, < 0 on error
  */
 static int snapshot_channel(struct lttng_consumer_channel *channel,
 		uint64_t key, char *path, uint64_t relayd_id,
-		uint64_t nb_packets_per_stream,
+		uint64_t nb_packets_per_stream, uint64_t begin_timestamp,
 		struct lttng_consumer_local_data *ctx)
 {
 	int ret;
@@ -1181,6 +1392,27 @@ static int snapshot_channel(struct lttng_consumer_channel *channel,
 				continue;
 			}
 
+			if (begin_timestamp) {
+				uint64_t timestamp_end;
+
+				ret = ustctl_get_timestamp_end(stream->ustream,
+						&timestamp_end);
+				if (ret < 0) {
+					ERR("Snapshot ustctl_get_timestamp_end");
+					goto error_put_subbuf;
+				}
+				if (timestamp_end < begin_timestamp) {
+					/* Packet ends before the time window. */
+					ret = ustctl_put_subbuf(stream->ustream);
+					if (ret < 0) {
+						ERR("Snapshot ustctl_put_subbuf");
+						goto error_close_stream;
+					}
+					consumed_pos += stream->max_sb_size;
+					continue;
+				}
+			}
+
 			ret = ustctl_get_subbuf_size(stream->ustream, &len);
 			if (ret < 0) {
 				ERR("Snapshot ustctl_get_subbuf_size");
@@ -1504,6 +1736,9 @@ int lttng_ustconsumer_recv_cmd(struct lttng_consumer_local_data *ctx,
 		 * allocation.
 		 */
 		channel->ust_app_uid = msg.u.ask_channel.ust_app_uid;
+		channel->writeback_window_size =
+				msg.u.ask_channel.writeback_window_size;
+		channel->direct_io = msg.u.ask_channel.direct_io;
 
 		/* Build channel attributes from received message. */
 		attr.subbuf_size = msg.u.ask_channel.subbuf_size;
@@ -1678,6 +1913,77 @@ error_get_channel_fatal:
 end_get_channel_nosignal:
 		goto end_nosignal;
 	}
+	case LTTNG_CONSUMER_SEND_CHANNEL_TO_APP:
+	{
+		int ret, app_sock = -1;
+		int32_t channel_handle = -1;
+		uint64_t key = msg.u.send_channel_to_app.key;
+		struct lttng_consumer_channel *channel;
+
+		channel = consumer_find_channel(key);
+		if (!channel) {
+			ERR("UST consumer send channel to app key %" PRIu64 " not found", key);
+			ret_code = LTTCOMM_CONSUMERD_CHAN_NOT_FOUND;
+			goto end_msg_sessiond;
+		}
+
+		/* Successfully received the command's type. */
+		ret = consumer_send_status_msg(sock, ret_code);
+		if (ret < 0) {
+			goto error_fatal;
+		}
+
+		health_poll_entry();
+		ret = lttng_consumer_poll_socket(consumer_sockpoll);
+		health_poll_exit();
+		if (ret) {
+			goto error_fatal;
+		}
+
+		ret = lttcomm_recv_fds_unix_sock(sock, &app_sock, 1);
+		if (ret != sizeof(app_sock)) {
+			ERR("Failed to receive application command socket");
+			goto error_fatal;
+		}
+
+		health_code_update();
+
+		ret_code = send_channel_to_app_and_relayd(app_sock,
+				msg.u.send_channel_to_app.session_handle,
+				channel, &channel_handle);
+		if (close(app_sock)) {
+			PERROR("close application command socket");
+		}
+
+		health_code_update();
+
+		ret = consumer_send_status_msg(sock, ret_code);
+		if (ret < 0) {
+			goto error_fatal;
+		}
+		if (ret_code != LTTCOMM_CONSUMERD_SUCCESS) {
+			goto end_nosignal;
+		}
+
+		/* The application's channel handle follows a successful status. */
+		ret = lttcomm_send_unix_sock(sock, &channel_handle,
+				sizeof(channel_handle));
+		if (ret < 0) {
+			goto error_fatal;
+		}
+
+		if (!channel->monitor) {
+			goto end_nosignal;
+		}
+
+		ret = send_streams_to_thread(channel, ctx);
+		if (ret < 0) {
+			goto error_fatal;
+		}
+		/* List MUST be empty after or else it could be reused. */
+		assert(cds_list_empty(&channel->streams.head));
+		goto end_nosignal;
+	}
 	case LTTNG_CONSUMER_DESTROY_CHANNEL:
 	{
 		uint64_t key = msg.u.destroy_channel.key;
@@ -1712,6 +2018,56 @@ end_get_channel_nosignal:
 
 		goto end_msg_sessiond;
 	}
+	case LTTNG_CONSUMER_FLUSH_CHANNELS:
+	{
+		int ret;
+		uint32_t i;
+		const uint32_t count = msg.u.flush_channels.count;
+		uint64_t *keys = NULL;
+
+		DBG("UST consumer flush %" PRIu32 " channels", count);
+
+		if (count == 0) {
+			goto end_msg_sessiond;
+		}
+
+		keys = zmalloc(count * sizeof(*keys));
+		if (!keys) {
+			PERROR("zmalloc flush channels keys");
+			goto error_flush_channels_fatal;
+		}
+
+		health_poll_entry();
+		ret = lttng_consumer_poll_socket(consumer_sockpoll);
+		health_poll_exit();
+		if (ret) {
+			goto error_flush_channels_fatal;
+		}
+
+		ret = lttcomm_recv_unix_sock(sock, keys, count * sizeof(*keys));
+		if (ret != (ssize_t) (count * sizeof(*keys))) {
+			ERR("Failed to receive the keys of the channels to flush");
+			goto error_flush_channels_fatal;
+		}
+
+		/*
+		 * Flush every channel even if one of them fails; only the
+		 * first error is reported to the session daemon.
+		 */
+		for (i = 0; i < count; i++) {
+			health_code_update();
+			ret = flush_channel(keys[i]);
+			if (ret != 0 && ret_code == LTTCOMM_CONSUMERD_SUCCESS) {
+				ret_code = ret;
+			}
+		}
+
+		free(keys);
+		goto end_msg_sessiond;
+error_flush_channels_fatal:
+		free(keys);
+		goto error_fatal;
+	}
 	case LTTNG_CONSUMER_CLEAR_QUIESCENT_CHANNEL:
 	{
 		int ret;
@@ -1828,6 +2184,7 @@ error_push_metadata_fatal:
 						msg.u.snapshot_channel.pathname,
 						msg.u.snapshot_channel.relayd_id,
 						msg.u.snapshot_channel.nb_packets_per_stream,
+						msg.u.snapshot_channel.begin_timestamp,
 						ctx);
 				if (ret < 0) {
 					ERR("Snapshot channel failed");
@@ -1991,6 +2348,30 @@ error_push_metadata_fatal:
 		}
 		goto end_msg_sessiond;
 	}
+	case LTTNG_CONSUMER_ADD_COMMAND_SOCKET:
+	{
+		int command_sock;
+
+		ret_code = LTTCOMM_CONSUMERD_SUCCESS;
+		/* Successfully received the command's type. */
+		ret = consumer_send_status_msg(sock, ret_code);
+		if (ret < 0) {
+			goto error_fatal;
+		}
+
+		ret = lttcomm_recv_fds_unix_sock(sock, &command_sock, 1);
+		if (ret != sizeof(command_sock)) {
+			ERR("Failed to receive command socket");
+			goto error_fatal;
+		}
+
+		DBG("Received additional command socket (%d)", command_sock);
+		ret = consumer_add_command_worker(ctx, command_sock);
+		if (ret) {
+			ret_code = LTTCOMM_CONSUMERD_FATAL;
+		}
+		goto end_msg_sessiond;
+	}
 	case LTTNG_CONSUMER_ROTATE_CHANNEL:
 	{
 		struct lttng_consumer_channel *channel;
@@ -2085,6 +2466,8 @@ end_rotate_channel_nosignal:
 		};
 		const bool is_local_trace =
 				!msg.u.create_trace_chunk.relayd_id.is_set;
+		const bool has_local_output =
+				msg.u.create_trace_chunk.credentials.is_set;
 		const uint64_t relayd_id =
 				msg.u.create_trace_chunk.relayd_id.value;
 		const char *chunk_override_name =
@@ -2094,10 +2477,12 @@ end_rotate_channel_nosignal:
 		struct lttng_directory_handle *chunk_directory_handle = NULL;
 
 		/*
-		 * The session daemon will only provide a chunk directory file
-		 * descriptor for local traces.
+		 * The session daemon only provides a chunk directory file
+		 * descriptor, along with its credentials, for chunks having a
+		 * local output: local traces and local copies of streamed
+		 * traces.
 		 */
-		if (is_local_trace) {
+		if (has_local_output) {
 			int chunk_dirfd;
 
 			/* Acnowledge the reception of the command. */
@@ -2211,6 +2596,70 @@ end_rotate_channel_nosignal:
 		health_code_update();
 		goto end_msg_sessiond;
 	}
+	case LTTNG_CONSUMER_ADD_LIVE_SESSION:
+	{
+		msg.u.add_live_session.session_name[
+				sizeof(msg.u.add_live_session.session_name) - 1] = '\0';
+		msg.u.add_live_session.hostname[
+				sizeof(msg.u.add_live_session.hostname) - 1] = '\0';
+		consumer_live_session_add(msg.u.add_live_session.session_id,
+				msg.u.add_live_session.session_name,
+				msg.u.add_live_session.hostname,
+				msg.u.add_live_session.live_timer);
+		goto end_msg_sessiond;
+	}
+	case LTTNG_CONSUMER_CLOSE_LIVE_SESSION:
+		consumer_live_session_close(
+				msg.u.close_live_session.session_id);
+		goto end_msg_sessiond;
+	case LTTNG_CONSUMER_PREPARE_BUFFER_SET:
+	{
+		int ret;
+		const uint32_t count = msg.u.prepare_buffer_set.channel_count;
+		struct lttcomm_consumer_buffer_set_channel *channels = NULL;
+
+		if (count == 0) {
+			goto end_msg_sessiond;
+		}
+
+		channels = zmalloc(count * sizeof(*channels));
+		if (!channels) {
+			PERROR("zmalloc buffer set channels");
+			goto error_prepare_buffer_set_fatal;
+		}
+
+		health_poll_entry();
+		ret = lttng_consumer_poll_socket(consumer_sockpoll);
+		health_poll_exit();
+		if (ret) {
+			goto error_prepare_buffer_set_fatal;
+		}
+
+		ret = lttcomm_recv_unix_sock(sock, channels,
+				count * sizeof(*channels));
+		if (ret != (ssize_t) (count * sizeof(*channels))) {
+			ERR("Failed to receive the channels of a buffer set");
+			goto error_prepare_buffer_set_fatal;
+		}
+
+		/* The buffers are created by the pool thread. */
+		ret = lttng_ustconsumer_pool_prepare(
+				msg.u.prepare_buffer_set.session_id,
+				msg.u.prepare_buffer_set.uuid, channels, count);
+		if (ret) {
+			ret_code = LTTCOMM_CONSUMERD_ENOMEM;
+		}
+
+		free(channels);
+		goto end_msg_sessiond;
+error_prepare_buffer_set_fatal:
+		free(channels);
+		goto error_fatal;
+	}
+	case LTTNG_CONSUMER_DESTROY_BUFFER_POOL:
+		lttng_ustconsumer_pool_destroy_session(
+				msg.u.destroy_buffer_pool.session_id);
+		goto end_msg_sessiond;
 	default:
 		break;
 	}
@@ -3014,12 +3463,12 @@ int lttng_ustconsumer_on_recv_stream(struct lttng_consumer_stream *stream)
 	assert(stream);
 
 	/*
-	 * Don't create anything if this is set for streaming or if there is
-	 * no current trace chunk on the parent channel.
+	 * Don't create anything if this is set for streaming without a local
+	 * copy or if there is no current trace chunk on the parent channel.
 	 */
-	if (stream->net_seq_idx == (uint64_t) -1ULL && stream->chan->monitor &&
-			stream->chan->trace_chunk) {
-		ret = consumer_stream_create_output_files(stream, true);
+	if (stream->chan->monitor && stream->chan->trace_chunk &&
+			consumer_stream_has_local_output(stream)) {
+		ret = consumer_stream_defer_output_files(stream);
 		if (ret) {
 			goto error;
 		}
@@ -17,6 +17,7 @@
 #include <common/payload.h>
 #include <common/payload-view.h>
 #include <common/unix.h>
+#include <common/sessiond-comm/sessiond-comm.h>
 #include <assert.h>
 #include "lttng-ctl-helper.h"
 #include <common/compat/poll.h>
@@ -24,6 +25,86 @@
 static
 int handshake(struct lttng_notification_channel *channel);
 
+static
+bool has_buffered_message(struct lttng_notification_channel *channel)
+{
+	return channel->reception_buffer.offset <
+			channel->reception_buffer.buffer.size;
+}
+
+/*
+ * Receive, in a single call, all the complete messages that are available on
+ * the channel's socket, up to the size of the reception buffer.
+ *
+ * The data is peeked at first so that only complete messages are consumed and
+ * that a message carrying file descriptors is left on the socket; it is
+ * received on its own since its file descriptors are sent separately.
+ *
+ * The caller must acquire the channel's lock.
+ */
+static
+int fill_reception_buffer(struct lttng_notification_channel *channel)
+{
+	int ret;
+	ssize_t peeked;
+	size_t messages_size = 0;
+	struct lttng_dynamic_buffer *buffer = &channel->reception_buffer.buffer;
+
+	channel->reception_buffer.offset = 0;
+	ret = lttng_dynamic_buffer_set_size(buffer, 0);
+	if (ret) {
+		goto error;
+	}
+
+	ret = lttng_dynamic_buffer_set_capacity(buffer,
+			DEFAULT_CLIENT_NOTIFICATION_RECEPTION_BUFFER_SIZE);
+	if (ret) {
+		goto error;
+	}
+
+	peeked = lttcomm_peek_unix_sock_non_block(channel->socket,
+			buffer->data, lttng_dynamic_buffer_get_capacity_left(buffer));
+	if (peeked < 0) {
+		ret = -1;
+		goto error;
+	}
+
+	while (peeked - messages_size >=
+			sizeof(struct lttng_notification_channel_message)) {
+		struct lttng_notification_channel_message msg;
+
+		memcpy(&msg, buffer->data + messages_size, sizeof(msg));
+		if (msg.fds != 0 || msg.size >
+				DEFAULT_MAX_NOTIFICATION_CLIENT_MESSAGE_PAYLOAD_SIZE ||
+				peeked - messages_size - sizeof(msg) < msg.size) {
+			break;
+		}
+
+		messages_size += sizeof(msg) + msg.size;
+	}
+
+	if (messages_size == 0) {
+		goto end;
+	}
+
+	ret = lttng_dynamic_buffer_set_size(buffer, messages_size);
+	if (ret) {
+		goto error;
+	}
+
+	/* Consume the messages that were peeked at. */
+	if (lttcomm_recv_unix_sock(channel->socket, buffer->data,
+			messages_size) < (ssize_t) messages_size) {
+		ret = -1;
+		goto error;
+	}
+end:
+	return ret;
+error:
+	(void) lttng_dynamic_buffer_set_size(buffer, 0);
+	goto end;
+}
+
 /*
  * Populates the reception buffer with the next complete message.
  * The caller must acquire the channel's lock.
@@ -36,6 +117,30 @@ int receive_message(struct lttng_notification_channel *channel)
 
 	lttng_payload_clear(&channel->reception_payload);
 
+	if (!has_buffered_message(channel)) {
+		ret = fill_reception_buffer(channel);
+		if (ret) {
+			goto error;
+		}
+	}
+
+	if (has_buffered_message(channel)) {
+		/* Messages in the reception buffer are known to be complete. */
+		const char *data = channel->reception_buffer.buffer.data +
+				channel->reception_buffer.offset;
+
+		memcpy(&msg, data, sizeof(msg));
+		ret = lttng_dynamic_buffer_append(
+				&channel->reception_payload.buffer, data,
+				sizeof(msg) + msg.size);
+		if (ret) {
+			goto error;
+		}
+
+		channel->reception_buffer.offset += sizeof(msg) + msg.size;
+		goto end;
+	}
+
 	ret = lttcomm_recv_unix_sock(channel->socket, &msg, sizeof(msg));
 	if (ret <= 0) {
 		ret = -1;
@@ -131,6 +236,55 @@ end:
 	return notification;
 }
 
+/*
+ * Wait for a message to be available on the channel's socket.
+ * The caller must acquire the channel's lock.
+ */
+static
+enum lttng_notification_channel_status wait_for_message(
+		struct lttng_notification_channel *channel)
+{
+	int ret;
+	enum lttng_notification_channel_status status =
+			LTTNG_NOTIFICATION_CHANNEL_STATUS_OK;
+	struct lttng_poll_event events;
+
+	/*
+	 * Block on interruptible epoll/poll() instead of the message reception
+	 * itself as the recvmsg() wrappers always restart on EINTR. We choose
+	 * to wait using interruptible epoll/poll() in order to:
+	 *   1) Return if a signal occurs,
+	 *   2) Not deal with partially received messages.
+	 *
+	 * The drawback to this approach is that we assume that messages
+	 * are complete/well formed. If a message is shorter than its
+	 * announced length, receive_message() will block on recvmsg()
+	 * and never return (even if a signal is received).
+	 */
+	ret = lttng_poll_create(&events, 1, LTTNG_CLOEXEC);
+	if (ret < 0) {
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+		goto end;
+	}
+	ret = lttng_poll_add(&events, channel->socket, LPOLLIN | LPOLLERR);
+	if (ret < 0) {
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+		goto end_clean_poll;
+	}
+	ret = lttng_poll_wait_interruptible(&events, -1);
+	if (ret <= 0) {
+		status = (ret == -1 && errno == EINTR) ?
+			LTTNG_NOTIFICATION_CHANNEL_STATUS_INTERRUPTED :
+			LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+		goto end_clean_poll;
+	}
+
+end_clean_poll:
+	lttng_poll_clean(&events);
+end:
+	return status;
+}
+
 struct lttng_notification_channel *lttng_notification_channel_create(
 		struct lttng_endpoint *endpoint)
 {
@@ -156,6 +310,7 @@ struct lttng_notification_channel *lttng_notification_channel_create(
 	channel->socket = -1;
 	pthread_mutex_init(&channel->lock, NULL);
 	lttng_payload_init(&channel->reception_payload);
+	lttng_dynamic_buffer_init(&channel->reception_buffer.buffer);
 	CDS_INIT_LIST_HEAD(&channel->pending_notifications.list);
 
 	is_root = (getuid() == 0);
@@ -218,7 +373,6 @@ lttng_notification_channel_get_next_notification(
 	struct lttng_notification *notification = NULL;
 	enum lttng_notification_channel_status status =
 			LTTNG_NOTIFICATION_CHANNEL_STATUS_OK;
-	struct lttng_poll_event events;
 
 	if (!channel || !_notification) {
 		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID;
@@ -247,40 +401,18 @@ lttng_notification_channel_get_next_notification(
 		goto end_unlock;
 	}
 
-	/*
-	 * Block on interruptible epoll/poll() instead of the message reception
-	 * itself as the recvmsg() wrappers always restart on EINTR. We choose
-	 * to wait using interruptible epoll/poll() in order to:
-	 *   1) Return if a signal occurs,
-	 *   2) Not deal with partially received messages.
-	 *
-	 * The drawback to this approach is that we assume that messages
-	 * are complete/well formed. If a message is shorter than its
-	 * announced length, receive_message() will block on recvmsg()
-	 * and never return (even if a signal is received).
-	 */
-	ret = lttng_poll_create(&events, 1, LTTNG_CLOEXEC);
-	if (ret < 0) {
-		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
-		goto end_unlock;
-	}
-	ret = lttng_poll_add(&events, channel->socket, LPOLLIN | LPOLLERR);
-	if (ret < 0) {
-		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
-		goto end_clean_poll;
-	}
-	ret = lttng_poll_wait_interruptible(&events, -1);
-	if (ret <= 0) {
-		status = (ret == -1 && errno == EINTR) ?
-			LTTNG_NOTIFICATION_CHANNEL_STATUS_INTERRUPTED :
-			LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
-		goto end_clean_poll;
+	/* Messages already received are decoded without waiting. */
+	if (!has_buffered_message(channel)) {
+		status = wait_for_message(channel);
+		if (status != LTTNG_NOTIFICATION_CHANNEL_STATUS_OK) {
+			goto end_unlock;
+		}
 	}
 
 	ret = receive_message(channel);
 	if (ret) {
 		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
-		goto end_clean_poll;
+		goto end_unlock;
 	}
 
 	switch (get_current_message_type(channel)) {
@@ -289,7 +421,7 @@ lttng_notification_channel_get_next_notification(
 				channel);
 		if (!notification) {
 			status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
-			goto end_clean_poll;
+			goto end_unlock;
 		}
 		break;
 	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_NOTIFICATION_DROPPED:
@@ -299,11 +431,9 @@ lttng_notification_channel_get_next_notification(
 	default:
 		/* Protocol error. */
 		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
-		goto end_clean_poll;
+		goto end_unlock;
 	}
 
-end_clean_poll:
-	lttng_poll_clean(&events);
 end_unlock:
 	pthread_mutex_unlock(&channel->lock);
 	*_notification = notification;
@@ -317,10 +447,13 @@ int enqueue_dropped_notification(
 {
 	int ret = 0;
 	struct pending_notification *pending_notification;
-	struct cds_list_head *last_element =
-			channel->pending_notifications.list.prev;
 
-	pending_notification = caa_container_of(last_element,
+	if (cds_list_empty(&channel->pending_notifications.list)) {
+		goto enqueue;
+	}
+
+	pending_notification = cds_list_entry(
+			channel->pending_notifications.list.prev,
 			struct pending_notification, node);
 	if (!pending_notification->notification) {
 		/*
@@ -344,13 +477,14 @@ int enqueue_dropped_notification(
 		goto end;
 	}
 
+enqueue:
 	pending_notification = zmalloc(sizeof(*pending_notification));
 	if (!pending_notification) {
 		ret = -1;
 		goto end;
 	}
 	CDS_INIT_LIST_HEAD(&pending_notification->node);
-	cds_list_add(&pending_notification->node,
+	cds_list_add_tail(&pending_notification->node,
 			&channel->pending_notifications.list);
 	channel->pending_notifications.count++;
 end:
@@ -386,7 +520,7 @@ int enqueue_notification_from_current_message(
 	}
 
 	pending_notification->notification = notification;
-	cds_list_add(&pending_notification->node,
+	cds_list_add_tail(&pending_notification->node,
 			&channel->pending_notifications.list);
 	channel->pending_notifications.count++;
 end:
@@ -396,6 +530,40 @@ error:
 	goto end;
 }
 
+/*
+ * Receive the next message and enqueue the notification it carries. Only
+ * notifications and "notification dropped" messages are expected outside of
+ * a command; any other message type is a protocol error.
+ *
+ * The caller must acquire the channel's lock.
+ */
+static
+int receive_and_enqueue_notification(
+		struct lttng_notification_channel *channel)
+{
+	int ret;
+
+	ret = receive_message(channel);
+	if (ret) {
+		goto end;
+	}
+
+	switch (get_current_message_type(channel)) {
+	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_NOTIFICATION:
+		ret = enqueue_notification_from_current_message(channel);
+		break;
+	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_NOTIFICATION_DROPPED:
+		ret = enqueue_dropped_notification(channel);
+		break;
+	default:
+		/* Protocol error. */
+		ret = -1;
+		break;
+	}
+end:
+	return ret;
+}
+
 enum lttng_notification_channel_status
 lttng_notification_channel_has_pending_notification(
 		struct lttng_notification_channel *channel,
@@ -438,7 +606,20 @@ lttng_notification_channel_has_pending_notification(
 	 * will block until our peer (the session daemon) has sent a complete
 	 * message if we see data available on the socket. If the peer does
 	 * not respect the protocol, this may block indefinitely.
+	 *
+	 * Messages that were already received along with a previous one
+	 * are decoded without polling the socket.
 	 */
+	if (has_buffered_message(channel)) {
+		ret = receive_and_enqueue_notification(channel);
+		if (ret) {
+			status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+			goto end_unlock;
+		}
+		*_notification_pending = true;
+		goto end_unlock;
+	}
+
 	ret = lttng_poll_create(&events, 1, LTTNG_CLOEXEC);
 	if (ret < 0) {
 		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
@@ -461,33 +642,133 @@ lttng_notification_channel_has_pending_notification(
 	}
 
 	/* Data available on socket. */
-	ret = receive_message(channel);
+	ret = receive_and_enqueue_notification(channel);
 	if (ret) {
 		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
 		goto end_clean_poll;
 	}
+	*_notification_pending = true;
 
-	switch (get_current_message_type(channel)) {
-	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_NOTIFICATION:
-		ret = enqueue_notification_from_current_message(channel);
-		if (ret) {
-			goto end_clean_poll;
+end_clean_poll:
+	lttng_poll_clean(&events);
+end_unlock:
+	pthread_mutex_unlock(&channel->lock);
+end:
+	return status;
+}
+
+enum lttng_notification_channel_status
+lttng_notification_channel_get_pending_notifications(
+		struct lttng_notification_channel *channel,
+		struct lttng_notification ***_notifications,
+		unsigned int *_count)
+{
+	int ret;
+	unsigned int count = 0;
+	enum lttng_notification_channel_status status =
+			LTTNG_NOTIFICATION_CHANNEL_STATUS_OK;
+	struct lttng_notification **notifications = NULL;
+	struct pending_notification *pending_notification, *tmp;
+	struct lttng_poll_event events;
+
+	if (!channel || !_notifications || !_count) {
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID;
+		goto end;
+	}
+
+	pthread_mutex_lock(&channel->lock);
+
+	if (channel->socket < 0) {
+		if (!channel->pending_notifications.count) {
+			status = LTTNG_NOTIFICATION_CHANNEL_STATUS_CLOSED;
+			goto end_unlock;
 		}
-		*_notification_pending = true;
-		break;
-	case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_NOTIFICATION_DROPPED:
-		ret = enqueue_dropped_notification(channel);
+
+		goto dequeue;
+	}
+
+	ret = lttng_poll_create(&events, 1, LTTNG_CLOEXEC);
+	if (ret < 0) {
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+		goto end_unlock;
+	}
+	ret = lttng_poll_add(&events, channel->socket, LPOLLIN | LPOLLERR);
+	if (ret < 0) {
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+		goto end_clean_poll;
+	}
+
+	/*
+	 * Enqueue every message that is already available, without waiting
+	 * for new ones. The same caveat as in
+	 * lttng_notification_channel_has_pending_notification() applies: a
+	 * partially sent message is waited for.
+	 *
+	 * The queue is bounded to ensure this terminates even if the session
+	 * daemon keeps sending notifications.
+	 */
+	while (channel->pending_notifications.count <
+			DEFAULT_CLIENT_MAX_QUEUED_NOTIFICATIONS_COUNT) {
+		if (!has_buffered_message(channel)) {
+			/* timeout = 0: return immediately. */
+			ret = lttng_poll_wait_interruptible(&events, 0);
+			if (ret == 0) {
+				/* No data available. */
+				break;
+			} else if (ret < 0) {
+				/*
+				 * The notifications received so far are kept
+				 * for the next call.
+				 */
+				status = errno == EINTR ?
+					LTTNG_NOTIFICATION_CHANNEL_STATUS_INTERRUPTED :
+					LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+				goto end_clean_poll;
+			}
+		}
+
+		ret = receive_and_enqueue_notification(channel);
 		if (ret) {
+			status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
 			goto end_clean_poll;
 		}
-		*_notification_pending = true;
-		break;
-	default:
-		/* Protocol error. */
-		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
-		goto end_clean_poll;
 	}
 
+	lttng_poll_clean(&events);
+
+dequeue:
+	if (channel->pending_notifications.count) {
+		notifications = zmalloc(sizeof(*notifications) *
+				channel->pending_notifications.count);
+		if (!notifications) {
+			status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+			goto end_unlock;
+		}
+	}
+
+	cds_list_for_each_entry_safe(pending_notification, tmp,
+			&channel->pending_notifications.list, node) {
+		if (pending_notification->notification) {
+			notifications[count++] =
+					pending_notification->notification;
+		} else {
+			status = LTTNG_NOTIFICATION_CHANNEL_STATUS_NOTIFICATIONS_DROPPED;
+		}
+
+		cds_list_del(&pending_notification->node);
+		free(pending_notification);
+	}
+	channel->pending_notifications.count = 0;
+
+	if (!count) {
+		free(notifications);
+		notifications = NULL;
+	}
+
+	*_notifications = notifications;
+	*_count = count;
+	goto end_unlock;
+
 end_clean_poll:
 	lttng_poll_clean(&events);
 end_unlock:
@@ -720,6 +1001,281 @@ enum lttng_notification_channel_status lttng_notification_channel_unsubscribe(
 			condition);
 }
 
+/*
+ * Send a SUBSCRIBE_MULTIPLE or UNSUBSCRIBE_MULTIPLE command carrying
+ * condition_count serialized conditions and receive the status of each of
+ * them.
+ *
+ * The caller must acquire the channel's lock.
+ */
+static
+enum lttng_notification_channel_status send_conditions_command(
+		struct lttng_notification_channel *channel,
+		enum lttng_notification_channel_message_type type,
+		const struct lttng_payload *conditions,
+		unsigned int condition_count,
+		enum lttng_notification_channel_status *statuses)
+{
+	ssize_t ret;
+	unsigned int i;
+	const int8_t *condition_statuses;
+	enum lttng_notification_channel_status status =
+			LTTNG_NOTIFICATION_CHANNEL_STATUS_OK;
+	struct lttng_payload payload;
+	struct lttng_notification_channel_message cmd_header = {
+		.type = (int8_t) type,
+	};
+	struct lttng_notification_channel_command_conditions cmd = {
+		.condition_count = condition_count,
+	};
+	const size_t statuses_offset =
+			sizeof(struct lttng_notification_channel_message) +
+			sizeof(struct lttng_notification_channel_command_reply);
+
+	lttng_payload_init(&payload);
+
+	ret = lttng_dynamic_buffer_append(&payload.buffer, &cmd_header,
+			sizeof(cmd_header));
+	if (ret) {
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+		goto end;
+	}
+
+	ret = lttng_dynamic_buffer_append(&payload.buffer, &cmd, sizeof(cmd));
+	if (ret) {
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+		goto end;
+	}
+
+	ret = lttng_payload_copy(conditions, &payload);
+	if (ret) {
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+		goto end;
+	}
+
+	/* Update payload length. */
+	((struct lttng_notification_channel_message *) payload.buffer.data)->size =
+			(uint32_t) (payload.buffer.size - sizeof(cmd_header));
+
+	{
+		struct lttng_payload_view pv =
+				lttng_payload_view_from_payload(
+						&payload, 0, -1);
+		const int fd_count =
+				lttng_payload_view_get_fd_handle_count(&pv);
+
+		/* Update fd count. */
+		((struct lttng_notification_channel_message *) payload.buffer.data)->fds =
+			(uint32_t) fd_count;
+
+		ret = lttcomm_send_unix_sock(
+			channel->socket, pv.buffer.data, pv.buffer.size);
+		if (ret < 0) {
+			status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+			goto end;
+		}
+
+		/* Pass fds if present. */
+		if (fd_count > 0) {
+			ret = lttcomm_send_payload_view_fds_unix_sock(
+					channel->socket, &pv);
+			if (ret < 0) {
+				status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+				goto end;
+			}
+		}
+	}
+
+	ret = receive_command_reply(channel, &status);
+	if (ret < 0) {
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+		goto end;
+	}
+
+	if (status != LTTNG_NOTIFICATION_CHANNEL_STATUS_OK) {
+		/* The command as a whole was rejected. */
+		for (i = 0; i < condition_count; i++) {
+			statuses[i] = status;
+		}
+		goto end;
+	}
+
+	if (channel->reception_payload.buffer.size <
+			statuses_offset + condition_count) {
+		/* Invalid reply received. */
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+		goto end;
+	}
+
+	condition_statuses = (const int8_t *)
+			(channel->reception_payload.buffer.data +
+			statuses_offset);
+	for (i = 0; i < condition_count; i++) {
+		statuses[i] = (enum lttng_notification_channel_status)
+				condition_statuses[i];
+		if (status == LTTNG_NOTIFICATION_CHANNEL_STATUS_OK) {
+			status = statuses[i];
+		}
+	}
+end:
+	lttng_payload_reset(&payload);
+	return status;
+}
+
+/*
+ * Subscribe or unsubscribe a set of conditions, sending as many conditions
+ * as the protocol allows in each command.
+ *
+ * Session daemons that predate the SUBSCRIBE_MULTIPLE and
+ * UNSUBSCRIBE_MULTIPLE commands (protocol < 1.2) are sent one command per
+ * condition.
+ */
+static
+enum lttng_notification_channel_status send_conditions_commands(
+		struct lttng_notification_channel *channel,
+		enum lttng_notification_channel_message_type type,
+		const struct lttng_condition *const *conditions,
+		unsigned int count,
+		enum lttng_notification_channel_status *statuses)
+{
+	int ret;
+	unsigned int i, chunk_first = 0, chunk_count = 0;
+	int chunk_fd_count = 0;
+	enum lttng_notification_channel_status status =
+			LTTNG_NOTIFICATION_CHANNEL_STATUS_OK;
+	struct lttng_payload chunk, condition_payload;
+	const size_t max_chunk_size =
+			DEFAULT_MAX_NOTIFICATION_CLIENT_MESSAGE_PAYLOAD_SIZE -
+			sizeof(struct lttng_notification_channel_command_conditions);
+
+	lttng_payload_init(&chunk);
+	lttng_payload_init(&condition_payload);
+
+	if (!channel || !conditions || !statuses || count == 0) {
+		status = LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!lttng_condition_validate(conditions[i])) {
+			status = LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID;
+			goto end;
+		}
+	}
+
+	if (channel->version.minor < 2) {
+		const enum lttng_notification_channel_message_type single_type =
+				type == LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_MULTIPLE ?
+				LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE :
+				LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE;
+
+		for (i = 0; i < count; i++) {
+			statuses[i] = send_condition_command(channel,
+					single_type, conditions[i]);
+			if (status == LTTNG_NOTIFICATION_CHANNEL_STATUS_OK) {
+				status = statuses[i];
+			}
+		}
+
+		goto end;
+	}
+
+	pthread_mutex_lock(&channel->lock);
+
+	for (i = 0; i < count; i++) {
+		enum lttng_notification_channel_status chunk_status;
+		int condition_fd_count;
+
+		lttng_payload_clear(&condition_payload);
+		ret = lttng_condition_serialize(conditions[i],
+				&condition_payload);
+		if (ret) {
+			status = LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID;
+			goto end_unlock;
+		}
+
+		{
+			struct lttng_payload_view condition_view =
+					lttng_payload_view_from_payload(
+							&condition_payload, 0, -1);
+
+			condition_fd_count = lttng_payload_view_get_fd_handle_count(
+					&condition_view);
+		}
+
+		if (chunk_count > 0 &&
+				(chunk.buffer.size + condition_payload.buffer.size >
+						max_chunk_size ||
+				chunk_fd_count + condition_fd_count >
+						LTTCOMM_MAX_SEND_FDS)) {
+			chunk_status = send_conditions_command(channel, type,
+					&chunk, chunk_count,
+					&statuses[chunk_first]);
+			if (chunk_status == LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR) {
+				status = chunk_status;
+				goto end_unlock;
+			} else if (status == LTTNG_NOTIFICATION_CHANNEL_STATUS_OK) {
+				status = chunk_status;
+			}
+
+			lttng_payload_clear(&chunk);
+			chunk_first = i;
+			chunk_count = 0;
+			chunk_fd_count = 0;
+		}
+
+		ret = lttng_payload_copy(&condition_payload, &chunk);
+		if (ret) {
+			status = LTTNG_NOTIFICATION_CHANNEL_STATUS_ERROR;
+			goto end_unlock;
+		}
+
+		chunk_count++;
+		chunk_fd_count += condition_fd_count;
+	}
+
+	{
+		const enum lttng_notification_channel_status chunk_status =
+				send_conditions_command(channel, type, &chunk,
+						chunk_count, &statuses[chunk_first]);
+
+		if (status == LTTNG_NOTIFICATION_CHANNEL_STATUS_OK) {
+			status = chunk_status;
+		}
+	}
+
+end_unlock:
+	pthread_mutex_unlock(&channel->lock);
+end:
+	lttng_payload_reset(&condition_payload);
+	lttng_payload_reset(&chunk);
+	return status;
+}
+
+enum lttng_notification_channel_status
+lttng_notification_channel_subscribe_multiple(
+		struct lttng_notification_channel *channel,
+		const struct lttng_condition *const *conditions,
+		unsigned int count,
+		enum lttng_notification_channel_status *statuses)
+{
+	return send_conditions_commands(channel,
+			LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_MULTIPLE,
+			conditions, count, statuses);
+}
+
+enum lttng_notification_channel_status
+lttng_notification_channel_unsubscribe_multiple(
+		struct lttng_notification_channel *channel,
+		const struct lttng_condition *const *conditions,
+		unsigned int count,
+		enum lttng_notification_channel_status *statuses)
+{
+	return send_conditions_commands(channel,
+			LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE_MULTIPLE,
+			conditions, count, statuses);
+}
+
 void lttng_notification_channel_destroy(
 		struct lttng_notification_channel *channel)
 {
@@ -732,5 +1288,6 @@ void lttng_notification_channel_destroy(
 	}
 	pthread_mutex_destroy(&channel->lock);
 	lttng_payload_reset(&channel->reception_payload);
+	lttng_dynamic_buffer_reset(&channel->reception_buffer.buffer);
 	free(channel);
 }
@@ -63,6 +63,7 @@ const char *sessiond_thread_name[NR_HEALTH_SESSIOND_TYPES] = {
 	[ HEALTH_SESSIOND_TYPE_ROTATION ] = "Session daemon rotation manager",
 	[ HEALTH_SESSIOND_TYPE_TIMER ] = "Session daemon timer manager",
 	[ HEALTH_SESSIOND_TYPE_ACTION_EXECUTOR ] = "Session daemon trigger action executor",
+	[ HEALTH_SESSIOND_TYPE_APP_REAPER ] = "Session daemon application reaper",
 };
 
 static
@@ -72,6 +73,10 @@ const char *consumerd_thread_name[NR_HEALTH_CONSUMERD_TYPES] = {
 	[ HEALTH_CONSUMERD_TYPE_DATA ] = "Consumer daemon data",
 	[ HEALTH_CONSUMERD_TYPE_SESSIOND ] = "Consumer daemon session daemon command manager",
 	[ HEALTH_CONSUMERD_TYPE_METADATA_TIMER ] = "Consumer daemon metadata timer",
+	[ HEALTH_CONSUMERD_TYPE_WRITEBACK ] = "Consumer daemon writeback",
+	[ HEALTH_CONSUMERD_TYPE_COMMAND_WORKER ] = "Consumer daemon session daemon command worker",
+	[ HEALTH_CONSUMERD_TYPE_LIVE ] = "Consumer daemon local live",
+	[ HEALTH_CONSUMERD_TYPE_BUFFER_POOL ] = "Consumer daemon buffer pool",
 };
 
 static
@@ -82,6 +87,7 @@ const char *relayd_thread_name[NR_HEALTH_RELAYD_TYPES] = {
 	[ HEALTH_RELAYD_TYPE_LIVE_DISPATCHER ] = "Relay daemon live dispatcher",
 	[ HEALTH_RELAYD_TYPE_LIVE_WORKER ] = "Relay daemon live worker",
 	[ HEALTH_RELAYD_TYPE_LIVE_LISTENER ] = "Relay daemon live listener",
+	[ HEALTH_RELAYD_TYPE_FORWARD ] = "Relay daemon upstream forwarder",
 };
 
 static
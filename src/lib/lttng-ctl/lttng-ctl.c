@@ -33,6 +33,7 @@
 #include <common/uri.h>
 #include <common/utils.h>
 #include <lttng/channel-internal.h>
+#include <lttng/counter-map-internal.h>
 #include <lttng/destruction-handle.h>
 #include <lttng/endpoint.h>
 #include <lttng/event-internal.h>
@@ -1315,6 +1316,108 @@ ask_sessiond:
 	return ret;
 }
 
+/*
+ * Enable a set of events, without filter nor exclusions, for a channel.
+ * The events are sent to the session daemon in as few commands as possible.
+ * If no channel name is specified, the default name is used.
+ * If ret_codes is not NULL, it receives the return code of each event.
+ * Returns 0 on success or a negative error code.
+ */
+int lttng_enable_events(struct lttng_handle *handle,
+		struct lttng_event *events, unsigned int event_count,
+		const char *channel_name, int *ret_codes)
+{
+	int ret;
+	unsigned int i, events_sent = 0;
+	struct lttcomm_session_msg lsm;
+
+	if (handle == NULL || events == NULL || event_count == 0) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	if (handle->domain.type == LTTNG_DOMAIN_JUL ||
+			handle->domain.type == LTTNG_DOMAIN_LOG4J ||
+			handle->domain.type == LTTNG_DOMAIN_PYTHON) {
+		/*
+		 * Agent events are matched on their logger name and log level
+		 * by a filter built for each of them; enable them one at a
+		 * time.
+		 */
+		for (i = 0; i < event_count; i++) {
+			ret = lttng_enable_event_with_exclusions(handle,
+					&events[i], channel_name, NULL, 0,
+					NULL);
+			if (ret_codes) {
+				ret_codes[i] = ret < 0 ? ret : 0;
+			}
+		}
+
+		ret = 0;
+		goto end;
+	}
+
+	memset(&lsm, 0, sizeof(lsm));
+	lsm.cmd_type = LTTNG_ENABLE_EVENTS;
+	COPY_DOMAIN_PACKED(lsm.domain, handle->domain);
+
+	ret = lttng_strncpy(lsm.session.name, handle->session_name,
+			sizeof(lsm.session.name));
+	if (ret) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	/* If no channel name, send empty string. */
+	ret = lttng_strncpy(lsm.u.enable_events.channel_name,
+			channel_name ?: "",
+			sizeof(lsm.u.enable_events.channel_name));
+	if (ret) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	for (i = 0; i < event_count; i++) {
+		if (events[i].name[0] == '\0') {
+			/* Enable all events. */
+			ret = lttng_strncpy(events[i].name, "*",
+					sizeof(events[i].name));
+			assert(ret == 0);
+		}
+	}
+
+	while (events_sent < event_count) {
+		const unsigned int count = min_t(unsigned int,
+				event_count - events_sent,
+				LTTNG_ENABLE_EVENTS_MAX_COUNT);
+		int32_t *event_ret_codes = NULL;
+
+		lsm.u.enable_events.event_count = count;
+		ret = lttng_ctl_ask_sessiond_varlen_no_cmd_header(&lsm,
+				events + events_sent, sizeof(*events) * count,
+				(void **) &event_ret_codes);
+		if (ret < 0) {
+			goto end;
+		}
+
+		if (ret != sizeof(*event_ret_codes) * count) {
+			free(event_ret_codes);
+			ret = -LTTNG_ERR_UNK;
+			goto end;
+		}
+
+		for (i = 0; ret_codes && i < count; i++) {
+			ret_codes[events_sent + i] = event_ret_codes[i];
+		}
+		free(event_ret_codes);
+		events_sent += count;
+	}
+
+	ret = 0;
+end:
+	return ret;
+}
+
 int lttng_disable_event_ext(struct lttng_handle *handle,
 		struct lttng_event *ev, const char *channel_name,
 		const char *original_filter_expression)
@@ -2179,6 +2282,38 @@ end:
 	return ret;
 }
 
+int lttng_set_session_local_copy_path(const char *session_name,
+		const char *path)
+{
+	int ret;
+	struct lttcomm_session_msg lsm;
+
+	if (session_name == NULL) {
+		return -LTTNG_ERR_INVALID;
+	}
+
+	memset(&lsm, 0, sizeof(lsm));
+	lsm.cmd_type = LTTNG_SET_SESSION_LOCAL_COPY_PATH;
+
+	ret = lttng_strncpy(lsm.session.name, session_name,
+			sizeof(lsm.session.name));
+	if (ret) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	ret = lttng_strncpy(lsm.u.set_local_copy_path.path, path ?: "",
+			sizeof(lsm.u.set_local_copy_path.path));
+	if (ret) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	ret = lttng_ctl_ask_sessiond(&lsm, NULL);
+end:
+	return ret;
+}
+
 /*
  * Ask the session daemon for all available domains of a session.
  * Sets the contents of the domains array.
@@ -2224,6 +2359,21 @@ error:
  */
 int lttng_list_channels(struct lttng_handle *handle,
 		struct lttng_channel **channels)
+{
+	return lttng_list_channels_filtered(handle, NULL, NULL, 0, channels);
+}
+
+/*
+ * Ask the session daemon for the channels of a session matching
+ * `name_pattern`, starting at the `*cursor`-th matching channel and listing
+ * at most `max_count` channels.
+ * Sets the contents of the channels array and advances the cursor.
+ * Returns the number of lttng_channel entries in channels;
+ * on error, returns a negative value.
+ */
+int lttng_list_channels_filtered(struct lttng_handle *handle,
+		const char *name_pattern, unsigned int *cursor,
+		unsigned int max_count, struct lttng_channel **channels)
 {
 	int ret;
 	size_t channel_count, i;
@@ -2246,6 +2396,17 @@ int lttng_list_channels(struct lttng_handle *handle,
 		goto end;
 	}
 
+	if (name_pattern) {
+		ret = lttng_strncpy(lsm.u.list.name_pattern, name_pattern,
+				sizeof(lsm.u.list.name_pattern));
+		if (ret) {
+			ret = -LTTNG_ERR_INVALID;
+			goto end;
+		}
+	}
+	lsm.u.list.cursor = cursor ? *cursor : 0;
+	lsm.u.list.max_count = max_count;
+
 	COPY_DOMAIN_PACKED(lsm.domain, handle->domain);
 
 	ret = lttng_ctl_ask_sessiond(&lsm, (void**) channels);
@@ -2271,6 +2432,9 @@ int lttng_list_channels(struct lttng_handle *handle,
 		extended_at += sizeof(struct lttng_channel_extended);
 	}
 
+	if (cursor) {
+		*cursor += channel_count;
+	}
 	ret = (int) channel_count;
 end:
 	return ret;
@@ -2284,6 +2448,23 @@ end:
  */
 int lttng_list_events(struct lttng_handle *handle,
 		const char *channel_name, struct lttng_event **events)
+{
+	return lttng_list_events_filtered(handle, channel_name, NULL, NULL, 0,
+			events);
+}
+
+/*
+ * Ask the session daemon for the events of a session channel matching
+ * `name_pattern`, starting at the `*cursor`-th matching event and listing at
+ * most `max_count` events.
+ * Sets the contents of the events array and advances the cursor.
+ * Returns the number of lttng_event entries in events;
+ * on error, returns a negative value.
+ */
+int lttng_list_events_filtered(struct lttng_handle *handle,
+		const char *channel_name, const char *name_pattern,
+		unsigned int *cursor, unsigned int max_count,
+		struct lttng_event **events)
 {
 	int ret;
 	struct lttcomm_session_msg lsm = {};
@@ -2326,6 +2507,17 @@ int lttng_list_events(struct lttng_handle *handle,
 		goto end;
 	}
 
+	if (name_pattern) {
+		ret = lttng_strncpy(lsm.u.list.name_pattern, name_pattern,
+				sizeof(lsm.u.list.name_pattern));
+		if (ret) {
+			ret = -LTTNG_ERR_INVALID;
+			goto end;
+		}
+	}
+	lsm.u.list.cursor = cursor ? *cursor : 0;
+	lsm.u.list.max_count = max_count;
+
 	COPY_DOMAIN_PACKED(lsm.domain, handle->domain);
 
 	ret = lttng_ctl_ask_sessiond_payload(&lsm_view, &payload);
@@ -2591,6 +2783,9 @@ int lttng_list_events(struct lttng_handle *handle,
 	/* Don't reset listing buffer as we return its content. */
 	*events = (struct lttng_event *) listing.data;
 	lttng_dynamic_buffer_init(&listing);
+	if (cursor) {
+		*cursor += nb_events;
+	}
 	ret = (int) nb_events;
 free_dynamic_buffer:
 	lttng_dynamic_buffer_reset(&listing);
@@ -2758,6 +2953,58 @@ end:
 	return ret;
 }
 
+/*
+ * Ask the session daemon for the geometry it recommends for a channel given
+ * the throughput it observed.
+ *
+ * Return 0 on success else a negative LTTng error code.
+ */
+int lttng_channel_get_advice(struct lttng_handle *handle,
+		const char *channel_name, struct lttng_channel_advice *advice)
+{
+	int ret;
+	struct lttcomm_session_msg lsm;
+	struct lttng_channel_advice *reply = NULL;
+
+	if (!handle || !channel_name || !advice) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	memset(&lsm, 0, sizeof(lsm));
+	lsm.cmd_type = LTTNG_GET_CHANNEL_ADVICE;
+	ret = lttng_strncpy(lsm.session.name, handle->session_name,
+			sizeof(lsm.session.name));
+	if (ret) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	ret = lttng_strncpy(lsm.u.channel_advice.channel_name, channel_name,
+			sizeof(lsm.u.channel_advice.channel_name));
+	if (ret) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	COPY_DOMAIN_PACKED(lsm.domain, handle->domain);
+
+	ret = lttng_ctl_ask_sessiond(&lsm, (void **) &reply);
+	if (ret < 0) {
+		goto end;
+	} else if (ret != sizeof(*reply) || !reply) {
+		/* Unexpected payload size */
+		ret = -LTTNG_ERR_UNK;
+		goto end;
+	}
+
+	memcpy(advice, reply, sizeof(*advice));
+	ret = 0;
+end:
+	free(reply);
+	return ret;
+}
+
 int lttng_channel_get_monitor_timer_interval(struct lttng_channel *chan,
 		uint64_t *monitor_timer_interval)
 {
@@ -2851,6 +3098,123 @@ end:
 	return ret;
 }
 
+int lttng_channel_get_writeback_window_size(struct lttng_channel *chan,
+		uint64_t *window_size)
+{
+	int ret = 0;
+
+	if (!chan || !window_size) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	if (!chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	*window_size = ((struct lttng_channel_extended *)
+			chan->attr.extended.ptr)->writeback_window_size;
+end:
+	return ret;
+}
+
+int lttng_channel_set_writeback_window_size(struct lttng_channel *chan,
+		uint64_t window_size)
+{
+	int ret = 0;
+
+	if (!chan || !chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	((struct lttng_channel_extended *)
+			chan->attr.extended.ptr)->writeback_window_size =
+			window_size;
+end:
+	return ret;
+}
+
+int lttng_channel_get_direct_io(struct lttng_channel *chan, int *direct_io)
+{
+	int ret = 0;
+
+	if (!chan || !direct_io) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	if (!chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	*direct_io = ((struct lttng_channel_extended *)
+			chan->attr.extended.ptr)->direct_io;
+end:
+	return ret;
+}
+
+int lttng_channel_set_direct_io(struct lttng_channel *chan, int direct_io)
+{
+	int ret = 0;
+
+	if (!chan || !chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	((struct lttng_channel_extended *)
+			chan->attr.extended.ptr)->direct_io = !!direct_io;
+end:
+	return ret;
+}
+
+int lttng_channel_get_advisable_attributes(struct lttng_channel *chan,
+		unsigned int *attrs)
+{
+	int ret = 0;
+
+	if (!chan || !attrs) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	if (!chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	*attrs = ((struct lttng_channel_extended *)
+			chan->attr.extended.ptr)->advisable_attrs;
+end:
+	return ret;
+}
+
+int lttng_channel_set_advisable_attributes(struct lttng_channel *chan,
+		unsigned int attrs)
+{
+	int ret = 0;
+
+	if (!chan || !chan->attr.extended.ptr) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	if (attrs & ~(LTTNG_CHANNEL_ADVISABLE_ATTR_SUBBUF_SIZE |
+			LTTNG_CHANNEL_ADVISABLE_ATTR_NUM_SUBBUF |
+			LTTNG_CHANNEL_ADVISABLE_ATTR_SWITCH_TIMER)) {
+		ret = -LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	((struct lttng_channel_extended *)
+			chan->attr.extended.ptr)->advisable_attrs = attrs;
+end:
+	return ret;
+}
+
 /*
  * Check if session daemon is alive.
  *
@@ -3352,6 +3716,89 @@ end:
 	return ret_code;
 }
 
+/*
+ * Ask the session daemon for the values of a counter map of the current user.
+ *
+ * Allocates and return an lttng_counter_map_values set.
+ * On error, returns a suitable lttng_error_code.
+ */
+enum lttng_error_code lttng_counter_map_list_values(
+		const char *map_name, struct lttng_counter_map_values **values)
+{
+	int ret;
+	enum lttng_error_code ret_code = LTTNG_OK;
+	struct lttcomm_session_msg lsm = { .cmd_type = LTTNG_LIST_COUNTER_MAP };
+	struct lttng_counter_map_values *local_values = NULL;
+	struct lttng_payload reply;
+	struct lttng_payload_view lsm_view =
+			lttng_payload_view_init_from_buffer(
+				(const char *) &lsm, 0, sizeof(lsm));
+
+	lttng_payload_init(&reply);
+
+	if (!map_name || !values) {
+		ret_code = LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	ret = lttng_strncpy(lsm.u.counter_map.map_name, map_name,
+			sizeof(lsm.u.counter_map.map_name));
+	if (ret) {
+		ret_code = LTTNG_ERR_INVALID;
+		goto end;
+	}
+
+	ret = lttng_ctl_ask_sessiond_payload(&lsm_view, &reply);
+	if (ret < 0) {
+		ret_code = (enum lttng_error_code) -ret;
+		goto end;
+	}
+
+	{
+		struct lttng_payload_view reply_view =
+				lttng_payload_view_from_payload(
+						&reply, 0, reply.buffer.size);
+
+		ret = lttng_counter_map_values_create_from_payload(
+				&reply_view, &local_values);
+		if (ret < 0) {
+			ret_code = LTTNG_ERR_FATAL;
+			goto end;
+		}
+	}
+
+	*values = local_values;
+	local_values = NULL;
+end:
+	lttng_payload_reset(&reply);
+	lttng_counter_map_values_destroy(local_values);
+	return ret_code;
+}
+
+/*
+ * Ask the session daemon to clear a counter map of the current user.
+ *
+ * Return LTTNG_OK on success, else a suitable lttng_error_code.
+ */
+enum lttng_error_code lttng_counter_map_clear(const char *map_name)
+{
+	int ret;
+	struct lttcomm_session_msg lsm = { .cmd_type = LTTNG_CLEAR_COUNTER_MAP };
+
+	if (!map_name) {
+		return LTTNG_ERR_INVALID;
+	}
+
+	ret = lttng_strncpy(lsm.u.counter_map.map_name, map_name,
+			sizeof(lsm.u.counter_map.map_name));
+	if (ret) {
+		return LTTNG_ERR_INVALID;
+	}
+
+	ret = lttng_ctl_ask_sessiond(&lsm, NULL);
+	return ret < 0 ? (enum lttng_error_code) -ret : LTTNG_OK;
+}
+
 /*
  * lib constructor.
  */
@@ -198,17 +198,53 @@ void lttng_snapshot_output_list_destroy(struct lttng_snapshot_output_list *list)
  */
 int lttng_snapshot_record(const char *session_name,
 		struct lttng_snapshot_output *output, int wait)
+{
+	return lttng_snapshot_record_scoped(session_name, output, NULL, 0, 0,
+			wait);
+}
+
+/*
+ * Record a snapshot of a subset of the channels of a session, optionally
+ * bounded to the packets of the last 'time_window_us' microseconds.
+ *
+ * Return 0 on success or else a negative LTTNG_ERR code.
+ */
+int lttng_snapshot_record_scoped(const char *session_name,
+		struct lttng_snapshot_output *output,
+		const char * const *channel_names, unsigned int channel_count,
+		uint64_t time_window_us, int wait)
 {
 	int ret;
+	unsigned int i;
 	struct lttcomm_session_msg lsm;
+	char (*names)[LTTNG_SYMBOL_NAME_LEN] = NULL;
 
-	if (!session_name) {
+	if (!session_name || (channel_count && !channel_names) ||
+			channel_count > LTTNG_SNAPSHOT_RECORD_MAX_CHANNEL_COUNT) {
 		ret = -LTTNG_ERR_INVALID;
 		goto end;
 	}
 
 	memset(&lsm, 0, sizeof(lsm));
 	lsm.cmd_type = LTTNG_SNAPSHOT_RECORD;
+	lsm.u.snapshot_record.time_window_us = time_window_us;
+	lsm.u.snapshot_record.channel_count = channel_count;
+
+	if (channel_count) {
+		names = zmalloc(sizeof(*names) * channel_count);
+		if (!names) {
+			ret = -LTTNG_ERR_NOMEM;
+			goto end;
+		}
+		for (i = 0; i < channel_count; i++) {
+			if (!channel_names[i] ||
+					lttng_strncpy(names[i], channel_names[i],
+						sizeof(names[i]))) {
+				ret = -LTTNG_ERR_INVALID;
+				goto end;
+			}
+		}
+	}
 
 	ret = lttng_strncpy(lsm.session.name, session_name,
 			sizeof(lsm.session.name));
@@ -228,8 +264,10 @@ int lttng_snapshot_record(const char *session_name,
 	}
 
 	/* The wait param is ignored. */
-	ret = lttng_ctl_ask_sessiond(&lsm, NULL);
+	ret = lttng_ctl_ask_sessiond_varlen_no_cmd_header(&lsm, names,
+			sizeof(*names) * channel_count, NULL);
 end:
+	free(names);
 	return ret;
 }
 
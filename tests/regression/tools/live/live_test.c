@@ -27,7 +27,7 @@
 #include <urcu/list.h>
 #include <common/common.h>
 
-#include <bin/lttng-relayd/lttng-viewer-abi.h>
+#include <common/live/lttng-viewer-abi.h>
 #include <common/index/ctf-index.h>
 
 #include <common/compat/errno.h>
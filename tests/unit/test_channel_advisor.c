@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <bin/lttng-sessiond/channel-advisor.h>
+#include <common/defaults.h>
+#include <common/time.h>
+#include <lttng/channel-internal.h>
+
+#include <tap/tap.h>
+
+/* Number of TAP tests in this file */
+#define NUM_TESTS 24
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static uint64_t nr_cpus;
+static uint64_t page_size;
+
+static bool is_pow2(uint64_t x)
+{
+	return x && !(x & (x - 1));
+}
+
+/*
+ * Input of a channel of one buffer, observed for one second, of which each
+ * stream is consumed at `stream_rate` bytes per second.
+ */
+static void init_input(struct channel_advisor_input *input,
+		uint64_t stream_rate)
+{
+	memset(input, 0, sizeof(*input));
+	input->domain = LTTNG_DOMAIN_UST;
+	input->overwrite = 0;
+	input->subbuf_size = page_size;
+	input->num_subbuf = 4;
+	input->switch_timer_interval = 0;
+	input->throughput.buffer_count = 1;
+	input->throughput.sample_count = 2;
+	input->throughput.duration = USEC_PER_SEC;
+	input->throughput.rate = stream_rate * nr_cpus;
+	input->throughput.peak_rate = stream_rate * nr_cpus;
+	input->throughput.capacity = input->subbuf_size * input->num_subbuf;
+}
+
+static void test_not_sampled(void)
+{
+	struct channel_advisor_input input;
+	struct lttng_channel_advice advice;
+
+	init_input(&input, 0);
+	input.throughput.duration = 0;
+	input.switch_timer_interval = 1000;
+	channel_advisor_compute(&input, &advice);
+	ok(!advice.observed_period && advice.subbuf_size == page_size &&
+			advice.num_subbuf == 4 &&
+			advice.switch_timer_interval == 1000,
+			"An unsampled channel keeps its geometry");
+}
+
+static void test_rounding(void)
+{
+	struct channel_advisor_input input;
+	struct lttng_channel_advice advice;
+	/* Fills three pages and a byte per sub-buffer period. */
+	const uint64_t stream_rate = (3 * page_size + 1) * USEC_PER_SEC /
+			DEFAULT_CHANNEL_ADVISOR_SUBBUF_PERIOD;
+
+	init_input(&input, stream_rate);
+	channel_advisor_compute(&input, &advice);
+	ok(advice.observed_period == USEC_PER_SEC,
+			"The observation period is reported");
+	ok(advice.subbuf_size == 4 * page_size,
+			"The sub-buffer size is rounded up to a power of two");
+	ok(is_pow2(advice.num_subbuf),
+			"The sub-buffer count is a power of two");
+	ok(advice.subbuf_size * advice.num_subbuf >=
+			stream_rate * DEFAULT_CHANNEL_ADVISOR_BURST_PERIOD /
+					USEC_PER_SEC,
+			"The buffers absorb the peak rate during the burst period");
+
+	init_input(&input, 1);
+	channel_advisor_compute(&input, &advice);
+	ok(advice.subbuf_size == page_size,
+			"The sub-buffer size is at least a page");
+}
+
+static void test_overwrite_minimum(void)
+{
+	struct channel_advisor_input input;
+	struct lttng_channel_advice advice;
+
+	init_input(&input, 1);
+	channel_advisor_compute(&input, &advice);
+	ok(advice.num_subbuf == 2,
+			"A discard mode channel has at least two sub-buffers");
+
+	input.overwrite = 1;
+	channel_advisor_compute(&input, &advice);
+	ok(advice.num_subbuf == 4,
+			"An overwrite mode channel has at least four sub-buffers");
+}
+
+static void test_growth(void)
+{
+	struct channel_advisor_input input;
+	struct lttng_channel_advice advice;
+	const uint64_t capacity = 4 * page_size;
+
+	init_input(&input, 1);
+	input.discarded_events = 10;
+	channel_advisor_compute(&input, &advice);
+	ok(advice.subbuf_size * advice.num_subbuf >= 2 * capacity,
+			"A channel which discarded events is grown twofold");
+	ok(advice.discarded_events == 10,
+			"The discarded events are reported");
+
+	init_input(&input, 1);
+	input.lost_packets = 1;
+	channel_advisor_compute(&input, &advice);
+	ok(advice.subbuf_size * advice.num_subbuf >= 2 * capacity,
+			"A channel which lost packets is grown twofold");
+
+	init_input(&input, 1);
+	input.throughput.peak_usage = capacity / 4 * 3;
+	channel_advisor_compute(&input, &advice);
+	ok(advice.subbuf_size * advice.num_subbuf >= 2 * capacity,
+			"A nearly full channel is grown twofold");
+
+	init_input(&input, 1);
+	input.throughput.peak_usage = page_size;
+	channel_advisor_compute(&input, &advice);
+	ok(advice.subbuf_size * advice.num_subbuf < 2 * capacity &&
+			advice.subbuf_size * advice.num_subbuf >= 2 * page_size,
+			"A channel is not grown past twice its highest usage without losses");
+}
+
+static void test_switch_timer(void)
+{
+	struct channel_advisor_input input;
+	struct lttng_channel_advice advice;
+	/* Sub-buffers of four pages fill in about 133 ms. */
+	const uint64_t stream_rate = (3 * page_size + 1) * USEC_PER_SEC /
+			DEFAULT_CHANNEL_ADVISOR_SUBBUF_PERIOD;
+	const uint64_t fill_period = 4 * page_size * USEC_PER_SEC /
+			stream_rate;
+
+	init_input(&input, stream_rate);
+	input.switch_timer_interval = fill_period + 1;
+	channel_advisor_compute(&input, &advice);
+	ok(advice.switch_timer_interval == 0,
+			"A switch timer slower than the sub-buffers fill is suppressed");
+
+	input.switch_timer_interval = fill_period - 1;
+	channel_advisor_compute(&input, &advice);
+	ok(advice.switch_timer_interval == fill_period - 1,
+			"A switch timer faster than the sub-buffers fill is kept");
+
+	input.switch_timer_interval = fill_period + 1;
+	input.live = true;
+	channel_advisor_compute(&input, &advice);
+	ok(advice.switch_timer_interval == fill_period + 1,
+			"The switch timer of a live channel is kept");
+}
+
+static void test_max_buffer_size(void)
+{
+	struct channel_advisor_input input;
+	struct lttng_channel_advice advice;
+	long phys_pages = sysconf(_SC_PHYS_PAGES);
+
+	/* A channel of 1 GiB streams which keeps discarding events. */
+	init_input(&input, 1);
+	input.subbuf_size = 1ULL << 20;
+	input.num_subbuf = 1ULL << 10;
+	input.discarded_events = 1;
+	input.max_buffer_size = 64 * page_size;
+	channel_advisor_compute(&input, &advice);
+	ok(advice.subbuf_size * advice.num_subbuf == 64 * page_size &&
+			is_pow2(advice.subbuf_size) &&
+			is_pow2(advice.num_subbuf),
+			"The advised buffers are clamped to the maximum buffer size");
+
+	input.max_buffer_size = 1;
+	channel_advisor_compute(&input, &advice);
+	ok(advice.subbuf_size == page_size && advice.num_subbuf == 2,
+			"The advised buffers hold at least the minimum count of one-page sub-buffers");
+
+	/* Streams of 1 TiB exceed the memory of the test machines. */
+	input.subbuf_size = 1ULL << 30;
+	input.max_buffer_size = 0;
+	channel_advisor_compute(&input, &advice);
+	ok(phys_pages > 0 && advice.subbuf_size * advice.num_subbuf * nr_cpus <=
+			(uint64_t) phys_pages * page_size /
+					DEFAULT_CHANNEL_ADVISOR_MEMORY_SHARE,
+			"The advised buffers of all streams take a share of the memory at most");
+}
+
+/* Channel attributes as sent by a client, with the default geometry. */
+static void init_channel(struct lttng_channel *channel,
+		struct lttng_channel_extended *extended, const char *name,
+		unsigned int advisable_attrs)
+{
+	memset(channel, 0, sizeof(*channel));
+	memset(extended, 0, sizeof(*extended));
+	strcpy(channel->name, name);
+	channel->attr.subbuf_size = page_size;
+	channel->attr.num_subbuf = 4;
+	channel->attr.switch_timer_interval = 0;
+	extended->advisable_attrs = advisable_attrs;
+	channel->attr.extended.ptr = extended;
+}
+
+static void test_apply(void)
+{
+	unsigned int i;
+	struct lttng_channel channel;
+	struct lttng_channel_extended extended;
+	struct lttng_channel_advice advice = {
+		.observed_period = USEC_PER_SEC,
+		.subbuf_size = 16 * page_size,
+		.num_subbuf = 8,
+		.switch_timer_interval = 1000,
+	};
+	const uid_t uid = 1000;
+	char name[LTTNG_SYMBOL_NAME_LEN];
+
+	channel_advisor_record(uid, LTTNG_DOMAIN_UST, "chan", &advice);
+
+	init_channel(&channel, &extended, "chan", 0);
+	channel_advisor_apply(uid, LTTNG_DOMAIN_UST, &channel);
+	ok(channel.attr.subbuf_size == page_size &&
+			channel.attr.num_subbuf == 4 &&
+			channel.attr.switch_timer_interval == 0,
+			"Explicitly set attributes equal to the defaults are kept");
+
+	init_channel(&channel, &extended, "chan",
+			LTTNG_CHANNEL_ADVISABLE_ATTR_NUM_SUBBUF);
+	channel_advisor_apply(uid, LTTNG_DOMAIN_UST, &channel);
+	ok(channel.attr.subbuf_size == page_size &&
+			channel.attr.num_subbuf == 8 &&
+			channel.attr.switch_timer_interval == 0,
+			"Only the advisable attributes are replaced");
+
+	init_channel(&channel, &extended, "chan",
+			LTTNG_CHANNEL_ADVISABLE_ATTR_SUBBUF_SIZE |
+			LTTNG_CHANNEL_ADVISABLE_ATTR_NUM_SUBBUF |
+			LTTNG_CHANNEL_ADVISABLE_ATTR_SWITCH_TIMER);
+	channel_advisor_apply(uid + 1, LTTNG_DOMAIN_UST, &channel);
+	ok(channel.attr.subbuf_size == page_size,
+			"The advice of another user's channel is not applied");
+
+	/* Evict the first record with as many records as are kept. */
+	for (i = 0; i < DEFAULT_CHANNEL_ADVISOR_MAX_RECORDS; i++) {
+		sprintf(name, "other%u", i);
+		channel_advisor_record(uid, LTTNG_DOMAIN_UST, name, &advice);
+	}
+
+	init_channel(&channel, &extended, "chan",
+			LTTNG_CHANNEL_ADVISABLE_ATTR_SUBBUF_SIZE);
+	channel_advisor_apply(uid, LTTNG_DOMAIN_UST, &channel);
+	ok(channel.attr.subbuf_size == page_size,
+			"The least recently used advice is forgotten past %d channels",
+			DEFAULT_CHANNEL_ADVISOR_MAX_RECORDS);
+
+	init_channel(&channel, &extended, name,
+			LTTNG_CHANNEL_ADVISABLE_ATTR_SUBBUF_SIZE);
+	channel_advisor_apply(uid, LTTNG_DOMAIN_UST, &channel);
+	ok(channel.attr.subbuf_size == 16 * page_size,
+			"The most recently used advice is kept");
+
+	channel_advisor_fini();
+}
+
+int main(void)
+{
+	long ret;
+
+	plan_tests(NUM_TESTS);
+
+	ret = sysconf(_SC_NPROCESSORS_CONF);
+	nr_cpus = ret > 0 ? ret : 1;
+	ret = sysconf(_SC_PAGESIZE);
+	page_size = ret > 0 ? ret : 4096;
+
+	diag("Channel advisor unit tests");
+
+	test_not_sampled();
+	test_rounding();
+	test_overwrite_minimum();
+	test_growth();
+	test_switch_timer();
+	test_max_buffer_size();
+	test_apply();
+
+	return exit_status();
+}
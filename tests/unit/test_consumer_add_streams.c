@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <bin/lttng-sessiond/consumer.h>
+#include <common/sessiond-comm/sessiond-comm.h>
+
+#include <tap/tap.h>
+
+/* Number of TAP tests in this file */
+#define NUM_TESTS 13
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+#define CHANNEL_KEY 42
+/* More streams than the file descriptors passed in a single message. */
+#define MAX_STREAM_COUNT (2 * LTTCOMM_MAX_SEND_FDS + 1)
+
+/* What the fake consumer daemon received and how it must answer. */
+struct fake_consumerd {
+	int fd;
+	enum lttcomm_return_code reply_code;
+	/* Inode of the file all the stream file descriptors refer to. */
+	ino_t stream_ino;
+	/* Received. */
+	bool msg_valid;
+	bool infos_valid;
+	unsigned int fd_count;
+	bool fds_valid;
+};
+
+/* Receive an ADD_STREAMS exchange the way the kernel consumer daemon does. */
+static void *fake_consumerd_thread(void *data)
+{
+	struct fake_consumerd *consumerd = data;
+	struct lttcomm_consumer_msg msg;
+	struct lttcomm_consumer_stream_info infos[MAX_STREAM_COUNT];
+	struct lttcomm_consumer_status_msg reply;
+	uint32_t i, stream_count;
+
+	if (lttcomm_recv_unix_sock(consumerd->fd, &msg, sizeof(msg)) !=
+			sizeof(msg)) {
+		goto end;
+	}
+	stream_count = msg.u.streams.stream_count;
+	consumerd->msg_valid = msg.cmd_type == LTTNG_CONSUMER_ADD_STREAMS &&
+			msg.u.streams.channel_key == CHANNEL_KEY &&
+			stream_count <= MAX_STREAM_COUNT;
+	if (!consumerd->msg_valid) {
+		goto end;
+	}
+
+	if (lttcomm_recv_unix_sock(consumerd->fd, infos,
+			sizeof(infos[0]) * stream_count) !=
+			sizeof(infos[0]) * stream_count) {
+		goto end;
+	}
+	consumerd->infos_valid = true;
+	for (i = 0; i < stream_count; i++) {
+		if (infos[i].cpu != (int32_t) i) {
+			consumerd->infos_valid = false;
+		}
+	}
+
+	consumerd->fds_valid = true;
+	while (consumerd->fd_count < stream_count) {
+		int fds[LTTCOMM_MAX_SEND_FDS];
+		const size_t chunk = min_t(size_t,
+				stream_count - consumerd->fd_count,
+				LTTCOMM_MAX_SEND_FDS);
+
+		if (lttcomm_recv_fds_unix_sock(consumerd->fd, fds, chunk) !=
+				sizeof(int) * chunk) {
+			consumerd->fds_valid = false;
+			goto end;
+		}
+
+		for (i = 0; i < chunk; i++) {
+			struct stat st;
+
+			if (fstat(fds[i], &st) ||
+					st.st_ino != consumerd->stream_ino) {
+				consumerd->fds_valid = false;
+			}
+			(void) close(fds[i]);
+		}
+		consumerd->fd_count += chunk;
+	}
+
+	reply.ret_code = consumerd->reply_code;
+	(void) lttcomm_send_unix_sock(consumerd->fd, &reply, sizeof(reply));
+end:
+	return NULL;
+}
+
+/*
+ * Hand `stream_count` streams to a fake consumer daemon and return the result
+ * of consumer_send_streams().
+ */
+static int send_streams(uint32_t stream_count,
+		enum lttcomm_return_code reply_code,
+		struct fake_consumerd *consumerd)
+{
+	int ret, sock_fds[2], pipe_fds[2], stream_fds[MAX_STREAM_COUNT];
+	uint32_t i;
+	pthread_t thread;
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	struct consumer_socket socket;
+	struct lttcomm_consumer_msg msg;
+	struct lttcomm_consumer_stream_info infos[MAX_STREAM_COUNT];
+	struct stat st;
+
+	ret = socketpair(AF_UNIX, SOCK_STREAM, 0, sock_fds);
+	assert(!ret);
+
+	/* Each stream is a duplicate of the same pipe end. */
+	ret = pipe(pipe_fds);
+	assert(!ret);
+	(void) close(pipe_fds[1]);
+	stream_fds[0] = pipe_fds[0];
+	ret = fstat(stream_fds[0], &st);
+	assert(!ret);
+	for (i = 0; i < stream_count; i++) {
+		if (i > 0) {
+			stream_fds[i] = dup(stream_fds[0]);
+			assert(stream_fds[i] >= 0);
+		}
+		infos[i].cpu = (int32_t) i;
+	}
+
+	memset(&socket, 0, sizeof(socket));
+	socket.fd_ptr = &sock_fds[0];
+	socket.lock = &lock;
+
+	memset(consumerd, 0, sizeof(*consumerd));
+	consumerd->fd = sock_fds[1];
+	consumerd->reply_code = reply_code;
+	consumerd->stream_ino = st.st_ino;
+
+	ret = pthread_create(&thread, NULL, fake_consumerd_thread, consumerd);
+	assert(!ret);
+
+	consumer_init_add_streams_comm_msg(&msg, CHANNEL_KEY, stream_count);
+	pthread_mutex_lock(&lock);
+	ret = consumer_send_streams(&socket, &msg, infos, stream_fds,
+			stream_count);
+	pthread_mutex_unlock(&lock);
+
+	/* Unblock the fake consumer daemon if the peer stopped early. */
+	if (sock_fds[0] >= 0) {
+		(void) shutdown(sock_fds[0], SHUT_RDWR);
+	}
+	(void) pthread_join(thread, NULL);
+
+	for (i = 0; i < stream_count; i++) {
+		(void) close(stream_fds[i]);
+	}
+	if (sock_fds[0] >= 0) {
+		(void) close(sock_fds[0]);
+	}
+	(void) close(sock_fds[1]);
+	return ret;
+}
+
+static void test_single_stream(void)
+{
+	struct fake_consumerd consumerd;
+
+	diag("Handing a single stream to the consumer daemon");
+	ok(send_streams(1, LTTCOMM_CONSUMERD_SUCCESS, &consumerd) == 0,
+			"Stream handed");
+	ok(consumerd.msg_valid, "ADD_STREAMS message received");
+	ok(consumerd.infos_valid, "Stream attributes received");
+	ok(consumerd.fd_count == 1 && consumerd.fds_valid,
+			"Stream file descriptor received");
+}
+
+static void test_many_streams(void)
+{
+	struct fake_consumerd consumerd;
+
+	diag("Handing more streams than file descriptors passed at once");
+	ok(send_streams(MAX_STREAM_COUNT, LTTCOMM_CONSUMERD_SUCCESS,
+			&consumerd) == 0,
+			"Streams handed");
+	ok(consumerd.msg_valid, "ADD_STREAMS message received");
+	ok(consumerd.infos_valid, "Stream attributes received in order");
+	ok(consumerd.fd_count == MAX_STREAM_COUNT,
+			"All the stream file descriptors received in chunks");
+	ok(consumerd.fds_valid, "Stream file descriptors valid");
+}
+
+static void test_consumerd_error(void)
+{
+	struct fake_consumerd consumerd;
+	int ret;
+
+	diag("Handing streams to a consumer daemon failing to add them");
+	ret = send_streams(MAX_STREAM_COUNT, LTTCOMM_CONSUMERD_CHAN_NOT_FOUND,
+			&consumerd);
+	ok(ret == -LTTCOMM_CONSUMERD_CHAN_NOT_FOUND,
+			"Error of the consumer daemon reported");
+	ok(consumerd.fd_count == MAX_STREAM_COUNT,
+			"Error reported once all the streams are received");
+	ok(consumerd.fds_valid, "Stream file descriptors valid");
+	ok(consumerd.msg_valid && consumerd.infos_valid,
+			"Single exchange for all the streams");
+}
+
+int main(int argc, char **argv)
+{
+	plan_tests(NUM_TESTS);
+
+	test_single_stream();
+	test_many_streams();
+	test_consumerd_error();
+
+	return exit_status();
+}
@@ -0,0 +1,539 @@
+/*
+ * Unit tests for the counter maps.
+ *
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <urcu.h>
+
+#include <bin/lttng-sessiond/counter-map.h>
+#include <common/defaults.h>
+#include <common/payload-view.h>
+#include <common/payload.h>
+#include <lttng/action/action-internal.h>
+#include <lttng/action/increment-counter-internal.h>
+#include <lttng/action/increment-counter.h>
+#include <lttng/condition/on-event-internal.h>
+#include <lttng/condition/on-event.h>
+#include <lttng/counter-map-internal.h>
+#include <lttng/counter-map.h>
+#include <lttng/event-expr.h>
+#include <lttng/event-field-value-internal.h>
+#include <lttng/event-rule/tracepoint.h>
+#include <lttng/trigger/trigger-internal.h>
+
+#include <tap/tap.h>
+
+/* Number of TAP tests in this file */
+#define NUM_TESTS 46
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static struct lttng_action *create_increment_counter(const char *map_name,
+		const char *key)
+{
+	struct lttng_action *action;
+
+	action = lttng_action_increment_counter_create();
+	assert(action);
+	assert(lttng_action_increment_counter_set_map_name(action, map_name) ==
+			LTTNG_ACTION_STATUS_OK);
+	assert(lttng_action_increment_counter_set_key(action, key) ==
+			LTTNG_ACTION_STATUS_OK);
+	return action;
+}
+
+/*
+ * Create a trigger of `uid` on an event rule capturing the `comm` field, with
+ * an error count of `error_count`.
+ */
+static struct lttng_trigger *create_trigger(uid_t uid,
+		struct lttng_action *action, uint64_t tracer_token,
+		uint64_t error_count)
+{
+	struct lttng_event_rule *rule;
+	struct lttng_condition *condition;
+	struct lttng_trigger *trigger;
+	const struct lttng_credentials creds = {
+		.uid = LTTNG_OPTIONAL_INIT_VALUE(uid),
+		.gid = LTTNG_OPTIONAL_INIT_UNSET,
+	};
+
+	rule = lttng_event_rule_tracepoint_create(LTTNG_DOMAIN_UST);
+	assert(rule);
+	assert(lttng_event_rule_tracepoint_set_pattern(rule, "tp:*") ==
+			LTTNG_EVENT_RULE_STATUS_OK);
+	condition = lttng_condition_on_event_create(rule);
+	assert(condition);
+	assert(lttng_condition_on_event_append_capture_descriptor(condition,
+			lttng_event_expr_event_payload_field_create("comm")) ==
+			LTTNG_CONDITION_STATUS_OK);
+	lttng_condition_on_event_set_error_count(condition, error_count);
+
+	trigger = lttng_trigger_create(condition, action);
+	assert(trigger);
+	lttng_trigger_set_credentials(trigger, &creds);
+	lttng_trigger_set_tracer_token(trigger, tracer_token);
+
+	lttng_condition_put(condition);
+	lttng_event_rule_destroy(rule);
+	return trigger;
+}
+
+/* Captured values: an unsigned integer and, if `comm` is set, a string. */
+static struct lttng_event_field_value *create_captured_values(uint64_t pid,
+		const char *comm)
+{
+	struct lttng_event_field_value *values;
+
+	values = lttng_event_field_value_array_create();
+	assert(values);
+	assert(!lttng_event_field_value_array_append(values,
+			lttng_event_field_value_uint_create(pid)));
+	if (comm) {
+		assert(!lttng_event_field_value_array_append(values,
+				lttng_event_field_value_string_create(comm)));
+	} else {
+		assert(!lttng_event_field_value_array_append_unavailable(
+				values));
+	}
+
+	return values;
+}
+
+static uint64_t get_dropped_count(
+		const struct lttng_counter_map_values *values)
+{
+	uint64_t dropped_count;
+
+	assert(lttng_counter_map_values_get_dropped_count(values,
+			&dropped_count) == LTTNG_COUNTER_MAP_STATUS_OK);
+	return dropped_count;
+}
+
+/* Value of `key` in `values`, or -1 if it is absent. */
+static int64_t get_value(const struct lttng_counter_map_values *values,
+		const char *key)
+{
+	unsigned int i, count;
+
+	assert(lttng_counter_map_values_get_count(values, &count) ==
+			LTTNG_COUNTER_MAP_STATUS_OK);
+	for (i = 0; i < count; i++) {
+		const char *entry_key;
+		uint64_t value;
+
+		assert(lttng_counter_map_values_get_at_index(values, i,
+				&entry_key, &value) ==
+				LTTNG_COUNTER_MAP_STATUS_OK);
+		if (!strcmp(entry_key, key)) {
+			return (int64_t) value;
+		}
+	}
+
+	return -1;
+}
+
+static void test_action_increment_counter(void)
+{
+	int ret;
+	const char *str;
+	unsigned int capture_index;
+	struct lttng_action *action, *other, *action_from_buffer = NULL;
+	struct lttng_payload payload;
+
+	diag("Testing the increment counter action.");
+	lttng_payload_init(&payload);
+
+	action = lttng_action_increment_counter_create();
+	ok(action, "Increment counter action created");
+	ok(lttng_action_increment_counter_get_map_name(action, &str) ==
+			LTTNG_ACTION_STATUS_UNSET,
+			"Map name of a new action is unset");
+	ok(lttng_action_increment_counter_set_map_name(action, NULL) ==
+			LTTNG_ACTION_STATUS_INVALID,
+			"NULL map name is rejected");
+	ok(lttng_action_increment_counter_set_map_name(action, "errors") ==
+			LTTNG_ACTION_STATUS_OK, "Map name set");
+	ok(lttng_action_increment_counter_set_key(action, "disk-full") ==
+			LTTNG_ACTION_STATUS_OK, "Key set");
+	ok(lttng_action_increment_counter_get_key_capture_index(action,
+			&capture_index) == LTTNG_ACTION_STATUS_UNSET,
+			"Key capture index of a new action is unset");
+
+	ret = lttng_action_serialize(action, &payload);
+	ok(ret == 0, "Action serialized");
+	{
+		struct lttng_payload_view view =
+				lttng_payload_view_from_payload(
+						&payload, 0, -1);
+
+		ok(lttng_action_create_from_payload(&view,
+				&action_from_buffer) > 0,
+				"Action created from payload");
+	}
+
+	ok(lttng_action_is_equal(action, action_from_buffer),
+			"Serialized and deserialized actions are equal");
+	ok(lttng_action_increment_counter_get_map_name(action_from_buffer,
+			&str) == LTTNG_ACTION_STATUS_OK &&
+			!strcmp(str, "errors"),
+			"Map name survives the round trip");
+	ok(lttng_action_increment_counter_get_key(action_from_buffer,
+			&str) == LTTNG_ACTION_STATUS_OK &&
+			!strcmp(str, "disk-full"),
+			"Key survives the round trip");
+
+	other = create_increment_counter("errors", "disk-error");
+	ok(!lttng_action_is_equal(action, other),
+			"Actions with different keys are not equal");
+	lttng_action_destroy(other);
+
+	other = create_increment_counter("warnings", "disk-full");
+	ok(!lttng_action_is_equal(action, other),
+			"Actions with different map names are not equal");
+	lttng_action_destroy(other);
+
+	other = create_increment_counter("errors", "disk-full");
+	ok(lttng_action_increment_counter_set_key_capture_index(other, 2) ==
+			LTTNG_ACTION_STATUS_OK, "Key capture index set");
+	ok(!lttng_action_is_equal(action, other),
+			"Actions with different key capture indexes are not equal");
+
+	lttng_action_destroy(action_from_buffer);
+	action_from_buffer = NULL;
+	lttng_payload_reset(&payload);
+	lttng_payload_init(&payload);
+	ret = lttng_action_serialize(other, &payload);
+	assert(!ret);
+	{
+		struct lttng_payload_view view =
+				lttng_payload_view_from_payload(
+						&payload, 0, -1);
+
+		ret = lttng_action_create_from_payload(&view,
+				&action_from_buffer) <= 0;
+		assert(!ret);
+	}
+
+	ok(lttng_action_increment_counter_get_key_capture_index(
+			action_from_buffer, &capture_index) ==
+			LTTNG_ACTION_STATUS_OK && capture_index == 2,
+			"Key capture index survives the round trip");
+	lttng_action_destroy(other);
+
+	lttng_action_destroy(action);
+	lttng_action_destroy(action_from_buffer);
+	lttng_payload_reset(&payload);
+}
+
+static void test_counter_map_values_serialization(void)
+{
+	int ret;
+	unsigned int count;
+	const char *key;
+	uint64_t value;
+	struct lttng_counter_map_values *values, *values_from_buffer = NULL;
+	struct lttng_payload payload;
+
+	diag("Testing the serialization of counter map values.");
+	lttng_payload_init(&payload);
+
+	values = lttng_counter_map_values_create();
+	ok(values, "Counter map values created");
+	ret = lttng_counter_map_values_add(values, "disk-full", 3);
+	ret |= lttng_counter_map_values_add(values, "disk-error", UINT64_MAX);
+	ok(ret == 0, "Values added");
+	lttng_counter_map_values_set_dropped_count(values, 7);
+
+	ret = lttng_counter_map_values_serialize(values, &payload);
+	ok(ret == 0, "Values serialized");
+	{
+		struct lttng_payload_view view =
+				lttng_payload_view_from_payload(
+						&payload, 0, -1);
+
+		ok(lttng_counter_map_values_create_from_payload(&view,
+				&values_from_buffer) ==
+				(ssize_t) payload.buffer.size,
+				"Values created from payload, consuming all of it");
+	}
+
+	ok(lttng_counter_map_values_get_count(values_from_buffer, &count) ==
+			LTTNG_COUNTER_MAP_STATUS_OK && count == 2,
+			"Count survives the round trip");
+	ok(get_value(values_from_buffer, "disk-full") == 3,
+			"First value survives the round trip");
+	ok((uint64_t) get_value(values_from_buffer, "disk-error") ==
+			UINT64_MAX,
+			"64-bit value survives the round trip");
+	ok(lttng_counter_map_values_get_at_index(values_from_buffer, count,
+			&key, &value) ==
+			LTTNG_COUNTER_MAP_STATUS_INVALID,
+			"Out of bounds index is rejected");
+	ok(get_dropped_count(values_from_buffer) == 7,
+			"Dropped count survives the round trip");
+
+	lttng_counter_map_values_destroy(values);
+	lttng_counter_map_values_destroy(values_from_buffer);
+	lttng_payload_reset(&payload);
+}
+
+static void test_counter_map_isolation(void)
+{
+	unsigned int count;
+	struct lttng_counter_map_values *values = NULL;
+	struct lttng_action *errors_full, *errors_error, *warnings_full;
+	const uid_t uid = 1000, other_uid = 1001;
+	struct lttng_triggers *triggers = lttng_triggers_create();
+
+	diag("Testing the isolation of the counter maps.");
+	assert(triggers);
+	ok(counter_map_init() == 0, "Counter maps initialized");
+
+	errors_full = create_increment_counter("errors", "disk-full");
+	errors_error = create_increment_counter("errors", "disk-error");
+	warnings_full = create_increment_counter("warnings", "disk-full");
+
+	counter_map_increment(uid, errors_full, NULL);
+	counter_map_increment(uid, errors_full, NULL);
+	counter_map_increment(uid, errors_error, NULL);
+	counter_map_increment(uid, warnings_full, NULL);
+	counter_map_increment(other_uid, errors_full, NULL);
+
+	ok(counter_map_list_values(uid, "errors", triggers, &values) == LTTNG_OK,
+			"Values of a map listed");
+	ok(lttng_counter_map_values_get_count(values, &count) ==
+			LTTNG_COUNTER_MAP_STATUS_OK && count == 2,
+			"Only the keys of the map are listed");
+	ok(get_value(values, "disk-full") == 2 &&
+			get_value(values, "disk-error") == 1,
+			"Only the increments of the uid are counted");
+	lttng_counter_map_values_destroy(values);
+	values = NULL;
+
+	ok(counter_map_list_values(uid, "unknown", triggers, &values) == LTTNG_OK &&
+			lttng_counter_map_values_get_count(values, &count) ==
+					LTTNG_COUNTER_MAP_STATUS_OK &&
+			count == 0,
+			"Unknown map is empty");
+	lttng_counter_map_values_destroy(values);
+	values = NULL;
+
+	ok(counter_map_clear(uid, "errors", triggers) == LTTNG_OK, "Map cleared");
+	ok(counter_map_list_values(uid, "errors", triggers, &values) == LTTNG_OK &&
+			lttng_counter_map_values_get_count(values, &count) ==
+					LTTNG_COUNTER_MAP_STATUS_OK &&
+			count == 0,
+			"Cleared map is empty");
+	lttng_counter_map_values_destroy(values);
+	values = NULL;
+
+	ok(counter_map_list_values(uid, "warnings", triggers, &values) == LTTNG_OK &&
+			get_value(values, "disk-full") == 1,
+			"Clearing a map leaves the other maps of the uid intact");
+	lttng_counter_map_values_destroy(values);
+	values = NULL;
+
+	ok(counter_map_list_values(other_uid, "errors", triggers, &values) == LTTNG_OK &&
+			get_value(values, "disk-full") == 1,
+			"Clearing a map leaves the map of another uid intact");
+	lttng_counter_map_values_destroy(values);
+	values = NULL;
+
+	counter_map_increment(uid, errors_full, NULL);
+	ok(counter_map_list_values(uid, "errors", triggers, &values) == LTTNG_OK &&
+			get_value(values, "disk-full") == 1,
+			"Cleared map counts from zero");
+	lttng_counter_map_values_destroy(values);
+
+	lttng_action_destroy(errors_full);
+	lttng_action_destroy(errors_error);
+	lttng_action_destroy(warnings_full);
+	lttng_triggers_destroy(triggers);
+	counter_map_fini();
+	rcu_barrier();
+}
+
+static void test_counter_map_captured_keys(void)
+{
+	uint64_t i;
+	unsigned int count;
+	char long_comm[DEFAULT_COUNTER_MAP_KEY_MAX_LEN * 2];
+	char truncated_key[DEFAULT_COUNTER_MAP_KEY_MAX_LEN];
+	struct lttng_counter_map_values *values = NULL;
+	struct lttng_event_field_value *bash, *zsh, *unavailable, *long_value;
+	struct lttng_action *comm_action, *pid_action;
+	struct lttng_triggers *triggers = lttng_triggers_create();
+	const uid_t uid = 1000;
+
+	diag("Testing the keys completed by captured event field values.");
+	assert(triggers);
+	assert(!counter_map_init());
+
+	comm_action = create_increment_counter("comms", "comm");
+	assert(lttng_action_increment_counter_set_key_capture_index(
+			comm_action, 1) == LTTNG_ACTION_STATUS_OK);
+	pid_action = create_increment_counter("pids", "pid");
+	assert(lttng_action_increment_counter_set_key_capture_index(
+			pid_action, 0) == LTTNG_ACTION_STATUS_OK);
+
+	memset(long_comm, 'a', sizeof(long_comm) - 1);
+	long_comm[sizeof(long_comm) - 1] = '\0';
+	bash = create_captured_values(1, "bash");
+	zsh = create_captured_values(2, "zsh");
+	unavailable = create_captured_values(3, NULL);
+	long_value = create_captured_values(4, long_comm);
+
+	counter_map_increment(uid, comm_action, bash);
+	counter_map_increment(uid, comm_action, bash);
+	counter_map_increment(uid, comm_action, zsh);
+	counter_map_increment(uid, comm_action, unavailable);
+	counter_map_increment(uid, comm_action, NULL);
+	counter_map_increment(uid, comm_action, long_value);
+
+	assert(counter_map_list_values(uid, "comms", triggers, &values) ==
+			LTTNG_OK);
+	ok(get_value(values, "comm=bash") == 2 &&
+			get_value(values, "comm=zsh") == 1,
+			"Each captured value is counted under its own key");
+	ok(get_value(values, "comm=?") == 2,
+			"Missing and unavailable captured values share a key");
+	/* "comm=" followed by as many 'a' as fit in a key. */
+	strcpy(truncated_key, "comm=");
+	memset(truncated_key + strlen("comm="), 'a',
+			sizeof(truncated_key) - strlen("comm=") - 1);
+	truncated_key[sizeof(truncated_key) - 1] = '\0';
+	ok(get_value(values, truncated_key) == 1, "Long keys are truncated");
+	lttng_counter_map_values_destroy(values);
+	values = NULL;
+
+	for (i = 0; i <= DEFAULT_COUNTER_MAP_MAX_KEYS; i++) {
+		struct lttng_event_field_value *pid =
+				create_captured_values(i, "bash");
+
+		counter_map_increment(uid, pid_action, pid);
+		lttng_event_field_value_destroy(pid);
+	}
+
+	assert(counter_map_list_values(uid, "pids", triggers, &values) ==
+			LTTNG_OK);
+	ok(lttng_counter_map_values_get_count(values, &count) ==
+			LTTNG_COUNTER_MAP_STATUS_OK &&
+			count == DEFAULT_COUNTER_MAP_MAX_KEYS,
+			"Map holds at most %d keys", DEFAULT_COUNTER_MAP_MAX_KEYS);
+	ok(get_dropped_count(values) == 1,
+			"Increment of a key beyond the maximum is dropped");
+	lttng_counter_map_values_destroy(values);
+
+	lttng_event_field_value_destroy(bash);
+	lttng_event_field_value_destroy(zsh);
+	lttng_event_field_value_destroy(unavailable);
+	lttng_event_field_value_destroy(long_value);
+	lttng_action_destroy(comm_action);
+	lttng_action_destroy(pid_action);
+	lttng_triggers_destroy(triggers);
+	counter_map_fini();
+	rcu_barrier();
+}
+
+static void test_counter_map_dropped(void)
+{
+	struct lttng_counter_map_values *values = NULL;
+	struct lttng_action *action;
+	struct lttng_trigger *trigger;
+	struct lttng_triggers *triggers = lttng_triggers_create();
+	const uid_t uid = 1000, other_uid = 1001;
+
+	diag("Testing the dropped increments of the counter maps.");
+	assert(triggers);
+	assert(!counter_map_init());
+
+	action = create_increment_counter("errors", "disk-full");
+	assert(lttng_action_increment_counter_set_key_capture_index(action,
+			1) == LTTNG_ACTION_STATUS_OK);
+	trigger = create_trigger(uid, action, 1, 0);
+	ok(!lttng_trigger_validate(trigger),
+			"Trigger with a key capture index beyond its captures is invalid");
+	lttng_trigger_put(trigger);
+	assert(lttng_action_increment_counter_set_key_capture_index(action,
+			0) == LTTNG_ACTION_STATUS_OK);
+	trigger = create_trigger(uid, action, 1, 0);
+	ok(lttng_trigger_validate(trigger),
+			"Trigger with a key capture index within its captures is valid");
+	lttng_trigger_put(trigger);
+	lttng_action_destroy(action);
+
+	/* The kernel tracer discarded 5 notifications of the trigger. */
+	action = create_increment_counter("errors", "disk-full");
+	trigger = create_trigger(uid, action, 42, 5);
+	assert(!lttng_triggers_add(triggers, trigger));
+
+	counter_map_increment_trigger(trigger, NULL);
+	counter_map_drop_trigger(trigger);
+	assert(counter_map_list_values(uid, "errors", triggers, &values) ==
+			LTTNG_OK);
+	ok(get_value(values, "disk-full") == 1 &&
+			get_dropped_count(values) == 6,
+			"Increments dropped by the session daemon and the tracer are counted");
+	lttng_counter_map_values_destroy(values);
+	values = NULL;
+
+	assert(counter_map_list_values(other_uid, "errors", triggers,
+			&values) == LTTNG_OK);
+	ok(get_dropped_count(values) == 0,
+			"Dropped increments of the map of another uid are not counted");
+	lttng_counter_map_values_destroy(values);
+	values = NULL;
+
+	assert(counter_map_clear(uid, "errors", triggers) == LTTNG_OK);
+	assert(counter_map_list_values(uid, "errors", triggers, &values) ==
+			LTTNG_OK);
+	ok(get_dropped_count(values) == 0,
+			"Cleared map has no dropped increments");
+	lttng_counter_map_values_destroy(values);
+	values = NULL;
+
+	lttng_condition_on_event_set_error_count(
+			lttng_trigger_get_condition(trigger), 8);
+	counter_map_drop_trigger(trigger);
+	assert(counter_map_list_values(uid, "errors", triggers, &values) ==
+			LTTNG_OK);
+	ok(get_dropped_count(values) == 4,
+			"Cleared map counts the dropped increments from the clear");
+	lttng_counter_map_values_destroy(values);
+
+	lttng_trigger_put(trigger);
+	lttng_action_destroy(action);
+	lttng_triggers_destroy(triggers);
+	counter_map_fini();
+	rcu_barrier();
+}
+
+int main(int argc, char **argv)
+{
+	plan_tests(NUM_TESTS);
+
+	rcu_register_thread();
+	test_action_increment_counter();
+	test_counter_map_values_serialization();
+	test_counter_map_isolation();
+	test_counter_map_captured_keys();
+	test_counter_map_dropped();
+	rcu_unregister_thread();
+
+	return exit_status();
+}
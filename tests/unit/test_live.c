@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <common/buffer-view.h>
+#include <common/live/packet-list.h>
+#include <common/live/stream-filter.h>
+#include <tap/tap.h>
+
+#define NUM_TESTS 26
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static char packet_data[1024];
+
+static struct live_packet *append_packet(struct live_packet_list *list,
+		size_t size, uint64_t retention_size)
+{
+	const struct lttng_buffer_view view =
+			lttng_buffer_view_init(packet_data, 0, size);
+	struct live_packet *packet = live_packet_create(&view);
+
+	if (!packet) {
+		diag("Failed to create a packet");
+		exit(EXIT_FAILURE);
+	}
+	live_packet_list_append(list, packet, retention_size);
+	return packet;
+}
+
+static void test_packet_retention(void)
+{
+	struct live_packet_list list;
+	struct live_packet *packet, *pinned;
+
+	diag("Packet retention");
+	live_packet_list_init(&list);
+	ok(live_packet_list_last_offset(&list) == 0 &&
+			!live_packet_list_next(&list, 0),
+			"An empty list has no packet to read");
+
+	append_packet(&list, 100, 250);
+	append_packet(&list, 100, 250);
+	ok(list.retained_size == 200 && list.next_offset == 200,
+			"Packets are retained within the retention size");
+
+	packet = append_packet(&list, 100, 250);
+	ok(packet->offset == 200, "Packets are laid out in consumption order");
+	ok(list.retained_size == 200, "The oldest packet is evicted");
+	ok(!live_packet_list_find(&list, 0),
+			"An evicted packet is no longer found");
+	ok(live_packet_list_find(&list, 100) &&
+			live_packet_list_find(&list, 100)->offset == 100,
+			"A retained packet is found by offset");
+	ok(!live_packet_list_find(&list, 150),
+			"No packet is found in the middle of a packet");
+	ok(live_packet_list_next(&list, 0) &&
+			live_packet_list_next(&list, 0)->offset == 100,
+			"The packets evicted before being read are skipped");
+	ok(live_packet_list_next(&list, 200) == packet,
+			"The next packet is found at its offset");
+	ok(!live_packet_list_next(&list, 300),
+			"There is no packet past the last one");
+	ok(live_packet_list_last_offset(&list) == 200,
+			"The last offset is the one of the newest packet");
+
+	pinned = live_packet_list_find(&list, 200);
+	live_packet_get(pinned);
+	packet = append_packet(&list, 1000, 250);
+	ok(packet->offset == 300 && list.retained_size == 1000 &&
+			live_packet_list_next(&list, 0) == packet,
+			"The newest packet is kept even if it exceeds the retention size");
+	ok(pinned->refcount == 1 && pinned->size == 100 &&
+			!memcmp(pinned->data, packet_data, pinned->size),
+			"A packet held by a viewer outlives its eviction");
+	live_packet_put(pinned);
+
+	live_packet_list_reset(&list);
+	ok(list.retained_size == 0 && !live_packet_list_next(&list, 0) &&
+			live_packet_list_last_offset(&list) == 1300,
+			"A reset list keeps the offset of the next packet");
+}
+
+static struct live_stream_filter *create_filter(const char *channel_name,
+		const uint32_t *cpus, uint32_t cpu_count)
+{
+	struct live_stream_filter *filter;
+
+	filter = calloc(1, sizeof(*filter) + cpu_count * sizeof(*cpus));
+	if (!filter) {
+		diag("Failed to allocate a stream filter");
+		exit(EXIT_FAILURE);
+	}
+	strcpy(filter->channel_name, channel_name);
+	filter->cpu_count = cpu_count;
+	if (cpu_count) {
+		memcpy(filter->cpus, cpus, cpu_count * sizeof(*cpus));
+	}
+	return filter;
+}
+
+static void test_stream_filter(void)
+{
+	const uint32_t cpus[] = { 1, 3 };
+	struct live_stream_filter *channel_filter, *cpu_filter,
+			*channel_cpu_filter;
+
+	diag("Stream filter");
+	channel_filter = create_filter("chan", NULL, 0);
+	cpu_filter = create_filter("", cpus, 2);
+	channel_cpu_filter = create_filter("chan", cpus, 2);
+
+	ok(live_stream_filter_match(NULL, "chan_0", false),
+			"No filter selects every stream");
+	ok(live_stream_filter_match(channel_filter, "metadata", true),
+			"Metadata streams are always selected");
+	ok(live_stream_filter_match(channel_filter, "chan_0", false) &&
+			live_stream_filter_match(channel_filter, "chan_12", false),
+			"The per-CPU streams of the channel are selected");
+	ok(!live_stream_filter_match(channel_filter, "chan2_0", false) &&
+			!live_stream_filter_match(channel_filter, "cha_0", false),
+			"The streams of other channels are not selected");
+	ok(live_stream_filter_match(channel_filter, "chan", false),
+			"A stream without a CPU suffix is matched as a whole");
+	ok(!live_stream_filter_match(channel_filter, "chan_x", false),
+			"A non-numeric suffix is part of the channel name");
+	ok(live_stream_filter_match(cpu_filter, "any_1", false) &&
+			live_stream_filter_match(cpu_filter, "other_3", false),
+			"An empty channel name selects the CPUs of every channel");
+	ok(!live_stream_filter_match(cpu_filter, "any_2", false),
+			"The streams of other CPUs are not selected");
+	ok(live_stream_filter_match(cpu_filter, "any", false),
+			"A stream without a CPU suffix is not subject to the CPU selection");
+	ok(live_stream_filter_match(channel_cpu_filter, "chan_3", false),
+			"The channel and CPU selections are combined");
+	ok(!live_stream_filter_match(channel_cpu_filter, "chan_0", false) &&
+			!live_stream_filter_match(channel_cpu_filter, "other_3", false),
+			"A stream must match both the channel and CPU selections");
+	ok(live_stream_filter_match(channel_cpu_filter, "metadata", true),
+			"Metadata streams ignore the CPU selection");
+
+	free(channel_filter);
+	free(cpu_filter);
+	free(channel_cpu_filter);
+}
+
+int main(void)
+{
+	plan_tests(NUM_TESTS);
+
+	test_packet_retention();
+	test_stream_filter();
+
+	return exit_status();
+}
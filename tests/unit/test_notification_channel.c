@@ -0,0 +1,505 @@
+/*
+ * Unit tests for the notification channel protocol, against a fake session
+ * daemon.
+ *
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <common/payload.h>
+#include <lttng/condition/condition.h>
+#include <lttng/condition/evaluation.h>
+#include <lttng/condition/session-rotation-internal.h>
+#include <lttng/condition/session-rotation.h>
+#include <lttng/notification/channel-internal.h>
+#include <lttng/notification/notification-internal.h>
+
+#include <tap/tap.h>
+
+/* Number of TAP tests in this file */
+#define NUM_TESTS 22
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+#define CONDITION_COUNT 3
+#define MAX_COMMANDS CONDITION_COUNT
+
+/* What the fake session daemon received and how it must answer. */
+struct fake_sessiond {
+	int fd;
+	unsigned int expected_commands;
+	/* Status of the command and of each condition of a command. */
+	int8_t reply_status;
+	int8_t condition_statuses[CONDITION_COUNT];
+	/* Send a notification before replying to the first command. */
+	bool interleave_notification;
+	/* Received. */
+	unsigned int command_count;
+	int8_t command_types[MAX_COMMANDS];
+	uint32_t condition_count;
+};
+
+static int recv_all(int fd, void *buf, size_t len)
+{
+	return recv(fd, buf, len, MSG_WAITALL) == (ssize_t) len ? 0 : -1;
+}
+
+static int send_all(int fd, const void *buf, size_t len)
+{
+	return send(fd, buf, len, MSG_NOSIGNAL) == (ssize_t) len ? 0 : -1;
+}
+
+static int send_message(int fd, enum lttng_notification_channel_message_type type,
+		const void *payload, uint32_t size)
+{
+	struct lttng_notification_channel_message msg = {
+		.type = (int8_t) type,
+		.size = size,
+	};
+
+	if (send_all(fd, &msg, sizeof(msg))) {
+		return -1;
+	}
+
+	return size ? send_all(fd, payload, size) : 0;
+}
+
+/* Send a "session rotation ongoing" notification for rotation `id`. */
+static int send_notification(int fd, uint64_t id)
+{
+	int ret;
+	struct lttng_condition *condition;
+	struct lttng_notification *notification;
+	struct lttng_payload payload;
+
+	lttng_payload_init(&payload);
+	condition = lttng_condition_session_rotation_ongoing_create();
+	assert(condition);
+	assert(lttng_condition_session_rotation_set_session_name(condition,
+			"session0") == LTTNG_CONDITION_STATUS_OK);
+	notification = lttng_notification_create(condition,
+			lttng_evaluation_session_rotation_ongoing_create(id));
+	assert(notification);
+
+	ret = lttng_notification_serialize(notification, &payload);
+	assert(!ret);
+	ret = send_message(fd, LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_NOTIFICATION,
+			payload.buffer.data, payload.buffer.size);
+
+	lttng_notification_destroy(notification);
+	lttng_payload_reset(&payload);
+	return ret;
+}
+
+/* Serve the subscription commands of the peer. */
+static void *fake_sessiond_thread(void *data)
+{
+	struct fake_sessiond *sessiond = data;
+	char buf[4096];
+
+	while (sessiond->command_count < sessiond->expected_commands) {
+		struct lttng_notification_channel_message msg;
+		struct lttng_notification_channel_command_reply reply = {
+			.status = sessiond->reply_status,
+		};
+		char reply_buf[sizeof(reply) + CONDITION_COUNT];
+		size_t reply_size = sizeof(reply);
+
+		if (recv_all(sessiond->fd, &msg, sizeof(msg)) ||
+				msg.size > sizeof(buf) ||
+				recv_all(sessiond->fd, buf, msg.size)) {
+			break;
+		}
+
+		sessiond->command_types[sessiond->command_count++] = msg.type;
+		memcpy(reply_buf, &reply, sizeof(reply));
+		switch (msg.type) {
+		case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_MULTIPLE:
+		case LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE_MULTIPLE:
+		{
+			struct lttng_notification_channel_command_conditions cmd;
+
+			memcpy(&cmd, buf, sizeof(cmd));
+			sessiond->condition_count += cmd.condition_count;
+			if (reply.status == LTTNG_NOTIFICATION_CHANNEL_STATUS_OK &&
+					cmd.condition_count <= CONDITION_COUNT) {
+				memcpy(reply_buf + sizeof(reply),
+						sessiond->condition_statuses,
+						cmd.condition_count);
+				reply_size += cmd.condition_count;
+			}
+			break;
+		}
+		default:
+			/* Single condition commands. */
+			sessiond->condition_count++;
+			break;
+		}
+
+		if (sessiond->interleave_notification &&
+				sessiond->command_count == 1 &&
+				send_notification(sessiond->fd, 42)) {
+			break;
+		}
+
+		if (send_message(sessiond->fd,
+				LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_COMMAND_REPLY,
+				reply_buf, reply_size)) {
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Create a channel, past its handshake with a session daemon speaking
+ * protocol 1.`minor`, connected to `fd`.
+ */
+static struct lttng_notification_channel *create_channel(int fd, int8_t minor)
+{
+	struct lttng_notification_channel *channel;
+
+	channel = calloc(1, sizeof(*channel));
+	assert(channel);
+	channel->socket = fd;
+	pthread_mutex_init(&channel->lock, NULL);
+	lttng_payload_init(&channel->reception_payload);
+	lttng_dynamic_buffer_init(&channel->reception_buffer.buffer);
+	CDS_INIT_LIST_HEAD(&channel->pending_notifications.list);
+	channel->version.set = true;
+	channel->version.major = LTTNG_NOTIFICATION_CHANNEL_VERSION_MAJOR;
+	channel->version.minor = minor;
+	return channel;
+}
+
+static struct lttng_condition *conditions[CONDITION_COUNT];
+
+/*
+ * Subscribe to (or unsubscribe from) all the conditions through a fake
+ * session daemon speaking protocol 1.`minor`.
+ */
+static enum lttng_notification_channel_status send_conditions(int8_t minor,
+		bool subscribe, struct fake_sessiond *sessiond,
+		enum lttng_notification_channel_status *statuses,
+		unsigned int *pending_count)
+{
+	int ret, fds[2];
+	pthread_t thread;
+	unsigned int i;
+	enum lttng_notification_channel_status status;
+	struct lttng_notification_channel *channel;
+	struct lttng_notification **notifications = NULL;
+
+	ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+	assert(!ret);
+	channel = create_channel(fds[0], minor);
+	sessiond->fd = fds[1];
+
+	ret = pthread_create(&thread, NULL, fake_sessiond_thread, sessiond);
+	assert(!ret);
+
+	if (subscribe) {
+		status = lttng_notification_channel_subscribe_multiple(channel,
+				(const struct lttng_condition * const *) conditions,
+				CONDITION_COUNT, statuses);
+	} else {
+		status = lttng_notification_channel_unsubscribe_multiple(
+				channel,
+				(const struct lttng_condition * const *) conditions,
+				CONDITION_COUNT, statuses);
+	}
+
+	/* Notifications received while waiting for the replies. */
+	*pending_count = 0;
+	(void) lttng_notification_channel_get_pending_notifications(channel,
+			&notifications, pending_count);
+	for (i = 0; i < *pending_count; i++) {
+		lttng_notification_destroy(notifications[i]);
+	}
+	free(notifications);
+
+	/* Unblock the fake session daemon if the peer stopped early. */
+	(void) shutdown(fds[0], SHUT_RDWR);
+	(void) pthread_join(thread, NULL);
+
+	lttng_notification_channel_destroy(channel);
+	(void) close(fds[1]);
+	return status;
+}
+
+static void test_subscribe_multiple(void)
+{
+	unsigned int i, pending_count;
+	enum lttng_notification_channel_status status;
+	enum lttng_notification_channel_status statuses[CONDITION_COUNT];
+	struct fake_sessiond sessiond = {
+		.expected_commands = 1,
+		.reply_status = LTTNG_NOTIFICATION_CHANNEL_STATUS_OK,
+		.condition_statuses = {
+			LTTNG_NOTIFICATION_CHANNEL_STATUS_OK,
+			LTTNG_NOTIFICATION_CHANNEL_STATUS_ALREADY_SUBSCRIBED,
+			LTTNG_NOTIFICATION_CHANNEL_STATUS_OK,
+		},
+		.interleave_notification = true,
+	};
+
+	diag("Subscribing to conditions through a 1.2 session daemon");
+	status = send_conditions(2, true, &sessiond, statuses, &pending_count);
+	ok(sessiond.command_count == 1 &&
+			sessiond.command_types[0] ==
+					LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE_MULTIPLE,
+			"Conditions sent in a single SUBSCRIBE_MULTIPLE command");
+	ok(sessiond.condition_count == CONDITION_COUNT,
+			"Command carries all the conditions");
+	for (i = 0; i < CONDITION_COUNT; i++) {
+		if (statuses[i] != sessiond.condition_statuses[i]) {
+			break;
+		}
+	}
+	ok(i == CONDITION_COUNT, "Status of each condition reported");
+	ok(status == LTTNG_NOTIFICATION_CHANNEL_STATUS_ALREADY_SUBSCRIBED,
+			"First failed condition status returned");
+	ok(pending_count == 1,
+			"Notification received before the reply is queued");
+}
+
+static void test_unsubscribe_multiple_rejected(void)
+{
+	unsigned int i, pending_count;
+	enum lttng_notification_channel_status status;
+	enum lttng_notification_channel_status statuses[CONDITION_COUNT];
+	struct fake_sessiond sessiond = {
+		.expected_commands = 1,
+		.reply_status = LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID,
+	};
+
+	diag("Unsubscribing from conditions through a 1.2 session daemon rejecting the command");
+	status = send_conditions(2, false, &sessiond, statuses,
+			&pending_count);
+	ok(sessiond.command_count == 1 &&
+			sessiond.command_types[0] ==
+					LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_UNSUBSCRIBE_MULTIPLE,
+			"Conditions sent in a single UNSUBSCRIBE_MULTIPLE command");
+	ok(status == LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID,
+			"Command status returned");
+	for (i = 0; i < CONDITION_COUNT; i++) {
+		if (statuses[i] != LTTNG_NOTIFICATION_CHANNEL_STATUS_INVALID) {
+			break;
+		}
+	}
+	ok(i == CONDITION_COUNT, "Command status reported for each condition");
+}
+
+static void test_subscribe_multiple_fallback(void)
+{
+	unsigned int i, pending_count;
+	enum lttng_notification_channel_status status;
+	enum lttng_notification_channel_status statuses[CONDITION_COUNT];
+	struct fake_sessiond sessiond = {
+		.expected_commands = CONDITION_COUNT,
+		.reply_status = LTTNG_NOTIFICATION_CHANNEL_STATUS_OK,
+		.interleave_notification = true,
+	};
+
+	diag("Subscribing to conditions through a 1.1 session daemon");
+	status = send_conditions(1, true, &sessiond, statuses, &pending_count);
+	for (i = 0; i < sessiond.command_count; i++) {
+		if (sessiond.command_types[i] !=
+				LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_SUBSCRIBE) {
+			break;
+		}
+	}
+	ok(sessiond.command_count == CONDITION_COUNT && i == CONDITION_COUNT,
+			"One SUBSCRIBE command sent per condition");
+	ok(status == LTTNG_NOTIFICATION_CHANNEL_STATUS_OK,
+			"Subscriptions succeeded");
+	for (i = 0; i < CONDITION_COUNT; i++) {
+		if (statuses[i] != LTTNG_NOTIFICATION_CHANNEL_STATUS_OK) {
+			break;
+		}
+	}
+	ok(i == CONDITION_COUNT, "Status of each condition reported");
+	ok(pending_count == 1,
+			"Notification received before a reply is queued");
+}
+
+static uint64_t get_rotation_id(struct lttng_notification *notification)
+{
+	uint64_t id = -1ULL;
+
+	(void) lttng_evaluation_session_rotation_get_id(
+			lttng_notification_get_evaluation(notification), &id);
+	return id;
+}
+
+static void test_pending_notifications(void)
+{
+	int ret, fds[2];
+	bool pending;
+	unsigned int i, count;
+	enum lttng_notification_channel_status status;
+	struct lttng_notification_channel *channel;
+	struct lttng_notification **notifications = NULL;
+	struct lttng_notification *notification = NULL;
+
+	diag("Getting the pending notifications of a channel");
+	ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+	assert(!ret);
+	channel = create_channel(fds[0], 2);
+
+	status = lttng_notification_channel_get_pending_notifications(channel,
+			&notifications, &count);
+	ok(status == LTTNG_NOTIFICATION_CHANNEL_STATUS_OK && count == 0 &&
+			!notifications,
+			"No notification returned by an idle channel");
+
+	ret = 0;
+	for (i = 0; i < 3; i++) {
+		ret |= send_notification(fds[1], i);
+	}
+	ret |= send_message(fds[1],
+			LTTNG_NOTIFICATION_CHANNEL_MESSAGE_TYPE_NOTIFICATION_DROPPED,
+			NULL, 0);
+	ret |= send_notification(fds[1], 3);
+	assert(!ret);
+
+	status = lttng_notification_channel_get_pending_notifications(channel,
+			&notifications, &count);
+	ok(status == LTTNG_NOTIFICATION_CHANNEL_STATUS_NOTIFICATIONS_DROPPED,
+			"Dropped notifications reported");
+	ok(count == 4, "All the available notifications returned at once");
+	for (i = 0; i < count; i++) {
+		if (get_rotation_id(notifications[i]) != i) {
+			break;
+		}
+	}
+	ok(count == 4 && i == count, "Notifications returned in order");
+	for (i = 0; i < count; i++) {
+		lttng_notification_destroy(notifications[i]);
+	}
+	free(notifications);
+	notifications = NULL;
+
+	status = lttng_notification_channel_get_pending_notifications(channel,
+			&notifications, &count);
+	ok(status == LTTNG_NOTIFICATION_CHANNEL_STATUS_OK && count == 0,
+			"Notifications returned once");
+
+	/* Messages received at once are decoded without polling. */
+	ret = send_notification(fds[1], 10);
+	ret |= send_notification(fds[1], 11);
+	assert(!ret);
+	status = lttng_notification_channel_has_pending_notification(channel,
+			&pending);
+	ok(status == LTTNG_NOTIFICATION_CHANNEL_STATUS_OK && pending,
+			"Pending notification detected");
+	status = lttng_notification_channel_get_next_notification(channel,
+			&notification);
+	ok(status == LTTNG_NOTIFICATION_CHANNEL_STATUS_OK && notification &&
+			get_rotation_id(notification) == 10,
+			"Oldest notification returned first");
+	lttng_notification_destroy(notification);
+	notification = NULL;
+	status = lttng_notification_channel_get_next_notification(channel,
+			&notification);
+	ok(status == LTTNG_NOTIFICATION_CHANNEL_STATUS_OK && notification &&
+			get_rotation_id(notification) == 11,
+			"Notification received along the previous one returned");
+	lttng_notification_destroy(notification);
+	status = lttng_notification_channel_has_pending_notification(channel,
+			&pending);
+	ok(status == LTTNG_NOTIFICATION_CHANNEL_STATUS_OK && !pending,
+			"No notification left");
+
+	lttng_notification_channel_destroy(channel);
+	(void) close(fds[1]);
+}
+
+static void handle_alarm(int signo)
+{
+}
+
+static void test_interrupted_wait(void)
+{
+	int ret, fds[2];
+	enum lttng_notification_channel_status status;
+	struct lttng_notification_channel *channel;
+	struct lttng_notification *notification = NULL;
+	struct sigaction action = {
+		.sa_handler = handle_alarm,
+	};
+	const struct itimerval timer = {
+		.it_value = { .tv_usec = 100000 },
+	};
+
+	diag("Waiting for a notification until a signal is received");
+	ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+	assert(!ret);
+	channel = create_channel(fds[0], 2);
+
+	/* No SA_RESTART: the wait must be interrupted. */
+	ret = sigaction(SIGALRM, &action, NULL);
+	assert(!ret);
+	ret = setitimer(ITIMER_REAL, &timer, NULL);
+	assert(!ret);
+
+	status = lttng_notification_channel_get_next_notification(channel,
+			&notification);
+	ok(status == LTTNG_NOTIFICATION_CHANNEL_STATUS_INTERRUPTED &&
+			!notification,
+			"Interrupted wait reported");
+
+	lttng_notification_channel_destroy(channel);
+	(void) close(fds[1]);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int i;
+
+	plan_tests(NUM_TESTS);
+
+	for (i = 0; i < CONDITION_COUNT; i++) {
+		char session_name[16];
+
+		conditions[i] = lttng_condition_session_rotation_ongoing_create();
+		assert(conditions[i]);
+		(void) snprintf(session_name, sizeof(session_name),
+				"session%u", i);
+		assert(lttng_condition_session_rotation_set_session_name(
+				conditions[i], session_name) ==
+				LTTNG_CONDITION_STATUS_OK);
+	}
+
+	test_subscribe_multiple();
+	test_unsubscribe_multiple_rejected();
+	test_subscribe_multiple_fallback();
+	test_pending_notifications();
+	test_interrupted_wait();
+
+	for (i = 0; i < CONDITION_COUNT; i++) {
+		lttng_condition_destroy(conditions[i]);
+	}
+
+	return exit_status();
+}
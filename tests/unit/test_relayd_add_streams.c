@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <common/compat/endian.h>
+#include <common/error.h>
+#include <common/relayd/relayd.h>
+#include <common/sessiond-comm/relayd.h>
+#include <common/sessiond-comm/sessiond-comm.h>
+#include <common/trace-chunk.h>
+
+#include <tap/tap.h>
+
+/* Number of TAP tests in this file */
+#define NUM_TESTS 17
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+#define STREAM_COUNT 3
+#define CHUNK_ID 42
+#define FIRST_HANDLE 100
+
+static const char * const stream_names[STREAM_COUNT] = {
+	"channel0_0", "channel0_1", "channel0_2",
+};
+
+/* What the fake relay daemon received and how it must answer. */
+struct fake_relayd {
+	int fd;
+	/* Number of streams to announce before the peer stops. */
+	unsigned int expected_streams;
+	uint32_t reply_code;
+	/* Received. */
+	unsigned int add_stream_count;
+	unsigned int add_streams_count;
+	unsigned int stream_count;
+	bool names_valid;
+	bool pathname_valid;
+	bool chunk_id_valid;
+};
+
+static ssize_t test_sock_sendmsg(struct lttcomm_sock *sock, const void *buf,
+		size_t len, int flags)
+{
+	return send(sock->fd, buf, len, MSG_NOSIGNAL);
+}
+
+static ssize_t test_sock_recvmsg(struct lttcomm_sock *sock, void *buf,
+		size_t len, int flags)
+{
+	return recv(sock->fd, buf, len, MSG_WAITALL);
+}
+
+static struct lttcomm_proto_ops test_sock_ops = {
+	.sendmsg = test_sock_sendmsg,
+	.recvmsg = test_sock_recvmsg,
+};
+
+static int recv_all(int fd, void *buf, size_t len)
+{
+	return recv(fd, buf, len, MSG_WAITALL) == (ssize_t) len ? 0 : -1;
+}
+
+static int send_all(int fd, const void *buf, size_t len)
+{
+	return send(fd, buf, len, MSG_NOSIGNAL) == (ssize_t) len ? 0 : -1;
+}
+
+static void check_name(struct fake_relayd *relayd, const char *name)
+{
+	if (relayd->stream_count >= STREAM_COUNT ||
+			strcmp(name, stream_names[relayd->stream_count])) {
+		relayd->names_valid = false;
+	}
+	relayd->stream_count++;
+}
+
+static void check_pathname(struct fake_relayd *relayd, const char *pathname)
+{
+	if (strcmp(pathname, "ust/uid/1000/64-bit")) {
+		relayd->pathname_valid = false;
+	}
+}
+
+static int handle_add_stream(struct fake_relayd *relayd, const char *data,
+		size_t size)
+{
+	struct lttcomm_relayd_add_stream_2_11 msg;
+	struct lttcomm_relayd_status_stream reply;
+
+	memcpy(&msg, data, sizeof(msg));
+	check_name(relayd, data + sizeof(msg));
+	check_pathname(relayd, data + sizeof(msg) +
+			be32toh(msg.channel_name_len));
+	if (be64toh(msg.trace_chunk_id) != CHUNK_ID) {
+		relayd->chunk_id_valid = false;
+	}
+
+	relayd->add_stream_count++;
+	reply.handle = htobe64(FIRST_HANDLE + relayd->stream_count - 1);
+	reply.ret_code = htobe32(relayd->reply_code);
+	return send_all(relayd->fd, &reply, sizeof(reply));
+}
+
+static int handle_add_streams(struct fake_relayd *relayd, const char *data,
+		size_t size)
+{
+	int ret;
+	uint32_t i, stream_count;
+	size_t offset;
+	struct lttcomm_relayd_add_streams msg;
+	struct lttcomm_relayd_status_streams reply;
+
+	memcpy(&msg, data, sizeof(msg));
+	stream_count = be32toh(msg.stream_count);
+	offset = sizeof(msg);
+	for (i = 0; i < stream_count; i++) {
+		check_name(relayd, data + offset);
+		offset += strlen(data + offset) + 1;
+	}
+	if (offset != sizeof(msg) + be32toh(msg.names_len)) {
+		relayd->names_valid = false;
+	}
+	check_pathname(relayd, data + offset);
+	if (be64toh(msg.trace_chunk_id) != CHUNK_ID) {
+		relayd->chunk_id_valid = false;
+	}
+
+	relayd->add_streams_count++;
+	reply.ret_code = htobe32(relayd->reply_code);
+	reply.stream_count = htobe32(stream_count);
+	ret = send_all(relayd->fd, &reply, sizeof(reply));
+	for (i = 0; i < stream_count && !ret; i++) {
+		const uint64_t handle = htobe64(relayd->reply_code == LTTNG_OK ?
+				FIRST_HANDLE + i : -1ULL);
+
+		ret = send_all(relayd->fd, &handle, sizeof(handle));
+	}
+
+	return ret;
+}
+
+/* Serve the commands of the peer until it announced all its streams. */
+static void *fake_relayd_thread(void *data)
+{
+	struct fake_relayd *relayd = data;
+	char buf[4096];
+
+	relayd->names_valid = true;
+	relayd->pathname_valid = true;
+	relayd->chunk_id_valid = true;
+
+	while (relayd->stream_count < relayd->expected_streams) {
+		struct lttcomm_relayd_hdr header;
+		uint64_t size;
+		int ret;
+
+		if (recv_all(relayd->fd, &header, sizeof(header))) {
+			break;
+		}
+
+		size = be64toh(header.data_size);
+		if (size > sizeof(buf) || recv_all(relayd->fd, buf, size)) {
+			break;
+		}
+
+		switch (be32toh(header.cmd)) {
+		case RELAYD_ADD_STREAM:
+			ret = handle_add_stream(relayd, buf, size);
+			break;
+		case RELAYD_ADD_STREAMS:
+			ret = handle_add_streams(relayd, buf, size);
+			break;
+		default:
+			ret = -1;
+			break;
+		}
+
+		if (ret) {
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Announce the streams to a fake relay daemon of version 2.`minor` and
+ * return the result of relayd_add_streams().
+ */
+static int add_streams(unsigned int minor, uint32_t reply_code,
+		struct fake_relayd *relayd, uint64_t *stream_ids)
+{
+	int ret, fds[2];
+	pthread_t thread;
+	struct lttcomm_relayd_sock rsock;
+	struct lttng_trace_chunk *chunk;
+
+	ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+	assert(!ret);
+
+	memset(&rsock, 0, sizeof(rsock));
+	rsock.sock.fd = fds[0];
+	rsock.sock.ops = &test_sock_ops;
+	rsock.major = 2;
+	rsock.minor = minor;
+
+	memset(relayd, 0, sizeof(*relayd));
+	relayd->fd = fds[1];
+	relayd->expected_streams = STREAM_COUNT;
+	relayd->reply_code = reply_code;
+
+	chunk = lttng_trace_chunk_create(CHUNK_ID, 0, NULL);
+	assert(chunk);
+
+	ret = pthread_create(&thread, NULL, fake_relayd_thread, relayd);
+	assert(!ret);
+
+	ret = relayd_add_streams(&rsock, stream_names, STREAM_COUNT, "ust",
+			"uid/1000/64-bit", stream_ids, 0, 0, chunk);
+
+	/* Unblock the fake relay daemon if the peer stopped early. */
+	(void) shutdown(fds[0], SHUT_RDWR);
+	(void) pthread_join(thread, NULL);
+
+	lttng_trace_chunk_put(chunk);
+	(void) close(fds[0]);
+	(void) close(fds[1]);
+	return ret;
+}
+
+static bool handles_assigned(const uint64_t *stream_ids)
+{
+	unsigned int i;
+
+	for (i = 0; i < STREAM_COUNT; i++) {
+		if (stream_ids[i] != FIRST_HANDLE + i) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void test_batch(void)
+{
+	struct fake_relayd relayd;
+	uint64_t stream_ids[STREAM_COUNT] = {};
+
+	diag("Announcing streams to a 2.13 relay daemon");
+	ok(add_streams(13, LTTNG_OK, &relayd, stream_ids) == 0,
+			"Streams added");
+	ok(relayd.add_streams_count == 1 && relayd.add_stream_count == 0,
+			"Streams announced in a single command");
+	ok(relayd.stream_count == STREAM_COUNT && relayd.names_valid,
+			"Stream names sent in order");
+	ok(relayd.pathname_valid, "Path name prefixed by the domain");
+	ok(relayd.chunk_id_valid, "Trace chunk id sent");
+	ok(handles_assigned(stream_ids), "Stream handles assigned in order");
+}
+
+static void test_batch_error(void)
+{
+	struct fake_relayd relayd;
+	uint64_t stream_ids[STREAM_COUNT] = {};
+
+	diag("Announcing streams to a 2.13 relay daemon failing to add them");
+	ok(add_streams(13, LTTNG_ERR_UNK, &relayd, stream_ids) < 0,
+			"Error reported");
+	ok(relayd.add_streams_count == 1,
+			"Streams announced in a single command");
+}
+
+static void test_fallback(void)
+{
+	struct fake_relayd relayd;
+	uint64_t stream_ids[STREAM_COUNT] = {};
+
+	diag("Announcing streams to a 2.12 relay daemon");
+	ok(add_streams(12, LTTNG_OK, &relayd, stream_ids) == 0,
+			"Streams added");
+	ok(relayd.add_streams_count == 0 &&
+			relayd.add_stream_count == STREAM_COUNT,
+			"One command sent per stream");
+	ok(relayd.stream_count == STREAM_COUNT && relayd.names_valid,
+			"Stream names sent in order");
+	ok(relayd.pathname_valid, "Path name prefixed by the domain");
+	ok(relayd.chunk_id_valid, "Trace chunk id sent");
+	ok(handles_assigned(stream_ids), "Stream handles assigned in order");
+}
+
+static void test_fallback_error(void)
+{
+	struct fake_relayd relayd;
+	uint64_t stream_ids[STREAM_COUNT] = {};
+
+	diag("Announcing streams to a 2.12 relay daemon failing to add them");
+	ok(add_streams(12, LTTNG_ERR_UNK, &relayd, stream_ids) < 0,
+			"Error reported");
+	ok(relayd.add_stream_count == 1,
+			"No stream announced after the first error");
+	ok(relayd.add_streams_count == 0, "Batch command not used");
+}
+
+int main(int argc, char **argv)
+{
+	plan_tests(NUM_TESTS);
+
+	test_batch();
+	test_batch_error();
+	test_fallback();
+	test_fallback_error();
+
+	return exit_status();
+}
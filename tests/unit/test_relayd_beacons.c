@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2021 EfficiOS, Inc.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <tap/tap.h>
+
+#include "stream.h"
+
+/* Number of TAP tests in this file */
+#define NUM_TESTS 8
+
+/* For error.h */
+int lttng_opt_quiet = 1;
+int lttng_opt_verbose;
+int lttng_opt_mi;
+
+static void test_before_first_index(void)
+{
+	diag("Live beacons received before the first index");
+	ok(!stream_beacon_is_overtaken(-1ULL, -1ULL),
+			"Beacon of a stream without packet kept");
+	ok(!stream_beacon_is_overtaken(-1ULL, 0),
+			"Beacon sent after the first packet kept");
+	ok(!stream_beacon_is_overtaken(-1ULL, 41),
+			"Beacon sent after many packets kept");
+}
+
+static void test_after_first_index(void)
+{
+	diag("Live beacons received after the first index");
+	ok(stream_beacon_is_overtaken(0, -1ULL),
+			"Beacon sampled before the first packet discarded");
+	ok(!stream_beacon_is_overtaken(0, 0),
+			"Beacon sampled after the first packet kept");
+	ok(!stream_beacon_is_overtaken(5, 5),
+			"Beacon sampled after the last packet kept");
+	ok(stream_beacon_is_overtaken(5, 4),
+			"Beacon sampled before the last packet discarded");
+	ok(!stream_beacon_is_overtaken(5, 6),
+			"Beacon sampled after an index in flight kept");
+}
+
+int main(int argc, char **argv)
+{
+	plan_tests(NUM_TESTS);
+
+	test_before_first_index();
+	test_after_first_index();
+
+	return exit_status();
+}
@@ -14,7 +14,7 @@
 #include <tap/tap.h>
 
 /* Number of TAP tests in this file */
-#define NUM_TESTS 69
+#define NUM_TESTS 85
 
 static void test_one_split(const char *input, char delim, int escape_delim,
 		...)
@@ -162,6 +162,34 @@ static void test_normalize_star_glob_pattern(void)
 	test_one_normalize_star_glob_pattern("**\\***", "*\\**");
 }
 
+static void test_one_star_glob_match(const char *pattern,
+		const char *candidate, bool expected)
+{
+	ok(strutils_star_glob_match(pattern, candidate) == expected,
+		"strutils_star_glob_match() returns the expected result: `%s` against `%s` -> %d",
+		pattern, candidate, expected);
+}
+
+static void test_star_glob_match(void)
+{
+	test_one_star_glob_match("allo", "allo", true);
+	test_one_star_glob_match("allo", "all", false);
+	test_one_star_glob_match("allo", "allo2", false);
+	test_one_star_glob_match("", "", true);
+	test_one_star_glob_match("", "allo", false);
+	test_one_star_glob_match("*", "", true);
+	test_one_star_glob_match("*", "allo", true);
+	test_one_star_glob_match("al*", "allo", true);
+	test_one_star_glob_match("al*", "al", true);
+	test_one_star_glob_match("*lo", "allo", true);
+	test_one_star_glob_match("*lo", "allos", false);
+	test_one_star_glob_match("a*l*o", "allo", true);
+	test_one_star_glob_match("a**o", "allo", true);
+	test_one_star_glob_match("a*lx*", "allo", false);
+	test_one_star_glob_match("al\\*o", "al*o", true);
+	test_one_star_glob_match("al\\*o", "allo", false);
+}
+
 int main(int argc, char **argv)
 {
 	plan_tests(NUM_TESTS);
@@ -170,6 +198,7 @@ int main(int argc, char **argv)
 	test_is_star_glob_pattern();
 	test_is_star_at_the_end_only_glob_pattern();
 	test_split();
+	test_star_glob_match();
 
 	return exit_status();
 }